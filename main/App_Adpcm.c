@@ -0,0 +1,103 @@
+#include "App_Adpcm.h"
+
+#include "esp_attr.h"
+
+static const int16_t s_step_table[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,    25,    28,
+    31,    34,    37,    41,    45,    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,   337,   371,   408,   449,   494,
+    544,   598,   658,   724,   796,   876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845,  8630,
+    9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static const int8_t s_index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8,
+};
+
+static inline int clamp_index(int i)
+{
+    return i < 0 ? 0 : (i > 88 ? 88 : i);
+}
+
+static inline int32_t clamp16(int32_t v)
+{
+    return v < -32768 ? -32768 : (v > 32767 ? 32767 : v);
+}
+
+// 单个 nibble：编码端与解码端共用同一重建公式，保证两端预测器一致
+static inline int32_t step_decode(int32_t pred, int *index, int nib)
+{
+    const int32_t step = s_step_table[*index];
+    int32_t diff = step >> 3;
+    if (nib & 4) diff += step;
+    if (nib & 2) diff += step >> 1;
+    if (nib & 1) diff += step >> 2;
+    pred = (nib & 8) ? pred - diff : pred + diff;
+    *index = clamp_index(*index + s_index_table[nib]);
+    return clamp16(pred);
+}
+
+static inline int step_encode(int32_t pred, int index, int32_t sample)
+{
+    const int32_t step = s_step_table[index];
+    int32_t diff = sample - pred;
+    int nib = 0;
+    if (diff < 0) {
+        nib = 8;
+        diff = -diff;
+    }
+    if (diff >= step) {
+        nib |= 4;
+        diff -= step;
+    }
+    if (diff >= (step >> 1)) {
+        nib |= 2;
+        diff -= step >> 1;
+    }
+    if (diff >= (step >> 2)) {
+        nib |= 1;
+    }
+    return nib;
+}
+
+void app_adpcm_encode_block(app_adpcm_enc_t *enc, const int16_t *pcm, uint8_t *out)
+{
+    int index = clamp_index(enc->index);
+    int32_t pred = pcm[0];
+
+    out[0] = (uint8_t)(pred & 0xff);
+    out[1] = (uint8_t)((pred >> 8) & 0xff);
+    out[2] = (uint8_t)index;
+    out[3] = 0;
+
+    uint8_t *p = out + 4;
+    for (int i = 1; i < APP_ADPCM_BLOCK_SAMPLES; i += 2) {
+        int lo = step_encode(pred, index, pcm[i]);
+        pred = step_decode(pred, &index, lo);
+        int hi = step_encode(pred, index, pcm[i + 1]);
+        pred = step_decode(pred, &index, hi);
+        *p++ = (uint8_t)(lo | (hi << 4));
+    }
+    enc->index = index;
+}
+
+// 解码在读指针上调用（上行追帧时按块批量解），放 IRAM 减少 cache miss
+void IRAM_ATTR app_adpcm_decode_block(const uint8_t *in, int16_t *pcm)
+{
+    int32_t pred = (int16_t)((uint16_t)in[0] | ((uint16_t)in[1] << 8));
+    int index = clamp_index(in[2]);
+    pcm[0] = (int16_t)pred;
+
+    const uint8_t *p = in + 4;
+    int16_t *o = pcm + 1;
+    for (int i = 0; i < (APP_ADPCM_BLOCK_BYTES - 4); ++i) {
+        const uint8_t b = p[i];
+        pred = step_decode(pred, &index, b & 0x0f);
+        o[0] = (int16_t)pred;
+        pred = step_decode(pred, &index, b >> 4);
+        o[1] = (int16_t)pred;
+        o += 2;
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * IMA ADPCM（单声道，块格式与 WAV IMA ADPCM 一致）
+ *
+ * 一块 = 4 字节头（首样本 int16 + step index + 保留）+ 252 字节数据（504 个 4bit 样本）
+ *      = 505 个 16bit 样本（1010 字节 PCM）-> 256 字节，约 4:1
+ * 每块自带预测器状态，可随机访问任意块解码（用于环形缓冲读指针）。
+ */
+
+#define APP_ADPCM_BLOCK_SAMPLES 505
+#define APP_ADPCM_BLOCK_BYTES   256
+#define APP_ADPCM_BLOCK_PCM_BYTES (APP_ADPCM_BLOCK_SAMPLES * 2)
+
+typedef struct {
+    int index; // step index 跨块延续，避免每块开头重新收敛
+} app_adpcm_enc_t;
+
+/**
+ * @brief 编码一块（pcm 必须有 APP_ADPCM_BLOCK_SAMPLES 个样本）
+ */
+void app_adpcm_encode_block(app_adpcm_enc_t *enc, const int16_t *pcm, uint8_t *out);
+
+/**
+ * @brief 解码一块到 APP_ADPCM_BLOCK_SAMPLES 个样本
+ */
+void app_adpcm_decode_block(const uint8_t *in, int16_t *pcm);
+
+#ifdef __cplusplus
+}
+#endif
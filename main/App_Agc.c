@@ -0,0 +1,269 @@
+#include "App_Agc.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+
+#include "App_PcmOps.h"
+#include "App_Spec.h"
+
+static const char *TAG = "App_Agc";
+
+#define AGC_SUB_MS 4
+#define AGC_FS_L (15 * 256)         // log2(32768)：0 dBFS
+#define AGC_CLIP_LEVEL 32440        // -0.1 dBFS：认为输入已削顶
+#define AGC_GAP_MS 250              // 两次换档最小间隔
+
+// 2^(k/16)，Q15
+static const uint32_t s_exp2_tab[17] = {
+    32768, 34219, 35734, 37316, 38968, 40693, 42495, 44376, 46341,
+    48393, 50535, 52773, 55109, 57549, 60097, 62757, 65536,
+};
+
+static inline int32_t agc_db_to_l(int db)
+{
+    return (int32_t)lrintf((float)db * 42.5237f);
+}
+
+static inline float agc_l_to_db(int32_t l)
+{
+    return (float)l / 42.5237f;
+}
+
+// 2^(l/256)，Q12
+static int32_t agc_exp2_q12(int32_t l)
+{
+    const int32_t i = l >> 8;
+    const int32_t f = l & 255;
+    const uint32_t lo = s_exp2_tab[f >> 4], hi = s_exp2_tab[(f >> 4) + 1];
+    const uint32_t m = lo + (((hi - lo) * (uint32_t)(f & 15) + 8) >> 4);
+    const int sh = (int)i - 3;
+    if (sh >= 0) return (int32_t)(m << (sh > 12 ? 12 : sh));
+    if (sh <= -31) return 0;
+    return (int32_t)((m + (1u << (-sh - 1))) >> -sh);
+}
+
+// 一阶平滑系数：1 - exp(-sub/tau)，Q15
+static int32_t agc_coef_q15(int tau_ms)
+{
+    return (int32_t)lrintf(32768.0f * (1.0f - expf(-(float)AGC_SUB_MS / (float)tau_ms)));
+}
+
+app_agc_cfg_t app_agc_cfg_default(int sample_rate)
+{
+    app_agc_cfg_t c = {
+        .sample_rate = sample_rate,
+        .target_dbfs = -20,
+        .max_gain_db = 24,
+        .min_gain_db = -12,
+        .gate_dbfs = -55,
+        .limit_dbfs = -1,
+        .attack_ms = 30,
+        .release_ms = 600,
+        .limiter_release_ms = 80,
+        .vad_credit_db = 6,
+        .coarse_step_db = 6,
+        .coarse_up_db = 12,
+        .coarse_down_db = -6,
+        .coarse_hold_ms = 2000,
+    };
+    return c;
+}
+
+esp_err_t app_agc_init(app_agc_t *a, const app_agc_cfg_t *cfg)
+{
+    ESP_RETURN_ON_FALSE(a && cfg && cfg->sample_rate > 0, ESP_ERR_INVALID_ARG, TAG, "bad args");
+    memset(a, 0, sizeof(*a));
+    app_agc_cfg_t def = app_agc_cfg_default(cfg->sample_rate);
+    a->cfg = *cfg;
+    app_agc_cfg_t *c = &a->cfg;
+    if (c->target_dbfs == 0) c->target_dbfs = def.target_dbfs;
+    if (c->max_gain_db <= 0 || c->max_gain_db > 24) c->max_gain_db = def.max_gain_db;
+    if (c->min_gain_db == 0) c->min_gain_db = def.min_gain_db;
+    if (c->gate_dbfs == 0) c->gate_dbfs = def.gate_dbfs;
+    if (c->limit_dbfs == 0) c->limit_dbfs = def.limit_dbfs;
+    if (c->attack_ms <= 0) c->attack_ms = def.attack_ms;
+    if (c->release_ms <= 0) c->release_ms = def.release_ms;
+    if (c->limiter_release_ms <= 0) c->limiter_release_ms = def.limiter_release_ms;
+    if (c->vad_credit_db <= 0) c->vad_credit_db = def.vad_credit_db;
+    if (c->coarse_step_db <= 0) c->coarse_step_db = def.coarse_step_db;
+    if (c->coarse_up_db <= 0) c->coarse_up_db = def.coarse_up_db;
+    if (c->coarse_down_db == 0) c->coarse_down_db = def.coarse_down_db;
+    if (c->coarse_hold_ms <= 0) c->coarse_hold_ms = def.coarse_hold_ms;
+    ESP_RETURN_ON_FALSE(c->min_gain_db < c->max_gain_db && c->limit_dbfs < 0 && c->target_dbfs < c->limit_dbfs,
+                        ESP_ERR_INVALID_ARG, TAG, "bad levels");
+
+    a->sub = c->sample_rate * AGC_SUB_MS / 1000;
+    ESP_RETURN_ON_FALSE(a->sub > 0, ESP_ERR_INVALID_ARG, TAG, "sample rate too low");
+    a->target_l = AGC_FS_L + agc_db_to_l(c->target_dbfs);
+    a->gate_l = AGC_FS_L + agc_db_to_l(c->gate_dbfs);
+    a->min_l = agc_db_to_l(c->min_gain_db);
+    a->max_l = agc_db_to_l(c->max_gain_db);
+    a->credit_l = agc_db_to_l(c->vad_credit_db);
+    a->up_l = agc_db_to_l(c->coarse_up_db);
+    a->down_l = agc_db_to_l(c->coarse_down_db);
+    a->step_l = agc_db_to_l(c->coarse_step_db);
+    a->ceil = (int32_t)lrintf(32767.0f * powf(10.0f, (float)c->limit_dbfs / 20.0f));
+    a->att_q15 = agc_coef_q15(c->attack_ms);
+    a->rel_q15 = agc_coef_q15(c->release_ms);
+    a->lim_rel_q15 = agc_coef_q15(c->limiter_release_ms);
+    a->hold_blocks = c->coarse_hold_ms / AGC_SUB_MS;
+    a->gap_blocks = AGC_GAP_MS / AGC_SUB_MS;
+    a->since_change = a->gap_blocks;
+
+    // 从单位增益起步
+    a->env_l16 = a->target_l << 8;
+    a->g_q12 = 4096;
+    a->coarse_db = c->coarse_db;
+    a->st.coarse_db = c->coarse_db;
+    a->st.level_dbfs = (float)c->target_dbfs;
+
+    if (c->set_coarse) {
+        ESP_LOGI(TAG, "agc: target %d dBFS, gain %d..%d dB, limit %d dBFS, codec %d dB (%d..%d step %d)",
+                 c->target_dbfs, c->min_gain_db, c->max_gain_db, c->limit_dbfs, c->coarse_db, c->coarse_min_db,
+                 c->coarse_max_db, c->coarse_step_db);
+    } else {
+        ESP_LOGI(TAG, "agc: target %d dBFS, gain %d..%d dB, limit %d dBFS", c->target_dbfs, c->min_gain_db,
+                 c->max_gain_db, c->limit_dbfs);
+    }
+    return ESP_OK;
+}
+
+// 子块内增益从 g0 线性过渡到 g1（Q12）；调用方保证 |x * g| 不超过 ceil
+static void agc_apply(int16_t *x, int m, int32_t g0, int32_t g1)
+{
+    if (g0 == g1) {
+        app_pcm_gain(x, x, m, g1);
+        return;
+    }
+    int32_t g = g0 << 8;
+    const int32_t inc = (g1 - g0) * 256 / m;
+    for (int i = 0; i < m; ++i) {
+        g += inc;
+        const int32_t v = (x[i] * (g >> 8) + 2048) >> 12;
+        x[i] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+    }
+}
+
+// 粗调：codec 换档后包络同步平移一档，下一子块起数字增益反向补偿
+static void agc_coarse(app_agc_t *a, bool active, bool clip)
+{
+    const app_agc_cfg_t *c = &a->cfg;
+    if (!c->set_coarse) return;
+    if (a->since_change < a->gap_blocks) {
+        a->since_change++;
+        return;
+    }
+    int dir = 0;
+    if (clip) {
+        dir = -1;
+    } else if (active) {
+        a->up_cnt = (a->gain_l >= a->up_l) ? a->up_cnt + 1 : 0;
+        a->down_cnt = (a->gain_l <= a->down_l) ? a->down_cnt + 1 : 0;
+        if (a->up_cnt >= a->hold_blocks) {
+            dir = 1;
+        } else if (a->down_cnt >= a->hold_blocks) {
+            dir = -1;
+        }
+    }
+    if (dir == 0) return;
+    a->up_cnt = 0;
+    a->down_cnt = 0;
+    const int db = a->coarse_db + dir * c->coarse_step_db;
+    if (db < c->coarse_min_db || db > c->coarse_max_db) return;
+    a->since_change = 0;
+    if (c->set_coarse(db, c->coarse_ctx) != ESP_OK) {
+        a->st.coarse_fails++;
+        return;
+    }
+    a->env_l16 += dir * a->step_l * 256;
+    a->coarse_db = db;
+    a->st.coarse_db = db;
+    if (dir > 0) {
+        a->st.coarse_ups++;
+    } else {
+        a->st.coarse_downs++;
+    }
+    ESP_LOGI(TAG, "codec gain %s -> %d dB (digital %.1f dB)", dir > 0 ? "up" : "down", db,
+             (double)agc_l_to_db(a->gain_l));
+}
+
+static void agc_block(app_agc_t *a, int16_t *x, int m)
+{
+    app_agc_stats_t *st = &a->st;
+    const int32_t peak = app_pcm_peak(x, m);
+    const int32_t lvl = app_spec_log2_q8(app_pcm_sum_sq(x, m) / (uint64_t)m) / 2;
+    st->blocks++;
+
+    // 只有语音段更新包络：停顿 / 底噪期间增益保持
+    const bool active = lvl > a->gate_l;
+    if (active) {
+        const int32_t k = ((lvl << 8) > a->env_l16) ? a->att_q15 : a->rel_q15;
+        a->env_l16 += (int32_t)(((int64_t)((lvl << 8) - a->env_l16) * k) >> 15);
+    }
+    int32_t g = a->target_l - (a->env_l16 >> 8);
+    if (g > a->max_l) g = a->max_l;
+    if (g < a->min_l) g = a->min_l;
+    a->gain_l = g;
+
+    // 限幅：本子块峰值乘增益不超过 ceil；先按时间常数恢复，超过则立即压低
+    const int32_t allow = (peak > 0) ? (int32_t)(((int64_t)a->ceil << 12) / peak) : INT32_MAX;
+    int32_t lim = a->lim_l;
+    if (lim < 0) lim += (int32_t)(((int64_t)(-lim) * a->lim_rel_q15 + 32767) >> 15);
+    int32_t g1 = agc_exp2_q12(g + lim);
+    if (g1 > allow) {
+        g1 = allow;
+        lim = app_spec_log2_q8((uint64_t)allow) - 12 * 256 - g;
+        if (lim > 0) lim = 0;
+        st->limiter_hits++;
+    }
+    a->lim_l = lim;
+    const int32_t g0 = (a->g_q12 < allow) ? a->g_q12 : allow;
+    agc_apply(x, m, g0, g1);
+    a->g_q12 = g1;
+
+    // 换档影响的是之后的输入，本子块已按旧增益处理
+    const bool clip = peak >= AGC_CLIP_LEVEL;
+    if (clip) st->in_clips++;
+    agc_coarse(a, active, clip);
+}
+
+void app_agc_process(app_agc_t *a, int16_t *x, int n)
+{
+    const uint32_t c0 = esp_cpu_get_cycle_count();
+    while (n > 0) {
+        const int m = (n < a->sub) ? n : a->sub;
+        agc_block(a, x, m);
+        x += m;
+        n -= m;
+    }
+    app_agc_stats_t *st = &a->st;
+    const uint32_t cyc = esp_cpu_get_cycle_count() - c0;
+    st->cycles_last = cyc;
+    st->cycles_avg = st->cycles_avg ? (st->cycles_avg * 15 + cyc) / 16 : cyc;
+    if (cyc > st->cycles_max) st->cycles_max = cyc;
+}
+
+int32_t app_agc_vad_scale_q12(const app_agc_t *a)
+{
+    const int32_t total = a->gain_l + a->lim_l + agc_db_to_l(a->coarse_db - a->cfg.coarse_db);
+    int32_t ex = 0;
+    if (total > a->credit_l) {
+        ex = total - a->credit_l;
+    } else if (total < 0) {
+        ex = total;
+    }
+    return agc_exp2_q12(-ex);
+}
+
+void app_agc_get_stats(const app_agc_t *a, app_agc_stats_t *out)
+{
+    if (!a || !out) return;
+    *out = a->st;
+    out->gain_db = agc_l_to_db(a->gain_l);
+    out->limit_db = agc_l_to_db(a->lim_l);
+    out->level_dbfs = agc_l_to_db((a->env_l16 >> 8) - AGC_FS_L);
+}
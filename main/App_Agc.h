@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 采集链自动增益：定点电平跟踪 + 数字增益 + 峰值限幅，必要时联动 codec 输入增益做粗调。
+ *
+ *   x ──4ms 子块──> 电平（log2 RMS）──攻击/释放包络──> 增益 = 目标 - 包络 ──限幅──> 子块内线性过渡 ──> y
+ *
+ * 只有高于 gate_dbfs 的子块更新包络：停顿和底噪期间增益保持，不把噪声拉上来。
+ * 限幅按子块峰值算允许的最大增益，超过立即压低（无前瞻延迟），之后按 limiter_release_ms 恢复。
+ * 粗调：数字增益持续高于 coarse_up_db（远场小声）时 codec 升一档、持续低于 coarse_down_db 或输入已削顶时降一档，
+ * 同时把包络平移一档，数字增益反向补偿，总增益不跳变（codec 生效前的几毫秒会差一档）。
+ *
+ * 电平、增益都在 log2 域（Q8，256 = 6.02 dB）计算，样本乘法为 Q12；原地处理、任意长度、零延迟。
+ * 增益状态给 VAD：app_agc_vad_scale_q12() 把输出电平折回基准增益，vad_credit_db 以内的放大算给 VAD。
+ */
+
+typedef esp_err_t (*app_agc_coarse_cb_t)(int db, void *ctx);
+
+typedef struct {
+    int sample_rate;            // 必填
+    int target_dbfs;            // 语音 RMS 目标，默认 -20（0 取默认）
+    int max_gain_db;            // 最大数字增益，默认 24（上限 24，Q12 乘法不溢出）
+    int min_gain_db;            // 最小数字增益，默认 -12（0 取默认）
+    int gate_dbfs;              // 低于此电平不更新包络，默认 -55（0 取默认）
+    int limit_dbfs;             // 输出峰值上限，默认 -1（0 取默认）
+    int attack_ms;              // 电平上升时间常数，默认 30
+    int release_ms;             // 电平下降时间常数，默认 600
+    int limiter_release_ms;     // 限幅恢复时间常数，默认 80
+    int vad_credit_db;          // VAD 可以吃到的放大量，默认 6
+
+    // 粗调（可选）：set_coarse 为 NULL 时只做数字增益；回调在 app_agc_process 的调用者上下文执行
+    app_agc_coarse_cb_t set_coarse;
+    void *coarse_ctx;
+    int coarse_db;              // 当前 codec 增益，即 VAD 的基准增益
+    int coarse_min_db;
+    int coarse_max_db;
+    int coarse_step_db;         // 默认 6
+    int coarse_up_db;           // 默认 12
+    int coarse_down_db;         // 默认 -6（0 取默认）
+    int coarse_hold_ms;         // 语音段持续多久才换档，默认 2000
+} app_agc_cfg_t;
+
+typedef struct {
+    uint32_t blocks;            // 已处理子块
+    uint32_t limiter_hits;      // 限幅压低增益的子块数
+    uint32_t in_clips;          // 输入已削顶的子块数（codec 增益过大，数字侧无法挽回）
+    uint32_t coarse_ups;
+    uint32_t coarse_downs;
+    uint32_t coarse_fails;
+    int coarse_db;
+    float gain_db;              // 数字增益（不含限幅）
+    float limit_db;             // 限幅衰减，<= 0
+    float level_dbfs;           // 语音电平包络
+    uint32_t cycles_last;       // 单次 process 的 CPU 周期（采集链一次一帧）
+    uint32_t cycles_avg;
+    uint32_t cycles_max;
+} app_agc_stats_t;
+
+typedef struct {
+    app_agc_cfg_t cfg;
+    int sub;                    // 子块样本数
+    int32_t target_l, gate_l, min_l, max_l, credit_l, up_l, down_l, step_l;   // log2 Q8
+    int32_t ceil;               // 输出峰值上限（样本幅度）
+    int32_t att_q15, rel_q15, lim_rel_q15;
+    int32_t env_l16;            // 语音电平包络，log2 Q16
+    int32_t gain_l;
+    int32_t lim_l;              // <= 0
+    int32_t g_q12;              // 上一子块末的线性增益
+    int coarse_db;
+    int up_cnt, down_cnt, hold_blocks;
+    int since_change, gap_blocks;
+    app_agc_stats_t st;
+} app_agc_t;
+
+app_agc_cfg_t app_agc_cfg_default(int sample_rate);
+
+esp_err_t app_agc_init(app_agc_t *a, const app_agc_cfg_t *cfg);
+
+/**
+ * @brief 原地处理 n 个样本
+ */
+void app_agc_process(app_agc_t *a, int16_t *x, int n);
+
+/**
+ * @brief VAD 电平折算系数（Q12）：输出 avg_abs 乘它后与基准增益下的阈值比较
+ *
+ * 总增益（codec 相对基准 + 数字 + 限幅）在 [0, vad_credit_db] 内为 1；
+ * 超出部分除掉（噪声被放大不会误开口），衰减部分补回（近讲压下来仍算有声）。
+ */
+int32_t app_agc_vad_scale_q12(const app_agc_t *a);
+
+void app_agc_get_stats(const app_agc_t *a, app_agc_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
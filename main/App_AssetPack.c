@@ -0,0 +1,135 @@
+#include "App_AssetPack.h"
+
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+
+#include "App_Speak_Sound.h"
+
+static const char *TAG = "App_AssetPack";
+
+#define ASSET_PARTITION_SUBTYPE 0x40
+#define ASSET_PLAY_CHUNK 4096
+
+typedef struct {
+    const esp_partition_t *part;
+    esp_partition_mmap_handle_t mmap_handle;
+    const uint8_t *base;
+    const app_asset_pack_hdr_t *hdr;
+    const app_asset_entry_t *table;
+} asset_pack_ctx_t;
+
+static asset_pack_ctx_t s_pack = {0};
+
+_Static_assert(sizeof(app_asset_pack_hdr_t) == 32, "asset pack header must be 32 bytes");
+_Static_assert(sizeof(app_asset_entry_t) == 32, "asset entry must be 32 bytes");
+
+esp_err_t app_asset_pack_open(const char *partition_label)
+{
+    if (s_pack.base) return ESP_OK;
+
+    const char *label = partition_label ? partition_label : "model";
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ASSET_PARTITION_SUBTYPE, label);
+    ESP_RETURN_ON_FALSE(part, ESP_ERR_NOT_FOUND, TAG, "partition %s not found", label);
+
+    // 先读头部校验，再按实际大小映射（不必映射整个 3MB 分区）
+    app_asset_pack_hdr_t hdr;
+    ESP_RETURN_ON_ERROR(esp_partition_read(part, 0, &hdr, sizeof(hdr)), TAG, "read header failed");
+    ESP_RETURN_ON_FALSE(hdr.magic == APP_ASSET_PACK_MAGIC, ESP_ERR_INVALID_VERSION, TAG,
+                        "no asset pack in %s (magic=0x%08x)", label, (unsigned)hdr.magic);
+    ESP_RETURN_ON_FALSE(hdr.version == APP_ASSET_PACK_VERSION && hdr.entry_size == sizeof(app_asset_entry_t),
+                        ESP_ERR_INVALID_VERSION, TAG, "unsupported pack v%u entry=%u",
+                        (unsigned)hdr.version, (unsigned)hdr.entry_size);
+    ESP_RETURN_ON_FALSE(hdr.total_size <= part->size && hdr.table_off >= sizeof(hdr) &&
+                            hdr.table_off + hdr.slot_count * sizeof(app_asset_entry_t) <= hdr.data_off &&
+                            hdr.data_off <= hdr.total_size,
+                        ESP_ERR_INVALID_SIZE, TAG, "pack layout invalid");
+
+    const void *ptr = NULL;
+    esp_partition_mmap_handle_t h;
+    ESP_RETURN_ON_ERROR(esp_partition_mmap(part, 0, hdr.total_size, ESP_PARTITION_MMAP_DATA, &ptr, &h),
+                        TAG, "mmap failed");
+
+    const uint8_t *base = (const uint8_t *)ptr;
+    const app_asset_entry_t *table = (const app_asset_entry_t *)(base + hdr.table_off);
+
+    // 逐条检查越界，之后 get() 不再重复校验
+    for (uint32_t i = 0; i < hdr.slot_count; ++i) {
+        const app_asset_entry_t *e = &table[i];
+        if (e->kind == APP_ASSET_KIND_NONE) continue;
+        if (e->offset < hdr.data_off || e->offset > hdr.total_size || e->length > hdr.total_size - e->offset) {
+            ESP_LOGE(TAG, "asset %u out of range", (unsigned)i);
+            esp_partition_munmap(h);
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+
+    s_pack.part = part;
+    s_pack.mmap_handle = h;
+    s_pack.base = base;
+    s_pack.hdr = (const app_asset_pack_hdr_t *)base;
+    s_pack.table = table;
+
+    ESP_LOGI(TAG, "asset pack mapped: %s, %u slots, %u bytes", label, (unsigned)hdr.slot_count,
+             (unsigned)hdr.total_size);
+    return ESP_OK;
+}
+
+bool app_asset_pack_ready(void)
+{
+    return s_pack.base != NULL;
+}
+
+esp_err_t app_asset_get(uint16_t id, app_asset_t *out)
+{
+    ESP_RETURN_ON_FALSE(out, ESP_ERR_INVALID_ARG, TAG, "out is NULL");
+    if (!s_pack.base || id >= s_pack.hdr->slot_count) return ESP_ERR_NOT_FOUND;
+
+    const app_asset_entry_t *e = &s_pack.table[id];
+    if (e->kind == APP_ASSET_KIND_NONE) return ESP_ERR_NOT_FOUND;
+
+    out->data = s_pack.base + e->offset;
+    out->len = e->length;
+    out->kind = (app_asset_kind_t)e->kind;
+    out->sample_rate = (int)e->sample_rate;
+    out->channels = e->channels;
+    out->name = e->name;
+    return ESP_OK;
+}
+
+esp_err_t app_asset_pack_verify(void)
+{
+    ESP_RETURN_ON_FALSE(s_pack.base, ESP_ERR_INVALID_STATE, TAG, "pack not open");
+    const app_asset_pack_hdr_t *hdr = s_pack.hdr;
+    uint32_t crc = esp_rom_crc32_le(0, s_pack.base + hdr->table_off, hdr->total_size - hdr->table_off);
+    ESP_RETURN_ON_FALSE(crc == hdr->crc32, ESP_ERR_INVALID_CRC, TAG, "crc mismatch: 0x%08x != 0x%08x",
+                        (unsigned)crc, (unsigned)hdr->crc32);
+    return ESP_OK;
+}
+
+esp_err_t app_asset_play(uint16_t id)
+{
+    app_asset_t a;
+    ESP_RETURN_ON_ERROR(app_asset_get(id, &a), TAG, "asset %u not found", (unsigned)id);
+    ESP_RETURN_ON_FALSE(a.kind == APP_ASSET_KIND_PCM, ESP_ERR_INVALID_ARG, TAG, "asset %u is not pcm", (unsigned)id);
+
+    app_speak_sound_cfg_t spk;
+    app_speak_sound_get_cfg(&spk);
+    ESP_RETURN_ON_FALSE(a.sample_rate == spk.sample_rate && a.channels == spk.channels, ESP_ERR_NOT_SUPPORTED, TAG,
+                        "asset %u is %dHz/%dch, speaker is %dHz/%dch", (unsigned)id, a.sample_rate, a.channels,
+                        spk.sample_rate, spk.channels);
+
+    // 分块写：映射区直接作为源；混音器运行时作为提示音混入，否则 codec 驱动直接拷入 DMA 缓冲
+    const uint8_t *p = (const uint8_t *)a.data;
+    size_t left = a.len;
+    while (left > 0) {
+        size_t n = left > ASSET_PLAY_CHUNK ? ASSET_PLAY_CHUNK : left;
+        ESP_RETURN_ON_ERROR(app_speak_sound_stream_play(APP_SPK_STREAM_EARCON, p, n), TAG, "spk write failed");
+        p += n;
+        left -= n;
+    }
+    return ESP_OK;
+}
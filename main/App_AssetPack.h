@@ -0,0 +1,106 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 只读资源包（asset pack）：由 tools/mkassetpack.py 生成，烧到 model 分区（subtype 0x40）。
+ * 整包通过 esp_partition_mmap 映射，资源直接从 flash 映射地址读，不做堆拷贝。
+ *
+ * 布局（小端）：
+ *   header(32B) | entry table(slot_count * 32B，按 id 直接下标) | data（每段 16B 对齐）
+ */
+
+#define APP_ASSET_PACK_MAGIC   0x50414447u // "GDAP"
+#define APP_ASSET_PACK_VERSION 1
+
+// 约定的资源 id（与 tools/mkassetpack.py 的 manifest 一致）
+#define APP_ASSET_ID_EARCON_WAKE     1  // 唤醒/开始聆听提示音
+#define APP_ASSET_ID_EARCON_END      2  // 说话结束、已提交
+#define APP_ASSET_ID_EARCON_ERROR    3  // 网络/服务异常
+#define APP_ASSET_ID_FILLER_BASE     16 // 垫音池起始 id（"嗯…"、"我想想"等）
+#define APP_ASSET_ID_FILLER_MAX      16 // 垫音池最大条数
+#define APP_ASSET_ID_KWS_MODEL       64 // 唤醒词模型（blob）
+#define APP_ASSET_ID_KWS_REPLAY      65 // 唤醒词回放测试录音（PCM，可选）
+#define APP_ASSET_ID_KWS_LABELS      66 // 回放录音中唤醒词结束时刻（blob，u32le 毫秒数组，可选）
+
+typedef enum {
+    APP_ASSET_KIND_NONE = 0, // 空槽
+    APP_ASSET_KIND_PCM = 1,  // s16le PCM
+    APP_ASSET_KIND_BLOB = 2, // 任意二进制（模型权重等）
+} app_asset_kind_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t entry_size;  // sizeof(app_asset_entry_t)
+    uint32_t slot_count;  // 最大 id + 1
+    uint32_t table_off;
+    uint32_t data_off;
+    uint32_t total_size;  // 整包字节数
+    uint32_t crc32;       // [table_off, total_size) 的 CRC32
+    uint32_t reserved;
+} app_asset_pack_hdr_t;
+
+typedef struct {
+    uint32_t offset;      // 相对包起始
+    uint32_t length;
+    uint32_t sample_rate; // PCM 有效
+    uint8_t kind;         // app_asset_kind_t
+    uint8_t channels;     // PCM 有效
+    uint8_t bits;         // PCM 有效（16）
+    uint8_t reserved;
+    char name[16];
+} app_asset_entry_t;
+
+typedef struct {
+    const void *data;     // 指向 flash 映射区，只读
+    size_t len;
+    app_asset_kind_t kind;
+    int sample_rate;
+    int channels;
+    const char *name;
+} app_asset_t;
+
+/**
+ * @brief 映射资源包（单例）
+ *
+ * @param partition_label NULL 则用 "model"
+ */
+esp_err_t app_asset_pack_open(const char *partition_label);
+
+/**
+ * @brief 资源包是否已加载
+ */
+bool app_asset_pack_ready(void);
+
+/**
+ * @brief 按 id 查找资源（O(1)，直接下标）
+ *
+ * @return ESP_ERR_NOT_FOUND：未加载或该 id 为空槽
+ */
+esp_err_t app_asset_get(uint16_t id, app_asset_t *out);
+
+/**
+ * @brief 校验整包 CRC（开机可选，3MB 约几十 ms）
+ */
+esp_err_t app_asset_pack_verify(void);
+
+/**
+ * @brief 直接从映射区播放 PCM 资源（阻塞到写完）
+ *
+ * @note 要求资源采样率/声道与喇叭配置一致（打包时已转换），否则返回 ESP_ERR_NOT_SUPPORTED。
+ * @note 混音器已启动时作为提示音（EARCON 流）混入，回复被压低而不是被打断。
+ */
+esp_err_t app_asset_play(uint16_t id);
+
+#ifdef __cplusplus
+}
+#endif
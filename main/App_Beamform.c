@@ -0,0 +1,185 @@
+#include "App_Beamform.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+
+static const char *TAG = "App_Beamform";
+
+#define BF_SOUND_MM_PER_S 343000
+// 有声帧判定：能量高于底噪 1.5 倍，且不是数字静音
+#define BF_MIN_ENERGY 64
+
+app_beamform_cfg_t app_beamform_cfg_default(int sample_rate)
+{
+    app_beamform_cfg_t c = {
+        .sample_rate = sample_rate,
+        .mic_distance_mm = 60,
+        .max_frame = sample_rate / 50,
+        .budget_us = 300,
+    };
+    return c;
+}
+
+esp_err_t app_beamform_init(app_beamform_t *bf, const app_beamform_cfg_t *cfg)
+{
+    ESP_RETURN_ON_FALSE(bf && cfg && cfg->sample_rate > 0, ESP_ERR_INVALID_ARG, TAG, "bad args");
+    memset(bf, 0, sizeof(*bf));
+
+    app_beamform_cfg_t def = app_beamform_cfg_default(cfg->sample_rate);
+    bf->cfg = *cfg;
+    if (bf->cfg.mic_distance_mm <= 0) bf->cfg.mic_distance_mm = def.mic_distance_mm;
+    if (bf->cfg.max_frame <= 0) bf->cfg.max_frame = def.max_frame;
+    if (bf->cfg.budget_us <= 0) bf->cfg.budget_us = def.budget_us;
+
+    const int64_t num = (int64_t)bf->cfg.mic_distance_mm * bf->cfg.sample_rate;
+    int L = (int)((num + BF_SOUND_MM_PER_S - 1) / BF_SOUND_MM_PER_S);
+    if (L > APP_BF_MAX_LAG) {
+        ESP_LOGW(TAG, "max lag %d clipped to %d", L, APP_BF_MAX_LAG);
+        L = APP_BF_MAX_LAG;
+    }
+    if (L < 1) L = 1;
+    bf->max_lag = L;
+
+    // 四段等长缓冲一次分配：w0 | w1 | d0 | d1
+    const size_t seg = (size_t)(L + bf->cfg.max_frame);
+    int16_t *buf = (int16_t *)calloc(seg * 4, sizeof(int16_t));
+    ESP_RETURN_ON_FALSE(buf, ESP_ERR_NO_MEM, TAG, "alloc %u samples failed", (unsigned)(seg * 4));
+    bf->w0 = buf;
+    bf->w1 = buf + seg;
+    bf->d0 = buf + seg * 2;
+    bf->d1 = buf + seg * 3;
+    bf->st.max_lag = L;
+    return ESP_OK;
+}
+
+void app_beamform_deinit(app_beamform_t *bf)
+{
+    if (!bf) return;
+    free(bf->w0);
+    bf->w0 = bf->w1 = bf->d0 = bf->d1 = NULL;
+}
+
+void app_beamform_set_lag(app_beamform_t *bf, int lag, bool lock)
+{
+    if (!bf) return;
+    if (lag > bf->max_lag) lag = bf->max_lag;
+    if (lag < -bf->max_lag) lag = -bf->max_lag;
+    bf->lag = lag;
+    bf->locked = lock;
+}
+
+static float lag_to_deg(const app_beamform_t *bf, int lag)
+{
+    float s = (float)lag * (float)BF_SOUND_MM_PER_S /
+              ((float)bf->cfg.sample_rate * (float)bf->cfg.mic_distance_mm);
+    if (s > 1.0f) s = 1.0f;
+    if (s < -1.0f) s = -1.0f;
+    return asinf(s) * (180.0f / (float)M_PI);
+}
+
+// 互相关：R(k) = sum d0[j-k] * d1[j]，j 取 [L, L+n-L)，所有 lag 样本数相同
+static void bf_update_doa(app_beamform_t *bf, int n)
+{
+    const int L = bf->max_lag;
+    if (n <= L) return;
+
+    const int16_t *d0 = bf->d0;
+    const int16_t *d1 = bf->d1;
+    int best = 0;
+    int64_t best_v = INT64_MIN;
+    for (int k = -L; k <= L; ++k) {
+        int64_t acc = 0;
+        const int16_t *a = d0 + L - k;
+        const int16_t *b = d1 + L;
+        for (int j = 0; j < n - L; ++j) acc += (int32_t)a[j] * b[j];
+        int64_t *r = &bf->rs[k + APP_BF_MAX_LAG];
+        *r += (acc - *r) / 8;
+        if (*r > best_v) {
+            best_v = *r;
+            best = k;
+        }
+    }
+    bf->st.doa_updates++;
+
+    // 滞回：新方向的相关值须比当前高出 1/8 才切换
+    const int64_t cur_v = bf->rs[bf->lag + APP_BF_MAX_LAG];
+    if (best != bf->lag && (cur_v <= 0 || best_v - cur_v > cur_v / 8)) {
+        bf->lag = best;
+        bf->st.steer_changes++;
+    }
+}
+
+void app_beamform_process(app_beamform_t *bf, const int16_t *m0, const int16_t *m1, int n, int16_t *out)
+{
+    if (!bf || !bf->w0 || n <= 0) return;
+    if (n > bf->cfg.max_frame) n = bf->cfg.max_frame;
+    const uint32_t c0 = esp_cpu_get_cycle_count();
+
+    const int L = bf->max_lag;
+    int16_t *w0 = bf->w0, *w1 = bf->w1, *d0 = bf->d0, *d1 = bf->d1;
+
+    // 入缓冲 + 预加重（一阶差分，压低频、让互相关峰更尖）+ 帧能量
+    int64_t e = 0;
+    int16_t p0 = bf->prev0, p1 = bf->prev1;
+    for (int i = 0; i < n; ++i) {
+        const int16_t a = m0[i], b = m1[i];
+        w0[L + i] = a;
+        w1[L + i] = b;
+        d0[L + i] = (int16_t)(((int32_t)a - p0) >> 1);
+        d1[L + i] = (int16_t)(((int32_t)b - p1) >> 1);
+        e += (int32_t)a * a + (int32_t)b * b;
+        p0 = a;
+        p1 = b;
+    }
+    bf->prev0 = p0;
+    bf->prev1 = p1;
+    e /= 2 * n;
+
+    // 底噪：下降快、上升慢（约 256 帧）
+    if (bf->st.frames == 0 || e < bf->floor) {
+        bf->floor = e;
+    } else {
+        bf->floor += (e - bf->floor) / 256 + 1;
+    }
+    if (!bf->locked && e > BF_MIN_ENERGY && e > bf->floor + bf->floor / 2) {
+        bf_update_doa(bf, n);
+    }
+
+    // 延迟求和：先到的一路延迟 |lag| 个样本
+    const int lag = bf->lag;
+    const int16_t *a = (lag >= 0) ? w0 + L - lag : w0 + L;
+    const int16_t *b = (lag >= 0) ? w1 + L : w1 + L + lag;
+    for (int i = 0; i < n; ++i) {
+        out[i] = (int16_t)(((int32_t)a[i] + b[i]) >> 1);
+    }
+
+    // 保留最后 L 个样本作为下一帧的历史
+    memmove(w0, w0 + n, (size_t)L * sizeof(int16_t));
+    memmove(w1, w1 + n, (size_t)L * sizeof(int16_t));
+    memmove(d0, d0 + n, (size_t)L * sizeof(int16_t));
+    memmove(d1, d1 + n, (size_t)L * sizeof(int16_t));
+
+    const uint32_t cyc = esp_cpu_get_cycle_count() - c0;
+    app_beamform_stats_t *st = &bf->st;
+    st->frames++;
+    st->lag = lag;
+    st->cycles_last = cyc;
+    st->cycles_avg = st->cycles_avg ? (st->cycles_avg * 7 + cyc) / 8 : cyc;
+    if (cyc > st->cycles_max) st->cycles_max = cyc;
+    // 预算按 20ms 音频折算到本帧长度
+    const uint64_t used_us_x = (uint64_t)cyc * (uint64_t)bf->cfg.sample_rate;
+    const uint64_t budget_us_x = (uint64_t)bf->cfg.budget_us * (uint64_t)n * 50u * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    if (used_us_x > budget_us_x) st->over_budget++;
+}
+
+void app_beamform_get_stats(const app_beamform_t *bf, app_beamform_stats_t *out)
+{
+    if (!bf || !out) return;
+    *out = bf->st;
+    out->doa_deg = lag_to_deg(bf, bf->lag);
+}
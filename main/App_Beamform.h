@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 双麦定点延迟求和波束（整样本延迟）+ 到达方向估计。
+ *
+ *   m0, m1 ──预加重──> 互相关 R(k), |k| <= max_lag ──有声帧 EWMA──> argmax = lag（带滞回）
+ *   y[n] = (m0[n - lag] + m1[n]) / 2      （lag < 0 时改为延迟 m1）
+ *
+ * max_lag = ceil(mic_distance * fs / 343m/s)；lag>0 表示声源偏向 m0 一侧（m1 晚到）。
+ * 目标方向相干叠加、非相干噪声平均，两麦约 +3 dB；只在能量高于底噪的帧更新方向，
+ * 避免静音期被扩散噪声拉走。
+ *
+ * CPU：每样本约 (2*max_lag+1) 次乘加；24 kHz / 60 mm 时 max_lag=5，约 11 次。
+ */
+
+#define APP_BF_MAX_LAG 8
+
+typedef struct {
+    int sample_rate;            // 必填
+    int mic_distance_mm;        // 默认 60
+    int max_frame;              // 单次 process 最多样本数，默认 20ms
+    int budget_us;              // 每 20ms 音频的 CPU 预算，默认 300（约单核 1.5%）；超出只计数
+} app_beamform_cfg_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t doa_updates;       // 参与方向估计的有声帧数
+    uint32_t steer_changes;
+    uint32_t over_budget;
+    int lag;                    // 当前导向延迟（样本）
+    int max_lag;
+    float doa_deg;              // -90..90，0 为正前方（两麦连线的垂直方向）
+    uint32_t cycles_last;       // 单帧 CPU 周期
+    uint32_t cycles_avg;
+    uint32_t cycles_max;
+} app_beamform_stats_t;
+
+typedef struct {
+    app_beamform_cfg_t cfg;
+    int max_lag;
+    int16_t *w0, *w1;           // [max_lag 历史 | 当前帧]
+    int16_t *d0, *d1;           // 预加重后的同布局副本，只用于方向估计
+    int16_t prev0, prev1;       // 预加重用的上一样本
+    int64_t rs[2 * APP_BF_MAX_LAG + 1];
+    int64_t floor;              // 帧能量底噪
+    int lag;
+    bool locked;
+    app_beamform_stats_t st;
+} app_beamform_t;
+
+app_beamform_cfg_t app_beamform_cfg_default(int sample_rate);
+
+esp_err_t app_beamform_init(app_beamform_t *bf, const app_beamform_cfg_t *cfg);
+void app_beamform_deinit(app_beamform_t *bf);
+
+/**
+ * @brief 处理一帧；out 可与 m0 相同。n 不超过 max_frame
+ */
+void app_beamform_process(app_beamform_t *bf, const int16_t *m0, const int16_t *m1, int n, int16_t *out);
+
+/**
+ * @brief 固定导向延迟（测试/标定用）；lock=false 恢复自动估计
+ */
+void app_beamform_set_lag(app_beamform_t *bf, int lag, bool lock);
+
+void app_beamform_get_stats(const app_beamform_t *bf, app_beamform_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
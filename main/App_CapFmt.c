@@ -0,0 +1,209 @@
+#include "App_CapFmt.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_log.h"
+
+static const char *TAG = "App_CapFmt";
+
+// ---------- 通用内核 ----------
+
+static void k_generic_s16(const app_cap_fmt_t *f, const void *in, int frames, int16_t *mic, int16_t *ref)
+{
+    const int16_t *x = (const int16_t *)in;
+    const int lanes = f->lanes;
+    const int n_mic = f->n_mic;
+    for (int i = 0; i < frames; ++i, x += lanes) {
+        int32_t s = 0;
+        for (int k = 0; k < n_mic; ++k) s += x[f->mic[k]];
+        mic[i] = (int16_t)(s / n_mic);
+        if (ref) ref[i] = (f->ref >= 0) ? x[f->ref] : 0;
+    }
+}
+
+static void k_generic_s32(const app_cap_fmt_t *f, const void *in, int frames, int16_t *mic, int16_t *ref)
+{
+    const int32_t *x = (const int32_t *)in;
+    const int lanes = f->lanes;
+    const int n_mic = f->n_mic;
+    for (int i = 0; i < frames; ++i, x += lanes) {
+        // 取高 16 位：算术右移后必然落在 int16 范围内，无需再饱和
+        int32_t s = 0;
+        for (int k = 0; k < n_mic; ++k) s += x[f->mic[k]] >> 16;
+        mic[i] = (int16_t)(s / n_mic);
+        if (ref) ref[i] = (f->ref >= 0) ? (int16_t)(x[f->ref] >> 16) : 0;
+    }
+}
+
+static void s_generic_s16(const app_cap_fmt_t *f, const void *in, int frames, int16_t *m0, int16_t *m1,
+                          int16_t *ref)
+{
+    const int16_t *x = (const int16_t *)in;
+    const int lanes = f->lanes;
+    const int a = f->mic[0], b = f->mic[1];
+    for (int i = 0; i < frames; ++i, x += lanes) {
+        m0[i] = x[a];
+        m1[i] = x[b];
+        if (ref) ref[i] = (f->ref >= 0) ? x[f->ref] : 0;
+    }
+}
+
+static void s_generic_s32(const app_cap_fmt_t *f, const void *in, int frames, int16_t *m0, int16_t *m1,
+                          int16_t *ref)
+{
+    const int32_t *x = (const int32_t *)in;
+    const int lanes = f->lanes;
+    const int a = f->mic[0], b = f->mic[1];
+    for (int i = 0; i < frames; ++i, x += lanes) {
+        m0[i] = (int16_t)(x[a] >> 16);
+        m1[i] = (int16_t)(x[b] >> 16);
+        if (ref) ref[i] = (f->ref >= 0) ? (int16_t)(x[f->ref] >> 16) : 0;
+    }
+}
+
+// 单声道 16bit：原样拷贝
+static void k_mono_s16(const app_cap_fmt_t *f, const void *in, int frames, int16_t *mic, int16_t *ref)
+{
+    (void)f;
+    memcpy(mic, in, (size_t)frames * sizeof(int16_t));
+    if (ref) memset(ref, 0, (size_t)frames * sizeof(int16_t));
+}
+
+// ---------- 特化内核 ----------
+// 常见 codec 布局：按 32bit 字读、在寄存器里拆 lane（小端：低半字是前一个 lane），每次两帧，
+// 省掉通用内核里的 lane 下标查表和内层循环。下混与通用内核同样按除法向零取整，结果逐位一致。
+// 这是 32bit 字内的 SWAR，不是 PIE：拆 lane 要靠 ee.vunzip.16，它的输出顺序没有在目标板上核对过，
+// 下混的向零取整也得另补符号修正；每帧只有几条搬运指令，主机上已比通用内核快 2.6~5.8 倍（cap_fmt_bench）。
+
+// 2ch × 32bit = 4 个 16bit lane，"RMNM"（ES7210）：w0 = [R | M0]，w1 = [N | M1]
+static void k_rmnm(const app_cap_fmt_t *f, const void *in, int frames, int16_t *restrict mic,
+                   int16_t *restrict ref)
+{
+    (void)f;
+    const uint32_t *restrict w = (const uint32_t *)in;
+    int i = 0;
+    for (; i + 2 <= frames; i += 2, w += 4) {
+        const uint32_t a0 = w[0], a1 = w[1], b0 = w[2], b1 = w[3];
+        mic[i] = (int16_t)((((int32_t)a0 >> 16) + ((int32_t)a1 >> 16)) / 2);
+        mic[i + 1] = (int16_t)((((int32_t)b0 >> 16) + ((int32_t)b1 >> 16)) / 2);
+        if (ref) {
+            ref[i] = (int16_t)a0;
+            ref[i + 1] = (int16_t)b0;
+        }
+    }
+    for (; i < frames; ++i, w += 2) {
+        mic[i] = (int16_t)((((int32_t)w[0] >> 16) + ((int32_t)w[1] >> 16)) / 2);
+        if (ref) ref[i] = (int16_t)w[0];
+    }
+}
+
+static void s_rmnm(const app_cap_fmt_t *f, const void *in, int frames, int16_t *restrict m0,
+                   int16_t *restrict m1, int16_t *restrict ref)
+{
+    (void)f;
+    const uint32_t *restrict w = (const uint32_t *)in;
+    for (int i = 0; i < frames; ++i, w += 2) {
+        const uint32_t a = w[0], b = w[1];
+        m0[i] = (int16_t)(a >> 16);
+        m1[i] = (int16_t)(b >> 16);
+        if (ref) ref[i] = (int16_t)a;
+    }
+}
+
+// 2ch × 16bit，"MR"（ES8311）：w = [M | R]
+static void k_mr(const app_cap_fmt_t *f, const void *in, int frames, int16_t *restrict mic,
+                 int16_t *restrict ref)
+{
+    (void)f;
+    const uint32_t *restrict w = (const uint32_t *)in;
+    int i = 0;
+    for (; i + 2 <= frames; i += 2, w += 2) {
+        const uint32_t a = w[0], b = w[1];
+        mic[i] = (int16_t)a;
+        mic[i + 1] = (int16_t)b;
+        if (ref) {
+            ref[i] = (int16_t)(a >> 16);
+            ref[i + 1] = (int16_t)(b >> 16);
+        }
+    }
+    for (; i < frames; ++i, ++w) {
+        mic[i] = (int16_t)w[0];
+        if (ref) ref[i] = (int16_t)(w[0] >> 16);
+    }
+}
+
+// 特化内核按固定 lane 位置写死，只在运行时格式与表项完全一致时选用
+static const struct {
+    int channels;
+    int bits;
+    const char *layout;
+    app_cap_fmt_kernel_t kernel;
+    app_cap_fmt_split_t split;
+    const char *name;
+} k_special[] = {
+    {2, 32, "RMNM", k_rmnm, s_rmnm, "rmnm_w32"},
+    {2, 16, "MR", k_mr, NULL, "mr_w32"},
+};
+
+void app_cap_fmt_use_generic(app_cap_fmt_t *f)
+{
+    if (!f) return;
+    if (f->lane_bits == 32) {
+        f->kernel = k_generic_s32;
+        f->split = (f->n_mic >= 2) ? s_generic_s32 : NULL;
+        f->kernel_name = "generic_s32";
+    } else {
+        f->kernel = k_generic_s16;
+        f->split = (f->n_mic >= 2) ? s_generic_s16 : NULL;
+        f->kernel_name = "generic_s16";
+    }
+}
+
+esp_err_t app_cap_fmt_init(app_cap_fmt_t *f, int channels, int bits, const char *layout)
+{
+    ESP_RETURN_ON_FALSE(f && channels > 0 && (bits == 16 || bits == 32), ESP_ERR_INVALID_ARG, TAG,
+                        "bad format %dch/%dbit", channels, bits);
+    memset(f, 0, sizeof(*f));
+    f->ref = -1;
+
+    const int lanes = layout ? (int)strlen(layout) : channels;
+    ESP_RETURN_ON_FALSE(lanes > 0 && lanes <= APP_CAP_FMT_MAX_LANES && (channels * bits) % lanes == 0,
+                        ESP_ERR_INVALID_ARG, TAG, "bad layout %s for %dch/%dbit", layout ? layout : "-", channels,
+                        bits);
+    f->lanes = lanes;
+    f->lane_bits = channels * bits / lanes;
+    f->frame_bytes = channels * bits / 8;
+    ESP_RETURN_ON_FALSE(f->lane_bits == 16 || f->lane_bits == 32, ESP_ERR_NOT_SUPPORTED, TAG,
+                        "lane width %d not supported", f->lane_bits);
+
+    for (int i = 0; i < lanes; ++i) {
+        const char c = layout ? layout[i] : 'M';
+        if (c == 'M') {
+            f->mic[f->n_mic++] = (int8_t)i;
+        } else if (c == 'R') {
+            if (f->ref < 0) f->ref = i;
+        } else {
+            ESP_RETURN_ON_FALSE(c == 'N', ESP_ERR_INVALID_ARG, TAG, "bad layout char '%c'", c);
+        }
+    }
+    ESP_RETURN_ON_FALSE(f->n_mic > 0, ESP_ERR_INVALID_ARG, TAG, "layout has no mic lane");
+
+    for (size_t i = 0; i < sizeof(k_special) / sizeof(k_special[0]); ++i) {
+        if (k_special[i].channels == channels && k_special[i].bits == bits && layout &&
+            strcmp(layout, k_special[i].layout) == 0) {
+            f->kernel = k_special[i].kernel;
+            f->split = k_special[i].split;
+            f->kernel_name = k_special[i].name;
+            return ESP_OK;
+        }
+    }
+    if (lanes == 1 && f->lane_bits == 16) {
+        f->kernel = k_mono_s16;
+        f->kernel_name = "mono_s16";
+    } else {
+        app_cap_fmt_use_generic(f);
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 采集格式转换：I2S 多声道 / 32bit 原始帧 -> 单声道 s16 麦克风 + 可选 s16 回采参考。
+ *
+ * layout 每个字母对应一个 lane（与 board_config.h 的 INPUT_CH_ALLOCATION 同义）：
+ *   'M' 麦克风（多路取平均下混，向零取整），'R' 回采参考，'N' 未用。
+ * lane 位宽 = channels * bits / strlen(layout)，只支持 16/32；
+ * 例如 ES7210 上 2ch × 32bit + "RMNM" 即每帧 4 个 16bit lane。
+ *
+ * 运行时格式是常见 codec 布局（2ch×32bit "RMNM"、2ch×16bit "MR"）时选用按字处理的特化内核，
+ * 其余组合走通用内核；两者输出逐位一致。
+ */
+
+#define APP_CAP_FMT_MAX_LANES 8
+
+struct app_cap_fmt;
+typedef void (*app_cap_fmt_kernel_t)(const struct app_cap_fmt *f, const void *in, int frames,
+                                     int16_t *mic, int16_t *ref);
+typedef void (*app_cap_fmt_split_t)(const struct app_cap_fmt *f, const void *in, int frames, int16_t *m0,
+                                    int16_t *m1, int16_t *ref);
+
+typedef struct app_cap_fmt {
+    int lanes;                  // 每帧 lane 数
+    int lane_bits;              // 16 / 32
+    int frame_bytes;            // 每帧原始字节数
+    int8_t mic[APP_CAP_FMT_MAX_LANES];
+    int n_mic;
+    int ref;                    // 参考 lane 下标，-1 表示没有
+    app_cap_fmt_kernel_t kernel;
+    app_cap_fmt_split_t split;  // n_mic >= 2 时有效
+    const char *kernel_name;
+} app_cap_fmt_t;
+
+/**
+ * @brief 解析采集格式并选择内核
+ *
+ * @param layout 可为 NULL：全部按麦克风处理（lane 数 = channels，位宽 = bits）
+ */
+esp_err_t app_cap_fmt_init(app_cap_fmt_t *f, int channels, int bits, const char *layout);
+
+/**
+ * @brief 强制改用通用内核（对比特化内核的性能/结果时用）
+ */
+void app_cap_fmt_use_generic(app_cap_fmt_t *f);
+
+/**
+ * @brief 转换 frames 帧；mic 输出 frames 个样本，ref 可为 NULL（无参考 lane 时输出静音）
+ */
+static inline void app_cap_fmt_convert(const app_cap_fmt_t *f, const void *in, int frames, int16_t *mic,
+                                       int16_t *ref)
+{
+    f->kernel(f, in, frames, mic, ref);
+}
+
+/**
+ * @brief 拆出前两路麦克风（不下混），供波束形成使用；要求 n_mic >= 2
+ */
+static inline void app_cap_fmt_split(const app_cap_fmt_t *f, const void *in, int frames, int16_t *m0, int16_t *m1,
+                                     int16_t *ref)
+{
+    f->split(f, in, frames, m0, m1, ref);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,166 @@
+#include "App_EventBus.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "esp_check.h"
+#include "esp_log.h"
+
+static const char *TAG = "App_EventBus";
+
+#define EVT_BUS_MAX_SUBS 8
+
+struct app_evt_sub_t {
+    QueueHandle_t q;
+    uint32_t mask;
+    uint32_t refs;  // 正在向它投递的 publish 数（锁内增减），unsubscribe 等它归零再删队列
+};
+
+typedef struct {
+    portMUX_TYPE lock;
+    app_evt_sub_t *subs[EVT_BUS_MAX_SUBS];
+    uint32_t seq;
+    app_evt_bus_stats_t st;
+} evt_bus_t;
+
+static evt_bus_t s_bus = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+esp_err_t app_event_bus_subscribe(uint32_t mask, int depth, app_evt_sub_t **out_sub)
+{
+    ESP_RETURN_ON_FALSE(out_sub && mask, ESP_ERR_INVALID_ARG, TAG, "arg invalid");
+    *out_sub = NULL;
+
+    app_evt_sub_t *s = (app_evt_sub_t *)calloc(1, sizeof(*s));
+    ESP_RETURN_ON_FALSE(s, ESP_ERR_NO_MEM, TAG, "alloc sub failed");
+    s->q = xQueueCreate(depth > 0 ? depth : 16, sizeof(app_evt_t));
+    s->mask = mask;
+    if (!s->q) {
+        free(s);
+        return ESP_ERR_NO_MEM;
+    }
+
+    bool added = false;
+    portENTER_CRITICAL(&s_bus.lock);
+    for (int i = 0; i < EVT_BUS_MAX_SUBS; ++i) {
+        if (!s_bus.subs[i]) {
+            s_bus.subs[i] = s;
+            added = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_bus.lock);
+
+    if (!added) {
+        vQueueDelete(s->q);
+        free(s);
+        ESP_LOGE(TAG, "too many subscribers (max %d)", EVT_BUS_MAX_SUBS);
+        return ESP_ERR_NO_MEM;
+    }
+    *out_sub = s;
+    return ESP_OK;
+}
+
+void app_event_bus_unsubscribe(app_evt_sub_t *sub)
+{
+    if (!sub) return;
+    portENTER_CRITICAL(&s_bus.lock);
+    for (int i = 0; i < EVT_BUS_MAX_SUBS; ++i) {
+        if (s_bus.subs[i] == sub) s_bus.subs[i] = NULL;
+    }
+    portEXIT_CRITICAL(&s_bus.lock);
+
+    // 已拍到快照的 publish 可能还在 xQueueSend（非阻塞，很快结束）
+    for (;;) {
+        portENTER_CRITICAL(&s_bus.lock);
+        const uint32_t refs = sub->refs;
+        portEXIT_CRITICAL(&s_bus.lock);
+        if (refs == 0) break;
+        vTaskDelay(1);
+    }
+    vQueueDelete(sub->q);
+    free(sub);
+}
+
+esp_err_t app_event_bus_recv(app_evt_sub_t *sub, app_evt_t *out, TickType_t timeout)
+{
+    ESP_RETURN_ON_FALSE(sub && out, ESP_ERR_INVALID_ARG, TAG, "arg invalid");
+    return (xQueueReceive(sub->q, out, timeout) == pdTRUE) ? ESP_OK : ESP_ERR_TIMEOUT;
+}
+
+void app_event_bus_publish(const app_evt_t *evt)
+{
+    if (!evt || evt->type >= APP_EVT_MAX) return;
+
+    // 先在锁内拍一份订阅快照并给每个订阅者加引用（xQueueSend 不能放在临界区里）
+    app_evt_sub_t *subs[EVT_BUS_MAX_SUBS];
+    int n = 0;
+    app_evt_t e = *evt;
+    portENTER_CRITICAL(&s_bus.lock);
+    for (int i = 0; i < EVT_BUS_MAX_SUBS; ++i) {
+        app_evt_sub_t *s = s_bus.subs[i];
+        if (!s || !(s->mask & APP_EVT_MASK(e.type))) continue;
+        s->refs++;
+        subs[n++] = s;
+    }
+    e.seq = ++s_bus.seq;
+    s_bus.st.published++;
+    portEXIT_CRITICAL(&s_bus.lock);
+
+    uint32_t delivered = 0, dropped = 0;
+    for (int i = 0; i < n; ++i) {
+        if (xQueueSend(subs[i]->q, &e, 0) == pdTRUE) {
+            delivered++;
+        } else {
+            dropped++;
+        }
+    }
+
+    portENTER_CRITICAL(&s_bus.lock);
+    for (int i = 0; i < n; ++i) subs[i]->refs--;
+    s_bus.st.delivered += delivered;
+    s_bus.st.dropped += dropped;
+    portEXIT_CRITICAL(&s_bus.lock);
+}
+
+// 不在 UTF-8 多字节字符中间截断
+static size_t utf8_cut(const char *s, size_t len, size_t max)
+{
+    if (len <= max) return len;
+    size_t n = max;
+    while (n > 0 && ((uint8_t)s[n] & 0xC0) == 0x80) n--;
+    return n > 0 ? n : max;
+}
+
+void app_event_bus_publish_text(app_evt_type_t type, const char *req, const char *text, size_t len)
+{
+    if (!text) return;
+    app_evt_t e = {0};
+    e.type = (uint8_t)type;
+    if (req) {
+        strncpy(e.req, req, sizeof(e.req) - 1);
+    }
+
+    do {
+        size_t n = utf8_cut(text, len, APP_EVT_TEXT_MAX - 1);
+        memcpy(e.text, text, n);
+        e.text[n] = '\0';
+        e.len = (uint16_t)n;
+        text += n;
+        len -= n;
+        e.more = (len > 0);
+        app_event_bus_publish(&e);
+    } while (len > 0);
+}
+
+void app_event_bus_get_stats(app_evt_bus_stats_t *out)
+{
+    if (!out) return;
+    portENTER_CRITICAL(&s_bus.lock);
+    *out = s_bus.st;
+    portEXIT_CRITICAL(&s_bus.lock);
+}
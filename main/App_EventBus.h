@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 轻量事件总线：发布端（WS 接收路径）只做一次非阻塞入队；
+ * 订阅端（表情/动作/显示等）各自持有一个队列，在自己的任务里取事件。
+ * 订阅队列满时丢弃该订阅的这条事件并计数，不会反压发布端。
+ */
+
+typedef enum {
+    APP_EVT_META = 0,       // 回复开始：anim/motion（尽早驱动表情与动作）
+    APP_EVT_ASR_TEXT = 1,   // 用户语音识别结果
+    APP_EVT_TEXT_DELTA = 2, // 回复文本增量（长增量会拆成多条）
+    APP_EVT_TEXT = 3,       // 回复完整文本
+    APP_EVT_REPLY_END = 4,  // 本轮下行结束（is_last）
+    APP_EVT_MAX,
+} app_evt_type_t;
+
+#define APP_EVT_MASK(t) (1u << (t))
+#define APP_EVT_MASK_ALL ((1u << APP_EVT_MAX) - 1)
+
+#define APP_EVT_TEXT_MAX 96
+
+typedef struct {
+    uint8_t type;           // app_evt_type_t
+    uint8_t more;           // 文本被拆分时：后面还有同一条的剩余部分
+    uint16_t len;           // text 有效长度
+    uint32_t seq;           // 发布序号（订阅端可据此发现丢失）
+    char req[24];
+    union {
+        struct {
+            char anim[32];
+            char motion[32];
+        } meta;
+        char text[APP_EVT_TEXT_MAX]; // 以 '\0' 结尾
+    };
+} app_evt_t;
+
+typedef struct app_evt_sub_t app_evt_sub_t;
+
+typedef struct {
+    uint32_t published;
+    uint32_t delivered;
+    uint32_t dropped;       // 订阅队列满被丢弃的次数（所有订阅累计）
+} app_evt_bus_stats_t;
+
+/**
+ * @brief 订阅事件（mask 为 APP_EVT_MASK() 的组合，depth<=0 用默认 16）
+ */
+esp_err_t app_event_bus_subscribe(uint32_t mask, int depth, app_evt_sub_t **out_sub);
+
+/**
+ * @brief 取消订阅：等并发中的 publish 投递完再删除队列（可能让出 CPU，不要在 ISR/临界区里调用）
+ */
+void app_event_bus_unsubscribe(app_evt_sub_t *sub);
+
+/**
+ * @brief 订阅端取事件（在订阅者自己的任务里调用）
+ *
+ * @return ESP_ERR_TIMEOUT：超时无事件
+ */
+esp_err_t app_event_bus_recv(app_evt_sub_t *sub, app_evt_t *out, TickType_t timeout);
+
+/**
+ * @brief 发布事件（非阻塞，可在 WS 接收路径上直接调用）
+ */
+void app_event_bus_publish(const app_evt_t *evt);
+
+/**
+ * @brief 发布文本类事件：超过 APP_EVT_TEXT_MAX-1 的文本按 UTF-8 边界拆成多条（more=1）
+ */
+void app_event_bus_publish_text(app_evt_type_t type, const char *req, const char *text, size_t len);
+
+void app_event_bus_get_stats(app_evt_bus_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,724 @@
+#include "App_EventCache.h"
+
+#include <dirent.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_spiffs.h"
+#include "esp_timer.h"
+
+static const char *TAG = "App_EventCache";
+
+#define EC_MAX_ENTRIES 64
+#define EC_INDEX_MAGIC 0x31494345u // "ECI1"
+#define EC_FILE_MAGIC 0x31304345u  // "EC01"
+#define EC_IO_CHUNK 4096
+
+typedef struct {
+    char event[24];
+    char af[24];
+    char ver[32];
+    uint32_t file_id;
+    uint32_t pcm_len;
+    uint32_t lru;      // 越大越新
+    uint32_t sum;      // FNV-1a(pcm)：服务端不带 version 时用来判断内容是否变化
+    uint8_t used;
+    uint8_t reserved[3];
+} ec_entry_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t next_file_id;
+    uint32_t lru_clock;
+    uint32_t count;
+    ec_entry_t e[EC_MAX_ENTRIES];
+} ec_index_t;
+
+// 每个缓存文件：头部（meta）+ 原始 PCM
+typedef struct {
+    uint32_t magic;
+    uint32_t pcm_len;
+    char anim[32];
+    char motion[32];
+    char af[32];
+    char ver[32];
+    char text[256];
+} ec_file_hdr_t;
+
+typedef struct {
+    app_event_cache_cfg_t cfg;
+    SemaphoreHandle_t lock;
+    ec_index_t idx;
+    bool revalidating[EC_MAX_ENTRIES];
+    int64_t checked_us[EC_MAX_ENTRIES]; // 上次从服务端拿到/确认内容的时间（只在 RAM）
+    bool inited;
+
+    app_event_cache_stats_t st;
+    uint64_t hit_ms_sum;
+    uint64_t miss_ms_sum;
+} ec_ctx_t;
+
+static ec_ctx_t s_ec = {0};
+
+// 共用的 WS 长连接（可选）：有就走 WS 多路复用，没有/断开就走 HTTP
+static portMUX_TYPE s_ec_ws_mux = portMUX_INITIALIZER_UNLOCKED;
+static app_rb3_ws_sess_t *s_ec_ws;
+static int s_ec_ws_users;
+static volatile bool s_ec_ws_detach;
+
+app_event_cache_cfg_t app_event_cache_cfg_default(void)
+{
+    app_event_cache_cfg_t c = {
+        .partition_label = "storage",
+        .base_path = "/storage",
+        .budget_bytes = 4 * 1024 * 1024,
+        .max_entries = 32,
+        .max_entry_bytes = 512 * 1024,
+        .unversioned_reval_s = 600,
+    };
+    return c;
+}
+
+static uint32_t fnv1a(uint32_t h, const uint8_t *p, size_t n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void ec_path(char *out, size_t out_sz, const char *name)
+{
+    snprintf(out, out_sz, "%s/%s", s_ec.cfg.base_path, name);
+}
+
+static void ec_entry_path(char *out, size_t out_sz, uint32_t file_id)
+{
+    snprintf(out, out_sz, "%s/ec_%08" PRIx32 ".bin", s_ec.cfg.base_path, file_id);
+}
+
+// 写入中的条目：写完后在锁内改名为 .bin；掉电留下的 .tmp 在 init 时清掉
+static void ec_tmp_path(char *out, size_t out_sz, uint32_t file_id)
+{
+    snprintf(out, out_sz, "%s/ec_%08" PRIx32 ".tmp", s_ec.cfg.base_path, file_id);
+}
+
+static void ec_copy(char *dst, size_t dst_sz, const char *src)
+{
+    if (!dst || dst_sz == 0) return;
+    dst[0] = '\0';
+    if (!src) return;
+    strncpy(dst, src, dst_sz - 1);
+    dst[dst_sz - 1] = '\0';
+}
+
+static esp_err_t ec_save_index(void)
+{
+    char path[64];
+    char tmp[64];
+    ec_path(path, sizeof(path), "ec_index.bin");
+    ec_path(tmp, sizeof(tmp), "ec_index.tmp");
+
+    FILE *f = fopen(tmp, "wb");
+    ESP_RETURN_ON_FALSE(f, ESP_FAIL, TAG, "open %s failed", tmp);
+    size_t wr = fwrite(&s_ec.idx, 1, sizeof(s_ec.idx), f);
+    fclose(f);
+    ESP_RETURN_ON_FALSE(wr == sizeof(s_ec.idx), ESP_FAIL, TAG, "write index failed");
+
+    // 先写临时文件再替换，掉电时不会留下半个索引
+    remove(path);
+    ESP_RETURN_ON_FALSE(rename(tmp, path) == 0, ESP_FAIL, TAG, "rename index failed");
+    return ESP_OK;
+}
+
+static void ec_load_index(void)
+{
+    char path[64];
+    ec_path(path, sizeof(path), "ec_index.bin");
+
+    memset(&s_ec.idx, 0, sizeof(s_ec.idx));
+    FILE *f = fopen(path, "rb");
+    if (f) {
+        size_t rd = fread(&s_ec.idx, 1, sizeof(s_ec.idx), f);
+        fclose(f);
+        if (rd != sizeof(s_ec.idx) || s_ec.idx.magic != EC_INDEX_MAGIC) {
+            ESP_LOGW(TAG, "index invalid, reset cache");
+            memset(&s_ec.idx, 0, sizeof(s_ec.idx));
+        }
+    }
+    s_ec.idx.magic = EC_INDEX_MAGIC;
+
+    s_ec.st.used_bytes = 0;
+    s_ec.st.entries = 0;
+    for (int i = 0; i < EC_MAX_ENTRIES; ++i) {
+        if (!s_ec.idx.e[i].used) continue;
+        s_ec.st.used_bytes += s_ec.idx.e[i].pcm_len + sizeof(ec_file_hdr_t);
+        s_ec.st.entries++;
+    }
+}
+
+// 掉电时写了一半的文件（ec_store 的条目临时文件、ec_save_index 的 ec_index.tmp）
+static void ec_remove_tmp(void)
+{
+    DIR *d = opendir(s_ec.cfg.base_path);
+    if (!d) return;
+    struct dirent *de;
+    char path[64];
+    while ((de = readdir(d)) != NULL) {
+        const size_t n = strlen(de->d_name);
+        if (strncmp(de->d_name, "ec_", 3) != 0 || n < 4 || strcmp(de->d_name + n - 4, ".tmp") != 0) continue;
+        ec_path(path, sizeof(path), de->d_name);
+        ESP_LOGW(TAG, "remove stale %s", path);
+        remove(path);
+    }
+    closedir(d);
+}
+
+static int ec_find(const char *event, const char *af)
+{
+    for (int i = 0; i < EC_MAX_ENTRIES; ++i) {
+        const ec_entry_t *e = &s_ec.idx.e[i];
+        if (e->used && strcmp(e->event, event) == 0 && strcmp(e->af, af) == 0) return i;
+    }
+    return -1;
+}
+
+static void ec_drop_entry(int i)
+{
+    ec_entry_t *e = &s_ec.idx.e[i];
+    if (!e->used) return;
+    char path[64];
+    ec_entry_path(path, sizeof(path), e->file_id);
+    remove(path);
+    uint32_t sz = e->pcm_len + sizeof(ec_file_hdr_t);
+    s_ec.st.used_bytes = (s_ec.st.used_bytes > sz) ? (s_ec.st.used_bytes - sz) : 0;
+    if (s_ec.st.entries > 0) s_ec.st.entries--;
+    memset(e, 0, sizeof(*e));
+    // 进行中的后台校验按 file_id 认领结果，槽位换了主人就不再回写
+    s_ec.revalidating[i] = false;
+    s_ec.checked_us[i] = 0;
+}
+
+// 淘汰最久未用的条目，直到能放下 need 字节且有空槽
+static int ec_make_room(uint32_t need)
+{
+    for (;;) {
+        int free_slot = -1;
+        int used = 0;
+        int oldest = -1;
+        for (int i = 0; i < EC_MAX_ENTRIES; ++i) {
+            const ec_entry_t *e = &s_ec.idx.e[i];
+            if (!e->used) {
+                if (free_slot < 0) free_slot = i;
+                continue;
+            }
+            used++;
+            if (s_ec.revalidating[i]) continue;
+            if (oldest < 0 || e->lru < s_ec.idx.e[oldest].lru) oldest = i;
+        }
+        bool fits = (s_ec.st.used_bytes + need <= s_ec.cfg.budget_bytes);
+        if (fits && free_slot >= 0 && used < s_ec.cfg.max_entries) return free_slot;
+        if (oldest < 0) return -1;
+        ESP_LOGI(TAG, "evict %s/%s (%" PRIu32 " bytes)", s_ec.idx.e[oldest].event, s_ec.idx.e[oldest].af,
+                 s_ec.idx.e[oldest].pcm_len);
+        ec_drop_entry(oldest);
+        s_ec.st.evictions++;
+    }
+}
+
+// 先在锁外把整条写进临时文件（SPIFFS 写很慢，不能挡住命中查找），再在锁内占槽、改名、更新索引
+static esp_err_t ec_store(const char *event, const char *af, const app_rb3_meta_t *meta,
+                          const uint8_t *pcm, size_t pcm_len, uint32_t sum)
+{
+    ESP_RETURN_ON_FALSE(pcm && pcm_len > 0, ESP_ERR_INVALID_ARG, TAG, "empty pcm");
+    ESP_RETURN_ON_FALSE(pcm_len <= s_ec.cfg.max_entry_bytes, ESP_ERR_INVALID_SIZE, TAG, "entry too large");
+
+    ec_entry_t e = {0};
+    ec_copy(e.event, sizeof(e.event), event);
+    ec_copy(e.af, sizeof(e.af), af);
+    ec_copy(e.ver, sizeof(e.ver), meta ? meta->ver : NULL);
+    e.pcm_len = (uint32_t)pcm_len;
+    e.sum = sum;
+    e.used = 1;
+    xSemaphoreTake(s_ec.lock, portMAX_DELAY);
+    e.file_id = s_ec.idx.next_file_id++;
+    xSemaphoreGive(s_ec.lock);
+
+    ec_file_hdr_t hdr = {0};
+    hdr.magic = EC_FILE_MAGIC;
+    hdr.pcm_len = (uint32_t)pcm_len;
+    if (meta) {
+        ec_copy(hdr.anim, sizeof(hdr.anim), meta->anim);
+        ec_copy(hdr.motion, sizeof(hdr.motion), meta->motion);
+        ec_copy(hdr.af, sizeof(hdr.af), meta->af);
+        ec_copy(hdr.ver, sizeof(hdr.ver), meta->ver);
+        ec_copy(hdr.text, sizeof(hdr.text), meta->text);
+    }
+
+    char tmp[64];
+    char path[64];
+    ec_tmp_path(tmp, sizeof(tmp), e.file_id);
+    ec_entry_path(path, sizeof(path), e.file_id);
+    FILE *f = fopen(tmp, "wb");
+    ESP_RETURN_ON_FALSE(f, ESP_FAIL, TAG, "open %s failed", tmp);
+    bool ok = fwrite(&hdr, 1, sizeof(hdr), f) == sizeof(hdr);
+    for (size_t off = 0; ok && off < pcm_len; off += EC_IO_CHUNK) {
+        size_t n = pcm_len - off;
+        if (n > EC_IO_CHUNK) n = EC_IO_CHUNK;
+        ok = fwrite(pcm + off, 1, n, f) == n;
+    }
+    fclose(f);
+    if (!ok) {
+        ESP_LOGE(TAG, "write %s failed (partition full?)", tmp);
+        remove(tmp);
+        return ESP_FAIL;
+    }
+
+    xSemaphoreTake(s_ec.lock, portMAX_DELAY);
+    esp_err_t ret = ESP_OK;
+    bool committed = false;
+    int old = ec_find(event, af);
+    if (old >= 0) ec_drop_entry(old);
+
+    const uint32_t need = (uint32_t)pcm_len + sizeof(ec_file_hdr_t);
+    const int slot = ec_make_room(need);
+    if (slot < 0) {
+        ret = ESP_ERR_NO_MEM;
+    } else if (rename(tmp, path) != 0) {
+        ESP_LOGE(TAG, "rename %s failed", tmp);
+        ret = ESP_FAIL;
+    } else {
+        committed = true;
+        e.lru = ++s_ec.idx.lru_clock;
+        s_ec.idx.e[slot] = e;
+        s_ec.checked_us[slot] = esp_timer_get_time();
+        s_ec.st.used_bytes += need;
+        s_ec.st.entries++;
+        ret = ec_save_index();
+        ESP_LOGI(TAG, "stored %s/%s ver=%s pcm=%u bytes, used=%" PRIu32 "/%u",
+                 event, af, e.ver[0] ? e.ver : "(none)", (unsigned)pcm_len, s_ec.st.used_bytes,
+                 (unsigned)s_ec.cfg.budget_bytes);
+    }
+    xSemaphoreGive(s_ec.lock);
+    if (!committed) remove(tmp);
+    return ret;
+}
+
+// ---------------------------------------------------------------------------------------------
+// 网络结果收集（未命中写入 / 后台校验共用）
+
+typedef struct {
+    app_rb3_on_audio_cb on_audio; // 可为 NULL（后台校验只收集不播放）
+    void *cb_ctx;
+    uint8_t *buf;
+    size_t len;
+    size_t cap;
+    size_t max;
+    bool overflow;
+    uint32_t sum;
+    int64_t first_us;
+    // 条件校验：meta 已回且版本等于 same_ver 时不收音频（服务端没理会 if_version 时兜底）
+    const app_rb3_meta_t *meta;
+    const char *same_ver;
+    bool same;
+} ec_collect_t;
+
+static esp_err_t ec_collect_cb(const uint8_t *pcm, size_t pcm_len, bool is_last, void *ctx)
+{
+    ec_collect_t *k = (ec_collect_t *)ctx;
+    if (k->first_us == 0) k->first_us = esp_timer_get_time();
+    if (k->same_ver && k->meta && k->meta->ver[0] && strcmp(k->meta->ver, k->same_ver) == 0) {
+        k->same = true;
+        return ESP_ERR_INVALID_VERSION; // WS 上会发 cancel，剩下的分片不再下行
+    }
+
+    if (!k->overflow && pcm && pcm_len > 0) {
+        if (k->len + pcm_len > k->max) {
+            k->overflow = true;
+        } else {
+            if (k->len + pcm_len > k->cap) {
+                size_t nc = k->cap ? k->cap : 16384;
+                while (nc < k->len + pcm_len) nc *= 2;
+                if (nc > k->max) nc = k->max;
+                uint8_t *p = (uint8_t *)heap_caps_realloc(k->buf, nc, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+                if (!p) p = (uint8_t *)realloc(k->buf, nc);
+                if (!p) {
+                    k->overflow = true;
+                } else {
+                    k->buf = p;
+                    k->cap = nc;
+                }
+            }
+            if (!k->overflow) {
+                memcpy(k->buf + k->len, pcm, pcm_len);
+                k->len += pcm_len;
+                k->sum = fnv1a(k->sum, pcm, pcm_len);
+            }
+        }
+    }
+
+    return k->on_audio ? k->on_audio(pcm, pcm_len, is_last, k->cb_ctx) : ESP_OK;
+}
+
+static app_rb3_ws_sess_t *ec_ws_get(void)
+{
+    app_rb3_ws_sess_t *sess = NULL;
+    portENTER_CRITICAL(&s_ec_ws_mux);
+    if (!s_ec_ws_detach && s_ec_ws) {
+        sess = s_ec_ws;
+        s_ec_ws_users++;
+    }
+    portEXIT_CRITICAL(&s_ec_ws_mux);
+    return sess;
+}
+
+static void ec_ws_put(void)
+{
+    portENTER_CRITICAL(&s_ec_ws_mux);
+    s_ec_ws_users--;
+    portEXIT_CRITICAL(&s_ec_ws_mux);
+}
+
+// 会话要关闭时让进行中的 WS 请求尽快退出
+static bool ec_ws_should_abort(void *ctx)
+{
+    (void)ctx;
+    return s_ec_ws_detach;
+}
+
+static esp_err_t ec_fetch(const app_rb3_cfg_t *cfg, const char *event, const char *req_id, const char *user_id,
+                          const char *if_version, app_rb3_meta_t *out_meta, app_rb3_on_audio_cb on_audio,
+                          void *cb_ctx)
+{
+    app_rb3_ws_sess_t *ws = ec_ws_get();
+    if (ws && app_rb3_ws_is_connected(ws)) {
+        esp_err_t ret = app_rb3_ws_event_stream(ws, event, req_id, user_id, if_version, out_meta, on_audio, cb_ctx,
+                                                ec_ws_should_abort, NULL);
+        ec_ws_put();
+        return ret;
+    }
+    if (ws) ec_ws_put();
+    return app_rb3_http_event_stream(cfg, event, req_id, user_id, if_version, out_meta, on_audio, cb_ctx);
+}
+
+typedef struct {
+    app_rb3_cfg_t cfg;
+    char event[24];
+    char af[24];
+    char user[32];
+    char ver[32];
+    uint32_t sum;
+    uint32_t file_id; // 发起时槽里的条目；结束时槽里已换成别的条目就不回写
+    int slot;
+} ec_reval_arg_t;
+
+static void task_revalidate(void *arg)
+{
+    ec_reval_arg_t *a = (ec_reval_arg_t *)arg;
+
+    app_rb3_meta_t meta = {0};
+    const char *if_ver = a->ver[0] ? a->ver : NULL;
+    ec_collect_t k = {
+        .max = s_ec.cfg.max_entry_bytes,
+        .sum = 2166136261u,
+        .meta = &meta,
+        .same_ver = if_ver,
+    };
+    // req 留空：WS 上由会话生成唯一 req，多个校验可并发；有 version 时是条件请求，未变不下行音频
+    esp_err_t ret = ec_fetch(&a->cfg, a->event, NULL, a->user[0] ? a->user : NULL, if_ver, &meta, ec_collect_cb, &k);
+    const bool not_modified = k.same || (ret == ESP_OK && k.len == 0 && if_ver && strcmp(meta.ver, if_ver) == 0);
+    xSemaphoreTake(s_ec.lock, portMAX_DELAY);
+    s_ec.st.revalidations++;
+    s_ec.st.reval_bytes += (uint32_t)k.len;
+    if (not_modified) s_ec.st.not_modified++;
+    const ec_entry_t *cur = &s_ec.idx.e[a->slot];
+    if (cur->used && cur->file_id == a->file_id) {
+        if (not_modified || ret == ESP_OK) s_ec.checked_us[a->slot] = esp_timer_get_time();
+        s_ec.revalidating[a->slot] = false;
+    }
+    xSemaphoreGive(s_ec.lock);
+
+    if (not_modified) {
+        ESP_LOGD(TAG, "revalidate %s/%s: ver %s not modified", a->event, a->af, a->ver);
+    } else if (ret == ESP_OK && !k.overflow && k.len > 0) {
+        // 服务端给了 version 就按 version 判断；否则比较内容校验和
+        bool changed = meta.ver[0] ? (strcmp(meta.ver, a->ver) != 0) : (k.sum != a->sum);
+        if (changed) {
+            ESP_LOGI(TAG, "revalidate %s/%s: ver %s -> %s, update", a->event, a->af,
+                     a->ver[0] ? a->ver : "(none)", meta.ver[0] ? meta.ver : "(none)");
+            if (ec_store(a->event, a->af, &meta, k.buf, k.len, k.sum) == ESP_OK) {
+                xSemaphoreTake(s_ec.lock, portMAX_DELAY);
+                s_ec.st.updates++;
+                xSemaphoreGive(s_ec.lock);
+            }
+        }
+    } else if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "revalidate %s failed: %s（保留旧缓存）", a->event, esp_err_to_name(ret));
+    }
+
+    free(k.buf);
+    free(a);
+    vTaskDelete(NULL);
+}
+
+static void ec_end_revalidate(int slot, uint32_t file_id)
+{
+    xSemaphoreTake(s_ec.lock, portMAX_DELAY);
+    if (s_ec.idx.e[slot].used && s_ec.idx.e[slot].file_id == file_id) s_ec.revalidating[slot] = false;
+    xSemaphoreGive(s_ec.lock);
+}
+
+// 命中回放成功后调用：同一条目同时只校验一次；无 version 的条目只能整条重下，按 unversioned_reval_s 限频
+static void ec_start_revalidate(const app_rb3_cfg_t *cfg, const char *event, const char *af, const char *user_id,
+                                const ec_entry_t *e, int slot)
+{
+    xSemaphoreTake(s_ec.lock, portMAX_DELAY);
+    const int64_t since_us = esp_timer_get_time() - s_ec.checked_us[slot];
+    bool start = s_ec.idx.e[slot].used && s_ec.idx.e[slot].file_id == e->file_id && !s_ec.revalidating[slot] &&
+                 (e->ver[0] || since_us >= (int64_t)s_ec.cfg.unversioned_reval_s * 1000000);
+    if (start) s_ec.revalidating[slot] = true;
+    xSemaphoreGive(s_ec.lock);
+    if (!start) return;
+
+    ec_reval_arg_t *a = (ec_reval_arg_t *)calloc(1, sizeof(*a));
+    if (!a) {
+        ec_end_revalidate(slot, e->file_id);
+        return;
+    }
+    a->cfg = *cfg;
+    ec_copy(a->event, sizeof(a->event), event);
+    ec_copy(a->af, sizeof(a->af), af);
+    ec_copy(a->user, sizeof(a->user), user_id);
+    ec_copy(a->ver, sizeof(a->ver), e->ver);
+    a->sum = e->sum;
+    a->file_id = e->file_id;
+    a->slot = slot;
+
+    // 低优先级：不与播放/网络主流程争抢
+    if (xTaskCreate(task_revalidate, "task_ec_reval", 6144, a, 2, NULL) != pdPASS) {
+        ec_end_revalidate(slot, e->file_id);
+        free(a);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------
+
+static esp_err_t ec_play_entry(const ec_entry_t *e, const char *req_id, app_rb3_meta_t *out_meta,
+                               app_rb3_on_audio_cb on_audio, void *cb_ctx, int64_t t0, uint32_t *first_ms)
+{
+    char path[64];
+    ec_entry_path(path, sizeof(path), e->file_id);
+    FILE *f = fopen(path, "rb");
+    ESP_RETURN_ON_FALSE(f, ESP_ERR_NOT_FOUND, TAG, "open %s failed", path);
+
+    ec_file_hdr_t hdr;
+    if (fread(&hdr, 1, sizeof(hdr), f) != sizeof(hdr) || hdr.magic != EC_FILE_MAGIC || hdr.pcm_len != e->pcm_len) {
+        fclose(f);
+        ESP_LOGW(TAG, "entry %s corrupted", path);
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    if (out_meta) {
+        memset(out_meta, 0, sizeof(*out_meta));
+        ec_copy(out_meta->req, sizeof(out_meta->req), req_id);
+        ec_copy(out_meta->anim, sizeof(out_meta->anim), hdr.anim);
+        ec_copy(out_meta->motion, sizeof(out_meta->motion), hdr.motion);
+        ec_copy(out_meta->af, sizeof(out_meta->af), hdr.af);
+        ec_copy(out_meta->ver, sizeof(out_meta->ver), hdr.ver);
+        ec_copy(out_meta->text, sizeof(out_meta->text), hdr.text);
+    }
+
+    uint8_t *buf = (uint8_t *)malloc(EC_IO_CHUNK);
+    if (!buf) {
+        fclose(f);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // 边读边算 FNV-1a，最后一块交出去（is_last）之前核对：截断/位翻转的条目不会被当成完整回复
+    esp_err_t ret = ESP_OK;
+    size_t left = hdr.pcm_len;
+    uint32_t sum = 2166136261u;
+    while (left > 0) {
+        size_t n = (left > EC_IO_CHUNK) ? EC_IO_CHUNK : left;
+        if (fread(buf, 1, n, f) != n) {
+            ESP_LOGW(TAG, "entry %s truncated (%u bytes missing)", path, (unsigned)left);
+            ret = ESP_ERR_INVALID_CRC;
+            break;
+        }
+        sum = fnv1a(sum, buf, n);
+        left -= n;
+        if (left == 0 && sum != e->sum) {
+            ESP_LOGW(TAG, "entry %s checksum mismatch", path);
+            ret = ESP_ERR_INVALID_CRC;
+            break;
+        }
+        if (*first_ms == UINT32_MAX) *first_ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+        ret = on_audio(buf, n, left == 0, cb_ctx);
+        if (ret != ESP_OK) break;
+    }
+    free(buf);
+    fclose(f);
+    return ret;
+}
+
+static void ec_record_latency(bool hit, uint32_t ms)
+{
+    xSemaphoreTake(s_ec.lock, portMAX_DELAY);
+    if (hit) {
+        s_ec.st.hits++;
+        s_ec.hit_ms_sum += ms;
+        s_ec.st.hit_first_ms_avg = (uint32_t)(s_ec.hit_ms_sum / s_ec.st.hits);
+    } else {
+        s_ec.st.misses++;
+        s_ec.miss_ms_sum += ms;
+        s_ec.st.miss_first_ms_avg = (uint32_t)(s_ec.miss_ms_sum / s_ec.st.misses);
+    }
+    xSemaphoreGive(s_ec.lock);
+    ESP_LOGI(TAG, "%s: event->first sample %" PRIu32 " ms（平均 hit=%" PRIu32 "ms miss=%" PRIu32 "ms）",
+             hit ? "hit" : "miss", ms, s_ec.st.hit_first_ms_avg, s_ec.st.miss_first_ms_avg);
+}
+
+esp_err_t app_event_cache_init(const app_event_cache_cfg_t *cfg)
+{
+    ESP_RETURN_ON_FALSE(!s_ec.inited, ESP_ERR_INVALID_STATE, TAG, "already inited");
+
+    s_ec.cfg = cfg ? *cfg : app_event_cache_cfg_default();
+    app_event_cache_cfg_t def = app_event_cache_cfg_default();
+    if (!s_ec.cfg.partition_label) s_ec.cfg.partition_label = def.partition_label;
+    if (!s_ec.cfg.base_path) s_ec.cfg.base_path = def.base_path;
+    if (s_ec.cfg.budget_bytes == 0) s_ec.cfg.budget_bytes = def.budget_bytes;
+    if (s_ec.cfg.max_entries <= 0 || s_ec.cfg.max_entries > EC_MAX_ENTRIES) s_ec.cfg.max_entries = def.max_entries;
+    if (s_ec.cfg.max_entry_bytes == 0) s_ec.cfg.max_entry_bytes = def.max_entry_bytes;
+    if (s_ec.cfg.unversioned_reval_s == 0) s_ec.cfg.unversioned_reval_s = def.unversioned_reval_s;
+
+    esp_vfs_spiffs_conf_t conf = {
+        .base_path = s_ec.cfg.base_path,
+        .partition_label = s_ec.cfg.partition_label,
+        .max_files = 4,
+        .format_if_mount_failed = true,
+    };
+    ESP_RETURN_ON_ERROR(esp_vfs_spiffs_register(&conf), TAG, "mount spiffs failed");
+
+    size_t total = 0, used = 0;
+    if (esp_spiffs_info(s_ec.cfg.partition_label, &total, &used) == ESP_OK) {
+        // SPIFFS 接近写满时 GC 很慢，预留 20%
+        size_t cap = (total / 10) * 8;
+        if (s_ec.cfg.budget_bytes > cap) s_ec.cfg.budget_bytes = cap;
+        ESP_LOGI(TAG, "spiffs total=%u used=%u, cache budget=%u", (unsigned)total, (unsigned)used,
+                 (unsigned)s_ec.cfg.budget_bytes);
+    }
+
+    s_ec.lock = xSemaphoreCreateMutex();
+    ESP_RETURN_ON_FALSE(s_ec.lock, ESP_ERR_NO_MEM, TAG, "create lock failed");
+
+    ec_load_index();
+    ec_remove_tmp();
+    s_ec.inited = true;
+    ESP_LOGI(TAG, "cache ready: %" PRIu32 " entries, %" PRIu32 " bytes", s_ec.st.entries, s_ec.st.used_bytes);
+    return ESP_OK;
+}
+
+esp_err_t app_event_cache_event_stream(const app_rb3_cfg_t *cfg,
+                                       const char *event_name,
+                                       const char *req_id,
+                                       const char *user_id,
+                                       app_rb3_meta_t *out_meta,
+                                       app_rb3_on_audio_cb on_audio,
+                                       void *cb_ctx)
+{
+    ESP_RETURN_ON_FALSE(cfg && event_name && on_audio, ESP_ERR_INVALID_ARG, TAG, "arg invalid");
+    if (!s_ec.inited) {
+        return ec_fetch(cfg, event_name, req_id, user_id, NULL, out_meta, on_audio, cb_ctx);
+    }
+
+    const char *af = cfg->af ? cfg->af : "pcm16";
+    const int64_t t0 = esp_timer_get_time();
+
+    // 命中：立即回放，然后后台校验
+    xSemaphoreTake(s_ec.lock, portMAX_DELAY);
+    int slot = ec_find(event_name, af);
+    ec_entry_t e = {0};
+    if (slot >= 0) {
+        s_ec.idx.e[slot].lru = ++s_ec.idx.lru_clock;
+        e = s_ec.idx.e[slot];
+    }
+    xSemaphoreGive(s_ec.lock);
+
+    if (slot >= 0) {
+        uint32_t first_ms = UINT32_MAX;
+        esp_err_t ret = ec_play_entry(&e, req_id, out_meta, on_audio, cb_ctx, t0, &first_ms);
+        if (first_ms != UINT32_MAX) ec_record_latency(true, first_ms);
+        if (ret != ESP_ERR_INVALID_CRC && ret != ESP_ERR_NOT_FOUND) {
+            ec_start_revalidate(cfg, event_name, af, user_id, &e, slot);
+            return ret;
+        }
+        // 文件损坏/截断/丢失：删掉条目，不做校验（“未变”会把坏条目永远留下）
+        xSemaphoreTake(s_ec.lock, portMAX_DELAY);
+        if (s_ec.idx.e[slot].used && s_ec.idx.e[slot].file_id == e.file_id) ec_drop_entry(slot);
+        (void)ec_save_index();
+        xSemaphoreGive(s_ec.lock);
+        // 已经播出一部分时不再从头重放，本次以错误结束，下次未命中重新下载
+        if (first_ms != UINT32_MAX) return ret;
+    }
+
+    // 未命中：走网络，边播边收集
+    ec_collect_t k = {
+        .on_audio = on_audio,
+        .cb_ctx = cb_ctx,
+        .max = s_ec.cfg.max_entry_bytes,
+        .sum = 2166136261u,
+    };
+    app_rb3_meta_t meta = {0};
+    esp_err_t ret = ec_fetch(cfg, event_name, req_id, user_id, NULL, &meta, ec_collect_cb, &k);
+    if (k.first_us > 0) ec_record_latency(false, (uint32_t)((k.first_us - t0) / 1000));
+    if (out_meta) *out_meta = meta;
+
+    if (ret == ESP_OK && !k.overflow && k.len > 0) {
+        (void)ec_store(event_name, af, &meta, k.buf, k.len, k.sum);
+    } else if (k.overflow) {
+        ESP_LOGI(TAG, "%s reply too large for cache (> %u bytes)", event_name, (unsigned)s_ec.cfg.max_entry_bytes);
+    }
+    free(k.buf);
+    return ret;
+}
+
+void app_event_cache_set_ws_session(app_rb3_ws_sess_t *sess)
+{
+    // 先挡住新请求并打断进行中的，等它们都放手后再换
+    portENTER_CRITICAL(&s_ec_ws_mux);
+    s_ec_ws_detach = true;
+    portEXIT_CRITICAL(&s_ec_ws_mux);
+    for (;;) {
+        portENTER_CRITICAL(&s_ec_ws_mux);
+        int users = s_ec_ws_users;
+        portEXIT_CRITICAL(&s_ec_ws_mux);
+        if (users <= 0) break;
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    portENTER_CRITICAL(&s_ec_ws_mux);
+    s_ec_ws = sess;
+    s_ec_ws_detach = false;
+    portEXIT_CRITICAL(&s_ec_ws_mux);
+}
+
+void app_event_cache_get_stats(app_event_cache_stats_t *out)
+{
+    if (!out) return;
+    if (!s_ec.inited) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    xSemaphoreTake(s_ec.lock, portMAX_DELAY);
+    *out = s_ec.st;
+    xSemaphoreGive(s_ec.lock);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "App_RobotBrainV3.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    const char *partition_label; // 默认 "storage"（partitions.csv 里的 SPIFFS 分区）
+    const char *base_path;       // 默认 "/storage"
+    size_t budget_bytes;         // 缓存总大小上限（LRU 淘汰），默认 4MB
+    int max_entries;             // 默认 32
+    size_t max_entry_bytes;      // 单条音频上限，默认 512KB（更长的回复不缓存）
+    uint32_t unversioned_reval_s; // 无 version 的条目只能整条重下比较，两次校验至少间隔这么久，默认 600s
+} app_event_cache_cfg_t;
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t hit_first_ms_avg;   // 命中：调用 -> 第一个音频样本回调
+    uint32_t miss_first_ms_avg;  // 未命中：同上（含网络 + TTS）
+    uint32_t revalidations;      // 后台校验次数
+    uint32_t not_modified;       // 条件校验：服务端确认版本未变（未下行音频）
+    uint32_t reval_bytes;        // 后台校验累计下行的音频字节
+    uint32_t updates;            // 校验发现新版本并写回
+    uint32_t evictions;
+    uint32_t used_bytes;
+    uint32_t entries;
+} app_event_cache_stats_t;
+
+app_event_cache_cfg_t app_event_cache_cfg_default(void);
+
+/**
+ * @brief 挂载 storage 分区并加载缓存索引（单例）
+ */
+esp_err_t app_event_cache_init(const app_event_cache_cfg_t *cfg);
+
+/**
+ * @brief 带缓存的事件请求：与 app_rb3_http_event_stream() 同签名
+ *
+ * - 命中（event + af）：立即从 flash 回放已解码音频和 meta（anim/motion/text），
+ *   然后在后台发条件请求（if_version = 缓存的 version），版本未变时服务端不下行音频；
+ *   version 变化则更新缓存。无 version 的条目按 unversioned_reval_s 限频整条重下、比较校验和。
+ * - 未命中（含缓存文件损坏/丢失）：走网络，边回调边收集，成功后写入缓存。
+ * - 回放时边读边核对校验和；截断或校验和不符的条目删除（不校验），还没播出声音时按未命中处理，
+ *   已播出一部分则返回 ESP_ERR_INVALID_CRC（不从头重放）。
+ * - 写缓存先写临时文件（不持锁），只在改名和更新索引时持锁，不阻塞命中查找。
+ *
+ * @note cfg 里的字符串指针会被后台校验任务使用，需保证生命周期（通常为常量）。
+ */
+esp_err_t app_event_cache_event_stream(const app_rb3_cfg_t *cfg,
+                                       const char *event_name,
+                                       const char *req_id,
+                                       const char *user_id,
+                                       app_rb3_meta_t *out_meta, // 可为 NULL
+                                       app_rb3_on_audio_cb on_audio,
+                                       void *cb_ctx);
+
+/**
+ * @brief 设置共用的 WS 会话（NULL 取消）：设置后事件请求与后台校验都走该长连接，断开时回退 HTTP
+ *
+ * @note 关闭会话前必须先传 NULL：本函数会打断进行中的 WS 请求并等待它们退出后才返回。
+ */
+void app_event_cache_set_ws_session(app_rb3_ws_sess_t *sess);
+
+void app_event_cache_get_stats(app_event_cache_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,194 @@
+#include "App_Kws.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+
+static const char *TAG = "App_Kws";
+
+#define KWS_HOP_MS 10
+
+app_kws_cfg_t app_kws_cfg_default(int sample_rate)
+{
+    app_kws_cfg_t c = {
+        .sample_rate = sample_rate,
+        .engine = &app_kws_engine_dscnn,
+        .model = NULL,
+        .model_len = 0,
+        .infer_ms = 40,
+        .smooth_ms = 0,
+        .threshold_q15 = 0,
+        .refractory_ms = 1500,
+    };
+    return c;
+}
+
+esp_err_t app_kws_init(app_kws_t *k, const app_kws_cfg_t *cfg)
+{
+    ESP_RETURN_ON_FALSE(k && cfg && cfg->sample_rate > 0 && cfg->model && cfg->model_len > 0, ESP_ERR_INVALID_ARG,
+                        TAG, "bad args");
+    memset(k, 0, sizeof(*k));
+    app_kws_cfg_t def = app_kws_cfg_default(cfg->sample_rate);
+    k->cfg = *cfg;
+    if (!k->cfg.engine) k->cfg.engine = def.engine;
+    if (k->cfg.infer_ms < KWS_HOP_MS) k->cfg.infer_ms = def.infer_ms;
+    if (k->cfg.refractory_ms <= 0) k->cfg.refractory_ms = def.refractory_ms;
+
+    const app_kws_engine_t *eng = k->cfg.engine;
+    ESP_RETURN_ON_ERROR(eng->load(k->cfg.model, k->cfg.model_len, &k->inst, &k->info), TAG, "%s: load model failed",
+                        eng->name);
+    const app_kws_model_info_t *mi = &k->info;
+    esp_err_t ret = ESP_OK;
+    if (mi->in_t <= 0 || mi->in_t > APP_KWS_MAX_T || mi->in_f <= 0 || mi->in_f > APP_KWS_MAX_F ||
+        mi->n_classes <= 1 || mi->n_classes > APP_KWS_MAX_CLASSES || mi->wake_class < 0 ||
+        mi->wake_class >= mi->n_classes ||
+        (mi->feat == APP_KWS_FEAT_MFCC ? mi->in_f > APP_SPEC_CEPS_MAX : mi->in_f != mi->n_mel)) {
+        ESP_LOGE(TAG, "model shape not supported: %dx%d feat=%d mel=%d classes=%d", mi->in_t, mi->in_f, mi->feat,
+                 mi->n_mel, mi->n_classes);
+        ret = ESP_ERR_NOT_SUPPORTED;
+    }
+
+    // 512 点窗：24k 约 21ms、16k 为 32ms；8k 用 256 点
+    k->n_fft = (k->cfg.sample_rate > 12000) ? 512 : 256;
+    k->hop = k->cfg.sample_rate * KWS_HOP_MS / 1000;
+    if (ret == ESP_OK) {
+        app_spec_pipe_cfg_t pc = app_spec_pipe_cfg_default(k->cfg.sample_rate);
+        pc.n_fft = k->n_fft;
+        pc.n_mel = mi->n_mel;
+        pc.n_ceps = (mi->feat == APP_KWS_FEAT_MFCC) ? mi->in_f : 0;
+        if (mi->fmin_hz > 0) pc.fmin_hz = mi->fmin_hz;
+        if (mi->fmax_hz > 0 && mi->fmax_hz < pc.fmax_hz) pc.fmax_hz = mi->fmax_hz;
+        ret = app_spec_pipe_init(&k->pipe, &pc);
+    }
+    if (ret == ESP_OK) {
+        k->win = (int16_t *)calloc((size_t)k->n_fft, sizeof(int16_t));
+        k->feat = (int8_t *)calloc((size_t)(mi->in_t * mi->in_f), 1);
+        if (!k->win || !k->feat) ret = ESP_ERR_NO_MEM;
+    }
+    if (ret != ESP_OK) {
+        app_kws_deinit(k);
+        return ret;
+    }
+
+    if (k->cfg.smooth_ms <= 0) k->cfg.smooth_ms = (mi->smooth_ms > 0) ? mi->smooth_ms : 200;
+    if (k->cfg.threshold_q15 <= 0) k->cfg.threshold_q15 = (mi->threshold_q15 > 0) ? mi->threshold_q15 : 19661;
+    k->infer_hops = k->cfg.infer_ms / KWS_HOP_MS;
+    k->n_smooth = k->cfg.smooth_ms / k->cfg.infer_ms;
+    if (k->n_smooth < 1) k->n_smooth = 1;
+    if (k->n_smooth > APP_KWS_SMOOTH_MAX) k->n_smooth = APP_KWS_SMOOTH_MAX;
+    ESP_LOGI(TAG, "%s: %dx%d %s, %d classes (wake=%d), infer every %d ms, smooth %d, th %.2f", eng->name, mi->in_t,
+             mi->in_f, mi->feat == APP_KWS_FEAT_MFCC ? "mfcc" : "logmel", mi->n_classes, mi->wake_class,
+             k->cfg.infer_ms, k->n_smooth, k->cfg.threshold_q15 / 32768.0);
+    return ESP_OK;
+}
+
+void app_kws_deinit(app_kws_t *k)
+{
+    if (!k) return;
+    if (k->inst && k->cfg.engine) k->cfg.engine->unload(k->inst);
+    k->inst = NULL;
+    app_spec_pipe_deinit(&k->pipe);
+    free(k->win);
+    free(k->feat);
+    k->win = NULL;
+    k->feat = NULL;
+}
+
+void app_kws_reset(app_kws_t *k)
+{
+    if (!k || !k->feat) return;
+    k->valid = 0;
+    k->hop_cnt = 0;
+    k->smooth_fill = 0;
+    k->smooth_pos = 0;
+    k->st.score = 0;
+}
+
+// 一跳：提特征、入窗；到推理间隔则跑引擎并做平滑判决。返回是否触发
+static bool kws_hop(app_kws_t *k)
+{
+    const app_kws_model_info_t *mi = &k->info;
+    app_kws_stats_t *st = &k->st;
+
+    uint32_t c0 = esp_cpu_get_cycle_count();
+    app_spec_feat_t f;
+    app_spec_pipe_run(&k->pipe, k->win, &f);
+    const int row = (mi->in_t - 1) * mi->in_f;
+    memmove(k->feat, k->feat + mi->in_f, (size_t)row);
+    for (int i = 0; i < mi->in_f; ++i) {
+        const int32_t v = (mi->feat == APP_KWS_FEAT_MFCC) ? f.mfcc[i] : f.logmel[i];
+        k->feat[row + i] = app_kws_requant(v - mi->in_offset, mi->in_mult, mi->in_shift);
+    }
+    if (k->valid < mi->in_t) k->valid++;
+    if (k->refractory > 0) k->refractory--;
+    st->hops++;
+    uint32_t cyc = esp_cpu_get_cycle_count() - c0;
+    st->feat_cycles_avg = st->feat_cycles_avg ? (st->feat_cycles_avg * 15 + cyc) / 16 : cyc;
+
+    if (k->valid < mi->in_t || ++k->hop_cnt < k->infer_hops) return false;
+    k->hop_cnt = 0;
+
+    c0 = esp_cpu_get_cycle_count();
+    float prob[APP_KWS_MAX_CLASSES];
+    k->cfg.engine->run(k->inst, k->feat, prob);
+    cyc = esp_cpu_get_cycle_count() - c0;
+    st->inferences++;
+    st->infer_cycles_avg = st->infer_cycles_avg ? (st->infer_cycles_avg * 7 + cyc) / 8 : cyc;
+    if (cyc > st->infer_cycles_max) st->infer_cycles_max = cyc;
+    // 每秒 100 跳特征 + 1000/infer_ms 次推理
+    const float per_s = (float)st->feat_cycles_avg * (1000.0f / KWS_HOP_MS) +
+                        (float)st->infer_cycles_avg * (1000.0f / (float)k->cfg.infer_ms);
+    st->load_pct = per_s / (CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 10000.0f);
+
+    // 唤醒类概率的滑动平均
+    k->smooth[k->smooth_pos] = prob[mi->wake_class];
+    k->smooth_pos = (k->smooth_pos + 1) % k->n_smooth;
+    if (k->smooth_fill < k->n_smooth) k->smooth_fill++;
+    float s = 0;
+    for (int i = 0; i < k->smooth_fill; ++i) s += k->smooth[i];
+    s /= (float)k->n_smooth;
+    st->score = s;
+    if (s > st->score_max) st->score_max = s;
+
+    if (k->refractory > 0 || s * 32768.0f < (float)k->cfg.threshold_q15) return false;
+    st->detections++;
+    ESP_LOGI(TAG, "wake: score %.2f (th %.2f), %u inferences", (double)s, k->cfg.threshold_q15 / 32768.0,
+             (unsigned)st->inferences);
+    st->score_max = 0;
+    k->refractory = k->cfg.refractory_ms / KWS_HOP_MS;
+    k->smooth_fill = 0;
+    k->smooth_pos = 0;
+    return true;
+}
+
+bool app_kws_feed(app_kws_t *k, const int16_t *x, int n, int *out_at)
+{
+    bool hit = false;
+    const int keep = k->n_fft - k->hop;
+    int off = 0;
+    while (off < n) {
+        int m = k->hop - k->fill;
+        if (m > n - off) m = n - off;
+        memcpy(k->win + keep + k->fill, x + off, (size_t)m * sizeof(int16_t));
+        k->fill += m;
+        off += m;
+        if (k->fill < k->hop) break;
+
+        if (kws_hop(k) && !hit) {
+            hit = true;
+            if (out_at) *out_at = off;
+        }
+        memmove(k->win, k->win + k->hop, (size_t)keep * sizeof(int16_t));
+        k->fill = 0;
+    }
+    return hit;
+}
+
+void app_kws_get_stats(const app_kws_t *k, app_kws_stats_t *out)
+{
+    if (!k || !out) return;
+    *out = k->st;
+}
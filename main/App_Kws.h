@@ -0,0 +1,145 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "App_Spec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 唤醒词检测前端：10ms 跳步的 MFCC / log-mel 特征 -> 可替换的分类引擎 -> 后验平滑 + 门限 + 不应期。
+ *
+ *   mic s16 ──512 点窗、10ms 跳──> app_spec_pipe ──量化 int8──> 特征窗 in_t × in_f
+ *       ──每 infer_ms 一次──> engine->run() ──唤醒类概率──> smooth_ms 滑动平均 >= threshold ──> 唤醒
+ *
+ * 引擎按 app_kws_engine_t 注册，模型 blob 一般来自资源包 APP_ASSET_ID_KWS_MODEL（model 分区，
+ * flash 映射只读）；特征类型、窗长、量化参数都由模型头给出。内置引擎：app_kws_engine_dscnn。
+ */
+
+#define APP_KWS_MAX_CLASSES 12
+#define APP_KWS_MAX_T 100
+#define APP_KWS_MAX_F 40
+#define APP_KWS_SMOOTH_MAX 16
+
+typedef enum {
+    APP_KWS_FEAT_MFCC = 0,
+    APP_KWS_FEAT_LOGMEL = 1,
+} app_kws_feat_t;
+
+// 模型声明的输入格式与默认检测参数（引擎 load 时填写）
+typedef struct {
+    int in_t;                   // 特征帧数（10ms 一帧）
+    int in_f;                   // 每帧特征维数
+    app_kws_feat_t feat;
+    int n_mel;
+    int n_classes;
+    int wake_class;
+    // 量化：q = sat8(((v - in_offset) * in_mult) >> (31 + in_shift))，v 为 Q8 特征
+    int32_t in_offset;
+    int32_t in_mult;
+    int in_shift;
+    int fmin_hz;                // mel 频带
+    int fmax_hz;
+    int smooth_ms;
+    int threshold_q15;
+} app_kws_model_info_t;
+
+/**
+ * @brief int8 定点重量化：sat8(round(acc * mult / 2^(31 + shift)))，mult 为 Q31，shift 可为负
+ */
+static inline int8_t app_kws_requant(int32_t acc, int32_t mult, int shift)
+{
+    const int total = 31 + shift;
+    const int64_t p = (int64_t)acc * mult;
+    int64_t r = (total > 0) ? ((p + ((int64_t)1 << (total - 1))) >> total) : p;
+    if (r > 127) r = 127;
+    if (r < -128) r = -128;
+    return (int8_t)r;
+}
+
+typedef struct app_kws_engine {
+    const char *name;
+    esp_err_t (*load)(const void *model, size_t len, void **inst, app_kws_model_info_t *info);
+    /**
+     * @brief 一次推理：in 为 in_t × in_f 的 int8 特征（时间优先），prob 输出各类概率
+     */
+    void (*run)(void *inst, const int8_t *in, float *prob);
+    void (*unload)(void *inst);
+} app_kws_engine_t;
+
+// 内置：int8 DS-CNN（格式见 App_KwsDscnn.c / tools/mkkwsmodel.py）
+extern const app_kws_engine_t app_kws_engine_dscnn;
+
+typedef struct {
+    int sample_rate;            // 必填
+    const app_kws_engine_t *engine; // 默认 &app_kws_engine_dscnn
+    const void *model;          // 必填：模型 blob（可直接指向 flash 映射区）
+    size_t model_len;
+    int infer_ms;               // 推理间隔，默认 40（10ms 的整数倍）
+    int smooth_ms;              // 后验平滑窗，<=0 用模型给的值（再无则 200）
+    int threshold_q15;          // 唤醒门限，<=0 用模型给的值（再无则 0.6）
+    int refractory_ms;          // 触发后的不应期，默认 1500
+} app_kws_cfg_t;
+
+typedef struct {
+    uint32_t hops;              // 已处理的特征帧
+    uint32_t inferences;
+    uint32_t detections;
+    float score;                // 最近一次平滑后的唤醒概率
+    float score_max;            // 自上次触发以来的最大值（调门限用）
+    uint32_t feat_cycles_avg;   // 每跳特征提取周期
+    uint32_t infer_cycles_avg;  // 每次推理周期
+    uint32_t infer_cycles_max;
+    float load_pct;             // 折算单核占用：(特征 + 推理) 周期 / 对应音频时长
+} app_kws_stats_t;
+
+typedef struct {
+    app_kws_cfg_t cfg;
+    app_kws_model_info_t info;
+    void *inst;
+    app_spec_pipe_t pipe;
+    int n_fft;
+    int hop;
+    int16_t *win;               // n_fft 个样本的滑动窗
+    int fill;                   // 当前跳已填的样本数
+    int8_t *feat;               // in_t × in_f
+    int valid;                  // 已填的特征帧数（不足 in_t 不推理）
+    int hop_cnt;
+    int infer_hops;
+    float smooth[APP_KWS_SMOOTH_MAX];
+    int n_smooth;
+    int smooth_pos;
+    int smooth_fill;
+    int refractory;             // 剩余不应期（跳）
+    app_kws_stats_t st;
+} app_kws_t;
+
+app_kws_cfg_t app_kws_cfg_default(int sample_rate);
+
+esp_err_t app_kws_init(app_kws_t *k, const app_kws_cfg_t *cfg);
+void app_kws_deinit(app_kws_t *k);
+
+/**
+ * @brief 送入 n 个单声道 s16 样本
+ *
+ * @param out_at 可为 NULL；触发时写入触发点在本次 x 中的样本下标
+ * @return 本次是否触发
+ */
+bool app_kws_feed(app_kws_t *k, const int16_t *x, int n, int *out_at);
+
+/**
+ * @brief 清空特征窗与平滑状态（例如播放结束、回到等待期时）
+ */
+void app_kws_reset(app_kws_t *k);
+
+void app_kws_get_stats(const app_kws_t *k, app_kws_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
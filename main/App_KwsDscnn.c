@@ -0,0 +1,340 @@
+#include "App_Kws.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char *TAG = "App_KwsDscnn";
+
+/*
+ * int8 DS-CNN 模型 blob（小端，由 tools/mkkwsmodel.py 生成）：
+ *
+ *   header(48B) | layer(16B 头 + int8 权重（补齐到 4B）+ int32 偏置) × n_layers
+ *
+ * 张量按 HWC 存放，输入为 in_t × in_f × 1。层类型：
+ *   CONV  权重 [oc][kh][kw][ic]（1x1 即 pointwise）
+ *   DW    权重 [kh][kw][c]（深度可分离，out_ch = in_ch）
+ *   POOL  全局平均池化，无权重
+ *   FC    权重 [oc][in]
+ * 量化均为对称 int8（零点 0），偏置为 int32（尺度 s_in * s_w），
+ * 输出 y = sat8(acc * mult / 2^(31 + shift))，relu 时再截到 >= 0。
+ */
+
+#define DSCNN_MAGIC 0x3153574Bu // "KWS1"
+#define DSCNN_VERSION 1
+#define DSCNN_HDR_SIZE 48
+#define DSCNN_LAYER_HDR_SIZE 16
+#define DSCNN_MAX_LAYERS 16
+#define DSCNN_MAX_CH 256
+
+typedef enum {
+    DSCNN_CONV = 1,
+    DSCNN_DW = 2,
+    DSCNN_POOL = 3,
+    DSCNN_FC = 4,
+} dscnn_type_t;
+
+typedef struct {
+    dscnn_type_t type;
+    bool relu;
+    int kh, kw, sh, sw;
+    int pt, pl;                 // 上/左补零
+    int32_t mult;
+    int shift;
+    int ih, iw, ic;
+    int oh, ow, oc;
+    const int8_t *w;
+    const int32_t *b;
+} dscnn_layer_t;
+
+typedef struct {
+    int n_layers;
+    dscnn_layer_t l[DSCNN_MAX_LAYERS];
+    float logit_scale;
+    int n_classes;
+    int8_t *buf[2];             // 乒乓激活缓冲
+    int32_t *acc;               // DW 逐通道累加
+} dscnn_t;
+
+static inline uint16_t rd16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t rd32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int conv_out(int in, int k, int s, bool same, int *pad)
+{
+    if (same) {
+        const int o = (in + s - 1) / s;
+        const int need = (o - 1) * s + k - in;
+        *pad = (need > 0) ? need / 2 : 0;
+        return o;
+    }
+    *pad = 0;
+    return (in >= k) ? (in - k) / s + 1 : 0;
+}
+
+static void dscnn_unload(void *inst)
+{
+    dscnn_t *m = (dscnn_t *)inst;
+    if (!m) return;
+    heap_caps_free(m->buf[0]);
+    heap_caps_free(m->acc);
+    free(m);
+}
+
+static esp_err_t dscnn_load(const void *model, size_t len, void **inst, app_kws_model_info_t *info)
+{
+    const uint8_t *p = (const uint8_t *)model;
+    ESP_RETURN_ON_FALSE(p && len >= DSCNN_HDR_SIZE && inst && info, ESP_ERR_INVALID_ARG, TAG, "bad args");
+    ESP_RETURN_ON_FALSE(rd32(p) == DSCNN_MAGIC && rd16(p + 4) == DSCNN_VERSION, ESP_ERR_INVALID_VERSION, TAG,
+                        "bad magic/version");
+    ESP_RETURN_ON_FALSE(((uintptr_t)p & 3) == 0, ESP_ERR_INVALID_ARG, TAG, "model not 4-byte aligned");
+    const int n_layers = rd16(p + 6);
+    ESP_RETURN_ON_FALSE(n_layers > 0 && n_layers <= DSCNN_MAX_LAYERS, ESP_ERR_INVALID_SIZE, TAG, "%d layers",
+                        n_layers);
+    ESP_RETURN_ON_FALSE(rd32(p + 40) == len, ESP_ERR_INVALID_SIZE, TAG, "blob length %u != %u", (unsigned)len,
+                        (unsigned)rd32(p + 40));
+
+    memset(info, 0, sizeof(*info));
+    info->in_t = rd16(p + 8);
+    info->in_f = rd16(p + 10);
+    info->feat = (app_kws_feat_t)p[12];
+    info->n_mel = p[13];
+    info->n_classes = p[14];
+    info->wake_class = p[15];
+    info->in_offset = (int32_t)rd32(p + 16);
+    info->in_mult = (int32_t)rd32(p + 20);
+    info->in_shift = (int8_t)p[24];
+    info->fmin_hz = rd16(p + 28);
+    info->fmax_hz = rd16(p + 30);
+    info->smooth_ms = rd16(p + 32);
+    info->threshold_q15 = rd16(p + 34);
+
+    dscnn_t *m = (dscnn_t *)calloc(1, sizeof(dscnn_t));
+    ESP_RETURN_ON_FALSE(m, ESP_ERR_NO_MEM, TAG, "alloc model failed");
+    m->n_layers = n_layers;
+    m->n_classes = info->n_classes;
+    m->logit_scale = (float)rd32(p + 36) / 16777216.0f;
+
+    // 逐层解析并推算形状，越界即判坏模型
+    size_t off = DSCNN_HDR_SIZE;
+    int h = info->in_t, w = info->in_f, c = 1;
+    size_t max_act = (size_t)h * w;
+    int max_ch = 1;
+    esp_err_t ret = ESP_OK;
+    for (int i = 0; i < n_layers && ret == ESP_OK; ++i) {
+        if (off + DSCNN_LAYER_HDR_SIZE > len) {
+            ret = ESP_ERR_INVALID_SIZE;
+            break;
+        }
+        const uint8_t *q = p + off;
+        dscnn_layer_t *L = &m->l[i];
+        L->type = (dscnn_type_t)q[0];
+        L->relu = q[1] != 0;
+        L->kh = q[2];
+        L->kw = q[3];
+        L->sh = q[4] ? q[4] : 1;
+        L->sw = q[5] ? q[5] : 1;
+        const bool same = q[6] != 0;
+        L->shift = (int8_t)q[7];
+        L->oc = rd16(q + 8);
+        L->mult = (int32_t)rd32(q + 12);
+        L->ih = h;
+        L->iw = w;
+        L->ic = c;
+        off += DSCNN_LAYER_HDR_SIZE;
+
+        size_t nw = 0;
+        switch (L->type) {
+        case DSCNN_CONV:
+            L->oh = conv_out(h, L->kh, L->sh, same, &L->pt);
+            L->ow = conv_out(w, L->kw, L->sw, same, &L->pl);
+            nw = (size_t)L->oc * L->kh * L->kw * c;
+            break;
+        case DSCNN_DW:
+            L->oc = c;
+            L->oh = conv_out(h, L->kh, L->sh, same, &L->pt);
+            L->ow = conv_out(w, L->kw, L->sw, same, &L->pl);
+            nw = (size_t)L->kh * L->kw * c;
+            break;
+        case DSCNN_POOL:
+            L->oc = c;
+            L->oh = L->ow = 1;
+            break;
+        case DSCNN_FC:
+            L->oh = L->ow = 1;
+            nw = (size_t)L->oc * h * w * c;
+            break;
+        default:
+            ret = ESP_ERR_NOT_SUPPORTED;
+            break;
+        }
+        if (ret != ESP_OK) break;
+        if (L->oh <= 0 || L->ow <= 0 || L->oc <= 0 || L->oc > DSCNN_MAX_CH) {
+            ret = ESP_ERR_INVALID_SIZE;
+            break;
+        }
+        if (nw > 0) {
+            const size_t nb = (size_t)L->oc * sizeof(int32_t);
+            const size_t wpad = (nw + 3) & ~(size_t)3;
+            if (off + wpad + nb > len) {
+                ret = ESP_ERR_INVALID_SIZE;
+                break;
+            }
+            L->w = (const int8_t *)(p + off);
+            L->b = (const int32_t *)(p + off + wpad);
+            off += wpad + nb;
+        }
+        h = L->oh;
+        w = L->ow;
+        c = L->oc;
+        if ((size_t)h * w * c > max_act) max_act = (size_t)h * w * c;
+        if (c > max_ch) max_ch = c;
+    }
+    if (ret == ESP_OK && (off != len || h * w * c != info->n_classes)) ret = ESP_ERR_INVALID_SIZE;
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "bad model at offset %u: %s", (unsigned)off, esp_err_to_name(ret));
+        dscnn_unload(m);
+        return ret;
+    }
+
+    // 激活放内部 RAM：每次推理要反复扫
+    m->buf[0] = (int8_t *)heap_caps_malloc(max_act * 2, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    m->acc = (int32_t *)heap_caps_malloc((size_t)max_ch * sizeof(int32_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!m->buf[0] || !m->acc) {
+        dscnn_unload(m);
+        ESP_LOGE(TAG, "alloc %u bytes activations failed", (unsigned)(max_act * 2));
+        return ESP_ERR_NO_MEM;
+    }
+    m->buf[1] = m->buf[0] + max_act;
+    *inst = m;
+    ESP_LOGI(TAG, "dscnn: %d layers, %u bytes model, %u bytes activations", n_layers, (unsigned)len,
+             (unsigned)(max_act * 2));
+    return ESP_OK;
+}
+
+static inline int8_t act(const dscnn_layer_t *L, int32_t acc)
+{
+    const int8_t v = app_kws_requant(acc, L->mult, L->shift);
+    return (L->relu && v < 0) ? 0 : v;
+}
+
+static void run_conv(const dscnn_layer_t *L, const int8_t *in, int8_t *out)
+{
+    const int ic = L->ic;
+    for (int oy = 0; oy < L->oh; ++oy) {
+        for (int ox = 0; ox < L->ow; ++ox) {
+            int8_t *o = out + (oy * L->ow + ox) * L->oc;
+            for (int oc = 0; oc < L->oc; ++oc) {
+                int32_t acc = L->b[oc];
+                const int8_t *wk = L->w + (size_t)oc * L->kh * L->kw * ic;
+                for (int ky = 0; ky < L->kh; ++ky) {
+                    const int iy = oy * L->sh + ky - L->pt;
+                    if (iy < 0 || iy >= L->ih) continue;
+                    for (int kx = 0; kx < L->kw; ++kx) {
+                        const int ix = ox * L->sw + kx - L->pl;
+                        if (ix < 0 || ix >= L->iw) continue;
+                        const int8_t *a = in + (iy * L->iw + ix) * ic;
+                        const int8_t *b = wk + (ky * L->kw + kx) * ic;
+                        for (int i = 0; i < ic; ++i) acc += a[i] * b[i];
+                    }
+                }
+                o[oc] = act(L, acc);
+            }
+        }
+    }
+}
+
+static void run_dw(const dscnn_layer_t *L, const int8_t *in, int8_t *out, int32_t *acc)
+{
+    const int c = L->ic;
+    for (int oy = 0; oy < L->oh; ++oy) {
+        for (int ox = 0; ox < L->ow; ++ox) {
+            memcpy(acc, L->b, (size_t)c * sizeof(int32_t));
+            for (int ky = 0; ky < L->kh; ++ky) {
+                const int iy = oy * L->sh + ky - L->pt;
+                if (iy < 0 || iy >= L->ih) continue;
+                for (int kx = 0; kx < L->kw; ++kx) {
+                    const int ix = ox * L->sw + kx - L->pl;
+                    if (ix < 0 || ix >= L->iw) continue;
+                    const int8_t *a = in + (iy * L->iw + ix) * c;
+                    const int8_t *b = L->w + (ky * L->kw + kx) * c;
+                    for (int i = 0; i < c; ++i) acc[i] += a[i] * b[i];
+                }
+            }
+            int8_t *o = out + (oy * L->ow + ox) * c;
+            for (int i = 0; i < c; ++i) o[i] = act(L, acc[i]);
+        }
+    }
+}
+
+static void run_pool(const dscnn_layer_t *L, const int8_t *in, int8_t *out, int32_t *acc)
+{
+    const int c = L->ic, n = L->ih * L->iw;
+    memset(acc, 0, (size_t)c * sizeof(int32_t));
+    for (int p = 0; p < n; ++p) {
+        for (int i = 0; i < c; ++i) acc[i] += in[p * c + i];
+    }
+    for (int i = 0; i < c; ++i) {
+        const int32_t s = acc[i];
+        out[i] = (int8_t)((s >= 0) ? (s + n / 2) / n : -((-s + n / 2) / n));
+    }
+}
+
+static void run_fc(const dscnn_layer_t *L, const int8_t *in, int8_t *out)
+{
+    const int n = L->ih * L->iw * L->ic;
+    for (int oc = 0; oc < L->oc; ++oc) {
+        const int8_t *b = L->w + (size_t)oc * n;
+        int32_t acc = L->b[oc];
+        for (int i = 0; i < n; ++i) acc += in[i] * b[i];
+        out[oc] = act(L, acc);
+    }
+}
+
+static void dscnn_run(void *inst, const int8_t *in, float *prob)
+{
+    dscnn_t *m = (dscnn_t *)inst;
+    const int8_t *x = in;
+    int cur = 0;
+    for (int i = 0; i < m->n_layers; ++i) {
+        const dscnn_layer_t *L = &m->l[i];
+        int8_t *y = m->buf[cur];
+        switch (L->type) {
+        case DSCNN_CONV: run_conv(L, x, y); break;
+        case DSCNN_DW: run_dw(L, x, y, m->acc); break;
+        case DSCNN_POOL: run_pool(L, x, y, m->acc); break;
+        case DSCNN_FC: run_fc(L, x, y); break;
+        }
+        x = y;
+        cur ^= 1;
+    }
+
+    // softmax
+    int8_t mx = x[0];
+    for (int i = 1; i < m->n_classes; ++i) {
+        if (x[i] > mx) mx = x[i];
+    }
+    float sum = 0;
+    for (int i = 0; i < m->n_classes; ++i) {
+        prob[i] = expf(m->logit_scale * (float)(x[i] - mx));
+        sum += prob[i];
+    }
+    for (int i = 0; i < m->n_classes; ++i) prob[i] /= sum;
+}
+
+const app_kws_engine_t app_kws_engine_dscnn = {
+    .name = "dscnn",
+    .load = dscnn_load,
+    .run = dscnn_run,
+    .unload = dscnn_unload,
+};
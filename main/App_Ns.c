@@ -0,0 +1,230 @@
+#include "App_Ns.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+
+static const char *TAG = "App_Ns";
+
+#define NS_PSD_ALPHA 0.7f       // 功率谱平滑（噪声跟踪用）
+#define NS_DD_ALPHA 0.98f       // 判决引导系数
+#define NS_NOISE_BIAS 1.5f      // 最小值跟踪相对噪声均值偏低，补偿约 1.8 dB
+#define NS_NOISE_MIN 1.0f       // 防止数字静音时除零
+
+static inline int16_t sat16(int32_t v)
+{
+    return (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+}
+
+// v * 2^sh，右移舍入、左移饱和
+static inline int32_t shift_sat(int32_t v, int sh)
+{
+    if (sh < 0) return (v + (1 << (-sh - 1))) >> -sh;
+    return sat16(v << (sh > 15 ? 15 : sh));
+}
+
+app_ns_cfg_t app_ns_cfg_default(int sample_rate)
+{
+    app_ns_cfg_t c = {
+        .sample_rate = sample_rate,
+        .frame_ms = 20,
+        .max_atten_db = 12,
+        .noise_up_db_per_s = 5,
+        .budget_us = 1000,
+    };
+    return c;
+}
+
+esp_err_t app_ns_init(app_ns_t *ns, const app_ns_cfg_t *cfg)
+{
+    ESP_RETURN_ON_FALSE(ns && cfg && cfg->sample_rate > 0, ESP_ERR_INVALID_ARG, TAG, "bad args");
+    memset(ns, 0, sizeof(*ns));
+
+    app_ns_cfg_t def = app_ns_cfg_default(cfg->sample_rate);
+    ns->cfg = *cfg;
+    if (ns->cfg.frame_ms <= 0) ns->cfg.frame_ms = def.frame_ms;
+    if (ns->cfg.max_atten_db <= 0) ns->cfg.max_atten_db = def.max_atten_db;
+    if (ns->cfg.noise_up_db_per_s <= 0) ns->cfg.noise_up_db_per_s = def.noise_up_db_per_s;
+    if (ns->cfg.budget_us <= 0) ns->cfg.budget_us = def.budget_us;
+
+    // 窗长取偶数，跳步为半窗
+    const int wl = (ns->cfg.sample_rate * ns->cfg.frame_ms / 1000) & ~1;
+    ESP_RETURN_ON_FALSE(wl >= 64 && wl <= APP_SPEC_FFT_MAX, ESP_ERR_INVALID_ARG, TAG,
+                        "window %d samples out of range", wl);
+    const int n_fft = (wl <= 256) ? 256 : 512;
+    ESP_RETURN_ON_ERROR(app_spec_fft_init(&ns->fft, n_fft), TAG, "fft init failed");
+    ns->win_len = wl;
+    ns->hop = wl / 2;
+    ns->latency = wl;
+    ns->bins = n_fft / 2 + 1;
+
+    // int16: win | in | out | ola | buf | spec；float: psd | noise | prev
+    const size_t n16 = (size_t)wl * 2 + (size_t)ns->hop * 2 + (size_t)n_fft + (size_t)ns->bins * 2;
+    ns->win = (int16_t *)calloc(n16, sizeof(int16_t));
+    ns->psd = (float *)calloc((size_t)ns->bins * 3, sizeof(float));
+    if (!ns->win || !ns->psd) {
+        app_ns_deinit(ns);
+        ESP_LOGE(TAG, "alloc buffers failed");
+        return ESP_ERR_NO_MEM;
+    }
+    ns->in = ns->win + wl;
+    ns->out = ns->in + wl;
+    ns->ola = ns->out + ns->hop;
+    ns->buf = ns->ola + ns->hop;
+    ns->spec = ns->buf + n_fft;
+    ns->noise = ns->psd + ns->bins;
+    ns->prev = ns->noise + ns->bins;
+
+    // 周期 sqrt-Hann：分析 × 合成 = Hann，半窗重叠相加恒为 1
+    for (int i = 0; i < wl; ++i) {
+        ns->win[i] = (int16_t)lrint(32767.0 * sin(M_PI * i / wl));
+    }
+    ns->gmin = powf(10.0f, -(float)ns->cfg.max_atten_db / 20.0f);
+    ns->noise_up = powf(10.0f, (float)ns->cfg.noise_up_db_per_s * (float)ns->hop /
+                                   (10.0f * (float)ns->cfg.sample_rate));
+    ESP_LOGI(TAG, "ns: window %d / hop %d samples, fft %d, max atten %d dB", wl, ns->hop, n_fft,
+             ns->cfg.max_atten_db);
+    return ESP_OK;
+}
+
+void app_ns_deinit(app_ns_t *ns)
+{
+    if (!ns) return;
+    app_spec_fft_deinit(&ns->fft);
+    free(ns->win);
+    free(ns->psd);
+    ns->win = ns->in = ns->out = ns->ola = ns->buf = ns->spec = NULL;
+    ns->psd = ns->noise = ns->prev = NULL;
+}
+
+void app_ns_set_bypass(app_ns_t *ns, bool bypass)
+{
+    if (!ns) return;
+    ns->bypass = bypass;
+}
+
+// 旁路：输出上一跳原样本；重叠尾部按增益 1 的结果续上，恢复处理时无跳变
+static void ns_hop_bypass(app_ns_t *ns)
+{
+    const int h = ns->hop;
+    memcpy(ns->out, ns->in, (size_t)h * sizeof(int16_t));
+    for (int i = 0; i < h; ++i) {
+        const int32_t w = ns->win[h + i];
+        const int32_t w2 = (w * w + (1 << 14)) >> 15;
+        ns->ola[i] = (int16_t)((ns->in[h + i] * w2 + (1 << 14)) >> 15);
+    }
+    ns->st.bypassed++;
+}
+
+// 按当前跳的功率谱更新噪声估计并求增益，直接乘到 spec 上
+static void ns_apply_gain(app_ns_t *ns, int exp)
+{
+    const float scale = ldexpf(1.0f, 2 * exp);
+    const bool first = (ns->st.frames == ns->st.bypassed);
+    float p_in = 0, p_out = 0, p_noise = 0;
+
+    for (int k = 0; k < ns->bins; ++k) {
+        int16_t *c = ns->spec + 2 * k;
+        const int32_t re = c[0], im = c[1];
+        const float p = (float)((uint32_t)(re * re) + (uint32_t)(im * im)) * scale;
+
+        float s = first ? p : NS_PSD_ALPHA * ns->psd[k] + (1.0f - NS_PSD_ALPHA) * p;
+        ns->psd[k] = s;
+        float nk = ns->noise[k];
+        if (first || s < nk) {
+            nk = s;
+        } else {
+            nk *= ns->noise_up;
+        }
+        if (nk < NS_NOISE_MIN) nk = NS_NOISE_MIN;
+        ns->noise[k] = nk;
+
+        const float npow = nk * NS_NOISE_BIAS;
+        const float post = p / npow;
+        const float ml = (post > 1.0f) ? post - 1.0f : 0.0f;
+        const float xi = NS_DD_ALPHA * ns->prev[k] / npow + (1.0f - NS_DD_ALPHA) * ml;
+        float g = xi / (1.0f + xi);
+        if (g < ns->gmin) g = ns->gmin;
+        ns->prev[k] = g * g * p;
+
+        const int32_t gq = (int32_t)(g * 32767.0f);
+        c[0] = (int16_t)((re * gq + (1 << 14)) >> 15);
+        c[1] = (int16_t)((im * gq + (1 << 14)) >> 15);
+
+        p_in += p;
+        p_out += g * g * p;
+        p_noise += npow;
+    }
+    ns->st.atten_db = (p_out > 0) ? 10.0f * log10f(p_in / p_out) : 0.0f;
+    // 粗略折算 dBFS：满幅正弦加窗后的谱峰约 32767 * n/4
+    const float full = 32767.0f * (float)ns->fft.n / 4.0f;
+    ns->st.noise_dbfs = 10.0f * log10f(p_noise / (2.0f * full * full));
+}
+
+static void ns_hop(app_ns_t *ns)
+{
+    const int h = ns->hop, wl = ns->win_len, n = ns->fft.n;
+    const int16_t *w = ns->win;
+
+    for (int i = 0; i < wl; ++i) ns->buf[i] = (int16_t)((ns->in[i] * w[i] + (1 << 14)) >> 15);
+    memset(ns->buf + wl, 0, (size_t)(n - wl) * sizeof(int16_t));
+
+    const int e = app_spec_rfft(&ns->fft, ns->buf, ns->spec);
+    ns_apply_gain(ns, e);
+    const int sh = e + app_spec_irfft(&ns->fft, ns->spec, ns->buf);
+
+    // 回到样本幅度、合成加窗、重叠相加
+    for (int i = 0; i < wl; ++i) {
+        const int32_t v = (shift_sat(ns->buf[i], sh) * w[i] + (1 << 14)) >> 15;
+        if (i < h) {
+            ns->out[i] = sat16(ns->ola[i] + v);
+        } else {
+            ns->ola[i - h] = (int16_t)v;
+        }
+    }
+}
+
+void app_ns_process(app_ns_t *ns, int16_t *x, int n)
+{
+    const int h = ns->hop;
+    while (n > 0) {
+        int k = h - ns->pos;
+        if (k > n) k = n;
+        memcpy(ns->in + h + ns->pos, x, (size_t)k * sizeof(int16_t));
+        memcpy(x, ns->out + ns->pos, (size_t)k * sizeof(int16_t));
+        ns->pos += k;
+        x += k;
+        n -= k;
+        if (ns->pos < h) break;
+
+        const uint32_t c0 = esp_cpu_get_cycle_count();
+        if (ns->bypass) {
+            ns_hop_bypass(ns);
+        } else {
+            ns_hop(ns);
+        }
+        memmove(ns->in, ns->in + h, (size_t)h * sizeof(int16_t));
+        ns->pos = 0;
+
+        const uint32_t cyc = esp_cpu_get_cycle_count() - c0;
+        app_ns_stats_t *st = &ns->st;
+        st->frames++;
+        st->cycles_last = cyc;
+        st->cycles_avg = st->cycles_avg ? (st->cycles_avg * 7 + cyc) / 8 : cyc;
+        if (cyc > st->cycles_max) st->cycles_max = cyc;
+        // 预算按 20ms 音频折算到一跳
+        const uint64_t used_us_x = (uint64_t)cyc * (uint64_t)ns->cfg.sample_rate;
+        const uint64_t budget_us_x = (uint64_t)ns->cfg.budget_us * (uint64_t)h * 50u * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+        if (used_us_x > budget_us_x) st->over_budget++;
+    }
+}
+
+void app_ns_get_stats(const app_ns_t *ns, app_ns_stats_t *out)
+{
+    if (!ns || !out) return;
+    *out = ns->st;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "App_Spec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 单通道频域降噪：噪声谱估计 + 判决引导 Wiener 增益。
+ *
+ *   x ──sqrt-Hann 窗 (frame_ms)──> rfft ──增益──> irfft ──sqrt-Hann 窗──> 50% 重叠相加 ──> y
+ *
+ * 噪声谱：平滑功率谱的最小值跟踪（低于估计时立即跟随，否则按 noise_up_db_per_s 缓慢上升），
+ * 风扇 / 空调 / 电视底噪这类平稳噪声几秒内收敛，语音段不会被当成噪声吸进去。
+ * 增益：G = ξ / (1 + ξ)，ξ 为判决引导的先验信噪比，下限为 -max_atten_db，减轻音乐噪声。
+ *
+ * 原地处理、任意长度输入；固定延迟 latency 个样本（= 一个窗长）。
+ * 旁路时不做 FFT，只保持相同延迟，切换无跳变。
+ */
+
+typedef struct {
+    int sample_rate;            // 必填
+    int frame_ms;               // 分析窗长，默认 20；窗长须 <= APP_SPEC_FFT_MAX 个样本
+    int max_atten_db;           // 最大衰减，默认 12
+    int noise_up_db_per_s;      // 噪声估计上升速率，默认 5
+    int budget_us;              // 每 20ms 音频的 CPU 预算，默认 1000（约单核 5%）；超出只计数
+} app_ns_cfg_t;
+
+typedef struct {
+    uint32_t frames;            // 已处理的跳步数（每跳 frame_ms/2）
+    uint32_t bypassed;          // 其中旁路的跳步数
+    uint32_t over_budget;
+    float atten_db;             // 最近一跳的平均衰减（按功率加权）
+    float noise_dbfs;           // 最近一跳的噪声估计总功率
+    uint32_t cycles_last;       // 单跳 CPU 周期
+    uint32_t cycles_avg;
+    uint32_t cycles_max;
+} app_ns_stats_t;
+
+typedef struct {
+    app_ns_cfg_t cfg;
+    int win_len;
+    int hop;
+    int latency;                // 样本
+    int bins;
+    app_spec_fft_t fft;
+    int16_t *win;               // sqrt-Hann，Q15
+    int16_t *in;                // [上一跳 | 当前跳]
+    int16_t *out;               // 本跳输出
+    int16_t *ola;               // 重叠相加尾部
+    int16_t *buf;               // 加窗帧 / 逆变换输出
+    int16_t *spec;              // bins 个复数
+    float *psd;                 // 平滑功率谱
+    float *noise;               // 噪声功率谱
+    float *prev;                // 上一跳 G^2 * P（判决引导用）
+    float gmin;
+    float noise_up;             // 每跳的上升倍数
+    int pos;
+    volatile bool bypass;
+    app_ns_stats_t st;
+} app_ns_t;
+
+app_ns_cfg_t app_ns_cfg_default(int sample_rate);
+
+esp_err_t app_ns_init(app_ns_t *ns, const app_ns_cfg_t *cfg);
+void app_ns_deinit(app_ns_t *ns);
+
+/**
+ * @brief 原地降噪 n 个样本（输出比输入晚 latency 个样本）
+ */
+void app_ns_process(app_ns_t *ns, int16_t *x, int n);
+
+/**
+ * @brief 旁路开关（可在其他任务里调用）；旁路期间不更新噪声估计
+ */
+void app_ns_set_bypass(app_ns_t *ns, bool bypass);
+
+void app_ns_get_stats(const app_ns_t *ns, app_ns_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,579 @@
+#include "App_PcmOps.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__has_include)
+#if __has_include("sdkconfig.h")
+#include "sdkconfig.h"
+#endif
+#endif
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+#define PCM_DEFAULT_FAST 1
+#else
+#define PCM_DEFAULT_FAST 0
+#endif
+
+// ESP32-S3 PIE：q0..q7 为 128 位（8 x s16），ACCX 为 40 位累加器
+#if defined(CONFIG_IDF_TARGET_ESP32S3) && defined(__XTENSA__)
+#define PCM_HAVE_PIE 1
+#else
+#define PCM_HAVE_PIE 0
+#endif
+
+static inline int16_t sat16(int32_t v)
+{
+    return (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+}
+
+static inline int32_t clamp_gain(int32_t g)
+{
+    // |x * g| 须在 int32 内：|g| <= 65535（约 16 倍）
+    return g > 65535 ? 65535 : (g < -65535 ? -65535 : g);
+}
+
+// ---------- portable ----------
+
+static uint64_t sum_abs_c(const int16_t *x, int n)
+{
+    uint64_t s = 0;
+    for (int i = 0; i < n; ++i) {
+        int32_t v = x[i];
+        s += (uint32_t)(v < 0 ? -v : v);
+    }
+    return s;
+}
+
+static uint64_t sum_sq_c(const int16_t *x, int n)
+{
+    uint64_t s = 0;
+    for (int i = 0; i < n; ++i) s += (uint32_t)((int32_t)x[i] * x[i]);
+    return s;
+}
+
+static int32_t peak_c(const int16_t *x, int n)
+{
+    int32_t p = 0;
+    for (int i = 0; i < n; ++i) {
+        int32_t v = x[i];
+        if (v < 0) v = -v;
+        if (v > p) p = v;
+    }
+    return p;
+}
+
+static void gain_c(int16_t *dst, const int16_t *src, int n, int32_t g)
+{
+    g = clamp_gain(g);
+    for (int i = 0; i < n; ++i) dst[i] = sat16((src[i] * g + 2048) >> 12);
+}
+
+static void mix_c(int16_t *dst, const int16_t *src, int n, int32_t g)
+{
+    g = clamp_gain(g);
+    for (int i = 0; i < n; ++i) dst[i] = sat16(dst[i] + ((src[i] * g + 2048) >> 12));
+}
+
+// 系数按 Q30 累加，两份实现的增量序列相同
+static void fade_c(int16_t *x, int n, int32_t from, int32_t to)
+{
+    if (n <= 0) return;
+    int32_t g = from * 32768;
+    const int32_t d = (to - from) * 32768 / n;
+    for (int i = 0; i < n; ++i) {
+        x[i] = (int16_t)((x[i] * (g >> 15) + 16384) >> 15);
+        g += d;
+    }
+}
+
+// 混音 + 增益斜坡：dst = sat(dst + src * g_i)，g_i 与 fade 同一 Q30 序列
+static void mix_ramp_c(int16_t *dst, const int16_t *src, int n, int32_t from, int32_t to)
+{
+    if (n <= 0) return;
+    int32_t g = from * 32768;
+    const int32_t d = (to - from) * 32768 / n;
+    for (int i = 0; i < n; ++i) {
+        dst[i] = sat16(dst[i] + ((src[i] * (g >> 15) + 16384) >> 15));
+        g += d;
+    }
+}
+
+static void s32_to_s16_c(int16_t *dst, const int32_t *src, int n)
+{
+    for (int i = 0; i < n; ++i) dst[i] = (int16_t)(src[i] >> 16);
+}
+
+static void stereo_to_mono_c(int16_t *dst, const int16_t *src, int frames)
+{
+    for (int i = 0; i < frames; ++i) dst[i] = (int16_t)(((int32_t)src[2 * i] + src[2 * i + 1]) >> 1);
+}
+
+// ---------- fast：4 路展开 ----------
+
+static uint64_t sum_abs_fast(const int16_t *restrict x, int n)
+{
+    uint64_t s = 0;
+    int i = 0;
+    while (i + 4 <= n) {
+        // 每块最多 8192 样本，32bit 部分和不会溢出
+        const int end = (n - i > 8192) ? i + 8192 : n;
+        uint32_t a = 0, b = 0;
+        for (; i + 4 <= end; i += 4) {
+            const int32_t v0 = x[i], v1 = x[i + 1], v2 = x[i + 2], v3 = x[i + 3];
+            a += (uint32_t)(v0 < 0 ? -v0 : v0) + (uint32_t)(v1 < 0 ? -v1 : v1);
+            b += (uint32_t)(v2 < 0 ? -v2 : v2) + (uint32_t)(v3 < 0 ? -v3 : v3);
+        }
+        s += (uint64_t)a + b;
+    }
+    for (; i < n; ++i) {
+        int32_t v = x[i];
+        s += (uint32_t)(v < 0 ? -v : v);
+    }
+    return s;
+}
+
+static uint64_t sum_sq_fast(const int16_t *restrict x, int n)
+{
+    uint64_t s = 0;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const int32_t v0 = x[i], v1 = x[i + 1], v2 = x[i + 2], v3 = x[i + 3];
+        // 两个平方和 <= 2^31，32bit 无符号放得下
+        const uint32_t a = (uint32_t)(v0 * v0) + (uint32_t)(v1 * v1);
+        const uint32_t b = (uint32_t)(v2 * v2) + (uint32_t)(v3 * v3);
+        s += (uint64_t)a + b;
+    }
+    for (; i < n; ++i) s += (uint32_t)((int32_t)x[i] * x[i]);
+    return s;
+}
+
+static int32_t peak_fast(const int16_t *restrict x, int n)
+{
+    // 分别求最大/最小值，循环内无 abs 分支
+    int32_t mx = 0, mn = 0;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const int32_t v0 = x[i], v1 = x[i + 1], v2 = x[i + 2], v3 = x[i + 3];
+        const int32_t h0 = v0 > v1 ? v0 : v1, h1 = v2 > v3 ? v2 : v3;
+        const int32_t l0 = v0 < v1 ? v0 : v1, l1 = v2 < v3 ? v2 : v3;
+        const int32_t h = h0 > h1 ? h0 : h1, l = l0 < l1 ? l0 : l1;
+        if (h > mx) mx = h;
+        if (l < mn) mn = l;
+    }
+    for (; i < n; ++i) {
+        if (x[i] > mx) mx = x[i];
+        if (x[i] < mn) mn = x[i];
+    }
+    return (-mn > mx) ? -mn : mx;
+}
+
+static void gain_fast(int16_t *dst, const int16_t *src, int n, int32_t g)
+{
+    g = clamp_gain(g);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const int32_t v0 = src[i], v1 = src[i + 1], v2 = src[i + 2], v3 = src[i + 3];
+        dst[i] = sat16((v0 * g + 2048) >> 12);
+        dst[i + 1] = sat16((v1 * g + 2048) >> 12);
+        dst[i + 2] = sat16((v2 * g + 2048) >> 12);
+        dst[i + 3] = sat16((v3 * g + 2048) >> 12);
+    }
+    for (; i < n; ++i) dst[i] = sat16((src[i] * g + 2048) >> 12);
+}
+
+static void mix_fast(int16_t *restrict dst, const int16_t *restrict src, int n, int32_t g)
+{
+    g = clamp_gain(g);
+    int i = 0;
+    if (g == 4096) {
+        // 单位增益：(x * 4096 + 2048) >> 12 == x，直接饱和相加
+        for (; i + 4 <= n; i += 4) {
+            dst[i] = sat16(dst[i] + src[i]);
+            dst[i + 1] = sat16(dst[i + 1] + src[i + 1]);
+            dst[i + 2] = sat16(dst[i + 2] + src[i + 2]);
+            dst[i + 3] = sat16(dst[i + 3] + src[i + 3]);
+        }
+    } else {
+        for (; i + 4 <= n; i += 4) {
+            dst[i] = sat16(dst[i] + ((src[i] * g + 2048) >> 12));
+            dst[i + 1] = sat16(dst[i + 1] + ((src[i + 1] * g + 2048) >> 12));
+            dst[i + 2] = sat16(dst[i + 2] + ((src[i + 2] * g + 2048) >> 12));
+            dst[i + 3] = sat16(dst[i + 3] + ((src[i + 3] * g + 2048) >> 12));
+        }
+    }
+    for (; i < n; ++i) dst[i] = sat16(dst[i] + ((src[i] * g + 2048) >> 12));
+}
+
+static void fade_fast(int16_t *x, int n, int32_t from, int32_t to)
+{
+    if (n <= 0) return;
+    int32_t g = from * 32768;
+    const int32_t d = (to - from) * 32768 / n;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const int32_t g0 = g >> 15, g1 = (g + d) >> 15, g2 = (g + 2 * d) >> 15, g3 = (g + 3 * d) >> 15;
+        x[i] = (int16_t)((x[i] * g0 + 16384) >> 15);
+        x[i + 1] = (int16_t)((x[i + 1] * g1 + 16384) >> 15);
+        x[i + 2] = (int16_t)((x[i + 2] * g2 + 16384) >> 15);
+        x[i + 3] = (int16_t)((x[i + 3] * g3 + 16384) >> 15);
+        g += 4 * d;
+    }
+    for (; i < n; ++i) {
+        x[i] = (int16_t)((x[i] * (g >> 15) + 16384) >> 15);
+        g += d;
+    }
+}
+
+static void mix_ramp_fast(int16_t *restrict dst, const int16_t *restrict src, int n, int32_t from, int32_t to)
+{
+    if (n <= 0) return;
+    int32_t g = from * 32768;
+    const int32_t d = (to - from) * 32768 / n;
+    int i = 0;
+    if (d == 0) {
+        // 增益稳定（混音器绝大多数块）：常数乘法
+        const int32_t g0 = g >> 15;
+        for (; i + 4 <= n; i += 4) {
+            dst[i] = sat16(dst[i] + ((src[i] * g0 + 16384) >> 15));
+            dst[i + 1] = sat16(dst[i + 1] + ((src[i + 1] * g0 + 16384) >> 15));
+            dst[i + 2] = sat16(dst[i + 2] + ((src[i + 2] * g0 + 16384) >> 15));
+            dst[i + 3] = sat16(dst[i + 3] + ((src[i + 3] * g0 + 16384) >> 15));
+        }
+    } else {
+        for (; i + 4 <= n; i += 4) {
+            const int32_t g0 = g >> 15, g1 = (g + d) >> 15, g2 = (g + 2 * d) >> 15, g3 = (g + 3 * d) >> 15;
+            dst[i] = sat16(dst[i] + ((src[i] * g0 + 16384) >> 15));
+            dst[i + 1] = sat16(dst[i + 1] + ((src[i + 1] * g1 + 16384) >> 15));
+            dst[i + 2] = sat16(dst[i + 2] + ((src[i + 2] * g2 + 16384) >> 15));
+            dst[i + 3] = sat16(dst[i + 3] + ((src[i + 3] * g3 + 16384) >> 15));
+            g += 4 * d;
+        }
+    }
+    for (; i < n; ++i) {
+        dst[i] = sat16(dst[i] + ((src[i] * (g >> 15) + 16384) >> 15));
+        g += d;
+    }
+}
+
+static void s32_to_s16_fast(int16_t *restrict dst, const int32_t *restrict src, int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        dst[i] = (int16_t)(src[i] >> 16);
+        dst[i + 1] = (int16_t)(src[i + 1] >> 16);
+        dst[i + 2] = (int16_t)(src[i + 2] >> 16);
+        dst[i + 3] = (int16_t)(src[i + 3] >> 16);
+    }
+    for (; i < n; ++i) dst[i] = (int16_t)(src[i] >> 16);
+}
+
+#if PCM_HAVE_PIE
+// ---------- fast（ESP32-S3）：PIE 向量内核 ----------
+// vld/vst 忽略地址低 4 位，只处理 16 字节对齐的主体；对齐前的头部与不足 8 个样本的尾巴走上面的 C 版本。
+// 只在任务上下文调用（q 寄存器由 FreeRTOS 按协处理器惰性保存），不可在中断里用。
+
+#define PIE_CHUNK 256 // 每段样本数：|x|*|x| <= 2^30，256 个累加 <= 2^38，40 位 ACCX 不溢出
+
+static inline int pie_head(const void *p, int n)
+{
+    const int h = (int)((16u - ((uintptr_t)p & 15u)) & 15u) / 2;
+    return h < n ? h : n;
+}
+
+static inline uint64_t pie_accx(uint32_t lo, uint32_t hi)
+{
+    return ((uint64_t)(hi & 0xffu) << 32) | lo;
+}
+
+static uint64_t sum_abs_pie(const int16_t *x, int n)
+{
+    static const int16_t ones[8] __attribute__((aligned(16))) = {1, 1, 1, 1, 1, 1, 1, 1};
+    int i = pie_head(x, n);
+    uint64_t s = sum_abs_fast(x, i);
+    while (n - i >= 8) {
+        int k = ((n - i > PIE_CHUNK) ? PIE_CHUNK : n - i) / 8;
+        const int16_t *p = x + i, *o = ones;
+        uint32_t lo, hi;
+        i += 8 * k;
+        // |x| = x * sign(x)：vcmp 得负数 lane = -1，乘 2 加 1 得 ±1，再乘加进 ACCX
+        __asm__ volatile("ee.zero.accx\n\t"
+                         "ee.zero.q q7\n\t"
+                         "ee.vld.128.ip q6, %[o], 0\n\t"
+                         "1:\n\t"
+                         "ee.vld.128.ip q0, %[p], 16\n\t"
+                         "ee.vcmp.lt.s16 q1, q0, q7\n\t"
+                         "ee.vadds.s16 q1, q1, q1\n\t"
+                         "ee.vadds.s16 q1, q1, q6\n\t"
+                         "ee.vmulas.s16.accx q0, q1\n\t"
+                         "addi %[k], %[k], -1\n\t"
+                         "bnez %[k], 1b\n\t"
+                         "rur.accx_0 %[lo]\n\t"
+                         "rur.accx_1 %[hi]\n\t"
+                         : [p] "+r"(p), [o] "+r"(o), [k] "+r"(k), [lo] "=r"(lo), [hi] "=r"(hi)
+                         :
+                         : "memory");
+        s += pie_accx(lo, hi);
+    }
+    return s + sum_abs_fast(x + i, n - i);
+}
+
+static uint64_t sum_sq_pie(const int16_t *x, int n)
+{
+    int i = pie_head(x, n);
+    uint64_t s = sum_sq_fast(x, i);
+    while (n - i >= 8) {
+        int k = ((n - i > PIE_CHUNK) ? PIE_CHUNK : n - i) / 8;
+        const int16_t *p = x + i;
+        uint32_t lo, hi;
+        i += 8 * k;
+        __asm__ volatile("ee.zero.accx\n\t"
+                         "1:\n\t"
+                         "ee.vld.128.ip q0, %[p], 16\n\t"
+                         "ee.vmulas.s16.accx q0, q0\n\t"
+                         "addi %[k], %[k], -1\n\t"
+                         "bnez %[k], 1b\n\t"
+                         "rur.accx_0 %[lo]\n\t"
+                         "rur.accx_1 %[hi]\n\t"
+                         : [p] "+r"(p), [k] "+r"(k), [lo] "=r"(lo), [hi] "=r"(hi)
+                         :
+                         : "memory");
+        s += pie_accx(lo, hi);
+    }
+    return s + sum_sq_fast(x + i, n - i);
+}
+
+static int32_t peak_pie(const int16_t *x, int n)
+{
+    const int h = pie_head(x, n);
+    int k = (n - h) / 8;
+    if (k == 0) return peak_fast(x, n);
+    int16_t ext[16] __attribute__((aligned(16)));
+    const int16_t *p = x + h;
+    int16_t *o = ext;
+    // q1 逐 lane 最大值，q2 逐 lane 最小值（初值 0，与 C 版本一致）
+    __asm__ volatile("ee.zero.q q1\n\t"
+                     "ee.zero.q q2\n\t"
+                     "1:\n\t"
+                     "ee.vld.128.ip q0, %[p], 16\n\t"
+                     "ee.vmax.s16 q1, q1, q0\n\t"
+                     "ee.vmin.s16 q2, q2, q0\n\t"
+                     "addi %[k], %[k], -1\n\t"
+                     "bnez %[k], 1b\n\t"
+                     "ee.vst.128.ip q1, %[o], 16\n\t"
+                     "ee.vst.128.ip q2, %[o], 16\n\t"
+                     : [p] "+r"(p), [k] "+r"(k), [o] "+r"(o)
+                     :
+                     : "memory");
+    int32_t mx = 0, mn = 0;
+    for (int j = 0; j < 8; ++j) {
+        if (ext[j] > mx) mx = ext[j];
+        if (ext[8 + j] < mn) mn = ext[8 + j];
+    }
+    int32_t pk = (-mn > mx) ? -mn : mx;
+    const int done = h + 8 * ((n - h) / 8);
+    const int32_t a = peak_fast(x, h), b = peak_fast(x + done, n - done);
+    if (a > pk) pk = a;
+    return b > pk ? b : pk;
+}
+
+static void mix_pie(int16_t *restrict dst, const int16_t *restrict src, int n, int32_t g)
+{
+    // 只有单位增益（混音器 / 降噪叠加的常见情况）有饱和加法可用；Q12 舍入的乘法没有对应指令
+    const int h = pie_head(dst, n);
+    if (clamp_gain(g) != 4096 || pie_head(src, n) != h || n - h < 8) {
+        mix_fast(dst, src, n, g);
+        return;
+    }
+    mix_fast(dst, src, h, g);
+    int k = (n - h) / 8;
+    int16_t *d = dst + h;
+    const int16_t *s = src + h;
+    const int done = h + 8 * k;
+    __asm__ volatile("1:\n\t"
+                     "ee.vld.128.ip q0, %[d], 0\n\t"
+                     "ee.vld.128.ip q1, %[s], 16\n\t"
+                     "ee.vadds.s16 q0, q0, q1\n\t"
+                     "ee.vst.128.ip q0, %[d], 16\n\t"
+                     "addi %[k], %[k], -1\n\t"
+                     "bnez %[k], 1b\n\t"
+                     : [d] "+r"(d), [s] "+r"(s), [k] "+r"(k)
+                     :
+                     : "memory");
+    mix_fast(dst + done, src + done, n - done, g);
+}
+
+#define PCM_FAST(fn) fn##_pie
+#else
+#define PCM_FAST(fn) fn##_fast
+#endif
+
+static const app_pcm_ops_t s_ops_portable = {
+    .name = "portable",
+    .sum_abs = sum_abs_c,
+    .sum_sq = sum_sq_c,
+    .peak = peak_c,
+    .gain = gain_c,
+    .mix = mix_c,
+    .fade = fade_c,
+    .mix_ramp = mix_ramp_c,
+    .s32_to_s16 = s32_to_s16_c,
+    .stereo_to_mono = stereo_to_mono_c,
+};
+
+// stereo_to_mono 没有 fast 版本：4 路展开在主机（0.56~0.77x）上比逐样本循环慢，默认路径不用比 portable 慢的内核
+static const app_pcm_ops_t s_ops_fast = {
+    .name = PCM_HAVE_PIE ? "fast+pie" : "fast",
+    .sum_abs = PCM_FAST(sum_abs),
+    .sum_sq = PCM_FAST(sum_sq),
+    .peak = PCM_FAST(peak),
+    .gain = gain_fast,
+    .mix = PCM_FAST(mix),
+    .fade = fade_fast,
+    .mix_ramp = mix_ramp_fast,
+    .s32_to_s16 = s32_to_s16_fast,
+    .stereo_to_mono = stereo_to_mono_c,
+};
+
+const app_pcm_ops_t *app_pcm_ops_get(app_pcm_impl_t impl)
+{
+    return (impl == APP_PCM_IMPL_FAST) ? &s_ops_fast : &s_ops_portable;
+}
+
+#if PCM_DEFAULT_FAST
+#define PCM_IMPL(fn) s_ops_fast.fn
+#else
+#define PCM_IMPL(fn) fn##_c
+#endif
+
+const char *app_pcm_ops_impl(void)
+{
+    return PCM_DEFAULT_FAST ? s_ops_fast.name : s_ops_portable.name;
+}
+
+// ---------- 对外接口 ----------
+
+uint64_t app_pcm_sum_abs(const int16_t *x, int n)
+{
+    return PCM_IMPL(sum_abs)(x, n);
+}
+
+float app_pcm_mean_abs(const int16_t *x, int n)
+{
+    return (n > 0) ? (float)PCM_IMPL(sum_abs)(x, n) / (float)n : 0.0f;
+}
+
+uint64_t app_pcm_sum_sq(const int16_t *x, int n)
+{
+    return PCM_IMPL(sum_sq)(x, n);
+}
+
+float app_pcm_rms(const int16_t *x, int n)
+{
+    return (n > 0) ? sqrtf((float)PCM_IMPL(sum_sq)(x, n) / (float)n) : 0.0f;
+}
+
+int32_t app_pcm_peak(const int16_t *x, int n)
+{
+    return PCM_IMPL(peak)(x, n);
+}
+
+void app_pcm_gain(int16_t *dst, const int16_t *src, int n, int32_t gain_q12)
+{
+    PCM_IMPL(gain)(dst, src, n, gain_q12);
+}
+
+void app_pcm_mix(int16_t *dst, const int16_t *src, int n, int32_t gain_q12)
+{
+    PCM_IMPL(mix)(dst, src, n, gain_q12);
+}
+
+void app_pcm_fade(int16_t *x, int n, int32_t from_q15, int32_t to_q15)
+{
+    PCM_IMPL(fade)(x, n, from_q15, to_q15);
+}
+
+void app_pcm_mix_ramp(int16_t *dst, const int16_t *src, int n, int32_t from_q15, int32_t to_q15)
+{
+    PCM_IMPL(mix_ramp)(dst, src, n, from_q15, to_q15);
+}
+
+void app_pcm_xfade(int16_t *dst, const int16_t *from, int n)
+{
+    if (n <= 0) return;
+    int32_t g = 0;
+    const int32_t d = (32767 << 15) / n;
+    for (int i = 0; i < n; ++i) {
+        const int32_t gi = g >> 15;
+        dst[i] = sat16((from[i] * (32767 - gi) + dst[i] * gi + 16384) >> 15);
+        g += d;
+    }
+}
+
+void app_pcm_s32_to_s16(int16_t *dst, const int32_t *src, int n)
+{
+    PCM_IMPL(s32_to_s16)(dst, src, n);
+}
+
+void app_pcm_s16_to_s32(int32_t *dst, const int16_t *src, int n)
+{
+    // 可原地（dst 需有 4*n 字节）：从后往前写
+    for (int i = n - 1; i >= 0; --i) dst[i] = (int32_t)src[i] << 16;
+}
+
+void app_pcm_mono_to_stereo(int16_t *dst, const int16_t *src, int frames)
+{
+    for (int i = frames - 1; i >= 0; --i) {
+        const int16_t v = src[i];
+        dst[2 * i] = v;
+        dst[2 * i + 1] = v;
+    }
+}
+
+void app_pcm_stereo_to_mono(int16_t *dst, const int16_t *src, int frames)
+{
+    stereo_to_mono_c(dst, src, frames);
+}
+
+// ---------- NCO ----------
+
+// round(32767 * sin(pi/2 * i/64))，i = 0..64
+static const int16_t s_qsin[65] = {
+    0,     804,   1608,  2410,  3212,  4011,  4808,  5602,  6393,  7179,  7962,  8739,  9512,
+    10278, 11039, 11793, 12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530, 18204, 18868,
+    19519, 20159, 20787, 21403, 22005, 22594, 23170, 23731, 24279, 24811, 25329, 25832, 26319,
+    26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956, 30273, 30571, 30852, 31113,
+    31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757, 32767,
+};
+
+static inline int32_t nco_sin(uint32_t phase)
+{
+    // 高 2 位象限，其后 22 位为象限内位置（6 位表下标 + 16 位插值）
+    const uint32_t q = phase >> 30;
+    uint32_t pos = (phase >> 8) & 0x3fffffu;
+    if (q & 1) pos = 0x400000u - pos;
+    const uint32_t idx = pos >> 16;
+    int32_t v = s_qsin[idx];
+    if (idx < 64) v += ((s_qsin[idx + 1] - v) * (int32_t)(pos & 0xffffu)) >> 16;
+    return (q & 2) ? -v : v;
+}
+
+void app_pcm_nco_init(app_pcm_nco_t *o, int freq_hz, int sample_rate, int16_t amp)
+{
+    o->phase = 0;
+    o->step = (sample_rate > 0) ? (uint32_t)(((uint64_t)(uint32_t)freq_hz << 32) / (uint32_t)sample_rate) : 0;
+    o->amp = amp;
+}
+
+void app_pcm_nco_run(app_pcm_nco_t *o, int16_t *dst, int frames, int channels)
+{
+    uint32_t ph = o->phase;
+    const int32_t amp = o->amp;
+    for (int i = 0; i < frames; ++i) {
+        const int16_t v = (int16_t)((nco_sin(ph) * amp + 16384) >> 15);
+        ph += o->step;
+        for (int c = 0; c < channels; ++c) *dst++ = v;
+    }
+    o->phase = ph;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * s16 PCM 常用小内核：电平统计、饱和增益、混音（含增益斜坡）、淡入淡出、格式转换、NCO 正弦。
+ * 不依赖 IDF，可直接在主机上编译（tools/pcm_ops_bench.c）。
+ *
+ * 每个内核有两份实现，结果逐位一致：
+ *   portable：直白的逐样本循环，主机/其他目标默认；
+ *   fast    ：4 路展开 + 分组累加（减少 64bit 累加与分支），ESP32-S3 默认；S3 上 sum_abs / sum_sq /
+ *             peak / 单位增益 mix 走 PIE 128 位向量指令（实现名 "fast+pie"，只能在任务上下文调用）。
+ *             stereo_to_mono 没有 fast 版本，两张表都用逐样本循环。
+ * 增益为 Q12（4096 = 1.0），淡变系数为 Q15（32767 ≈ 1.0）。
+ */
+
+typedef enum {
+    APP_PCM_IMPL_PORTABLE = 0,
+    APP_PCM_IMPL_FAST,
+} app_pcm_impl_t;
+
+uint64_t app_pcm_sum_abs(const int16_t *x, int n);
+float app_pcm_mean_abs(const int16_t *x, int n);
+uint64_t app_pcm_sum_sq(const int16_t *x, int n);
+float app_pcm_rms(const int16_t *x, int n);
+
+/**
+ * @brief 最大绝对值，0..32768
+ */
+int32_t app_pcm_peak(const int16_t *x, int n);
+
+/**
+ * @brief dst = sat(src * gain)，dst 可与 src 相同
+ */
+void app_pcm_gain(int16_t *dst, const int16_t *src, int n, int32_t gain_q12);
+
+/**
+ * @brief dst = sat(dst + src * gain)
+ */
+void app_pcm_mix(int16_t *dst, const int16_t *src, int n, int32_t gain_q12);
+
+/**
+ * @brief 原地线性淡变：第 i 个样本乘 from + (to - from) * i / n
+ */
+void app_pcm_fade(int16_t *x, int n, int32_t from_q15, int32_t to_q15);
+
+/**
+ * @brief dst = sat(dst + src * g_i)，g_i 从 from 线性变到 to（与 app_pcm_fade 同一序列），混音器用
+ */
+void app_pcm_mix_ramp(int16_t *dst, const int16_t *src, int n, int32_t from_q15, int32_t to_q15);
+
+/**
+ * @brief 交叉淡化：from 从 1 淡出、dst 从 0 淡入，结果写回 dst
+ */
+void app_pcm_xfade(int16_t *dst, const int16_t *from, int n);
+
+void app_pcm_s32_to_s16(int16_t *dst, const int32_t *src, int n);
+void app_pcm_s16_to_s32(int32_t *dst, const int16_t *src, int n);
+
+/**
+ * @brief 单声道 -> 双声道（复制），可原地（dst 需有 2*frames 空间）
+ */
+void app_pcm_mono_to_stereo(int16_t *dst, const int16_t *src, int frames);
+
+/**
+ * @brief 双声道 -> 单声道（平均），可原地
+ */
+void app_pcm_stereo_to_mono(int16_t *dst, const int16_t *src, int frames);
+
+// 数控振荡器：32bit 相位累加 + 四分之一周期查表线性插值（约 -80 dB 谐波），无浮点
+typedef struct {
+    uint32_t phase;
+    uint32_t step;
+    int16_t amp;
+} app_pcm_nco_t;
+
+void app_pcm_nco_init(app_pcm_nco_t *o, int freq_hz, int sample_rate, int16_t amp);
+
+/**
+ * @brief 生成 frames 帧，多声道时各声道相同
+ */
+void app_pcm_nco_run(app_pcm_nco_t *o, int16_t *dst, int frames, int channels);
+
+// 两份实现的函数表（测试/基准对比用）
+typedef struct {
+    const char *name;
+    uint64_t (*sum_abs)(const int16_t *x, int n);
+    uint64_t (*sum_sq)(const int16_t *x, int n);
+    int32_t (*peak)(const int16_t *x, int n);
+    void (*gain)(int16_t *dst, const int16_t *src, int n, int32_t gain_q12);
+    void (*mix)(int16_t *dst, const int16_t *src, int n, int32_t gain_q12);
+    void (*fade)(int16_t *x, int n, int32_t from_q15, int32_t to_q15);
+    void (*mix_ramp)(int16_t *dst, const int16_t *src, int n, int32_t from_q15, int32_t to_q15);
+    void (*s32_to_s16)(int16_t *dst, const int32_t *src, int n);
+    void (*stereo_to_mono)(int16_t *dst, const int16_t *src, int frames);
+} app_pcm_ops_t;
+
+const app_pcm_ops_t *app_pcm_ops_get(app_pcm_impl_t impl);
+
+/**
+ * @brief 当前默认实现名
+ */
+const char *app_pcm_ops_impl(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,173 @@
+#include "App_Ptt.h"
+
+#include <string.h>
+
+#include "driver/gpio.h"
+#include "esp_check.h"
+#include "esp_log.h"
+
+static const char *TAG = "App_Ptt";
+
+app_ptt_cfg_t app_ptt_cfg_default(void)
+{
+    app_ptt_cfg_t c = {
+        .src = APP_PTT_SRC_GPIO,
+        .gpio = 0,
+        .active_low = true,
+        .debounce_ms = 30,
+        .sim_hold_ms = 3000,
+        .sim_gap_ms = 8000,
+    };
+    return c;
+}
+
+static void ptt_report(app_ptt_t *p, bool pressed, int64_t t_us)
+{
+    p->pressed = pressed;
+    if (pressed) {
+        p->st.presses++;
+    } else {
+        p->st.releases++;
+    }
+    p->cfg.cb(pressed, t_us, p->cfg.ctx);
+}
+
+static inline bool ptt_level_pressed(const app_ptt_t *p)
+{
+    return (gpio_get_level((gpio_num_t)p->cfg.gpio) == 0) == p->cfg.active_low;
+}
+
+// 首沿即报，然后屏蔽 debounce_ms
+static void ptt_gpio_isr(void *arg)
+{
+    app_ptt_t *p = (app_ptt_t *)arg;
+    const int64_t now = esp_timer_get_time();
+    if (p->locked) {
+        p->st.bounces++;
+        return;
+    }
+    const bool v = ptt_level_pressed(p);
+    if (v == p->pressed) return;
+    p->locked = true;
+    gpio_intr_disable((gpio_num_t)p->cfg.gpio);
+    ptt_report(p, v, now);
+    esp_timer_start_once(p->timer, (uint64_t)p->cfg.debounce_ms * 1000);
+}
+
+static void ptt_gpio_unlock(void *arg)
+{
+    app_ptt_t *p = (app_ptt_t *)arg;
+    const bool v = ptt_level_pressed(p);
+    if (v != p->pressed) {
+        // 屏蔽期内松开 / 按下：补报，并再屏蔽一轮
+        p->st.late_edges++;
+        ptt_report(p, v, esp_timer_get_time());
+        esp_timer_start_once(p->timer, (uint64_t)p->cfg.debounce_ms * 1000);
+        return;
+    }
+    p->locked = false;
+    gpio_intr_enable((gpio_num_t)p->cfg.gpio);
+}
+
+static void ptt_sim_tick(void *arg)
+{
+    app_ptt_t *p = (app_ptt_t *)arg;
+    const bool v = !p->pressed;
+    ptt_report(p, v, esp_timer_get_time());
+    esp_timer_start_once(p->timer, (uint64_t)(v ? p->cfg.sim_hold_ms : p->cfg.sim_gap_ms) * 1000);
+}
+
+esp_err_t app_ptt_init(app_ptt_t *p, const app_ptt_cfg_t *cfg)
+{
+    ESP_RETURN_ON_FALSE(p && cfg && cfg->cb, ESP_ERR_INVALID_ARG, TAG, "bad args");
+    memset(p, 0, sizeof(*p));
+    app_ptt_cfg_t def = app_ptt_cfg_default();
+    p->cfg = *cfg;
+    if (p->cfg.debounce_ms <= 0) p->cfg.debounce_ms = def.debounce_ms;
+    if (p->cfg.sim_hold_ms <= 0) p->cfg.sim_hold_ms = def.sim_hold_ms;
+    if (p->cfg.sim_gap_ms <= 0) p->cfg.sim_gap_ms = def.sim_gap_ms;
+
+    if (p->cfg.src == APP_PTT_SRC_EXTERNAL) {
+        p->inited = true;
+        ESP_LOGI(TAG, "ptt: external source");
+        return ESP_OK;
+    }
+
+    const esp_timer_create_args_t ta = {
+        .callback = (p->cfg.src == APP_PTT_SRC_SIM) ? ptt_sim_tick : ptt_gpio_unlock,
+        .arg = p,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "ptt",
+    };
+    ESP_RETURN_ON_ERROR(esp_timer_create(&ta, &p->timer), TAG, "create timer failed");
+
+    esp_err_t ret = ESP_OK;
+    if (p->cfg.src == APP_PTT_SRC_SIM) {
+        ret = esp_timer_start_once(p->timer, (uint64_t)p->cfg.sim_gap_ms * 1000);
+        if (ret == ESP_OK) {
+            ESP_LOGI(TAG, "ptt: simulated key, hold %d ms every %d ms", p->cfg.sim_hold_ms,
+                     p->cfg.sim_hold_ms + p->cfg.sim_gap_ms);
+        }
+    } else {
+        gpio_config_t io = {
+            .pin_bit_mask = 1ULL << p->cfg.gpio,
+            .mode = GPIO_MODE_INPUT,
+            .pull_up_en = p->cfg.active_low ? GPIO_PULLUP_ENABLE : GPIO_PULLUP_DISABLE,
+            .pull_down_en = p->cfg.active_low ? GPIO_PULLDOWN_DISABLE : GPIO_PULLDOWN_ENABLE,
+            .intr_type = GPIO_INTR_ANYEDGE,
+        };
+        ret = gpio_config(&io);
+        if (ret == ESP_OK) {
+            // 别的模块已装过 ISR 服务时返回 INVALID_STATE，可以直接用
+            ret = gpio_install_isr_service(0);
+            if (ret == ESP_ERR_INVALID_STATE) ret = ESP_OK;
+        }
+        if (ret == ESP_OK) {
+            p->pressed = ptt_level_pressed(p);
+            ret = gpio_isr_handler_add((gpio_num_t)p->cfg.gpio, ptt_gpio_isr, p);
+        }
+        if (ret == ESP_OK) {
+            ESP_LOGI(TAG, "ptt: gpio %d (active %s), debounce %d ms", p->cfg.gpio, p->cfg.active_low ? "low" : "high",
+                     p->cfg.debounce_ms);
+        }
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "ptt init failed: %s", esp_err_to_name(ret));
+        esp_timer_delete(p->timer);
+        p->timer = NULL;
+        return ret;
+    }
+    p->inited = true;
+    return ESP_OK;
+}
+
+void app_ptt_deinit(app_ptt_t *p)
+{
+    if (!p || !p->inited) return;
+    if (p->cfg.src == APP_PTT_SRC_GPIO) {
+        gpio_isr_handler_remove((gpio_num_t)p->cfg.gpio);
+    }
+    if (p->timer) {
+        esp_timer_stop(p->timer);
+        esp_timer_delete(p->timer);
+        p->timer = NULL;
+    }
+    p->inited = false;
+}
+
+void app_ptt_inject(app_ptt_t *p, bool pressed)
+{
+    if (!p || !p->inited || p->pressed == pressed) return;
+    ptt_report(p, pressed, esp_timer_get_time());
+}
+
+bool app_ptt_is_pressed(const app_ptt_t *p)
+{
+    return p && p->pressed;
+}
+
+void app_ptt_get_stats(const app_ptt_t *p, app_ptt_stats_t *out)
+{
+    if (!p || !out) return;
+    *out = p->st;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 按键说话（push-to-talk）的按键源：按下 / 松开直接回调，不经过轮询任务。
+ *
+ *   GPIO：任意沿中断里读电平，状态变化立即回调（首沿即报，按下延迟 = 中断延迟）；
+ *         随后屏蔽中断 debounce_ms，到期再采一次电平，补报屏蔽期间漏掉的变化。
+ *   SIM ：定时器按 sim_hold_ms / sim_gap_ms 自动按下 / 松开，不接按键也能量延迟。
+ *   EXTERNAL：不占硬件，由触摸屏、BLE 遥控等在任务上下文调用 app_ptt_inject()。
+ *
+ * 回调带事件时刻（esp_timer_get_time，GPIO 为中断里的时刻）。
+ * GPIO 源的回调在中断上下文执行，只能用 FromISR 接口（可用 xPortInIsrContext() 判断）。
+ */
+
+typedef enum {
+    APP_PTT_SRC_GPIO = 0,
+    APP_PTT_SRC_SIM = 1,
+    APP_PTT_SRC_EXTERNAL = 2,
+} app_ptt_src_t;
+
+typedef void (*app_ptt_cb_t)(bool pressed, int64_t t_us, void *ctx);
+
+typedef struct {
+    app_ptt_src_t src;
+    int gpio;                   // GPIO：按键引脚，默认 0（BOOT 键）
+    bool active_low;            // GPIO：低电平为按下，默认 true（内部上拉）
+    int debounce_ms;            // GPIO：沿后屏蔽时长，默认 30
+    int sim_hold_ms;            // SIM：每次按住时长，默认 3000
+    int sim_gap_ms;             // SIM：松开到下次按下，默认 8000
+    app_ptt_cb_t cb;            // 必填
+    void *ctx;
+} app_ptt_cfg_t;
+
+typedef struct {
+    uint32_t presses;
+    uint32_t releases;
+    uint32_t bounces;           // 屏蔽期内被忽略的沿
+    uint32_t late_edges;        // 屏蔽期结束补报的变化
+} app_ptt_stats_t;
+
+typedef struct {
+    app_ptt_cfg_t cfg;
+    esp_timer_handle_t timer;   // GPIO：屏蔽期结束；SIM：下一次按下 / 松开
+    volatile bool pressed;
+    volatile bool locked;       // GPIO：屏蔽期中
+    bool inited;
+    app_ptt_stats_t st;
+} app_ptt_t;
+
+app_ptt_cfg_t app_ptt_cfg_default(void);
+
+esp_err_t app_ptt_init(app_ptt_t *p, const app_ptt_cfg_t *cfg);
+void app_ptt_deinit(app_ptt_t *p);
+
+/**
+ * @brief 外部源上报按下 / 松开（任务上下文）；与当前状态相同则忽略
+ */
+void app_ptt_inject(app_ptt_t *p, bool pressed);
+
+bool app_ptt_is_pressed(const app_ptt_t *p);
+
+/**
+ * @brief 按下时的回溯字节数：按下前 preroll_bytes，再加上事件处理晚到的 since_us（按下时刻起的音频不丢）
+ */
+static inline size_t app_ptt_preroll_bytes(size_t preroll_bytes, int64_t since_us, size_t bytes_per_sec)
+{
+    const uint64_t late = (uint64_t)(since_us > 0 ? since_us : 0) * bytes_per_sec / 1000000;
+    return preroll_bytes + ((size_t)late & ~(size_t)1);
+}
+
+/**
+ * @brief 松键时刻在采集流里的字节序号：seq_w 往回退 since_us 对应的字节（对齐到样本），不早于 send_seq_r
+ */
+static inline uint64_t app_ptt_release_seq(uint64_t seq_w, uint64_t send_seq_r, int64_t since_us, size_t bytes_per_sec)
+{
+    const uint64_t late = ((uint64_t)(since_us > 0 ? since_us : 0) * bytes_per_sec / 1000000) & ~(uint64_t)1;
+    const uint64_t seq = (seq_w > late) ? (seq_w - late) : 0;
+    return (seq < send_seq_r) ? send_seq_r : seq;
+}
+
+void app_ptt_get_stats(const app_ptt_t *p, app_ptt_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,377 @@
+#include "App_Rb3ConnMgr.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_random.h"
+
+static const char *TAG = "App_Rb3ConnMgr";
+
+#define CM_TICK_MS 50
+
+typedef struct {
+    app_rb3_cfg_t rb3;
+    app_rb3_connmgr_cfg_t cfg;
+    SemaphoreHandle_t lock;
+    TaskHandle_t task;
+    volatile bool stop;
+    bool started;
+
+    // 以下 primary/state/users/broken/kick/paused 需持锁访问；pending/standby 只由管理器任务访问
+    app_rb3_conn_state_t state;
+    app_rb3_ws_sess_t *primary;
+    int users;                  // 借用计数（>0 时管理器不关闭主连接）
+    bool primary_broken;
+    bool kick;
+    bool paused;
+
+    app_rb3_ws_sess_t *pending; // 正在建连、成功后成为主连接
+    uint32_t pending_t0;
+    app_rb3_ws_sess_t *standby;
+    uint32_t standby_t0;
+    bool standby_ready;
+    uint32_t standby_retry_at;
+
+    int backoff_step;
+    uint32_t backoff_until;
+    uint64_t connect_ms_sum;
+    app_rb3_connmgr_stats_t st;
+} cm_ctx_t;
+
+static cm_ctx_t s_cm = {0};
+
+static inline uint32_t now_ms(void)
+{
+    return esp_log_timestamp();
+}
+
+app_rb3_connmgr_cfg_t app_rb3_connmgr_cfg_default(void)
+{
+    app_rb3_connmgr_cfg_t c = {
+        .connect_timeout_ms = 5000,
+        .backoff_min_ms = 250,
+        .backoff_max_ms = 16000,
+        .liveness_ms = 0, // 0：按 rb3 的 ping_interval_ms + pong_timeout_ms
+        .hot_standby = false,
+        .task_prio = 4,
+    };
+    return c;
+}
+
+// 调用方需持锁
+static void cm_enter_backoff(uint32_t now)
+{
+    if (s_cm.backoff_step < 16) s_cm.backoff_step++;
+    uint32_t b = (uint32_t)s_cm.cfg.backoff_min_ms << (s_cm.backoff_step - 1);
+    if (b > (uint32_t)s_cm.cfg.backoff_max_ms || b == 0) b = (uint32_t)s_cm.cfg.backoff_max_ms;
+    // ±25% 抖动：多台设备同时掉线时错开重连
+    b = b - b / 4 + esp_random() % (b / 2 + 1);
+    s_cm.backoff_until = now + b;
+    s_cm.st.backoff_ms = b;
+    s_cm.state = APP_RB3_CONN_BACKOFF;
+    ESP_LOGW(TAG, "connect failed, retry in %" PRIu32 " ms（第 %d 次）", b, s_cm.backoff_step);
+}
+
+static void cm_record_connect(uint32_t ms)
+{
+    s_cm.st.connects++;
+    s_cm.st.connect_ms_last = ms;
+    s_cm.connect_ms_sum += ms;
+    s_cm.st.connect_ms_avg = (uint32_t)(s_cm.connect_ms_sum / s_cm.st.connects);
+}
+
+static bool cm_sess_alive(app_rb3_ws_sess_t *s)
+{
+    if (!app_rb3_ws_is_connected(s)) return false;
+    return app_rb3_ws_rx_idle_ms(s) <= (uint32_t)s_cm.cfg.liveness_ms;
+}
+
+// 备用连接：只在 READY 时维护，失败不影响主状态机
+static void cm_step_standby(uint32_t now, app_rb3_ws_sess_t **to_close, int *nclose)
+{
+    if (!s_cm.standby) {
+        if ((int32_t)(now - s_cm.standby_retry_at) < 0) return;
+        if (app_rb3_ws_open_nowait(&s_cm.rb3, &s_cm.standby) == ESP_OK) {
+            s_cm.standby_t0 = now;
+            s_cm.standby_ready = false;
+        } else {
+            s_cm.standby_retry_at = now + (uint32_t)s_cm.cfg.backoff_max_ms / 4;
+        }
+        return;
+    }
+    if (!s_cm.standby_ready) {
+        if (app_rb3_ws_is_connected(s_cm.standby)) {
+            s_cm.standby_ready = true;
+            cm_record_connect(now - s_cm.standby_t0);
+        } else if (app_rb3_ws_has_ended(s_cm.standby) ||
+                   (int)(now - s_cm.standby_t0) > s_cm.cfg.connect_timeout_ms) {
+            app_rb3_ws_mark_broken(s_cm.standby);
+            to_close[(*nclose)++] = s_cm.standby;
+            s_cm.standby = NULL;
+            s_cm.st.connect_fails++;
+            s_cm.standby_retry_at = now + (uint32_t)s_cm.cfg.backoff_max_ms / 4;
+        }
+        return;
+    }
+    if (!cm_sess_alive(s_cm.standby)) {
+        to_close[(*nclose)++] = s_cm.standby;
+        s_cm.standby = NULL;
+        s_cm.standby_ready = false;
+    }
+}
+
+static void cm_step(void)
+{
+    const uint32_t now = now_ms();
+    app_rb3_ws_sess_t *to_close[3];
+    int nclose = 0;
+    app_rb3_ws_sess_t *down = NULL;
+    app_rb3_ws_sess_t *up = NULL;
+
+    xSemaphoreTake(s_cm.lock, portMAX_DELAY);
+    const bool kick = s_cm.kick;
+    s_cm.kick = false;
+
+    if (s_cm.paused) {
+        // 静默期：空闲的连接全部关掉；被借用的等归还后下一拍再关
+        if (s_cm.primary && s_cm.users == 0) {
+            down = s_cm.primary;
+            to_close[nclose++] = s_cm.primary;
+            s_cm.primary = NULL;
+            s_cm.primary_broken = false;
+        }
+        if (s_cm.pending) to_close[nclose++] = s_cm.pending;
+        if (s_cm.standby) to_close[nclose++] = s_cm.standby;
+        s_cm.pending = NULL;
+        s_cm.standby = NULL;
+        s_cm.standby_ready = false;
+        s_cm.state = APP_RB3_CONN_PAUSED;
+    } else {
+        if (kick && (s_cm.state == APP_RB3_CONN_PAUSED || s_cm.state == APP_RB3_CONN_BACKOFF)) {
+            // 暂停时仍被借用的主连接没关：直接恢复 READY，不再另建
+            s_cm.state = s_cm.primary ? APP_RB3_CONN_READY : APP_RB3_CONN_CONNECTING;
+        }
+
+        // 主连接存活检查：只在未被借用时（等待期）判死，使用中的失败由借用方 release(broken) 报告
+        if (s_cm.primary && s_cm.users == 0) {
+            const bool dead = s_cm.primary_broken || !app_rb3_ws_is_connected(s_cm.primary);
+            const bool silent = !dead && app_rb3_ws_rx_idle_ms(s_cm.primary) > (uint32_t)s_cm.cfg.liveness_ms;
+            if (dead || silent) {
+                s_cm.st.drops++;
+                if (silent) s_cm.st.liveness_fails++;
+                ESP_LOGW(TAG, "primary ws %s", silent ? "heartbeat timeout" : "down");
+                app_rb3_ws_mark_broken(s_cm.primary);
+                down = s_cm.primary;
+                to_close[nclose++] = s_cm.primary;
+                s_cm.primary = NULL;
+                s_cm.primary_broken = false;
+                if (s_cm.standby && s_cm.standby_ready && cm_sess_alive(s_cm.standby)) {
+                    up = s_cm.standby;
+                    s_cm.standby = NULL;
+                    s_cm.standby_ready = false;
+                    s_cm.st.standby_promotions++;
+                    ESP_LOGI(TAG, "standby ws promoted");
+                } else {
+                    // 第一次重连不退避
+                    s_cm.state = APP_RB3_CONN_CONNECTING;
+                }
+            }
+        }
+
+        switch (s_cm.state) {
+        case APP_RB3_CONN_CONNECTING:
+            if (up) break;
+            if (!s_cm.pending) {
+                if (app_rb3_ws_open_nowait(&s_cm.rb3, &s_cm.pending) == ESP_OK) {
+                    s_cm.pending_t0 = now;
+                } else {
+                    s_cm.pending = NULL;
+                    s_cm.st.connect_fails++;
+                    cm_enter_backoff(now);
+                }
+            } else if (app_rb3_ws_is_connected(s_cm.pending)) {
+                up = s_cm.pending;
+                s_cm.pending = NULL;
+                s_cm.backoff_step = 0;
+                s_cm.st.backoff_ms = 0;
+                cm_record_connect(now - s_cm.pending_t0);
+            } else if (app_rb3_ws_has_ended(s_cm.pending) ||
+                       (int)(now - s_cm.pending_t0) > s_cm.cfg.connect_timeout_ms) {
+                // 握手被拒/出错时立即退避，不等满建连超时
+                app_rb3_ws_mark_broken(s_cm.pending);
+                to_close[nclose++] = s_cm.pending;
+                s_cm.pending = NULL;
+                s_cm.st.connect_fails++;
+                cm_enter_backoff(now);
+            }
+            break;
+        case APP_RB3_CONN_BACKOFF:
+            if ((int32_t)(now - s_cm.backoff_until) >= 0) s_cm.state = APP_RB3_CONN_CONNECTING;
+            break;
+        case APP_RB3_CONN_READY:
+            if (s_cm.cfg.hot_standby) cm_step_standby(now, to_close, &nclose);
+            break;
+        default:
+            break;
+        }
+    }
+    s_cm.st.state = s_cm.state;
+    xSemaphoreGive(s_cm.lock);
+
+    // 回调与关闭都在锁外：on_down 可能要等其它模块放手（如事件缓存）
+    if (down && s_cm.cfg.on_down) s_cm.cfg.on_down(down, s_cm.cfg.ctx);
+    for (int i = 0; i < nclose; ++i) app_rb3_ws_close(to_close[i]);
+    if (up) {
+        // 先让上层挂好回调，再对 acquire 可见
+        if (s_cm.cfg.on_up) s_cm.cfg.on_up(up, s_cm.cfg.ctx);
+        xSemaphoreTake(s_cm.lock, portMAX_DELAY);
+        s_cm.primary = up;
+        s_cm.primary_broken = false;
+        s_cm.state = APP_RB3_CONN_READY;
+        s_cm.st.state = s_cm.state;
+        xSemaphoreGive(s_cm.lock);
+        ESP_LOGI(TAG, "ws ready（connect %" PRIu32 " ms）", s_cm.st.connect_ms_last);
+    }
+}
+
+static void task_connmgr(void *arg)
+{
+    (void)arg;
+    while (!s_cm.stop) {
+        cm_step();
+        (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CM_TICK_MS));
+    }
+
+    xSemaphoreTake(s_cm.lock, portMAX_DELAY);
+    app_rb3_ws_sess_t *p = s_cm.primary;
+    s_cm.primary = NULL;
+    s_cm.state = APP_RB3_CONN_PAUSED;
+    xSemaphoreGive(s_cm.lock);
+    if (p && s_cm.cfg.on_down) s_cm.cfg.on_down(p, s_cm.cfg.ctx);
+    if (p) app_rb3_ws_close(p);
+    if (s_cm.pending) app_rb3_ws_close(s_cm.pending);
+    if (s_cm.standby) app_rb3_ws_close(s_cm.standby);
+    s_cm.pending = NULL;
+    s_cm.standby = NULL;
+
+    s_cm.task = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t app_rb3_connmgr_start(const app_rb3_cfg_t *rb3, const app_rb3_connmgr_cfg_t *cfg)
+{
+    ESP_RETURN_ON_FALSE(rb3 && (rb3->base_url || rb3->endpoint_count > 0), ESP_ERR_INVALID_ARG, TAG, "rb3 cfg invalid");
+    ESP_RETURN_ON_FALSE(!s_cm.started, ESP_ERR_INVALID_STATE, TAG, "already started");
+
+    memset(&s_cm, 0, sizeof(s_cm));
+    s_cm.rb3 = *rb3;
+    s_cm.cfg = cfg ? *cfg : app_rb3_connmgr_cfg_default();
+    app_rb3_connmgr_cfg_t def = app_rb3_connmgr_cfg_default();
+    if (s_cm.cfg.connect_timeout_ms <= 0) s_cm.cfg.connect_timeout_ms = def.connect_timeout_ms;
+    if (s_cm.cfg.backoff_min_ms <= 0) s_cm.cfg.backoff_min_ms = def.backoff_min_ms;
+    if (s_cm.cfg.backoff_max_ms < s_cm.cfg.backoff_min_ms) s_cm.cfg.backoff_max_ms = def.backoff_max_ms;
+    if (s_cm.cfg.task_prio <= 0) s_cm.cfg.task_prio = def.task_prio;
+    if (s_cm.cfg.liveness_ms <= 0) {
+        int ping = rb3->ping_interval_ms > 0 ? rb3->ping_interval_ms : 10000;
+        int pong = rb3->pong_timeout_ms > 0 ? rb3->pong_timeout_ms : 4000;
+        s_cm.cfg.liveness_ms = ping + pong;
+    }
+
+    s_cm.lock = xSemaphoreCreateMutex();
+    ESP_RETURN_ON_FALSE(s_cm.lock, ESP_ERR_NO_MEM, TAG, "create lock failed");
+    s_cm.state = APP_RB3_CONN_CONNECTING;
+    s_cm.started = true;
+
+    if (xTaskCreate(task_connmgr, "task_rb3_conn", 4096, NULL, s_cm.cfg.task_prio, &s_cm.task) != pdPASS) {
+        vSemaphoreDelete(s_cm.lock);
+        s_cm.lock = NULL;
+        s_cm.started = false;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+void app_rb3_connmgr_stop(void)
+{
+    if (!s_cm.started) return;
+    s_cm.stop = true;
+    if (s_cm.task) xTaskNotifyGive(s_cm.task);
+    while (s_cm.task) vTaskDelay(pdMS_TO_TICKS(10));
+    vSemaphoreDelete(s_cm.lock);
+    s_cm.lock = NULL;
+    s_cm.started = false;
+}
+
+app_rb3_ws_sess_t *app_rb3_connmgr_acquire(int wait_ms)
+{
+    if (!s_cm.started) return NULL;
+    const uint32_t t0 = now_ms();
+    bool kicked = false;
+    for (;;) {
+        app_rb3_ws_sess_t *sess = NULL;
+        xSemaphoreTake(s_cm.lock, portMAX_DELAY);
+        if (s_cm.state == APP_RB3_CONN_READY && s_cm.primary && !s_cm.primary_broken &&
+            app_rb3_ws_is_connected(s_cm.primary)) {
+            sess = s_cm.primary;
+            s_cm.users++;
+        }
+        xSemaphoreGive(s_cm.lock);
+        if (sess) return sess;
+
+        if (!kicked) {
+            app_rb3_connmgr_kick();
+            kicked = true;
+        }
+        if ((int)(now_ms() - t0) >= wait_ms) return NULL;
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+void app_rb3_connmgr_release(app_rb3_ws_sess_t *sess, bool broken)
+{
+    if (!s_cm.started || !sess) return;
+    xSemaphoreTake(s_cm.lock, portMAX_DELAY);
+    if (sess == s_cm.primary) {
+        if (s_cm.users > 0) s_cm.users--;
+        if (broken) s_cm.primary_broken = true;
+    }
+    xSemaphoreGive(s_cm.lock);
+    if (broken && s_cm.task) xTaskNotifyGive(s_cm.task);
+}
+
+void app_rb3_connmgr_kick(void)
+{
+    if (!s_cm.started) return;
+    xSemaphoreTake(s_cm.lock, portMAX_DELAY);
+    s_cm.kick = true;
+    s_cm.paused = false;
+    s_cm.st.kicks++;
+    xSemaphoreGive(s_cm.lock);
+    if (s_cm.task) xTaskNotifyGive(s_cm.task);
+}
+
+void app_rb3_connmgr_set_paused(bool paused)
+{
+    if (!s_cm.started) return;
+    xSemaphoreTake(s_cm.lock, portMAX_DELAY);
+    s_cm.paused = paused;
+    if (!paused) s_cm.kick = true;
+    xSemaphoreGive(s_cm.lock);
+    if (s_cm.task) xTaskNotifyGive(s_cm.task);
+}
+
+void app_rb3_connmgr_get_stats(app_rb3_connmgr_stats_t *out)
+{
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!s_cm.started) return;
+    xSemaphoreTake(s_cm.lock, portMAX_DELAY);
+    *out = s_cm.st;
+    xSemaphoreGive(s_cm.lock);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#include "App_RobotBrainV3.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * WS 连接管理（后台任务）：建连/心跳/退避重连都不占用调用方任务。
+ *
+ *   PAUSED ──resume/kick──> CONNECTING ──连上──> READY
+ *      ^                        │ 失败/超时          │ 断开/心跳超时（未被借用时）
+ *      └──── pause ────         v                    v
+ *                            BACKOFF <──── 无备用连接 ┘（有备用则直接顶上，仍为 READY）
+ *
+ * 调用方按轮次借用主连接（acquire/release），借用期间管理器不会关闭它；
+ * 语音起点 kick() 跳过退避立即重连，调用方不等待，音频继续进环形缓冲。
+ */
+
+typedef enum {
+    APP_RB3_CONN_PAUSED = 0,    // 不保持连接（静默期）
+    APP_RB3_CONN_CONNECTING,
+    APP_RB3_CONN_READY,
+    APP_RB3_CONN_BACKOFF,
+} app_rb3_conn_state_t;
+
+typedef struct {
+    int connect_timeout_ms;     // 单次建连超时，默认 5000
+    int backoff_min_ms;         // 退避起点，默认 250（每次失败翻倍，带 ±25% 抖动）
+    int backoff_max_ms;         // 退避上限，默认 16000
+    int liveness_ms;            // 未借用时超过该时长没收到任何帧（含 pong）即判死，默认 ping+pong 超时
+    bool hot_standby;           // 额外保持一条已连接的备用会话，主连接断开时直接顶上
+    int task_prio;              // 默认 4
+
+    // 会话成为主连接时调用（设置回调、挂到事件缓存等）；主连接关闭前调用 on_down。均在管理器任务里执行
+    void (*on_up)(app_rb3_ws_sess_t *sess, void *ctx);
+    void (*on_down)(app_rb3_ws_sess_t *sess, void *ctx);
+    void *ctx;
+} app_rb3_connmgr_cfg_t;
+
+typedef struct {
+    app_rb3_conn_state_t state;
+    uint32_t connects;          // 建连成功次数（含备用）
+    uint32_t connect_fails;     // 建连失败/超时次数
+    uint32_t drops;             // 主连接断开/判死次数
+    uint32_t liveness_fails;    // 其中因心跳超时判死的次数
+    uint32_t standby_promotions;// 备用连接顶上的次数
+    uint32_t kicks;             // 语音起点触发的立即重连
+    uint32_t backoff_ms;        // 当前退避时长
+    uint32_t connect_ms_last;   // 最近一次建连耗时
+    uint32_t connect_ms_avg;
+} app_rb3_connmgr_stats_t;
+
+app_rb3_connmgr_cfg_t app_rb3_connmgr_cfg_default(void);
+
+/**
+ * @brief 启动管理器任务并开始建连（单例）
+ *
+ * @note rb3 里的字符串指针需保证生命周期（通常为常量）。
+ */
+esp_err_t app_rb3_connmgr_start(const app_rb3_cfg_t *rb3, const app_rb3_connmgr_cfg_t *cfg);
+void app_rb3_connmgr_stop(void);
+
+/**
+ * @brief 借用已连接的主会话；wait_ms=0 不等待。未就绪返回 NULL（并触发 kick）
+ */
+app_rb3_ws_sess_t *app_rb3_connmgr_acquire(int wait_ms);
+
+/**
+ * @brief 归还会话；broken=true 表示使用中发现连接已坏，由管理器关闭并切换/重连
+ */
+void app_rb3_connmgr_release(app_rb3_ws_sess_t *sess, bool broken);
+
+/**
+ * @brief 立即重连（跳过退避；PAUSED 时恢复），不阻塞
+ */
+void app_rb3_connmgr_kick(void);
+
+/**
+ * @brief 暂停（关闭空闲连接、不再重连）/ 恢复
+ */
+void app_rb3_connmgr_set_paused(bool paused);
+
+void app_rb3_connmgr_get_stats(app_rb3_connmgr_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,243 @@
+#include "App_Rb3Endpoint.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_check.h"
+#include "esp_http_client.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "App_Rb3Endpoint";
+
+typedef struct {
+    const char *url;
+    uint32_t rtt_ms;
+    uint32_t err_permille;
+    uint32_t consec_fails;
+    uint32_t probes;
+    uint32_t probe_fails;
+    uint32_t sess_fails;
+} ep_t;
+
+typedef struct {
+    portMUX_TYPE lock;
+    app_rb3_ep_cfg_t cfg;
+    ep_t ep[APP_RB3_EP_MAX];
+    int count;
+    int cur;
+    bool started;
+    volatile bool stop;
+    TaskHandle_t task;
+} ep_ctx_t;
+
+static ep_ctx_t s_ep = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+app_rb3_ep_cfg_t app_rb3_ep_cfg_default(void)
+{
+    app_rb3_ep_cfg_t c = {
+        .probe_interval_ms = 5000,
+        .probe_timeout_ms = 2000,
+        .health_path = "/health",
+        .switch_margin_pct = 20,
+        .task_prio = 3,
+    };
+    return c;
+}
+
+// 调用方需持锁
+static uint32_t ep_score(const ep_t *e)
+{
+    uint32_t rtt = e->rtt_ms ? e->rtt_ms : (uint32_t)s_ep.cfg.probe_timeout_ms;
+    uint32_t s = (uint32_t)(((uint64_t)rtt * (1000 + 4 * e->err_permille)) / 1000);
+    return s + e->consec_fails * (uint32_t)s_ep.cfg.probe_timeout_ms;
+}
+
+// 调用方需持锁
+static void ep_update(ep_t *e, bool ok, uint32_t rtt_ms)
+{
+    e->err_permille = (e->err_permille * 7 + (ok ? 0 : 1000)) / 8;
+    if (ok) {
+        e->consec_fails = 0;
+        if (rtt_ms) e->rtt_ms = e->rtt_ms ? (e->rtt_ms * 7 + rtt_ms) / 8 : rtt_ms;
+    } else {
+        e->consec_fails++;
+    }
+}
+
+static void ep_probe_one(int idx)
+{
+    char url[256];
+    int n = snprintf(url, sizeof(url), "%s%s", s_ep.ep[idx].url, s_ep.cfg.health_path);
+    if (n <= 0 || n >= (int)sizeof(url)) return;
+
+    esp_http_client_config_t c = {
+        .url = url,
+        .method = HTTP_METHOD_GET,
+        .timeout_ms = s_ep.cfg.probe_timeout_ms,
+        .disable_auto_redirect = true,
+        .transport_type = (strncmp(url, "https://", 8) == 0) ? HTTP_TRANSPORT_OVER_SSL : HTTP_TRANSPORT_OVER_TCP,
+    };
+    int64_t t0 = esp_timer_get_time();
+    esp_http_client_handle_t h = esp_http_client_init(&c);
+    if (!h) return;
+    esp_err_t ret = esp_http_client_perform(h);
+    int status = esp_http_client_get_status_code(h);
+    esp_http_client_cleanup(h);
+    uint32_t rtt = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+    bool ok = (ret == ESP_OK && status >= 200 && status < 300);
+    if (ok && rtt == 0) rtt = 1;
+
+    portENTER_CRITICAL(&s_ep.lock);
+    ep_t *e = &s_ep.ep[idx];
+    e->probes++;
+    if (!ok) e->probe_fails++;
+    ep_update(e, ok, ok ? rtt : 0);
+    portEXIT_CRITICAL(&s_ep.lock);
+
+    if (!ok) {
+        ESP_LOGW(TAG, "probe %s failed: %s status=%d", s_ep.ep[idx].url, esp_err_to_name(ret), status);
+    } else {
+        ESP_LOGD(TAG, "probe %s rtt=%" PRIu32 "ms", s_ep.ep[idx].url, rtt);
+    }
+}
+
+static void task_ep_probe(void *arg)
+{
+    (void)arg;
+    while (!s_ep.stop) {
+        for (int i = 0; i < s_ep.count && !s_ep.stop; ++i) {
+            ep_probe_one(i);
+        }
+        (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(s_ep.cfg.probe_interval_ms));
+    }
+    s_ep.task = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t app_rb3_ep_start(const char *const *urls, int count, const app_rb3_ep_cfg_t *cfg)
+{
+    ESP_RETURN_ON_FALSE(urls && count > 0, ESP_ERR_INVALID_ARG, TAG, "no endpoints");
+    ESP_RETURN_ON_FALSE(!s_ep.started, ESP_ERR_INVALID_STATE, TAG, "already started");
+    if (count > APP_RB3_EP_MAX) {
+        ESP_LOGW(TAG, "too many endpoints (%d), only first %d used", count, APP_RB3_EP_MAX);
+        count = APP_RB3_EP_MAX;
+    }
+
+    app_rb3_ep_cfg_t def = app_rb3_ep_cfg_default();
+    app_rb3_ep_cfg_t c = cfg ? *cfg : def;
+    if (c.probe_interval_ms <= 0) c.probe_interval_ms = def.probe_interval_ms;
+    if (c.probe_timeout_ms <= 0) c.probe_timeout_ms = def.probe_timeout_ms;
+    if (!c.health_path) c.health_path = def.health_path;
+    if (c.switch_margin_pct < 0) c.switch_margin_pct = def.switch_margin_pct;
+    if (c.task_prio <= 0) c.task_prio = def.task_prio;
+
+    portENTER_CRITICAL(&s_ep.lock);
+    if (s_ep.started) {
+        portEXIT_CRITICAL(&s_ep.lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_ep.cfg = c;
+    memset(s_ep.ep, 0, sizeof(s_ep.ep));
+    for (int i = 0; i < count; ++i) s_ep.ep[i].url = urls[i];
+    s_ep.count = count;
+    s_ep.cur = 0;
+    s_ep.stop = false;
+    s_ep.started = true;
+    portEXIT_CRITICAL(&s_ep.lock);
+
+    if (count > 1 &&
+        xTaskCreate(task_ep_probe, "task_rb3_ep", 4096, NULL, c.task_prio, &s_ep.task) != pdPASS) {
+        ESP_LOGW(TAG, "probe task create failed, routing by session feedback only");
+    }
+    ESP_LOGI(TAG, "%d endpoint(s), first=%s", count, urls[0]);
+    return ESP_OK;
+}
+
+void app_rb3_ep_stop(void)
+{
+    if (!s_ep.started) return;
+    s_ep.stop = true;
+    if (s_ep.task) xTaskNotifyGive(s_ep.task);
+    while (s_ep.task) vTaskDelay(pdMS_TO_TICKS(10));
+    portENTER_CRITICAL(&s_ep.lock);
+    s_ep.started = false;
+    s_ep.count = 0;
+    portEXIT_CRITICAL(&s_ep.lock);
+}
+
+int app_rb3_ep_pick(const char **out_url)
+{
+    if (out_url) *out_url = NULL;
+    if (!s_ep.started) return -1;
+
+    int prev, cur;
+    portENTER_CRITICAL(&s_ep.lock);
+    prev = cur = s_ep.cur;
+    int best = 0;
+    uint32_t best_score = ep_score(&s_ep.ep[0]);
+    for (int i = 1; i < s_ep.count; ++i) {
+        uint32_t sc = ep_score(&s_ep.ep[i]);
+        if (sc < best_score) {
+            best = i;
+            best_score = sc;
+        }
+    }
+    // 当前端点不健康就直接切；否则要明显更好才切
+    uint32_t cur_score = ep_score(&s_ep.ep[cur]);
+    if (s_ep.ep[cur].consec_fails >= 2 ||
+        (uint64_t)best_score * (100 + (uint32_t)s_ep.cfg.switch_margin_pct) < (uint64_t)cur_score * 100) {
+        cur = best;
+    }
+    s_ep.cur = cur;
+    const char *url = s_ep.ep[cur].url;
+    portEXIT_CRITICAL(&s_ep.lock);
+
+    if (cur != prev) {
+        ESP_LOGI(TAG, "route %s -> %s (score %" PRIu32 " -> %" PRIu32 ")", s_ep.ep[prev].url, url, cur_score,
+                 best_score);
+    }
+    if (out_url) *out_url = url;
+    return cur;
+}
+
+void app_rb3_ep_report(int idx, bool ok)
+{
+    if (!s_ep.started || idx < 0 || idx >= s_ep.count) return;
+    portENTER_CRITICAL(&s_ep.lock);
+    ep_t *e = &s_ep.ep[idx];
+    if (!ok) e->sess_fails++;
+    ep_update(e, ok, 0);
+    portEXIT_CRITICAL(&s_ep.lock);
+    // 失败后尽快补测一轮，让分数反映真实情况
+    if (!ok && s_ep.task) xTaskNotifyGive(s_ep.task);
+}
+
+int app_rb3_ep_get_stats(app_rb3_ep_stats_t *out, int max)
+{
+    if (!out || max <= 0 || !s_ep.started) return 0;
+    portENTER_CRITICAL(&s_ep.lock);
+    int n = s_ep.count < max ? s_ep.count : max;
+    for (int i = 0; i < n; ++i) {
+        const ep_t *e = &s_ep.ep[i];
+        out[i] = (app_rb3_ep_stats_t){
+            .url = e->url,
+            .healthy = e->consec_fails < 2,
+            .current = (i == s_ep.cur),
+            .rtt_ms = e->rtt_ms,
+            .err_permille = e->err_permille,
+            .probes = e->probes,
+            .probe_fails = e->probe_fails,
+            .sess_fails = e->sess_fails,
+            .score = ep_score(e),
+        };
+    }
+    portEXIT_CRITICAL(&s_ep.lock);
+    return n;
+}
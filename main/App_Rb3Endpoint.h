@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 多服务端选择（单例）：后台定期 GET <base_url>/health，维护每个端点的 RTT 与错误率（EWMA），
+ * 新会话路由到分数最低的端点；会话层的建连失败/中途断开也计入错误率，
+ * 因此当前端点出问题后，下一次重连自然切到次优端点（故障转移）。
+ *
+ *   score = rtt_ms * (1 + 4 * err) + 连续失败次数 * probe_timeout_ms
+ *
+ * 切换带滞回：新端点须比当前好 switch_margin_pct 以上才切，避免在相近端点间来回跳。
+ */
+
+#define APP_RB3_EP_MAX 4
+
+typedef struct {
+    int probe_interval_ms;      // 每轮探测间隔，默认 5000（只有一个端点时不探测）
+    int probe_timeout_ms;       // 单次探测超时，默认 2000；未测过的端点按该值估 RTT
+    const char *health_path;    // 默认 "/health"
+    int switch_margin_pct;      // 默认 20
+    int task_prio;              // 默认 3
+} app_rb3_ep_cfg_t;
+
+typedef struct {
+    const char *url;
+    bool healthy;               // 连续失败 < 2
+    bool current;               // 当前路由目标
+    uint32_t rtt_ms;            // EWMA，0 表示还没测过
+    uint32_t err_permille;      // 错误率 EWMA（探测 + 会话）
+    uint32_t probes;
+    uint32_t probe_fails;
+    uint32_t sess_fails;        // 会话建连失败/中途断开
+    uint32_t score;
+} app_rb3_ep_stats_t;
+
+app_rb3_ep_cfg_t app_rb3_ep_cfg_default(void);
+
+/**
+ * @brief 设置端点表并启动探测任务；url 字符串需保证生命周期（通常为常量）
+ *
+ * @note 已启动时返回 ESP_ERR_INVALID_STATE（App_RobotBrainV3 首次用到端点列表时会按默认配置启动）。
+ */
+esp_err_t app_rb3_ep_start(const char *const *urls, int count, const app_rb3_ep_cfg_t *cfg);
+void app_rb3_ep_stop(void);
+
+/**
+ * @brief 选出当前最优端点；未启动返回 -1
+ */
+int app_rb3_ep_pick(const char **out_url);
+
+/**
+ * @brief 会话层反馈：ok=true 为建连成功，false 为建连失败/中途断开
+ */
+void app_rb3_ep_report(int idx, bool ok);
+
+/**
+ * @brief 导出各端点状态，返回端点数
+ */
+int app_rb3_ep_get_stats(app_rb3_ep_stats_t *out, int max);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,475 @@
+#include "App_Rb3Json.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#define BIT_F(f) (1u << (f))
+
+// 各消息类型允许的字段（解析后按此过滤；未知类型不过滤，兼容 HTTP 回复）
+static const uint32_t k_type_fields[] = {
+    [APP_RB3_MSG_UNKNOWN] = 0xFFFFFFFFu,
+    [APP_RB3_MSG_META] = BIT_F(APP_RB3_F_TYPE) | BIT_F(APP_RB3_F_REQ) | BIT_F(APP_RB3_F_RID) | BIT_F(APP_RB3_F_ANIM) |
+                         BIT_F(APP_RB3_F_MOTION) | BIT_F(APP_RB3_F_AF) | BIT_F(APP_RB3_F_VERSION) |
+                         BIT_F(APP_RB3_F_SEQ),
+    [APP_RB3_MSG_AUDIO] = BIT_F(APP_RB3_F_TYPE) | BIT_F(APP_RB3_F_REQ) | BIT_F(APP_RB3_F_RID) |
+                          BIT_F(APP_RB3_F_CHUNK) | BIT_F(APP_RB3_F_IS_LAST) | BIT_F(APP_RB3_F_SEQ),
+    [APP_RB3_MSG_ASR_TEXT] = BIT_F(APP_RB3_F_TYPE) | BIT_F(APP_RB3_F_REQ) | BIT_F(APP_RB3_F_RID) |
+                             BIT_F(APP_RB3_F_TEXT) | BIT_F(APP_RB3_F_SEQ),
+    [APP_RB3_MSG_TEXT_DELTA] = BIT_F(APP_RB3_F_TYPE) | BIT_F(APP_RB3_F_REQ) | BIT_F(APP_RB3_F_RID) |
+                               BIT_F(APP_RB3_F_TEXT) | BIT_F(APP_RB3_F_SEQ),
+    [APP_RB3_MSG_TEXT] = BIT_F(APP_RB3_F_TYPE) | BIT_F(APP_RB3_F_REQ) | BIT_F(APP_RB3_F_RID) | BIT_F(APP_RB3_F_TEXT) |
+                         BIT_F(APP_RB3_F_SEQ),
+    [APP_RB3_MSG_ERROR] = BIT_F(APP_RB3_F_TYPE) | BIT_F(APP_RB3_F_REQ) | BIT_F(APP_RB3_F_RID) |
+                          BIT_F(APP_RB3_F_MESSAGE),
+};
+
+#define F_NONE (-1)
+#define F_META_OBJ (-2)
+
+static inline bool key_is(const char *k, size_t n, const char *lit, size_t lit_n)
+{
+    return n == lit_n && memcmp(k, lit, n) == 0;
+}
+
+// 按长度分派的字段表：每个 key 最多 2~3 次 memcmp
+static int field_lookup(const char *k, size_t n)
+{
+    switch (n) {
+    case 2:
+        if (key_is(k, n, "af", 2)) return APP_RB3_F_AF;
+        break;
+    case 3:
+        if (key_is(k, n, "req", 3)) return APP_RB3_F_REQ;
+        if (key_is(k, n, "rid", 3)) return APP_RB3_F_RID;
+        if (key_is(k, n, "seq", 3)) return APP_RB3_F_SEQ;
+        break;
+    case 4:
+        if (key_is(k, n, "type", 4)) return APP_RB3_F_TYPE;
+        if (key_is(k, n, "text", 4)) return APP_RB3_F_TEXT;
+        if (key_is(k, n, "anim", 4)) return APP_RB3_F_ANIM;
+        if (key_is(k, n, "meta", 4)) return F_META_OBJ;
+        break;
+    case 5:
+        if (key_is(k, n, "chunk", 5)) return APP_RB3_F_CHUNK;
+        if (key_is(k, n, "audio", 5)) return APP_RB3_F_AUDIO;
+        break;
+    case 6:
+        if (key_is(k, n, "motion", 6)) return APP_RB3_F_MOTION;
+        break;
+    case 7:
+        if (key_is(k, n, "is_last", 7)) return APP_RB3_F_IS_LAST;
+        if (key_is(k, n, "version", 7)) return APP_RB3_F_VERSION;
+        if (key_is(k, n, "message", 7)) return APP_RB3_F_MESSAGE;
+        break;
+    default:
+        break;
+    }
+    return F_NONE;
+}
+
+static app_rb3_msg_type_t type_lookup(const char *t, size_t n)
+{
+    switch (n) {
+    case 4:
+        if (key_is(t, n, "meta", 4)) return APP_RB3_MSG_META;
+        if (key_is(t, n, "text", 4)) return APP_RB3_MSG_TEXT;
+        break;
+    case 5:
+        if (key_is(t, n, "audio", 5)) return APP_RB3_MSG_AUDIO;
+        if (key_is(t, n, "error", 5)) return APP_RB3_MSG_ERROR;
+        break;
+    case 8:
+        if (key_is(t, n, "asr_text", 8)) return APP_RB3_MSG_ASR_TEXT;
+        break;
+    case 10:
+        if (key_is(t, n, "text_delta", 10)) return APP_RB3_MSG_TEXT_DELTA;
+        break;
+    default:
+        break;
+    }
+    return APP_RB3_MSG_UNKNOWN;
+}
+
+typedef struct {
+    const char *p;
+    const char *end;
+    bool inplace;
+} jp_t;
+
+static inline void skip_ws(jp_t *j)
+{
+    while (j->p < j->end && (*j->p == ' ' || *j->p == '\t' || *j->p == '\r' || *j->p == '\n')) j->p++;
+}
+
+static int hex4(const char *s)
+{
+    int v = 0;
+    for (int i = 0; i < 4; ++i) {
+        char c = s[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= c - '0';
+        else if (c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v |= c - 'A' + 10;
+        else return -1;
+    }
+    return v;
+}
+
+static char *put_utf8(char *w, uint32_t cp)
+{
+    if (cp < 0x80) {
+        *w++ = (char)cp;
+    } else if (cp < 0x800) {
+        *w++ = (char)(0xC0 | (cp >> 6));
+        *w++ = (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        *w++ = (char)(0xE0 | (cp >> 12));
+        *w++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *w++ = (char)(0x80 | (cp & 0x3F));
+    } else {
+        *w++ = (char)(0xF0 | (cp >> 18));
+        *w++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+        *w++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *w++ = (char)(0x80 | (cp & 0x3F));
+    }
+    return w;
+}
+
+// j->p 指向开引号；结束后指向闭引号之后。out 可为 NULL（跳过）。
+// 原地模式：反转义写回原缓冲（输出不长于输入），末尾补 '\0'
+static bool parse_string(jp_t *j, app_rb3_str_t *out)
+{
+    if (j->p >= j->end || *j->p != '"') return false;
+    const char *start = ++j->p;
+    const bool write = j->inplace && out;
+    char *w = (char *)start;
+
+    while (j->p < j->end) {
+        // 快路径：无转义的连续片段（audio 的 base64 整段都走这里，用 memchr 按字扫描）
+        const char *q = (const char *)memchr(j->p, '"', (size_t)(j->end - j->p));
+        if (!q) return false;
+        const char *bs = (const char *)memchr(j->p, '\\', (size_t)(q - j->p));
+        if (bs) q = bs;
+        if (write && w != j->p) memmove(w, j->p, (size_t)(q - j->p));
+        w += q - j->p;
+        j->p = q;
+
+        if (*q == '"') {
+            if (out) {
+                out->p = start;
+                out->len = (size_t)(w - start);
+                if (write) *w = '\0';
+            }
+            j->p++;
+            return true;
+        }
+
+        // 转义
+        if (q + 1 >= j->end) return false;
+        char e = q[1];
+        j->p = q + 2;
+        if (!write) {
+            if (e == 'u') {
+                if (j->end - j->p < 4) return false;
+                j->p += 4;
+            }
+            w = (char *)j->p;
+            continue;
+        }
+        switch (e) {
+        case '"': *w++ = '"'; break;
+        case '\\': *w++ = '\\'; break;
+        case '/': *w++ = '/'; break;
+        case 'b': *w++ = '\b'; break;
+        case 'f': *w++ = '\f'; break;
+        case 'n': *w++ = '\n'; break;
+        case 'r': *w++ = '\r'; break;
+        case 't': *w++ = '\t'; break;
+        case 'u': {
+            if (j->end - j->p < 4) return false;
+            int cp = hex4(j->p);
+            j->p += 4;
+            if (cp < 0) {
+                *w++ = '?';
+                break;
+            }
+            // 代理对
+            if (cp >= 0xD800 && cp <= 0xDBFF && j->end - j->p >= 6 && j->p[0] == '\\' && j->p[1] == 'u') {
+                int lo = hex4(j->p + 2);
+                if (lo >= 0xDC00 && lo <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    j->p += 6;
+                }
+            }
+            if (cp >= 0xD800 && cp <= 0xDFFF) cp = '?';
+            w = put_utf8(w, (uint32_t)cp);
+            break;
+        }
+        default:
+            *w++ = e;
+            break;
+        }
+    }
+    return false;
+}
+
+// 跳过任意值（字符串/对象/数组/字面量），不改写输入
+static bool skip_value(jp_t *j)
+{
+    if (j->p >= j->end) return false;
+    char c = *j->p;
+    if (c == '"') {
+        bool saved = j->inplace;
+        j->inplace = false;
+        bool ok = parse_string(j, NULL);
+        j->inplace = saved;
+        return ok;
+    }
+    if (c == '{' || c == '[') {
+        int depth = 0;
+        while (j->p < j->end) {
+            c = *j->p;
+            if (c == '"') {
+                bool saved = j->inplace;
+                j->inplace = false;
+                bool ok = parse_string(j, NULL);
+                j->inplace = saved;
+                if (!ok) return false;
+                continue;
+            }
+            if (c == '{' || c == '[') depth++;
+            else if (c == '}' || c == ']') {
+                if (--depth == 0) {
+                    j->p++;
+                    return true;
+                }
+            }
+            j->p++;
+        }
+        return false;
+    }
+    while (j->p < j->end && *j->p != ',' && *j->p != '}' && *j->p != ']' && *j->p != ' ' && *j->p != '\r' &&
+           *j->p != '\n' && *j->p != '\t') {
+        j->p++;
+    }
+    return true;
+}
+
+static bool parse_object(jp_t *j, app_rb3_msg_t *m, int depth)
+{
+    skip_ws(j);
+    if (j->p >= j->end || *j->p != '{') return false;
+    j->p++;
+
+    for (;;) {
+        skip_ws(j);
+        if (j->p >= j->end) return false;
+        if (*j->p == '}') {
+            j->p++;
+            return true;
+        }
+
+        // key：只读方式取原始片段（协议 key 不含转义）
+        app_rb3_str_t key;
+        bool saved = j->inplace;
+        j->inplace = false;
+        bool ok = parse_string(j, &key);
+        j->inplace = saved;
+        if (!ok) return false;
+
+        skip_ws(j);
+        if (j->p >= j->end || *j->p != ':') return false;
+        j->p++;
+        skip_ws(j);
+        if (j->p >= j->end) return false;
+
+        int f = field_lookup(key.p, key.len);
+        const char c = *j->p;
+        if (f == F_META_OBJ && c == '{' && depth == 0) {
+            if (!parse_object(j, m, depth + 1)) return false;
+        } else if (f == APP_RB3_F_AUDIO && c == '[') {
+            const char *s = j->p;
+            if (!skip_value(j)) return false;
+            m->str[f].p = s;
+            m->str[f].len = (size_t)(j->p - s);
+            m->present |= BIT_F(f);
+        } else if (f == APP_RB3_F_IS_LAST) {
+            m->is_last = (c == 't');
+            m->present |= BIT_F(f);
+            if (!skip_value(j)) return false;
+        } else if (f == APP_RB3_F_SEQ && (c == '-' || (c >= '0' && c <= '9'))) {
+            int64_t v = 0;
+            bool neg = (c == '-');
+            if (neg) j->p++;
+            while (j->p < j->end && *j->p >= '0' && *j->p <= '9') v = v * 10 + (*j->p++ - '0');
+            m->seq = neg ? -v : v;
+            m->present |= BIT_F(f);
+        } else if (f >= 0 && c == '"') {
+            if (!parse_string(j, &m->str[f])) return false;
+            m->present |= BIT_F(f);
+        } else {
+            if (!skip_value(j)) return false;
+        }
+
+        skip_ws(j);
+        if (j->p >= j->end) return false;
+        if (*j->p == ',') {
+            j->p++;
+        } else if (*j->p != '}') {
+            return false;
+        }
+    }
+}
+
+static esp_err_t parse_common(jp_t *j, const char *base, app_rb3_msg_t *out, size_t *consumed)
+{
+    memset(out, 0, sizeof(*out));
+    skip_ws(j);
+    if (!parse_object(j, out, 0)) return ESP_ERR_INVALID_RESPONSE;
+    if (consumed) *consumed = (size_t)(j->p - base);
+
+    if (APP_RB3_HAS(out, APP_RB3_F_TYPE)) {
+        out->type = type_lookup(out->str[APP_RB3_F_TYPE].p, out->str[APP_RB3_F_TYPE].len);
+    }
+    // 按类型字段表过滤：其它类型的字段即使出现也不认
+    uint32_t allowed = k_type_fields[out->type];
+    for (int f = 0; f < APP_RB3_F_COUNT; ++f) {
+        if ((out->present & BIT_F(f)) && !(allowed & BIT_F(f))) {
+            out->str[f].p = NULL;
+            out->str[f].len = 0;
+        }
+    }
+    out->present &= allowed;
+    if (!APP_RB3_HAS(out, APP_RB3_F_IS_LAST)) out->is_last = false;
+    return ESP_OK;
+}
+
+esp_err_t app_rb3_json_parse(char *json, size_t len, app_rb3_msg_t *out, size_t *consumed)
+{
+    if (!json || !out) return ESP_ERR_INVALID_ARG;
+    jp_t j = {.p = json, .end = json + len, .inplace = true};
+    return parse_common(&j, json, out, consumed);
+}
+
+esp_err_t app_rb3_json_parse_ro(const char *json, size_t len, app_rb3_msg_t *out)
+{
+    if (!json || !out) return ESP_ERR_INVALID_ARG;
+    jp_t j = {.p = json, .end = json + len, .inplace = false};
+    return parse_common(&j, json, out, NULL);
+}
+
+void app_rb3_json_copy(char *dst, size_t dst_sz, const app_rb3_msg_t *m, app_rb3_field_t f)
+{
+    if (!dst || dst_sz == 0) return;
+    dst[0] = '\0';
+    if (!m || f >= APP_RB3_F_COUNT || !m->str[f].p) return;
+    size_t n = m->str[f].len;
+    if (n >= dst_sz) {
+        n = dst_sz - 1;
+        // 不在 UTF-8 多字节字符中间截断
+        while (n > 0 && ((uint8_t)m->str[f].p[n] & 0xC0) == 0x80) n--;
+    }
+    memcpy(dst, m->str[f].p, n);
+    dst[n] = '\0';
+}
+
+// ---------------------------------------------------------------------------------------------
+// writer
+
+static void jw_put(app_rb3_jw_t *w, const char *s, size_t n)
+{
+    if (w->overflow) return;
+    if (w->len + n >= w->cap) { // 留 1 字节给 '\0'
+        w->overflow = true;
+        return;
+    }
+    memcpy(w->buf + w->len, s, n);
+    w->len += n;
+}
+
+static void jw_escaped(app_rb3_jw_t *w, const char *s, size_t n)
+{
+    jw_put(w, "\"", 1);
+    size_t run = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint8_t c = (uint8_t)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        jw_put(w, s + run, i - run);
+        run = i + 1;
+        char esc[8];
+        switch (c) {
+        case '"': jw_put(w, "\\\"", 2); break;
+        case '\\': jw_put(w, "\\\\", 2); break;
+        case '\n': jw_put(w, "\\n", 2); break;
+        case '\r': jw_put(w, "\\r", 2); break;
+        case '\t': jw_put(w, "\\t", 2); break;
+        case '\b': jw_put(w, "\\b", 2); break;
+        case '\f': jw_put(w, "\\f", 2); break;
+        default:
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            jw_put(w, esc, 6);
+            break;
+        }
+    }
+    jw_put(w, s + run, n - run);
+    jw_put(w, "\"", 1);
+}
+
+static void jw_key(app_rb3_jw_t *w, const char *key)
+{
+    if (w->need_comma) jw_put(w, ",", 1);
+    w->need_comma = true;
+    jw_escaped(w, key, strlen(key));
+    jw_put(w, ":", 1);
+}
+
+void app_rb3_jw_begin(app_rb3_jw_t *w, char *buf, size_t cap)
+{
+    w->buf = buf;
+    w->cap = cap;
+    w->len = 0;
+    w->overflow = (buf == NULL || cap == 0);
+    w->need_comma = false;
+    jw_put(w, "{", 1);
+}
+
+void app_rb3_jw_strn(app_rb3_jw_t *w, const char *key, const char *val, size_t len)
+{
+    if (!val) return;
+    jw_key(w, key);
+    jw_escaped(w, val, len);
+}
+
+void app_rb3_jw_str(app_rb3_jw_t *w, const char *key, const char *val)
+{
+    if (!val) return;
+    app_rb3_jw_strn(w, key, val, strlen(val));
+}
+
+void app_rb3_jw_int(app_rb3_jw_t *w, const char *key, int64_t val)
+{
+    char num[24];
+    int n = snprintf(num, sizeof(num), "%" PRId64, val);
+    jw_key(w, key);
+    jw_put(w, num, (size_t)n);
+}
+
+void app_rb3_jw_bool(app_rb3_jw_t *w, const char *key, bool val)
+{
+    jw_key(w, key);
+    if (val) {
+        jw_put(w, "true", 4);
+    } else {
+        jw_put(w, "false", 5);
+    }
+}
+
+esp_err_t app_rb3_jw_end(app_rb3_jw_t *w, size_t *out_len)
+{
+    jw_put(w, "}", 1);
+    if (w->overflow) return ESP_ERR_INVALID_SIZE;
+    w->buf[w->len] = '\0';
+    if (out_len) *out_len = w->len;
+    return ESP_OK;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * v3 协议 JSON 编解码（单遍、零分配）
+ *
+ * 解析：一次扫描顶层对象，按预置字段表识别 key，所有字段一次取出；
+ *       嵌套对象/数组整体跳过（"meta" 子对象除外，按同一张表展开一层），
+ *       因此 text 里出现 "rid" 之类的内容不会被误匹配。
+ * 编码：扁平对象写入调用方缓冲，字符串按 JSON 规则转义，溢出返回错误而不截断。
+ * 主机上用录下的 WS 帧回放校验/计时：tools/rb3_json_bench.c（录制见 tools/rb3_capture.py）。
+ */
+
+typedef enum {
+    APP_RB3_MSG_UNKNOWN = 0,
+    APP_RB3_MSG_META,
+    APP_RB3_MSG_AUDIO,
+    APP_RB3_MSG_ASR_TEXT,
+    APP_RB3_MSG_TEXT_DELTA,
+    APP_RB3_MSG_TEXT,
+    APP_RB3_MSG_ERROR,
+} app_rb3_msg_type_t;
+
+typedef enum {
+    APP_RB3_F_TYPE = 0,
+    APP_RB3_F_REQ,
+    APP_RB3_F_RID,
+    APP_RB3_F_ANIM,
+    APP_RB3_F_MOTION,
+    APP_RB3_F_AF,
+    APP_RB3_F_TEXT,
+    APP_RB3_F_CHUNK,
+    APP_RB3_F_IS_LAST,
+    APP_RB3_F_VERSION,
+    APP_RB3_F_SEQ,
+    APP_RB3_F_AUDIO,   // HTTP 回复里的 "audio" 数组（原始片段）
+    APP_RB3_F_MESSAGE, // error 消息
+    APP_RB3_F_COUNT,
+} app_rb3_field_t;
+
+typedef struct {
+    const char *p; // 原地解析时已反转义并以 '\0' 结尾；只读解析时为原始片段
+    size_t len;
+} app_rb3_str_t;
+
+typedef struct {
+    app_rb3_msg_type_t type;
+    uint32_t present; // (1u << app_rb3_field_t) 位图：已按消息类型的字段表过滤
+    app_rb3_str_t str[APP_RB3_F_COUNT];
+    bool is_last;
+    int64_t seq;
+} app_rb3_msg_t;
+
+#define APP_RB3_HAS(m, f) (((m)->present >> (f)) & 1u)
+
+/**
+ * @brief 原地解析一条消息（字符串就地反转义，json 会被改写）
+ *
+ * @param consumed 可为 NULL；返回对象结束后的偏移（用于数组内逐个解析）
+ */
+esp_err_t app_rb3_json_parse(char *json, size_t len, app_rb3_msg_t *out, size_t *consumed);
+
+/**
+ * @brief 只读解析（不改写输入，字符串为原始片段、不反转义），用于入队前的轻量检查
+ */
+esp_err_t app_rb3_json_parse_ro(const char *json, size_t len, app_rb3_msg_t *out);
+
+/**
+ * @brief 复制字符串字段到定长缓冲（截断时保证 UTF-8 完整、以 '\0' 结尾）
+ */
+void app_rb3_json_copy(char *dst, size_t dst_sz, const app_rb3_msg_t *m, app_rb3_field_t f);
+
+typedef struct {
+    char *buf;
+    size_t cap;
+    size_t len;
+    bool overflow;
+    bool need_comma;
+} app_rb3_jw_t;
+
+void app_rb3_jw_begin(app_rb3_jw_t *w, char *buf, size_t cap);
+void app_rb3_jw_str(app_rb3_jw_t *w, const char *key, const char *val); // val 为 NULL 时跳过该字段
+void app_rb3_jw_strn(app_rb3_jw_t *w, const char *key, const char *val, size_t len);
+void app_rb3_jw_int(app_rb3_jw_t *w, const char *key, int64_t val);
+void app_rb3_jw_bool(app_rb3_jw_t *w, const char *key, bool val);
+
+/**
+ * @brief 结束对象并补 '\0'；缓冲不足返回 ESP_ERR_INVALID_SIZE
+ */
+esp_err_t app_rb3_jw_end(app_rb3_jw_t *w, size_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
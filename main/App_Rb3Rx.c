@@ -0,0 +1,279 @@
+#include "App_Rb3Rx.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static bool span_eq(const app_rb3_str_t *s, const char *c)
+{
+    size_t n = strlen(c);
+    return s->p && s->len == n && memcmp(s->p, c, n) == 0;
+}
+
+static void copy_id(char *dst, size_t cap, const char *src)
+{
+    size_t n = src ? strlen(src) : 0;
+    if (n >= cap) n = cap - 1;
+    if (n) memcpy(dst, src, n);
+    dst[n] = '\0';
+}
+
+// 摘下队列与暂存里的全部消息，串成一条链返回
+static app_rb3_rx_msg_t *req_detach(app_rb3_rx_req_t *q)
+{
+    app_rb3_rx_msg_t *chain = q->head;
+    for (int i = 0; i < q->npend; ++i) {
+        q->pend[i].msg->next = chain;
+        chain = q->pend[i].msg;
+    }
+    q->head = q->tail = NULL;
+    q->bytes = 0;
+    q->npend = 0;
+    return chain;
+}
+
+void app_rb3_rx_free_chain(app_rb3_rx_msg_t *chain)
+{
+    while (chain) {
+        app_rb3_rx_msg_t *next = chain->next;
+        free(chain);
+        chain = next;
+    }
+}
+
+void app_rb3_rx_init(app_rb3_rx_t *rx, size_t window_bytes)
+{
+    memset(rx, 0, sizeof(*rx));
+    rx->window = window_bytes;
+}
+
+void app_rb3_rx_deinit(app_rb3_rx_t *rx)
+{
+    for (int i = 0; i < APP_RB3_RX_SLOTS; ++i) {
+        app_rb3_rx_free_chain(req_detach(&rx->req[i]));
+        rx->req[i].open = false;
+    }
+}
+
+int app_rb3_rx_open(app_rb3_rx_t *rx, const char *req, bool voice)
+{
+    if (req && strlen(req) >= APP_RB3_RX_REQ_LEN) return -1;
+    if (!voice && (!req || !req[0])) return -1;
+
+    int slot = -1;
+    if (voice) {
+        if (rx->req[APP_RB3_RX_VOICE].open) return -1;
+        slot = APP_RB3_RX_VOICE;
+    } else {
+        for (int i = 0; i < APP_RB3_RX_MAX_REQ; ++i) {
+            if (!rx->req[i].open) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot < 0) return -1;
+    }
+
+    app_rb3_rx_req_t *q = &rx->req[slot];
+    q->open = true;
+    q->down = false;
+    q->overflowed = false;
+    q->overflow_msgs = 0;
+    q->window = rx->window;
+    q->next_seq = -1;
+    copy_id(q->req, sizeof(q->req), req);
+
+    // 同一个 req 被重新使用（如自检固定 req）：从 retired 里移除，否则会被当成残余丢掉
+    if (q->req[0]) {
+        for (int i = 0; i < APP_RB3_RX_RETIRED_MAX; ++i) {
+            if (strcmp(rx->retired[i].req, q->req) == 0) {
+                rx->retired[i].req[0] = '\0';
+                rx->retired[i].rid[0] = '\0';
+            }
+        }
+    }
+    return slot;
+}
+
+void app_rb3_rx_retire(app_rb3_rx_t *rx, const char *req, const char *rid)
+{
+    if ((!req || !req[0]) && (!rid || !rid[0])) return;
+    int i = rx->retired_next;
+    rx->retired_next = (i + 1) % APP_RB3_RX_RETIRED_MAX;
+    copy_id(rx->retired[i].req, sizeof(rx->retired[i].req), req);
+    copy_id(rx->retired[i].rid, sizeof(rx->retired[i].rid), rid);
+}
+
+app_rb3_rx_msg_t *app_rb3_rx_close(app_rb3_rx_t *rx, int slot, const char *rid)
+{
+    if (slot < 0 || slot >= APP_RB3_RX_SLOTS || !rx->req[slot].open) return NULL;
+    app_rb3_rx_req_t *q = &rx->req[slot];
+    app_rb3_rx_retire(rx, q->req, rid);
+    rx->st.seq_dups += q->seq_dups;
+    rx->st.seq_reorders += q->seq_reorders;
+    rx->st.seq_gaps += q->seq_gaps;
+    q->seq_dups = q->seq_reorders = q->seq_gaps = 0;
+    app_rb3_rx_msg_t *chain = req_detach(q);
+    q->req[0] = '\0';
+    q->open = false;
+    return chain;
+}
+
+// 消息是否属于已结束/已取消的回复：rid 或 req 任一命中即视为残余（req 需每轮唯一）
+bool app_rb3_rx_is_stale(const app_rb3_rx_t *rx, const app_rb3_msg_t *m)
+{
+    for (int i = 0; i < APP_RB3_RX_RETIRED_MAX; ++i) {
+        if (rx->retired[i].rid[0] && span_eq(&m->str[APP_RB3_F_RID], rx->retired[i].rid)) return true;
+        if (rx->retired[i].req[0] && span_eq(&m->str[APP_RB3_F_REQ], rx->retired[i].req)) return true;
+    }
+    return false;
+}
+
+app_rb3_rx_push_t app_rb3_rx_push(app_rb3_rx_t *rx, app_rb3_rx_msg_t *msg, const app_rb3_msg_t *m, int *out_slot)
+{
+    // 解析失败的消息也交给语音轮（消费者解析时再丢），和原先单队列的行为一致
+    int slot = APP_RB3_RX_VOICE;
+    if (m) {
+        if (app_rb3_rx_is_stale(rx, m)) {
+            rx->st.stale_msgs++;
+            rx->st.stale_bytes += msg->len;
+            return APP_RB3_RX_STALE;
+        }
+        if (m->str[APP_RB3_F_REQ].p) {
+            slot = -1;
+            for (int i = 0; i < APP_RB3_RX_SLOTS; ++i) {
+                if (rx->req[i].open && rx->req[i].req[0] && span_eq(&m->str[APP_RB3_F_REQ], rx->req[i].req)) {
+                    slot = i;
+                    break;
+                }
+            }
+            // 语音轮开始时没给 req（服务端自己生成）：认领其余没人要的消息
+            if (slot < 0 && rx->req[APP_RB3_RX_VOICE].open && !rx->req[APP_RB3_RX_VOICE].req[0]) {
+                slot = APP_RB3_RX_VOICE;
+            }
+        }
+    }
+    if (slot < 0 || !rx->req[slot].open) {
+        rx->st.unrouted_msgs++;
+        rx->st.unrouted_bytes += msg->len;
+        return APP_RB3_RX_UNROUTED;
+    }
+
+    app_rb3_rx_req_t *q = &rx->req[slot];
+    if (out_slot) *out_slot = slot;
+    // 控制帧总是入队；音频队列为空时总允许一条，避免单条超过窗口导致死锁。
+    // 溢出过的请求不再收音频：回复已不完整，后面的分片只会被丢掉
+    const bool control = m && (m->type != APP_RB3_MSG_AUDIO || m->is_last);
+    if (!control && (q->overflowed || (q->bytes > 0 && q->bytes + msg->len > q->window))) {
+        q->overflowed = true;
+        q->overflow_msgs++;
+        rx->st.full++;
+        return APP_RB3_RX_FULL;
+    }
+    msg->next = NULL;
+    if (q->tail) {
+        q->tail->next = msg;
+    } else {
+        q->head = msg;
+    }
+    q->tail = msg;
+    q->bytes += msg->len;
+    return APP_RB3_RX_QUEUED;
+}
+
+app_rb3_rx_msg_t *app_rb3_rx_pop(app_rb3_rx_t *rx, int slot)
+{
+    app_rb3_rx_req_t *q = &rx->req[slot];
+    app_rb3_rx_msg_t *msg = q->head;
+    if (!msg) return NULL;
+    q->head = msg->next;
+    if (!q->head) q->tail = NULL;
+    q->bytes = (q->bytes > msg->len) ? q->bytes - msg->len : 0;
+    msg->next = NULL;
+    return msg;
+}
+
+void app_rb3_rx_set_down(app_rb3_rx_t *rx)
+{
+    for (int i = 0; i < APP_RB3_RX_SLOTS; ++i) {
+        if (rx->req[i].open) rx->req[i].down = true;
+    }
+}
+
+void app_rb3_rx_set_window(app_rb3_rx_t *rx, size_t window_bytes)
+{
+    rx->window = window_bytes;
+    for (int i = 0; i < APP_RB3_RX_SLOTS; ++i) rx->req[i].window = window_bytes;
+}
+
+bool app_rb3_rx_ready(app_rb3_rx_req_t *q, app_rb3_rx_msg_t **out_msg, app_rb3_msg_t *out_m)
+{
+    for (int i = 0; i < q->npend; ++i) {
+        if (q->pend[i].m.seq != q->next_seq) continue;
+        *out_msg = q->pend[i].msg;
+        *out_m = q->pend[i].m;
+        q->pend[i] = q->pend[--q->npend];
+        q->next_seq++;
+        return true;
+    }
+    return false;
+}
+
+static bool req_has_seq(const app_rb3_rx_req_t *q, int64_t seq)
+{
+    for (int i = 0; i < q->npend; ++i) {
+        if (q->pend[i].m.seq == seq) return true;
+    }
+    return false;
+}
+
+void app_rb3_rx_skip_gap(app_rb3_rx_req_t *q)
+{
+    if (q->npend == 0) return;
+    int64_t min = q->pend[0].m.seq;
+    for (int i = 1; i < q->npend; ++i) {
+        if (q->pend[i].m.seq < min) min = q->pend[i].m.seq;
+    }
+    q->next_seq = min;
+    q->seq_gaps++;
+}
+
+app_rb3_rx_order_t app_rb3_rx_accept(app_rb3_rx_req_t *q, app_rb3_rx_msg_t *msg, const app_rb3_msg_t *m)
+{
+    if (!APP_RB3_HAS(m, APP_RB3_F_SEQ)) return APP_RB3_RX_DELIVER;
+
+    const int64_t seq = m->seq;
+    if (q->next_seq < 0) q->next_seq = seq;
+    if (seq < q->next_seq || req_has_seq(q, seq)) {
+        q->seq_dups++;
+        return APP_RB3_RX_DUP;
+    }
+    if (seq == q->next_seq) {
+        q->next_seq++;
+        return APP_RB3_RX_DELIVER;
+    }
+    // 超前：暂存（数组多留一格，超过深度就跳过缺口）
+    q->pend[q->npend].msg = msg;
+    q->pend[q->npend].m = *m;
+    q->npend++;
+    q->seq_reorders++;
+    if (q->npend > APP_RB3_RX_REORDER_DEPTH) app_rb3_rx_skip_gap(q);
+    return APP_RB3_RX_HELD;
+}
+
+void app_rb3_rx_get_stats(const app_rb3_rx_t *rx, app_rb3_rx_stats_t *out, size_t *queued_bytes, int *active)
+{
+    *out = rx->st;
+    size_t bytes = 0;
+    int n = 0;
+    for (int i = 0; i < APP_RB3_RX_SLOTS; ++i) {
+        const app_rb3_rx_req_t *q = &rx->req[i];
+        out->seq_dups += q->seq_dups;
+        out->seq_reorders += q->seq_reorders;
+        out->seq_gaps += q->seq_gaps;
+        if (!q->open) continue;
+        bytes += q->bytes;
+        n++;
+    }
+    if (queued_bytes) *queued_bytes = bytes;
+    if (active) *active = n;
+}
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "App_Rb3Json.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * v3 WS 下行分流核心：按 req 把完整消息分到各逻辑请求的 FIFO，每个请求各有接收窗口（credit），
+ * 在请求内按 seq 去重/重排。不含任务/锁/socket，可在主机上跑（tools/rb3_rx_bench.c）。
+ *
+ *   ws 任务：parse_ro -> push ──残余（已结束/取消的 req/rid）──> 丢弃（stale）
+ *                            ├─req 没有对应请求──────────────> 丢弃（unrouted）
+ *                            ├─所属请求窗口满（只限音频）───────> FULL，该请求记为溢出，由调用方处理
+ *                            └─入该请求 FIFO
+ *   消费者：pop -> parse（原地）-> accept（seq）-> 交付 / 暂存 / 重复丢弃
+ *
+ * 控制帧（meta/text/asr_text/error 与 is_last 音频）不受窗口限制，总是入队：体积小，丢了消费者就等不到结束。
+ * 一个请求的音频第一次超出窗口后，该请求记为溢出，之后的音频都不再入队；消费者见到溢出应放弃本次回复
+ * 并 cancel，而不是带着缺口播下去。
+ *
+ * 请求槽：APP_RB3_RX_MAX_REQ 个给 event/query，另有一个固定给语音轮（APP_RB3_RX_VOICE）。
+ * 不带 req 的消息（如 asr_text、无 req 的 error）只交给语音轮；没有进行中的语音轮时丢弃并计数。
+ * 语音轮本身没有 req 时，它还认领 req 对不上任何请求的消息（服务端代为生成的 req）。
+ *
+ * push/pop/open/close/retire/is_stale/set_down 访问共享状态，调用方需加锁；
+ * ready/accept/skip_gap 只动该请求的重排状态，由唯一的消费者在锁外调用。
+ */
+
+#define APP_RB3_RX_MAX_REQ 4            // 并发的 event/query
+#define APP_RB3_RX_VOICE APP_RB3_RX_MAX_REQ
+#define APP_RB3_RX_SLOTS (APP_RB3_RX_MAX_REQ + 1)
+#define APP_RB3_RX_REORDER_DEPTH 4      // 每个请求最多暂存的超前消息数
+#define APP_RB3_RX_RETIRED_MAX 4        // 记住最近结束/取消的 req，晚到的残余直接丢弃
+#define APP_RB3_RX_REQ_LEN 32
+
+// 一条完整下行消息：头部与 JSON 同一块分配，free() 释放
+typedef struct app_rb3_rx_msg {
+    struct app_rb3_rx_msg *next;
+    size_t len;
+    char data[];                // len 字节 + '\0'
+} app_rb3_rx_msg_t;
+
+typedef enum {
+    APP_RB3_RX_QUEUED = 0,
+    APP_RB3_RX_STALE,           // 属于已结束/已取消的请求
+    APP_RB3_RX_UNROUTED,        // 没有对应的进行中请求
+    APP_RB3_RX_FULL,            // 所属请求的窗口已满或已溢出（音频，未入队）
+} app_rb3_rx_push_t;
+
+typedef enum {
+    APP_RB3_RX_DELIVER = 0,     // 按序，交给调用方
+    APP_RB3_RX_HELD,            // 超前，已暂存
+    APP_RB3_RX_DUP,             // 重复，调用方释放
+} app_rb3_rx_order_t;
+
+typedef struct {
+    uint32_t stale_msgs;
+    uint64_t stale_bytes;
+    uint32_t unrouted_msgs;
+    uint64_t unrouted_bytes;
+    uint32_t full;              // 因窗口满/已溢出丢弃的音频消息数
+    uint32_t seq_dups;
+    uint32_t seq_reorders;
+    uint32_t seq_gaps;
+} app_rb3_rx_stats_t;
+
+typedef struct {
+    // 共享（加锁）
+    bool open;
+    bool down;                  // 连接已断，FIFO 取空后消费者退出
+    char req[APP_RB3_RX_REQ_LEN];
+    app_rb3_rx_msg_t *head;
+    app_rb3_rx_msg_t *tail;
+    size_t bytes;               // 已入队未取走（credit 已用）
+    size_t window;
+    bool overflowed;            // 音频超出过窗口：本次回复已不完整
+    uint32_t overflow_msgs;     // 本请求因此丢弃的音频消息数
+
+    // 消费者私有：seq 重排
+    int64_t next_seq;           // <0：还没见到带 seq 的消息
+    int npend;
+    struct {
+        app_rb3_rx_msg_t *msg;
+        app_rb3_msg_t m;        // 指向 msg->data（已原地解析）
+    } pend[APP_RB3_RX_REORDER_DEPTH + 1];
+    uint32_t seq_dups;
+    uint32_t seq_reorders;
+    uint32_t seq_gaps;
+} app_rb3_rx_req_t;
+
+typedef struct {
+    app_rb3_rx_req_t req[APP_RB3_RX_SLOTS];
+    struct {
+        char req[APP_RB3_RX_REQ_LEN];
+        char rid[64];
+    } retired[APP_RB3_RX_RETIRED_MAX];
+    int retired_next;
+    size_t window;              // 新开请求的窗口
+    app_rb3_rx_stats_t st;      // 已关闭请求的 seq 计数也并到这里
+} app_rb3_rx_t;
+
+void app_rb3_rx_init(app_rb3_rx_t *rx, size_t window_bytes);
+
+/**
+ * @brief 释放所有请求里排队/暂存的消息
+ */
+void app_rb3_rx_deinit(app_rb3_rx_t *rx);
+
+/**
+ * @brief 登记一个请求：voice=true 占语音槽（req 可为 NULL），否则占一个空闲的 event/query 槽
+ *
+ * @return 槽号；req 非法、语音槽已占用或没有空槽返回 -1。同名 req 会从 retired 里移除
+ */
+int app_rb3_rx_open(app_rb3_rx_t *rx, const char *req, bool voice);
+
+/**
+ * @brief 结束请求：req/rid 记入 retired（晚到的残余在 push 时丢弃）
+ *
+ * @return 队列与暂存里剩下的消息（链表），调用方在锁外 app_rb3_rx_free_chain()
+ */
+app_rb3_rx_msg_t *app_rb3_rx_close(app_rb3_rx_t *rx, int slot, const char *rid);
+
+void app_rb3_rx_free_chain(app_rb3_rx_msg_t *chain);
+
+void app_rb3_rx_retire(app_rb3_rx_t *rx, const char *req, const char *rid);
+bool app_rb3_rx_is_stale(const app_rb3_rx_t *rx, const app_rb3_msg_t *m);
+
+/**
+ * @brief 投递一条完整消息（m 为 app_rb3_json_parse_ro 的结果，可为 NULL 表示解析失败）
+ *
+ * @param out_slot 所属的槽号（QUEUED / FULL 时有效）
+ * @return 非 QUEUED 时消息仍归调用方（释放或等待后重投）
+ */
+app_rb3_rx_push_t app_rb3_rx_push(app_rb3_rx_t *rx, app_rb3_rx_msg_t *msg, const app_rb3_msg_t *m, int *out_slot);
+
+/**
+ * @brief 取出队首消息并归还其 credit；空返回 NULL
+ */
+app_rb3_rx_msg_t *app_rb3_rx_pop(app_rb3_rx_t *rx, int slot);
+
+/**
+ * @brief 连接断开：所有进行中的请求置 down
+ */
+void app_rb3_rx_set_down(app_rb3_rx_t *rx);
+
+void app_rb3_rx_set_window(app_rb3_rx_t *rx, size_t window_bytes);
+
+/**
+ * @brief 暂存里有 seq 正好是下一个的消息时取出
+ */
+bool app_rb3_rx_ready(app_rb3_rx_req_t *q, app_rb3_rx_msg_t **out_msg, app_rb3_msg_t *out_m);
+
+/**
+ * @brief 按 seq 处理一条已解析的消息；不带 seq 的直接交付。暂存超过深度时自动跳过缺口
+ */
+app_rb3_rx_order_t app_rb3_rx_accept(app_rb3_rx_req_t *q, app_rb3_rx_msg_t *msg, const app_rb3_msg_t *m);
+
+/**
+ * @brief 缺失的 seq 不再等：跳到暂存里最小的 seq（暂存为空时无操作）
+ */
+void app_rb3_rx_skip_gap(app_rb3_rx_req_t *q);
+
+/**
+ * @brief 汇总计数（含进行中请求的 seq 计数）；queued_bytes 可为 NULL
+ */
+void app_rb3_rx_get_stats(const app_rb3_rx_t *rx, app_rb3_rx_stats_t *out, size_t *queued_bytes, int *active);
+
+#ifdef __cplusplus
+}
+#endif
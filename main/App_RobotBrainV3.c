@@ -1,4 +1,7 @@
 #include "App_RobotBrainV3.h"
+#include "App_Rb3Endpoint.h"
+#include "App_Rb3Json.h"
+#include "App_Rb3Rx.h"
 
 #include <ctype.h>
 #include <inttypes.h>
@@ -9,9 +12,11 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 
 #include "esp_check.h"
 #include "esp_event.h"
+#include "esp_heap_caps.h"
 #include "esp_http_client.h"
 #include "esp_log.h"
 #include "esp_websocket_client.h"
@@ -77,130 +82,105 @@ static void safe_copy(char *dst, size_t dst_sz, const char *src, size_t src_len)
     dst[n] = '\0';
 }
 
-static void json_extract_string(const char *json, const char *key, char *out, size_t out_sz)
+static bool span_eq(const app_rb3_str_t *s, const char *c)
 {
-    if (!out || out_sz == 0) return;
-    out[0] = '\0';
-    if (!json || !key) return;
-
-    const char *p = strstr(json, key);
-    if (!p) return;
-    p += strlen(key);
-    while (*p && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ':')) p++;
-    if (*p != '"') return;
-    p++;
-    const char *start = p;
-    while (*p && *p != '"') p++;
-    if (*p != '"') return;
-    safe_copy(out, out_sz, start, (size_t)(p - start));
+    size_t n = strlen(c);
+    return s->p && s->len == n && memcmp(s->p, c, n) == 0;
 }
 
-static bool json_extract_bool_in_obj(const char *obj_start, const char *obj_end, const char *key)
+// base64 解码一条 audio 消息并回调（tmp 不够时扩容）
+static esp_err_t decode_audio_chunk(const app_rb3_msg_t *m, uint8_t **tmp, size_t *tmp_cap,
+                                    app_rb3_on_audio_cb on_audio, void *cb_ctx)
 {
-    if (!obj_start || !obj_end || !key) return false;
-    char *p = strstr(obj_start, key);
-    if (!p || p >= obj_end) return false;
-    p += strlen(key);
-    while (p < obj_end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ':')) p++;
-    if (p >= obj_end) return false;
-    return (*p == 't' || *p == 'T'); // true
-}
+    const app_rb3_str_t *b64 = &m->str[APP_RB3_F_CHUNK];
+    if (!b64->p || b64->len == 0) return ESP_OK;
 
-static char *find_json_object_end(char *start, char *limit)
-{
-    int brace = 0;
-    for (char *p = start; p < limit; ++p) {
-        if (*p == '{') brace++;
-        else if (*p == '}') {
-            brace--;
-            if (brace == 0) return p;
-        }
+    size_t need = (b64->len / 4) * 3 + 4;
+    if (need > *tmp_cap) {
+        uint8_t *p = (uint8_t *)realloc(*tmp, need);
+        if (!p) return ESP_ERR_NO_MEM;
+        *tmp = p;
+        *tmp_cap = need;
     }
-    return NULL;
+    size_t out_len = 0;
+    int mret = mbedtls_base64_decode(*tmp, *tmp_cap, &out_len, (const unsigned char *)b64->p, b64->len);
+    if (mret != 0 || out_len == 0) return ESP_OK;
+    return on_audio(*tmp, out_len, m->is_last, cb_ctx);
 }
 
-static esp_err_t parse_and_cb_audio_array(const char *json,
-                                         size_t json_len,
-                                         int chunk_bytes,
+// HTTP 回复的 "audio":[{...},...]：逐个对象原地解析
+static esp_err_t parse_and_cb_audio_array(char *arr,
+                                         size_t arr_len,
                                          app_rb3_on_audio_cb on_audio,
                                          void *cb_ctx)
 {
-    if (!json || json_len == 0 || !on_audio) return ESP_ERR_INVALID_ARG;
-
-    // locate "audio":[ ... ]
-    const char *pa = strstr(json, "\"audio\"");
-    ESP_RETURN_ON_FALSE(pa, ESP_FAIL, TAG, "no audio field");
-    pa += strlen("\"audio\"");
-    while (*pa && (*pa == ' ' || *pa == '\t' || *pa == '\r' || *pa == '\n' || *pa == ':')) pa++;
-    ESP_RETURN_ON_FALSE(*pa == '[', ESP_FAIL, TAG, "audio not array");
-
-    char *buf = (char *)json; // reuse helpers require char*
-    char *p = (char *)(pa + 1);
-    char *limit = (char *)json + json_len;
+    if (!arr || arr_len == 0 || !on_audio) return ESP_ERR_INVALID_ARG;
+    ESP_RETURN_ON_FALSE(arr[0] == '[', ESP_FAIL, TAG, "audio not array");
 
-    uint8_t *tmp = (uint8_t *)malloc((size_t)chunk_bytes + 1024); // base64 解码输出上限略大一点
-    ESP_RETURN_ON_FALSE(tmp, ESP_ERR_NO_MEM, TAG, "tmp alloc failed");
+    char *p = arr + 1;
+    char *limit = arr + arr_len;
+    uint8_t *tmp = NULL;
+    size_t tmp_cap = 0;
 
     esp_err_t cb_ret = ESP_OK;
     while (p < limit) {
         while (p < limit && *p != '{' && *p != ']') p++;
         if (p >= limit || *p == ']') break;
 
-        char *obj_start = p;
-        char *obj_end = find_json_object_end(obj_start, limit);
-        if (!obj_end) break;
-
-        // type == "audio" ?
-        bool is_audio = false;
-        char *ptype = strstr(obj_start, "\"type\"");
-        if (ptype && ptype < obj_end) {
-            ptype += strlen("\"type\"");
-            while (ptype < obj_end && (*ptype == ' ' || *ptype == '\t' || *ptype == '\r' || *ptype == '\n' || *ptype == ':')) ptype++;
-            if (ptype < obj_end && *ptype == '"') {
-                ptype++;
-                if ((obj_end - ptype) >= 5 && strncmp(ptype, "audio", 5) == 0) {
-                    is_audio = true;
-                }
-            }
-        }
+        app_rb3_msg_t m;
+        size_t used = 0;
+        if (app_rb3_json_parse(p, (size_t)(limit - p), &m, &used) != ESP_OK) break;
+        p += used;
+        if (m.type != APP_RB3_MSG_AUDIO) continue;
 
-        if (is_audio) {
-            bool is_last = json_extract_bool_in_obj(obj_start, obj_end, "\"is_last\"");
-
-            // chunk base64
-            char *pc = strstr(obj_start, "\"chunk\"");
-            if (pc && pc < obj_end) {
-                pc += strlen("\"chunk\"");
-                while (pc < obj_end && (*pc == ' ' || *pc == '\t' || *pc == '\r' || *pc == '\n' || *pc == ':')) pc++;
-                if (pc < obj_end && *pc == '"') {
-                    pc++;
-                    char *b64_start = pc;
-                    while (pc < obj_end && *pc && *pc != '"') pc++;
-                    if (pc < obj_end && *pc == '"') {
-                        size_t b64_len = (size_t)(pc - b64_start);
-                        size_t out_len = 0;
-                        int mret = mbedtls_base64_decode(tmp, (size_t)chunk_bytes + 1024, &out_len,
-                                                         (const unsigned char *)b64_start, b64_len);
-                        if (mret == 0 && out_len > 0) {
-                            cb_ret = on_audio(tmp, out_len, is_last, cb_ctx);
-                            if (cb_ret != ESP_OK) {
-                                break;
-                            }
-                        }
-                    }
-                }
-            }
-        }
-
-        p = obj_end + 1;
-        while (p < limit && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ',')) p++;
+        cb_ret = decode_audio_chunk(&m, &tmp, &tmp_cap, on_audio, cb_ctx);
+        if (cb_ret != ESP_OK) break;
     }
 
     free(tmp);
-    (void)buf;
     return cb_ret;
 }
 
+// HTTP 回复顶层（含 "meta" 子对象）-> out_meta
+static void fill_meta_from_msg(app_rb3_meta_t *out_meta, const app_rb3_msg_t *m)
+{
+    memset(out_meta, 0, sizeof(*out_meta));
+    app_rb3_json_copy(out_meta->req, sizeof(out_meta->req), m, APP_RB3_F_REQ);
+    app_rb3_json_copy(out_meta->rid, sizeof(out_meta->rid), m, APP_RB3_F_RID);
+    app_rb3_json_copy(out_meta->text, sizeof(out_meta->text), m, APP_RB3_F_TEXT);
+    app_rb3_json_copy(out_meta->anim, sizeof(out_meta->anim), m, APP_RB3_F_ANIM);
+    app_rb3_json_copy(out_meta->motion, sizeof(out_meta->motion), m, APP_RB3_F_MOTION);
+    app_rb3_json_copy(out_meta->af, sizeof(out_meta->af), m, APP_RB3_F_AF);
+    app_rb3_json_copy(out_meta->ver, sizeof(out_meta->ver), m, APP_RB3_F_VERSION);
+}
+
+// HTTP 回复：解析顶层字段 + 逐个回调 audio
+static esp_err_t handle_http_reply(char *body, size_t len, app_rb3_meta_t *out_meta,
+                                   app_rb3_on_audio_cb on_audio, void *cb_ctx)
+{
+    app_rb3_msg_t m;
+    ESP_RETURN_ON_ERROR(app_rb3_json_parse(body, len, &m, NULL), TAG, "reply json invalid");
+    if (out_meta) fill_meta_from_msg(out_meta, &m);
+    ESP_RETURN_ON_FALSE(APP_RB3_HAS(&m, APP_RB3_F_AUDIO), ESP_FAIL, TAG, "no audio field");
+    return parse_and_cb_audio_array((char *)m.str[APP_RB3_F_AUDIO].p, m.str[APP_RB3_F_AUDIO].len, on_audio, cb_ctx);
+}
+
+// 本次请求用哪个服务端：有端点列表按探测结果挑，返回端点下标（-1 表示用 base_url）
+static int rb3_pick_base(const app_rb3_cfg_t *cfg, const char **out_url)
+{
+    *out_url = cfg->base_url;
+    if (!cfg->endpoints || cfg->endpoint_count <= 0) return -1;
+    (void)app_rb3_ep_start(cfg->endpoints, cfg->endpoint_count, NULL); // 已启动时忽略
+    const char *url = NULL;
+    int idx = app_rb3_ep_pick(&url);
+    if (idx < 0 || !url) {
+        *out_url = cfg->endpoints[0];
+        return -1;
+    }
+    *out_url = url;
+    return idx;
+}
+
 app_rb3_cfg_t app_rb3_cfg_default(const char *base_url)
 {
     app_rb3_cfg_t cfg = {
@@ -213,6 +193,7 @@ app_rb3_cfg_t app_rb3_cfg_default(const char *base_url)
         .mode = "stream",
         .chunk_bytes = 500,
         .timeout_ms = 20000,
+        .rx_window_bytes = 512 * 1024,
     };
     return cfg;
 }
@@ -221,16 +202,20 @@ esp_err_t app_rb3_http_event_stream(const app_rb3_cfg_t *cfg,
                                    const char *event_name,
                                    const char *req_id,
                                    const char *user_id,
+                                   const char *if_version,
                                    app_rb3_meta_t *out_meta,
                                    app_rb3_on_audio_cb on_audio,
                                    void *cb_ctx)
 {
-    ESP_RETURN_ON_FALSE(cfg && cfg->base_url && cfg->event_path, ESP_ERR_INVALID_ARG, TAG, "cfg invalid");
+    ESP_RETURN_ON_FALSE(cfg && (cfg->base_url || cfg->endpoint_count > 0) && cfg->event_path, ESP_ERR_INVALID_ARG,
+                        TAG, "cfg invalid");
     ESP_RETURN_ON_FALSE(event_name && on_audio, ESP_ERR_INVALID_ARG, TAG, "arg invalid");
 
     // build url
+    const char *base = NULL;
+    const int ep = rb3_pick_base(cfg, &base);
     char url[256];
-    int ulen = snprintf(url, sizeof(url), "%s%s", cfg->base_url, cfg->event_path);
+    int ulen = snprintf(url, sizeof(url), "%s%s", base, cfg->event_path);
     ESP_RETURN_ON_FALSE(ulen > 0 && ulen < (int)sizeof(url), ESP_ERR_INVALID_ARG, TAG, "url too long");
 
     // build json body
@@ -241,11 +226,18 @@ esp_err_t app_rb3_http_event_stream(const app_rb3_cfg_t *cfg,
     const char *mode = cfg->mode ? cfg->mode : "stream";
     const int chunk_bytes = cfg->chunk_bytes > 0 ? cfg->chunk_bytes : 500;
 
-    int blen = snprintf(body, sizeof(body),
-                        "{\"type\":\"event\",\"event\":\"%s\",\"req\":\"%s\",\"user_id\":\"%s\","
-                        "\"chunk_bytes\":%d,\"mode\":\"%s\",\"af\":\"%s\"}",
-                        event_name, rid, uid, chunk_bytes, mode, af);
-    ESP_RETURN_ON_FALSE(blen > 0 && blen < (int)sizeof(body), ESP_ERR_INVALID_ARG, TAG, "body too long");
+    app_rb3_jw_t jw;
+    app_rb3_jw_begin(&jw, body, sizeof(body));
+    app_rb3_jw_str(&jw, "type", "event");
+    app_rb3_jw_str(&jw, "event", event_name);
+    app_rb3_jw_str(&jw, "req", rid);
+    app_rb3_jw_str(&jw, "user_id", uid);
+    app_rb3_jw_int(&jw, "chunk_bytes", chunk_bytes);
+    app_rb3_jw_str(&jw, "mode", mode);
+    app_rb3_jw_str(&jw, "af", af);
+    if (if_version && if_version[0]) app_rb3_jw_str(&jw, "if_version", if_version);
+    size_t blen = 0;
+    ESP_RETURN_ON_ERROR(app_rb3_jw_end(&jw, &blen), TAG, "body too long");
 
     rb3_resp_buf_t rb = {0};
     esp_http_client_config_t c = {
@@ -261,29 +253,19 @@ esp_err_t app_rb3_http_event_stream(const app_rb3_cfg_t *cfg,
     ESP_RETURN_ON_FALSE(h, ESP_FAIL, TAG, "http init failed");
 
     esp_http_client_set_header(h, "Content-Type", "application/json");
-    esp_http_client_set_post_field(h, body, blen);
+    esp_http_client_set_post_field(h, body, (int)blen);
 
     esp_err_t ret = esp_http_client_perform(h);
     int status = esp_http_client_get_status_code(h);
     esp_http_client_cleanup(h);
+    app_rb3_ep_report(ep, ret == ESP_OK && status < 500);
 
     ESP_RETURN_ON_FALSE(ret == ESP_OK, ret, TAG, "http perform failed");
     ESP_RETURN_ON_FALSE(status >= 200 && status < 300, ESP_FAIL, TAG, "http status=%d", status);
     ESP_RETURN_ON_FALSE(rb.buf && rb.len > 0, ESP_FAIL, TAG, "empty body");
 
-    // fill meta (best-effort)
-    if (out_meta) {
-        memset(out_meta, 0, sizeof(*out_meta));
-        json_extract_string(rb.buf, "\"req\"", out_meta->req, sizeof(out_meta->req));
-        json_extract_string(rb.buf, "\"rid\"", out_meta->rid, sizeof(out_meta->rid));
-        json_extract_string(rb.buf, "\"text\"", out_meta->text, sizeof(out_meta->text));
-        // meta 子对象里可能有 anim/motion/af（这里简单全局找，够用）
-        json_extract_string(rb.buf, "\"anim\"", out_meta->anim, sizeof(out_meta->anim));
-        json_extract_string(rb.buf, "\"motion\"", out_meta->motion, sizeof(out_meta->motion));
-        json_extract_string(rb.buf, "\"af\"", out_meta->af, sizeof(out_meta->af));
-    }
-
-    esp_err_t cb_ret = parse_and_cb_audio_array(rb.buf, rb.len, chunk_bytes, on_audio, cb_ctx);
+    // 顶层字段（meta 子对象里的 anim/motion/af 一并展开）+ audio 数组
+    esp_err_t cb_ret = handle_http_reply(rb.buf, rb.len, out_meta, on_audio, cb_ctx);
     free(rb.buf);
     return cb_ret;
 }
@@ -294,117 +276,277 @@ static bool starts_with(const char *s, const char *prefix)
     return strncmp(s, prefix, strlen(prefix)) == 0;
 }
 
+// http(s) -> ws(s)，ws(s) 原样；端口以 URL 为准（未写则用协议默认端口）
 static esp_err_t build_ws_url(const char *base_url, char *out, size_t out_sz)
 {
     if (!base_url || !out || out_sz == 0) return ESP_ERR_INVALID_ARG;
     const char *path = "/v1/robot/voice_rt";
+    const char *scheme = NULL;
+    const char *rest = NULL;
     if (starts_with(base_url, "http://")) {
-        const char *host = base_url + 7;
-        // 若未显式提供端口，默认用 8443（避免误连到 8000/80）
-        const char *slash = strchr(host, '/');
-        const char *port = strchr(host, ':');
-        if (!port || (slash && port > slash)) {
-            char host_only[192];
-            size_t ncopy = slash ? (size_t)(slash - host) : strlen(host);
-            if (ncopy >= sizeof(host_only)) ncopy = sizeof(host_only) - 1;
-            memcpy(host_only, host, ncopy);
-            host_only[ncopy] = '\0';
-            int n = snprintf(out, out_sz, "ws://%s:8443%s", host_only, path);
-            return (n > 0 && (size_t)n < out_sz) ? ESP_OK : ESP_ERR_INVALID_SIZE;
-        }
-        int n = snprintf(out, out_sz, "ws://%s%s", host, path);
-        return (n > 0 && (size_t)n < out_sz) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+        scheme = "ws://";
+        rest = base_url + 7;
+    } else if (starts_with(base_url, "https://")) {
+        scheme = "wss://";
+        rest = base_url + 8;
+    } else if (starts_with(base_url, "ws://")) {
+        scheme = "ws://";
+        rest = base_url + 5;
+    } else if (starts_with(base_url, "wss://")) {
+        scheme = "wss://";
+        rest = base_url + 6;
+    } else {
+        return ESP_ERR_INVALID_ARG;
     }
-    if (starts_with(base_url, "https://")) {
-        const char *host = base_url + 8;
-        const char *slash = strchr(host, '/');
-        const char *port = strchr(host, ':');
-        if (!port || (slash && port > slash)) {
-            char host_only[192];
-            size_t ncopy = slash ? (size_t)(slash - host) : strlen(host);
-            if (ncopy >= sizeof(host_only)) ncopy = sizeof(host_only) - 1;
-            memcpy(host_only, host, ncopy);
-            host_only[ncopy] = '\0';
-            int n = snprintf(out, out_sz, "wss://%s:8443%s", host_only, path);
-            return (n > 0 && (size_t)n < out_sz) ? ESP_OK : ESP_ERR_INVALID_SIZE;
-        }
-        int n = snprintf(out, out_sz, "wss://%s%s", host, path);
-        return (n > 0 && (size_t)n < out_sz) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+    size_t rlen = strlen(rest);
+    while (rlen > 0 && rest[rlen - 1] == '/') rlen--;
+    int n = snprintf(out, out_sz, "%s%.*s%s", scheme, (int)rlen, rest, path);
+    return (n > 0 && (size_t)n < out_sz) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+#define RB3_WS_RX_WINDOW_DEFAULT (512 * 1024)
+#define RB3_WS_RX_WINDOW_MIN 4096
+#define RB3_WS_REORDER_WAIT_MS 300  // 有暂存时等缺失 seq 的最长时间，超时跳过缺口
+
+// 多路复用：一条连接上同时进行的逻辑请求（语音轮 + event/query），按 req 分流，见 App_Rb3Rx
+typedef struct {
+    app_rb3_rx_msg_t *assem;  // 组装中的消息
+    int assem_len;            // expected total length
+
+    // core 的共享部分（各请求 FIFO、retired、计数）由 ws 任务与消费者共享，需加锁
+    portMUX_TYPE lock;
+    app_rb3_rx_t core;
+    SemaphoreHandle_t ready[APP_RB3_RX_SLOTS];  // 入队/断线时 give，唤醒该请求的消费者
+
+    // 接收窗口：每个请求各自计未消费字节。事件回调跑在 esp_websocket_client 的任务里（持有 client 锁，
+    // ping/pong 和发送都要等它），所以回调从不阻塞：控制帧总是入队，音频超过窗口时该请求记为溢出，
+    // 消费者随即报错并 cancel，不带缺口播放。窗口由上层按播放缓冲余量放宽（app_rb3_ws_set_rx_window）。
+    volatile bool closing;     // close 时置位，之后到达的消息直接丢弃
+    uint32_t overflows;        // 窗口满/已溢出丢弃的音频
+    uint32_t drops;            // 丢弃总数（窗口满/close/内存不足/异常分片），均有日志
+
+    volatile uint32_t last_rx_ms; // 最近一次收到任何帧（含 pong）的时间，用于等待期存活检测
+
+    // 本连接所属端点（-1：未用端点列表）；建连成功/失败、中途断开各反馈一次
+    int ep_idx;
+    bool ep_down_reported;
+    volatile bool ended; // 收到过 DISCONNECTED/ERROR：未自动重连，这条会话不会再连上
+} ws_rx_ctx_t;
+
+static void ws_rx_retire(ws_rx_ctx_t *r, const char *req, const char *rid)
+{
+    portENTER_CRITICAL(&r->lock);
+    app_rb3_rx_retire(&r->core, req, rid);
+    portEXIT_CRITICAL(&r->lock);
+}
+
+static void ws_rx_ctx_reset(ws_rx_ctx_t *r)
+{
+    if (!r) return;
+    if (r->assem) {
+        free(r->assem);
+        r->assem = NULL;
     }
-    // 兼容用户直接传 ws/wss：若未显式提供端口，则默认 8443
-    if (starts_with(base_url, "ws://") || starts_with(base_url, "wss://")) {
-        const char *host = starts_with(base_url, "ws://") ? (base_url + 5) : (base_url + 6);
-        const char *slash = strchr(host, '/');
-        const char *port = strchr(host, ':');
-        if (!port || (slash && port > slash)) {
-            char host_only[192];
-            size_t ncopy = slash ? (size_t)(slash - host) : strlen(host);
-            if (ncopy >= sizeof(host_only)) ncopy = sizeof(host_only) - 1;
-            memcpy(host_only, host, ncopy);
-            host_only[ncopy] = '\0';
-            if (starts_with(base_url, "ws://")) {
-                int n = snprintf(out, out_sz, "ws://%s:8443%s", host_only, path);
-                return (n > 0 && (size_t)n < out_sz) ? ESP_OK : ESP_ERR_INVALID_SIZE;
-            }
-            int n = snprintf(out, out_sz, "wss://%s:8443%s", host_only, path);
-            return (n > 0 && (size_t)n < out_sz) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+    r->assem_len = 0;
+}
+
+static void ws_rx_ctx_deinit(ws_rx_ctx_t *r)
+{
+    app_rb3_rx_deinit(&r->core);
+    for (int i = 0; i < APP_RB3_RX_SLOTS; ++i) {
+        if (r->ready[i]) vSemaphoreDelete(r->ready[i]);
+        r->ready[i] = NULL;
+    }
+    ws_rx_ctx_reset(r);
+}
+
+static esp_err_t ws_rx_ctx_init(ws_rx_ctx_t *r, size_t window_bytes)
+{
+    memset(r, 0, sizeof(*r));
+    portMUX_INITIALIZE(&r->lock);
+    app_rb3_rx_init(&r->core, (window_bytes >= RB3_WS_RX_WINDOW_MIN) ? window_bytes : RB3_WS_RX_WINDOW_DEFAULT);
+    for (int i = 0; i < APP_RB3_RX_SLOTS; ++i) {
+        r->ready[i] = xSemaphoreCreateBinary();
+        if (!r->ready[i]) {
+            ws_rx_ctx_deinit(r);
+            return ESP_ERR_NO_MEM;
         }
-        int n = snprintf(out, out_sz, "%s%s", base_url, path);
-        return (n > 0 && (size_t)n < out_sz) ? ESP_OK : ESP_ERR_INVALID_SIZE;
     }
-    return ESP_ERR_INVALID_ARG;
+    return ESP_OK;
 }
 
-static void json_extract_string_inplace(const char *json, const char *key, char *out, size_t out_sz)
+static void ws_rx_count_drop(ws_rx_ctx_t *r, const char *why, int bytes)
 {
-    // 复用旧实现（key 需包含引号，例如 "\"type\""）
-    json_extract_string(json, key, out, out_sz);
+    portENTER_CRITICAL(&r->lock);
+    r->drops++;
+    portEXIT_CRITICAL(&r->lock);
+    ESP_LOGW(TAG, "ws rx drop (%s): %d bytes, total drops=%" PRIu32, why, bytes, r->drops);
 }
 
-static bool json_extract_bool(const char *json, const char *key)
+// 登记一个逻辑请求：之后 req 相同的下行消息都进它自己的 FIFO；返回槽号，-1 为失败
+static int ws_rx_open(ws_rx_ctx_t *r, const char *req, bool voice)
 {
-    // 简化版：全局查找 key，然后读 true/false
-    if (!json || !key) return false;
-    const char *p = strstr(json, key);
-    if (!p) return false;
-    p += strlen(key);
-    while (*p && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ':')) p++;
-    return (*p == 't' || *p == 'T');
+    portENTER_CRITICAL(&r->lock);
+    const int slot = app_rb3_rx_open(&r->core, req, voice);
+    portEXIT_CRITICAL(&r->lock);
+    // 上一个使用者留下的唤醒
+    if (slot >= 0) (void)xSemaphoreTake(r->ready[slot], 0);
+    return slot;
 }
 
-static esp_err_t json_extract_b64_chunk(const char *json, const char *key, const char **out_b64, size_t *out_len)
+// 结束一个逻辑请求：先登记为 retired 再解除路由，之后晚到的消息在 ws 任务里直接丢弃
+static void ws_rx_close(ws_rx_ctx_t *r, int slot, const char *rid)
 {
-    if (!json || !key || !out_b64 || !out_len) return ESP_ERR_INVALID_ARG;
-    *out_b64 = NULL;
-    *out_len = 0;
-    const char *p = strstr(json, key);
-    if (!p) return ESP_FAIL;
-    p += strlen(key);
-    while (*p && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ':')) p++;
-    if (*p != '"') return ESP_FAIL;
-    p++;
-    const char *start = p;
-    while (*p && *p != '"') p++;
-    if (*p != '"') return ESP_FAIL;
-    *out_b64 = start;
-    *out_len = (size_t)(p - start);
-    return ESP_OK;
+    if (slot < 0) return;
+    portENTER_CRITICAL(&r->lock);
+    app_rb3_rx_msg_t *left = app_rb3_rx_close(&r->core, slot, rid);
+    portEXIT_CRITICAL(&r->lock);
+    app_rb3_rx_free_chain(left);
 }
 
-typedef struct {
-    QueueHandle_t q;      // item: char* (heap allocated, null-terminated)
-    char *assem;          // assembling buffer
-    int assem_len;        // expected total length
-} ws_rx_ctx_t;
+// 在 ws 任务上下文投递：不阻塞，入队或丢弃二选一
+static void ws_rx_deliver(ws_rx_ctx_t *r, app_rb3_rx_msg_t *msg, const app_rb3_msg_t *m)
+{
+    if (r->closing) {
+        ws_rx_count_drop(r, "closing", (int)msg->len);
+        free(msg);
+        return;
+    }
+    int slot = -1;
+    size_t queued = 0;
+    bool first = false;
+    portENTER_CRITICAL(&r->lock);
+    const app_rb3_rx_push_t res = app_rb3_rx_push(&r->core, msg, m, &slot);
+    if (res == APP_RB3_RX_FULL) {
+        r->overflows++;
+        r->drops++;
+        queued = r->core.req[slot].bytes;
+        first = r->core.req[slot].overflow_msgs == 1;
+    }
+    portEXIT_CRITICAL(&r->lock);
 
-static void ws_rx_ctx_reset(ws_rx_ctx_t *r)
+    switch (res) {
+    case APP_RB3_RX_QUEUED:
+        (void)xSemaphoreGive(r->ready[slot]);
+        return;
+    case APP_RB3_RX_STALE:
+        // 已结束/已取消回复的残余分片：不占队列、不做 base64 解码
+        break;
+    case APP_RB3_RX_UNROUTED:
+        // 没有请求在等它（如空闲时的服务端错误）：计数后丢弃，不占任何窗口
+        if (m && m->type == APP_RB3_MSG_ERROR) {
+            ESP_LOGW(TAG, "ws server error (no request): %.*s", (int)m->str[APP_RB3_F_MESSAGE].len,
+                     m->str[APP_RB3_F_MESSAGE].p ? m->str[APP_RB3_F_MESSAGE].p : "");
+        } else {
+            ESP_LOGD(TAG, "ws rx unrouted: %u bytes", (unsigned)msg->len);
+        }
+        break;
+    default:
+        // 消费者跟不上：不能停住 client 任务（否则 ping/pong、cancel、下一轮 start 全部超时）。
+        // 第一次溢出就唤醒消费者，由它放弃本次回复并 cancel；之后的音频只计数
+        if (first) {
+            ESP_LOGW(TAG, "ws rx window full: slot=%d queued=%u, reply dropped", slot, (unsigned)queued);
+            (void)xSemaphoreGive(r->ready[slot]);
+        }
+        break;
+    }
+    free(msg);
+}
+
+// ws 任务上下文：只读解析一次，残余丢弃，其余按 req 分流到对应请求的 FIFO
+static void ws_rx_route(ws_rx_ctx_t *r, app_rb3_rx_msg_t *msg)
 {
-    if (!r) return;
-    if (r->assem) {
-        free(r->assem);
-        r->assem = NULL;
+    app_rb3_msg_t m;
+    const bool ok = app_rb3_json_parse_ro(msg->data, msg->len, &m) == ESP_OK;
+    ws_rx_deliver(r, msg, ok ? &m : NULL);
+}
+
+// 断线/出错：所有进行中的请求置 down 并唤醒
+static void ws_rx_signal_down(ws_rx_ctx_t *r)
+{
+    portENTER_CRITICAL(&r->lock);
+    app_rb3_rx_set_down(&r->core);
+    portEXIT_CRITICAL(&r->lock);
+    for (int i = 0; i < APP_RB3_RX_SLOTS; ++i) {
+        if (r->ready[i]) (void)xSemaphoreGive(r->ready[i]);
+    }
+}
+
+static void ws_rx_log_gap(ws_rx_ctx_t *r, int slot, int64_t from)
+{
+    const app_rb3_rx_req_t *q = &r->core.req[slot];
+    ESP_LOGW(TAG, "ws req %s: seq gap %" PRId64 "..%" PRId64 " skipped", q->req[0] ? q->req : "-", from,
+             q->next_seq - 1);
+}
+
+/**
+ * 取请求 slot 的下一条可处理消息（已原地解析，调用方 free(*out_msg)）
+ * 按 seq 去重/重排：seq 小于期望值的是重复，直接丢；超前的暂存，等缺失的那条或超时跳过。
+ * 不带 seq 的消息按到达顺序交付。返回 ESP_ERR_TIMEOUT：超时无消息；ESP_FAIL：连接断开；
+ * ESP_ERR_INVALID_SIZE：该请求的音频超出过接收窗口（回复已不完整，剩下的消息不再交付）。
+ */
+static esp_err_t ws_rx_next(ws_rx_ctx_t *r, int slot, int timeout_ms, app_rb3_rx_msg_t **out_msg,
+                            app_rb3_msg_t *out_m)
+{
+    app_rb3_rx_req_t *q = &r->core.req[slot];
+    for (;;) {
+        if (q->npend > 0 && app_rb3_rx_ready(q, out_msg, out_m)) return ESP_OK;
+
+        portENTER_CRITICAL(&r->lock);
+        app_rb3_rx_msg_t *rx = app_rb3_rx_pop(&r->core, slot);
+        const bool down = q->down;
+        const bool overflowed = q->overflowed;
+        portEXIT_CRITICAL(&r->lock);
+        if (overflowed) {
+            free(rx);
+            return ESP_ERR_INVALID_SIZE;
+        }
+        if (!rx) {
+            if (down) return ESP_FAIL;
+            const int wait_ms = (q->npend > 0) ? RB3_WS_REORDER_WAIT_MS : timeout_ms;
+            if (xSemaphoreTake(r->ready[slot], pdMS_TO_TICKS(wait_ms)) == pdTRUE) continue;
+            if (q->npend > 0) {
+                const int64_t from = q->next_seq;
+                app_rb3_rx_skip_gap(q);
+                ws_rx_log_gap(r, slot, from);
+                continue;
+            }
+            return ESP_ERR_TIMEOUT;
+        }
+
+        // 整条消息只扫描一遍：字段原地反转义，后面直接用 span
+        if (app_rb3_json_parse(rx->data, rx->len, out_m, NULL) != ESP_OK) {
+            ESP_LOGW(TAG, "ws drop bad json (%u bytes)", (unsigned)rx->len);
+            free(rx);
+            continue;
+        }
+        // cancel 之前已入队的残余消息
+        portENTER_CRITICAL(&r->lock);
+        const bool stale = app_rb3_rx_is_stale(&r->core, out_m);
+        if (stale) {
+            r->core.st.stale_msgs++;
+            r->core.st.stale_bytes += rx->len;
+        }
+        portEXIT_CRITICAL(&r->lock);
+        if (stale) {
+            free(rx);
+            continue;
+        }
+
+        const int64_t from = q->next_seq;
+        const uint32_t gaps = q->seq_gaps;
+        switch (app_rb3_rx_accept(q, rx, out_m)) {
+        case APP_RB3_RX_DELIVER:
+            *out_msg = rx;
+            return ESP_OK;
+        case APP_RB3_RX_DUP:
+            free(rx);
+            break;
+        default:
+            if (q->seq_gaps != gaps) ws_rx_log_gap(r, slot, from);
+            break;
+        }
     }
-    r->assem_len = 0;
 }
 
 static void ws_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
@@ -415,30 +557,37 @@ static void ws_event_handler(void *handler_args, esp_event_base_t base, int32_t
 
     if (event_id == WEBSOCKET_EVENT_CONNECTED) {
         ESP_LOGI(TAG, "ws connected");
+        r->last_rx_ms = esp_log_timestamp();
+        app_rb3_ep_report(r->ep_idx, true);
         return;
     }
-    if (event_id == WEBSOCKET_EVENT_DISCONNECTED) {
-        ESP_LOGW(TAG, "ws disconnected");
-        ws_rx_ctx_reset(r);
-        if (r->q) {
-            char *nil = NULL;
-            (void)xQueueSend(r->q, &nil, 0);
+    if (event_id == WEBSOCKET_EVENT_DISCONNECTED || event_id == WEBSOCKET_EVENT_ERROR) {
+        if (event_id == WEBSOCKET_EVENT_ERROR) {
+            ESP_LOGE(TAG, "ws error");
+        } else {
+            ESP_LOGW(TAG, "ws disconnected");
         }
-        return;
-    }
-    if (event_id == WEBSOCKET_EVENT_ERROR) {
-        ESP_LOGE(TAG, "ws error");
-        ws_rx_ctx_reset(r);
-        if (r->q) {
-            char *nil = NULL;
-            (void)xQueueSend(r->q, &nil, 0);
+        // 主动 close 不算端点故障；error 后通常紧跟 disconnected，只记一次
+        if (!r->closing && !r->ep_down_reported) {
+            r->ep_down_reported = true;
+            app_rb3_ep_report(r->ep_idx, false);
         }
+        r->ended = true;
+        ws_rx_ctx_reset(r);
+        ws_rx_signal_down(r);
         return;
     }
 
     if (event_id == WEBSOCKET_EVENT_DATA) {
         esp_websocket_event_data_t *d = (esp_websocket_event_data_t *)event_data;
-        if (!d || !d->data_ptr || d->data_len <= 0) return;
+        if (!d) return;
+        r->last_rx_ms = esp_log_timestamp();
+        // 控制帧（ping/pong/close）只用于存活判断，不进消息组装
+        const uint8_t op = d->op_code & 0x0F;
+        if (op == WS_TRANSPORT_OPCODES_PING || op == WS_TRANSPORT_OPCODES_PONG || op == WS_TRANSPORT_OPCODES_CLOSE) {
+            return;
+        }
+        if (!d->data_ptr || d->data_len <= 0) return;
 
         // 组装完整 payload（esp_websocket_client 可能分片回调）
         int total = (d->payload_len > 0) ? d->payload_len : d->data_len;
@@ -448,30 +597,32 @@ static void ws_event_handler(void *handler_args, esp_event_base_t base, int32_t
         // 若未来出现二进制下行，这里需要按 op_code 分支处理。
         if (offset == 0) {
             ws_rx_ctx_reset(r);
-            r->assem = (char *)malloc((size_t)total + 1);
-            if (!r->assem) return;
+            // 排队的消息可能积到窗口上限，优先放 PSRAM
+            r->assem = (app_rb3_rx_msg_t *)heap_caps_malloc_prefer(sizeof(app_rb3_rx_msg_t) + (size_t)total + 1, 2,
+                                                                   MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT,
+                                                                   MALLOC_CAP_8BIT);
+            if (!r->assem) {
+                ws_rx_count_drop(r, "no mem", total);
+                return;
+            }
             r->assem_len = total;
         }
         if (!r->assem || r->assem_len <= 0) return;
         if (offset + d->data_len > r->assem_len) {
             // 异常分片，丢弃
+            ws_rx_count_drop(r, "bad fragment", r->assem_len);
             ws_rx_ctx_reset(r);
             return;
         }
-        memcpy(r->assem + offset, d->data_ptr, (size_t)d->data_len);
+        memcpy(r->assem->data + offset, d->data_ptr, (size_t)d->data_len);
 
         if (offset + d->data_len >= r->assem_len) {
-            r->assem[r->assem_len] = '\0';
-            char *msg = r->assem;
+            app_rb3_rx_msg_t *msg = r->assem;
+            msg->len = (size_t)r->assem_len;
+            msg->data[msg->len] = '\0';
             r->assem = NULL;
             r->assem_len = 0;
-            if (r->q) {
-                if (xQueueSend(r->q, &msg, 0) != pdTRUE) {
-                    free(msg);
-                }
-            } else {
-                free(msg);
-            }
+            ws_rx_route(r, msg);
         }
     }
 }
@@ -482,8 +633,47 @@ typedef struct app_rb3_ws_sess_t {
     uint8_t *tmp;
     size_t tmp_cap;
     app_rb3_cfg_t cfg; // 保存一份 cfg（指针字段由调用方保证生命周期）
+
+    // 当前进行中的语音轮（用于 cancel）
+    char cur_req[32];
+    char cur_rid[64];
+    int voice_slot;           // send_start 登记，recv_until_last 结束/取消时释放；-1 为无
+    uint32_t cancels_sent;
+    uint32_t req_counter;     // event/query 未指定 req 时生成唯一 req
+
+    // 多个请求共用一条连接：一条消息从首帧到 FIN 期间持有，避免别的消息插进分片之间（RFC 6455 5.4）
+    SemaphoreHandle_t tx_lock;
+
+    app_rb3_ws_callbacks_t cbs;
 } app_rb3_ws_sess_t;
 
+// 发一条完整文本消息（持有发送锁）；返回写出字节数，<=0 为失败
+static int ws_send_text(app_rb3_ws_sess_t *sess, const char *msg, size_t len, int timeout_ms)
+{
+    const TickType_t to = pdMS_TO_TICKS(timeout_ms);
+    if (xSemaphoreTake(sess->tx_lock, to) != pdTRUE) {
+        ESP_LOGW(TAG, "ws send: tx lock timeout");
+        return -1;
+    }
+    int wr = esp_websocket_client_send_text(sess->client, msg, (int)len, to);
+    xSemaphoreGive(sess->tx_lock);
+    return wr;
+}
+
+// {"type":"start","req":...,"af":...,"voice":...,"model":...}（req 可为 NULL）
+static esp_err_t build_start_msg(char *buf, size_t cap, const char *req, const char *af, const char *voice,
+                                 const char *model, size_t *out_len)
+{
+    app_rb3_jw_t jw;
+    app_rb3_jw_begin(&jw, buf, cap);
+    app_rb3_jw_str(&jw, "type", "start");
+    app_rb3_jw_str(&jw, "req", req);
+    app_rb3_jw_str(&jw, "af", af);
+    app_rb3_jw_str(&jw, "voice", voice);
+    app_rb3_jw_str(&jw, "model", model);
+    return app_rb3_jw_end(&jw, out_len);
+}
+
 static esp_err_t ws_wait_connected(esp_websocket_client_handle_t client,
                                    app_rb3_should_abort_cb should_abort,
                                    void *abort_ctx,
@@ -498,14 +688,21 @@ static esp_err_t ws_wait_connected(esp_websocket_client_handle_t client,
     return ESP_OK;
 }
 
-esp_err_t app_rb3_ws_open(const app_rb3_cfg_t *cfg, app_rb3_ws_sess_t **out_sess)
+esp_err_t app_rb3_ws_open_nowait(const app_rb3_cfg_t *cfg, app_rb3_ws_sess_t **out_sess)
 {
-    ESP_RETURN_ON_FALSE(cfg && cfg->base_url && out_sess, ESP_ERR_INVALID_ARG, TAG, "arg invalid");
+    ESP_RETURN_ON_FALSE(cfg && (cfg->base_url || cfg->endpoint_count > 0) && out_sess, ESP_ERR_INVALID_ARG, TAG,
+                        "arg invalid");
     *out_sess = NULL;
 
+    const char *base = NULL;
+    const int ep = rb3_pick_base(cfg, &base);
     char ws_url[256];
-    ESP_RETURN_ON_ERROR(build_ws_url(cfg->base_url, ws_url, sizeof(ws_url)), TAG, "build ws url failed");
+    ESP_RETURN_ON_ERROR(build_ws_url(base, ws_url, sizeof(ws_url)), TAG, "build ws url failed");
+    if (ep >= 0) ESP_LOGI(TAG, "ws open -> %s", ws_url);
 
+    // ping 由 ws 任务按间隔自动发送；超时无 pong 时 client 主动断开（上层收到 DISCONNECTED）
+    const int ping_ms = cfg->ping_interval_ms > 0 ? cfg->ping_interval_ms : 10000;
+    const int pong_ms = cfg->pong_timeout_ms > 0 ? cfg->pong_timeout_ms : 4000;
     esp_websocket_client_config_t wcfg = {
         .uri = ws_url,
         .buffer_size = 8192,
@@ -514,39 +711,58 @@ esp_err_t app_rb3_ws_open(const app_rb3_cfg_t *cfg, app_rb3_ws_sess_t **out_sess
         .reconnect_timeout_ms = 0,
         .network_timeout_ms = 10000,
         .disable_auto_reconnect = true,
+        .ping_interval_sec = (ping_ms + 999) / 1000,
+        .pingpong_timeout_sec = (ping_ms + pong_ms + 999) / 1000,
     };
 
     app_rb3_ws_sess_t *s = (app_rb3_ws_sess_t *)calloc(1, sizeof(*s));
     ESP_RETURN_ON_FALSE(s, ESP_ERR_NO_MEM, TAG, "alloc sess failed");
     s->cfg = *cfg;
+    s->cfg.base_url = base;
+    s->tx_lock = xSemaphoreCreateMutex();
+    if (!s->tx_lock) {
+        free(s);
+        return ESP_ERR_NO_MEM;
+    }
 
     s->client = esp_websocket_client_init(&wcfg);
     if (!s->client) {
+        vSemaphoreDelete(s->tx_lock);
         free(s);
         return ESP_FAIL;
     }
 
-    s->rx.q = xQueueCreate(16, sizeof(char *));
-    if (!s->rx.q) {
+    if (ws_rx_ctx_init(&s->rx, (size_t)cfg->rx_window_bytes) != ESP_OK) {
         esp_websocket_client_destroy(s->client);
+        vSemaphoreDelete(s->tx_lock);
         free(s);
         return ESP_ERR_NO_MEM;
     }
-    s->rx.assem = NULL;
-    s->rx.assem_len = 0;
 
+    s->rx.ep_idx = ep;
+    s->voice_slot = -1;
     ESP_ERROR_CHECK(esp_websocket_register_events(s->client, WEBSOCKET_EVENT_ANY, ws_event_handler, &s->rx));
     esp_err_t ret = esp_websocket_client_start(s->client);
     if (ret != ESP_OK) {
-        ws_rx_ctx_reset(&s->rx);
-        vQueueDelete(s->rx.q);
+        app_rb3_ep_report(ep, false);
+        ws_rx_ctx_deinit(&s->rx);
         esp_websocket_client_destroy(s->client);
+        vSemaphoreDelete(s->tx_lock);
         free(s);
         return ret;
     }
 
+    *out_sess = s;
+    return ESP_OK;
+}
+
+esp_err_t app_rb3_ws_open(const app_rb3_cfg_t *cfg, app_rb3_ws_sess_t **out_sess)
+{
+    app_rb3_ws_sess_t *s = NULL;
+    ESP_RETURN_ON_ERROR(app_rb3_ws_open_nowait(cfg, &s), TAG, "ws open failed");
+
     // 等待连接建立
-    ret = ws_wait_connected(s->client, NULL, NULL, 5000);
+    esp_err_t ret = ws_wait_connected(s->client, NULL, NULL, 5000);
     if (ret != ESP_OK) {
         app_rb3_ws_close(s);
         return ret;
@@ -562,10 +778,31 @@ bool app_rb3_ws_is_connected(app_rb3_ws_sess_t *sess)
     return esp_websocket_client_is_connected(sess->client);
 }
 
+bool app_rb3_ws_has_ended(app_rb3_ws_sess_t *sess)
+{
+    return !sess || sess->rx.ended;
+}
+
+void app_rb3_ws_mark_broken(app_rb3_ws_sess_t *sess)
+{
+    if (!sess || sess->rx.ep_down_reported) return;
+    sess->rx.ep_down_reported = true;
+    app_rb3_ep_report(sess->rx.ep_idx, false);
+}
+
+uint32_t app_rb3_ws_rx_idle_ms(app_rb3_ws_sess_t *sess)
+{
+    if (!sess || !sess->rx.last_rx_ms) return 0;
+    return esp_log_timestamp() - sess->rx.last_rx_ms;
+}
+
 void app_rb3_ws_close(app_rb3_ws_sess_t *sess)
 {
     if (!sess) return;
 
+    // stop 期间到达的消息不再入队
+    sess->rx.closing = true;
+
     if (sess->client) {
         esp_websocket_client_stop(sess->client);
         esp_websocket_client_destroy(sess->client);
@@ -573,19 +810,12 @@ void app_rb3_ws_close(app_rb3_ws_sess_t *sess)
     }
 
     // 清空队列中的残留消息
-    if (sess->rx.q) {
-        char *rx = NULL;
-        while (xQueueReceive(sess->rx.q, &rx, 0) == pdTRUE) {
-            if (rx) free(rx);
-        }
-        vQueueDelete(sess->rx.q);
-        sess->rx.q = NULL;
-    }
-    ws_rx_ctx_reset(&sess->rx);
+    ws_rx_ctx_deinit(&sess->rx);
 
     if (sess->tmp) free(sess->tmp);
     sess->tmp = NULL;
     sess->tmp_cap = 0;
+    if (sess->tx_lock) vSemaphoreDelete(sess->tx_lock);
 
     free(sess);
 }
@@ -601,20 +831,25 @@ esp_err_t app_rb3_ws_send_start(app_rb3_ws_sess_t *sess, const char *req_id, con
     const char *model = sess->cfg.model ? sess->cfg.model : "gpt-realtime-mini";
 
     char start_msg[256];
-    int slen = 0;
-    if (req) {
-        slen = snprintf(start_msg, sizeof(start_msg),
-                        "{\"type\":\"start\",\"req\":\"%s\",\"af\":\"%s\",\"voice\":\"%s\",\"model\":\"%s\"}",
-                        req, af_out, voice, model);
-    } else {
-        slen = snprintf(start_msg, sizeof(start_msg),
-                        "{\"type\":\"start\",\"af\":\"%s\",\"voice\":\"%s\",\"model\":\"%s\"}",
-                        af_out, voice, model);
+    size_t slen = 0;
+    ESP_RETURN_ON_ERROR(build_start_msg(start_msg, sizeof(start_msg), req, af_out, voice, model, &slen),
+                        TAG, "start msg too long");
+
+    // 上一轮没走完 recv（出错返回）：结束它的路由；本轮占语音槽（不带 req 的下行也归它）
+    ws_rx_close(&sess->rx, sess->voice_slot, sess->cur_rid);
+    sess->voice_slot = ws_rx_open(&sess->rx, req, true);
+    ESP_RETURN_ON_FALSE(sess->voice_slot >= 0, ESP_ERR_INVALID_ARG, TAG, "req id too long");
+
+    int wr = ws_send_text(sess, start_msg, slen, 2000);
+    if (wr <= 0) {
+        ws_rx_close(&sess->rx, sess->voice_slot, NULL);
+        sess->voice_slot = -1;
+        return ESP_FAIL;
     }
-    ESP_RETURN_ON_FALSE(slen > 0 && slen < (int)sizeof(start_msg), ESP_ERR_INVALID_SIZE, TAG, "start msg too long");
 
-    int wr = esp_websocket_client_send_text(sess->client, start_msg, slen, pdMS_TO_TICKS(2000));
-    return (wr > 0) ? ESP_OK : ESP_FAIL;
+    safe_copy(sess->cur_req, sizeof(sess->cur_req), req, req ? strlen(req) : 0);
+    sess->cur_rid[0] = '\0';
+    return ESP_OK;
 }
 
 esp_err_t app_rb3_ws_send_bin(app_rb3_ws_sess_t *sess, const uint8_t *data, size_t len, int timeout_ms)
@@ -622,19 +857,264 @@ esp_err_t app_rb3_ws_send_bin(app_rb3_ws_sess_t *sess, const uint8_t *data, size
     ESP_RETURN_ON_FALSE(sess && sess->client && data && len > 0, ESP_ERR_INVALID_ARG, TAG, "arg invalid");
     ESP_RETURN_ON_FALSE(esp_websocket_client_is_connected(sess->client), ESP_ERR_INVALID_STATE, TAG, "ws not connected");
     if (timeout_ms <= 0) timeout_ms = 2000;
-    int wr = esp_websocket_client_send_bin(sess->client, (const char *)data, (int)len, pdMS_TO_TICKS(timeout_ms));
+    const TickType_t to = pdMS_TO_TICKS(timeout_ms);
+    ESP_RETURN_ON_FALSE(xSemaphoreTake(sess->tx_lock, to) == pdTRUE, ESP_ERR_TIMEOUT, TAG, "ws send: tx lock timeout");
+    int wr = esp_websocket_client_send_bin(sess->client, (const char *)data, (int)len, to);
+    xSemaphoreGive(sess->tx_lock);
     return (wr > 0 && wr == (int)len) ? ESP_OK : ESP_FAIL;
 }
 
+esp_err_t app_rb3_ws_send_binv(app_rb3_ws_sess_t *sess, const app_rb3_iov_t *iov, int iovcnt, int timeout_ms)
+{
+    ESP_RETURN_ON_FALSE(sess && sess->client && iov && iovcnt > 0, ESP_ERR_INVALID_ARG, TAG, "arg invalid");
+    ESP_RETURN_ON_FALSE(esp_websocket_client_is_connected(sess->client), ESP_ERR_INVALID_STATE, TAG, "ws not connected");
+    if (timeout_ms <= 0) timeout_ms = 2000;
+
+    // 跳过空段；只有一段时退化为普通 send_bin
+    int first = -1;
+    int segs = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        if (iov[i].base && iov[i].len > 0) {
+            if (first < 0) first = i;
+            segs++;
+        }
+    }
+    ESP_RETURN_ON_FALSE(segs > 0, ESP_ERR_INVALID_ARG, TAG, "empty iov");
+    if (segs == 1) {
+        return app_rb3_ws_send_bin(sess, (const uint8_t *)iov[first].base, iov[first].len, timeout_ms);
+    }
+
+    // 多段：首段 BINARY(无 FIN) + 后续 CONT(无 FIN) + 空 FIN 帧，服务端收到的仍是一条消息。
+    // 注意：esp_websocket_client 内部仍会拷贝到自己的 tx_buffer 做掩码，这里省掉的是上层的拼接拷贝。
+    // 整条消息持有发送锁：其他请求的文本帧不能插在分片之间。
+    const TickType_t to = pdMS_TO_TICKS(timeout_ms);
+    ESP_RETURN_ON_FALSE(xSemaphoreTake(sess->tx_lock, to) == pdTRUE, ESP_ERR_TIMEOUT, TAG, "ws send: tx lock timeout");
+    esp_err_t ret = ESP_OK;
+    bool started = false;
+    for (int i = first; i < iovcnt; ++i) {
+        if (!iov[i].base || iov[i].len == 0) continue;
+        const char *p = (const char *)iov[i].base;
+        const int n = (int)iov[i].len;
+        int wr = started ? esp_websocket_client_send_cont_msg(sess->client, p, n, to)
+                         : esp_websocket_client_send_bin_partial(sess->client, p, n, to);
+        if (wr != n) {
+            ESP_LOGW(TAG, "ws send binv seg %d failed, want=%d ret=%d", i, n, wr);
+            ret = ESP_FAIL;
+            break;
+        }
+        started = true;
+    }
+    // 中途失败时消息已不完整，连接只能由上层重建；FIN 也不再补发
+    if (ret == ESP_OK && esp_websocket_client_send_fin(sess->client, to) < 0) ret = ESP_FAIL;
+    xSemaphoreGive(sess->tx_lock);
+    return ret;
+}
+
 esp_err_t app_rb3_ws_send_end(app_rb3_ws_sess_t *sess)
 {
     ESP_RETURN_ON_FALSE(sess && sess->client, ESP_ERR_INVALID_ARG, TAG, "sess invalid");
     ESP_RETURN_ON_FALSE(esp_websocket_client_is_connected(sess->client), ESP_ERR_INVALID_STATE, TAG, "ws not connected");
     const char *end_msg = "{\"type\":\"end\"}";
-    int wr = esp_websocket_client_send_text(sess->client, end_msg, (int)strlen(end_msg), pdMS_TO_TICKS(2000));
+    int wr = ws_send_text(sess, end_msg, strlen(end_msg), 2000);
     return (wr > 0) ? ESP_OK : ESP_FAIL;
 }
 
+// 先登记为 retired，再发送：cancel 发出后服务端在途的分片到达时已能被过滤
+static esp_err_t ws_send_cancel_ids(app_rb3_ws_sess_t *sess, const char *req, const char *rid)
+{
+    ws_rx_retire(&sess->rx, req, rid);
+
+    char msg[160];
+    size_t mlen = 0;
+    app_rb3_jw_t jw;
+    app_rb3_jw_begin(&jw, msg, sizeof(msg));
+    app_rb3_jw_str(&jw, "type", "cancel");
+    app_rb3_jw_str(&jw, "req", req);
+    app_rb3_jw_str(&jw, "rid", (rid && rid[0]) ? rid : NULL);
+    ESP_RETURN_ON_ERROR(app_rb3_jw_end(&jw, &mlen), TAG, "cancel msg too long");
+
+    if (!esp_websocket_client_is_connected(sess->client)) return ESP_ERR_INVALID_STATE;
+    int wr = ws_send_text(sess, msg, mlen, 1000);
+    if (wr <= 0) return ESP_FAIL;
+    sess->cancels_sent++;
+    ESP_LOGI(TAG, "ws send cancel: %s", msg);
+    return ESP_OK;
+}
+
+esp_err_t app_rb3_ws_send_cancel(app_rb3_ws_sess_t *sess)
+{
+    ESP_RETURN_ON_FALSE(sess && sess->client, ESP_ERR_INVALID_ARG, TAG, "sess invalid");
+    if (!sess->cur_req[0] && !sess->cur_rid[0]) return ESP_OK; // 没有进行中的请求
+
+    char req[32], rid[64];
+    memcpy(req, sess->cur_req, sizeof(req));
+    memcpy(rid, sess->cur_rid, sizeof(rid));
+    sess->cur_req[0] = '\0';
+    sess->cur_rid[0] = '\0';
+    ws_rx_close(&sess->rx, sess->voice_slot, rid);
+    sess->voice_slot = -1;
+    return ws_send_cancel_ids(sess, req, rid);
+}
+
+void app_rb3_ws_get_stats(app_rb3_ws_sess_t *sess, app_rb3_ws_stats_t *out)
+{
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!sess) return;
+    out->cancels_sent = sess->cancels_sent;
+    app_rb3_rx_stats_t st;
+    size_t queued = 0;
+    int active = 0;
+    portENTER_CRITICAL(&sess->rx.lock);
+    app_rb3_rx_get_stats(&sess->rx.core, &st, &queued, &active);
+    out->rx_window_bytes = (uint32_t)sess->rx.core.window;
+    out->rx_overflows = sess->rx.overflows;
+    out->rx_drops = sess->rx.drops;
+    portEXIT_CRITICAL(&sess->rx.lock);
+    out->stale_msgs_dropped = st.stale_msgs;
+    out->stale_bytes_dropped = st.stale_bytes;
+    out->rx_unrouted = st.unrouted_msgs;
+    out->rx_queued_bytes = (uint32_t)queued;
+    out->req_active = (uint32_t)active;
+    out->seq_dups = st.seq_dups;
+    out->seq_reorders = st.seq_reorders;
+    out->seq_gaps = st.seq_gaps;
+}
+
+void app_rb3_ws_set_rx_window(app_rb3_ws_sess_t *sess, size_t window_bytes)
+{
+    if (!sess) return;
+    if (window_bytes < RB3_WS_RX_WINDOW_MIN) window_bytes = RB3_WS_RX_WINDOW_MIN;
+    portENTER_CRITICAL(&sess->rx.lock);
+    app_rb3_rx_set_window(&sess->rx.core, window_bytes);
+    portEXIT_CRITICAL(&sess->rx.lock);
+}
+
+void app_rb3_ws_set_callbacks(app_rb3_ws_sess_t *sess, const app_rb3_ws_callbacks_t *cbs)
+{
+    if (!sess) return;
+    if (cbs) {
+        sess->cbs = *cbs;
+    } else {
+        memset(&sess->cbs, 0, sizeof(sess->cbs));
+    }
+}
+
+// text_delta 增量拼接到 out_meta->text（满了就丢尾部）
+static void meta_text_append(app_rb3_meta_t *m, size_t *text_len, const char *p, size_t n)
+{
+    size_t cap = sizeof(m->text);
+    if (*text_len >= cap - 1) return;
+    size_t can = cap - 1 - *text_len;
+    if (n > can) n = can;
+    memcpy(m->text + *text_len, p, n);
+    *text_len += n;
+    m->text[*text_len] = '\0';
+}
+
+// 一个逻辑请求的下行处理状态（voice/event/query 共用）
+typedef struct {
+    app_rb3_meta_t *out_meta;           // 可为 NULL
+    size_t text_len;
+    const app_rb3_ws_callbacks_t *cbs;  // 只有语音轮触发会话回调
+    app_rb3_on_audio_cb on_audio;
+    void *cb_ctx;
+    uint8_t **tmp;                      // base64 解码缓冲（并发请求各用各的）
+    size_t *tmp_cap;
+    char rid[64];                       // meta 里的 rid（取消/结束时登记）
+    bool got_last;
+} ws_turn_t;
+
+static esp_err_t ws_turn_handle(ws_turn_t *t, const app_rb3_msg_t *m)
+{
+    const app_rb3_str_t *txt = &m->str[APP_RB3_F_TEXT];
+    const app_rb3_ws_callbacks_t *cbs = t->cbs;
+
+    switch (m->type) {
+    case APP_RB3_MSG_META:
+        app_rb3_json_copy(t->rid, sizeof(t->rid), m, APP_RB3_F_RID);
+        if (t->out_meta || (cbs && cbs->on_meta)) {
+            app_rb3_meta_t local;
+            app_rb3_meta_t *mt = t->out_meta ? t->out_meta : &local;
+            if (!t->out_meta) memset(&local, 0, sizeof(local));
+            app_rb3_json_copy(mt->req, sizeof(mt->req), m, APP_RB3_F_REQ);
+            app_rb3_json_copy(mt->rid, sizeof(mt->rid), m, APP_RB3_F_RID);
+            app_rb3_json_copy(mt->anim, sizeof(mt->anim), m, APP_RB3_F_ANIM);
+            app_rb3_json_copy(mt->motion, sizeof(mt->motion), m, APP_RB3_F_MOTION);
+            app_rb3_json_copy(mt->af, sizeof(mt->af), m, APP_RB3_F_AF);
+            app_rb3_json_copy(mt->ver, sizeof(mt->ver), m, APP_RB3_F_VERSION);
+            if (cbs && cbs->on_meta) cbs->on_meta(mt, cbs->ctx);
+        }
+        break;
+    case APP_RB3_MSG_ASR_TEXT:
+    case APP_RB3_MSG_TEXT:
+        if (!txt->p) break;
+        if (t->out_meta) {
+            app_rb3_json_copy(t->out_meta->text, sizeof(t->out_meta->text), m, APP_RB3_F_TEXT);
+            t->text_len = strlen(t->out_meta->text);
+        }
+        if (!cbs) break;
+        if (m->type == APP_RB3_MSG_ASR_TEXT) {
+            if (cbs->on_asr_text) cbs->on_asr_text(txt->p, txt->len, cbs->ctx);
+        } else {
+            if (cbs->on_text) cbs->on_text(txt->p, txt->len, cbs->ctx);
+        }
+        break;
+    case APP_RB3_MSG_TEXT_DELTA:
+        if (!txt->p || txt->len == 0) break;
+        if (cbs && cbs->on_text_delta) cbs->on_text_delta(txt->p, txt->len, cbs->ctx);
+        if (t->out_meta) meta_text_append(t->out_meta, &t->text_len, txt->p, txt->len);
+        break;
+    case APP_RB3_MSG_AUDIO:
+        ESP_RETURN_ON_ERROR(decode_audio_chunk(m, t->tmp, t->tmp_cap, t->on_audio, t->cb_ctx), TAG, "on_audio failed");
+        if (m->is_last) t->got_last = true;
+        break;
+    case APP_RB3_MSG_ERROR:
+        ESP_LOGW(TAG, "ws server error: %.*s", (int)m->str[APP_RB3_F_MESSAGE].len,
+                 m->str[APP_RB3_F_MESSAGE].p ? m->str[APP_RB3_F_MESSAGE].p : "");
+        break;
+    default:
+        break;
+    }
+    return ESP_OK;
+}
+
+// 在请求 slot 上收消息直到 is_last；被 should_abort 打断返回 ESP_ERR_INVALID_STATE，
+// 下行溢出返回 ESP_ERR_INVALID_SIZE，连续 cfg.timeout_ms 收不到该请求的任何消息返回 ESP_ERR_TIMEOUT
+static esp_err_t ws_turn_run(app_rb3_ws_sess_t *sess, int slot, ws_turn_t *t,
+                             app_rb3_should_abort_cb should_abort, void *abort_ctx)
+{
+    const int idle_max_ms = sess->cfg.timeout_ms > 0 ? sess->cfg.timeout_ms : 20000;
+    int idle_ms = 0;
+    while (!t->got_last) {
+        if (should_abort && should_abort(abort_ctx)) return ESP_ERR_INVALID_STATE;
+
+        app_rb3_rx_msg_t *rx = NULL;
+        app_rb3_msg_t m;
+        esp_err_t ret = ws_rx_next(&sess->rx, slot, 3000, &rx, &m);
+        if (ret == ESP_ERR_TIMEOUT) {
+            if (!esp_websocket_client_is_connected(sess->client)) return ESP_FAIL;
+            idle_ms += 3000;
+            if (idle_ms >= idle_max_ms) {
+                ESP_LOGW(TAG, "ws req slot=%d: no downlink for %d ms, give up", slot, idle_ms);
+                return ESP_ERR_TIMEOUT;
+            }
+            continue;
+        }
+        if (ret == ESP_ERR_INVALID_SIZE) {
+            ESP_LOGE(TAG, "ws req slot=%d: downlink overflowed the receive window, reply dropped", slot);
+            return ret;
+        }
+        if (ret != ESP_OK) return ret;
+        idle_ms = 0;
+
+        ret = ws_turn_handle(t, &m);
+        free(rx);
+        if (ret != ESP_OK) return ret;
+    }
+    return ESP_OK;
+}
+
 esp_err_t app_rb3_ws_recv_until_last(app_rb3_ws_sess_t *sess,
                                      app_rb3_meta_t *out_meta,
                                      app_rb3_on_audio_cb on_audio,
@@ -642,94 +1122,188 @@ esp_err_t app_rb3_ws_recv_until_last(app_rb3_ws_sess_t *sess,
                                      app_rb3_should_abort_cb should_abort,
                                      void *abort_ctx)
 {
-    ESP_RETURN_ON_FALSE(sess && sess->client && sess->rx.q && on_audio, ESP_ERR_INVALID_ARG, TAG, "arg invalid");
+    ESP_RETURN_ON_FALSE(sess && sess->client && on_audio, ESP_ERR_INVALID_ARG, TAG, "arg invalid");
     ESP_RETURN_ON_FALSE(esp_websocket_client_is_connected(sess->client), ESP_ERR_INVALID_STATE, TAG, "ws not connected");
+    ESP_RETURN_ON_FALSE(sess->voice_slot >= 0, ESP_ERR_INVALID_STATE, TAG, "no voice turn (send_start first)");
 
     if (out_meta) memset(out_meta, 0, sizeof(*out_meta));
-    size_t text_len = 0;
-    bool got_last = false;
+    ws_turn_t t = {
+        .out_meta = out_meta,
+        .cbs = &sess->cbs,
+        .on_audio = on_audio,
+        .cb_ctx = cb_ctx,
+        .tmp = &sess->tmp,
+        .tmp_cap = &sess->tmp_cap,
+    };
+    esp_err_t ret = ws_turn_run(sess, sess->voice_slot, &t, should_abort, abort_ctx);
+    if (t.rid[0]) memcpy(sess->cur_rid, t.rid, sizeof(sess->cur_rid));
 
-    while (!got_last) {
-        if (should_abort && should_abort(abort_ctx)) return ESP_ERR_INVALID_STATE;
+    if (ret != ESP_OK) {
+        // 打断/溢出/超时/回调失败：告诉服务端停止生成，残余下行在解析阶段丢弃（已断线时只结束本轮）
+        (void)app_rb3_ws_send_cancel(sess);
+        return ret;
+    }
 
-        char *rx = NULL;
-        if (xQueueReceive(sess->rx.q, &rx, pdMS_TO_TICKS(3000)) != pdTRUE) {
-            if (!esp_websocket_client_is_connected(sess->client)) return ESP_FAIL;
-            continue;
-        }
-        if (rx == NULL) {
-            return ESP_FAIL;
-        }
+    // 正常结束：该请求已完成，不再需要 cancel；晚到的重复消息按 retired 丢弃
+    ws_rx_close(&sess->rx, sess->voice_slot, sess->cur_rid);
+    sess->voice_slot = -1;
+    sess->cur_req[0] = '\0';
+    sess->cur_rid[0] = '\0';
+    return ESP_OK;
+}
 
-        char type[16] = {0};
-        json_extract_string_inplace(rx, "\"type\"", type, sizeof(type));
-        if (strcmp(type, "meta") == 0) {
-            if (out_meta) {
-                json_extract_string_inplace(rx, "\"req\"", out_meta->req, sizeof(out_meta->req));
-                json_extract_string_inplace(rx, "\"rid\"", out_meta->rid, sizeof(out_meta->rid));
-                json_extract_string_inplace(rx, "\"anim\"", out_meta->anim, sizeof(out_meta->anim));
-                json_extract_string_inplace(rx, "\"motion\"", out_meta->motion, sizeof(out_meta->motion));
-                json_extract_string_inplace(rx, "\"af\"", out_meta->af, sizeof(out_meta->af));
-            }
-        } else if (strcmp(type, "asr_text") == 0) {
-            if (out_meta) {
-                json_extract_string_inplace(rx, "\"text\"", out_meta->text, sizeof(out_meta->text));
-                text_len = strlen(out_meta->text);
-            }
-        } else if (strcmp(type, "text_delta") == 0) {
-            if (out_meta) {
-                char delta[128] = {0};
-                json_extract_string_inplace(rx, "\"text\"", delta, sizeof(delta));
-                if (delta[0]) {
-                    size_t dlen = strlen(delta);
-                    size_t cap = sizeof(out_meta->text);
-                    if (text_len < cap - 1) {
-                        size_t can = cap - 1 - text_len;
-                        if (dlen > can) dlen = can;
-                        memcpy(out_meta->text + text_len, delta, dlen);
-                        text_len += dlen;
-                        out_meta->text[text_len] = '\0';
-                    }
-                }
-            }
-        } else if (strcmp(type, "text") == 0) {
-            if (out_meta) {
-                json_extract_string_inplace(rx, "\"text\"", out_meta->text, sizeof(out_meta->text));
-                text_len = strlen(out_meta->text);
-            }
-        } else if (strcmp(type, "audio") == 0) {
-            bool is_last = json_extract_bool(rx, "\"is_last\"");
-            const char *b64 = NULL;
-            size_t b64_len = 0;
-            if (json_extract_b64_chunk(rx, "\"chunk\"", &b64, &b64_len) == ESP_OK && b64 && b64_len > 0) {
-                size_t need = (b64_len / 4) * 3 + 4;
-                if (need > sess->tmp_cap) {
-                    uint8_t *p = (uint8_t *)realloc(sess->tmp, need);
-                    if (!p) {
-                        free(rx);
-                        return ESP_ERR_NO_MEM;
-                    }
-                    sess->tmp = p;
-                    sess->tmp_cap = need;
-                }
-                size_t out_len = 0;
-                int mret = mbedtls_base64_decode(sess->tmp, sess->tmp_cap, &out_len,
-                                                 (const unsigned char *)b64, b64_len);
-                if (mret == 0 && out_len > 0) {
-                    esp_err_t cbret = on_audio(sess->tmp, out_len, is_last, cb_ctx);
-                    if (cbret != ESP_OK) {
-                        free(rx);
-                        return cbret;
-                    }
-                }
-            }
-            if (is_last) got_last = true;
-        }
+// event/query：登记 req -> 发请求 -> 收到 is_last；与语音轮并发时各走各的队列
+static esp_err_t ws_request_roundtrip(app_rb3_ws_sess_t *sess, const char *req, const char *msg, size_t mlen,
+                                      app_rb3_meta_t *out_meta, app_rb3_on_audio_cb on_audio, void *cb_ctx,
+                                      app_rb3_should_abort_cb should_abort, void *abort_ctx)
+{
+    const int slot = ws_rx_open(&sess->rx, req, false);
+    ESP_RETURN_ON_FALSE(slot >= 0, ESP_ERR_NO_MEM, TAG, "too many concurrent ws requests (max %d)", APP_RB3_RX_MAX_REQ);
 
-        free(rx);
+    int wr = ws_send_text(sess, msg, mlen, 2000);
+    if (wr <= 0) {
+        ws_rx_close(&sess->rx, slot, NULL);
+        return ESP_FAIL;
     }
 
-    return ESP_OK;
+    if (out_meta) memset(out_meta, 0, sizeof(*out_meta));
+    uint8_t *tmp = NULL;
+    size_t tmp_cap = 0;
+    ws_turn_t t = {
+        .out_meta = out_meta,
+        .on_audio = on_audio,
+        .cb_ctx = cb_ctx,
+        .tmp = &tmp,
+        .tmp_cap = &tmp_cap,
+    };
+    esp_err_t ret = ws_turn_run(sess, slot, &t, should_abort, abort_ctx);
+    free(tmp);
+
+    ws_rx_close(&sess->rx, slot, t.rid);
+    // 被打断或回调不要了：让服务端停发剩下的分片
+    if (ret != ESP_OK && !t.got_last && esp_websocket_client_is_connected(sess->client)) {
+        (void)ws_send_cancel_ids(sess, req, t.rid);
+    }
+    return ret;
+}
+
+static const char *ws_make_req(app_rb3_ws_sess_t *sess, const char *req_id, const char *prefix, char *buf, size_t sz)
+{
+    if (req_id && req_id[0]) return req_id;
+    uint32_t n = ++sess->req_counter;
+    snprintf(buf, sz, "%s_%08" PRIx32 "_%" PRIu32, prefix, esp_log_timestamp(), n);
+    return buf;
+}
+
+esp_err_t app_rb3_ws_event_stream(app_rb3_ws_sess_t *sess,
+                                  const char *event_name,
+                                  const char *req_id,
+                                  const char *user_id,
+                                  const char *if_version,
+                                  app_rb3_meta_t *out_meta,
+                                  app_rb3_on_audio_cb on_audio,
+                                  void *cb_ctx,
+                                  app_rb3_should_abort_cb should_abort,
+                                  void *abort_ctx)
+{
+    ESP_RETURN_ON_FALSE(sess && sess->client && event_name && on_audio, ESP_ERR_INVALID_ARG, TAG, "arg invalid");
+    ESP_RETURN_ON_FALSE(esp_websocket_client_is_connected(sess->client), ESP_ERR_INVALID_STATE, TAG, "ws not connected");
+
+    char req_buf[32];
+    const char *req = ws_make_req(sess, req_id, "ev", req_buf, sizeof(req_buf));
+
+    char msg[384];
+    size_t mlen = 0;
+    app_rb3_jw_t jw;
+    app_rb3_jw_begin(&jw, msg, sizeof(msg));
+    app_rb3_jw_str(&jw, "type", "event");
+    app_rb3_jw_str(&jw, "event", event_name);
+    app_rb3_jw_str(&jw, "req", req);
+    app_rb3_jw_str(&jw, "user_id", user_id ? user_id : "demo");
+    app_rb3_jw_int(&jw, "chunk_bytes", sess->cfg.chunk_bytes > 0 ? sess->cfg.chunk_bytes : 500);
+    app_rb3_jw_str(&jw, "mode", sess->cfg.mode ? sess->cfg.mode : "stream");
+    app_rb3_jw_str(&jw, "af", sess->cfg.af ? sess->cfg.af : "pcm_16k_16bit");
+    if (if_version && if_version[0]) app_rb3_jw_str(&jw, "if_version", if_version);
+    ESP_RETURN_ON_ERROR(app_rb3_jw_end(&jw, &mlen), TAG, "event msg too long");
+
+    return ws_request_roundtrip(sess, req, msg, mlen, out_meta, on_audio, cb_ctx, should_abort, abort_ctx);
+}
+
+esp_err_t app_rb3_ws_text_query(app_rb3_ws_sess_t *sess,
+                                const char *text,
+                                const char *req_id,
+                                app_rb3_meta_t *out_meta,
+                                app_rb3_on_audio_cb on_audio,
+                                void *cb_ctx,
+                                app_rb3_should_abort_cb should_abort,
+                                void *abort_ctx)
+{
+    ESP_RETURN_ON_FALSE(sess && sess->client && text && on_audio, ESP_ERR_INVALID_ARG, TAG, "arg invalid");
+    ESP_RETURN_ON_FALSE(esp_websocket_client_is_connected(sess->client), ESP_ERR_INVALID_STATE, TAG, "ws not connected");
+
+    char req_buf[32];
+    const char *req = ws_make_req(sess, req_id, "q", req_buf, sizeof(req_buf));
+
+    const size_t cap = strlen(text) * 6 + 256; // 最坏情况每字节转义成 \u00XX
+    char *msg = (char *)malloc(cap);
+    ESP_RETURN_ON_FALSE(msg, ESP_ERR_NO_MEM, TAG, "alloc query msg failed");
+    size_t mlen = 0;
+    app_rb3_jw_t jw;
+    app_rb3_jw_begin(&jw, msg, cap);
+    app_rb3_jw_str(&jw, "type", "query");
+    app_rb3_jw_str(&jw, "text", text);
+    app_rb3_jw_str(&jw, "req", req);
+    app_rb3_jw_str(&jw, "af", sess->cfg.af ? sess->cfg.af : "pcm16");
+    app_rb3_jw_str(&jw, "voice", sess->cfg.voice ? sess->cfg.voice : "alloy");
+    esp_err_t ret = app_rb3_jw_end(&jw, &mlen);
+    if (ret == ESP_OK) {
+        ret = ws_request_roundtrip(sess, req, msg, mlen, out_meta, on_audio, cb_ctx, should_abort, abort_ctx);
+    }
+    free(msg);
+    return ret;
+}
+
+esp_err_t app_rb3_ws_voice(app_rb3_ws_sess_t *sess,
+                           const uint8_t *pcm,
+                           size_t pcm_len,
+                           int send_chunk_bytes,
+                           const char *audio_format,
+                           const char *req_id,
+                           app_rb3_meta_t *out_meta,
+                           app_rb3_on_audio_cb on_audio,
+                           void *cb_ctx,
+                           app_rb3_should_abort_cb should_abort,
+                           void *abort_ctx)
+{
+    ESP_RETURN_ON_FALSE(sess && pcm && pcm_len > 0 && on_audio, ESP_ERR_INVALID_ARG, TAG, "arg invalid");
+
+    char req_buf[32];
+    const char *req = ws_make_req(sess, req_id, "v", req_buf, sizeof(req_buf));
+    ESP_RETURN_ON_ERROR(app_rb3_ws_send_start(sess, req, audio_format), TAG, "ws send start failed");
+
+    const size_t snd_chunk = (send_chunk_bytes > 0) ? (size_t)send_chunk_bytes : 4096;
+    size_t off = 0;
+    while (off < pcm_len) {
+        if (should_abort && should_abort(abort_ctx)) {
+            (void)app_rb3_ws_send_cancel(sess);
+            return ESP_ERR_INVALID_STATE;
+        }
+        size_t n = pcm_len - off;
+        if (n > snd_chunk) n = snd_chunk;
+        esp_err_t ret = app_rb3_ws_send_bin(sess, pcm + off, n, 2000);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "ws send bin failed, off=%u/%u", (unsigned)off, (unsigned)pcm_len);
+            return ret;
+        }
+        off += n;
+        // 给网络栈一点调度机会，避免长时间占用导致写失败
+        vTaskDelay(1);
+    }
+
+    if (app_rb3_ws_send_end(sess) != ESP_OK) {
+        ESP_LOGW(TAG, "ws send end failed");
+    }
+    return app_rb3_ws_recv_until_last(sess, out_meta, on_audio, cb_ctx, should_abort, abort_ctx);
 }
 
 esp_err_t app_rb3_http_voice_stream(const app_rb3_cfg_t *cfg,
@@ -743,12 +1317,14 @@ esp_err_t app_rb3_http_voice_stream(const app_rb3_cfg_t *cfg,
                                    app_rb3_on_audio_cb on_audio,
                                    void *cb_ctx)
 {
-    ESP_RETURN_ON_FALSE(cfg && cfg->base_url, ESP_ERR_INVALID_ARG, TAG, "cfg invalid");
+    ESP_RETURN_ON_FALSE(cfg && (cfg->base_url || cfg->endpoint_count > 0), ESP_ERR_INVALID_ARG, TAG, "cfg invalid");
     ESP_RETURN_ON_FALSE(pcm && pcm_len > 0 && on_audio, ESP_ERR_INVALID_ARG, TAG, "arg invalid");
 
     // build url
+    const char *base = NULL;
+    const int ep = rb3_pick_base(cfg, &base);
     char url[256];
-    int ulen = snprintf(url, sizeof(url), "%s%s", cfg->base_url, "/v1/robot/voice_rt");
+    int ulen = snprintf(url, sizeof(url), "%s%s", base, "/v1/robot/voice_rt");
     ESP_RETURN_ON_FALSE(ulen > 0 && ulen < (int)sizeof(url), ESP_ERR_INVALID_ARG, TAG, "url too long");
 
     const char *rid = req_id ? req_id : "r_voice";
@@ -785,12 +1361,25 @@ esp_err_t app_rb3_http_voice_stream(const app_rb3_cfg_t *cfg,
         free(b64);
         return ESP_ERR_NO_MEM;
     }
-    int blen = snprintf(body, body_cap,
-                        "{\"type\":\"voice\",\"audio_data\":\"%s\",\"audio_format\":\"%s\",\"language\":\"%s\","
-                        "\"req\":\"%s\",\"user_id\":\"%s\",\"chunk_bytes\":%d,\"mode\":\"%s\",\"af\":\"%s\"}",
-                        b64, af_in, lang, rid, uid, chunk_bytes, mode, af_out);
+    app_rb3_jw_t jw;
+    app_rb3_jw_begin(&jw, body, body_cap);
+    app_rb3_jw_str(&jw, "type", "voice");
+    app_rb3_jw_strn(&jw, "audio_data", b64, b64_out);
+    app_rb3_jw_str(&jw, "audio_format", af_in);
+    app_rb3_jw_str(&jw, "language", lang);
+    app_rb3_jw_str(&jw, "req", rid);
+    app_rb3_jw_str(&jw, "user_id", uid);
+    app_rb3_jw_int(&jw, "chunk_bytes", chunk_bytes);
+    app_rb3_jw_str(&jw, "mode", mode);
+    app_rb3_jw_str(&jw, "af", af_out);
+    size_t blen = 0;
+    esp_err_t jret = app_rb3_jw_end(&jw, &blen);
     free(b64);
-    ESP_RETURN_ON_FALSE(blen > 0 && (size_t)blen < body_cap, ESP_ERR_INVALID_ARG, TAG, "body too long");
+    if (jret != ESP_OK) {
+        free(body);
+        ESP_LOGE(TAG, "body too long");
+        return ESP_ERR_INVALID_ARG;
+    }
 
     rb3_resp_buf_t rb = {0};
     esp_http_client_config_t c = {
@@ -809,29 +1398,19 @@ esp_err_t app_rb3_http_voice_stream(const app_rb3_cfg_t *cfg,
     }
 
     esp_http_client_set_header(h, "Content-Type", "application/json");
-    esp_http_client_set_post_field(h, body, blen);
+    esp_http_client_set_post_field(h, body, (int)blen);
 
     esp_err_t ret = esp_http_client_perform(h);
     int status = esp_http_client_get_status_code(h);
     esp_http_client_cleanup(h);
     free(body);
+    app_rb3_ep_report(ep, ret == ESP_OK && status < 500);
 
     ESP_RETURN_ON_FALSE(ret == ESP_OK, ret, TAG, "http perform failed");
     ESP_RETURN_ON_FALSE(status >= 200 && status < 300, ESP_FAIL, TAG, "http status=%d", status);
     ESP_RETURN_ON_FALSE(rb.buf && rb.len > 0, ESP_FAIL, TAG, "empty body");
 
-    // fill meta (best-effort)
-    if (out_meta) {
-        memset(out_meta, 0, sizeof(*out_meta));
-        json_extract_string(rb.buf, "\"req\"", out_meta->req, sizeof(out_meta->req));
-        json_extract_string(rb.buf, "\"rid\"", out_meta->rid, sizeof(out_meta->rid));
-        json_extract_string(rb.buf, "\"text\"", out_meta->text, sizeof(out_meta->text));
-        json_extract_string(rb.buf, "\"anim\"", out_meta->anim, sizeof(out_meta->anim));
-        json_extract_string(rb.buf, "\"motion\"", out_meta->motion, sizeof(out_meta->motion));
-        json_extract_string(rb.buf, "\"af\"", out_meta->af, sizeof(out_meta->af));
-    }
-
-    esp_err_t cb_ret = parse_and_cb_audio_array(rb.buf, rb.len, chunk_bytes, on_audio, cb_ctx);
+    esp_err_t cb_ret = handle_http_reply(rb.buf, rb.len, out_meta, on_audio, cb_ctx);
     free(rb.buf);
     return cb_ret;
 }
@@ -850,238 +1429,18 @@ esp_err_t app_rb3_ws_voice_stream(const app_rb3_cfg_t *cfg,
                                  app_rb3_should_abort_cb should_abort,
                                  void *abort_ctx)
 {
-    ESP_RETURN_ON_FALSE(cfg && cfg->base_url, ESP_ERR_INVALID_ARG, TAG, "cfg invalid");
+    ESP_RETURN_ON_FALSE(cfg && (cfg->base_url || cfg->endpoint_count > 0), ESP_ERR_INVALID_ARG, TAG, "cfg invalid");
     ESP_RETURN_ON_FALSE(pcm && pcm_len > 0 && on_audio, ESP_ERR_INVALID_ARG, TAG, "arg invalid");
 
-    char ws_url[256];
-    ESP_RETURN_ON_ERROR(build_ws_url(cfg->base_url, ws_url, sizeof(ws_url)), TAG, "build ws url failed");
-
     (void)language;
     (void)user_id;
 
-    // voice_rt: start 参数（req/rid 可选；af/voice/model 可选）
-    const char *req = req_id; // 可为 NULL，让服务端生成
-    const char *rid = NULL;   // 目前端侧不生成 rid；如需可扩展参数
-
-    // 输出音频格式（服务端当前实现以 pcm16 输出）
-    const char *af_out = cfg->af ? cfg->af : (audio_format ? audio_format : "pcm16");
-    const char *voice = cfg->voice ? cfg->voice : "alloy";
-    const char *model = cfg->model ? cfg->model : "gpt-realtime-mini";
-
-    const int snd_chunk = (send_chunk_bytes > 0) ? send_chunk_bytes : 4096;
-
-    // start json（字段按你最新协议）
-    char start_msg[256];
-    int slen = 0;
-    if (req) {
-        slen = snprintf(start_msg, sizeof(start_msg),
-                        "{\"type\":\"start\",\"req\":\"%s\",\"af\":\"%s\",\"voice\":\"%s\",\"model\":\"%s\"}",
-                        req, af_out, voice, model);
-    } else {
-        slen = snprintf(start_msg, sizeof(start_msg),
-                        "{\"type\":\"start\",\"af\":\"%s\",\"voice\":\"%s\",\"model\":\"%s\"}",
-                        af_out, voice, model);
-    }
-    // rid 预留：若未来需要端侧指定 rid，可在这里补上
-    (void)rid;
-    ESP_RETURN_ON_FALSE(slen > 0 && slen < (int)sizeof(start_msg), ESP_ERR_INVALID_SIZE, TAG, "start msg too long");
-
-    esp_websocket_client_config_t wcfg = {
-        .uri = ws_url,
-        .buffer_size = 8192,
-        .task_stack = 4096,
-        .task_prio = 5,
-        .reconnect_timeout_ms = 0, // 我们自己控制生命周期
-        .network_timeout_ms = 10000,
-        .disable_auto_reconnect = true,
-    };
-    esp_websocket_client_handle_t client = esp_websocket_client_init(&wcfg);
-    ESP_RETURN_ON_FALSE(client, ESP_FAIL, TAG, "ws init failed");
-
-    ws_rx_ctx_t rxctx = {
-        .q = xQueueCreate(8, sizeof(char *)),
-        .assem = NULL,
-        .assem_len = 0,
-    };
-    if (!rxctx.q) {
-        esp_websocket_client_destroy(client);
-        return ESP_ERR_NO_MEM;
-    }
-    // 收消息走事件回调，避免使用不存在的同步 recv API
-    ESP_ERROR_CHECK(esp_websocket_register_events(client, WEBSOCKET_EVENT_ANY, ws_event_handler, &rxctx));
-
-    esp_err_t ret = esp_websocket_client_start(client);
-    if (ret != ESP_OK) {
-        vQueueDelete(rxctx.q);
-        esp_websocket_client_destroy(client);
-        return ret;
-    }
-
-    // 等待连接建立（简单轮询）
-    uint32_t t0 = esp_log_timestamp();
-    while (!esp_websocket_client_is_connected(client)) {
-        if (should_abort && should_abort(abort_ctx)) {
-            esp_websocket_client_stop(client);
-            esp_websocket_client_destroy(client);
-            return ESP_ERR_INVALID_STATE;
-        }
-        if ((int)(esp_log_timestamp() - t0) > 5000) {
-            esp_websocket_client_stop(client);
-            esp_websocket_client_destroy(client);
-            return ESP_ERR_TIMEOUT;
-        }
-        vTaskDelay(pdMS_TO_TICKS(20));
-    }
-
-    ESP_LOGI(TAG, "ws send start: %s", start_msg);
-    // send start (text)
-    int wst = esp_websocket_client_send_text(client, start_msg, slen, pdMS_TO_TICKS(2000));
-    if (wst <= 0) {
-        ESP_LOGE(TAG, "ws send start failed, ret=%d", wst);
-        ws_rx_ctx_reset(&rxctx);
-        vQueueDelete(rxctx.q);
-        esp_websocket_client_stop(client);
-        esp_websocket_client_destroy(client);
-        return ESP_FAIL;
-    }
-
-    // send audio (binary chunks)
-    size_t off = 0;
-    while (off < pcm_len) {
-        if (should_abort && should_abort(abort_ctx)) {
-            esp_websocket_client_stop(client);
-            esp_websocket_client_destroy(client);
-            return ESP_ERR_INVALID_STATE;
-        }
-        size_t n = pcm_len - off;
-        if (n > (size_t)snd_chunk) n = (size_t)snd_chunk;
-        int wr = esp_websocket_client_send_bin(client, (const char *)pcm + off, (int)n, pdMS_TO_TICKS(2000));
-        if (wr <= 0 || wr != (int)n) {
-            ESP_LOGE(TAG, "ws send bin failed, want=%d ret=%d off=%u/%u",
-                     (int)n, wr, (unsigned)off, (unsigned)pcm_len);
-            ws_rx_ctx_reset(&rxctx);
-            vQueueDelete(rxctx.q);
-            esp_websocket_client_stop(client);
-            esp_websocket_client_destroy(client);
-            return ESP_FAIL;
-        }
-        off += n;
-        // 给网络栈一点调度机会，避免长时间占用导致写失败
-        vTaskDelay(1);
-    }
-
-    // send end (text)
-    const char *end_msg = "{\"type\":\"end\"}";
-    int wse = esp_websocket_client_send_text(client, end_msg, (int)strlen(end_msg), pdMS_TO_TICKS(2000));
-    if (wse <= 0) {
-        ESP_LOGW(TAG, "ws send end failed, ret=%d", wse);
-    }
-
-    // recv loop：直到 audio is_last=true 或 abort
-    if (out_meta) memset(out_meta, 0, sizeof(*out_meta));
-
-    // base64 解码缓冲：按收到的 b64 长度动态扩容，避免依赖 chunk_bytes 假设
-    uint8_t *tmp = NULL;
-    size_t tmp_cap = 0;
-
-    bool got_last = false;
-    // 文本聚合：支持 text_delta（增量）和 text（整句）
-    size_t text_len = 0;
-
-    while (!got_last) {
-        if (should_abort && should_abort(abort_ctx)) {
-            free(tmp);
-            ws_rx_ctx_reset(&rxctx);
-            vQueueDelete(rxctx.q);
-            esp_websocket_client_stop(client);
-            esp_websocket_client_destroy(client);
-            return ESP_ERR_INVALID_STATE;
-        }
-
-        char *rx = NULL;
-        if (xQueueReceive(rxctx.q, &rx, pdMS_TO_TICKS(3000)) != pdTRUE) {
-            if (!esp_websocket_client_is_connected(client)) break;
-            continue;
-        }
-        if (rx == NULL) {
-            // disconnected/error signal
-            break;
-        }
-
-        // 仅处理 JSON 文本帧（服务端 audio 是 base64 字段）
-        char type[16] = {0};
-        json_extract_string_inplace(rx, "\"type\"", type, sizeof(type));
-        if (strcmp(type, "meta") == 0) {
-            if (out_meta) {
-                json_extract_string_inplace(rx, "\"req\"", out_meta->req, sizeof(out_meta->req));
-                json_extract_string_inplace(rx, "\"rid\"", out_meta->rid, sizeof(out_meta->rid));
-                json_extract_string_inplace(rx, "\"anim\"", out_meta->anim, sizeof(out_meta->anim));
-                json_extract_string_inplace(rx, "\"motion\"", out_meta->motion, sizeof(out_meta->motion));
-                json_extract_string_inplace(rx, "\"af\"", out_meta->af, sizeof(out_meta->af));
-            }
-        } else if (strcmp(type, "asr_text") == 0) {
-            if (out_meta) {
-                json_extract_string_inplace(rx, "\"text\"", out_meta->text, sizeof(out_meta->text));
-            }
-        } else if (strcmp(type, "text_delta") == 0) {
-            // 增量拼接到 out_meta->text
-            if (out_meta) {
-                char delta[128] = {0};
-                json_extract_string_inplace(rx, "\"text\"", delta, sizeof(delta));
-                if (delta[0]) {
-                    size_t dlen = strlen(delta);
-                    size_t cap = sizeof(out_meta->text);
-                    if (text_len < cap - 1) {
-                        size_t can = cap - 1 - text_len;
-                        if (dlen > can) dlen = can;
-                        memcpy(out_meta->text + text_len, delta, dlen);
-                        text_len += dlen;
-                        out_meta->text[text_len] = '\0';
-                    }
-                }
-            }
-        } else if (strcmp(type, "text") == 0) {
-            // 完整文本
-            if (out_meta) {
-                json_extract_string_inplace(rx, "\"text\"", out_meta->text, sizeof(out_meta->text));
-                text_len = strlen(out_meta->text);
-            }
-        } else if (strcmp(type, "audio") == 0) {
-            bool is_last = json_extract_bool(rx, "\"is_last\"");
-            const char *b64 = NULL;
-            size_t b64_len = 0;
-            if (json_extract_b64_chunk(rx, "\"chunk\"", &b64, &b64_len) == ESP_OK && b64 && b64_len > 0) {
-                // base64 输出上限约为 b64_len*3/4
-                size_t need = (b64_len / 4) * 3 + 4;
-                if (need > tmp_cap) {
-                    uint8_t *p = (uint8_t *)realloc(tmp, need);
-                    if (!p) {
-                        free(rx);
-                        break;
-                    }
-                    tmp = p;
-                    tmp_cap = need;
-                }
-                size_t out_len = 0;
-                int mret = mbedtls_base64_decode(tmp, tmp_cap, &out_len,
-                                                 (const unsigned char *)b64, b64_len);
-                if (mret == 0 && out_len > 0) {
-                    esp_err_t cbret = on_audio(tmp, out_len, is_last, cb_ctx);
-                    if (cbret != ESP_OK) {
-                        break;
-                    }
-                }
-            }
-            if (is_last) got_last = true;
-        }
-        free(rx);
-    }
-
-    free(tmp);
-    ws_rx_ctx_reset(&rxctx);
-    vQueueDelete(rxctx.q);
-    esp_websocket_client_stop(client);
-    esp_websocket_client_destroy(client);
-    return got_last ? ESP_OK : ESP_FAIL;
+    // 单次调用：临时会话，跑完一轮即关闭（常驻场景请直接用 app_rb3_ws_voice）
+    app_rb3_ws_sess_t *sess = NULL;
+    ESP_RETURN_ON_ERROR(app_rb3_ws_open(cfg, &sess), TAG, "ws open failed");
+    esp_err_t ret = app_rb3_ws_voice(sess, pcm, pcm_len, send_chunk_bytes, audio_format, req_id, out_meta,
+                                     on_audio, cb_ctx, should_abort, abort_ctx);
+    app_rb3_ws_close(sess);
+    return ret;
 }
 
@@ -11,8 +11,12 @@ extern "C" {
 #endif
 
 typedef struct {
-    // 例如："http://192.168.31.193:8443" 或 "https://xxx"
+    // 例如："http://192.168.31.193:8443" 或 "https://xxx"（端口按 URL，未写则用协议默认端口）
     const char *base_url;
+    // 多服务端（可选）：非空时按 /health 探测的 RTT/错误率挑最优端点，建连失败/断开后自动换端点；
+    // base_url 仅在列表为空时使用。首次用到时按默认配置启动 App_Rb3Endpoint
+    const char *const *endpoints;
+    int endpoint_count;
     // 默认 "/v1/robot/event"
     const char *event_path;
     // 默认音频格式（建议自检用 pcm，避免端上 MP3 解码依赖）
@@ -25,8 +29,13 @@ typedef struct {
     const char *mode;
     // 下行 audio 分片大小（Base64 前原始字节数），默认 500
     int chunk_bytes;
-    // HTTP 超时
+    // HTTP 超时；WS 一次回复中连续这么久收不到该请求的下行也放弃（cancel 后返回 ESP_ERR_TIMEOUT）
     int timeout_ms;
+    // WS 下行每个请求的接收窗口（队列内未消费 JSON 字节，放 PSRAM），<=0 用默认 512KB
+    int rx_window_bytes;
+    // WS 心跳：ping 间隔 / 等 pong 超时（超时 client 自动断开），<=0 用默认 10000 / 4000ms
+    int ping_interval_ms;
+    int pong_timeout_ms;
 } app_rb3_cfg_t;
 
 typedef struct {
@@ -36,15 +45,53 @@ typedef struct {
     char motion[32];
     char af[32];
     char text[256];
+    char ver[32];   // 服务端内容版本（event 回复可带 "version"，用于端上缓存校验；可为空）
 } app_rb3_meta_t;
 
+// 分段发送描述（iovec 风格）：多段拼成同一条 WS 消息
+typedef struct {
+    const void *base;
+    size_t len;
+} app_rb3_iov_t;
+
+typedef struct {
+    uint32_t cancels_sent;        // 已发送 cancel 次数
+    uint32_t stale_msgs_dropped;  // 属于已取消 req/rid、在 base64 解码前被丢弃的消息数
+    uint64_t stale_bytes_dropped; // 对应的 JSON 字节数
+
+    // 下行缓冲：每个请求各有接收窗口；ws 任务从不阻塞，控制帧总是入队，音频超过窗口时整段回复作废
+    uint32_t rx_window_bytes;     // 当前（每个请求的）接收窗口
+    uint32_t rx_queued_bytes;     // 已入队未消费
+    uint32_t rx_overflows;        // 窗口满丢弃的音频消息数（所属回复随即报错并 cancel，不带缺口播放）
+    uint32_t rx_drops;            // 丢弃消息总数（窗口满/close/内存不足/异常分片，均打日志）
+
+    // 多路复用（按 req 分流，按 seq 去重/重排）
+    uint32_t req_active;          // 当前登记的逻辑请求数
+    uint32_t rx_unrouted;         // 没有对应请求、直接丢弃的消息数（如空闲时的服务端 error）
+    uint32_t seq_dups;            // 重复 seq 丢弃数
+    uint32_t seq_reorders;        // 乱序到达、暂存后按序交付的消息数
+    uint32_t seq_gaps;            // 等不到缺失 seq、超时跳过的次数
+} app_rb3_ws_stats_t;
+
 typedef esp_err_t (*app_rb3_on_audio_cb)(const uint8_t *pcm, size_t pcm_len, bool is_last, void *ctx);
 typedef bool (*app_rb3_should_abort_cb)(void *ctx);
+
+// WS 会话下行的非音频消息：每条解析完立即回调（在 recv_until_last 调用线程上，回调内不要阻塞）
+typedef struct {
+    void (*on_meta)(const app_rb3_meta_t *meta, void *ctx);           // req/rid/anim/motion/af
+    void (*on_asr_text)(const char *text, size_t len, void *ctx);     // 用户语音识别结果
+    void (*on_text_delta)(const char *delta, size_t len, void *ctx);  // 回复文本增量（不截断）
+    void (*on_text)(const char *text, size_t len, void *ctx);         // 回复完整文本
+    void *ctx;
+} app_rb3_ws_callbacks_t;
 typedef struct app_rb3_ws_sess_t app_rb3_ws_sess_t;
 
 /**
  * @brief 发送 v3 服务端事件请求（HTTP: POST /v1/robot/event），并按序回调输出 audio 分片
  *
+ * - if_version 非空时为条件请求（请求带 "if_version"）：服务端内容版本未变则只回 meta（含 version）
+ *   和空的 audio，on_audio 不会被调用；调用方比较 out_meta->ver 判断是否未变。
+ *
  * @note 本实现是“驱动层”封装：负责 HTTP、JSON 解析、Base64 解码。
  *       播放/队列/状态机由上层 task 负责。
  */
@@ -52,6 +99,7 @@ esp_err_t app_rb3_http_event_stream(const app_rb3_cfg_t *cfg,
                                    const char *event_name,
                                    const char *req_id,
                                    const char *user_id,
+                                   const char *if_version, // 可为 NULL
                                    app_rb3_meta_t *out_meta, // 可为 NULL
                                    app_rb3_on_audio_cb on_audio,
                                    void *cb_ctx);
@@ -78,6 +126,7 @@ esp_err_t app_rb3_http_voice_stream(const app_rb3_cfg_t *cfg,
  *
  * @note 发送 start + 二进制音频分片 + end；接收 meta/audio/asr_text。
  *       若 should_abort 返回 true，会立即中断并关闭连接（用于打断/取消）。
+ *       每次调用都会新建/关闭连接；已有长连接时请用 app_rb3_ws_voice。
  */
 esp_err_t app_rb3_ws_voice_stream(const app_rb3_cfg_t *cfg,
                                  const uint8_t *pcm,
@@ -97,14 +146,74 @@ esp_err_t app_rb3_ws_voice_stream(const app_rb3_cfg_t *cfg,
  * @brief WS 会话（长连接）API：用于“等待期常连、唤醒期 start/bin/end”的模式。
  *
  * @note 目前只支持文本下行（服务端 audio 为 JSON+base64），与现有 ws_voice_stream 一致。
- *       会话保持连接：recv_until_last 返回后不会关闭连接。
+ *       会话保持连接：recv_until_last 返回后不会关闭连接；被 should_abort 打断时会向服务端发送 cancel。
+ *       下行超出接收窗口时不带缺口播放：返回 ESP_ERR_INVALID_SIZE 并 cancel（连接仍可用）。
+ *       一条连接可同时承载多个逻辑请求（语音轮 + event + query，最多 4 个），下行按 req 分流，
+ *       带 seq 的消息在各自请求内去重/重排；因此并发请求的 req 必须互不相同。
  */
 esp_err_t app_rb3_ws_open(const app_rb3_cfg_t *cfg, app_rb3_ws_sess_t **out_sess);
+
+/**
+ * @brief 只启动连接、不等待建立（立即返回）；之后用 app_rb3_ws_is_connected 轮询
+ */
+esp_err_t app_rb3_ws_open_nowait(const app_rb3_cfg_t *cfg, app_rb3_ws_sess_t **out_sess);
 bool app_rb3_ws_is_connected(app_rb3_ws_sess_t *sess);
+
+/**
+ * @brief 会话已结束（握手被拒/建连出错/连上后断开）：不自动重连，不必再等它连上
+ */
+bool app_rb3_ws_has_ended(app_rb3_ws_sess_t *sess);
+
+/**
+ * @brief 标记会话已坏（建连超时/心跳超时/发送失败）：计入所属端点的错误率，之后新会话会避开它
+ */
+void app_rb3_ws_mark_broken(app_rb3_ws_sess_t *sess);
+
+/**
+ * @brief 距最近一次收到任何帧（数据/pong）的毫秒数；尚未连上返回 0
+ */
+uint32_t app_rb3_ws_rx_idle_ms(app_rb3_ws_sess_t *sess);
 void app_rb3_ws_close(app_rb3_ws_sess_t *sess);
 esp_err_t app_rb3_ws_send_start(app_rb3_ws_sess_t *sess, const char *req_id, const char *audio_format);
 esp_err_t app_rb3_ws_send_bin(app_rb3_ws_sess_t *sess, const uint8_t *data, size_t len, int timeout_ms);
+
+/**
+ * @brief 把多段内存作为“一条” WS 二进制消息发送（分片帧 + FIN），调用方无需先拷贝拼接
+ *
+ * @note 典型用法：环形缓冲回绕时两段直接发送，省掉 bounce buffer。
+ *       发送期间调用方需保证各段内容不被改写。
+ */
+esp_err_t app_rb3_ws_send_binv(app_rb3_ws_sess_t *sess, const app_rb3_iov_t *iov, int iovcnt, int timeout_ms);
 esp_err_t app_rb3_ws_send_end(app_rb3_ws_sess_t *sess);
+
+/**
+ * @brief 通知服务端取消当前回复（{"type":"cancel","req":...,"rid":...}）
+ *
+ * @note req 取自最近一次 send_start，rid 取自下行 meta；之后属于该 req/rid 的下行消息
+ *       会在解析阶段直接丢弃（不做 base64 解码、不进回调）。
+ *       recv_until_last 出错返回（打断/下行溢出/超时/回调失败）时会自动调用本函数。
+ */
+esp_err_t app_rb3_ws_send_cancel(app_rb3_ws_sess_t *sess);
+void app_rb3_ws_get_stats(app_rb3_ws_sess_t *sess, app_rb3_ws_stats_t *out);
+
+/**
+ * @brief 设置下行接收窗口（字节，按 JSON 计）
+ *
+ * @note 每个进行中的请求各用一份窗口，一个请求消费慢不占用其他请求的额度。
+ *       ws 任务不会为窗口阻塞（它同时负责 ping/pong 与发送）：控制帧总是入队，音频超出窗口时
+ *       丢弃并计入 rx_overflows，该请求的接收随即返回 ESP_ERR_INVALID_SIZE（已 cancel）。
+ *       上层按播放缓冲余量放宽窗口（cfg.rx_window_bytes + 余量），使“播放环 + 队列”积压的总量固定；
+ *       队列为空时总允许一条消息。
+ */
+void app_rb3_ws_set_rx_window(app_rb3_ws_sess_t *sess, size_t window_bytes);
+
+/**
+ * @brief 设置会话的类型化回调（meta/asr_text/text_delta/text），NULL 清除
+ *
+ * @note 回调在解析到对应消息时立即触发（早于音频播放），用于表情/动作提前调度。
+ *       文本指针仅在回调期间有效；out_meta 的填充行为不变（text 仍截断为 256 字节）。
+ */
+void app_rb3_ws_set_callbacks(app_rb3_ws_sess_t *sess, const app_rb3_ws_callbacks_t *cbs);
 esp_err_t app_rb3_ws_recv_until_last(app_rb3_ws_sess_t *sess,
                                      app_rb3_meta_t *out_meta,  // 可为 NULL
                                      app_rb3_on_audio_cb on_audio,
@@ -112,6 +221,52 @@ esp_err_t app_rb3_ws_recv_until_last(app_rb3_ws_sess_t *sess,
                                      app_rb3_should_abort_cb should_abort,
                                      void *abort_ctx);
 
+/**
+ * @brief 在已打开的会话上完成一轮语音：start + 二进制分片 + end + 收到 is_last
+ *
+ * @note req_id 为 NULL 时自动生成；会话回调（set_callbacks）照常触发。
+ */
+esp_err_t app_rb3_ws_voice(app_rb3_ws_sess_t *sess,
+                           const uint8_t *pcm,
+                           size_t pcm_len,
+                           int send_chunk_bytes,
+                           const char *audio_format,
+                           const char *req_id,
+                           app_rb3_meta_t *out_meta,  // 可为 NULL
+                           app_rb3_on_audio_cb on_audio,
+                           void *cb_ctx,
+                           app_rb3_should_abort_cb should_abort,
+                           void *abort_ctx);
+
+/**
+ * @brief 在会话上触发服务端事件（{"type":"event",...}），回复与 HTTP 版字段一致（含 if_version 条件请求）
+ *
+ * @note 可与进行中的语音轮并发（不同任务调用）；不触发会话回调，结果在 out_meta。
+ *       req_id 为 NULL 时自动生成；被 should_abort 打断或 on_audio 返回错误时发送该 req 的 cancel。
+ */
+esp_err_t app_rb3_ws_event_stream(app_rb3_ws_sess_t *sess,
+                                  const char *event_name,
+                                  const char *req_id,
+                                  const char *user_id,
+                                  const char *if_version, // 可为 NULL
+                                  app_rb3_meta_t *out_meta, // 可为 NULL
+                                  app_rb3_on_audio_cb on_audio,
+                                  void *cb_ctx,
+                                  app_rb3_should_abort_cb should_abort,
+                                  void *abort_ctx);
+
+/**
+ * @brief 在会话上发文本提问（{"type":"query","text":...}），下行与语音轮相同（meta/text/audio）
+ */
+esp_err_t app_rb3_ws_text_query(app_rb3_ws_sess_t *sess,
+                                const char *text,
+                                const char *req_id,
+                                app_rb3_meta_t *out_meta, // 可为 NULL
+                                app_rb3_on_audio_cb on_audio,
+                                void *cb_ctx,
+                                app_rb3_should_abort_cb should_abort,
+                                void *abort_ctx);
+
 /**
  * @brief 默认配置（只填 base_url 即可用）
  */
@@ -9,7 +9,11 @@
  #include "esp_check.h"
  #include "esp_log.h"
  
- #include "App_Speak_Sound.h"
+#include "App_Agc.h"
+ #include "App_CapFmt.h"
+#include "App_Ns.h"
+#include "App_PcmOps.h"
+#include "App_Speak_Sound.h"
  
  typedef struct {
      app_speak_state_cfg_t cfg;
@@ -18,6 +22,13 @@
  
      TaskHandle_t task;
      volatile app_speak_state_t state;
+ 
+     app_beamform_t bf;
+     volatile bool bf_on;
+    app_ns_t ns;
+    volatile bool ns_on;
+    app_agc_t agc;
+    volatile bool agc_on;
  } speak_state_ctx_t;
  
  static speak_state_ctx_t s_ctx = {0};
@@ -36,6 +47,18 @@
          .log_state_change = true,
         .on_audio = NULL,
         .on_audio_ctx = NULL,
+        .on_ref = NULL,
+        .on_ref_ctx = NULL,
+        .beamform = false,
+        .beam_mic_distance_mm = 60,
+        .noise_suppress = false,
+        .ns_max_atten_db = 12,
+        .agc = false,
+        .agc_target_dbfs = -20,
+        .agc_max_gain_db = 24,
+        .agc_coarse = false,
+        .agc_mic_gain_min_db = 18,
+        .agc_mic_gain_max_db = 42,
      };
      return c;
  }
@@ -52,6 +75,12 @@
      }
  }
  
+static esp_err_t agc_set_mic_gain(int db, void *ctx)
+{
+    (void)ctx;
+    return app_speak_sound_set_mic_gain(db);
+}
+
  static void task_speak_state(void *arg)
  {
      (void)arg;
@@ -65,29 +94,82 @@
      const int window_ms = (s_ctx.cfg.window_ms > 0) ? s_ctx.cfg.window_ms : 500;
  
      const int sr = (acfg.sample_rate > 0) ? acfg.sample_rate : 16000;
-     const int ch = (acfg.channels > 0) ? acfg.channels : 1;
-     const int bps = (acfg.bits_per_sample > 0) ? acfg.bits_per_sample : 16;
-     const int bytes_per_sample = bps / 8;
- 
-     const int samples_per_frame = (sr * frame_ms) / 1000;
-     const int bytes_per_frame = samples_per_frame * ch * bytes_per_sample;
- 
-     uint8_t *frame = (uint8_t *)malloc((size_t)bytes_per_frame);
-     if (!frame) {
-         ESP_LOGE(TAG, "alloc frame failed (%d bytes)", bytes_per_frame);
-         vTaskDelete(NULL);
-         return;
-     }
- 
-     const int64_t target_samples = ((int64_t)sr * (int64_t)ch * (int64_t)window_ms) / 1000;
-     if (target_samples <= 0) {
-         ESP_LOGE(TAG, "bad window_ms=%d", window_ms);
-         free(frame);
-         vTaskDelete(NULL);
-         return;
-     }
- 
-     ESP_LOGI(TAG, "start: window=%dms frame=%dms th=%d on=%d off=%d",
+    const int ch = (acfg.mic_channels > 0) ? acfg.mic_channels : ((acfg.channels > 0) ? acfg.channels : 1);
+    const int bps = (acfg.mic_bits > 0) ? acfg.mic_bits : ((acfg.bits_per_sample > 0) ? acfg.bits_per_sample : 16);
+
+    app_cap_fmt_t fmt;
+    if (app_cap_fmt_init(&fmt, ch, bps, acfg.mic_layout) != ESP_OK) {
+        ESP_LOGE(TAG, "unsupported capture format %dch/%dbit %s", ch, bps, acfg.mic_layout ? acfg.mic_layout : "");
+        vTaskDelete(NULL);
+        return;
+    }
+    const bool want_ref = s_ctx.cfg.on_ref && fmt.ref >= 0;
+
+    // 参数先校验完再初始化前端（波束/降噪/AGC），出错时无需逐个回滚
+    const int64_t target_samples = ((int64_t)sr * (int64_t)window_ms) / 1000;
+    if (target_samples <= 0) {
+        ESP_LOGE(TAG, "bad window_ms=%d", window_ms);
+        vTaskDelete(NULL);
+        return;
+    }
+
+    const int samples_per_frame = (sr * frame_ms) / 1000;
+    const int bytes_per_frame = samples_per_frame * fmt.frame_bytes;
+    const int mono_bytes = samples_per_frame * (int)sizeof(int16_t);
+
+    // 原始帧 + 单声道麦克风 + 参考 + 第二路麦克风，一次分配
+    uint8_t *frame = (uint8_t *)malloc((size_t)bytes_per_frame + (size_t)mono_bytes * 3);
+    if (!frame) {
+        ESP_LOGE(TAG, "alloc frame failed (%d bytes)", bytes_per_frame + mono_bytes * 3);
+        vTaskDelete(NULL);
+        return;
+    }
+    int16_t *mic = (int16_t *)(frame + bytes_per_frame);
+    int16_t *ref = mic + samples_per_frame;
+    int16_t *mic1 = ref + samples_per_frame;
+
+    if (s_ctx.cfg.beamform && fmt.split) {
+        app_beamform_cfg_t bcfg = app_beamform_cfg_default(sr);
+        bcfg.mic_distance_mm = s_ctx.cfg.beam_mic_distance_mm;
+        bcfg.max_frame = samples_per_frame;
+        if (app_beamform_init(&s_ctx.bf, &bcfg) == ESP_OK) {
+            s_ctx.bf_on = true;
+            ESP_LOGI(TAG, "beamform on: %d mm, max lag %d", bcfg.mic_distance_mm, s_ctx.bf.max_lag);
+        } else {
+            ESP_LOGW(TAG, "beamform init failed, fall back to mic average");
+        }
+    }
+    if (s_ctx.cfg.noise_suppress) {
+        app_ns_cfg_t ncfg = app_ns_cfg_default(sr);
+        ncfg.frame_ms = frame_ms;
+        ncfg.max_atten_db = s_ctx.cfg.ns_max_atten_db;
+        if (app_ns_init(&s_ctx.ns, &ncfg) == ESP_OK) {
+            s_ctx.ns_on = true;
+        } else {
+            ESP_LOGW(TAG, "noise suppressor init failed, run without it");
+        }
+    }
+    if (s_ctx.cfg.agc) {
+        app_agc_cfg_t gcfg = app_agc_cfg_default(sr);
+        gcfg.target_dbfs = s_ctx.cfg.agc_target_dbfs;
+        gcfg.max_gain_db = s_ctx.cfg.agc_max_gain_db;
+        gcfg.coarse_db = acfg.mic_gain_db;
+        if (s_ctx.cfg.agc_coarse) {
+            // 粗调在本任务里走 I2C，几毫秒内完成，DMA 缓冲兜得住
+            gcfg.set_coarse = agc_set_mic_gain;
+            gcfg.coarse_min_db = s_ctx.cfg.agc_mic_gain_min_db;
+            gcfg.coarse_max_db = s_ctx.cfg.agc_mic_gain_max_db;
+        }
+        if (app_agc_init(&s_ctx.agc, &gcfg) == ESP_OK) {
+            s_ctx.agc_on = true;
+        } else {
+            ESP_LOGW(TAG, "agc init failed, run with fixed gain");
+        }
+    }
+
+    ESP_LOGI(TAG, "capture %dch/%dbit %s -> mono s16, kernel=%s, ref=%s", ch, bps,
+             acfg.mic_layout ? acfg.mic_layout : "", fmt.kernel_name, (fmt.ref >= 0) ? "yes" : "no");
+    ESP_LOGI(TAG, "start: window=%dms frame=%dms th=%d on=%d off=%d",
               window_ms,
               frame_ms,
               s_ctx.cfg.th_avg_abs,
@@ -112,28 +194,33 @@
              continue;
          }
  
+        if (s_ctx.bf_on) {
+            app_cap_fmt_split(&fmt, frame, samples_per_frame, mic, mic1, want_ref ? ref : NULL);
+            app_beamform_process(&s_ctx.bf, mic, mic1, samples_per_frame, mic);
+        } else {
+            app_cap_fmt_convert(&fmt, frame, samples_per_frame, mic, want_ref ? ref : NULL);
+        }
+        if (s_ctx.ns_on) {
+            app_ns_process(&s_ctx.ns, mic, samples_per_frame);
+        }
+        if (s_ctx.agc_on) {
+            app_agc_process(&s_ctx.agc, mic, samples_per_frame);
+        }
+
         if (s_ctx.cfg.on_audio) {
             // 注意：回调在本任务上下文执行，需尽量短小，避免阻塞 mic 读取
-            s_ctx.cfg.on_audio(frame, bytes_per_frame, s_ctx.cfg.on_audio_ctx);
+            s_ctx.cfg.on_audio((const uint8_t *)mic, mono_bytes, s_ctx.cfg.on_audio_ctx);
+        }
+        if (want_ref) {
+            s_ctx.cfg.on_ref((const uint8_t *)ref, mono_bytes, s_ctx.cfg.on_ref_ctx);
         }
 
-         if (bps == 16) {
-             const int16_t *x = (const int16_t *)frame;
-             const int n = samples_per_frame * ch;
-             for (int i = 0; i < n; ++i) {
-                 int32_t v = x[i];
-                 if (v < 0) v = -v;
-                 sum_abs += v;
-             }
-             n_samp += n;
-         } else {
-             // 退化：按字节统计
-             for (int i = 0; i < bytes_per_frame; ++i) {
-                 sum_abs += frame[i];
-             }
-             n_samp += bytes_per_frame;
-         }
- 
+        // VAD 电平折回基准增益：AGC 放大的底噪不会误开口
+        uint64_t frame_abs = app_pcm_sum_abs(mic, samples_per_frame);
+        if (s_ctx.agc_on) frame_abs = (frame_abs * (uint64_t)app_agc_vad_scale_q12(&s_ctx.agc)) >> 12;
+        sum_abs += (int64_t)frame_abs;
+        n_samp += samples_per_frame;
+
          if (n_samp >= target_samples) {
              const int32_t avg_abs = (n_samp > 0) ? (int32_t)(sum_abs / n_samp) : 0;
              const bool voiced = (avg_abs > s_ctx.cfg.th_avg_abs);
@@ -151,6 +238,29 @@
                      is_speaking = false;
                      on_cnt = 0;
                      emit_state(APP_SPEAK_STATE_SILENT);
+                     if (s_ctx.bf_on) {
+                         app_beamform_stats_t bs;
+                         app_beamform_get_stats(&s_ctx.bf, &bs);
+                         ESP_LOGI(TAG, "beam: doa=%.0f deg lag=%d updates=%u cycles avg=%u max=%u over_budget=%u",
+                                  (double)bs.doa_deg, bs.lag, (unsigned)bs.doa_updates, (unsigned)bs.cycles_avg,
+                                  (unsigned)bs.cycles_max, (unsigned)bs.over_budget);
+                     }
+                    if (s_ctx.ns_on) {
+                        app_ns_stats_t ns;
+                        app_ns_get_stats(&s_ctx.ns, &ns);
+                        ESP_LOGI(TAG, "ns: atten=%.1f dB noise=%.0f dBFS cycles avg=%u max=%u over_budget=%u%s",
+                                 (double)ns.atten_db, (double)ns.noise_dbfs, (unsigned)ns.cycles_avg,
+                                 (unsigned)ns.cycles_max, (unsigned)ns.over_budget, s_ctx.ns.bypass ? " (bypass)" : "");
+                    }
+                    if (s_ctx.agc_on) {
+                        app_agc_stats_t gs;
+                        app_agc_get_stats(&s_ctx.agc, &gs);
+                        ESP_LOGI(TAG, "agc: gain=%.1f dB limit=%.1f dB level=%.0f dBFS codec=%d dB (up %u down %u) "
+                                      "limiter=%u clips=%u cycles avg=%u max=%u",
+                                 (double)gs.gain_db, (double)gs.limit_db, (double)gs.level_dbfs, gs.coarse_db,
+                                 (unsigned)gs.coarse_ups, (unsigned)gs.coarse_downs, (unsigned)gs.limiter_hits,
+                                 (unsigned)gs.in_clips, (unsigned)gs.cycles_avg, (unsigned)gs.cycles_max);
+                    }
                  }
              }
  
@@ -194,3 +304,35 @@
      return s_ctx.state;
  }
  
+
+esp_err_t app_speak_state_get_beam_stats(app_beamform_stats_t *out)
+{
+    ESP_RETURN_ON_FALSE(out, ESP_ERR_INVALID_ARG, "SpeakState", "out null");
+    if (!s_ctx.bf_on) return ESP_ERR_INVALID_STATE;
+    app_beamform_get_stats(&s_ctx.bf, out);
+    return ESP_OK;
+}
+
+esp_err_t app_speak_state_set_ns_bypass(bool bypass)
+{
+    if (!s_ctx.ns_on) return ESP_ERR_INVALID_STATE;
+    app_ns_set_bypass(&s_ctx.ns, bypass);
+    ESP_LOGI(s_ctx.cfg.log_tag, "ns %s", bypass ? "bypass" : "on");
+    return ESP_OK;
+}
+
+esp_err_t app_speak_state_get_ns_stats(app_ns_stats_t *out)
+{
+    ESP_RETURN_ON_FALSE(out, ESP_ERR_INVALID_ARG, "SpeakState", "out null");
+    if (!s_ctx.ns_on) return ESP_ERR_INVALID_STATE;
+    app_ns_get_stats(&s_ctx.ns, out);
+    return ESP_OK;
+}
+
+esp_err_t app_speak_state_get_agc_stats(app_agc_stats_t *out)
+{
+    ESP_RETURN_ON_FALSE(out, ESP_ERR_INVALID_ARG, "SpeakState", "out null");
+    if (!s_ctx.agc_on) return ESP_ERR_INVALID_STATE;
+    app_agc_get_stats(&s_ctx.agc, out);
+    return ESP_OK;
+}
@@ -2,6 +2,10 @@
  
  #include <stdbool.h>
  #include "esp_err.h"
+
+#include "App_Agc.h"
+#include "App_Beamform.h"
+#include "App_Ns.h"
  
  #ifdef __cplusplus
  extern "C" {
@@ -34,8 +38,29 @@ typedef void (*app_speak_state_on_audio_cb_t)(const uint8_t *pcm, int pcm_len, v
      bool log_state_change;       // 默认 true
 
     // 可选：每次成功读取一帧麦克风数据都会回调（回调需尽量轻量，勿阻塞）
+    // 数据已按采集格式转换为单声道 s16（多路麦克风取平均），采样率同 app_speak_sound_cfg_t
     app_speak_state_on_audio_cb_t on_audio;
     void *on_audio_ctx;
+
+    // 可选：采集布局里有回采参考 lane（'R'）时，每帧同步回调一次参考信号（单声道 s16）
+    app_speak_state_on_audio_cb_t on_ref;
+    void *on_ref_ctx;
+
+    // 采集布局里有 >= 2 路麦克风时，用双麦波束代替简单平均（VAD 与 on_audio 都用波束输出）
+    bool beamform;               // 默认 false：会改变 VAD 输入电平，由调用方显式打开
+    int beam_mic_distance_mm;    // 默认 60
+
+    // 频域降噪：波束/下混之后、VAD 与 on_audio 之前；输出比 on_ref 参考晚一个窗长（20ms）
+    bool noise_suppress;         // 默认 false
+    int ns_max_atten_db;         // 默认 12
+
+    // 自动增益：降噪之后、VAD 与 on_audio 之前；VAD 按 AGC 增益折算电平，th_avg_abs 仍指基准增益下的电平
+    bool agc;                    // 默认 false
+    int agc_target_dbfs;         // 语音 RMS 目标，默认 -20
+    int agc_max_gain_db;         // 默认 24
+    bool agc_coarse;             // 默认 false；true：数字增益长时间偏大 / 偏小时经 I2C 调 codec 输入增益
+    int agc_mic_gain_min_db;     // 粗调范围，默认 18..42（codec 会再截到自身支持的范围）
+    int agc_mic_gain_max_db;
  } app_speak_state_cfg_t;
  
  app_speak_state_cfg_t app_speak_state_cfg_default(void);
@@ -51,6 +76,26 @@ typedef void (*app_speak_state_on_audio_cb_t)(const uint8_t *pcm, int pcm_len, v
                                  void *cb_ctx);
  
  app_speak_state_t app_speak_state_get(void);
+
+/**
+ * @brief 波束统计（方向、单帧 CPU 周期）；未启用波束返回 ESP_ERR_INVALID_STATE
+ */
+esp_err_t app_speak_state_get_beam_stats(app_beamform_stats_t *out);
+
+/**
+ * @brief 降噪旁路开关（运行中可切换）；未启用降噪返回 ESP_ERR_INVALID_STATE
+ */
+esp_err_t app_speak_state_set_ns_bypass(bool bypass);
+
+/**
+ * @brief 降噪统计（衰减量、每跳 CPU 周期）；未启用降噪返回 ESP_ERR_INVALID_STATE
+ */
+esp_err_t app_speak_state_get_ns_stats(app_ns_stats_t *out);
+
+/**
+ * @brief AGC 统计（增益、限幅、codec 档位、每帧 CPU 周期）；未启用 AGC 返回 ESP_ERR_INVALID_STATE
+ */
+esp_err_t app_speak_state_get_agc_stats(app_agc_stats_t *out);
  
  #ifdef __cplusplus
  }
@@ -1,20 +1,33 @@
 #include "App_Speak_Sound.h"
 
-#include <math.h>
+#include <inttypes.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/ringbuf.h"
 
 #include "esp_check.h"
+#include "esp_cpu.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
+#include "esp_timer.h"
 
 #include "bsp/esp-bsp.h"          // Waveshare BSP entry
 #include "esp_codec_dev.h"        // device handle + read/write
 
+#include "App_PcmOps.h"
+
 static const char *TAG = "App_Speak_Sound";
 
+// BSP 的 I2S 通道按默认配置创建：6 个 DMA 描述符 × 240 帧，已提交未播出的样本最多这么多
+#define SPK_DMA_DESC_FRAMES 240
+#define SPK_DMA_FRAMES (6 * SPK_DMA_DESC_FRAMES)
+#define SPK_FADE_STEPS 4
+#define SPK_EQ_OVER_BLOCKS 3
+
 static esp_codec_dev_handle_t s_spk = NULL;
 static esp_codec_dev_handle_t s_mic = NULL;
 static app_speak_sound_cfg_t s_cfg = {
@@ -51,6 +64,8 @@ esp_err_t app_speak_sound_init(const app_speak_sound_cfg_t *cfg)
     if (cfg) {
         s_cfg = *cfg;
     }
+    if (s_cfg.mic_channels <= 0) s_cfg.mic_channels = s_cfg.channels;
+    if (s_cfg.mic_bits <= 0) s_cfg.mic_bits = s_cfg.bits_per_sample;
 
     // 关键：Waveshare BSP 的 bsp_audio_codec_*_init() 只有在 i2s_data_if==NULL 时才会调用 bsp_i2c_init()
     // 我们这里先调用 bsp_audio_init() 会导致 i2s_data_if 非空，从而跳过 I2C 初始化，最终 speaker_init 里 i2c_handle 为 NULL 并触发 assert。
@@ -91,15 +106,41 @@ esp_err_t app_speak_sound_init(const app_speak_sound_cfg_t *cfg)
     ESP_RETURN_ON_ERROR(esp_codec_dev_set_out_mute(s_spk, false), TAG, "set spk mute failed");
     ESP_RETURN_ON_ERROR(esp_codec_dev_open(s_spk, &fs), TAG, "open spk failed");
 
-    // mic
-    ESP_RETURN_ON_ERROR(esp_codec_dev_open(s_mic, &fs), TAG, "open mic failed");
+    // mic：采集格式可以与喇叭不同（多声道/32bit），采样率保持一致
+    esp_codec_dev_sample_info_t fs_mic = fs;
+    fs_mic.channel = (uint8_t)s_cfg.mic_channels;
+    fs_mic.bits_per_sample = (uint8_t)s_cfg.mic_bits;
+    ESP_RETURN_ON_ERROR(esp_codec_dev_open(s_mic, &fs_mic), TAG, "open mic failed");
     // 说明：不同 codec 对 gain 的单位/范围不完全一致，这里 best-effort。
     (void)esp_codec_dev_set_in_gain(s_mic, s_cfg.mic_gain_db);
 
-    ESP_LOGI(TAG, "audio inited: %d Hz, ch=%d, bits=%d", s_cfg.sample_rate, s_cfg.channels, s_cfg.bits_per_sample);
+    ESP_LOGI(TAG, "audio inited: %d Hz, ch=%d, bits=%d, mic %dch/%dbit %s", s_cfg.sample_rate, s_cfg.channels,
+             s_cfg.bits_per_sample, s_cfg.mic_channels, s_cfg.mic_bits, s_cfg.mic_layout ? s_cfg.mic_layout : "");
+    return ESP_OK;
+}
+
+esp_err_t app_speak_sound_set_mic_gain(int db)
+{
+    ESP_RETURN_ON_FALSE(s_mic, ESP_ERR_INVALID_STATE, TAG, "mic not init");
+    int ret;
+    const char *l = s_cfg.mic_layout;
+    if (l && strchr(l, 'R')) {
+        // lane 下标即 codec 输入通道
+        uint16_t mask = 0;
+        for (int i = 0; l[i] && i < 16; ++i) {
+            if (l[i] == 'M') mask |= ESP_CODEC_DEV_MAKE_CHANNEL_MASK(i);
+        }
+        ret = esp_codec_dev_set_in_channel_gain(s_mic, mask, (float)db);
+    } else {
+        ret = esp_codec_dev_set_in_gain(s_mic, (float)db);
+    }
+    ESP_RETURN_ON_FALSE(ret == ESP_CODEC_DEV_OK, ESP_FAIL, TAG, "set mic gain %d dB failed: %d", db, ret);
+    s_cfg.mic_gain_db = db;
     return ESP_OK;
 }
 
+static bool spk_out_running(void);
+
 esp_err_t app_speak_sound_play_tone(int freq_hz, int duration_ms)
 {
     ESP_RETURN_ON_FALSE(s_spk, ESP_ERR_INVALID_STATE, TAG, "speaker not init");
@@ -107,7 +148,8 @@ esp_err_t app_speak_sound_play_tone(int freq_hz, int duration_ms)
 
     const int sr = s_cfg.sample_rate;
     const int ch = s_cfg.channels;
-    const int16_t amp = 12000;
+    app_pcm_nco_t nco;
+    app_pcm_nco_init(&nco, freq_hz, sr, 12000);
 
     const int samples_total = (sr * duration_ms) / 1000;
     const int chunk_samples = 512; // 每次写 512 帧
@@ -120,20 +162,12 @@ esp_err_t app_speak_sound_play_tone(int freq_hz, int duration_ms)
         int n = chunk_samples;
         if (sent + n > samples_total) n = samples_total - sent;
 
-        for (int i = 0; i < n; ++i) {
-            float t = (float)(sent + i) / (float)sr;
-            float s = sinf(2.0f * (float)M_PI * (float)freq_hz * t);
-            int16_t v = (int16_t)((float)amp * s);
-            if (ch == 2) {
-                buf[i * 2] = v;
-                buf[i * 2 + 1] = v;
-            } else {
-                buf[i] = v;
-            }
-        }
+        app_pcm_nco_run(&nco, buf, n, ch);
 
         size_t bytes = (size_t)n * (size_t)ch * sizeof(int16_t);
-        esp_err_t err = esp_codec_dev_write(s_spk, (const uint8_t *)buf, bytes);
+        // 混音器运行时作为提示音混入（不再与回复抢 codec）
+        esp_err_t err = spk_out_running() ? app_speak_sound_stream_play(APP_SPK_STREAM_EARCON, buf, bytes)
+                                          : esp_codec_dev_write(s_spk, (const uint8_t *)buf, bytes);
         if (err != ESP_OK) {
             heap_caps_free(buf);
             return err;
@@ -183,7 +217,7 @@ esp_err_t app_speak_sound_play_pcm(const void *buf, size_t bytes)
     size_t left = bytes;
     while (left > 0) {
         size_t chunk = left > 2048 ? 2048 : left;
-        esp_err_t err = esp_codec_dev_write(s_spk, p, chunk);
+        esp_err_t err = app_speak_sound_spk_write(p, chunk);
         if (err != ESP_OK) return err;
         p += chunk;
         left -= chunk;
@@ -198,9 +232,601 @@ esp_err_t app_speak_sound_mic_read(void *buf, size_t bytes)
     return esp_codec_dev_read(s_mic, (uint8_t *)buf, bytes);
 }
 
+// 喇叭只能有一个写者：混音器启动后直接写入改走 TTS 流
 esp_err_t app_speak_sound_spk_write(const void *buf, size_t bytes)
 {
     ESP_RETURN_ON_FALSE(s_spk, ESP_ERR_INVALID_STATE, TAG, "speaker not init");
     ESP_RETURN_ON_FALSE(buf && bytes > 0, ESP_ERR_INVALID_ARG, TAG, "bad args");
-    return esp_codec_dev_write(s_spk, (const uint8_t *)buf, bytes);
+    return app_speak_sound_stream_play(APP_SPK_STREAM_TTS, buf, bytes);
+}
+
+// 分步降音量（每步一次 I2C 写）后静音：DMA 里的样本无法撤回，只能在 codec 端淡出，避免截断爆音
+// 按系统节拍分级淡出（vTaskDelay 让出 CPU，不忙等）：fade_ms 不足一拍时降一级、等到下一拍再静音
+static void spk_fade_mute(int fade_ms)
+{
+    if (fade_ms > 0) {
+        int steps = fade_ms / (int)portTICK_PERIOD_MS;
+        if (steps < 1) steps = 1;
+        if (steps > SPK_FADE_STEPS - 1) steps = SPK_FADE_STEPS - 1;
+        const TickType_t step_ticks = pdMS_TO_TICKS((uint32_t)(fade_ms / steps));
+        for (int i = steps; i > 0; --i) {
+            (void)esp_codec_dev_set_out_vol(s_spk, s_cfg.volume * i / (steps + 1));
+            vTaskDelay(step_ticks > 0 ? step_ticks : 1);
+        }
+    }
+    (void)esp_codec_dev_set_out_mute(s_spk, true);
+}
+
+// 静音下写一整段 DMA 深度的 0，把排队的旧样本顶出去，再恢复音量（恢复后旧样本不会再冒出来）
+static void spk_flush_unmute(void)
+{
+    static const uint8_t zeros[512] = {0};
+    const size_t frame = (size_t)s_cfg.channels * (size_t)(s_cfg.bits_per_sample / 8);
+    size_t left = (size_t)SPK_DMA_FRAMES * frame;
+    while (left > 0) {
+        size_t n = left > sizeof(zeros) ? sizeof(zeros) : left;
+        if (esp_codec_dev_write(s_spk, zeros, n) != ESP_OK) break;
+        left -= n;
+    }
+    (void)esp_codec_dev_set_out_vol(s_spk, s_cfg.volume);
+    (void)esp_codec_dev_set_out_mute(s_spk, false);
+}
+
+typedef struct {
+    RingbufHandle_t fifo;       // 字节环形缓冲：生产者 xRingbufferSend，混音任务按块读出
+    size_t cap;
+    size_t chunk;               // 单次 send 上限（cap 的一半，整帧），FIFO 半空即可推进
+    int16_t *buf;               // 本块从 FIFO 读出的数据
+    // 以下由 lock 保护
+    int64_t t_first_us;         // 空闲后第一次写入的时刻，0 表示没有待测的延迟
+    bool short_prev;            // 上一块数据不够一块
+    app_spk_stream_stats_t st;
+} spk_stream_t;
+
+typedef struct {
+    bool started;
+    app_spk_out_cfg_t cfg;
+    TaskHandle_t task;
+    size_t frame_bytes;
+    size_t block_bytes;
+    spk_stream_t ss[APP_SPK_STREAM_MAX];
+    int16_t *mixbuf;            // block_frames + 限幅前瞻（收尾时补零把延迟线推出来）
+    app_spk_mix_t mix;
+    app_spk_eq_t eq;
+    bool eq_on;
+    bool eq_tail;               // 延迟线里还有没推出来的样本
+    bool eq_lim_off;            // 运行时关限幅：等下一块把延迟线推出来再关，不丢样本
+    float eq_budget_cyc;        // 每帧的 CPU 预算
+    int eq_over_run;
+    SemaphoreHandle_t mix_mux;  // 保护 mix / eq 与 FIFO 读出 / 清空
+    volatile uint32_t gen;      // 打断代号：混好后代号变了的块不写
+    volatile bool need_flush;
+
+    // 以下由 lock 保护：DMA 水位模型 + 统计
+    portMUX_TYPE lock;
+    uint32_t active_mask;       // 混音器眼里活跃的流
+    uint32_t inflight_frames;   // 已混好、正在写 codec 的帧
+    uint32_t dma_frames;        // 最近一次写完时 DMA 中估计的帧数
+    int64_t dma_t_us;
+    app_spk_out_stats_t st;
+} spk_out_t;
+
+static spk_out_t s_out = {
+    .lock = portMUX_INITIALIZER_UNLOCKED,
+};
+
+app_spk_out_cfg_t app_speak_sound_out_cfg_default(void)
+{
+    const int bf = 2 * SPK_DMA_DESC_FRAMES;
+    const app_spk_mix_cfg_t mc = app_spk_mix_cfg_default(s_cfg.sample_rate, bf);
+    app_spk_out_cfg_t c = {
+        .block_frames = bf,
+        .task_prio = 7,
+        .eq_enable = true,
+        .eq = app_spk_eq_cfg_default(s_cfg.sample_rate, s_cfg.channels),
+        .eq_budget_pct = 3.0f,
+    };
+    for (int s = 0; s < APP_SPK_STREAM_MAX; ++s) {
+        // TTS 按网络节奏到达，多留一些余量
+        c.streams[s].fifo_frames = ((s == APP_SPK_STREAM_TTS) ? 6 : 3) * bf;
+        c.streams[s].duck_db = mc.streams[s].duck_db;
+        c.streams[s].ramp_ms = mc.streams[s].ramp_ms;
+    }
+    return c;
+}
+
+static bool spk_out_running(void)
+{
+    return s_out.started;
+}
+
+// 调用方需持 lock：按采样率推算 DMA 里还剩多少帧没播
+static uint32_t spk_out_dma_level_locked(int64_t now_us)
+{
+    uint64_t drained = (uint64_t)(now_us - s_out.dma_t_us) * (uint64_t)s_cfg.sample_rate / 1000000ULL;
+    return (drained >= s_out.dma_frames) ? 0 : (uint32_t)(s_out.dma_frames - drained);
+}
+
+static inline size_t spk_fifo_bytes(const spk_stream_t *ss)
+{
+    const size_t free_bytes = xRingbufferGetCurFreeSize(ss->fifo);
+    return (free_bytes >= ss->cap) ? 0 : ss->cap - free_bytes;
+}
+
+// 回绕时分两段读；dst 为 NULL 时只丢弃
+static size_t spk_fifo_read(spk_stream_t *ss, uint8_t *dst, size_t want)
+{
+    size_t got = 0;
+    while (got < want) {
+        size_t n = 0;
+        uint8_t *p = (uint8_t *)xRingbufferReceiveUpTo(ss->fifo, &n, 0, want - got);
+        if (!p) break;
+        if (dst) memcpy(dst + got, p, n);
+        vRingbufferReturnItem(ss->fifo, p);
+        got += n;
+    }
+    return got;
+}
+
+static void spk_out_flush_if_needed(void)
+{
+    // 打断后的第一块新数据之前（或空闲时）清掉 DMA 里的旧样本并恢复音量
+    if (!s_out.need_flush) return;
+    spk_flush_unmute();
+    portENTER_CRITICAL(&s_out.lock);
+    s_out.dma_frames = 0;
+    s_out.dma_t_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&s_out.lock);
+    s_out.need_flush = false;
+}
+
+static void spk_out_write_block(const int16_t *pcm, uint32_t n, uint32_t delay_frames,
+                                const int64_t t_first[APP_SPK_STREAM_MAX])
+{
+    portENTER_CRITICAL(&s_out.lock);
+    const int64_t t0 = esp_timer_get_time();
+    const uint32_t level0 = spk_out_dma_level_locked(t0);
+    portEXIT_CRITICAL(&s_out.lock);
+
+    // 整块一次写入：codec 驱动拷进 DMA，DMA 满时在这里阻塞
+    (void)esp_codec_dev_write(s_spk, (const uint8_t *)pcm, (int)(n * s_out.frame_bytes));
+    const int64_t t1 = esp_timer_get_time();
+
+    // 写完时 DMA 水位 = 原水位 + 本块 - 期间播出，且不超过 DMA 深度（阻塞返回说明刚好填满）
+    uint64_t drained = (uint64_t)(t1 - t0) * (uint64_t)s_cfg.sample_rate / 1000000ULL;
+    uint64_t level = (uint64_t)level0 + n;
+    level = (level > drained) ? level - drained : 0;
+    if (level > SPK_DMA_FRAMES) level = SPK_DMA_FRAMES;
+    // 块首样本的播出时刻：写入时 DMA 里排在它前面的样本播完，再加限幅的前瞻延迟
+    const int64_t t_play = t0 + (int64_t)(level0 + delay_frames) * 1000000 / s_cfg.sample_rate;
+
+    portENTER_CRITICAL(&s_out.lock);
+    if (level0 == 0 && s_out.st.frames_written > 0) s_out.st.underruns++;
+    s_out.inflight_frames = 0;
+    s_out.dma_frames = (uint32_t)level;
+    s_out.dma_t_us = t1;
+    s_out.st.frames_written += n;
+    s_out.st.writes++;
+    uint32_t us = (uint32_t)(t1 - t0);
+    s_out.st.write_us_avg = s_out.st.write_us_avg ? (s_out.st.write_us_avg * 7 + us) / 8 : us;
+    for (int s = 0; s < APP_SPK_STREAM_MAX; ++s) {
+        if (t_first[s] == 0) continue;
+        app_spk_stream_stats_t *st = &s_out.ss[s].st;
+        const uint32_t ms = (t_play > t_first[s]) ? (uint32_t)((t_play - t_first[s]) / 1000) : 0;
+        st->latency_ms_last = ms;
+        st->latency_ms_avg = st->latency_ms_avg ? (st->latency_ms_avg * 7 + ms) / 8 : ms;
+        if (ms > st->latency_ms_max) st->latency_ms_max = ms;
+    }
+    portEXIT_CRITICAL(&s_out.lock);
+}
+
+// 调用方需持 mix_mux：限幅已推空后真正关掉（保留降级后的段数）
+static void spk_eq_limiter_off(void)
+{
+    app_spk_eq_cfg_t c = s_out.eq.cfg;
+    const int bands = s_out.eq.n_active;
+    c.limiter = false;
+    (void)app_spk_eq_set(&s_out.eq, &c);
+    app_spk_eq_set_active_bands(&s_out.eq, bands);
+    s_out.eq_lim_off = false;
+}
+
+// 调用方需持 mix_mux：EQ + 限幅处理 mixbuf，返回限幅延迟帧数；数据不满一块（收尾）或要关限幅时
+// 补零把延迟线推出来（mixbuf 按最大前瞻留了余量）
+static int spk_eq_run(int *n_out)
+{
+    const int la = app_spk_eq_latency_frames(&s_out.eq);
+    int n = *n_out;
+    if (la > 0 && (n < s_out.cfg.block_frames || s_out.eq_lim_off)) {
+        memset(s_out.mixbuf + (size_t)n * (size_t)s_cfg.channels, 0, (size_t)la * s_out.frame_bytes);
+        n += la;
+        s_out.eq_tail = false;
+    } else if (la > 0) {
+        s_out.eq_tail = true;
+    }
+    const uint32_t c0 = esp_cpu_get_cycle_count();
+    app_spk_eq_process(&s_out.eq, s_out.mixbuf, n);
+    const uint32_t cyc = esp_cpu_get_cycle_count() - c0;
+    *n_out = n;
+    if (s_out.eq_lim_off) spk_eq_limiter_off();
+
+    // 连续超预算：从末尾减一段 EQ（限幅保护喇叭，不减）
+    const bool over = (float)cyc > s_out.eq_budget_cyc * (float)n;
+    s_out.eq_over_run = over ? s_out.eq_over_run + 1 : 0;
+    if (s_out.eq_over_run >= SPK_EQ_OVER_BLOCKS && s_out.eq.n_active > 0) {
+        app_spk_eq_set_active_bands(&s_out.eq, s_out.eq.n_active - 1);
+        s_out.eq_over_run = 0;
+        ESP_LOGW(TAG, "eq over budget (%" PRIu32 " cycles / %d frames), running %d bands", cyc, n, s_out.eq.n_active);
+    }
+
+    portENTER_CRITICAL(&s_out.lock);
+    app_spk_out_stats_t *st = &s_out.st;
+    st->eq_cycles_avg = st->eq_cycles_avg ? (st->eq_cycles_avg * 15 + cyc) / 16 : cyc;
+    if (cyc > st->eq_cycles_max) st->eq_cycles_max = cyc;
+    if (over) st->eq_over_budget++;
+    st->eq_bands = s_out.eq.n_active;
+    portEXIT_CRITICAL(&s_out.lock);
+    return la;
+}
+
+// 混一块并写出：某路攒够整块才混，allow_partial 时只有零头也送出；没混返回 false
+static bool spk_mix_block(bool allow_partial)
+{
+    const size_t fb = s_out.frame_bytes;
+    const int bf = s_out.cfg.block_frames;
+    int frames[APP_SPK_STREAM_MAX];
+    const int16_t *src[APP_SPK_STREAM_MAX];
+    bool full = false, any = false;
+    for (int s = 0; s < APP_SPK_STREAM_MAX; ++s) {
+        const size_t q = spk_fifo_bytes(&s_out.ss[s]) / fb;
+        frames[s] = (q > (size_t)bf) ? bf : (int)q;
+        full |= (frames[s] == bf);
+        any |= (frames[s] > 0);
+    }
+    if (!full && !(allow_partial && (any || s_out.eq_tail))) return false;
+
+    xSemaphoreTake(s_out.mix_mux, portMAX_DELAY);
+    const uint32_t gen = s_out.gen;
+    for (int s = 0; s < APP_SPK_STREAM_MAX; ++s) {
+        spk_stream_t *ss = &s_out.ss[s];
+        frames[s] = (int)(spk_fifo_read(ss, (uint8_t *)ss->buf, (size_t)frames[s] * fb) / fb);
+        src[s] = ss->buf;
+    }
+    int n_out = 0;
+    const uint32_t muted = app_spk_mix_run(&s_out.mix, src, frames, s_out.mixbuf, &n_out);
+    uint32_t dropped[APP_SPK_STREAM_MAX] = {0};
+    uint32_t act = 0;
+    float gain[APP_SPK_STREAM_MAX];
+    for (int s = 0; s < APP_SPK_STREAM_MAX; ++s) {
+        // 已被闪避到静音的流（回复开始后的填充音）：剩余数据不再播
+        if (muted & (1u << s)) dropped[s] = (uint32_t)(spk_fifo_read(&s_out.ss[s], NULL, s_out.ss[s].cap) / fb);
+        if (app_spk_mix_active(&s_out.mix, (app_spk_stream_t)s)) act |= 1u << s;
+        gain[s] = app_spk_mix_gain(&s_out.mix, (app_spk_stream_t)s);
+    }
+    const app_spk_mix_stats_t ms = s_out.mix.st;
+    const float load = app_spk_mix_load_pct(&s_out.mix, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+    uint32_t eq_delay = 0;
+    if (s_out.eq_on) {
+        eq_delay = (uint32_t)spk_eq_run(&n_out);
+    }
+    xSemaphoreGive(s_out.mix_mux);
+
+    int64_t t_first[APP_SPK_STREAM_MAX] = {0};
+    portENTER_CRITICAL(&s_out.lock);
+    s_out.active_mask = act;
+    for (int s = 0; s < APP_SPK_STREAM_MAX; ++s) {
+        spk_stream_t *ss = &s_out.ss[s];
+        if (frames[s] > 0) {
+            if (ss->short_prev) ss->st.underruns++;
+            ss->short_prev = frames[s] < bf;
+            t_first[s] = ss->t_first_us;
+            ss->t_first_us = 0;
+        } else if (!(act & (1u << s))) {
+            ss->short_prev = false;
+        }
+        ss->st.frames_mixed += (uint64_t)frames[s];
+        ss->st.frames_dropped += dropped[s];
+        ss->st.gain = gain[s];
+    }
+    s_out.st.mix_cycles_avg = ms.cycles_avg;
+    s_out.st.mix_cycles_max = ms.cycles_max;
+    s_out.st.mix_load_pct = load;
+    s_out.inflight_frames = (uint32_t)n_out;
+    portEXIT_CRITICAL(&s_out.lock);
+
+    if (gen != s_out.gen) {
+        // 混的时候被打断：这块不写
+        portENTER_CRITICAL(&s_out.lock);
+        s_out.inflight_frames = 0;
+        s_out.st.blocks_dropped++;
+        portEXIT_CRITICAL(&s_out.lock);
+        return true;
+    }
+    spk_out_flush_if_needed();
+    if (n_out > 0) spk_out_write_block(s_out.mixbuf, (uint32_t)n_out, eq_delay, t_first);
+    return true;
+}
+
+static bool spk_out_fifo_any(void)
+{
+    for (int s = 0; s < APP_SPK_STREAM_MAX; ++s) {
+        if (spk_fifo_bytes(&s_out.ss[s]) >= s_out.frame_bytes) return true;
+    }
+    return false;
+}
+
+static void task_spk_mix(void *arg)
+{
+    (void)arg;
+    // 只有零头时等半块时长没有新数据就送出（回复尾巴/断流），不让它卡在 FIFO 里
+    const TickType_t starve = pdMS_TO_TICKS((uint32_t)s_out.cfg.block_frames * 500U / (uint32_t)s_cfg.sample_rate) + 1;
+    bool pending = false;
+    while (1) {
+        const bool woke = ulTaskNotifyTake(pdTRUE, pending ? starve : portMAX_DELAY) > 0;
+        spk_out_flush_if_needed();
+        while (spk_mix_block(!woke)) {
+        }
+        pending = spk_out_fifo_any() || s_out.eq_tail;
+    }
+}
+
+esp_err_t app_speak_sound_out_start(const app_spk_out_cfg_t *cfg)
+{
+    ESP_RETURN_ON_FALSE(s_spk, ESP_ERR_INVALID_STATE, TAG, "speaker not init");
+    ESP_RETURN_ON_FALSE(!s_out.started, ESP_ERR_INVALID_STATE, TAG, "out already started");
+
+    app_spk_out_cfg_t def = app_speak_sound_out_cfg_default();
+    s_out.cfg = cfg ? *cfg : def;
+    if (s_out.cfg.block_frames <= 0) s_out.cfg.block_frames = def.block_frames;
+    if (s_out.cfg.task_prio <= 0) s_out.cfg.task_prio = def.task_prio;
+    const int bf = s_out.cfg.block_frames;
+
+    s_out.frame_bytes = (size_t)s_cfg.channels * (size_t)(s_cfg.bits_per_sample / 8);
+    s_out.block_bytes = (size_t)bf * s_out.frame_bytes;
+
+    app_spk_mix_cfg_t mc = app_spk_mix_cfg_default(s_cfg.sample_rate, bf);
+    mc.channels = s_cfg.channels;
+    for (int s = 0; s < APP_SPK_STREAM_MAX; ++s) {
+        app_spk_stream_cfg_t *sc = &s_out.cfg.streams[s];
+        if (sc->fifo_frames <= 0) sc->fifo_frames = def.streams[s].fifo_frames;
+        // 至少两块：一块在混，一块在填
+        if (sc->fifo_frames < 2 * bf) sc->fifo_frames = 2 * bf;
+        mc.streams[s].duck_db = sc->duck_db;
+        mc.streams[s].ramp_ms = sc->ramp_ms;
+    }
+    ESP_RETURN_ON_ERROR(app_spk_mix_init(&s_out.mix, &mc), TAG, "mix init failed");
+
+    s_out.eq_on = s_out.cfg.eq_enable;
+    if (s_out.eq_on) {
+        app_spk_eq_cfg_t ec = s_out.cfg.eq;
+        ec.sample_rate = s_cfg.sample_rate;
+        ec.channels = s_cfg.channels;
+        ESP_RETURN_ON_FALSE(app_spk_eq_init(&s_out.eq, &ec), ESP_ERR_INVALID_ARG, TAG, "eq init failed");
+        if (s_out.cfg.eq_budget_pct <= 0) s_out.cfg.eq_budget_pct = def.eq_budget_pct;
+        s_out.eq_budget_cyc = s_out.cfg.eq_budget_pct / 100.0f * (float)CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1e6f /
+                              (float)s_cfg.sample_rate;
+        s_out.st.eq_bands = s_out.eq.n_active;
+    }
+
+    size_t fifo_total = 0;
+    for (int s = 0; s < APP_SPK_STREAM_MAX; ++s) {
+        spk_stream_t *ss = &s_out.ss[s];
+        ss->cap = (size_t)s_out.cfg.streams[s].fifo_frames * s_out.frame_bytes;
+        ss->chunk = ss->cap / 2 / s_out.frame_bytes * s_out.frame_bytes;
+        ss->fifo = xRingbufferCreate(ss->cap, RINGBUF_TYPE_BYTEBUF);
+        ss->buf = (int16_t *)heap_caps_malloc(s_out.block_bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        ESP_RETURN_ON_FALSE(ss->fifo && ss->buf, ESP_ERR_NO_MEM, TAG, "stream %s alloc failed",
+                            app_spk_mix_stream_name((app_spk_stream_t)s));
+        fifo_total += ss->cap;
+    }
+    // 限幅可在运行时打开（set_eq），余量按最大前瞻留，不按启动时的配置
+    s_out.mixbuf = (int16_t *)heap_caps_malloc(
+        s_out.block_bytes + (s_out.eq_on ? (size_t)APP_SPK_EQ_MAX_LA_FRAMES * s_out.frame_bytes : 0),
+        MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    s_out.mix_mux = xSemaphoreCreateMutex();
+    ESP_RETURN_ON_FALSE(s_out.mixbuf && s_out.mix_mux, ESP_ERR_NO_MEM, TAG, "out alloc failed");
+
+    if (xTaskCreate(task_spk_mix, "task_spk_mix", 3072, NULL, s_out.cfg.task_prio, &s_out.task) != pdPASS) {
+        return ESP_FAIL;
+    }
+    s_out.started = true;
+    ESP_LOGI(TAG, "spk mixer: %d streams, block %d frames (%u bytes), fifo %u bytes total", APP_SPK_STREAM_MAX, bf,
+             (unsigned)s_out.block_bytes, (unsigned)fifo_total);
+    if (s_out.eq_on) {
+        ESP_LOGI(TAG, "spk eq: %d bands, pre %.1f dB, limiter %s %.1f dBFS (+%d frames), budget %.1f%%",
+                 s_out.eq.cfg.n_bands, (double)s_out.eq.cfg.pre_gain_db, s_out.eq.cfg.limiter ? "on" : "off",
+                 (double)s_out.eq.cfg.limit_dbfs, app_spk_eq_latency_frames(&s_out.eq),
+                 (double)s_out.cfg.eq_budget_pct);
+    }
+    return ESP_OK;
+}
+
+size_t app_speak_sound_stream_write(app_spk_stream_t s, const void *buf, size_t bytes, TickType_t wait)
+{
+    if (!s_out.started || !buf || s >= APP_SPK_STREAM_MAX) return 0;
+    spk_stream_t *ss = &s_out.ss[s];
+    const uint8_t *p = (const uint8_t *)buf;
+    size_t done = 0;
+    while (done < bytes) {
+        size_t n = bytes - done;
+        if (n > ss->chunk) n = ss->chunk;
+        // 空闲后的第一段：发送前记时刻（混音任务可能在这边拿到锁之前就读走）
+        bool first = false;
+        if (spk_fifo_bytes(ss) == 0) {
+            portENTER_CRITICAL(&s_out.lock);
+            if (!(s_out.active_mask & (1u << s)) && ss->t_first_us == 0) {
+                ss->t_first_us = esp_timer_get_time();
+                first = true;
+            }
+            portEXIT_CRITICAL(&s_out.lock);
+        }
+        const bool ok = xRingbufferSend(ss->fifo, p + done, n, wait) == pdTRUE;
+        portENTER_CRITICAL(&s_out.lock);
+        if (ok) {
+            ss->st.frames_in += n / s_out.frame_bytes;
+            if (first) ss->st.starts++;
+        } else if (first) {
+            ss->t_first_us = 0;
+        }
+        portEXIT_CRITICAL(&s_out.lock);
+        if (!ok) break;
+        done += n;
+        xTaskNotifyGive(s_out.task);
+    }
+    return done;
+}
+
+esp_err_t app_speak_sound_stream_play(app_spk_stream_t s, const void *buf, size_t bytes)
+{
+    ESP_RETURN_ON_FALSE(s_spk, ESP_ERR_INVALID_STATE, TAG, "speaker not init");
+    ESP_RETURN_ON_FALSE(buf && bytes > 0 && s < APP_SPK_STREAM_MAX, ESP_ERR_INVALID_ARG, TAG, "bad args");
+    if (!s_out.started) return esp_codec_dev_write(s_spk, (const uint8_t *)buf, (int)bytes);
+    return (app_speak_sound_stream_write(s, buf, bytes, portMAX_DELAY) == bytes) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t app_speak_sound_out_set_eq(const app_spk_eq_cfg_t *cfg)
+{
+    ESP_RETURN_ON_FALSE(s_out.started && s_out.eq_on, ESP_ERR_INVALID_STATE, TAG, "eq not running");
+    ESP_RETURN_ON_FALSE(cfg, ESP_ERR_INVALID_ARG, TAG, "bad args");
+    app_spk_eq_cfg_t c = *cfg;
+    xSemaphoreTake(s_out.mix_mux, portMAX_DELAY);
+    // 关限幅时延迟线里可能还有样本：先保持开着，由混音任务推空后再关
+    s_out.eq_lim_off = !c.limiter && s_out.eq.cfg.limiter && s_out.eq_tail;
+    if (s_out.eq_lim_off) c.limiter = true;
+    const bool ok = app_spk_eq_set(&s_out.eq, &c);
+    if (!ok) s_out.eq_lim_off = false;
+    s_out.eq_over_run = 0;
+    const int bands = s_out.eq.n_active;
+    xSemaphoreGive(s_out.mix_mux);
+    ESP_RETURN_ON_FALSE(ok, ESP_ERR_INVALID_ARG, TAG, "bad eq cfg");
+    portENTER_CRITICAL(&s_out.lock);
+    s_out.st.eq_bands = bands;
+    portEXIT_CRITICAL(&s_out.lock);
+    return ESP_OK;
+}
+
+void app_speak_sound_out_get_eq_stats(app_spk_eq_stats_t *out)
+{
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!s_out.started || !s_out.eq_on) return;
+    xSemaphoreTake(s_out.mix_mux, portMAX_DELAY);
+    app_spk_eq_get_stats(&s_out.eq, out);
+    xSemaphoreGive(s_out.mix_mux);
+}
+
+size_t app_speak_sound_out_write(const void *buf, size_t bytes, TickType_t wait)
+{
+    return app_speak_sound_stream_write(APP_SPK_STREAM_TTS, buf, bytes, wait);
+}
+
+// 调用方需持 mix_mux：清空一路 FIFO 并停止它的闪避
+static void spk_stream_drop_locked(app_spk_stream_t s)
+{
+    spk_stream_t *ss = &s_out.ss[s];
+    const uint32_t n = (uint32_t)(spk_fifo_read(ss, NULL, ss->cap) / s_out.frame_bytes);
+    app_spk_mix_reset_stream(&s_out.mix, s);
+    portENTER_CRITICAL(&s_out.lock);
+    ss->st.frames_dropped += n;
+    ss->t_first_us = 0;
+    ss->short_prev = false;
+    s_out.active_mask &= ~(1u << s);
+    portEXIT_CRITICAL(&s_out.lock);
+}
+
+esp_err_t app_speak_sound_stream_cancel(app_spk_stream_t s)
+{
+    ESP_RETURN_ON_FALSE(s_out.started, ESP_ERR_INVALID_STATE, TAG, "out not started");
+    ESP_RETURN_ON_FALSE(s < APP_SPK_STREAM_MAX, ESP_ERR_INVALID_ARG, TAG, "bad stream");
+    xSemaphoreTake(s_out.mix_mux, portMAX_DELAY);
+    spk_stream_drop_locked(s);
+    xSemaphoreGive(s_out.mix_mux);
+    return ESP_OK;
+}
+
+esp_err_t app_speak_sound_stream_set_gain(app_spk_stream_t s, float gain)
+{
+    ESP_RETURN_ON_FALSE(s_out.started, ESP_ERR_INVALID_STATE, TAG, "out not started");
+    ESP_RETURN_ON_FALSE(s < APP_SPK_STREAM_MAX, ESP_ERR_INVALID_ARG, TAG, "bad stream");
+    xSemaphoreTake(s_out.mix_mux, portMAX_DELAY);
+    app_spk_mix_set_gain(&s_out.mix, s, gain);
+    xSemaphoreGive(s_out.mix_mux);
+    return ESP_OK;
+}
+
+esp_err_t app_speak_sound_out_set_volume(float gain)
+{
+    ESP_RETURN_ON_FALSE(s_out.started, ESP_ERR_INVALID_STATE, TAG, "out not started");
+    xSemaphoreTake(s_out.mix_mux, portMAX_DELAY);
+    app_spk_mix_set_master(&s_out.mix, gain);
+    xSemaphoreGive(s_out.mix_mux);
+    return ESP_OK;
+}
+
+esp_err_t app_speak_sound_out_cancel(int fade_ms, int64_t *out_silent_us)
+{
+    ESP_RETURN_ON_FALSE(s_out.started, ESP_ERR_INVALID_STATE, TAG, "out not started");
+
+    const bool audible = app_speak_sound_out_pending_frames() > 0;
+    // 代号 +1：已混好未写出的块由混音任务丢弃；FIFO 里的数据这里就丢
+    xSemaphoreTake(s_out.mix_mux, portMAX_DELAY);
+    s_out.gen++;
+    for (int s = 0; s < APP_SPK_STREAM_MAX; ++s) spk_stream_drop_locked((app_spk_stream_t)s);
+    if (s_out.eq_on) {
+        // 延迟线里是被打断的旧样本：清掉，不再推出来
+        app_spk_eq_reset(&s_out.eq);
+        s_out.eq_tail = false;
+        if (s_out.eq_lim_off) spk_eq_limiter_off();
+    }
+    xSemaphoreGive(s_out.mix_mux);
+
+    if (audible) {
+        spk_fade_mute(fade_ms);
+        s_out.need_flush = true;
+        xTaskNotifyGive(s_out.task);
+    }
+    if (out_silent_us) *out_silent_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_out.lock);
+    s_out.st.cancels++;
+    portEXIT_CRITICAL(&s_out.lock);
+    return ESP_OK;
+}
+
+uint32_t app_speak_sound_out_pending_frames(void)
+{
+    if (!s_out.started) return 0;
+    size_t q = 0;
+    for (int s = 0; s < APP_SPK_STREAM_MAX; ++s) {
+        const size_t b = spk_fifo_bytes(&s_out.ss[s]);
+        if (b > q) q = b;
+    }
+    portENTER_CRITICAL(&s_out.lock);
+    uint32_t n = (uint32_t)(q / s_out.frame_bytes) + s_out.inflight_frames +
+                 spk_out_dma_level_locked(esp_timer_get_time());
+    if (s_out.eq_tail) n += (uint32_t)app_spk_eq_latency_frames(&s_out.eq);
+    portEXIT_CRITICAL(&s_out.lock);
+    return n;
+}
+
+void app_speak_sound_out_get_stats(app_spk_out_stats_t *out)
+{
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!s_out.started) return;
+    portENTER_CRITICAL(&s_out.lock);
+    *out = s_out.st;
+    uint32_t level = spk_out_dma_level_locked(esp_timer_get_time());
+    portEXIT_CRITICAL(&s_out.lock);
+    out->frames_played = (out->frames_written > level) ? out->frames_written - level : 0;
+}
+
+void app_speak_sound_stream_get_stats(app_spk_stream_t s, app_spk_stream_stats_t *out)
+{
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    if (!s_out.started || s >= APP_SPK_STREAM_MAX) return;
+    portENTER_CRITICAL(&s_out.lock);
+    *out = s_out.ss[s].st;
+    portEXIT_CRITICAL(&s_out.lock);
 }
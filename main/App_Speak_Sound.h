@@ -1,9 +1,16 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+
 #include "esp_err.h"
 
+#include "App_SpkEq.h"
+#include "App_SpkMix.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -14,6 +21,11 @@ typedef struct {
     int bits_per_sample;    // 16
     int volume;             // 0..100
     int mic_gain_db;        // codec dependent, best-effort
+
+    // 采集格式（可与喇叭不同，见 App_CapFmt.h）；0/NULL 表示与喇叭相同
+    int mic_channels;       // 例如 ES7210：2
+    int mic_bits;           // 16 / 32
+    const char *mic_layout; // 例如 "RMNM"；NULL 表示全部为麦克风
 } app_speak_sound_cfg_t;
 
 /**
@@ -30,7 +42,14 @@ esp_err_t app_speak_sound_init(const app_speak_sound_cfg_t *cfg);
 void app_speak_sound_get_cfg(app_speak_sound_cfg_t *out_cfg);
 
 /**
- * @brief 播放一段正弦测试音
+ * @brief 运行中调整麦克风模拟增益（AGC 粗调用）
+ *
+ * @note 采集布局里有回采参考 lane（'R'）时只调麦克风通道，参考电平不变。
+ */
+esp_err_t app_speak_sound_set_mic_gain(int db);
+
+/**
+ * @brief 播放一段正弦测试音（混音器已启动时走 EARCON 流）
  */
 esp_err_t app_speak_sound_play_tone(int freq_hz, int duration_ms);
 
@@ -40,6 +59,7 @@ esp_err_t app_speak_sound_play_tone(int freq_hz, int duration_ms);
  * @param buf      输出 PCM 数据缓冲
  * @param buf_bytes 缓冲大小（字节）
  * @param out_bytes 实际录到的字节数（可为 NULL）
+ * @note 数据为原始采集格式（同 app_speak_sound_mic_read）。
  */
 esp_err_t app_speak_sound_record(void *buf, size_t buf_bytes, size_t *out_bytes, int duration_ms);
 
@@ -52,16 +72,142 @@ esp_err_t app_speak_sound_play_pcm(const void *buf, size_t bytes);
  * @brief 从麦克风读取指定字节数 PCM（阻塞直到读满）
  *
  * @note 用于流式 VAD/上行；与 app_speak_sound_record() 不冲突，但请避免并发读。
+ * @note 数据为原始采集格式（mic_channels/mic_bits），需用 App_CapFmt 转成单声道 s16。
  */
 esp_err_t app_speak_sound_mic_read(void *buf, size_t bytes);
 
 /**
  * @brief 向喇叭写入指定字节数 PCM（阻塞直到写入完成）
  *
- * @note 用于可中断播放：上层可分小块循环写并随时停止。
+ * @note 混音器已启动时写入 TTS 流（保证喇叭只有一个写者）。
  */
 esp_err_t app_speak_sound_spk_write(const void *buf, size_t bytes);
 
+/*
+ * 播放混音器：独立任务独占 esp_codec_dev_write，按块（默认 2 个 I2S DMA 描述符，20ms）混合多路输入流。
+ *
+ *   stream_write(TTS)    ──> [FIFO] ─┐
+ *   stream_write(EARCON) ──> [FIFO] ─┼─混音任务：闪避 / 增益斜坡 / 主音量（App_SpkMix）──整块写──> I2S DMA（6 × 240 帧）
+ *   stream_write(FILLER) ──> [FIFO] ─┘
+ *
+ * 任一路攒够一块即混（其余路不足的部分补零）；只有零头时等半块时长没有新数据再送出。
+ * 打断（out_cancel）清空所有 FIFO，已进 DMA 的样本在 codec 端淡出静音后顶掉。
+ * 已播放位置 = 已写出帧数 - DMA 中估计的剩余帧数（按写出时刻与采样率推算）。
+ * 每路延迟 = 空闲后第一个样本交给混音器 -> 该样本估计从喇叭播出（含 FIFO、凑块、限幅前瞻与 DMA 排队）。
+ *
+ * 混音输出经 App_SpkEq（级联双二阶 EQ + 前瞻限幅）再写 codec：codec 音量可以开大而 TTS 峰值不削顶。
+ * EQ + 限幅每块的 CPU 超过 eq_budget_pct 连续 3 块时从末尾减掉一段 EQ（限幅不减）。
+ */
+
+typedef struct {
+    int fifo_frames;        // 输入 FIFO 深度，默认 TTS 6 块、其余 3 块
+    int duck_db;            // 见 App_SpkMix.h，0 取默认
+    int ramp_ms;            // 增益过渡时长，默认 60
+} app_spk_stream_cfg_t;
+
+typedef struct {
+    int block_frames;       // 每块帧数，默认 480（2 个 DMA 描述符）
+    int task_prio;          // 默认 7（高于播放/网络任务）
+    app_spk_stream_cfg_t streams[APP_SPK_STREAM_MAX];
+    bool eq_enable;         // 默认 true
+    app_spk_eq_cfg_t eq;    // 默认见 app_spk_eq_cfg_default()；sample_rate / channels 取喇叭配置
+    float eq_budget_pct;    // EQ + 限幅占一个核的上限，默认 3
+} app_spk_out_cfg_t;
+
+typedef struct {
+    uint64_t frames_written;    // 已交给 I2S 的帧数
+    uint64_t frames_played;     // 估计已从喇叭播出的帧数
+    uint32_t writes;            // codec write 调用次数（对比旧方案：每 512B 一次）
+    uint32_t underruns;         // DMA 已播空后才写入的次数（断流）
+    uint32_t cancels;
+    uint32_t blocks_dropped;    // 打断时丢弃的已混好未写出的块
+    uint32_t write_us_avg;      // 单次 write 平均阻塞时长（EWMA）
+    uint32_t mix_cycles_avg;    // 混一块的 CPU 周期
+    uint32_t mix_cycles_max;
+    float mix_load_pct;         // 混音占一个核的百分比（累计周期 / 输出时长）
+    uint32_t eq_cycles_avg;     // EQ + 限幅处理一块的 CPU 周期
+    uint32_t eq_cycles_max;
+    uint32_t eq_over_budget;    // 超预算的块数
+    int eq_bands;               // 实际运行的 EQ 段数（超预算会减少）
+} app_spk_out_stats_t;
+
+typedef struct {
+    uint64_t frames_in;         // 写入 FIFO 的帧数
+    uint64_t frames_mixed;
+    uint64_t frames_dropped;    // 被闪避到静音或取消时丢弃
+    uint32_t starts;            // 空闲 -> 有数据的次数
+    uint32_t underruns;         // 活跃中途数据不够一块（块内补零）
+    uint32_t latency_ms_last;
+    uint32_t latency_ms_avg;
+    uint32_t latency_ms_max;
+    float gain;                 // 当前增益（含闪避与主音量）
+} app_spk_stream_stats_t;
+
+app_spk_out_cfg_t app_speak_sound_out_cfg_default(void);
+
+/**
+ * @brief 启动混音任务（init 之后调用；之后 spk_write / play_tone 也走混音器）
+ */
+esp_err_t app_speak_sound_out_start(const app_spk_out_cfg_t *cfg);
+
+/**
+ * @brief 写入一路输入流；FIFO 满时每段最多等 wait，返回实际写入字节数
+ */
+size_t app_speak_sound_stream_write(app_spk_stream_t s, const void *buf, size_t bytes, TickType_t wait);
+
+/**
+ * @brief 阻塞写完整段；混音器未启动时直接写 codec
+ */
+esp_err_t app_speak_sound_stream_play(app_spk_stream_t s, const void *buf, size_t bytes);
+
+/**
+ * @brief 丢弃一路尚未混入的数据并立即停止它的闪避（不影响其他流）
+ */
+esp_err_t app_speak_sound_stream_cancel(app_spk_stream_t s);
+
+/**
+ * @brief 流的用户增益 0..1（走斜坡）
+ */
+esp_err_t app_speak_sound_stream_set_gain(app_spk_stream_t s, float gain);
+
+void app_speak_sound_stream_get_stats(app_spk_stream_t s, app_spk_stream_stats_t *out);
+
+/**
+ * @brief 软件主音量 0..1（混音时作用于所有流；codec 音量不变）
+ */
+esp_err_t app_speak_sound_out_set_volume(float gain);
+
+/**
+ * @brief 运行时换 EQ / 限幅参数（频段、前增益、限幅上限与释放；前瞻长度以启动时为准）
+ *
+ * @note 频段超出 Q28 系数范围或频率越界返回 ESP_ERR_INVALID_ARG，原参数不变。
+ *       关限幅时延迟线里还没播的样本先随下一块推出，之后才去掉前瞻延迟。
+ */
+esp_err_t app_speak_sound_out_set_eq(const app_spk_eq_cfg_t *cfg);
+
+void app_speak_sound_out_get_eq_stats(app_spk_eq_stats_t *out);
+
+/**
+ * @brief 等同 stream_write(APP_SPK_STREAM_TTS, ...)
+ */
+size_t app_speak_sound_out_write(const void *buf, size_t bytes, TickType_t wait);
+
+/**
+ * @brief 打断：清空所有流的 FIFO，codec 淡出并静音（DMA 清理由混音任务完成）
+ *
+ * 淡出按系统节拍分级，调用方阻塞约 fade_ms（vTaskDelay，不占 CPU）；不足一拍时按一拍算。
+ *
+ * @param out_silent_us 可为 NULL；返回喇叭实际静音的时刻（esp_timer 微秒）
+ */
+esp_err_t app_speak_sound_out_cancel(int fade_ms, int64_t *out_silent_us);
+
+/**
+ * @brief 尚未播出的帧数（最长的 FIFO + DMA 估计），0 表示喇叭已空闲
+ */
+uint32_t app_speak_sound_out_pending_frames(void);
+
+void app_speak_sound_out_get_stats(app_spk_out_stats_t *out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,580 @@
+#include "App_Spec.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+
+static const char *TAG = "App_Spec";
+
+#if CONFIG_IDF_TARGET_ESP32S3
+static app_spec_impl_t s_impl = APP_SPEC_IMPL_FAST;
+#else
+static app_spec_impl_t s_impl = APP_SPEC_IMPL_REF;
+#endif
+
+typedef struct {
+    int16_t re, im;
+} cpx16_t;
+
+void app_spec_set_impl(app_spec_impl_t impl)
+{
+    s_impl = impl;
+}
+
+app_spec_impl_t app_spec_get_impl(void)
+{
+    return s_impl;
+}
+
+// ---------- 公共算术（两套实现共用，保证逐位一致） ----------
+
+static inline int16_t sat16(int32_t v)
+{
+    if (v > 32767) return 32767;
+    if (v < -32768) return -32768;
+    return (int16_t)v;
+}
+
+static inline int32_t rsr(int32_t v, int s)
+{
+    return s ? ((v + (1 << (s - 1))) >> s) : v;
+}
+
+static inline int32_t iabs32(int32_t v)
+{
+    return v < 0 ? -v : v;
+}
+
+// 每级右移位数：growth 为该级分量的最大放大倍数（向上取整）
+static inline int stage_shift(int32_t max_abs, int growth)
+{
+    const int32_t b = max_abs * growth;
+    int s = 0;
+    while ((b >> s) > 32767) s++;
+    return s;
+}
+
+// a * W，W = tw[idx]；idx 0 视为精确 1
+static inline void tw_mul(cpx16_t a, const cpx16_t *tw, int idx, int32_t *re, int32_t *im)
+{
+    if (idx == 0) {
+        *re = a.re;
+        *im = a.im;
+        return;
+    }
+    const int32_t c = tw[idx].re, s = tw[idx].im;
+    *re = (a.re * c - a.im * s + (1 << 14)) >> 15;
+    *im = (a.re * s + a.im * c + (1 << 14)) >> 15;
+}
+
+// radix-4 合并（输入为位反转序的 radix-2^2 形式）：
+//   b0 = a0 + t1 + t2 + t3, b1 = a0 - t1 - j(t2 - t3), b2 = a0 + t1 - t2 - t3, b3 = a0 - t1 + j(t2 - t3)
+// 其中 t1 = W^2 a1, t2 = W a2, t3 = W^3 a3。返回输出分量的最大绝对值
+static inline int32_t r4_combine(int32_t a0r, int32_t a0i, int32_t t1r, int32_t t1i, int32_t t2r, int32_t t2i,
+                                 int32_t t3r, int32_t t3i, int s, cpx16_t *o0, cpx16_t *o1, cpx16_t *o2,
+                                 cpx16_t *o3)
+{
+    const int32_t s0r = a0r + t1r, s0i = a0i + t1i;
+    const int32_t d0r = a0r - t1r, d0i = a0i - t1i;
+    const int32_t s1r = t2r + t3r, s1i = t2i + t3i;
+    const int32_t d1r = t2r - t3r, d1i = t2i - t3i;
+
+    o0->re = sat16(rsr(s0r + s1r, s));
+    o0->im = sat16(rsr(s0i + s1i, s));
+    o1->re = sat16(rsr(d0r + d1i, s));
+    o1->im = sat16(rsr(d0i - d1r, s));
+    o2->re = sat16(rsr(s0r - s1r, s));
+    o2->im = sat16(rsr(s0i - s1i, s));
+    o3->re = sat16(rsr(d0r - d1i, s));
+    o3->im = sat16(rsr(d0i + d1r, s));
+
+    int32_t m = iabs32(o0->re);
+    int32_t v;
+    if ((v = iabs32(o0->im)) > m) m = v;
+    if ((v = iabs32(o1->re)) > m) m = v;
+    if ((v = iabs32(o1->im)) > m) m = v;
+    if ((v = iabs32(o2->re)) > m) m = v;
+    if ((v = iabs32(o2->im)) > m) m = v;
+    if ((v = iabs32(o3->re)) > m) m = v;
+    if ((v = iabs32(o3->im)) > m) m = v;
+    return m;
+}
+
+// ---------- radix-4 级：REF ----------
+
+static int32_t r4_stage_ref(cpx16_t *z, int m, int span, const cpx16_t *tw, int s)
+{
+    const int step = m / (4 * span);
+    int32_t mx = 0;
+    for (int g = 0; g < m; g += 4 * span) {
+        for (int k = 0; k < span; ++k) {
+            cpx16_t *p = z + g + k;
+            int32_t t1r, t1i, t2r, t2i, t3r, t3i;
+            tw_mul(p[span], tw, 2 * k * step, &t1r, &t1i);
+            tw_mul(p[2 * span], tw, k * step, &t2r, &t2i);
+            tw_mul(p[3 * span], tw, 3 * k * step, &t3r, &t3i);
+            int32_t v = r4_combine(p[0].re, p[0].im, t1r, t1i, t2r, t2i, t3r, t3i, s, &p[0], &p[span],
+                                   &p[2 * span], &p[3 * span]);
+            if (v > mx) mx = v;
+        }
+    }
+    return mx;
+}
+
+// ---------- radix-4 级：FAST ----------
+// k 外层：每个 k 的三组旋转因子只取一次；k=0 整组免乘；组内指针步进。仍是标量 C（主机上约 1.0~1.1x REF）。
+// 没有 PIE 版本：规格要求 re*c - im*s 加 1<<14 后再 >>15，ee.cmul.s16 按 SAR 截断右移、没有舍入常数，
+// 差的 1 LSB 还会改变下一级块浮点的移位，与 REF 对不上
+
+static int32_t r4_stage_fast(cpx16_t *z, int m, int span, const cpx16_t *tw, int s)
+{
+    const int step = m / (4 * span);
+    const int group = 4 * span;
+    int32_t mx = 0;
+
+    for (cpx16_t *p = z; p < z + m; p += group) {
+        const cpx16_t a1 = p[span], a2 = p[2 * span], a3 = p[3 * span];
+        int32_t v = r4_combine(p[0].re, p[0].im, a1.re, a1.im, a2.re, a2.im, a3.re, a3.im, s, &p[0], &p[span],
+                               &p[2 * span], &p[3 * span]);
+        if (v > mx) mx = v;
+    }
+
+    for (int k = 1; k < span; ++k) {
+        const int32_t c1 = tw[k * step].re, s1 = tw[k * step].im;
+        const int32_t c2 = tw[2 * k * step].re, s2 = tw[2 * k * step].im;
+        const int32_t c3 = tw[3 * k * step].re, s3 = tw[3 * k * step].im;
+        for (cpx16_t *p = z + k; p < z + m; p += group) {
+            const cpx16_t a1 = p[span], a2 = p[2 * span], a3 = p[3 * span];
+            const int32_t t1r = (a1.re * c2 - a1.im * s2 + (1 << 14)) >> 15;
+            const int32_t t1i = (a1.re * s2 + a1.im * c2 + (1 << 14)) >> 15;
+            const int32_t t2r = (a2.re * c1 - a2.im * s1 + (1 << 14)) >> 15;
+            const int32_t t2i = (a2.re * s1 + a2.im * c1 + (1 << 14)) >> 15;
+            const int32_t t3r = (a3.re * c3 - a3.im * s3 + (1 << 14)) >> 15;
+            const int32_t t3i = (a3.re * s3 + a3.im * c3 + (1 << 14)) >> 15;
+            int32_t v = r4_combine(p[0].re, p[0].im, t1r, t1i, t2r, t2i, t3r, t3i, s, &p[0], &p[span],
+                                   &p[2 * span], &p[3 * span]);
+            if (v > mx) mx = v;
+        }
+    }
+    return mx;
+}
+
+// ---------- 实数 FFT ----------
+
+esp_err_t app_spec_fft_init(app_spec_fft_t *f, int n)
+{
+    ESP_RETURN_ON_FALSE(f && (n == 256 || n == 512), ESP_ERR_INVALID_ARG, TAG, "fft size %d not supported", n);
+    memset(f, 0, sizeof(*f));
+    const int m = n / 2;
+    f->n = n;
+    f->m = m;
+    f->tw = (int16_t *)malloc((size_t)m * 2 * sizeof(int16_t));
+    f->tw_split = (int16_t *)malloc((size_t)(m + 1) * 2 * sizeof(int16_t));
+    f->bitrev = (uint16_t *)malloc((size_t)m * sizeof(uint16_t));
+    if (!f->tw || !f->tw_split || !f->bitrev) {
+        app_spec_fft_deinit(f);
+        ESP_LOGE(TAG, "alloc fft tables failed");
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int i = 0; i < m; ++i) {
+        const double a = 2.0 * M_PI * (double)i / (double)m;
+        f->tw[2 * i] = (int16_t)lrint(32767.0 * cos(a));
+        f->tw[2 * i + 1] = (int16_t)lrint(-32767.0 * sin(a));
+    }
+    for (int k = 0; k <= m; ++k) {
+        const double a = 2.0 * M_PI * (double)k / (double)n;
+        f->tw_split[2 * k] = (int16_t)lrint(32767.0 * cos(a));
+        f->tw_split[2 * k + 1] = (int16_t)lrint(-32767.0 * sin(a));
+    }
+    int bits = 0;
+    while ((1 << bits) < m) bits++;
+    for (int i = 0; i < m; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b) r |= ((i >> b) & 1) << (bits - 1 - b);
+        f->bitrev[i] = (uint16_t)r;
+    }
+    return ESP_OK;
+}
+
+void app_spec_fft_deinit(app_spec_fft_t *f)
+{
+    if (!f) return;
+    free(f->tw);
+    free(f->tw_split);
+    free(f->bitrev);
+    f->tw = f->tw_split = NULL;
+    f->bitrev = NULL;
+}
+
+// 实数拆分：X2(k) = (Z[k] + conj Z[m-k]) + W_n^k * (-j)(Z[k] - conj Z[m-k])，输出 X2 >> sh
+static inline void split_one(cpx16_t zk, cpx16_t zj, const cpx16_t *tw, int k, int sh, cpx16_t *o)
+{
+    const int32_t fer = zk.re + zj.re, fei = zk.im - zj.im;
+    const int32_t gr = zk.im + zj.im, gi = zj.re - zk.re;
+    int32_t xr = fer + gr, xi = fei + gi;
+    if (k != 0) {
+        const int64_t c = tw[k].re, s = tw[k].im;
+        xr = fer + (int32_t)((gr * c - gi * s + (1 << 14)) >> 15);
+        xi = fei + (int32_t)((gr * s + gi * c + (1 << 14)) >> 15);
+    }
+    o->re = sat16(rsr(xr, sh));
+    o->im = sat16(rsr(xi, sh));
+}
+
+// m 点复数 FFT 各级（输入已是位反转序，mx 为输入最大绝对值）；返回累计右移，*mx_out 为输出最大绝对值
+static int cfft_stages(const app_spec_fft_t *f, cpx16_t *z, int32_t mx, int32_t *mx_out)
+{
+    const int m = f->m;
+    const cpx16_t *tw = (const cpx16_t *)f->tw;
+    int exp = 0;
+    int span = 1;
+    if ((m & 0x5555) == 0) {
+        // log2(m) 为奇数：先做一级 radix-2（W = 1）
+        const int s = stage_shift(mx, 3);
+        int32_t nm = 0;
+        for (int i = 0; i < m; i += 2) {
+            const cpx16_t a = z[i], b = z[i + 1];
+            z[i].re = sat16(rsr((int32_t)a.re + b.re, s));
+            z[i].im = sat16(rsr((int32_t)a.im + b.im, s));
+            z[i + 1].re = sat16(rsr((int32_t)a.re - b.re, s));
+            z[i + 1].im = sat16(rsr((int32_t)a.im - b.im, s));
+            int32_t v;
+            if ((v = iabs32(z[i].re)) > nm) nm = v;
+            if ((v = iabs32(z[i].im)) > nm) nm = v;
+            if ((v = iabs32(z[i + 1].re)) > nm) nm = v;
+            if ((v = iabs32(z[i + 1].im)) > nm) nm = v;
+        }
+        mx = nm;
+        exp += s;
+        span = 2;
+    }
+
+    const bool fast = (s_impl == APP_SPEC_IMPL_FAST);
+    for (; span < m; span *= 4) {
+        const int s = stage_shift(mx, 6);
+        mx = fast ? r4_stage_fast(z, m, span, tw, s) : r4_stage_ref(z, m, span, tw, s);
+        exp += s;
+    }
+    *mx_out = mx;
+    return exp;
+}
+
+int app_spec_rfft(const app_spec_fft_t *f, const int16_t *x, int16_t *out)
+{
+    const int m = f->m;
+    cpx16_t *z = (cpx16_t *)out;
+
+    // 偶/奇样本打包成复数，按位反转序放置
+    int32_t mx = 0;
+    for (int i = 0; i < m; ++i) {
+        cpx16_t v = {x[2 * i], x[2 * i + 1]};
+        z[f->bitrev[i]] = v;
+        int32_t a = iabs32(v.re), b = iabs32(v.im);
+        if (a > mx) mx = a;
+        if (b > mx) mx = b;
+    }
+    const int exp = cfft_stages(f, z, mx, &mx);
+
+    // 拆分出 m+1 个频点；k 与 m-k 成对计算，可原地进行
+    const int s = stage_shift(mx, 3);
+    const cpx16_t *tws = (const cpx16_t *)f->tw_split;
+    const cpx16_t z0 = z[0];
+    split_one(z0, z0, tws, 0, s + 1, &z[0]);
+    split_one(z0, z0, tws, m, s + 1, &z[m]);
+    for (int k = 1; k <= m / 2; ++k) {
+        const cpx16_t zk = z[k], zj = z[m - k];
+        split_one(zk, zj, tws, k, s + 1, &z[k]);
+        if (k != m - k) split_one(zj, zk, tws, m - k, s + 1, &z[m - k]);
+    }
+    return exp + s;
+}
+
+// 逆拆分（乘 2）：2Z[k] = (X[k] + conj X[m-k]) + j W_n^-k (X[k] - conj X[m-k])
+static inline void unsplit_one(cpx16_t xk, cpx16_t xj, const cpx16_t *tw, int k, int32_t *zr, int32_t *zi)
+{
+    const int32_t er = xk.re + xj.re, ei = xk.im - xj.im;
+    const int32_t dr = xk.re - xj.re, di = xk.im + xj.im;
+    int32_t ar = dr, ai = di;
+    if (k != 0) {
+        // W_n^-k = (c, -tw.im)
+        const int32_t c = tw[k].re, s = tw[k].im;
+        ar = (dr * c + di * s + (1 << 14)) >> 15;
+        ai = (di * c - dr * s + (1 << 14)) >> 15;
+    }
+    *zr = er - ai;
+    *zi = ei + ar;
+}
+
+int app_spec_irfft(const app_spec_fft_t *f, int16_t *spec, int16_t *x)
+{
+    const int m = f->m;
+    cpx16_t *z = (cpx16_t *)spec;
+    const cpx16_t *tws = (const cpx16_t *)f->tw_split;
+
+    int32_t mx = 0;
+    for (int k = 0; k <= m; ++k) {
+        int32_t v;
+        if ((v = iabs32(z[k].re)) > mx) mx = v;
+        if ((v = iabs32(z[k].im)) > mx) mx = v;
+    }
+    // 合成 m 点复数谱并取共轭（逆变换 = 共轭 -> 正变换 -> 共轭），k 与 m-k 成对原地进行
+    const int s0 = stage_shift(mx, 4);
+    int32_t nm = 0;
+    for (int k = 0; k <= m / 2; ++k) {
+        const int j = m - k;
+        const cpx16_t xk = z[k], xj = z[j];
+        int32_t r, i;
+        unsplit_one(xk, xj, tws, k, &r, &i);
+        z[k].re = sat16(rsr(r, s0));
+        z[k].im = sat16(rsr(-i, s0));
+        if (k != 0 && k != j) {
+            unsplit_one(xj, xk, tws, j, &r, &i);
+            z[j].re = sat16(rsr(r, s0));
+            z[j].im = sat16(rsr(-i, s0));
+        }
+    }
+    for (int k = 0; k < m; ++k) {
+        int32_t v;
+        if ((v = iabs32(z[k].re)) > nm) nm = v;
+        if ((v = iabs32(z[k].im)) > nm) nm = v;
+    }
+    // 原地位反转
+    for (int i = 0; i < m; ++i) {
+        const int r = f->bitrev[i];
+        if (i < r) {
+            const cpx16_t t = z[i];
+            z[i] = z[r];
+            z[r] = t;
+        }
+    }
+    int bits = 0;
+    while ((1 << bits) < m) bits++;
+    const int exp = cfft_stages(f, z, nm, &nm);
+    for (int i = 0; i < m; ++i) {
+        x[2 * i] = z[i].re;
+        x[2 * i + 1] = sat16(-(int32_t)z[i].im);
+    }
+    // 正变换得到 m * 2z / 2^(s0 + exp)
+    return s0 + exp - 1 - bits;
+}
+
+void app_spec_power(const int16_t *spec, int bins, uint32_t *pow)
+{
+    for (int k = 0; k < bins; ++k) {
+        const int32_t re = spec[2 * k], im = spec[2 * k + 1];
+        pow[k] = (uint32_t)(re * re) + (uint32_t)(im * im);
+    }
+}
+
+// round(256 * log2(1 + i/32))
+static const uint16_t s_log2_tab[33] = {
+    0,   11,  22,  33,  44,  54,  63,  73,  82,  92,  100, 109, 118, 126, 134, 142, 150,
+    157, 165, 172, 179, 186, 193, 200, 207, 213, 220, 226, 232, 238, 244, 250, 256,
+};
+
+int32_t app_spec_log2_q8(uint64_t v)
+{
+    if (v == 0) return 0;
+    const int e = 63 - __builtin_clzll(v);
+    // 归一到 [1, 2) 的 Q16 小数部分
+    const uint32_t frac = ((e >= 16) ? (uint32_t)(v >> (e - 16)) : (uint32_t)(v << (16 - e))) - 65536u;
+    const int i = (int)(frac >> 11);
+    const int32_t r = (int32_t)(frac & 2047);
+    const int32_t lo = s_log2_tab[i], hi = s_log2_tab[i + 1];
+    return e * 256 + lo + (((hi - lo) * r + 1024) >> 11);
+}
+
+// ---------- mel ----------
+
+static double hz_to_mel(double f)
+{
+    return 2595.0 * log10(1.0 + f / 700.0);
+}
+
+static double mel_to_hz(double m)
+{
+    return 700.0 * (pow(10.0, m / 2595.0) - 1.0);
+}
+
+esp_err_t app_spec_mel_init(app_spec_mel_t *mel, int sample_rate, int n_fft, int n_mel, int fmin_hz, int fmax_hz)
+{
+    ESP_RETURN_ON_FALSE(mel && sample_rate > 0 && n_fft > 0 && n_mel > 0 && n_mel <= APP_SPEC_MEL_MAX &&
+                            fmin_hz >= 0 && fmax_hz > fmin_hz && fmax_hz <= sample_rate / 2,
+                        ESP_ERR_INVALID_ARG, TAG, "bad mel args");
+    memset(mel, 0, sizeof(*mel));
+    const int bins = n_fft / 2 + 1;
+    // 每个频点最多落在两个相邻三角里
+    mel->w = (int16_t *)malloc((size_t)(bins * 2 + n_mel) * sizeof(int16_t));
+    ESP_RETURN_ON_FALSE(mel->w, ESP_ERR_NO_MEM, TAG, "alloc mel weights failed");
+    mel->n_mel = n_mel;
+
+    const double m0 = hz_to_mel(fmin_hz), m1 = hz_to_mel(fmax_hz);
+    const double bin_hz = (double)sample_rate / (double)n_fft;
+    int off = 0;
+    for (int i = 0; i < n_mel; ++i) {
+        const double fl = mel_to_hz(m0 + (m1 - m0) * i / (n_mel + 1));
+        const double fc = mel_to_hz(m0 + (m1 - m0) * (i + 1) / (n_mel + 1));
+        const double fr = mel_to_hz(m0 + (m1 - m0) * (i + 2) / (n_mel + 1));
+        int start = -1, len = 0;
+        for (int b = 0; b < bins; ++b) {
+            const double f = b * bin_hz;
+            double w = 0;
+            if (f > fl && f <= fc) w = (f - fl) / (fc - fl);
+            else if (f > fc && f < fr) w = (fr - f) / (fr - fc);
+            if (w <= 0) {
+                if (start >= 0) break;
+                continue;
+            }
+            if (start < 0) start = b;
+            mel->w[off + len++] = (int16_t)lrint(32767.0 * w);
+        }
+        if (len == 0) {
+            // 低频三角比频点间隔还窄：取最近的频点
+            start = (int)lrint(fc / bin_hz);
+            if (start >= bins) start = bins - 1;
+            mel->w[off] = 32767;
+            len = 1;
+        }
+        mel->start[i] = (int16_t)start;
+        mel->len[i] = (int16_t)len;
+        mel->off[i] = (int16_t)off;
+        off += len;
+    }
+    return ESP_OK;
+}
+
+void app_spec_mel_deinit(app_spec_mel_t *mel)
+{
+    if (!mel) return;
+    free(mel->w);
+    mel->w = NULL;
+}
+
+void app_spec_mel_apply(const app_spec_mel_t *mel, const uint32_t *pow, int exp, int16_t *logmel)
+{
+    for (int i = 0; i < mel->n_mel; ++i) {
+        const uint32_t *p = pow + mel->start[i];
+        const int16_t *w = mel->w + mel->off[i];
+        uint64_t e = 0;
+        for (int j = 0; j < mel->len[i]; ++j) e += (uint64_t)w[j] * p[j];
+        int32_t v = app_spec_log2_q8(e >> 15) + 2 * exp * 256;
+        logmel[i] = sat16(v);
+    }
+}
+
+// ---------- 帧流水线 ----------
+
+app_spec_pipe_cfg_t app_spec_pipe_cfg_default(int sample_rate)
+{
+    app_spec_pipe_cfg_t c = {
+        .sample_rate = sample_rate,
+        .n_fft = 512,
+        .n_mel = 40,
+        .n_ceps = 13,
+        .fmin_hz = 60,
+        .fmax_hz = sample_rate / 2,
+    };
+    return c;
+}
+
+esp_err_t app_spec_pipe_init(app_spec_pipe_t *p, const app_spec_pipe_cfg_t *cfg)
+{
+    ESP_RETURN_ON_FALSE(p && cfg && cfg->sample_rate > 0, ESP_ERR_INVALID_ARG, TAG, "bad args");
+    memset(p, 0, sizeof(*p));
+    app_spec_pipe_cfg_t def = app_spec_pipe_cfg_default(cfg->sample_rate);
+    p->cfg = *cfg;
+    if (p->cfg.n_fft <= 0) p->cfg.n_fft = def.n_fft;
+    if (p->cfg.n_mel <= 0) p->cfg.n_mel = def.n_mel;
+    if (p->cfg.n_ceps < 0) p->cfg.n_ceps = def.n_ceps;
+    if (p->cfg.n_ceps > APP_SPEC_CEPS_MAX) p->cfg.n_ceps = APP_SPEC_CEPS_MAX;
+    if (p->cfg.fmin_hz <= 0) p->cfg.fmin_hz = def.fmin_hz;
+    if (p->cfg.fmax_hz <= 0) p->cfg.fmax_hz = def.fmax_hz;
+
+    const int n = p->cfg.n_fft;
+    esp_err_t ret = app_spec_fft_init(&p->fft, n);
+    if (ret == ESP_OK) {
+        ret = app_spec_mel_init(&p->mel, p->cfg.sample_rate, n, p->cfg.n_mel, p->cfg.fmin_hz, p->cfg.fmax_hz);
+    }
+    if (ret != ESP_OK) {
+        app_spec_pipe_deinit(p);
+        return ret;
+    }
+
+    p->win = (int16_t *)malloc((size_t)n * sizeof(int16_t));
+    p->buf = (int16_t *)malloc((size_t)n * sizeof(int16_t));
+    p->spec = (int16_t *)malloc((size_t)(n + 2) * sizeof(int16_t));
+    p->pow = (uint32_t *)malloc((size_t)(n / 2 + 1) * sizeof(uint32_t));
+    if (p->cfg.n_ceps > 0) {
+        p->dct = (int16_t *)malloc((size_t)(p->cfg.n_ceps * p->cfg.n_mel) * sizeof(int16_t));
+    }
+    if (!p->win || !p->buf || !p->spec || !p->pow || (p->cfg.n_ceps > 0 && !p->dct)) {
+        app_spec_pipe_deinit(p);
+        ESP_LOGE(TAG, "alloc pipe buffers failed");
+        return ESP_ERR_NO_MEM;
+    }
+
+    // 周期 Hann 窗
+    for (int i = 0; i < n; ++i) {
+        p->win[i] = (int16_t)lrint(32767.0 * (0.5 - 0.5 * cos(2.0 * M_PI * i / n)));
+    }
+    // 正交 DCT-II
+    const int nm = p->cfg.n_mel;
+    for (int i = 0; i < p->cfg.n_ceps; ++i) {
+        const double scale = (i == 0) ? sqrt(1.0 / nm) : sqrt(2.0 / nm);
+        for (int j = 0; j < nm; ++j) {
+            p->dct[i * nm + j] = (int16_t)lrint(32767.0 * scale * cos(M_PI * i * (j + 0.5) / nm));
+        }
+    }
+    return ESP_OK;
+}
+
+void app_spec_pipe_deinit(app_spec_pipe_t *p)
+{
+    if (!p) return;
+    app_spec_fft_deinit(&p->fft);
+    app_spec_mel_deinit(&p->mel);
+    free(p->win);
+    free(p->buf);
+    free(p->spec);
+    free(p->pow);
+    free(p->dct);
+    p->win = p->buf = p->spec = p->dct = NULL;
+    p->pow = NULL;
+}
+
+void app_spec_pipe_run(app_spec_pipe_t *p, const int16_t *frame, app_spec_feat_t *out)
+{
+    const uint32_t c0 = esp_cpu_get_cycle_count();
+    const int n = p->cfg.n_fft;
+
+    int64_t e = 0;
+    for (int i = 0; i < n; ++i) {
+        const int32_t x = frame[i];
+        e += x * x;
+        p->buf[i] = (int16_t)((x * p->win[i] + (1 << 14)) >> 15);
+    }
+    out->log_energy = sat16(app_spec_log2_q8((uint64_t)e));
+
+    out->fft_exp = app_spec_rfft(&p->fft, p->buf, p->spec);
+    app_spec_power(p->spec, n / 2 + 1, p->pow);
+    app_spec_mel_apply(&p->mel, p->pow, out->fft_exp, out->logmel);
+
+    const int nm = p->cfg.n_mel;
+    for (int i = 0; i < p->cfg.n_ceps; ++i) {
+        const int16_t *d = p->dct + i * nm;
+        int64_t acc = 0;
+        for (int j = 0; j < nm; ++j) acc += (int32_t)d[j] * out->logmel[j];
+        out->mfcc[i] = (int32_t)((acc + (1 << 14)) >> 15);
+    }
+
+    const uint32_t cyc = esp_cpu_get_cycle_count() - c0;
+    p->frames++;
+    p->cycles_last = cyc;
+    p->cycles_avg = p->cycles_avg ? (p->cycles_avg * 7 + cyc) / 8 : cyc;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 定点频谱内核库：加窗实数 FFT（256/512 点）、功率谱、log-mel、MFCC / 对数能量。
+ * 供谱 VAD、降噪、回声消除、关键词识别等共用。
+ *
+ * FFT：N 点实数 -> N/2 点复数 radix-4 DIT（log2(N/2) 为奇数时先做一级 radix-2），
+ * 再拆分出 N/2+1 个频点。数据为 s16 复数交织，块浮点：每级按当前最大值决定右移位数，
+ * 累计到 exp，输出 X ≈ DFT(x) / 2^exp。
+ *
+ * 两套 radix-4 实现，逐位一致（selftest 校验）：
+ *   REF  ：逐蝶形标量实现，算术规格的参照，主机/其他目标默认用它；
+ *   FAST ：按旋转因子下标外层循环（每组因子只取一次）、k=0 整组免乘，标量 C，ESP32-S3 默认用它。
+ * 算术规格：旋转因子 Q15 舍入乘；下标 0 的旋转因子视为精确 1（不乘）；移位为舍入右移后饱和。
+ */
+
+#define APP_SPEC_FFT_MAX 512
+#define APP_SPEC_MEL_MAX 40
+#define APP_SPEC_CEPS_MAX 13
+
+typedef enum {
+    APP_SPEC_IMPL_REF = 0,
+    APP_SPEC_IMPL_FAST,
+} app_spec_impl_t;
+
+typedef struct {
+    int n;                      // 实数点数：256 / 512
+    int m;                      // 复数点数 n/2
+    int16_t *tw;                // W_m^i，i < m，(cos, -sin) 交织 Q15
+    int16_t *tw_split;          // W_n^k，k <= m
+    uint16_t *bitrev;           // m 点位反转表
+} app_spec_fft_t;
+
+esp_err_t app_spec_fft_init(app_spec_fft_t *f, int n);
+void app_spec_fft_deinit(app_spec_fft_t *f);
+
+/**
+ * @brief 实数 FFT
+ *
+ * @param x   n 个样本（已加窗）
+ * @param out n/2+1 个复数，交织 (re, im)，共 n+2 个 int16
+ * @return exp：out ≈ DFT(x) / 2^exp
+ */
+int app_spec_rfft(const app_spec_fft_t *f, const int16_t *x, int16_t *out);
+
+/**
+ * @brief 逆实数 FFT（与 app_spec_rfft 互逆）
+ *
+ * @param spec n/2+1 个复数（会被改写，用作工作区）
+ * @param x    n 个输出样本
+ * @return exp：IDFT(spec) ≈ x * 2^exp（通常为负）；spec 本身带 rfft 的 exp 时两者相加
+ */
+int app_spec_irfft(const app_spec_fft_t *f, int16_t *spec, int16_t *x);
+
+/**
+ * @brief 选择 radix-4 实现（全局；测试对比用）
+ */
+void app_spec_set_impl(app_spec_impl_t impl);
+app_spec_impl_t app_spec_get_impl(void);
+
+/**
+ * @brief 功率谱 re^2 + im^2
+ */
+void app_spec_power(const int16_t *spec, int bins, uint32_t *pow);
+
+/**
+ * @brief log2(v)，Q8；v=0 返回 0
+ */
+int32_t app_spec_log2_q8(uint64_t v);
+
+typedef struct {
+    int n_mel;
+    int16_t start[APP_SPEC_MEL_MAX];    // 每个三角滤波器的起始频点
+    int16_t len[APP_SPEC_MEL_MAX];
+    int16_t off[APP_SPEC_MEL_MAX];      // 在 w 中的偏移
+    int16_t *w;                         // Q15 权重
+} app_spec_mel_t;
+
+esp_err_t app_spec_mel_init(app_spec_mel_t *mel, int sample_rate, int n_fft, int n_mel, int fmin_hz, int fmax_hz);
+void app_spec_mel_deinit(app_spec_mel_t *mel);
+
+/**
+ * @brief log-mel：log2(sum w * P) + 2*exp，Q8
+ */
+void app_spec_mel_apply(const app_spec_mel_t *mel, const uint32_t *pow, int exp, int16_t *logmel);
+
+typedef struct {
+    int sample_rate;            // 必填
+    int n_fft;                  // 256 / 512，默认 512
+    int n_mel;                  // 默认 40
+    int n_ceps;                 // 默认 13；0 表示不算 MFCC
+    int fmin_hz;                // 默认 60
+    int fmax_hz;                // 默认 sample_rate/2
+} app_spec_pipe_cfg_t;
+
+typedef struct {
+    int16_t log_energy;                 // log2(sum x^2)，Q8（未加窗）
+    int fft_exp;
+    int16_t logmel[APP_SPEC_MEL_MAX];   // Q8
+    int32_t mfcc[APP_SPEC_CEPS_MAX];    // Q8，正交 DCT-II
+} app_spec_feat_t;
+
+typedef struct {
+    app_spec_pipe_cfg_t cfg;
+    app_spec_fft_t fft;
+    app_spec_mel_t mel;
+    int16_t *win;               // Hann，Q15
+    int16_t *buf;               // 加窗后的帧
+    int16_t *spec;              // n_fft+2
+    uint32_t *pow;              // n_fft/2+1
+    int16_t *dct;               // n_ceps × n_mel，Q15
+    uint32_t frames;
+    uint32_t cycles_last;
+    uint32_t cycles_avg;
+} app_spec_pipe_t;
+
+app_spec_pipe_cfg_t app_spec_pipe_cfg_default(int sample_rate);
+
+esp_err_t app_spec_pipe_init(app_spec_pipe_t *p, const app_spec_pipe_cfg_t *cfg);
+void app_spec_pipe_deinit(app_spec_pipe_t *p);
+
+/**
+ * @brief 一帧 n_fft 个样本 -> 对数能量 / log-mel / MFCC；功率谱留在 p->pow 供调用方复用
+ */
+void app_spec_pipe_run(app_spec_pipe_t *p, const int16_t *frame, app_spec_feat_t *out);
+
+#ifdef __cplusplus
+}
+#endif
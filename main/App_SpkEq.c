@@ -0,0 +1,339 @@
+#include "App_SpkEq.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#define EQ_Q 28
+#define EQ_FRAC 8               // 段间样本带 8 位小数：低频极点附近的舍入误差会被放大上百倍
+#define EQ_CHUNK 64             // 分段处理：段间中间结果放栈上（64 帧 × 2 声道 × 4B）
+#define EQ_Y_LIMIT (1 << 28)    // 段输出钳位（约 32 倍满幅），防止异常系数下状态发散
+
+app_spk_eq_cfg_t app_spk_eq_cfg_default(int sample_rate, int channels)
+{
+    app_spk_eq_cfg_t c = {
+        .sample_rate = sample_rate,
+        .channels = channels,
+        .pre_gain_db = 0.0f,
+        .n_bands = 2,
+        .bands = {
+            {.type = APP_SPK_EQ_HIGHPASS, .freq_hz = 250.0f, .q = 0.707f},
+            {.type = APP_SPK_EQ_PEAK, .freq_hz = 3000.0f, .q = 1.0f, .gain_db = 3.0f},
+        },
+        .limiter = true,
+        .limit_dbfs = -3.0f,
+        .lookahead_ms = 2,
+        .release_ms = 60,
+    };
+    return c;
+}
+
+static bool q28(double v, int32_t *out)
+{
+    // Q28 可表示 [-8, 8)：+12 dB 搁架滤波器的 b 约为 4，够用
+    const double s = v * (double)(1 << EQ_Q);
+    if (!(s > -2147483648.0 && s < 2147483647.0)) return false;
+    *out = (int32_t)llround(s);
+    return true;
+}
+
+// RBJ Audio EQ Cookbook
+static bool biquad_design(const app_spk_eq_band_t *b, int sample_rate, app_spk_biquad_t *out)
+{
+    if (!(b->freq_hz > 0.0f) || b->freq_hz >= 0.5f * (float)sample_rate) return false;
+    const double q = (b->q > 0.0f) ? b->q : 0.707;
+    const double w0 = 2.0 * M_PI * b->freq_hz / sample_rate;
+    const double cw = cos(w0), sw = sin(w0);
+    const double alpha = sw / (2.0 * q);
+    const double A = pow(10.0, b->gain_db / 40.0);
+    const double sa = 2.0 * sqrt(A) * alpha;
+    double b0, b1, b2, a0, a1, a2;
+    switch (b->type) {
+    case APP_SPK_EQ_PEAK:
+        b0 = 1.0 + alpha * A;
+        b1 = -2.0 * cw;
+        b2 = 1.0 - alpha * A;
+        a0 = 1.0 + alpha / A;
+        a1 = -2.0 * cw;
+        a2 = 1.0 - alpha / A;
+        break;
+    case APP_SPK_EQ_LOWSHELF:
+        b0 = A * ((A + 1.0) - (A - 1.0) * cw + sa);
+        b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cw);
+        b2 = A * ((A + 1.0) - (A - 1.0) * cw - sa);
+        a0 = (A + 1.0) + (A - 1.0) * cw + sa;
+        a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cw);
+        a2 = (A + 1.0) + (A - 1.0) * cw - sa;
+        break;
+    case APP_SPK_EQ_HIGHSHELF:
+        b0 = A * ((A + 1.0) + (A - 1.0) * cw + sa);
+        b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cw);
+        b2 = A * ((A + 1.0) + (A - 1.0) * cw - sa);
+        a0 = (A + 1.0) - (A - 1.0) * cw + sa;
+        a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cw);
+        a2 = (A + 1.0) - (A - 1.0) * cw - sa;
+        break;
+    case APP_SPK_EQ_HIGHPASS:
+        b0 = (1.0 + cw) / 2.0;
+        b1 = -(1.0 + cw);
+        b2 = b0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cw;
+        a2 = 1.0 - alpha;
+        break;
+    case APP_SPK_EQ_LOWPASS:
+        b0 = (1.0 - cw) / 2.0;
+        b1 = 1.0 - cw;
+        b2 = b0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cw;
+        a2 = 1.0 - alpha;
+        break;
+    default:
+        return false;
+    }
+    return q28(b0 / a0, &out->b0) && q28(b1 / a0, &out->b1) && q28(b2 / a0, &out->b2) && q28(a1 / a0, &out->a1) &&
+           q28(a2 / a0, &out->a2);
+}
+
+static bool eq_apply_cfg(app_spk_eq_t *e, const app_spk_eq_cfg_t *cfg)
+{
+    if (cfg->n_bands < 0 || cfg->n_bands > APP_SPK_EQ_MAX_BANDS) return false;
+    app_spk_biquad_t bq[APP_SPK_EQ_MAX_BANDS];
+    for (int i = 0; i < cfg->n_bands; ++i) {
+        if (!biquad_design(&cfg->bands[i], e->cfg.sample_rate, &bq[i])) return false;
+    }
+    const app_spk_eq_cfg_t def = app_spk_eq_cfg_default(e->cfg.sample_rate, e->cfg.channels);
+    const int old_n = e->cfg.n_bands;
+
+    e->cfg.pre_gain_db = cfg->pre_gain_db;
+    e->cfg.n_bands = cfg->n_bands;
+    memcpy(e->cfg.bands, cfg->bands, sizeof(e->cfg.bands));
+    e->cfg.limiter = cfg->limiter;
+    e->cfg.limit_dbfs = (cfg->limit_dbfs == 0.0f) ? def.limit_dbfs : cfg->limit_dbfs;
+    e->cfg.release_ms = (cfg->release_ms > 0) ? cfg->release_ms : def.release_ms;
+
+    memcpy(e->bq, bq, sizeof(bq[0]) * (size_t)cfg->n_bands);
+    // 新增的段从零状态开始，已有段保留状态（换系数只有轻微瞬态）
+    for (int i = old_n; i < cfg->n_bands; ++i) {
+        memset(e->zx[i], 0, sizeof(e->zx[i]));
+        memset(e->zy[i], 0, sizeof(e->zy[i]));
+    }
+    e->n_active = cfg->n_bands;
+
+    float pre = powf(10.0f, e->cfg.pre_gain_db / 20.0f);
+    if (pre > 8.0f) pre = 8.0f;
+    e->pre_q12 = (int32_t)lrintf(pre * 4096.0f);
+    float lim = powf(10.0f, e->cfg.limit_dbfs / 20.0f);
+    if (lim > 1.0f) lim = 1.0f;
+    e->ceil = (int32_t)floorf(32767.0f * lim);
+    if (e->ceil < 1) e->ceil = 1;
+    const double rel_frames = (double)e->cfg.release_ms * e->cfg.sample_rate / 1000.0;
+    e->rel_q15 = (int32_t)lround(32768.0 * (1.0 - exp(-1.0 / rel_frames)));
+    if (e->rel_q15 < 1) e->rel_q15 = 1;
+    return true;
+}
+
+void app_spk_eq_reset(app_spk_eq_t *e)
+{
+    if (!e) return;
+    memset(e->zx, 0, sizeof(e->zx));
+    memset(e->zy, 0, sizeof(e->zy));
+    memset(e->delay, 0, sizeof(e->delay));
+    for (int i = 0; i < e->la; ++i) e->box[i] = 32768;
+    e->box_sum = 32768 * e->la;
+    e->env = 32768;
+    e->dq_head = 0;
+    e->dq_len = 0;
+    e->pos = 0;
+}
+
+bool app_spk_eq_init(app_spk_eq_t *e, const app_spk_eq_cfg_t *cfg)
+{
+    if (!e || !cfg || cfg->sample_rate <= 0) return false;
+    memset(e, 0, sizeof(*e));
+    const app_spk_eq_cfg_t def = app_spk_eq_cfg_default(cfg->sample_rate, cfg->channels);
+    e->cfg.sample_rate = cfg->sample_rate;
+    e->cfg.channels = (cfg->channels > 0) ? cfg->channels : 1;
+    if (e->cfg.channels > APP_SPK_EQ_MAX_CH) return false;
+    e->cfg.lookahead_ms = (cfg->lookahead_ms > 0) ? cfg->lookahead_ms : def.lookahead_ms;
+    e->la = e->cfg.lookahead_ms * e->cfg.sample_rate / 1000;
+    if (e->la < 1) e->la = 1;
+    if (e->la > APP_SPK_EQ_MAX_LA_FRAMES) e->la = APP_SPK_EQ_MAX_LA_FRAMES;
+    e->inv_la_q16 = 65536 / e->la;
+    if (!eq_apply_cfg(e, cfg)) return false;
+    app_spk_eq_reset(e);
+    e->min_g = 32768;
+    return true;
+}
+
+bool app_spk_eq_set(app_spk_eq_t *e, const app_spk_eq_cfg_t *cfg)
+{
+    if (!e || !cfg) return false;
+    return eq_apply_cfg(e, cfg);
+}
+
+void app_spk_eq_set_active_bands(app_spk_eq_t *e, int n)
+{
+    if (!e) return;
+    if (n < 0) n = 0;
+    e->n_active = (n > e->cfg.n_bands) ? e->cfg.n_bands : n;
+}
+
+int app_spk_eq_latency_frames(const app_spk_eq_t *e)
+{
+    return (e && e->cfg.limiter) ? e->la : 0;
+}
+
+// 单段 DF1：系数与状态放寄存器，整段数据跑完再换下一段
+// 不做向量化：y[i] 依赖 y[i-1]，能并行的只有声道（最多 2 路，占不满 PIE 的 8 个 s16 通道），
+// 而 Q28 系数 × 32bit 样本要 64bit 累加，PIE 最宽只到 ACCX 40 位；esp-dsp 的 biquad 是浮点，结果对不上
+static void biquad_run(const app_spk_biquad_t *q, int32_t *zx, int32_t *zy, int32_t *x, int n, int stride)
+{
+    const int64_t b0 = q->b0, b1 = q->b1, b2 = q->b2, a1 = q->a1, a2 = q->a2;
+    int32_t x1 = zx[0], x2 = zx[1], y1 = zy[0], y2 = zy[1];
+    for (int i = 0; i < n; ++i) {
+        const int32_t in = x[i * stride];
+        const int64_t acc = b0 * in + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+        int64_t v = (acc + (1 << (EQ_Q - 1))) >> EQ_Q;
+        v = (v > EQ_Y_LIMIT) ? EQ_Y_LIMIT : (v < -EQ_Y_LIMIT ? -EQ_Y_LIMIT : v);
+        const int32_t y = (int32_t)v;
+        x2 = x1;
+        x1 = in;
+        y2 = y1;
+        y1 = y;
+        x[i * stride] = y;
+    }
+    zx[0] = x1;
+    zx[1] = x2;
+    zy[0] = y1;
+    zy[1] = y2;
+}
+
+static inline int32_t iabs32(int32_t v)
+{
+    return v < 0 ? -v : v;
+}
+
+static void limiter_run(app_spk_eq_t *e, const int32_t *in, int16_t *out, int n)
+{
+    const int ch = e->cfg.channels;
+    const int la = e->la;
+    const int cap = la + 1;
+    const int32_t ceil = e->ceil << EQ_FRAC;
+    app_spk_eq_stats_t *st = &e->st;
+    for (int f = 0; f < n; ++f) {
+        const int32_t *xf = in + f * ch;
+        int32_t a = 0;
+        for (int c = 0; c < ch; ++c) {
+            const int32_t v = iabs32(xf[c]);
+            if (v > a) a = v;
+        }
+        // 本帧所需增益（Q15）：a * req <= ceil * 32768
+        const int32_t req = (a <= ceil) ? 32768 : (int32_t)(((int64_t)ceil << 15) / a);
+        if ((a >> EQ_FRAC) > st->peak_in) st->peak_in = a >> EQ_FRAC;
+
+        // 窗口最小（最近 L+1 帧）：单调递增队列
+        while (e->dq_len > 0) {
+            int back = e->dq_head + e->dq_len - 1;
+            if (back >= cap) back -= cap;
+            if (e->dq_val[back] < req) break;
+            e->dq_len--;
+        }
+        int tail = e->dq_head + e->dq_len;
+        if (tail >= cap) tail -= cap;
+        e->dq_val[tail] = req;
+        e->dq_idx[tail] = e->t;
+        e->dq_len++;
+        if ((uint32_t)(e->t - e->dq_idx[e->dq_head]) > (uint32_t)la) {
+            e->dq_head = (e->dq_head + 1 == cap) ? 0 : e->dq_head + 1;
+            e->dq_len--;
+        }
+        const int32_t h = e->dq_val[e->dq_head];
+
+        // 下降立即跟随，回升按 release 指数恢复（始终 <= h）
+        if (h < e->env) {
+            e->env = h;
+        } else if (h > e->env) {
+            const int32_t d = (int32_t)(((int64_t)(h - e->env) * e->rel_q15) >> 15);
+            e->env += (d > 0) ? d : 1;
+        }
+
+        // 滑动平均：L 帧斜坡；窗口里每个值都 <= 即将离开延迟线那一帧的所需增益
+        e->box_sum += e->env - e->box[e->pos];
+        e->box[e->pos] = e->env;
+        const int32_t g =
+            (e->box_sum == 32768 * la) ? 32768 : (int32_t)(((int64_t)e->box_sum * e->inv_la_q16) >> 16);
+        if (g < 32768) {
+            st->frames_limited++;
+            if (g < e->min_g) e->min_g = g;
+        }
+
+        int32_t *d = e->delay + e->pos * ch;
+        int16_t *o = out + f * ch;
+        for (int c = 0; c < ch; ++c) {
+            const int32_t y = d[c];
+            d[c] = xf[c];
+            // 按绝对值截断，保证不超过 ceil
+            int32_t v = (int32_t)(((int64_t)iabs32(y) * g) >> (15 + EQ_FRAC));
+            if (v > 32767) v = 32767;
+            if (v > st->peak_out) st->peak_out = v;
+            o[c] = (int16_t)(y < 0 ? -v : v);
+        }
+        e->pos = (e->pos + 1 == la) ? 0 : e->pos + 1;
+        e->t++;
+    }
+}
+
+void app_spk_eq_process(app_spk_eq_t *e, int16_t *x, int frames)
+{
+    if (!e || !x || frames <= 0) return;
+    const int ch = e->cfg.channels;
+    int32_t buf[EQ_CHUNK * APP_SPK_EQ_MAX_CH];
+    for (int off = 0; off < frames; off += EQ_CHUNK) {
+        const int n = (frames - off < EQ_CHUNK) ? frames - off : EQ_CHUNK;
+        int16_t *px = x + (size_t)off * ch;
+        const int ns = n * ch;
+        const int32_t pre = e->pre_q12;
+        for (int i = 0; i < ns; ++i) buf[i] = (px[i] * pre + (1 << (11 - EQ_FRAC))) >> (12 - EQ_FRAC);
+        for (int b = 0; b < e->n_active; ++b) {
+            for (int c = 0; c < ch; ++c) biquad_run(&e->bq[b], e->zx[b][c], e->zy[b][c], buf + c, n, ch);
+        }
+        if (e->cfg.limiter) {
+            limiter_run(e, buf, px, n);
+        } else {
+            for (int i = 0; i < ns; ++i) {
+                const int32_t v = (buf[i] + (1 << (EQ_FRAC - 1))) >> EQ_FRAC;
+                const int32_t a = iabs32(v);
+                if (a > e->st.peak_in) e->st.peak_in = a;
+                px[i] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+                if (a > e->st.peak_out) e->st.peak_out = (a > 32767) ? 32767 : a;
+            }
+        }
+    }
+    e->st.frames += (uint64_t)frames;
+}
+
+float app_spk_eq_response_db(const app_spk_eq_t *e, float freq_hz)
+{
+    if (!e) return 0.0f;
+    const double w = 2.0 * M_PI * freq_hz / e->cfg.sample_rate;
+    const double c1 = cos(w), s1 = sin(w), c2 = cos(2.0 * w), s2 = sin(2.0 * w);
+    const double k = 1.0 / (double)(1 << EQ_Q);
+    double db = 20.0 * log10(e->pre_q12 / 4096.0);
+    for (int i = 0; i < e->n_active; ++i) {
+        const app_spk_biquad_t *q = &e->bq[i];
+        // H(e^jw) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+        const double nr = (q->b0 + q->b1 * c1 + q->b2 * c2) * k, ni = -(q->b1 * s1 + q->b2 * s2) * k;
+        const double dr = 1.0 + (q->a1 * c1 + q->a2 * c2) * k, di = -(q->a1 * s1 + q->a2 * s2) * k;
+        db += 10.0 * log10((nr * nr + ni * ni) / (dr * dr + di * di));
+    }
+    return (float)db;
+}
+
+void app_spk_eq_get_stats(const app_spk_eq_t *e, app_spk_eq_stats_t *out)
+{
+    if (!e || !out) return;
+    *out = e->st;
+    out->min_gain_db = (e->min_g < 32768) ? 20.0f * log10f((float)e->min_g / 32768.0f) : 0.0f;
+}
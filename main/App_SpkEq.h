@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 喇叭输出处理：定点级联双二阶 EQ + 前瞻峰值限幅，接在混音器输出与 codec 之间。
+ * 不依赖 IDF，可直接在主机上编译（tools/spk_eq_bench.c 校验频响与限幅上限）。
+ *
+ *   x ──pre_gain──> [biquad 1] ─> ... ─> [biquad n] ──> 延迟 L ──× g ──> 饱和 ──> y
+ *                                                  └─> 所需增益 ─> 窗口最小（L+1）─> 释放 ─> 滑动平均（L）─┘
+ *
+ * 系数由 RBJ 公式在浮点下算出后量化为 Q28，运行时按 DF1 + 64bit 累加；段间保持 32bit 不饱和，
+ * 提升的频段先超出 s16 也不会在 EQ 内部削顶，统一交给限幅器。
+ * 限幅器：窗口最小保证峰值样本离开延迟线时增益已经降到位，滑动平均把降增益摊成 L 帧的斜坡，
+ * 输出峰值严格不超过 limit_dbfs（无过冲、无硬削顶），代价是 lookahead_ms 的延迟。
+ * 多声道共用一个增益（按帧峰值），声像不漂。
+ */
+
+#define APP_SPK_EQ_MAX_BANDS 6
+#define APP_SPK_EQ_MAX_CH 2
+#define APP_SPK_EQ_MAX_LA_FRAMES 256    // 前瞻延迟上限（24 kHz 约 10ms）
+
+typedef enum {
+    APP_SPK_EQ_PEAK = 0,
+    APP_SPK_EQ_LOWSHELF,
+    APP_SPK_EQ_HIGHSHELF,
+    APP_SPK_EQ_HIGHPASS,
+    APP_SPK_EQ_LOWPASS,
+} app_spk_eq_type_t;
+
+typedef struct {
+    app_spk_eq_type_t type;
+    float freq_hz;
+    float q;                    // <= 0 取 0.707
+    float gain_db;              // 仅 PEAK / SHELF
+} app_spk_eq_band_t;
+
+typedef struct {
+    int sample_rate;            // 必填
+    int channels;               // 1..2，默认 1
+    float pre_gain_db;          // EQ 前增益（给提升的频段留余量）
+    int n_bands;
+    app_spk_eq_band_t bands[APP_SPK_EQ_MAX_BANDS];
+
+    bool limiter;
+    float limit_dbfs;           // 输出峰值上限，默认 -3（0 取默认）
+    int lookahead_ms;           // 默认 2
+    int release_ms;             // 默认 60
+} app_spk_eq_cfg_t;
+
+typedef struct {
+    uint64_t frames;
+    uint64_t frames_limited;    // 增益 < 1 的帧数
+    int32_t peak_in;            // EQ 后、限幅前的最大幅度（可超过 32767）
+    int32_t peak_out;
+    float min_gain_db;          // 限幅最深的衰减，<= 0
+} app_spk_eq_stats_t;
+
+typedef struct {
+    int32_t b0, b1, b2, a1, a2;   // Q28，已按 a0 归一：y = b0·x + b1·x1 + b2·x2 - a1·y1 - a2·y2
+} app_spk_biquad_t;
+
+typedef struct {
+    app_spk_eq_cfg_t cfg;
+    int n_active;               // 实际运行的段数（CPU 超预算时可从末尾减段）
+    app_spk_biquad_t bq[APP_SPK_EQ_MAX_BANDS];
+    int32_t zx[APP_SPK_EQ_MAX_BANDS][APP_SPK_EQ_MAX_CH][2];
+    int32_t zy[APP_SPK_EQ_MAX_BANDS][APP_SPK_EQ_MAX_CH][2];
+    int32_t pre_q12;
+
+    // 限幅器
+    int la;                     // 前瞻帧数 L
+    int32_t ceil;
+    int32_t rel_q15;
+    int32_t inv_la_q16;
+    int32_t delay[APP_SPK_EQ_MAX_LA_FRAMES * APP_SPK_EQ_MAX_CH];
+    int32_t box[APP_SPK_EQ_MAX_LA_FRAMES];
+    int32_t dq_val[APP_SPK_EQ_MAX_LA_FRAMES + 1];     // 窗口最小的单调队列
+    uint32_t dq_idx[APP_SPK_EQ_MAX_LA_FRAMES + 1];
+    int dq_head, dq_len;
+    int32_t box_sum;
+    int32_t env;                // 释放包络，Q15（32768 = 1.0）
+    int32_t min_g;
+    uint32_t t;                 // 帧计数（单调队列下标）
+    int pos;                    // 延迟线 / 滑动平均写位置
+    app_spk_eq_stats_t st;
+} app_spk_eq_t;
+
+/**
+ * @brief 默认：250 Hz 高通（小喇叭放不出低频，只会多耗冲程）+ 3 kHz +3 dB（清晰度），-3 dBFS 限幅
+ */
+app_spk_eq_cfg_t app_spk_eq_cfg_default(int sample_rate, int channels);
+
+bool app_spk_eq_init(app_spk_eq_t *e, const app_spk_eq_cfg_t *cfg);
+
+/**
+ * @brief 运行时换 EQ 频段 / 前增益 / 限幅上限（滤波器状态保留；前瞻长度不变）
+ */
+bool app_spk_eq_set(app_spk_eq_t *e, const app_spk_eq_cfg_t *cfg);
+
+/**
+ * @brief 只保留前 n 段（CPU 超预算时降级用），n 超出已配置段数时取全部
+ */
+void app_spk_eq_set_active_bands(app_spk_eq_t *e, int n);
+
+void app_spk_eq_reset(app_spk_eq_t *e);
+
+/**
+ * @brief 原地处理 frames 帧交织 s16；开了限幅时输出比输入晚 app_spk_eq_latency_frames() 帧
+ */
+void app_spk_eq_process(app_spk_eq_t *e, int16_t *x, int frames);
+
+int app_spk_eq_latency_frames(const app_spk_eq_t *e);
+
+/**
+ * @brief 量化后系数级联（含 pre_gain、当前运行段）在 freq_hz 处的理论增益，dB
+ */
+float app_spk_eq_response_db(const app_spk_eq_t *e, float freq_hz);
+
+void app_spk_eq_get_stats(const app_spk_eq_t *e, app_spk_eq_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,187 @@
+#include "App_SpkMix.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "esp_check.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+
+#include "App_PcmOps.h"
+
+static const char *TAG = "App_SpkMix";
+
+#define MIX_MUTE_DB (-60)
+
+static const char *const s_stream_name[APP_SPK_STREAM_MAX] = {"filler", "tts", "earcon", "alert"};
+
+app_spk_mix_cfg_t app_spk_mix_cfg_default(int sample_rate, int block_frames)
+{
+    app_spk_mix_cfg_t c = {
+        .sample_rate = sample_rate,
+        .channels = 1,
+        .block_frames = block_frames,
+        .hold_ms = 200,
+        .streams = {
+            [APP_SPK_STREAM_FILLER] = {.duck_db = 1, .ramp_ms = 60},
+            // 回复开始后填充音淡出并丢弃（原先 task_play 里的交叉淡化）
+            [APP_SPK_STREAM_TTS] = {.duck_db = -96, .ramp_ms = 60},
+            // 提示音压低回复但不打断
+            [APP_SPK_STREAM_EARCON] = {.duck_db = -12, .ramp_ms = 60},
+            [APP_SPK_STREAM_ALERT] = {.duck_db = -20, .ramp_ms = 60},
+        },
+    };
+    return c;
+}
+
+static inline int32_t gain_to_q15(float g)
+{
+    if (!(g > 0.0f)) return 0;
+    return (g >= 1.0f) ? 32767 : (int32_t)lrintf(g * 32767.0f);
+}
+
+// 32767 当作 1.0：满幅乘满幅不衰减
+static inline int32_t q15_mul(int32_t a, int32_t b)
+{
+    if (a >= 32767) return b;
+    if (b >= 32767) return a;
+    return (a * b + 16384) >> 15;
+}
+
+esp_err_t app_spk_mix_init(app_spk_mix_t *m, const app_spk_mix_cfg_t *cfg)
+{
+    ESP_RETURN_ON_FALSE(m && cfg && cfg->sample_rate > 0 && cfg->block_frames > 0, ESP_ERR_INVALID_ARG, TAG,
+                        "bad args");
+    memset(m, 0, sizeof(*m));
+    const app_spk_mix_cfg_t def = app_spk_mix_cfg_default(cfg->sample_rate, cfg->block_frames);
+    m->cfg = *cfg;
+    if (m->cfg.channels <= 0) m->cfg.channels = def.channels;
+    if (m->cfg.hold_ms <= 0) m->cfg.hold_ms = def.hold_ms;
+
+    const int sr = m->cfg.sample_rate;
+    for (int s = 0; s < APP_SPK_STREAM_MAX; ++s) {
+        app_spk_mix_stream_cfg_t *sc = &m->cfg.streams[s];
+        if (sc->duck_db == 0) sc->duck_db = def.streams[s].duck_db;
+        if (sc->ramp_ms <= 0) sc->ramp_ms = def.streams[s].ramp_ms;
+
+        if (sc->duck_db > 0) {
+            m->duck_q15[s] = 32767;
+        } else if (sc->duck_db <= MIX_MUTE_DB) {
+            m->duck_q15[s] = 0;
+        } else {
+            m->duck_q15[s] = gain_to_q15(powf(10.0f, (float)sc->duck_db / 20.0f));
+        }
+        int64_t step = (int64_t)32767 * m->cfg.block_frames * 1000 / ((int64_t)sc->ramp_ms * sr);
+        m->step_q15[s] = (step < 1) ? 1 : (step > 32767 ? 32767 : (int32_t)step);
+        m->user_q15[s] = 32767;
+        m->cur_q15[s] = 32767;
+    }
+    m->master_q15 = 32767;
+    m->hold_frames = (int)((int64_t)m->cfg.hold_ms * sr / 1000);
+    for (int s = 0; s < APP_SPK_STREAM_MAX; ++s) m->idle_frames[s] = m->hold_frames;
+
+    ESP_LOGI(TAG, "mix: %d streams, block %d frames, duck tts %d / earcon %d / alert %d dB, hold %d ms",
+             APP_SPK_STREAM_MAX, m->cfg.block_frames, m->cfg.streams[APP_SPK_STREAM_TTS].duck_db,
+             m->cfg.streams[APP_SPK_STREAM_EARCON].duck_db, m->cfg.streams[APP_SPK_STREAM_ALERT].duck_db,
+             m->cfg.hold_ms);
+    return ESP_OK;
+}
+
+bool app_spk_mix_active(const app_spk_mix_t *m, app_spk_stream_t s)
+{
+    return m && s < APP_SPK_STREAM_MAX && m->idle_frames[s] < m->hold_frames;
+}
+
+uint32_t app_spk_mix_run(app_spk_mix_t *m, const int16_t *const src[APP_SPK_STREAM_MAX],
+                         const int frames[APP_SPK_STREAM_MAX], int16_t *out, int *out_frames)
+{
+    const uint32_t c0 = esp_cpu_get_cycle_count();
+    const int ch = m->cfg.channels;
+    const int bf = m->cfg.block_frames;
+
+    // 活跃状态先于闪避更新：高优先级流的第一块就开始压别人
+    bool was_active[APP_SPK_STREAM_MAX];
+    int n_out = 0;
+    for (int s = 0; s < APP_SPK_STREAM_MAX; ++s) {
+        was_active[s] = app_spk_mix_active(m, (app_spk_stream_t)s);
+        const int n = (frames[s] > bf) ? bf : frames[s];
+        if (n > 0 && src[s]) {
+            m->idle_frames[s] = 0;
+            if (n > n_out) n_out = n;
+        } else if (m->idle_frames[s] < m->hold_frames) {
+            m->idle_frames[s] += bf;
+        }
+    }
+
+    memset(out, 0, (size_t)bf * (size_t)ch * sizeof(int16_t));
+    uint32_t muted = 0;
+    int32_t duck = 32767;   // 从高到低累积：比 s 优先级高的活跃流里压得最狠的
+    for (int s = APP_SPK_STREAM_MAX - 1; s >= 0; --s) {
+        const int32_t target = q15_mul(q15_mul(m->user_q15[s], m->master_q15), duck);
+        const bool active = app_spk_mix_active(m, (app_spk_stream_t)s);
+        const int32_t from = m->cur_q15[s];
+        int32_t to = target;
+        if (active && was_active[s]) {
+            // 活跃中：每块最多走一步；空闲 -> 活跃直接就位
+            if (to > from + m->step_q15[s]) to = from + m->step_q15[s];
+            if (to < from - m->step_q15[s]) to = from - m->step_q15[s];
+        }
+        m->cur_q15[s] = to;
+
+        const int n = (frames[s] > bf) ? bf : frames[s];
+        if (n > 0 && src[s] && (from > 0 || to > 0)) {
+            app_pcm_mix_ramp(out, src[s], n * ch, from, to);
+            m->st.frames_mixed[s] += (uint64_t)n;
+        }
+        if (duck == 0 && to == 0) muted |= 1u << s;
+
+        if (active && m->duck_q15[s] < duck) duck = m->duck_q15[s];
+    }
+    if (out_frames) *out_frames = n_out;
+
+    const uint32_t cyc = esp_cpu_get_cycle_count() - c0;
+    app_spk_mix_stats_t *st = &m->st;
+    st->blocks++;
+    st->frames += (uint64_t)n_out;
+    st->cycles += cyc;
+    st->cycles_avg = st->cycles_avg ? (st->cycles_avg * 15 + cyc) / 16 : cyc;
+    if (cyc > st->cycles_max) st->cycles_max = cyc;
+    return muted;
+}
+
+void app_spk_mix_set_gain(app_spk_mix_t *m, app_spk_stream_t s, float gain)
+{
+    if (!m || s >= APP_SPK_STREAM_MAX) return;
+    m->user_q15[s] = gain_to_q15(gain);
+}
+
+void app_spk_mix_set_master(app_spk_mix_t *m, float gain)
+{
+    if (!m) return;
+    m->master_q15 = gain_to_q15(gain);
+}
+
+float app_spk_mix_gain(const app_spk_mix_t *m, app_spk_stream_t s)
+{
+    if (!m || s >= APP_SPK_STREAM_MAX) return 0.0f;
+    return (float)m->cur_q15[s] / 32767.0f;
+}
+
+void app_spk_mix_reset_stream(app_spk_mix_t *m, app_spk_stream_t s)
+{
+    if (!m || s >= APP_SPK_STREAM_MAX) return;
+    m->idle_frames[s] = m->hold_frames;
+}
+
+float app_spk_mix_load_pct(const app_spk_mix_t *m, int cpu_mhz)
+{
+    if (!m || m->st.frames == 0 || cpu_mhz <= 0) return 0.0f;
+    // 周期 / (输出秒数 × 主频)
+    const double sec = (double)m->st.frames / (double)m->cfg.sample_rate;
+    return (float)(100.0 * (double)m->st.cycles / (sec * (double)cpu_mhz * 1e6));
+}
+
+const char *app_spk_mix_stream_name(app_spk_stream_t s)
+{
+    return (s < APP_SPK_STREAM_MAX) ? s_stream_name[s] : "?";
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 播放混音核心：多路带优先级的输入流按块混成一路，不含任务/队列，可在主机上跑（Task_Dsp_Selftest）。
+ *
+ *   流（低 -> 高优先级）：FILLER  TTS  EARCON  ALERT
+ *   每块：目标增益 = 用户增益 × 主音量 × 闪避系数；当前增益每块最多走 ramp 一步；
+ *         每路 mix_ramp（块内线性过渡）累加进输出，饱和截断。
+ *
+ * 闪避：某流活跃（本块有数据，或停了不到 hold_ms）时，比它优先级低的流压到 duck_db；
+ * 多个高优先级流同时活跃取压得最狠的一个。duck_db <= -60 视为静音：增益淡到 0 之后
+ * app_spk_mix_run() 在返回的掩码里报出这些流，调用者丢弃它们剩余的数据（例如回复开始后的填充音）。
+ * 流从空闲变活跃时增益直接就位，不做淡入。
+ */
+
+typedef enum {
+    APP_SPK_STREAM_FILLER = 0,  // 等待回复时的填充音，优先级最低
+    APP_SPK_STREAM_TTS,         // 回复语音
+    APP_SPK_STREAM_EARCON,      // 提示音（测试音、资源包音效）
+    APP_SPK_STREAM_ALERT,       // 告警
+    APP_SPK_STREAM_MAX,
+} app_spk_stream_t;
+
+typedef struct {
+    int duck_db;                // 本流活跃时低优先级流的增益，0 取默认，正数表示不压
+    int ramp_ms;                // 本流增益从 0 到满幅的过渡时长，默认 60
+} app_spk_mix_stream_cfg_t;
+
+typedef struct {
+    int sample_rate;            // 必填
+    int channels;               // 默认 1
+    int block_frames;           // 每块帧数，必填
+    int hold_ms;                // 断流多久后不再算活跃，默认 200
+    app_spk_mix_stream_cfg_t streams[APP_SPK_STREAM_MAX];
+} app_spk_mix_cfg_t;
+
+typedef struct {
+    uint64_t blocks;
+    uint64_t frames;            // 已输出帧数
+    uint64_t cycles;            // 累计 CPU 周期（算每秒输出的负载）
+    uint32_t cycles_avg;        // 单块
+    uint32_t cycles_max;
+    uint64_t frames_mixed[APP_SPK_STREAM_MAX];
+} app_spk_mix_stats_t;
+
+typedef struct {
+    app_spk_mix_cfg_t cfg;
+    int32_t duck_q15[APP_SPK_STREAM_MAX];   // 闪避系数，0 为静音，32767 为不压
+    int32_t step_q15[APP_SPK_STREAM_MAX];   // 每块最大增益变化
+    int32_t user_q15[APP_SPK_STREAM_MAX];
+    int32_t cur_q15[APP_SPK_STREAM_MAX];
+    int32_t master_q15;
+    int idle_frames[APP_SPK_STREAM_MAX];    // 距上次有数据的帧数
+    int hold_frames;
+    app_spk_mix_stats_t st;
+} app_spk_mix_t;
+
+app_spk_mix_cfg_t app_spk_mix_cfg_default(int sample_rate, int block_frames);
+
+esp_err_t app_spk_mix_init(app_spk_mix_t *m, const app_spk_mix_cfg_t *cfg);
+
+/**
+ * @brief 混一块
+ *
+ * @param src    每路的交织 PCM，frames[s] 为 0 时可为 NULL
+ * @param frames 每路本块的帧数（<= block_frames）
+ * @param out    block_frames * channels 个样本；有效长度为各路最长者，写到 *out_frames
+ * @return 已淡到静音的被闪避流掩码（1 << stream），调用者应丢弃其剩余数据
+ */
+uint32_t app_spk_mix_run(app_spk_mix_t *m, const int16_t *const src[APP_SPK_STREAM_MAX],
+                         const int frames[APP_SPK_STREAM_MAX], int16_t *out, int *out_frames);
+
+/**
+ * @brief 用户增益 0..1（走斜坡，不跳变）
+ */
+void app_spk_mix_set_gain(app_spk_mix_t *m, app_spk_stream_t s, float gain);
+
+/**
+ * @brief 主音量（软件音量）0..1，作用于所有流
+ */
+void app_spk_mix_set_master(app_spk_mix_t *m, float gain);
+
+/**
+ * @brief 流的当前增益（含闪避与主音量）0..1
+ */
+float app_spk_mix_gain(const app_spk_mix_t *m, app_spk_stream_t s);
+
+/**
+ * @brief 流是否算活跃（决定是否闪避别人）
+ */
+bool app_spk_mix_active(const app_spk_mix_t *m, app_spk_stream_t s);
+
+/**
+ * @brief 清掉流的活跃状态（打断后立即停止闪避）
+ */
+void app_spk_mix_reset_stream(app_spk_mix_t *m, app_spk_stream_t s);
+
+/**
+ * @brief 混音占一个核的百分比（累计周期 / 输出时长）
+ */
+float app_spk_mix_load_pct(const app_spk_mix_t *m, int cpu_mhz);
+
+const char *app_spk_mix_stream_name(app_spk_stream_t s);
+
+#ifdef __cplusplus
+}
+#endif
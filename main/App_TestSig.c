@@ -0,0 +1,236 @@
+#include "App_TestSig.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "App_Kws.h"
+
+int16_t app_tsig_noise(uint32_t *st, int amp)
+{
+    int32_t acc = 0;
+    for (int k = 0; k < 4; ++k) acc += (int32_t)(app_tsig_lcg(st) >> 20) - 2048;
+    return (int16_t)((acc * amp) / 4096);
+}
+
+double app_tsig_pow(const int16_t *x, int n)
+{
+    double p = 0;
+    for (int i = 0; i < n; ++i) p += (double)x[i] * (double)x[i];
+    return p;
+}
+
+double app_tsig_snr_db(const int16_t *ref, const int16_t *y, int n)
+{
+    double s = 0, e = 0;
+    for (int i = 0; i < n; ++i) {
+        const double d = (double)ref[i] - (double)y[i];
+        s += (double)ref[i] * (double)ref[i];
+        e += d * d;
+    }
+    return (e > 0) ? 10.0 * log10(s / e) : 99.0;
+}
+
+void app_tsig_tones(int16_t *x, int n, int sr)
+{
+    uint32_t st = 0x12345678u;
+    for (int i = 0; i < n; ++i) {
+        const float v = 6000.0f * sinf(2.0f * (float)M_PI * 300.0f * (float)i / (float)sr) +
+                        3000.0f * sinf(2.0f * (float)M_PI * 1700.0f * (float)i / (float)sr) +
+                        (float)((int32_t)(app_tsig_lcg(&st) >> 22) - 512);
+        x[i] = (int16_t)v;
+    }
+}
+
+// ---------- 语音 + 房间噪声 ----------
+
+void app_tsig_scene_init(app_tsig_scene_t *sc, int sr, uint32_t noise_seed)
+{
+    memset(sc, 0, sizeof(*sc));
+    sc->sr = sr;
+    sc->frame = sr / 50;
+    if (sc->frame > APP_TSIG_FRAME_MAX) sc->frame = APP_TSIG_FRAME_MAX;
+    sc->ns = noise_seed;
+}
+
+void app_tsig_speech(app_tsig_scene_t *sc, int f, int amp, int16_t *out)
+{
+    const int fps = 50, syl_frames = fps / 4, n = sc->frame;
+    const int t = f % (3 * fps);
+    memset(out, 0, (size_t)n * sizeof(int16_t));
+    if (t >= 3 * fps / 2) return;
+    const int syl = (t / syl_frames) % 6, k = t % syl_frames;
+    if (k == 0) {
+        static const int f0_tab[6] = {140, 180, 125, 200, 160, 115};
+        for (int i = 0; i < APP_TSIG_HARMONICS; ++i) {
+            app_pcm_nco_init(&sc->h[i], f0_tab[syl] * (i + 1), sc->sr, (int16_t)(amp / (i + 1)));
+        }
+    }
+    for (int i = 0; i < APP_TSIG_HARMONICS; ++i) {
+        app_pcm_nco_run(&sc->h[i], sc->tmp, n, 1);
+        app_pcm_mix(out, sc->tmp, n, 4096);
+    }
+    const float a0 = sinf((float)M_PI * k / syl_frames), a1 = sinf((float)M_PI * (k + 1) / syl_frames);
+    app_pcm_fade(out, n, (int32_t)(32767 * a0 * a0), (int32_t)(32767 * a1 * a1));
+}
+
+void app_tsig_room_noise(app_tsig_scene_t *sc, app_tsig_noise_t type, int f, int amp, int16_t *out)
+{
+    const int n = sc->frame;
+    for (int i = 0; i < n; ++i) {
+        if (type == APP_TSIG_NOISE_FAN) {
+            sc->lp += (app_tsig_noise(&sc->ns, amp * 3) - sc->lp) / 8;
+            out[i] = (int16_t)sc->lp;
+        } else {
+            out[i] = app_tsig_noise(&sc->ns, amp);
+        }
+    }
+    if (type == APP_TSIG_NOISE_TV) {
+        const float ph = 2.0f * (float)M_PI * 0.25f;
+        const float g0 = 0.6f + 0.4f * sinf(ph * f / 50), g1 = 0.6f + 0.4f * sinf(ph * (f + 1) / 50);
+        app_pcm_fade(out, n, (int32_t)(32767 * g0), (int32_t)(32767 * g1));
+    }
+}
+
+// ---------- 双麦 ----------
+
+void app_tsig_bf_source(int16_t *src, int n, int sr)
+{
+    uint32_t st = 0xbeefu;
+    int32_t lp = 0;
+    for (int i = 0; i < n; ++i) {
+        lp += (app_tsig_noise(&st, 12000) - lp) / 4;
+        const bool on = (i % (sr / 2)) < (sr * 3 / 10);
+        src[i] = on ? (int16_t)lp : 0;
+    }
+}
+
+void app_tsig_bf_frame(const int16_t *src, int frame, int pad, int f, int tau, int noise_amp, uint32_t *ns0,
+                       uint32_t *ns1, int part, int16_t *m0, int16_t *m1)
+{
+    for (int i = 0; i < frame; ++i) {
+        const int t = pad + f * frame + i;
+        const int16_t n0 = app_tsig_noise(ns0, noise_amp), n1 = app_tsig_noise(ns1, noise_amp);
+        const int32_t s0 = (part == 2) ? 0 : src[t];
+        const int32_t s1 = (part == 2) ? 0 : src[t - tau];
+        m0[i] = (int16_t)(s0 + ((part == 1) ? 0 : n0));
+        m1[i] = (int16_t)(s1 + ((part == 1) ? 0 : n1));
+    }
+}
+
+// ---------- 能量 VAD ----------
+
+void app_tsig_vad_feed(app_tsig_vad_t *v, int sr, const int16_t *x, int n)
+{
+    v->sum += (int64_t)app_pcm_sum_abs(x, n);
+    v->n += n;
+    if (v->n < sr / 2) return;
+    const bool voiced = (v->sum / v->n) > 80;
+    v->windows++;
+    v->voiced += voiced;
+    if (!v->speaking) {
+        v->on_cnt = voiced ? v->on_cnt + 1 : 0;
+        if (v->on_cnt >= 3) {
+            v->speaking = true;
+            v->off_cnt = 0;
+            v->wakes++;
+        }
+    } else {
+        v->off_cnt = voiced ? 0 : v->off_cnt + 1;
+        if (v->off_cnt >= 6) {
+            v->speaking = false;
+            v->on_cnt = 0;
+        }
+    }
+    v->sum = 0;
+    v->n = 0;
+}
+
+// ---------- 合成唤醒词模型 ----------
+
+#define KWS_SYN_CH 32
+#define KWS_SYN_BLOCKS 4
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    put16(p, (uint16_t)v);
+    put16(p + 2, (uint16_t)(v >> 16));
+}
+
+// 按输入幅度约 40、权重 ±64 均匀分布估计累加值的标准差，把输出缩放回约 40
+static void kws_syn_mult(int fan, int32_t *mult, int *shift)
+{
+    int e;
+    const double m = frexp(40.0 / (sqrt((double)fan) * 40.0 * 37.0), &e);
+    *mult = (int32_t)lrint(m * 2147483648.0);
+    *shift = -e;
+}
+
+static size_t kws_syn_layer(uint8_t *p, int type, int k_h, int k_w, int s, int oc, int n_w, int fan, uint32_t *seed)
+{
+    int32_t mult = 0;
+    int shift = 0;
+    if (n_w > 0) kws_syn_mult(fan, &mult, &shift);
+    if (p) {
+        memset(p, 0, 16);
+        p[0] = (uint8_t)type;
+        p[1] = (type != 4); // 除最后的全连接都带 relu
+        p[2] = (uint8_t)k_h;
+        p[3] = (uint8_t)k_w;
+        p[4] = p[5] = (uint8_t)s;
+        p[6] = 1;
+        p[7] = (uint8_t)(int8_t)shift;
+        put16(p + 8, (uint16_t)oc);
+        put32(p + 12, (uint32_t)mult);
+    }
+    size_t off = 16;
+    if (n_w == 0) return off;
+    for (int i = 0; i < n_w; ++i) {
+        const uint32_t r = app_tsig_lcg(seed);
+        if (p) p[off + i] = (uint8_t)(int8_t)((int)(r >> 25) - 64);
+    }
+    off += (size_t)((n_w + 3) & ~3);
+    if (p) memset(p + off, 0, (size_t)oc * 4);
+    return off + (size_t)oc * 4;
+}
+
+size_t app_tsig_kws_model(uint8_t *p)
+{
+    const int in_t = 49, in_f = 10, n_classes = 3, ch = KWS_SYN_CH;
+    const int n_layers = 3 + 2 * KWS_SYN_BLOCKS;
+    uint32_t seed = 0x4b575331u;
+    size_t off = 48;
+#define KWS_SYN(type, kh, kw, s, oc, nw, fan) off += kws_syn_layer(p ? p + off : NULL, type, kh, kw, s, oc, nw, fan, &seed)
+    KWS_SYN(1, 10, 4, 2, ch, ch * 40, 40);
+    for (int b = 0; b < KWS_SYN_BLOCKS; ++b) {
+        KWS_SYN(2, 3, 3, 1, ch, 9 * ch, 9);
+        KWS_SYN(1, 1, 1, 1, ch, ch * ch, ch);
+    }
+    KWS_SYN(3, 0, 0, 1, ch, 0, 0);
+    KWS_SYN(4, 0, 0, 1, n_classes, n_classes * ch, ch);
+#undef KWS_SYN
+    if (p) {
+        memset(p, 0, 48);
+        put32(p, 0x3153574Bu);
+        put16(p + 4, 1);
+        put16(p + 6, (uint16_t)n_layers);
+        put16(p + 8, (uint16_t)in_t);
+        put16(p + 10, (uint16_t)in_f);
+        p[12] = APP_KWS_FEAT_MFCC;
+        p[13] = 40;
+        p[14] = (uint8_t)n_classes;
+        p[15] = (uint8_t)(n_classes - 1);
+        put32(p + 20, 1u << 30); // 输入 /4：Q8 MFCC 约 ±500 -> int8
+        p[24] = 0;
+        put16(p + 28, 20);
+        put16(p + 30, 4000);
+        put32(p + 36, 1u << 22); // logit 尺度 0.25
+        put32(p + 40, (uint32_t)off);
+    }
+    return off;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "App_PcmOps.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 合成测试信号与场景：Task_Dsp_Selftest（目标板）和 tools/ 下的主机基准共用一份，
+ * 同样的种子两边得到逐样本相同的输入，板上与主机的数字可以直接对照。
+ * 不依赖 IDF（主机上与 App_PcmOps.c 一起编译）。帧长一律 sr/50（20 ms）。
+ */
+
+#define APP_TSIG_HARMONICS 6
+#define APP_TSIG_FRAME_MAX 960 // 20 ms @ 48 kHz
+
+// 线性同余（Numerical Recipes 常数）：所有基准的伪随机都走这一个
+static inline uint32_t app_tsig_lcg(uint32_t *st)
+{
+    *st = *st * 1664525u + 1013904223u;
+    return *st;
+}
+
+/**
+ * @brief 近似高斯噪声（4 个均匀分布相加），标准差约 amp * 0.58
+ */
+int16_t app_tsig_noise(uint32_t *st, int amp);
+
+double app_tsig_pow(const int16_t *x, int n);
+
+/**
+ * @brief ref 与 y 的 SNR（dB），y 与 ref 完全相同时返回 99
+ */
+double app_tsig_snr_db(const int16_t *ref, const int16_t *y, int n);
+
+/**
+ * @brief 通用测试信号：300 Hz + 1.7 kHz 两个音 + 伪随机噪声，幅度接近真实语音
+ */
+void app_tsig_tones(int16_t *x, int n, int sr);
+
+// ---------- 语音 + 房间噪声（降噪 / AGC 场景） ----------
+
+typedef enum {
+    APP_TSIG_NOISE_FAN = 0, // 平稳低通噪声
+    APP_TSIG_NOISE_TV,      // 宽带噪声，响度 0.25 Hz 起伏
+} app_tsig_noise_t;
+
+typedef struct {
+    int sr;
+    int frame;
+    app_pcm_nco_t h[APP_TSIG_HARMONICS];
+    int16_t tmp[APP_TSIG_FRAME_MAX];
+    uint32_t ns; // 噪声种子（逐帧延续）
+    int32_t lp;
+} app_tsig_scene_t;
+
+void app_tsig_scene_init(app_tsig_scene_t *sc, int sr, uint32_t noise_seed);
+
+/**
+ * @brief 第 f 帧合成语音：1.5 s 说（6 个 250 ms 音节，基频各不相同、sin^2 包络）/ 1.5 s 停
+ */
+void app_tsig_speech(app_tsig_scene_t *sc, int f, int amp, int16_t *out);
+
+/**
+ * @brief 第 f 帧房间噪声（帧须按顺序取，噪声序列逐帧延续）
+ */
+void app_tsig_room_noise(app_tsig_scene_t *sc, app_tsig_noise_t type, int f, int amp, int16_t *out);
+
+// ---------- 双麦（波束场景） ----------
+
+/**
+ * @brief 声源：300 ms 有 / 200 ms 无的低通噪声
+ */
+void app_tsig_bf_source(int16_t *src, int n, int sr);
+
+/**
+ * @brief 第 f 帧双麦输入：声源从 tau 方向到达（m1 比 m0 晚 tau 个样本），两麦各自叠加独立噪声
+ *
+ * src 前后各留 pad（>= |tau|）个样本。part: 0 混合，1 只有声源，2 只有噪声（锁定导向后分别测功率）
+ */
+void app_tsig_bf_frame(const int16_t *src, int frame, int pad, int f, int tau, int noise_amp, uint32_t *ns0,
+                       uint32_t *ns1, int part, int16_t *m0, int16_t *m1);
+
+// ---------- 能量 VAD（与 App_SpeakState 相同的判决，用来数误唤醒） ----------
+
+// 500 ms 窗平均绝对值 > 80 为有声；连续 3 窗开口、6 窗静音
+typedef struct {
+    int64_t sum;
+    int n;
+    int on_cnt, off_cnt;
+    bool speaking;
+    int wakes;
+    int voiced, windows;
+} app_tsig_vad_t;
+
+void app_tsig_vad_feed(app_tsig_vad_t *v, int sr, const int16_t *x, int n);
+
+// ---------- 合成唤醒词模型 ----------
+
+/**
+ * @brief 合成 DS-CNN（49x10 MFCC，10x4/2 卷积 + 4 组 dw3x3/pw，32 通道，3 类），权重伪随机
+ *
+ * 结构与 tools/mkkwsmodel.py random 相同，没有真模型时测 CPU 用。p 为 NULL 时只返回长度。
+ */
+size_t app_tsig_kws_model(uint8_t *p);
+
+#ifdef __cplusplus
+}
+#endif
@@ -14,15 +14,35 @@
 #include "esp_netif.h"
 #include <inttypes.h>
 #include "esp_heap_caps.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 #include "protocol_examples_common.h"
 
+#include "App_Adpcm.h"
+#include "App_AssetPack.h"
+#include "App_EventBus.h"
+#include "App_EventCache.h"
+#include "App_Kws.h"
+#include "App_Ptt.h"
+#include "App_Rb3ConnMgr.h"
 #include "App_Speak_Sound.h"
 #include "App_RobotBrainV3.h"
 #include "App_SpeakState.h"
 
 static const char *TAG = "Task_Chat_Continue";
 
+#ifdef CONFIG_VOICE_WAKEUP_MODE
+#define CHAT_WAKE_WORD_DEFAULT true
+#else
+#define CHAT_WAKE_WORD_DEFAULT false
+#endif
+
+#ifdef CONFIG_KEY_PRESS_DIALOG_MODE
+#define CHAT_PTT_DEFAULT true
+#else
+#define CHAT_PTT_DEFAULT false
+#endif
+
 typedef struct {
     uint8_t *pcm;
     size_t pcm_len;
@@ -39,31 +59,74 @@ typedef enum {
 typedef enum {
     CHAT_EVT_SPEAK_ON = 1,
     CHAT_EVT_SPEAK_OFF = 2,
+    CHAT_EVT_WAKE = 3,       // 唤醒词触发
+    CHAT_EVT_PTT_DOWN = 4,   // 按键按下
+    CHAT_EVT_PTT_UP = 5,     // 按键松开
 } chat_evt_type_t;
 
 typedef struct {
     chat_evt_type_t type;
     uint32_t tick;
+    int64_t t_us;            // 事件时刻（按键事件为中断里的时刻）
 } chat_evt_t;
 
+// 上行节流：preroll 一次性突发发送，之后按采集速率 token bucket 发送；
+// chunk 大小按 send 实测耗时自适应（加性增、乘性减）
+typedef struct {
+    bool burst;               // true: 正在突发清空 preroll/积压
+    int chunk;                // 当前 chunk 字节数
+    int64_t tokens;           // 可发送字节（token）
+    int64_t last_refill_us;
+    uint32_t send_lat_us;     // send 耗时 EWMA
+
+    uint64_t bytes_sent;
+    uint64_t bytes_dropped;
+    uint64_t send_time_us;
+    uint32_t lag_ms;
+    uint32_t max_lag_ms;
+
+    uint64_t cpu_us;          // 累计上行 CPU（见 uplink_cpu_sample）
+
+    // 本轮统计（用于每轮日志：吞吐 + 每秒音频的 CPU）
+    uint64_t turn_bytes;
+    uint64_t turn_send_us;
+    uint32_t turn_rt_net0;    // 本轮起点的任务运行时间（esp_timer 微秒）
+    uint32_t turn_rt_ip0;
+} uplink_pacer_t;
+
 typedef struct {
     task_chat_continue_cfg_t cfg;
     app_speak_sound_cfg_t audio_cfg;
 
     QueueHandle_t q_evt;          // chat_evt_t
     RingbufHandle_t rb_play;      // raw PCM bytes
+    size_t rx_window_base;        // WS 下行接收窗口基数（rb3.rx_window_bytes），另加播放环余量
 
     volatile uint32_t turn_id;    // 每次开始说话 +1（用于打断/丢弃旧音频）
     volatile bool playing;
     volatile uint32_t abort_token; // 递增即可触发打断（避免 bool 粘滞）
+    TaskHandle_t play_task;        // 打断时直接唤醒，不等它的轮询间隔
+    TaskHandle_t net_task;
+    TaskHandle_t tcpip_task;       // lwIP tcpip 线程：上行 CPU 连同它一起算
+    volatile int64_t barge_t0_us;  // 播放中检测到开口的时刻（0：无待测打断）
+    uint64_t barge_sum_ms;
 
     // phase
     volatile chat_phase_t phase;
     uint32_t last_activity_tick;
 
     // audio circular buffer (PSRAM): 始终循环存储麦克风 PCM
+    // seq/pre_cap 均按“PCM 字节”计；ADPCM 模式下 pre_rb 存编码块，按块寻址
     uint8_t *pre_rb;
     size_t pre_cap;
+    bool pre_adpcm;
+    size_t pre_blocks;            // ADPCM：环中块数
+    int16_t pre_stage[APP_ADPCM_BLOCK_SAMPLES]; // ADPCM：写端凑满一块再编码（仅 mic 回调线程访问）
+    size_t pre_stage_bytes;
+    app_adpcm_enc_t pre_enc;
+    int16_t pre_dec[APP_ADPCM_BLOCK_SAMPLES];   // ADPCM：读端最近解码的块（仅 task_net 访问）
+    uint64_t pre_dec_blk;         // 已解码块号 + 1（0 表示无）
+    uint8_t *txbuf;               // ADPCM：解码后的上行发送缓冲（uplink_max_chunk_bytes）
     size_t pre_preroll_bytes;     // 1.5s 对应 bytes
     volatile uint64_t pre_seq_w;  // 已写入总字节数（单调递增）
     uint64_t send_seq_r;          // 唤醒期发送指针（单调递增，<= pre_seq_w）
@@ -71,17 +134,58 @@ typedef struct {
 
     // send pacing / backlog control
     uint32_t last_catchup_log_tick;
+    uplink_pacer_t up;
 
-    // WS session (keep-alive in WAITING)
+    // WS session：由连接管理器保持，唤醒期借用一轮（NULL 表示本轮尚未拿到连接）
     app_rb3_ws_sess_t *ws;
+    bool start_pending;           // 说话已开始但 start 还没发出（连接未就绪）
+    bool off_pending;             // start 未发出时已说完：补发积压后再结束本轮
+    bool first_uplink_pending;
+    int64_t wake_us;              // 本轮说话起点
+    int64_t start_wait_us;        // 开始等连接的时刻（说话起点或中途换连接时）
+    uint64_t turn_seq0;           // 本轮上传起点（换连接后从这里整轮重发）
+    bool catchup_open;            // ADPCM：本轮（或换连接重发）还没发出首个字节，积压只受历史长度限制
+    uint64_t catchup_seq;         // ADPCM：首个字节发出时的写指针，此前的积压允许追完
+    int turn_failovers;
+    uint64_t wake_uplink_sum_ms;
+    char cur_req[24];             // 本轮 req（事件总线上的文本事件带上，订阅端据此区分轮次）
+
+    // 首包延迟统计（end -> 首个下行 audio）
+    bool last_turn_cancelled;     // 上一轮是否被打断（已向服务端发 cancel）
+    task_chat_continue_latency_stats_t lat;
+    uint64_t lat_sum_ms;
+    uint64_t lat_after_cancel_sum_ms;
 
     // play buffering control
     volatile uint32_t play_bytes_in;
     uint32_t play_prefill_bytes; // 至少缓存多少再开始播（默认 1s）
-    uint32_t play_low_wm_bytes;  // 低水位：降到此以下才恢复快速入队
-    uint32_t play_high_wm_bytes; // 高水位：超过则对下行做背压
+
+    // 等待回复（task_net 写，task_play 读）：end 时刻（ms），0 表示不在等待
+    volatile uint32_t resp_end_ms;
+    uint64_t perceived_sum_ms;
+    int filler_next;              // 垫音池轮换位置
+
+    // 唤醒词：mic 回调把采集帧转给 task_kws（推理较重，不放在 mic 任务里）
+    bool kws_on;
+    app_kws_t kws;
+    RingbufHandle_t rb_kws;
+    volatile bool vad_speaking;   // 能量 VAD 当前是否判为说话
+    int64_t wake_listen_us;       // 唤醒词触发后等开口的截止时刻（0：不在等）
+
+    // 按键说话：按键回调直接投递事件；按键开启的轮次松键即结束，不看 VAD
+    bool ptt_on;
+    app_ptt_t ptt;
+    bool turn_ptt;
+    bool ptt_end_pending;         // 已松键：积压发到 ptt_end_seq 再 end
+    uint64_t ptt_end_seq;
+    int64_t ptt_up_us;
+    size_t ptt_preroll_bytes;
+    uint64_t ptt_uplink_sum_ms;
+    uint64_t ptt_end_sum_ms;
 } chat_ctx_t;
 
+static chat_ctx_t *s_chat = NULL;
+
 typedef struct {
     chat_ctx_t *c;
     uint32_t *last_abort_seen;
@@ -94,17 +198,6 @@ static bool should_abort_ws(void *ctx)
     return a->c->abort_token != *(a->last_abort_seen);
 }
 
-static float frame_mean_abs_16(const int16_t *x, int n)
-{
-    int64_t sum = 0;
-    for (int i = 0; i < n; ++i) {
-        int32_t v = x[i];
-        if (v < 0) v = -v;
-        sum += v;
-    }
-    return (n > 0) ? (float)sum / (float)n : 0.0f;
-}
-
 // forward decl: used by on_audio_push_rb_track()
 static esp_err_t on_audio_push_rb(const uint8_t *pcm, size_t pcm_len, bool is_last, void *ctx);
 
@@ -121,53 +214,59 @@ static bool is_playback_active(chat_ctx_t *c)
 typedef struct {
     chat_ctx_t *c;
     bool *got_audio;
+    int64_t *first_audio_us;
 } dl_audio_ctx_t;
 
 static esp_err_t on_audio_push_rb_track(const uint8_t *pcm, size_t pcm_len, bool is_last, void *ctx)
 {
     dl_audio_ctx_t *d = (dl_audio_ctx_t *)ctx;
     if (d && d->got_audio && pcm && pcm_len > 0) {
+        if (!*(d->got_audio) && d->first_audio_us) {
+            *(d->first_audio_us) = esp_timer_get_time();
+        }
         *(d->got_audio) = true;
     }
     return on_audio_push_rb(pcm, pcm_len, is_last, d ? d->c : NULL);
 }
 
+// 下行接收窗口 = 基数 + 播放环余量（base64 膨胀约 4/3）：播放环与 ws 队列合起来积压的总量固定，
+// 环满时队列只剩基数。超出时 ws 会话作废本次回复并 cancel（ws 任务不能阻塞，做不到 TCP 背压）
+static void update_rx_window(chat_ctx_t *c)
+{
+    if (!c || !c->ws || !c->rb_play || !c->rx_window_base) return;
+    const size_t headroom = xRingbufferGetCurFreeSize(c->rb_play);
+    app_rb3_ws_set_rx_window(c->ws, c->rx_window_base + headroom / 3 * 4);
+}
+
 static esp_err_t on_audio_push_rb(const uint8_t *pcm, size_t pcm_len, bool is_last, void *ctx)
 {
     (void)is_last;
     chat_ctx_t *c = (chat_ctx_t *)ctx;
     if (!c || !pcm || pcm_len == 0) return ESP_ERR_INVALID_ARG;
 
-    // 如果已经被打断（turn_id 变化），丢弃后续 audio
-    uint32_t cur_turn = c->turn_id;
-
     // 若上层已触发打断，尽快退出（让 ws_recv 结束）
     uint32_t abort0 = c->abort_token;
 
-    // 背压：如果播放缓冲高于高水位，先等它消耗到低水位再继续入队
-    // 目的：避免“服务端灌得太快 -> ringbuf 满 -> 丢块 -> 听起来卡”
-    while (__atomic_load_n(&c->play_bytes_in, __ATOMIC_RELAXED) > c->play_high_wm_bytes) {
-        if (c->abort_token != abort0) return ESP_ERR_INVALID_STATE;
-        vTaskDelay(pdMS_TO_TICKS(20));
-        if (__atomic_load_n(&c->play_bytes_in, __ATOMIC_RELAXED) <= c->play_low_wm_bytes) break;
-    }
-
-    // copy to ringbuffer (ringbuf 负责分配内部节点内存)
-    // 不再“满就丢”：而是等一等（同时让 TCP 背压生效）
+    // copy to ringbuffer（阻塞等待空间，由 task_play 归还 item 唤醒；不丢块）
+    uint32_t waited = 0;
     for (;;) {
         if (c->abort_token != abort0) return ESP_ERR_INVALID_STATE;
         BaseType_t ok = xRingbufferSend(c->rb_play, pcm, pcm_len, pdMS_TO_TICKS(200));
         if (ok == pdTRUE) {
             (void)__atomic_fetch_add(&c->play_bytes_in, (uint32_t)pcm_len, __ATOMIC_RELAXED);
             c->playing = true;
+            update_rx_window(c);
             return ESP_OK;
         }
-        // 仍然满：稍等再试（避免刷屏，只在满时偶尔提示）
-        ESP_LOGW(TAG, "play ringbuf full, wait... drop=0 bytes (turn=%" PRIu32 ")", cur_turn);
-        vTaskDelay(pdMS_TO_TICKS(20));
+        // 满：在 recv 线程上等，后续消息先排在 ws 会话的接收窗口里（PSRAM），窗口随余量收回到基数
+        update_rx_window(c);
+        if ((waited++ % 10) == 0) {
+            ESP_LOGW(TAG, "play ringbuf full, wait turn=%" PRIu32, c->turn_id);
+        }
     }
 }
 
+// 只由 task_play 调用（单一消费者，避免 play_bytes_in 记账错乱）
 static void flush_play_rb(chat_ctx_t *c)
 {
     if (!c || !c->rb_play) return;
@@ -179,52 +278,159 @@ static void flush_play_rb(chat_ctx_t *c)
     __atomic_store_n(&c->play_bytes_in, 0, __ATOMIC_RELAXED);
 }
 
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+// 喇叭出第一个声音（垫音或回复）：记录感知延迟
+static void record_perceived_latency(chat_ctx_t *c, bool filler)
+{
+    uint32_t end_ms = c->resp_end_ms;
+    if (end_ms == 0) return;
+    c->resp_end_ms = 0;
+
+    uint32_t ms = now_ms() - end_ms;
+    task_chat_continue_latency_stats_t *l = &c->lat;
+    l->perceived_turns++;
+    l->perceived_ms_last = ms;
+    c->perceived_sum_ms += ms;
+    l->perceived_ms_avg = (uint32_t)(c->perceived_sum_ms / l->perceived_turns);
+    if (filler) l->fillers_played++;
+    ESP_LOGI(TAG, "感知延迟: %" PRIu32 " ms（%s）；平均 感知=%" PRIu32 "ms 实际首包=%" PRIu32 "ms",
+             ms, filler ? "垫音" : "回复", l->perceived_ms_avg, l->first_audio_ms_avg);
+}
+
+// 从资源包垫音池轮换取一条（格式须与喇叭一致）
+static bool filler_pick(chat_ctx_t *c, app_asset_t *out)
+{
+    if (!app_asset_pack_ready()) return false;
+    for (int i = 0; i < APP_ASSET_ID_FILLER_MAX; ++i) {
+        int idx = (c->filler_next + i) % APP_ASSET_ID_FILLER_MAX;
+        if (app_asset_get((uint16_t)(APP_ASSET_ID_FILLER_BASE + idx), out) != ESP_OK) continue;
+        if (out->kind != APP_ASSET_KIND_PCM || out->sample_rate != c->audio_cfg.sample_rate ||
+            out->channels != c->audio_cfg.channels) {
+            continue;
+        }
+        c->filler_next = idx + 1;
+        return true;
+    }
+    return false;
+}
+
+static void record_barge_in(chat_ctx_t *c, uint32_t ms)
+{
+    task_chat_continue_latency_stats_t *l = &c->lat;
+    l->barge_ins++;
+    l->barge_ms_last = ms;
+    if (ms > l->barge_ms_max) l->barge_ms_max = ms;
+    c->barge_sum_ms += ms;
+    l->barge_ms_avg = (uint32_t)(c->barge_sum_ms / l->barge_ins);
+    ESP_LOGI(TAG, "打断: 开口->静音 %" PRIu32 " ms（平均 %" PRIu32 "ms，最大 %" PRIu32 "ms）", ms, l->barge_ms_avg,
+             l->barge_ms_max);
+}
+
+// 打断：混音器丢弃所有流未写出的输出、喇叭淡出静音，清空待播队列
+static void play_abort(chat_ctx_t *c)
+{
+    int64_t silent_us = esp_timer_get_time();
+    (void)app_speak_sound_out_cancel(c->cfg.barge_fade_ms, &silent_us);
+    flush_play_rb(c);
+    c->playing = false;
+
+    int64_t t0 = c->barge_t0_us;
+    if (t0 != 0) {
+        c->barge_t0_us = 0;
+        record_barge_in(c, (uint32_t)((silent_us > t0 ? silent_us - t0 : 0) / 1000));
+    }
+}
+
 static void task_play(void *arg)
 {
     chat_ctx_t *c = (chat_ctx_t *)arg;
     const int chunk = (c->cfg.spk_chunk_bytes > 0) ? c->cfg.spk_chunk_bytes : 512;
+    const size_t frame_bytes = sizeof(int16_t) * (size_t)((c->audio_cfg.channels > 0) ? c->audio_cfg.channels : 1);
     uint32_t last_abort = c->abort_token;
     bool prefilled = false;
 
+    // 当前垫音（指向 flash 映射区）
+    const uint8_t *filler = NULL;
+    size_t filler_len = 0;
+    size_t filler_off = 0;
+    uint32_t filler_end_ms = 0; // 已为哪一轮（resp_end_ms）放过垫音，每轮最多一次
+
     while (1) {
         // 若收到打断请求，即使当前无音频也要清一次队列
         if (c->abort_token != last_abort) {
-            flush_play_rb(c);
-            c->playing = false;
+            play_abort(c);
             last_abort = c->abort_token;
             prefilled = false;
-            vTaskDelay(pdMS_TO_TICKS(20)); // 让 DMA 自然消耗一点点，降低爆音概率
+            filler = NULL;
         }
 
         // 至少缓存一定数据再开始播放（降低网络抖动导致的卡顿）
         if (!prefilled) {
             uint32_t inb = __atomic_load_n(&c->play_bytes_in, __ATOMIC_RELAXED);
             if (inb < c->play_prefill_bytes) {
-                vTaskDelay(pdMS_TO_TICKS(20));
+                // 正在播垫音：继续送一小块（FILLER 流满时最多等 20ms），同时等回复凑够 prefill
+                if (filler) {
+                    size_t n = filler_len - filler_off;
+                    if (n > (size_t)chunk) n = (size_t)chunk;
+                    filler_off += app_speak_sound_stream_write(APP_SPK_STREAM_FILLER, filler + filler_off, n,
+                                                               pdMS_TO_TICKS(20));
+                    if (filler_off >= filler_len) {
+                        filler = NULL; // 垫音已全部送入混音器，播完前 playing 保持，由下面的空闲检查清掉
+                    }
+                    continue;
+                }
+
+                // 超过首包预算仍无声：起垫音
+                uint32_t end_ms = c->resp_end_ms;
+                if (end_ms != 0 && end_ms != filler_end_ms && c->cfg.first_audio_budget_ms > 0 &&
+                    now_ms() - end_ms >= (uint32_t)c->cfg.first_audio_budget_ms) {
+                    filler_end_ms = end_ms;
+                    app_asset_t a;
+                    if (filler_pick(c, &a)) {
+                        filler = (const uint8_t *)a.data;
+                        filler_len = a.len - (a.len % frame_bytes);
+                        filler_off = 0;
+                        c->playing = true; // 抑制回声触发唤醒
+                        ESP_LOGI(TAG, "首包超过预算 %dms，播放垫音 %s（%u bytes）", c->cfg.first_audio_budget_ms,
+                                 a.name, (unsigned)filler_len);
+                        record_perceived_latency(c, true);
+                        continue;
+                    }
+                }
+                if (c->playing && inb == 0 && app_speak_sound_out_pending_frames() == 0) {
+                    c->playing = false;
+                }
+                // 等数据；打断时 mic 任务会直接通知，不用等满 20ms
+                (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
                 continue;
             }
             prefilled = true;
-            ESP_LOGI(TAG, "play prefill ok: %u bytes, start playback", (unsigned)inb);
+            ESP_LOGI(TAG, "play prefill ok: %u bytes, start playback%s", (unsigned)inb, filler ? "（垫音交叉淡入）" : "");
+            // 垫音不再续送：回复进 TTS 流后混音器在 filler_xfade_ms 内把 FILLER 流压到静音并丢弃剩余
+            filler = NULL;
         }
 
         size_t item_size = 0;
-        uint8_t *item = (uint8_t *)xRingbufferReceive(c->rb_play, &item_size, pdMS_TO_TICKS(200));
+        uint8_t *item = (uint8_t *)xRingbufferReceive(c->rb_play, &item_size, pdMS_TO_TICKS(50));
         if (!item) {
-            c->playing = false;
-            prefilled = false; // underrun：等下次再凑够 prefill
+            // 队列空：驱动里还有没播完的就仍算播放中（抑制回声唤醒），播空了才算 underrun
+            if (app_speak_sound_out_pending_frames() == 0) {
+                c->playing = false;
+                prefilled = false; // underrun：等下次再凑够 prefill
+            }
             continue;
         }
 
-        // 分小块写，便于“说话即打断”
+        record_perceived_latency(c, false);
+
+        // 整项拷进 TTS 流（混音器按块写 DMA）；FIFO 满时分段等待，期间可被打断
         size_t off = 0;
-        while (off < item_size) {
-            if (c->abort_token != last_abort) {
-                break;
-            }
-            size_t n = item_size - off;
-            if (n > (size_t)chunk) n = (size_t)chunk;
-            (void)app_speak_sound_spk_write(item + off, n);
-            off += n;
+        while (off < item_size && c->abort_token == last_abort) {
+            off += app_speak_sound_out_write(item + off, item_size - off, pdMS_TO_TICKS(20));
         }
 
         vRingbufferReturnItem(c->rb_play, item);
@@ -233,19 +439,43 @@ static void task_play(void *arg)
         }
 
         if (c->abort_token != last_abort) {
-            flush_play_rb(c);
-            c->playing = false;
+            play_abort(c);
             last_abort = c->abort_token;
             prefilled = false;
-            vTaskDelay(pdMS_TO_TICKS(20));
         }
     }
 }
 
+static void prebuf_write_adpcm(chat_ctx_t *c, const uint8_t *data, size_t len)
+{
+    uint8_t *stage = (uint8_t *)c->pre_stage;
+    size_t off = 0;
+    while (off < len) {
+        size_t n = APP_ADPCM_BLOCK_PCM_BYTES - c->pre_stage_bytes;
+        if (n > len - off) n = len - off;
+        memcpy(stage + c->pre_stage_bytes, data + off, n);
+        c->pre_stage_bytes += n;
+        off += n;
+        if (c->pre_stage_bytes < APP_ADPCM_BLOCK_PCM_BYTES) break;
+
+        // 凑满一块：编码进环，seq 按整块推进
+        uint64_t seq = __atomic_load_n(&c->pre_seq_w, __ATOMIC_RELAXED);
+        size_t slot = (size_t)((seq / APP_ADPCM_BLOCK_PCM_BYTES) % c->pre_blocks);
+        app_adpcm_encode_block(&c->pre_enc, c->pre_stage, c->pre_rb + slot * APP_ADPCM_BLOCK_BYTES);
+        c->pre_stage_bytes = 0;
+        __atomic_store_n(&c->pre_seq_w, seq + APP_ADPCM_BLOCK_PCM_BYTES, __ATOMIC_RELEASE);
+    }
+}
+
 static void prebuf_write(chat_ctx_t *c, const uint8_t *data, size_t len)
 {
     if (!c || !c->pre_rb || c->pre_cap == 0 || !data || len == 0) return;
 
+    if (c->pre_adpcm) {
+        prebuf_write_adpcm(c, data, len);
+        return;
+    }
+
     // 统一策略：无论等待期/唤醒期/静默期，都持续循环存音频
     uint64_t seq = __atomic_load_n(&c->pre_seq_w, __ATOMIC_RELAXED);
     size_t w = (size_t)(seq % c->pre_cap);
@@ -265,42 +495,330 @@ static void prebuf_write(chat_ctx_t *c, const uint8_t *data, size_t len)
     __atomic_store_n(&c->pre_seq_w, seq + len, __ATOMIC_RELEASE);
 }
 
-static size_t prebuf_copy(chat_ctx_t *c, uint64_t seq, uint8_t *dst, size_t len)
+// ADPCM 读取：解码 [seq, seq+len) 到 out（按块解码，跨 chunk 复用最近一块）
+static void prebuf_read_adpcm(chat_ctx_t *c, uint64_t seq, size_t len, uint8_t *out)
+{
+    const uint8_t *dec = (const uint8_t *)c->pre_dec;
+    while (len > 0) {
+        uint64_t blk = seq / APP_ADPCM_BLOCK_PCM_BYTES;
+        size_t off = (size_t)(seq % APP_ADPCM_BLOCK_PCM_BYTES);
+        if (c->pre_dec_blk != blk + 1) {
+            size_t slot = (size_t)(blk % c->pre_blocks);
+            app_adpcm_decode_block(c->pre_rb + slot * APP_ADPCM_BLOCK_BYTES, c->pre_dec);
+            c->pre_dec_blk = blk + 1;
+        }
+        size_t n = APP_ADPCM_BLOCK_PCM_BYTES - off;
+        if (n > len) n = len;
+        memcpy(out, dec + off, n);
+        out += n;
+        seq += n;
+        len -= n;
+    }
+}
+
+// 零拷贝读取：返回 [seq, seq+len) 在环形缓冲中的 1~2 段（回绕时两段）
+static int prebuf_spans(chat_ctx_t *c, uint64_t seq, size_t len, app_rb3_iov_t iov[2])
 {
-    if (!c || !c->pre_rb || !dst || len == 0 || c->pre_cap == 0) return 0;
+    if (!c || !c->pre_rb || !iov || len == 0 || c->pre_cap == 0 || len > c->pre_cap) return 0;
 
-    size_t off = 0;
     size_t r = (size_t)(seq % c->pre_cap);
-    while (off < len) {
-        size_t n = len - off;
-        size_t space = c->pre_cap - r;
-        if (n > space) n = space;
-        memcpy(dst + off, c->pre_rb + r, n);
-        r += n;
-        off += n;
-        if (r >= c->pre_cap) r = 0;
+    size_t n0 = c->pre_cap - r;
+    if (n0 >= len) {
+        iov[0].base = c->pre_rb + r;
+        iov[0].len = len;
+        return 1;
+    }
+    iov[0].base = c->pre_rb + r;
+    iov[0].len = n0;
+    iov[1].base = c->pre_rb;
+    iov[1].len = len - n0;
+    return 2;
+}
+
+// 上行 CPU 取 FreeRTOS 运行时统计（esp_timer 时钟，微秒）：task_net 自己 + lwIP tcpip 线程。
+// send 的墙钟耗时含等网络 / 等窗口，不是 CPU。没开 CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS 时恒为 0
+static void uplink_cpu_sample(const chat_ctx_t *c, uint32_t *net_us, uint32_t *ip_us)
+{
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    *net_us = (uint32_t)ulTaskGetRunTimeCounter(c->net_task);
+    *ip_us = c->tcpip_task ? (uint32_t)ulTaskGetRunTimeCounter(c->tcpip_task) : 0;
+#else
+    (void)c;
+    *net_us = 0;
+    *ip_us = 0;
+#endif
+}
+
+static void uplink_pacer_reset(chat_ctx_t *c)
+{
+    uplink_pacer_t *u = &c->up;
+    u->burst = true;
+    // chunk 跨轮保留：上一轮学到的链路能力直接复用
+    if (u->chunk <= 0) u->chunk = c->cfg.uplink_min_chunk_bytes;
+    u->tokens = 0;
+    u->last_refill_us = esp_timer_get_time();
+    u->lag_ms = 0;
+    u->max_lag_ms = 0;
+    u->turn_bytes = 0;
+    u->turn_send_us = 0;
+    uplink_cpu_sample(c, &u->turn_rt_net0, &u->turn_rt_ip0);
+}
+
+static void uplink_pacer_refill(chat_ctx_t *c)
+{
+    uplink_pacer_t *u = &c->up;
+    int64_t now = esp_timer_get_time();
+    int64_t dt = now - u->last_refill_us;
+    u->last_refill_us = now;
+    if (dt <= 0) return;
+
+    // 速率比采集略高 25%：小幅落后能自然追上，又不会把链路打满
+    u->tokens += (dt * (int64_t)c->bytes_per_sec * 5) / (4 * 1000000LL);
+    const int64_t cap = (int64_t)u->chunk * 2;
+    if (u->tokens > cap) u->tokens = cap;
+}
+
+static void uplink_pacer_on_sent(chat_ctx_t *c, size_t n, int64_t lat_us)
+{
+    uplink_pacer_t *u = &c->up;
+    if (lat_us < 0) lat_us = 0;
+    u->bytes_sent += n;
+    u->send_time_us += (uint64_t)lat_us;
+    u->turn_bytes += n;
+    u->turn_send_us += (uint64_t)lat_us;
+    u->send_lat_us = (u->send_lat_us == 0) ? (uint32_t)lat_us : (uint32_t)(((int64_t)u->send_lat_us * 7 + lat_us) / 8);
+
+    // 链路慢：chunk 减半，单次 send 阻塞更短、更易响应打断；
+    // 链路快：chunk 逐步加大，减少 WS 帧与调度开销
+    const int64_t target_us = (int64_t)c->cfg.uplink_target_send_ms * 1000;
+    int chunk = u->chunk;
+    if (lat_us > target_us) {
+        chunk /= 2;
+    } else if (lat_us < target_us / 4) {
+        chunk += c->cfg.uplink_min_chunk_bytes;
+    }
+    if (chunk < c->cfg.uplink_min_chunk_bytes) chunk = c->cfg.uplink_min_chunk_bytes;
+    if (chunk > c->cfg.uplink_max_chunk_bytes) chunk = c->cfg.uplink_max_chunk_bytes;
+    u->chunk = chunk & ~3; // 按采样帧对齐
+}
+
+static void uplink_pacer_track_lag(chat_ctx_t *c, size_t backlog)
+{
+    uplink_pacer_t *u = &c->up;
+    u->lag_ms = (c->bytes_per_sec > 0) ? (uint32_t)(((uint64_t)backlog * 1000) / c->bytes_per_sec) : 0;
+    if (u->lag_ms > u->max_lag_ms) u->max_lag_ms = u->lag_ms;
+}
+
+static void record_first_audio_latency(chat_ctx_t *c, uint32_t ms)
+{
+    task_chat_continue_latency_stats_t *l = &c->lat;
+    l->first_audio_ms_last = ms;
+    if (c->last_turn_cancelled) {
+        l->turns_after_cancel++;
+        c->lat_after_cancel_sum_ms += ms;
+        l->first_audio_after_cancel_ms_avg = (uint32_t)(c->lat_after_cancel_sum_ms / l->turns_after_cancel);
+    } else {
+        l->turns++;
+        c->lat_sum_ms += ms;
+        l->first_audio_ms_avg = (uint32_t)(c->lat_sum_ms / l->turns);
+    }
+    ESP_LOGI(TAG, "首包延迟: %" PRIu32 " ms（%s）；平均 普通=%" PRIu32 "ms 打断后=%" PRIu32 "ms",
+             ms, c->last_turn_cancelled ? "打断后" : "普通", l->first_audio_ms_avg,
+             l->first_audio_after_cancel_ms_avg);
+}
+
+// WS 下行非音频消息：解析后立即转发到事件总线（非阻塞），表情/动作据此提前调度
+static void on_ws_meta(const app_rb3_meta_t *meta, void *ctx)
+{
+    (void)ctx;
+    app_evt_t e = {0};
+    e.type = APP_EVT_META;
+    strncpy(e.req, meta->req, sizeof(e.req) - 1);
+    strncpy(e.meta.anim, meta->anim, sizeof(e.meta.anim) - 1);
+    strncpy(e.meta.motion, meta->motion, sizeof(e.meta.motion) - 1);
+    app_event_bus_publish(&e);
+    ESP_LOGI(TAG, "meta: req=%s anim=%s motion=%s", meta->req, meta->anim, meta->motion);
+}
+
+static void on_ws_asr_text(const char *text, size_t len, void *ctx)
+{
+    chat_ctx_t *c = (chat_ctx_t *)ctx;
+    app_event_bus_publish_text(APP_EVT_ASR_TEXT, c->cur_req, text, len);
+}
+
+static void on_ws_text_delta(const char *delta, size_t len, void *ctx)
+{
+    chat_ctx_t *c = (chat_ctx_t *)ctx;
+    app_event_bus_publish_text(APP_EVT_TEXT_DELTA, c->cur_req, delta, len);
+}
+
+static void on_ws_text(const char *text, size_t len, void *ctx)
+{
+    chat_ctx_t *c = (chat_ctx_t *)ctx;
+    app_event_bus_publish_text(APP_EVT_TEXT, c->cur_req, text, len);
+}
+
+static void publish_reply_end(chat_ctx_t *c)
+{
+    app_evt_t e = {0};
+    e.type = APP_EVT_REPLY_END;
+    strncpy(e.req, c->cur_req, sizeof(e.req) - 1);
+    app_event_bus_publish(&e);
+}
+
+// 连接管理器回调：新主连接挂上会话回调，事件请求（app_event_cache_event_stream）复用这条长连接
+static void on_ws_up(app_rb3_ws_sess_t *sess, void *ctx)
+{
+    chat_ctx_t *c = (chat_ctx_t *)ctx;
+    app_rb3_ws_callbacks_t cbs = {
+        .on_meta = on_ws_meta,
+        .on_asr_text = on_ws_asr_text,
+        .on_text_delta = on_ws_text_delta,
+        .on_text = on_ws_text,
+        .ctx = c,
+    };
+    app_rb3_ws_set_callbacks(sess, &cbs);
+    app_event_cache_set_ws_session(sess);
+}
+
+static void on_ws_down(app_rb3_ws_sess_t *sess, void *ctx)
+{
+    (void)sess;
+    (void)ctx;
+    app_event_cache_set_ws_session(NULL);
+}
+
+// 本轮用完（或发现已坏）归还给连接管理器；坏连接由管理器关闭并切换/重连
+static void chat_ws_release(chat_ctx_t *c, bool broken)
+{
+    if (!c->ws) return;
+    app_rb3_connmgr_release(c->ws, broken);
+    c->ws = NULL;
+}
+
+static void record_wake_uplink(chat_ctx_t *c)
+{
+    uint32_t ms = (uint32_t)((esp_timer_get_time() - c->wake_us) / 1000);
+    task_chat_continue_latency_stats_t *l = &c->lat;
+    l->wake_turns++;
+    l->wake_uplink_ms_last = ms;
+    if (ms > l->wake_uplink_ms_max) l->wake_uplink_ms_max = ms;
+    c->wake_uplink_sum_ms += ms;
+    l->wake_uplink_ms_avg = (uint32_t)(c->wake_uplink_sum_ms / l->wake_turns);
+    if (c->turn_ptt) {
+        l->ptt_turns++;
+        l->ptt_uplink_ms_last = ms;
+        if (ms > l->ptt_uplink_ms_max) l->ptt_uplink_ms_max = ms;
+        c->ptt_uplink_sum_ms += ms;
+        l->ptt_uplink_ms_avg = (uint32_t)(c->ptt_uplink_sum_ms / l->ptt_turns);
+    }
+    ESP_LOGI(TAG, "%s->首个上行: %" PRIu32 " ms（平均 %" PRIu32 "ms，最大 %" PRIu32 "ms，未就绪 %" PRIu32 " 次）",
+             c->turn_ptt ? "按下" : "唤醒", ms, l->wake_uplink_ms_avg, l->wake_uplink_ms_max, l->wake_not_ready);
+}
+
+// 从读指针发 n 字节（一条 WS 消息）并推进读指针；失败时读指针不动
+static esp_err_t uplink_send(chat_ctx_t *c, size_t n, int64_t *out_lat_us)
+{
+    app_rb3_iov_t iov[2] = {0};
+    int segs = 0;
+    if (c->pre_adpcm) {
+        // 压缩历史：读指针处解码到发送缓冲（原始模式仍直接从环形缓冲零拷贝发送）
+        prebuf_read_adpcm(c, c->send_seq_r, n, c->txbuf);
+        iov[0].base = c->txbuf;
+        iov[0].len = n;
+        segs = 1;
+    } else {
+        segs = prebuf_spans(c, c->send_seq_r, n, iov);
+    }
+    int64_t t0 = esp_timer_get_time();
+    esp_err_t sret = app_rb3_ws_send_binv(c->ws, iov, segs, 2000);
+    int64_t lat_us = esp_timer_get_time() - t0;
+    if (out_lat_us) *out_lat_us = lat_us;
+    if (sret != ESP_OK) return sret;
+
+    if (c->first_uplink_pending) {
+        c->first_uplink_pending = false;
+        record_wake_uplink(c);
+    }
+    // 发送期间若 mic 已追上并覆盖在途数据（极端慢链路），记为丢弃
+    uint64_t seq_after = __atomic_load_n(&c->pre_seq_w, __ATOMIC_ACQUIRE);
+    if (c->catchup_open) {
+        c->catchup_open = false;
+        c->catchup_seq = seq_after;
+    }
+    if (seq_after > c->pre_cap && seq_after - c->pre_cap > c->send_seq_r) {
+        uint64_t torn = seq_after - c->pre_cap - c->send_seq_r;
+        if (torn > n) torn = n;
+        c->up.bytes_dropped += torn;
+        ESP_LOGW(TAG, "丢帧: 发送期间被覆盖 %" PRIu64 " bytes", torn);
+    }
+    c->send_seq_r += n;
+    if (!c->up.burst) c->up.tokens -= (int64_t)n;
+    uplink_pacer_on_sent(c, n, lat_us);
+    return ESP_OK;
+}
+
+// 说完（VAD 判停）：节流期攒着的不足一个 chunk 的尾巴在 end 之前补发完；发不出去的计入丢弃
+static void uplink_flush(chat_ctx_t *c)
+{
+    if (!c->ws || !app_rb3_ws_is_connected(c->ws)) return;
+    const uint64_t end = __atomic_load_n(&c->pre_seq_w, __ATOMIC_ACQUIRE);
+    const uint64_t min_seq = (end > c->pre_cap) ? (end - c->pre_cap) : 0;
+    if (c->send_seq_r < min_seq) {
+        c->up.bytes_dropped += min_seq - c->send_seq_r;
+        c->send_seq_r = min_seq;
+    }
+    c->up.burst = true;
+    while (c->send_seq_r < end) {
+        uint64_t left = end - c->send_seq_r;
+        size_t n = (left > (uint64_t)c->up.chunk) ? (size_t)c->up.chunk : (size_t)left;
+        if (uplink_send(c, n, NULL) != ESP_OK) {
+            c->up.bytes_dropped += end - c->send_seq_r;
+            ESP_LOGW(TAG, "丢帧: end 前补发失败 %" PRIu64 " bytes", end - c->send_seq_r);
+            c->send_seq_r = end;
+            break;
+        }
     }
-    return len;
+}
+
+static void record_ptt_end(chat_ctx_t *c)
+{
+    uint32_t ms = (uint32_t)((esp_timer_get_time() - c->ptt_up_us) / 1000);
+    task_chat_continue_latency_stats_t *l = &c->lat;
+    l->ptt_ends++;
+    l->ptt_end_ms_last = ms;
+    if (ms > l->ptt_end_ms_max) l->ptt_end_ms_max = ms;
+    c->ptt_end_sum_ms += ms;
+    l->ptt_end_ms_avg = (uint32_t)(c->ptt_end_sum_ms / l->ptt_ends);
+    ESP_LOGI(TAG, "松开->end: %" PRIu32 " ms（平均 %" PRIu32 "ms，最大 %" PRIu32 "ms）", ms, l->ptt_end_ms_avg,
+             l->ptt_end_ms_max);
 }
 
 static void on_speak_state_change(app_speak_state_t st, void *ctx)
 {
     chat_ctx_t *c = (chat_ctx_t *)ctx;
     if (!c || !c->q_evt) return;
-
-    // 关键：一旦开始说话，立即触发 abort，让 recv/play 能立刻被打断
-    if (st == APP_SPEAK_STATE_SPEAKING) {
-        // 播放期/播放中：忽略 SPEAK_ON（否则扬声器回灌会立刻再次唤醒）
-        if (is_playback_active(c)) {
+    c->vad_speaking = (st == APP_SPEAK_STATE_SPEAKING);
+
+    // 关键：一旦开始说话，立即触发 abort，让 recv/play 能立刻被打断。
+    // 这里在 mic 任务里：只改 token 并通知播放任务，清队列/停喇叭由 task_play 做，不卡 mic 读取
+    // 唤醒词 / 按键模式下开口不打断：打断与唤醒由唤醒词或按键触发（见 kws_on_wake / on_ptt_key）
+    if (st == APP_SPEAK_STATE_SPEAKING && !c->kws_on && !c->ptt_on) {
+        const bool playing = is_playback_active(c);
+        // 播放期/播放中：默认忽略 SPEAK_ON（否则扬声器回灌会立刻再次唤醒）
+        if (playing && !c->cfg.barge_in) {
             return;
         }
+        c->resp_end_ms = 0; // 用户又开口：不再为上一轮起垫音
+        if (playing) c->barge_t0_us = esp_timer_get_time();
         c->abort_token++;
-        flush_play_rb(c);
+        if (c->play_task) xTaskNotifyGive(c->play_task);
     }
 
     chat_evt_t ev = {
         .type = (st == APP_SPEAK_STATE_SPEAKING) ? CHAT_EVT_SPEAK_ON : CHAT_EVT_SPEAK_OFF,
         .tick = xTaskGetTickCount(),
+        .t_us = esp_timer_get_time(),
     };
     (void)xQueueSend(c->q_evt, &ev, 0);
 }
@@ -311,6 +829,181 @@ static void on_speak_audio_frame(const uint8_t *pcm, int pcm_len, void *ctx)
     if (!c || !pcm || pcm_len <= 0) return;
 
     prebuf_write(c, pcm, (size_t)pcm_len);
+    if (c->rb_kws && xRingbufferSend(c->rb_kws, pcm, (size_t)pcm_len, 0) != pdTRUE) {
+        c->lat.kws_drop_bytes += (uint32_t)pcm_len;
+    }
+}
+
+// 唤醒词触发：与能量模式开口相同的播放期门控/打断，再通知 task_net 进入唤醒期
+static void kws_on_wake(chat_ctx_t *c)
+{
+    if (c->phase == CHAT_PHASE_WAKE) return;
+    const bool playing = is_playback_active(c);
+    if (playing && !c->cfg.barge_in) return;
+    c->resp_end_ms = 0;
+    if (playing) c->barge_t0_us = esp_timer_get_time();
+    c->abort_token++;
+    if (c->play_task) xTaskNotifyGive(c->play_task);
+
+    chat_evt_t ev = {
+        .type = CHAT_EVT_WAKE,
+        .tick = xTaskGetTickCount(),
+        .t_us = esp_timer_get_time(),
+    };
+    (void)xQueueSend(c->q_evt, &ev, 0);
+}
+
+// 按键：GPIO 源在中断里调用，直接投递进状态机；按下是明确的用户意图，播放中也直接打断
+static void on_ptt_key(bool pressed, int64_t t_us, void *ctx)
+{
+    chat_ctx_t *c = (chat_ctx_t *)ctx;
+    const bool isr = xPortInIsrContext();
+    BaseType_t woken = pdFALSE;
+    if (pressed) {
+        if (is_playback_active(c)) c->barge_t0_us = t_us;
+        c->resp_end_ms = 0;
+        c->abort_token++;
+        if (c->play_task) {
+            if (isr) {
+                vTaskNotifyGiveFromISR(c->play_task, &woken);
+            } else {
+                xTaskNotifyGive(c->play_task);
+            }
+        }
+    }
+
+    chat_evt_t ev = {
+        .type = pressed ? CHAT_EVT_PTT_DOWN : CHAT_EVT_PTT_UP,
+        .tick = isr ? xTaskGetTickCountFromISR() : xTaskGetTickCount(),
+        .t_us = t_us,
+    };
+    if (isr) {
+        (void)xQueueSendFromISR(c->q_evt, &ev, &woken);
+        portYIELD_FROM_ISR(woken);
+    } else {
+        (void)xQueueSend(c->q_evt, &ev, 0);
+    }
+}
+
+static void task_kws(void *arg)
+{
+    chat_ctx_t *c = (chat_ctx_t *)arg;
+    while (1) {
+        size_t n = 0;
+        int16_t *x = (int16_t *)xRingbufferReceiveUpTo(c->rb_kws, &n, portMAX_DELAY, 1024);
+        if (!x) continue;
+        const bool hit = app_kws_feed(&c->kws, x, (int)(n / sizeof(int16_t)), NULL);
+        vRingbufferReturnItem(c->rb_kws, x);
+        if (hit) kws_on_wake(c);
+    }
+}
+
+// 唤醒后没开口（多为误唤醒）：取消本轮、回等待期，不等服务端回复
+static void chat_abandon_turn(chat_ctx_t *c)
+{
+    if (c->ws && !c->start_pending) (void)app_rb3_ws_send_cancel(c->ws);
+    c->start_pending = false;
+    c->off_pending = false;
+    c->ptt_end_pending = false;
+    c->phase = CHAT_PHASE_WAITING;
+    chat_ws_release(c, false);
+}
+
+// 说完：发 end，收回复直到 is_last，决定进入播放期还是回等待期；结束后归还连接
+static void chat_finish_turn(chat_ctx_t *c, abort_ctx_t *ab)
+{
+    if (c->ws && app_rb3_ws_is_connected(c->ws)) {
+        (void)app_rb3_ws_send_end(c->ws);
+        ESP_LOGI(TAG, "上传: end（保持WS连接）sent=%" PRIu64 " dropped=%" PRIu64
+                      " max_lag=%" PRIu32 "ms chunk=%d send_lat=%" PRIu32 "us",
+                 c->up.bytes_sent, c->up.bytes_dropped, c->up.max_lag_ms, c->up.chunk,
+                 c->up.send_lat_us);
+        if (c->up.turn_bytes > 0 && c->up.turn_send_us > 0) {
+            // 吞吐 = 本轮字节 / send 墙钟耗时；CPU = 本轮 task_net + tcpip 运行时间，折算到每上传 1s 音频
+            uint32_t net_us = 0, ip_us = 0;
+            uplink_cpu_sample(c, &net_us, &ip_us);
+            net_us -= c->up.turn_rt_net0;
+            ip_us -= c->up.turn_rt_ip0;
+            c->up.cpu_us += (uint64_t)net_us + ip_us;
+            const uint64_t bps = (c->up.turn_bytes * 1000000ULL) / c->up.turn_send_us;
+            const double audio_s = (double)c->up.turn_bytes / (double)c->bytes_per_sec;
+            ESP_LOGI(TAG, "上行基准: %" PRIu64 " bytes/s，每上传1s音频 CPU %.1f ms（task_net %.1f + tcpip %.1f）",
+                     bps, (net_us + (double)ip_us) / 1000.0 / audio_s, net_us / 1000.0 / audio_s,
+                     ip_us / 1000.0 / audio_s);
+        }
+
+        app_rb3_meta_t meta = {0};
+        bool got_audio = false;
+        int64_t end_us = esp_timer_get_time();
+        // 通知 task_play 开始计首包预算（0 保留为“不在等待”）
+        uint32_t end_ms = (uint32_t)(end_us / 1000);
+        c->resp_end_ms = end_ms ? end_ms : 1;
+        int64_t first_audio_us = 0;
+        dl_audio_ctx_t dl = {
+            .c = c,
+            .got_audio = &got_audio,
+            .first_audio_us = &first_audio_us,
+        };
+        update_rx_window(c);
+        esp_err_t rxret = app_rb3_ws_recv_until_last(c->ws, &meta, on_audio_push_rb_track, &dl,
+                                                     should_abort_ws, ab);
+        if (c->ws) {
+            app_rb3_ws_stats_t ws_st;
+            app_rb3_ws_get_stats(c->ws, &ws_st);
+            if (ws_st.rx_overflows > 0 || ws_st.rx_drops > 0) {
+                ESP_LOGW(TAG, "下行缓冲: overflows=%" PRIu32 " drops=%" PRIu32 " queued=%" PRIu32,
+                         ws_st.rx_overflows, ws_st.rx_drops, ws_st.rx_queued_bytes);
+            }
+        }
+        if (got_audio && first_audio_us > end_us) {
+            record_first_audio_latency(c, (uint32_t)((first_audio_us - end_us) / 1000));
+        }
+        if (!got_audio) {
+            c->resp_end_ms = 0; // 本轮没有回复音频：不再等待，也不再起垫音
+        }
+        c->last_turn_cancelled = (rxret == ESP_ERR_INVALID_STATE);
+        publish_reply_end(c);
+        if (rxret == ESP_ERR_INVALID_STATE) {
+            ESP_LOGI(TAG, "ws recv cancelled（已通知服务端 cancel）");
+        } else if (rxret == ESP_ERR_INVALID_SIZE) {
+            // 播放跟不上、下行积压超出窗口：本轮回复作废（已 cancel），连接本身没坏
+            ESP_LOGE(TAG, "ws reply overflowed the receive window, dropped（已通知服务端 cancel）");
+        } else if (rxret != ESP_OK) {
+            ESP_LOGE(TAG, "ws recv failed: %s", esp_err_to_name(rxret));
+            chat_ws_release(c, true);
+        } else {
+            ESP_LOGI(TAG, "resp text=%s anim=%s motion=%s af=%s", meta.text, meta.anim, meta.motion,
+                     meta.af[0] ? meta.af : "(none)");
+        }
+
+        // 根据是否有下行音频，决定进入播放期还是直接回等待期
+        if (got_audio || is_playback_active(c)) {
+            ESP_LOGI(TAG, "状态切换: 唤醒期 -> 播放期（等待下行播完再回等待期）");
+            c->phase = CHAT_PHASE_PLAYBACK;
+        } else {
+            ESP_LOGI(TAG, "状态切换: 唤醒期 -> 等待期（无下行音频）");
+            c->phase = CHAT_PHASE_WAITING;
+        }
+    } else {
+        ESP_LOGI(TAG, "状态切换: 唤醒期 -> 等待期（WS 未连接）");
+        c->phase = CHAT_PHASE_WAITING;
+    }
+
+    chat_ws_release(c, false);
+}
+
+// start：req 每轮唯一，服务端/解析层按 req 区分被 cancel 的旧回复
+static esp_err_t chat_send_start(chat_ctx_t *c, const app_rb3_cfg_t *rb3)
+{
+    esp_err_t ret = app_rb3_ws_send_start(c->ws, c->cur_req, rb3->af);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "ws send start failed: %s，换连接重试", esp_err_to_name(ret));
+        chat_ws_release(c, true);
+        app_rb3_connmgr_kick();
+        return ret;
+    }
+    c->start_pending = false;
+    return ESP_OK;
 }
 
 static void task_net(void *arg)
@@ -318,35 +1011,46 @@ static void task_net(void *arg)
     chat_ctx_t *c = (chat_ctx_t *)arg;
     ESP_ERROR_CHECK(nvs_flash_init());
     ESP_ERROR_CHECK(esp_netif_init());
+    c->net_task = xTaskGetCurrentTaskHandle();
+    c->tcpip_task = xTaskGetHandle("tiT");
     ESP_ERROR_CHECK(esp_event_loop_create_default());
     ESP_ERROR_CHECK(example_connect());
 
     app_rb3_cfg_t rb3 = app_rb3_cfg_default(c->cfg.base_url);
+    rb3.endpoints = c->cfg.endpoints;
+    rb3.endpoint_count = c->cfg.endpoint_count;
     // 关键：下行音频格式要和本机播放采样率一致；全链路改成 24k。
     rb3.af = "pcm_24k_16bit";
     rb3.mode = "stream";
     rb3.chunk_bytes = 500;
+    c->rx_window_base = (size_t)rb3.rx_window_bytes;
 
-    // 等待期默认保持 WS 连接（长连接）
+    // 等待期默认保持 WS 连接（长连接）：建连/心跳/退避重连都在连接管理器任务里，task_net 不再阻塞等待
     c->phase = CHAT_PHASE_WAITING;
     c->last_activity_tick = xTaskGetTickCount();
     ESP_LOGI(TAG, "状态切换: 启动 -> 等待期（保持WS连接，不上传；持续循环存音频）");
 
-    if (app_rb3_ws_open(&rb3, &c->ws) != ESP_OK) {
-        ESP_LOGW(TAG, "ws open failed, will retry on next wake");
-        c->ws = NULL;
-    }
+    app_rb3_connmgr_cfg_t cm = app_rb3_connmgr_cfg_default();
+    cm.hot_standby = c->cfg.ws_hot_standby;
+    cm.on_up = on_ws_up;
+    cm.on_down = on_ws_down;
+    cm.ctx = c;
+    ESP_ERROR_CHECK(app_rb3_connmgr_start(&rb3, &cm));
 
     const uint32_t idle_to_silent_ms = 60000;
-    const size_t max_backlog = c->bytes_per_sec * 3;  // 最多允许落后 3s
-    const size_t keep_backlog = c->bytes_per_sec * 1; // 追帧后保留 1s
-    const int send_chunk = 4096;                      // SRAM bounce buffer
-    uint8_t *txbuf = (uint8_t *)malloc(send_chunk);
-    if (!txbuf) {
-        ESP_LOGE(TAG, "alloc txbuf failed");
-        vTaskDelete(NULL);
-        return;
-    }
+    // 说话开始后等连接就绪的上限：超过则放弃本轮（音频一直在环形缓冲里，连上后从起点补发）
+    const uint32_t wake_connect_wait_ms = 8000;
+    // 坏链路才会触发：落后超过 uplink_max_lag_ms 则快进，只保留 1s（界定延迟）。
+    size_t max_backlog = (c->bytes_per_sec * (size_t)c->cfg.uplink_max_lag_ms) / 1000;
+    // 直接从环形缓冲发送（不再经 bounce buffer）：发送期间 mic 仍在写，
+    // 预留 1s + 一个 chunk 的余量，保证在途数据不会被覆盖
+    const size_t send_margin = c->bytes_per_sec + (size_t)c->cfg.uplink_max_chunk_bytes;
+    const size_t hist_backlog = (c->pre_cap > send_margin) ? (c->pre_cap - send_margin) : (c->pre_cap / 2);
+    if (max_backlog > hist_backlog) max_backlog = hist_backlog;
+    // 压缩历史只放宽连接前的追帧（唤醒后连接慢）：首个上行字节前按历史长度；
+    // 开始发送后只给那段旧积压放行，之后新增的落后仍按 uplink_max_lag_ms 快进
+    const size_t catchup_backlog = c->pre_adpcm ? hist_backlog : max_backlog;
+    const size_t keep_backlog = c->bytes_per_sec * 1;
 
     // 用于 WS 打断：token 变化即 abort
     uint32_t last_abort_seen = c->abort_token;
@@ -361,7 +1065,15 @@ static void task_net(void *arg)
         // 播放期：等下行音频播完再回到等待期
         if (c->phase == CHAT_PHASE_PLAYBACK) {
             if (!is_playback_active(c)) {
-                ESP_LOGI(TAG, "状态切换: 播放期 -> 等待期（下行播完）");
+                app_spk_out_stats_t os;
+                app_spk_stream_stats_t ts;
+                app_speak_sound_out_get_stats(&os);
+                app_speak_sound_stream_get_stats(APP_SPK_STREAM_TTS, &ts);
+                ESP_LOGI(TAG, "状态切换: 播放期 -> 等待期（下行播完）；混音器 已播=%" PRIu64 " 帧 write=%" PRIu32
+                              " 次（平均阻塞 %" PRIu32 "us）断流=%" PRIu32 " 打断丢块=%" PRIu32 " 负载=%.2f%%；TTS 延迟 %" PRIu32
+                              "ms（平均 %" PRIu32 "ms）",
+                         os.frames_played, os.writes, os.write_us_avg, os.underruns, os.blocks_dropped,
+                         (double)os.mix_load_pct, ts.latency_ms_last, ts.latency_ms_avg);
                 c->phase = CHAT_PHASE_WAITING;
                 c->last_activity_tick = xTaskGetTickCount();
             } else {
@@ -370,17 +1082,82 @@ static void task_net(void *arg)
             }
         }
 
+        // 唤醒期但连接还没就绪：每拍非阻塞地试一次，连上立即 start（发送指针仍指向说话起点）
+        if (c->phase == CHAT_PHASE_WAKE && c->start_pending) {
+            if (!c->ws) c->ws = app_rb3_connmgr_acquire(0);
+            if (c->ws) {
+                (void)chat_send_start(c, &rb3);
+            } else if ((uint32_t)((esp_timer_get_time() - c->start_wait_us) / 1000) > wake_connect_wait_ms) {
+                ESP_LOGE(TAG, "WS %u ms 内未就绪，放弃本轮", (unsigned)wake_connect_wait_ms);
+                c->start_pending = false;
+                c->off_pending = false;
+                c->ptt_end_pending = false;
+                c->phase = CHAT_PHASE_WAITING;
+                round_active = false;
+            }
+        }
+
+        // 松键后积压已发到松键时刻（或本轮已中断）：立即 end
+        if (c->phase == CHAT_PHASE_WAKE && c->ptt_end_pending && !c->start_pending &&
+            (!c->ws || !round_active || c->send_seq_r >= c->ptt_end_seq)) {
+            c->ptt_end_pending = false;
+            if (c->ws) record_ptt_end(c);
+            chat_finish_turn(c, &ab);
+            round_active = false;
+        }
+
+        // 唤醒词触发后 wake_listen_ms 内没开口：放弃本轮
+        if (c->phase == CHAT_PHASE_WAKE && c->wake_listen_us != 0 && esp_timer_get_time() > c->wake_listen_us) {
+            c->wake_listen_us = 0;
+            if (!c->vad_speaking) {
+                c->lat.kws_no_speech++;
+                ESP_LOGI(TAG, "状态切换: 唤醒期 -> 等待期（唤醒后 %d ms 未开口）", c->cfg.wake_listen_ms);
+                chat_abandon_turn(c);
+                round_active = false;
+            }
+        }
+
+        // 说完时 start 还没发出：等连上并把积压补发完再结束本轮
+        if (c->phase == CHAT_PHASE_WAKE && c->off_pending && !c->start_pending) {
+            uint64_t seq_w = __atomic_load_n(&c->pre_seq_w, __ATOMIC_ACQUIRE);
+            uint64_t backlog = (seq_w > c->send_seq_r) ? (seq_w - c->send_seq_r) : 0;
+            if (!c->ws || backlog < (uint64_t)c->up.chunk) {
+                c->off_pending = false;
+                uplink_flush(c);
+                chat_finish_turn(c, &ab);
+                round_active = false;
+            }
+        }
+
         // 处理状态事件（非阻塞）
         chat_evt_t ev = {0};
         while (xQueueReceive(c->q_evt, &ev, 0) == pdTRUE) {
             uint32_t tnow = xTaskGetTickCount();
             c->last_activity_tick = tnow;
 
-            if (ev.type == CHAT_EVT_SPEAK_ON) {
-                // 播放期：不允许再次唤醒（抑制回声触发唤醒）
-                if (c->phase == CHAT_PHASE_PLAYBACK) {
+            if (ev.type == CHAT_EVT_SPEAK_ON && (c->kws_on || c->ptt_on)) {
+                // 唤醒词 / 按键模式：开口只说明唤醒后已开始说话，不开启新一轮
+                c->wake_listen_us = 0;
+                continue;
+            }
+            if (ev.type == CHAT_EVT_WAKE && c->phase == CHAT_PHASE_WAKE) {
+                continue;
+            }
+            if (ev.type == CHAT_EVT_PTT_DOWN && c->phase == CHAT_PHASE_WAKE) {
+                // 上一轮还没结束又按下：取消上一轮，从这次按下重新开始
+                ESP_LOGI(TAG, "按键: 上一轮未结束，取消后重新开始");
+                chat_abandon_turn(c);
+                round_active = false;
+            }
+            if (ev.type == CHAT_EVT_SPEAK_ON || ev.type == CHAT_EVT_WAKE || ev.type == CHAT_EVT_PTT_DOWN) {
+                // 播放期：不允许再次唤醒（抑制回声触发唤醒）；打开 barge_in 时开口即打断进入唤醒期。
+                // 按键不受限：按下即打断
+                if (c->phase == CHAT_PHASE_PLAYBACK && !c->cfg.barge_in && ev.type != CHAT_EVT_PTT_DOWN) {
                     continue;
                 }
+                if (c->phase == CHAT_PHASE_PLAYBACK) {
+                    ESP_LOGI(TAG, "状态切换: 播放期 -> 唤醒期（打断）");
+                }
                 if (c->phase == CHAT_PHASE_WAITING) {
                     ESP_LOGI(TAG, "状态切换: 等待期 -> 唤醒期");
                 } else if (c->phase == CHAT_PHASE_SILENT) {
@@ -389,90 +1166,83 @@ static void task_net(void *arg)
                 c->phase = CHAT_PHASE_WAKE;
                 round_active = true;
                 last_abort_seen = c->abort_token;
-
-                // 确保 WS 已连接
-                if (!c->ws || !app_rb3_ws_is_connected(c->ws)) {
-                    if (c->ws) app_rb3_ws_close(c->ws);
-                    c->ws = NULL;
-                    if (app_rb3_ws_open(&rb3, &c->ws) != ESP_OK) {
-                        ESP_LOGE(TAG, "ws open failed");
-                        c->phase = CHAT_PHASE_WAITING;
-                        round_active = false;
-                        break;
-                    }
+                c->turn_ptt = (ev.type == CHAT_EVT_PTT_DOWN);
+                c->ptt_end_pending = false;
+                // 按键从按下（中断里的时刻）开始计延迟
+                c->wake_us = c->turn_ptt ? ev.t_us : esp_timer_get_time();
+                c->first_uplink_pending = true;
+                c->off_pending = false;
+                c->wake_listen_us = 0;
+                if (ev.type == CHAT_EVT_WAKE) {
+                    // preroll 1.5s 覆盖唤醒词本身；之后等用户开口，能量 VAD 判说完
+                    c->lat.kws_wakes++;
+                    if (!c->vad_speaking) c->wake_listen_us = c->wake_us + (int64_t)c->cfg.wake_listen_ms * 1000;
                 }
 
-                // start
-                if (app_rb3_ws_send_start(c->ws, "r_chat", rb3.af) != ESP_OK) {
-                    ESP_LOGE(TAG, "ws send start failed");
-                    app_rb3_ws_close(c->ws);
-                    c->ws = NULL;
-                    c->phase = CHAT_PHASE_WAITING;
-                    round_active = false;
-                    break;
-                }
+                c->turn_id++;
+                snprintf(c->cur_req, sizeof(c->cur_req), "r_chat_%" PRIu32, c->turn_id);
 
-                // 设置发送指针：从“当前时刻前 1.5s”开始，然后追到实时
+                // 设置发送指针：从“当前时刻前 1.5s”开始（按键：按下时刻前 ptt_preroll_ms），然后追到实时
                 uint64_t seq_w = __atomic_load_n(&c->pre_seq_w, __ATOMIC_ACQUIRE);
                 uint64_t min_seq = (seq_w > c->pre_cap) ? (seq_w - c->pre_cap) : 0;
-                uint64_t target = (seq_w > c->pre_preroll_bytes) ? (seq_w - c->pre_preroll_bytes) : 0;
+                size_t preroll = c->pre_preroll_bytes;
+                if (c->turn_ptt) {
+                    preroll = app_ptt_preroll_bytes(c->ptt_preroll_bytes, esp_timer_get_time() - ev.t_us,
+                                                    c->bytes_per_sec);
+                }
+                uint64_t target = (seq_w > preroll) ? (seq_w - preroll) : 0;
                 if (target < min_seq) {
                     uint64_t lost = min_seq - target;
                     target = min_seq;
                     ESP_LOGW(TAG, "preroll 不足：被覆盖 %" PRIu64 " bytes，改为发送可用窗口", lost);
                 }
                 c->send_seq_r = target;
-                ESP_LOGI(TAG, "上传: start -> preroll -> realtime, preroll_bytes=%" PRIu64,
-                         (seq_w >= target) ? (seq_w - target) : 0);
+                c->turn_seq0 = target;
+                c->turn_failovers = 0;
+                c->catchup_open = true;
+                c->catchup_seq = 0;
+                c->start_wait_us = c->wake_us;
+                uplink_pacer_reset(c);
+
+                // 借用连接（不等待）：没就绪就让连接管理器立即重连，本轮 start 延后发
+                if (c->ws && !app_rb3_ws_is_connected(c->ws)) chat_ws_release(c, true);
+                if (!c->ws) c->ws = app_rb3_connmgr_acquire(0);
+                c->start_pending = true;
+                if (!c->ws) {
+                    c->lat.wake_not_ready++;
+                    ESP_LOGW(TAG, "WS 未就绪：后台重连中，音频继续缓存");
+                } else {
+                    (void)chat_send_start(c, &rb3);
+                }
+                ESP_LOGI(TAG, "上传: start -> preroll(突发) -> realtime(节流), preroll_bytes=%" PRIu64 " chunk=%d",
+                         (seq_w >= target) ? (seq_w - target) : 0, c->up.chunk);
+            } else if (ev.type == CHAT_EVT_PTT_UP) {
+                if (c->phase == CHAT_PHASE_WAKE && c->turn_ptt && !c->ptt_end_pending) {
+                    // 松键：音频只发到松键时刻（不等尾部静音），发完立即 end
+                    const uint64_t seq_w = __atomic_load_n(&c->pre_seq_w, __ATOMIC_ACQUIRE);
+                    c->ptt_end_pending = true;
+                    c->ptt_up_us = ev.t_us;
+                    c->ptt_end_seq = app_ptt_release_seq(seq_w, c->send_seq_r, esp_timer_get_time() - ev.t_us,
+                                                         c->bytes_per_sec);
+                }
             } else if (ev.type == CHAT_EVT_SPEAK_OFF) {
-                if (c->phase == CHAT_PHASE_WAKE) {
+                if (c->phase == CHAT_PHASE_WAKE && !c->turn_ptt) {
                     // 注意：这里不立刻切回等待期。
                     // 若服务端有下行音频，则进入“播放期”，等播完再切回等待期（避免回声再次唤醒）。
-                    if (c->ws && app_rb3_ws_is_connected(c->ws)) {
-                        (void)app_rb3_ws_send_end(c->ws);
-                        ESP_LOGI(TAG, "上传: end（保持WS连接）");
-
-                        app_rb3_meta_t meta = {0};
-                        bool got_audio = false;
-                        dl_audio_ctx_t dl = {
-                            .c = c,
-                            .got_audio = &got_audio,
-                        };
-                        esp_err_t rxret = app_rb3_ws_recv_until_last(c->ws, &meta, on_audio_push_rb_track, &dl,
-                                                                     should_abort_ws, &ab);
-                        if (rxret == ESP_ERR_INVALID_STATE) {
-                            ESP_LOGI(TAG, "ws recv cancelled");
-                        } else if (rxret != ESP_OK) {
-                            ESP_LOGE(TAG, "ws recv failed: %s", esp_err_to_name(rxret));
-                            if (c->ws) {
-                                app_rb3_ws_close(c->ws);
-                                c->ws = NULL;
-                            }
-                        } else {
-                            ESP_LOGI(TAG, "resp text=%s anim=%s motion=%s af=%s", meta.text, meta.anim, meta.motion,
-                                     meta.af[0] ? meta.af : "(none)");
-                        }
-
-                        // 根据是否有下行音频，决定进入播放期还是直接回等待期
-                        if (got_audio || is_playback_active(c)) {
-                            ESP_LOGI(TAG, "状态切换: 唤醒期 -> 播放期（等待下行播完再回等待期）");
-                            c->phase = CHAT_PHASE_PLAYBACK;
-                        } else {
-                            ESP_LOGI(TAG, "状态切换: 唤醒期 -> 等待期（无下行音频）");
-                            c->phase = CHAT_PHASE_WAITING;
-                        }
-                    } else {
-                        ESP_LOGI(TAG, "状态切换: 唤醒期 -> 等待期（WS 未连接）");
-                        c->phase = CHAT_PHASE_WAITING;
+                    if (c->start_pending) {
+                        c->off_pending = true;
+                        continue;
                     }
-
+                    uplink_flush(c);
+                    chat_finish_turn(c, &ab);
                     round_active = false;
                 }
             }
         }
 
-        // 唤醒期：从 PSRAM 环形缓冲按 r_send 发送到 WS（带追帧/丢帧）
-        if (c->phase == CHAT_PHASE_WAKE && round_active && c->ws && app_rb3_ws_is_connected(c->ws)) {
+        // 唤醒期：从 PSRAM 环形缓冲按 r_send 发送到 WS（preroll 突发 + token bucket 节流）
+        if (c->phase == CHAT_PHASE_WAKE && round_active && !c->start_pending && c->ws &&
+            app_rb3_ws_is_connected(c->ws)) {
             if (should_abort_ws(&ab)) {
                 round_active = false;
                 continue;
@@ -483,15 +1253,25 @@ static void task_net(void *arg)
             if (c->send_seq_r < min_seq) {
                 uint64_t drop = min_seq - c->send_seq_r;
                 c->send_seq_r = min_seq;
+                c->up.bytes_dropped += drop;
                 ESP_LOGW(TAG, "丢帧: 超出缓存窗口，跳过 %" PRIu64 " bytes", drop);
             }
 
             uint64_t backlog64 = (seq_w >= c->send_seq_r) ? (seq_w - c->send_seq_r) : 0;
             size_t backlog = (backlog64 > (uint64_t)SIZE_MAX) ? SIZE_MAX : (size_t)backlog64;
-
-            if (backlog > max_backlog) {
+            uplink_pacer_track_lag(c, backlog);
+
+            size_t lag_limit = max_backlog;
+            if (c->catchup_open) {
+                lag_limit = catchup_backlog;
+            } else if (c->catchup_seq > c->send_seq_r) {
+                uint64_t debt = c->catchup_seq - c->send_seq_r;
+                lag_limit = (debt >= catchup_backlog - max_backlog) ? catchup_backlog : max_backlog + (size_t)debt;
+            }
+            if (backlog > lag_limit) {
                 size_t drop = backlog - keep_backlog;
                 c->send_seq_r += drop;
+                c->up.bytes_dropped += drop;
                 uint32_t now = xTaskGetTickCount();
                 if (now - c->last_catchup_log_tick > pdMS_TO_TICKS(1000)) {
                     c->last_catchup_log_tick = now;
@@ -501,28 +1281,68 @@ static void task_net(void *arg)
                 backlog = keep_backlog;
             }
 
-            // 轻度节流：每轮最多发送 1~3 个 chunk
-            int chunks = 1;
-            if (backlog > c->bytes_per_sec) chunks = 3;
-            else if (backlog > (c->bytes_per_sec / 2)) chunks = 2;
-
-            for (int i = 0; i < chunks; ++i) {
-                seq_w = __atomic_load_n(&c->pre_seq_w, __ATOMIC_ACQUIRE);
-                if (c->send_seq_r >= seq_w) break;
-                size_t n = (size_t)(seq_w - c->send_seq_r);
-                if (n > (size_t)send_chunk) n = (size_t)send_chunk;
-                prebuf_copy(c, c->send_seq_r, txbuf, n);
-                esp_err_t sret = app_rb3_ws_send_bin(c->ws, txbuf, n, 2000);
+            // 突发阶段不受 token 限制；积压回落到最小 chunk 以内转入节流
+            // （按自适应 chunk 判断的话，chunk 长到比按键 preroll 还大时整段 preroll 要等 token 攒够才发）。
+            // 节流期间若因链路抖动重新积压超过 0.5s，再次突发追赶。
+            // 松键后：只补发到松键时刻，一直突发；发完回到循环开头 end
+            if (c->ptt_end_pending) {
+                backlog = (c->ptt_end_seq > c->send_seq_r) ? (size_t)(c->ptt_end_seq - c->send_seq_r) : 0;
+                c->up.burst = true;
+                if (backlog == 0) continue;
+            } else if (c->up.burst && backlog < (size_t)c->cfg.uplink_min_chunk_bytes) {
+                c->up.burst = false;
+                c->up.tokens = 0;
+                c->up.last_refill_us = esp_timer_get_time();
+            } else if (!c->up.burst && backlog > c->bytes_per_sec / 2) {
+                c->up.burst = true;
+            }
+
+            size_t n = backlog;
+            if (n > (size_t)c->up.chunk) n = (size_t)c->up.chunk;
+            bool can_send = false;
+            if (c->up.burst) {
+                can_send = (n > 0);
+            } else {
+                // 攒够最小 chunk 且有 token 就发，不等满一个自适应 chunk（最大 16KB 约 340ms）
+                uplink_pacer_refill(c);
+                can_send = (n >= (size_t)c->cfg.uplink_min_chunk_bytes) && (c->up.tokens >= (int64_t)n);
+            }
+
+            if (can_send) {
+                int64_t lat_us = 0;
+                esp_err_t sret = uplink_send(c, n, &lat_us);
                 if (sret != ESP_OK) {
+                    chat_ws_release(c, true);
+                    // 中途断线：本轮起点还在环形缓冲里就换连接（连接管理器会挑另一个端点）整轮重发
+                    uint64_t seq_w = __atomic_load_n(&c->pre_seq_w, __ATOMIC_ACQUIRE);
+                    if (c->turn_failovers < 2 && seq_w - c->turn_seq0 + send_margin <= c->pre_cap) {
+                        ESP_LOGW(TAG, "send failed: %s，换连接后从本轮起点重发", esp_err_to_name(sret));
+                        c->turn_failovers++;
+                        c->lat.turn_failovers++;
+                        c->send_seq_r = c->turn_seq0;
+                        c->catchup_open = true;
+                        c->catchup_seq = 0;
+                        uplink_pacer_reset(c);
+                        c->start_pending = true;
+                        c->start_wait_us = esp_timer_get_time();
+                        app_rb3_connmgr_kick();
+                        continue;
+                    }
                     ESP_LOGW(TAG, "send failed: %s, back to WAITING and reconnect later", esp_err_to_name(sret));
-                    app_rb3_ws_close(c->ws);
-                    c->ws = NULL;
                     c->phase = CHAT_PHASE_WAITING;
                     round_active = false;
-                    break;
+                    continue;
                 }
-                c->send_seq_r += n;
-                vTaskDelay(1);
+            } else {
+                // 等攒够最小 chunk 或 token（最多 20ms，保证状态事件及时处理）
+                const size_t want = (size_t)c->cfg.uplink_min_chunk_bytes;
+                size_t need = (backlog < want) ? (want - backlog) : 0;
+                const int64_t short_tokens = (int64_t)(n > want ? n : want) - c->up.tokens;
+                if (short_tokens > 0 && (size_t)short_tokens * 4 / 5 > need) need = (size_t)short_tokens * 4 / 5;
+                uint32_t wait_ms = (c->bytes_per_sec > 0) ? (uint32_t)((need * 1000) / c->bytes_per_sec) : 20;
+                if (wait_ms > 20) wait_ms = 20;
+                TickType_t ticks = pdMS_TO_TICKS(wait_ms);
+                vTaskDelay(ticks > 0 ? ticks : 1);
             }
         } else {
             // 非唤醒态：检查等待期是否进入静默
@@ -532,10 +1352,8 @@ static void task_net(void *arg)
                 if (elapsed_ms >= idle_to_silent_ms) {
                     c->phase = CHAT_PHASE_SILENT;
                     ESP_LOGI(TAG, "状态切换: 等待期 -> 静默期（空闲>=60s，关闭WS）");
-                    if (c->ws) {
-                        app_rb3_ws_close(c->ws);
-                        c->ws = NULL;
-                    }
+                    chat_ws_release(c, false);
+                    app_rb3_connmgr_set_paused(true);
                 }
             }
             vTaskDelay(pdMS_TO_TICKS(20));
@@ -557,6 +1375,22 @@ static task_chat_continue_cfg_t cfg_default(void)
         .th_min = 200.0f,
         .spk_chunk_bytes = 512,
         .max_record_ms = 15000,
+        .uplink_min_chunk_bytes = 2048,
+        .uplink_max_chunk_bytes = 16384,
+        .uplink_target_send_ms = 40,
+        .uplink_max_lag_ms = 4000,
+        .first_audio_budget_ms = 1200,
+        .filler_xfade_ms = 60,
+        .preroll_history_ms = 5000,
+        .preroll_adpcm = false,
+        .barge_in = false,
+        .barge_fade_ms = 8,
+        .ws_hot_standby = false,
+        .wake_word = CHAT_WAKE_WORD_DEFAULT,
+        .wake_listen_ms = 5000,
+        .push_to_talk = CHAT_PTT_DEFAULT,
+        .ptt_gpio = 0,
+        .ptt_preroll_ms = 300,
     };
     return c;
 }
@@ -567,6 +1401,18 @@ esp_err_t task_chat_continue_start(const task_chat_continue_cfg_t *cfg)
     ESP_RETURN_ON_FALSE(c, ESP_ERR_NO_MEM, TAG, "alloc ctx failed");
 
     c->cfg = cfg ? *cfg : cfg_default();
+    if (c->cfg.uplink_min_chunk_bytes <= 0) c->cfg.uplink_min_chunk_bytes = 2048;
+    if (c->cfg.uplink_max_chunk_bytes < c->cfg.uplink_min_chunk_bytes) {
+        c->cfg.uplink_max_chunk_bytes = (c->cfg.uplink_min_chunk_bytes > 16384) ? c->cfg.uplink_min_chunk_bytes : 16384;
+    }
+    if (c->cfg.uplink_target_send_ms <= 0) c->cfg.uplink_target_send_ms = 40;
+    if (c->cfg.uplink_max_lag_ms <= 0) c->cfg.uplink_max_lag_ms = 4000;
+    if (c->cfg.first_audio_budget_ms == 0) c->cfg.first_audio_budget_ms = 1200;
+    if (c->cfg.filler_xfade_ms <= 0) c->cfg.filler_xfade_ms = 60;
+    if (c->cfg.barge_fade_ms <= 0) c->cfg.barge_fade_ms = 8;
+    if (c->cfg.preroll_history_ms <= 0) c->cfg.preroll_history_ms = 5000;
+    if (c->cfg.wake_listen_ms <= 0) c->cfg.wake_listen_ms = 5000;
+    if (c->cfg.ptt_preroll_ms <= 0) c->cfg.ptt_preroll_ms = 300;
     app_speak_sound_get_cfg(&c->audio_cfg);
 
     c->q_evt = xQueueCreate(8, sizeof(chat_evt_t));
@@ -579,20 +1425,33 @@ esp_err_t task_chat_continue_start(const task_chat_continue_cfg_t *cfg)
     ESP_RETURN_ON_FALSE(c->rb_play, ESP_ERR_NO_MEM, TAG, "create rb_play failed");
 
     // 统一：PSRAM 环形缓冲始终循环存麦克风 PCM
+    // SpeakState 已按采集格式转成单声道 s16，与 mic 的声道数/位宽无关
     const int sr = (c->audio_cfg.sample_rate > 0) ? c->audio_cfg.sample_rate : 16000;
-    const int ch = (c->audio_cfg.channels > 0) ? c->audio_cfg.channels : 1;
-    const int bps = (c->audio_cfg.bits_per_sample > 0) ? c->audio_cfg.bits_per_sample : 16;
+    const int ch = 1;
+    const int bps = 16;
     const int bytes_per_sample = bps / 8;
     const size_t bytes_per_sec = (size_t)sr * (size_t)ch * (size_t)bytes_per_sample;
     c->bytes_per_sec = bytes_per_sec;
-    c->pre_cap = bytes_per_sec * 5; // 5s 历史缓存
+    size_t hist_bytes = (bytes_per_sec * (size_t)c->cfg.preroll_history_ms) / 1000;
+    size_t store_bytes = hist_bytes;
+    c->pre_adpcm = c->cfg.preroll_adpcm;
+    if (c->pre_adpcm) {
+        c->pre_blocks = (hist_bytes + APP_ADPCM_BLOCK_PCM_BYTES - 1) / APP_ADPCM_BLOCK_PCM_BYTES;
+        hist_bytes = c->pre_blocks * APP_ADPCM_BLOCK_PCM_BYTES;
+        store_bytes = c->pre_blocks * APP_ADPCM_BLOCK_BYTES;
+        c->txbuf = (uint8_t *)malloc((size_t)c->cfg.uplink_max_chunk_bytes);
+        ESP_RETURN_ON_FALSE(c->txbuf, ESP_ERR_NO_MEM, TAG, "alloc txbuf failed");
+    }
+    c->pre_cap = hist_bytes;
     c->pre_preroll_bytes = (bytes_per_sec * 1500) / 1000; // 1.5s
-    c->pre_rb = (uint8_t *)heap_caps_malloc(c->pre_cap, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    c->pre_rb = (uint8_t *)heap_caps_malloc(store_bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
     if (!c->pre_rb) {
-        ESP_LOGW(TAG, "PSRAM alloc prebuf failed, fallback to internal heap (%u bytes)", (unsigned)c->pre_cap);
-        c->pre_rb = (uint8_t *)malloc(c->pre_cap);
+        ESP_LOGW(TAG, "PSRAM alloc prebuf failed, fallback to internal heap (%u bytes)", (unsigned)store_bytes);
+        c->pre_rb = (uint8_t *)malloc(store_bytes);
     }
     ESP_RETURN_ON_FALSE(c->pre_rb, ESP_ERR_NO_MEM, TAG, "alloc prebuf failed");
+    ESP_LOGI(TAG, "mic history: %d ms, %s, %u bytes", c->cfg.preroll_history_ms, c->pre_adpcm ? "ADPCM" : "PCM",
+             (unsigned)store_bytes);
     c->phase = CHAT_PHASE_WAITING;
     c->pre_seq_w = 0;
     c->send_seq_r = 0;
@@ -601,10 +1460,42 @@ esp_err_t task_chat_continue_start(const task_chat_continue_cfg_t *cfg)
     // 播放预缓冲：默认至少 0.5s 才开始播（降低首句延迟）
     c->play_prefill_bytes = (uint32_t)(bytes_per_sec / 2);
     c->play_bytes_in = 0;
-    // 播放背压水位：放宽一点，减少“灌入被频繁暂停”造成的断续
-    // 高水位 8s、低水位 4s（16k/16bit/mono 下约 256KB / 128KB）
-    c->play_high_wm_bytes = (uint32_t)(bytes_per_sec * 8);
-    c->play_low_wm_bytes = (uint32_t)(bytes_per_sec * 4);
+
+    // 唤醒词：模型在资源包里；加载失败退回能量触发
+    if (c->cfg.wake_word) {
+        app_asset_t m;
+        esp_err_t err = app_asset_pack_ready() ? app_asset_get(APP_ASSET_ID_KWS_MODEL, &m) : ESP_ERR_NOT_FOUND;
+        if (err == ESP_OK) {
+            app_kws_cfg_t kc = app_kws_cfg_default(sr);
+            kc.model = m.data;
+            kc.model_len = m.len;
+            err = app_kws_init(&c->kws, &kc);
+        }
+        if (err == ESP_OK) {
+            // 250ms 余量：推理偶尔超过一个采集帧时不丢音频
+            c->rb_kws = xRingbufferCreate((bytes_per_sec / 4 + 3) & ~(size_t)3, RINGBUF_TYPE_BYTEBUF);
+            ESP_RETURN_ON_FALSE(c->rb_kws, ESP_ERR_NO_MEM, TAG, "create rb_kws failed");
+            c->kws_on = true;
+        } else {
+            ESP_LOGW(TAG, "wake word unavailable (%s), fall back to energy trigger", esp_err_to_name(err));
+        }
+    }
+
+    // 按键说话：ptt_gpio < 0 用模拟按键（定时按下 / 松开），不接按键也能量延迟
+    c->ptt_preroll_bytes = ((bytes_per_sec * (size_t)c->cfg.ptt_preroll_ms) / 1000) & ~(size_t)1;
+    if (c->cfg.push_to_talk) {
+        app_ptt_cfg_t pc = app_ptt_cfg_default();
+        pc.src = (c->cfg.ptt_gpio >= 0) ? APP_PTT_SRC_GPIO : APP_PTT_SRC_SIM;
+        if (c->cfg.ptt_gpio >= 0) pc.gpio = c->cfg.ptt_gpio;
+        pc.cb = on_ptt_key;
+        pc.ctx = c;
+        esp_err_t err = app_ptt_init(&c->ptt, &pc);
+        if (err == ESP_OK) {
+            c->ptt_on = true;
+        } else {
+            ESP_LOGW(TAG, "push-to-talk unavailable (%s), fall back to energy trigger", esp_err_to_name(err));
+        }
+    }
 
     // 启动 SpeakState：由它独占 mic_read；Continue 通过回调拿到音频帧与说话状态
     app_speak_state_cfg_t scfg = app_speak_state_cfg_default();
@@ -616,13 +1507,71 @@ esp_err_t task_chat_continue_start(const task_chat_continue_cfg_t *cfg)
     scfg.log_state_change = false; // 由 Continue 统一打印“静默/等待/唤醒”
     scfg.on_audio = on_speak_audio_frame;
     scfg.on_audio_ctx = c;
+    scfg.beamform = c->cfg.mic_beamform;
+    scfg.noise_suppress = c->cfg.mic_noise_suppress;
+    scfg.agc = c->cfg.mic_agc;
+    scfg.agc_coarse = c->cfg.mic_agc_coarse;
     ESP_RETURN_ON_ERROR(app_speak_state_start(&scfg, on_speak_state_change, c), TAG, "start speak state failed");
 
-    BaseType_t ok1 = xTaskCreate(task_play, "task_chat_play", 4096, c, 6, NULL);
+    // 垫音的淡出时长即 FILLER 流的增益过渡时长（TTS 流活跃时压到静音）
+    app_spk_out_cfg_t ocfg = app_speak_sound_out_cfg_default();
+    ocfg.streams[APP_SPK_STREAM_FILLER].ramp_ms = c->cfg.filler_xfade_ms;
+    ESP_RETURN_ON_ERROR(app_speak_sound_out_start(&ocfg), TAG, "start spk mixer failed");
+    BaseType_t ok1 = xTaskCreate(task_play, "task_chat_play", 4096, c, 6, &c->play_task);
     BaseType_t ok2 = xTaskCreate(task_net, "task_chat_state", 6144, c, 5, NULL);
     ESP_RETURN_ON_FALSE(ok1 == pdPASS && ok2 == pdPASS, ESP_FAIL, TAG, "create task failed");
+    if (c->kws_on) {
+        // 比 mic/播放/网络任务低：推理偶尔慢一拍由 rb_kws 缓冲
+        BaseType_t ok3 = xTaskCreate(task_kws, "task_chat_kws", 4096, c, 4, NULL);
+        ESP_RETURN_ON_FALSE(ok3 == pdPASS, ESP_FAIL, TAG, "create kws task failed");
+    }
+
+    s_chat = c;
+    ESP_LOGI(TAG, "Task_Chat_Continue started, base_url=%s endpoints=%d trigger=%s",
+             c->cfg.base_url ? c->cfg.base_url : "(null)", c->cfg.endpoint_count,
+             c->ptt_on ? (c->kws_on ? "key + wake word" : "key") : (c->kws_on ? "wake word" : "energy"));
+    return ESP_OK;
+}
+
+esp_err_t task_chat_continue_get_uplink_stats(task_chat_continue_uplink_stats_t *out)
+{
+    ESP_RETURN_ON_FALSE(out, ESP_ERR_INVALID_ARG, TAG, "out is NULL");
+    chat_ctx_t *c = s_chat;
+    ESP_RETURN_ON_FALSE(c, ESP_ERR_INVALID_STATE, TAG, "not started");
+    // 统计字段由 task_net 单写，这里 best-effort 读取
+    out->bytes_sent = c->up.bytes_sent;
+    out->bytes_dropped = c->up.bytes_dropped;
+    out->lag_ms = c->up.lag_ms;
+    out->max_lag_ms = c->up.max_lag_ms;
+    out->chunk_bytes = (uint32_t)c->up.chunk;
+    out->send_lat_us = c->up.send_lat_us;
+    out->send_time_us = c->up.send_time_us;
+    out->cpu_us = c->up.cpu_us;
+    return ESP_OK;
+}
 
-    ESP_LOGI(TAG, "Task_Chat_Continue started, base_url=%s", c->cfg.base_url ? c->cfg.base_url : "(null)");
+esp_err_t task_chat_continue_get_latency_stats(task_chat_continue_latency_stats_t *out)
+{
+    ESP_RETURN_ON_FALSE(out, ESP_ERR_INVALID_ARG, TAG, "out is NULL");
+    chat_ctx_t *c = s_chat;
+    ESP_RETURN_ON_FALSE(c, ESP_ERR_INVALID_STATE, TAG, "not started");
+    *out = c->lat;
+    return ESP_OK;
+}
+
+esp_err_t task_chat_continue_get_kws_stats(app_kws_stats_t *out)
+{
+    ESP_RETURN_ON_FALSE(out, ESP_ERR_INVALID_ARG, TAG, "out is NULL");
+    chat_ctx_t *c = s_chat;
+    ESP_RETURN_ON_FALSE(c && c->kws_on, ESP_ERR_INVALID_STATE, TAG, "wake word not running");
+    app_kws_get_stats(&c->kws, out);
     return ESP_OK;
 }
 
+esp_err_t task_chat_continue_ptt_inject(bool pressed)
+{
+    chat_ctx_t *c = s_chat;
+    ESP_RETURN_ON_FALSE(c && c->ptt_on, ESP_ERR_INVALID_STATE, TAG, "push-to-talk not running");
+    app_ptt_inject(&c->ptt, pressed);
+    return ESP_OK;
+}
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "esp_err.h"
 
+#include "App_Kws.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -9,6 +14,9 @@ extern "C" {
 typedef struct {
     // 例如："http://192.168.31.193:8443"
     const char *base_url;
+    // 多服务端（可选）：按 RTT/错误率选最优，断线换端点；非空时优先于 base_url
+    const char *const *endpoints;
+    int endpoint_count;
     const char *user_id;
     const char *language;   // "zh-CN"
 
@@ -23,14 +31,124 @@ typedef struct {
     float th_min;           // 默认 200.0（平均绝对值门限下限）
 
     // 播放
-    int spk_chunk_bytes;    // 默认 512（越小越容易打断）
+    int spk_chunk_bytes;    // 垫音每次送入混音器的字节数，默认 512（回复按整项送入，打断由混音器清空）
 
     // 录音最大缓存（避免异常长句打爆内存）
     int max_record_ms;      // 默认 15000ms
+
+    // 上行节流（token bucket + 自适应 chunk；<=0 用默认值）
+    int uplink_min_chunk_bytes; // 默认 2048
+    int uplink_max_chunk_bytes; // 默认 16384
+    int uplink_target_send_ms;  // 默认 40ms：单次 send 超过则缩小 chunk
+    int uplink_max_lag_ms;      // 默认 4000ms：落后实时超过该值才快进丢弃（preroll_adpcm 时首个上行字节前的积压按历史长度）
+
+    // 垫音（掩盖首包延迟）：说完后超过该时间仍无可播音频，则播资源包里的垫音，回复到达后交叉淡入
+    int first_audio_budget_ms;  // 默认 1200ms；<0 关闭垫音
+    int filler_xfade_ms;        // 默认 60ms：回复开始后垫音在混音器里淡出的时长
+
+    // 麦克风历史环形缓冲（preroll/追帧窗口）
+    int preroll_history_ms;     // 默认 5000ms
+    bool preroll_adpcm;         // true：按 IMA ADPCM 块存（约 4:1，同样内存约 4 倍时长；需单声道 16bit）
+
+    // 打断：播放中检测到开口即停播（无回声参考时扬声器回灌可能自触发，默认关闭）
+    bool barge_in;
+    int barge_fade_ms;          // 打断时喇叭淡出时长，默认 8ms
+
+    // 连接管理：额外保持一条备用 WS，主连接断开时直接切换（多占一条 TLS/内存）
+    bool ws_hot_standby;
+
+    // 唤醒词：资源包里的 KWS 模型（APP_ASSET_ID_KWS_MODEL）触发 等待期 -> 唤醒期，能量 VAD 只判说完
+    bool wake_word;             // 默认随 CONFIG_VOICE_WAKEUP_MODE；模型不可用时退回能量触发
+    int wake_listen_ms;         // 唤醒后等开口的时长，默认 5000ms；超时仍未开口则取消本轮
+
+    // 按键说话：按下即从短 preroll 开始上传，松开立即 end（不等尾部静音），能量 VAD 不再触发
+    bool push_to_talk;          // 默认随 CONFIG_KEY_PRESS_DIALOG_MODE
+    int ptt_gpio;               // 按键引脚，默认 0（BOOT 键）；<0 用模拟按键（定时按下 / 松开，测延迟用）
+    int ptt_preroll_ms;         // 按下前补发的音频，默认 300ms
+
+    // 采集前端（均默认关闭：会改变 VAD 输入，打开后需按实际电平重调 th_min / th_mul）
+    bool mic_beamform;          // 双麦波束（采集布局有 >= 2 路麦克风时生效）
+    bool mic_noise_suppress;    // 频域降噪（VAD 与上行都用降噪后的音频）
+    bool mic_agc;               // 自动增益（VAD 按增益折算，th_* 仍指基准增益下的电平）
+    bool mic_agc_coarse;        // AGC 粗调：在 mic 任务里经 I2C 改 codec 输入增益（需 mic_agc）
 } task_chat_continue_cfg_t;
 
+typedef struct {
+    uint64_t bytes_sent;     // 累计上行字节
+    uint64_t bytes_dropped;  // 累计丢弃字节（缓存覆盖 + 超时延快进）
+    uint32_t lag_ms;         // 当前落后实时（ms）
+    uint32_t max_lag_ms;     // 本轮最大落后（ms）
+    uint32_t chunk_bytes;    // 当前自适应 chunk 大小
+    uint32_t send_lat_us;    // 单次上行 send 平均耗时（EWMA）
+    uint64_t send_time_us;   // 累计上行 send 墙钟耗时，含等网络（吞吐 = bytes_sent/send_time_us）
+    uint64_t cpu_us;         // 累计上行 CPU：task_net + lwIP tcpip 运行时间（需 FreeRTOS 运行时统计，否则为 0）
+} task_chat_continue_uplink_stats_t;
+
+typedef struct {
+    uint32_t turns;                    // 有下行音频的轮次
+    uint32_t first_audio_ms_last;      // 最近一轮：上传 end -> 首个下行 audio
+    uint32_t first_audio_ms_avg;       // 普通轮次平均
+    uint32_t turns_after_cancel;       // 紧跟在打断（cancel）之后的轮次
+    uint32_t first_audio_after_cancel_ms_avg;
+
+    // 感知延迟：说完（上传 end）-> 喇叭出第一个声音（垫音或回复），对比上面的实际首包
+    uint32_t perceived_turns;
+    uint32_t perceived_ms_last;
+    uint32_t perceived_ms_avg;
+    uint32_t fillers_played;           // 触发垫音的轮次
+
+    // 唤醒 -> 首个上行分片发出（含等连接就绪）
+    uint32_t wake_turns;
+    uint32_t wake_uplink_ms_last;
+    uint32_t wake_uplink_ms_avg;
+    uint32_t wake_uplink_ms_max;
+    uint32_t wake_not_ready;           // 说话起点时连接未就绪的轮次
+    uint32_t turn_failovers;           // 上传中途断线、换连接整轮重发的次数
+
+    // 打断：检测到开口 -> 喇叭实际静音（含淡出）
+    uint32_t barge_ins;
+    uint32_t barge_ms_last;
+    uint32_t barge_ms_avg;
+    uint32_t barge_ms_max;
+
+    // 唤醒词（检测器本身的占用/得分见 task_chat_continue_get_kws_stats）
+    uint32_t kws_wakes;                // 唤醒词开启的轮次
+    uint32_t kws_no_speech;            // 唤醒后没开口被取消的轮次（多为误唤醒）
+    uint32_t kws_drop_bytes;           // task_kws 跟不上丢弃的采集字节
+
+    // 按键说话：按下（中断时刻）-> 首个上行分片发出；松开 -> end 发出
+    uint32_t ptt_turns;
+    uint32_t ptt_uplink_ms_last;
+    uint32_t ptt_uplink_ms_avg;
+    uint32_t ptt_uplink_ms_max;
+    uint32_t ptt_ends;
+    uint32_t ptt_end_ms_last;
+    uint32_t ptt_end_ms_avg;
+    uint32_t ptt_end_ms_max;
+} task_chat_continue_latency_stats_t;
+
 esp_err_t task_chat_continue_start(const task_chat_continue_cfg_t *cfg);
 
+/**
+ * @brief 读取上行节流统计（start 后有效）
+ */
+esp_err_t task_chat_continue_get_uplink_stats(task_chat_continue_uplink_stats_t *out);
+
+/**
+ * @brief 读取首包延迟统计（对比打断后下一轮与普通轮次的首包时间，以及垫音后的感知延迟）
+ */
+esp_err_t task_chat_continue_get_latency_stats(task_chat_continue_latency_stats_t *out);
+
+/**
+ * @brief 读取唤醒词检测统计（CPU 占用、推理耗时、得分）；未启用唤醒词返回 ESP_ERR_INVALID_STATE
+ */
+esp_err_t task_chat_continue_get_kws_stats(app_kws_stats_t *out);
+
+/**
+ * @brief 外部按键源（触摸屏、遥控等）上报按下 / 松开；未启用按键说话返回 ESP_ERR_INVALID_STATE
+ */
+esp_err_t task_chat_continue_ptt_inject(bool pressed);
+
 #ifdef __cplusplus
 }
 #endif
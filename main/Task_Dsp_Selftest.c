@@ -0,0 +1,925 @@
+#include "Task_Dsp_Selftest.h"
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "esp_check.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "App_Adpcm.h"
+#include "App_Agc.h"
+#include "App_AssetPack.h"
+#include "App_Beamform.h"
+#include "App_CapFmt.h"
+#include "App_Kws.h"
+#include "App_Ns.h"
+#include "App_PcmOps.h"
+#include "App_Spec.h"
+#include "App_SpkEq.h"
+#include "App_SpkMix.h"
+#include "App_TestSig.h"
+
+static const char *TAG = "Task_Dsp_Selftest";
+
+#define DSP_TEST_SR 24000
+
+static void log_bench(const char *name, int samples, int64_t us)
+{
+    // 相对实时倍数：处理 samples 个样本的耗时 vs 其音频时长
+    double audio_us = (double)samples * 1000000.0 / DSP_TEST_SR;
+    ESP_LOGI(TAG, "%-16s %6" PRId64 " us / %d samples，%.2f Msamples/s，%.0fx realtime", name, us, samples,
+             (us > 0) ? (double)samples / (double)us : 0.0, (us > 0) ? audio_us / (double)us : 0.0);
+}
+
+static esp_err_t bench_adpcm(void)
+{
+    const int blocks = (DSP_TEST_SR * 5) / APP_ADPCM_BLOCK_SAMPLES; // 约 5s
+    const int n = blocks * APP_ADPCM_BLOCK_SAMPLES;
+    int16_t *x = (int16_t *)heap_caps_malloc((size_t)n * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    int16_t *y = (int16_t *)heap_caps_malloc((size_t)n * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    uint8_t *e = (uint8_t *)heap_caps_malloc((size_t)blocks * APP_ADPCM_BLOCK_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    esp_err_t ret = ESP_OK;
+    if (!x || !y || !e) {
+        ret = ESP_ERR_NO_MEM;
+        goto out;
+    }
+    app_tsig_tones(x, n, DSP_TEST_SR);
+
+    app_adpcm_enc_t enc = {0};
+    int64_t t0 = esp_timer_get_time();
+    for (int b = 0; b < blocks; ++b) {
+        app_adpcm_encode_block(&enc, x + b * APP_ADPCM_BLOCK_SAMPLES, e + b * APP_ADPCM_BLOCK_BYTES);
+    }
+    int64_t t1 = esp_timer_get_time();
+    for (int b = 0; b < blocks; ++b) {
+        app_adpcm_decode_block(e + b * APP_ADPCM_BLOCK_BYTES, y + b * APP_ADPCM_BLOCK_SAMPLES);
+    }
+    int64_t t2 = esp_timer_get_time();
+
+    log_bench("adpcm encode", n, t1 - t0);
+    log_bench("adpcm decode", n, t2 - t1);
+
+    // 随机访问：单独解任意一块，结果须与顺序解码一致（环形缓冲读指针依赖这一点）
+    static int16_t one[APP_ADPCM_BLOCK_SAMPLES];
+    int k = blocks / 3;
+    app_adpcm_decode_block(e + k * APP_ADPCM_BLOCK_BYTES, one);
+    bool ra_ok = memcmp(one, y + k * APP_ADPCM_BLOCK_SAMPLES, sizeof(one)) == 0;
+
+    const double snr = app_tsig_snr_db(x, y, n);
+    ESP_LOGI(TAG, "adpcm: ratio %.2f:1, SNR %.1f dB, random access %s",
+             (double)APP_ADPCM_BLOCK_PCM_BYTES / APP_ADPCM_BLOCK_BYTES, snr, ra_ok ? "ok" : "MISMATCH");
+    if (!ra_ok || snr < 20.0) ret = ESP_FAIL;
+
+out:
+    heap_caps_free(x);
+    heap_caps_free(y);
+    heap_caps_free(e);
+    return ret;
+}
+
+// 采集格式：特化内核 vs 通用内核，结果须逐位一致
+static esp_err_t bench_cap_fmt_one(int channels, int bits, const char *layout)
+{
+    app_cap_fmt_t fs, fg;
+    ESP_RETURN_ON_ERROR(app_cap_fmt_init(&fs, channels, bits, layout), TAG, "cap fmt init failed");
+    fg = fs;
+    app_cap_fmt_use_generic(&fg);
+
+    const int n = DSP_TEST_SR * 2; // 约 2s
+    const size_t raw_bytes = (size_t)n * (size_t)fs.frame_bytes;
+    uint8_t *raw = (uint8_t *)heap_caps_malloc(raw_bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    int16_t *out = (int16_t *)heap_caps_malloc((size_t)n * 6 * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    esp_err_t ret = ESP_OK;
+    if (!raw || !out) {
+        ret = ESP_ERR_NO_MEM;
+        goto out;
+    }
+    // 每个 lane 填同一测试信号的不同相位，参考/麦克风可区分
+    int16_t *sig = out;
+    app_tsig_tones(sig, n, DSP_TEST_SR);
+    for (int i = 0; i < n; ++i) {
+        for (int l = 0; l < fs.lanes; ++l) {
+            int16_t v = sig[(i + l * 7) % n];
+            if (fs.lane_bits == 32) {
+                ((int32_t *)raw)[i * fs.lanes + l] = ((int32_t)v << 16) | (int32_t)(i & 0xffff);
+            } else {
+                ((int16_t *)raw)[i * fs.lanes + l] = v;
+            }
+        }
+    }
+    int16_t *ms = out, *rs = out + n, *mg = out + 2 * n, *rg = out + 3 * n;
+
+    int64_t t0 = esp_timer_get_time();
+    app_cap_fmt_convert(&fs, raw, n, ms, rs);
+    int64_t t1 = esp_timer_get_time();
+    app_cap_fmt_convert(&fg, raw, n, mg, rg);
+    int64_t t2 = esp_timer_get_time();
+
+    char name[24];
+    snprintf(name, sizeof(name), "cap %s", fs.kernel_name);
+    log_bench(name, n, t1 - t0);
+    snprintf(name, sizeof(name), "cap %s", fg.kernel_name);
+    log_bench(name, n, t2 - t1);
+
+    int bad = 0;
+    for (int i = 0; i < n; ++i) {
+        if (ms[i] != mg[i] || rs[i] != rg[i]) bad++;
+    }
+    // 双麦拆分：同样逐位比较（ms/mg 已比完，复用为输出）
+    if (fs.split && fg.split) {
+        int16_t *a0 = ms, *a1 = mg, *b0 = out + 4 * n, *b1 = out + 5 * n;
+        app_cap_fmt_split(&fs, raw, n, a0, a1, rs);
+        app_cap_fmt_split(&fg, raw, n, b0, b1, rg);
+        for (int i = 0; i < n; ++i) {
+            if (a0[i] != b0[i] || a1[i] != b1[i] || rs[i] != rg[i]) bad++;
+        }
+    }
+    ESP_LOGI(TAG, "cap %dch/%dbit %s: %s vs %s, %.2fx, mismatch %d", channels, bits, layout ? layout : "-",
+             fs.kernel_name, fg.kernel_name, (t1 > t0) ? (double)(t2 - t1) / (double)(t1 - t0) : 0.0, bad);
+    if (bad) ret = ESP_FAIL;
+
+out:
+    heap_caps_free(raw);
+    heap_caps_free(out);
+    return ret;
+}
+
+static esp_err_t bench_cap_fmt(void)
+{
+    esp_err_t ret = ESP_OK;
+    // 两个特化布局 + 两个走通用内核的布局
+    if (bench_cap_fmt_one(2, 32, "RMNM") != ESP_OK) ret = ESP_FAIL;
+    if (bench_cap_fmt_one(2, 16, "MR") != ESP_OK) ret = ESP_FAIL;
+    if (bench_cap_fmt_one(2, 32, "MR") != ESP_OK) ret = ESP_FAIL;
+    if (bench_cap_fmt_one(4, 16, "MMRN") != ESP_OK) ret = ESP_FAIL;
+    return ret;
+}
+
+// ---------- 双麦波束：合成场景 ----------
+
+#define BF_SCENE_FRAME (DSP_TEST_SR / 50)
+#define BF_SCENE_PAD APP_BF_MAX_LAG
+
+static esp_err_t bench_beamform_scene(const int16_t *src, int frames, int tau, int noise_amp)
+{
+    int16_t m0[BF_SCENE_FRAME], m1[BF_SCENE_FRAME], y[BF_SCENE_FRAME];
+    app_beamform_cfg_t cfg = app_beamform_cfg_default(DSP_TEST_SR);
+    app_beamform_t bf, bs, bn;
+    ESP_RETURN_ON_ERROR(app_beamform_init(&bf, &cfg), TAG, "bf init failed");
+
+    // 1) 混合信号自动估计方向
+    uint32_t ns0 = 0x1111u, ns1 = 0x2222u;
+    for (int f = 0; f < frames; ++f) {
+        app_tsig_bf_frame(src, BF_SCENE_FRAME, BF_SCENE_PAD, f, tau, noise_amp, &ns0, &ns1, 0, m0, m1);
+        app_beamform_process(&bf, m0, m1, BF_SCENE_FRAME, y);
+    }
+    app_beamform_stats_t st;
+    app_beamform_get_stats(&bf, &st);
+    app_beamform_deinit(&bf);
+
+    // 2) 锁定估计出的导向，声源/噪声分量分开过，算输入（m0）与输出的 SNR
+    esp_err_t ret = app_beamform_init(&bs, &cfg);
+    if (ret == ESP_OK) ret = app_beamform_init(&bn, &cfg);
+    if (ret != ESP_OK) {
+        app_beamform_deinit(&bs);
+        return ret;
+    }
+    app_beamform_set_lag(&bs, st.lag, true);
+    app_beamform_set_lag(&bn, st.lag, true);
+    double ps_in = 0, pn_in = 0, ps_out = 0, pn_out = 0;
+    ns0 = 0x1111u;
+    ns1 = 0x2222u;
+    for (int f = 0; f < frames; ++f) {
+        uint32_t a0 = ns0, a1 = ns1;
+        app_tsig_bf_frame(src, BF_SCENE_FRAME, BF_SCENE_PAD, f, tau, noise_amp, &a0, &a1, 1, m0, m1);
+        ps_in += app_tsig_pow(m0, BF_SCENE_FRAME);
+        app_beamform_process(&bs, m0, m1, BF_SCENE_FRAME, y);
+        ps_out += app_tsig_pow(y, BF_SCENE_FRAME);
+
+        app_tsig_bf_frame(src, BF_SCENE_FRAME, BF_SCENE_PAD, f, tau, noise_amp, &ns0, &ns1, 2, m0, m1);
+        pn_in += app_tsig_pow(m0, BF_SCENE_FRAME);
+        app_beamform_process(&bn, m0, m1, BF_SCENE_FRAME, y);
+        pn_out += app_tsig_pow(y, BF_SCENE_FRAME);
+    }
+    app_beamform_deinit(&bs);
+    app_beamform_deinit(&bn);
+
+    const double snr_in = 10.0 * log10(ps_in / (pn_in + 1.0));
+    const double snr_out = 10.0 * log10(ps_out / (pn_out + 1.0));
+    ESP_LOGI(TAG, "beam tau=%+d: lag=%+d (%.0f deg), SNR %.1f -> %.1f dB (+%.1f), cycles/frame avg %" PRIu32
+                  " max %" PRIu32 ", over budget %" PRIu32 "/%" PRIu32,
+             tau, st.lag, (double)st.doa_deg, snr_in, snr_out, snr_out - snr_in, st.cycles_avg, st.cycles_max,
+             st.over_budget, st.frames);
+    // 理论上两麦非相干噪声 +3 dB
+    return (st.lag == tau && snr_out - snr_in > 2.0) ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t bench_beamform(void)
+{
+    const int frames = 150; // 3s
+    const int n = frames * BF_SCENE_FRAME + 2 * BF_SCENE_PAD;
+    int16_t *src = (int16_t *)heap_caps_malloc((size_t)n * sizeof(int16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    ESP_RETURN_ON_FALSE(src, ESP_ERR_NO_MEM, TAG, "alloc src failed");
+    app_tsig_bf_source(src, n, DSP_TEST_SR);
+
+    esp_err_t ret = ESP_OK;
+    static const struct {
+        int tau;
+        int noise_amp;
+    } scenes[] = {
+        {3, 3000},
+        {-2, 1500},
+        {0, 3000},
+        {-4, 3000},
+    };
+    for (size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); ++i) {
+        if (bench_beamform_scene(src, frames, scenes[i].tau, scenes[i].noise_amp) != ESP_OK) ret = ESP_FAIL;
+    }
+    heap_caps_free(src);
+    return ret;
+}
+
+// ---------- 频谱内核：REF/FAST 逐位一致 + 精度 + 每帧周期 ----------
+
+static esp_err_t bench_spec_fft(int n)
+{
+    app_spec_fft_t f;
+    ESP_RETURN_ON_ERROR(app_spec_fft_init(&f, n), TAG, "fft init failed");
+    const size_t bytes = (size_t)(n * 3 + 4) * sizeof(int16_t);
+    int16_t *x = (int16_t *)heap_caps_malloc(bytes, MALLOC_CAP_8BIT);
+    if (!x) {
+        app_spec_fft_deinit(&f);
+        return ESP_ERR_NO_MEM;
+    }
+    int16_t *a = x + n, *b = a + n + 2;
+    const app_spec_impl_t saved = app_spec_get_impl();
+
+    // 不同幅度的随机帧：两套实现逐位一致
+    uint32_t st = 0x5eedu;
+    int mismatch = 0;
+    for (int t = 0; t < 64; ++t) {
+        const int amp = 32 << (t % 10);
+        for (int i = 0; i < n; ++i) x[i] = (int16_t)((app_tsig_noise(&st, 4096) * amp) >> 12);
+        app_spec_set_impl(APP_SPEC_IMPL_REF);
+        int ea = app_spec_rfft(&f, x, a);
+        app_spec_set_impl(APP_SPEC_IMPL_FAST);
+        int eb = app_spec_rfft(&f, x, b);
+        if (ea != eb || memcmp(a, b, (size_t)(n + 2) * sizeof(int16_t)) != 0) mismatch++;
+    }
+
+    // 精度：与浮点 DFT 比较
+    app_tsig_tones(x, n, DSP_TEST_SR);
+    int e = app_spec_rfft(&f, x, a);
+    double ps = 0, pe = 0;
+    for (int k = 0; k <= n / 2; ++k) {
+        double re = 0, im = 0;
+        for (int i = 0; i < n; ++i) {
+            const double ph = 2.0 * M_PI * (double)((k * i) % n) / n;
+            re += x[i] * cos(ph);
+            im -= x[i] * sin(ph);
+        }
+        const double dr = re - ldexp(a[2 * k], e), di = im - ldexp(a[2 * k + 1], e);
+        ps += re * re + im * im;
+        pe += dr * dr + di * di;
+    }
+    const double snr = (pe > 0) ? 10.0 * log10(ps / pe) : 99.0;
+
+    // 每帧周期
+    uint32_t cyc[2];
+    for (int impl = 0; impl < 2; ++impl) {
+        app_spec_set_impl(impl ? APP_SPEC_IMPL_FAST : APP_SPEC_IMPL_REF);
+        const uint32_t c0 = esp_cpu_get_cycle_count();
+        for (int r = 0; r < 100; ++r) app_spec_rfft(&f, x, a);
+        cyc[impl] = (esp_cpu_get_cycle_count() - c0) / 100;
+    }
+    app_spec_set_impl(saved);
+
+    ESP_LOGI(TAG, "rfft %d: ref %" PRIu32 " / fast %" PRIu32 " cycles/frame (%.2fx), SNR %.1f dB, mismatch %d/64",
+             n, cyc[0], cyc[1], cyc[1] ? (double)cyc[0] / cyc[1] : 0.0, snr, mismatch);
+    heap_caps_free(x);
+    app_spec_fft_deinit(&f);
+    return (mismatch == 0 && snr > 50.0) ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t bench_spec_pipe(void)
+{
+    app_spec_pipe_t p;
+    app_spec_pipe_cfg_t cfg = app_spec_pipe_cfg_default(DSP_TEST_SR);
+    ESP_RETURN_ON_ERROR(app_spec_pipe_init(&p, &cfg), TAG, "pipe init failed");
+    int16_t *x = (int16_t *)heap_caps_malloc((size_t)cfg.n_fft * sizeof(int16_t), MALLOC_CAP_8BIT);
+    if (!x) {
+        app_spec_pipe_deinit(&p);
+        return ESP_ERR_NO_MEM;
+    }
+    app_tsig_tones(x, cfg.n_fft, DSP_TEST_SR);
+    app_spec_feat_t feat;
+    for (int r = 0; r < 100; ++r) app_spec_pipe_run(&p, x, &feat);
+
+    // 测试信号主能量在 300 Hz：峰值应落在低频 mel 带
+    int peak = 0;
+    for (int i = 1; i < cfg.n_mel; ++i) {
+        if (feat.logmel[i] > feat.logmel[peak]) peak = i;
+    }
+    const double frame_us = (double)cfg.n_fft * 1000000.0 / DSP_TEST_SR;
+    ESP_LOGI(TAG, "spec pipe %d/%d mel/%d ceps: %" PRIu32 " cycles/frame (%.1f%% of a core at %.0f us hop), "
+                  "log E %.2f, peak mel %d, c0 %.1f",
+             cfg.n_fft, cfg.n_mel, cfg.n_ceps, p.cycles_avg,
+             100.0 * p.cycles_avg / (frame_us / 2 * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ), frame_us / 2,
+             feat.log_energy / 256.0, peak, feat.mfcc[0] / 256.0);
+    heap_caps_free(x);
+    app_spec_pipe_deinit(&p);
+    return (peak < cfg.n_mel / 4) ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t bench_spec(void)
+{
+    esp_err_t ret = ESP_OK;
+    if (bench_spec_fft(256) != ESP_OK) ret = ESP_FAIL;
+    if (bench_spec_fft(512) != ESP_OK) ret = ESP_FAIL;
+    if (bench_spec_pipe() != ESP_OK) ret = ESP_FAIL;
+    return ret;
+}
+
+// ---------- 降噪：合成带噪语音 ----------
+
+#define NS_SCENE_FRAME (DSP_TEST_SR / 50)
+#define NS_SCENE_SECONDS 12
+// 一次场景：speech_amp=0 时只有噪声（统计误唤醒），否则统计 SNR（输出与延迟对齐的纯净语音比较）
+static esp_err_t ns_scene_run(app_tsig_noise_t type, int speech_amp, int noise_amp, bool bypass, app_tsig_vad_t *vad,
+                              double *snr_in, double *snr_out, app_ns_stats_t *st)
+{
+    app_ns_t ns;
+    app_ns_cfg_t cfg = app_ns_cfg_default(DSP_TEST_SR);
+    ESP_RETURN_ON_ERROR(app_ns_init(&ns, &cfg), TAG, "ns init failed");
+    app_ns_set_bypass(&ns, bypass);
+    const int lat = ns.latency;
+    app_tsig_scene_t *sc = (app_tsig_scene_t *)malloc(sizeof(app_tsig_scene_t));
+    int16_t *buf = (int16_t *)malloc((size_t)(NS_SCENE_FRAME * 3 + lat) * sizeof(int16_t));
+    if (!sc || !buf) {
+        free(sc);
+        free(buf);
+        app_ns_deinit(&ns);
+        return ESP_ERR_NO_MEM;
+    }
+    int16_t *clean = buf, *noise = clean + NS_SCENE_FRAME, *x = noise + NS_SCENE_FRAME;
+    int16_t *dl = x + NS_SCENE_FRAME; // 纯净语音延迟线
+    memset(dl, 0, (size_t)lat * sizeof(int16_t));
+    app_tsig_scene_init(sc, DSP_TEST_SR, 0x5a5au + (uint32_t)type);
+
+    memset(vad, 0, sizeof(*vad));
+    double ps = 0, pn = 0, pe = 0;
+    const int frames = NS_SCENE_SECONDS * 50;
+    for (int f = 0; f < frames; ++f) {
+        if (speech_amp > 0) {
+            app_tsig_speech(sc, f, speech_amp, clean);
+        } else {
+            memset(clean, 0, NS_SCENE_FRAME * sizeof(int16_t));
+        }
+        app_tsig_room_noise(sc, type, f, noise_amp, noise);
+        memcpy(x, clean, NS_SCENE_FRAME * sizeof(int16_t));
+        app_pcm_mix(x, noise, NS_SCENE_FRAME, 4096);
+        app_ns_process(&ns, x, NS_SCENE_FRAME);
+        app_tsig_vad_feed(vad, DSP_TEST_SR, x, NS_SCENE_FRAME);
+
+        // 前 2s 留给噪声估计收敛，不计入 SNR
+        for (int i = 0; i < NS_SCENE_FRAME; ++i) {
+            // 延迟 lat 个样本的纯净语音（lat >= 一帧）
+            const int16_t c = dl[i];
+            if (f >= 100) {
+                const double e = (double)x[i] - c;
+                ps += (double)c * c;
+                pe += e * e;
+                pn += (double)noise[i] * noise[i];
+            }
+        }
+        memmove(dl, dl + NS_SCENE_FRAME, (size_t)(lat - NS_SCENE_FRAME) * sizeof(int16_t));
+        memcpy(dl + lat - NS_SCENE_FRAME, clean, NS_SCENE_FRAME * sizeof(int16_t));
+    }
+    app_ns_get_stats(&ns, st);
+    *snr_in = 10.0 * log10((ps + 1.0) / (pn + 1.0));
+    *snr_out = 10.0 * log10((ps + 1.0) / (pe + 1.0));
+    free(sc);
+    free(buf);
+    app_ns_deinit(&ns);
+    return ESP_OK;
+}
+
+static esp_err_t bench_ns(void)
+{
+    static const struct {
+        const char *name;
+        app_tsig_noise_t type;
+        int speech_amp;
+        int noise_amp;
+    } scenes[] = {
+        {"fan", APP_TSIG_NOISE_FAN, 2500, 500},
+        {"tv", APP_TSIG_NOISE_TV, 2500, 250},
+    };
+    esp_err_t ret = ESP_OK;
+    for (size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); ++i) {
+        app_tsig_vad_t v_off, v_on, v_sp;
+        double si, so_off, so_on, d0, d1;
+        app_ns_stats_t st_off, st_on, st;
+        // 只有噪声：旁路 / 降噪各跑一遍比较误唤醒
+        esp_err_t err = ns_scene_run(scenes[i].type, 0, scenes[i].noise_amp, true, &v_off, &d0, &d1, &st_off);
+        if (err == ESP_OK) err = ns_scene_run(scenes[i].type, 0, scenes[i].noise_amp, false, &v_on, &d0, &d1, &st_on);
+        // 带噪语音：SNR 改善，且语音仍能唤醒
+        if (err == ESP_OK) err = ns_scene_run(scenes[i].type, scenes[i].speech_amp, scenes[i].noise_amp, true, &v_sp,
+                                              &si, &so_off, &st);
+        if (err == ESP_OK) err = ns_scene_run(scenes[i].type, scenes[i].speech_amp, scenes[i].noise_amp, false, &v_sp,
+                                              &si, &so_on, &st);
+        if (err != ESP_OK) return err;
+
+        const double hop_us = 10000.0; // 默认 20ms 窗、10ms 跳
+        ESP_LOGI(TAG, "ns %-3s: SNR %.1f -> %.1f dB (+%.1f, bypass %.1f), noise-only wakes %d -> %d, voiced windows "
+                      "%d -> %d /%d, speech wakes %d",
+                 scenes[i].name, si, so_on, so_on - si, so_off, v_off.wakes, v_on.wakes, v_off.voiced, v_on.voiced,
+                 v_on.windows, v_sp.wakes);
+        ESP_LOGI(TAG, "ns %-3s: %" PRIu32 " cycles/hop avg, %" PRIu32 " max (%.1f%% of a core), bypass %" PRIu32
+                      " avg, over budget %" PRIu32 "/%" PRIu32 ", atten %.1f dB",
+                 scenes[i].name, st.cycles_avg, st.cycles_max,
+                 100.0 * st.cycles_avg / (hop_us * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ), st_off.cycles_avg,
+                 st.over_budget, st.frames, (double)st_on.atten_db);
+        if (!(so_on - si > 3.0 && v_on.voiced < v_off.voiced && v_sp.wakes > 0)) ret = ESP_FAIL;
+    }
+    return ret;
+}
+
+// ---------- AGC：同一段语音按不同距离（电平）送入 ----------
+
+#define AGC_SCENE_SECONDS 9
+
+typedef struct {
+    double in_dbfs, out_dbfs;   // 稳定后语音段 RMS
+    double vad_db;              // VAD 看到的电平相对输入
+    int32_t peak;
+    app_agc_stats_t st;
+} agc_scene_t;
+
+// late_amp > 0：6s 起每段开头加 100ms 硬起音方波（小声之后拍桌 / 关门，增益还在高位，看限幅）
+static esp_err_t agc_scene_run(int speech_amp, int late_amp, agc_scene_t *r)
+{
+    app_agc_t agc;
+    app_agc_cfg_t cfg = app_agc_cfg_default(DSP_TEST_SR);
+    ESP_RETURN_ON_ERROR(app_agc_init(&agc, &cfg), TAG, "agc init failed");
+    app_tsig_scene_t *sc = (app_tsig_scene_t *)malloc(sizeof(app_tsig_scene_t));
+    int16_t *x = (int16_t *)malloc(NS_SCENE_FRAME * 2 * sizeof(int16_t));
+    if (!sc || !x) {
+        free(sc);
+        free(x);
+        return ESP_ERR_NO_MEM;
+    }
+    int16_t *noise = x + NS_SCENE_FRAME;
+    app_tsig_scene_init(sc, DSP_TEST_SR, 0xa5a5u);
+
+    double pi = 0, po = 0, ai = 0, av = 0;
+    int64_t cnt = 0;
+    r->peak = 0;
+    const int frames = AGC_SCENE_SECONDS * 50;
+    for (int f = 0; f < frames; ++f) {
+        app_tsig_speech(sc, f, speech_amp, x);
+        if (late_amp > 0 && f >= 300 && (f % 150) < 5) {
+            for (int i = 0; i < NS_SCENE_FRAME; ++i) x[i] = (int16_t)(((i / 12) & 1) ? late_amp : -late_amp);
+        }
+        app_tsig_room_noise(sc, APP_TSIG_NOISE_FAN, f, 20, noise);
+        app_pcm_mix(x, noise, NS_SCENE_FRAME, 4096);
+        // 第一段（3s）留给收敛；只统计说话段
+        const bool meas = f >= 150 && (f % 150) < 75;
+        if (meas) {
+            pi += (double)app_pcm_sum_sq(x, NS_SCENE_FRAME);
+            ai += (double)app_pcm_sum_abs(x, NS_SCENE_FRAME);
+        }
+        app_agc_process(&agc, x, NS_SCENE_FRAME);
+        if (meas) {
+            po += (double)app_pcm_sum_sq(x, NS_SCENE_FRAME);
+            av += (double)app_pcm_sum_abs(x, NS_SCENE_FRAME) * app_agc_vad_scale_q12(&agc) / 4096.0;
+            cnt += NS_SCENE_FRAME;
+        }
+        const int32_t pk = app_pcm_peak(x, NS_SCENE_FRAME);
+        if (pk > r->peak) r->peak = pk;
+    }
+    app_agc_get_stats(&agc, &r->st);
+    r->in_dbfs = 10.0 * log10(pi / (double)cnt / (32768.0 * 32768.0) + 1e-12);
+    r->out_dbfs = 10.0 * log10(po / (double)cnt / (32768.0 * 32768.0) + 1e-12);
+    r->vad_db = 20.0 * log10((av + 1.0) / (ai + 1.0));
+    free(sc);
+    free(x);
+    return ESP_OK;
+}
+
+static esp_err_t bench_agc(void)
+{
+    // 远场小声 -> 近讲；最后一档输入已削顶，只看限幅
+    static const int amps[] = {300, 1000, 3000, 9000, 30000};
+    const int n_level = 4;
+    const app_agc_cfg_t def = app_agc_cfg_default(DSP_TEST_SR);
+    const int32_t ceil = (int32_t)lrintf(32767.0f * powf(10.0f, def.limit_dbfs / 20.0f));
+    double in_min = 0, in_max = -200, out_min = 0, out_max = -200;
+    uint32_t cyc_avg = 0, cyc_max = 0;
+    esp_err_t ret = ESP_OK;
+    for (size_t i = 0; i < sizeof(amps) / sizeof(amps[0]); ++i) {
+        agc_scene_t r;
+        ESP_RETURN_ON_ERROR(agc_scene_run(amps[i], 0, &r), TAG, "agc scene failed");
+        ESP_LOGI(TAG, "agc amp %5d: speech %6.1f -> %6.1f dBFS, gain %5.1f dB, peak %5" PRId32 ", limiter %4" PRIu32
+                      ", clips %4" PRIu32 ", vad %+.1f dB",
+                 amps[i], r.in_dbfs, r.out_dbfs, (double)r.st.gain_db, r.peak, r.st.limiter_hits, r.st.in_clips,
+                 r.vad_db);
+        if ((int)i < n_level) {
+            if (r.in_dbfs < in_min) in_min = r.in_dbfs;
+            if (r.in_dbfs > in_max) in_max = r.in_dbfs;
+            if (r.out_dbfs < out_min) out_min = r.out_dbfs;
+            if (r.out_dbfs > out_max) out_max = r.out_dbfs;
+            // VAD 看到的放大不超过 vad_credit_db，衰减被补回
+            if (r.vad_db < -0.5 || r.vad_db > def.vad_credit_db + 0.5) ret = ESP_FAIL;
+        }
+        if (r.peak > ceil) ret = ESP_FAIL;
+        if (r.st.cycles_avg > cyc_avg) cyc_avg = r.st.cycles_avg;
+        if (r.st.cycles_max > cyc_max) cyc_max = r.st.cycles_max;
+    }
+    agc_scene_t r;
+    ESP_RETURN_ON_ERROR(agc_scene_run(amps[0], 30000, &r), TAG, "agc scene failed");
+    ESP_LOGI(TAG, "agc quiet -> slam: peak %" PRId32 " (ceil %" PRId32 "), limiter %" PRIu32 ", gain %.1f dB", r.peak,
+             ceil, r.st.limiter_hits, (double)r.st.gain_db);
+    if (r.peak > ceil || r.st.limiter_hits == 0) ret = ESP_FAIL;
+
+    const double frame_us = 20000.0;
+    ESP_LOGI(TAG, "agc: speech spread %.1f dB in -> %.1f dB out, %" PRIu32 " cycles/frame avg, %" PRIu32
+                  " max (%.2f%% of a core)",
+             in_max - in_min, out_max - out_min, cyc_avg, cyc_max,
+             100.0 * cyc_avg / (frame_us * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ));
+    if (out_max - out_min > 3.0) ret = ESP_FAIL;
+    return ret;
+}
+
+#define PCM_BENCH_N 480         // 20 ms @ 24 kHz
+#define PCM_BENCH_REPS 200
+
+typedef enum {
+    PCM_OP_SUM_ABS = 0,
+    PCM_OP_SUM_SQ,
+    PCM_OP_PEAK,
+    PCM_OP_GAIN,
+    PCM_OP_MIX,
+    PCM_OP_FADE,
+    PCM_OP_MIX_RAMP,
+    PCM_OP_S32_TO_S16,
+    PCM_OP_STEREO_TO_MONO,
+    PCM_OP_COUNT,
+} pcm_op_t;
+
+static const char *const s_pcm_op_name[PCM_OP_COUNT] = {
+    "sum_abs", "sum_sq", "peak", "gain", "mix", "fade", "mix_ramp", "s32_to_s16", "stereo_to_mono",
+};
+
+// 跑一次 op，返回标量结果；数组结果写入 out
+static uint64_t pcm_op_run(const app_pcm_ops_t *o, pcm_op_t op, const int16_t *x, const int32_t *x32, int16_t *out)
+{
+    switch (op) {
+    case PCM_OP_SUM_ABS: return o->sum_abs(x, PCM_BENCH_N);
+    case PCM_OP_SUM_SQ: return o->sum_sq(x, PCM_BENCH_N);
+    case PCM_OP_PEAK: return (uint64_t)o->peak(x, PCM_BENCH_N);
+    case PCM_OP_GAIN: o->gain(out, x, PCM_BENCH_N, 3 * 4096 + 517); break;
+    case PCM_OP_MIX:
+        memcpy(out, x + PCM_BENCH_N, PCM_BENCH_N * sizeof(int16_t));
+        o->mix(out, x, PCM_BENCH_N, 2900);
+        break;
+    case PCM_OP_FADE:
+        memcpy(out, x, PCM_BENCH_N * sizeof(int16_t));
+        o->fade(out, PCM_BENCH_N, 32767, 1200);
+        break;
+    case PCM_OP_MIX_RAMP:
+        memcpy(out, x + PCM_BENCH_N, PCM_BENCH_N * sizeof(int16_t));
+        o->mix_ramp(out, x, PCM_BENCH_N, 32767, 4100);
+        break;
+    case PCM_OP_S32_TO_S16: o->s32_to_s16(out, x32, PCM_BENCH_N); break;
+    case PCM_OP_STEREO_TO_MONO: o->stereo_to_mono(out, x, PCM_BENCH_N); break;
+    default: break;
+    }
+    return 0;
+}
+
+static esp_err_t bench_pcm_ops(void)
+{
+    int16_t *x = (int16_t *)heap_caps_malloc(PCM_BENCH_N * 4 * sizeof(int16_t), MALLOC_CAP_8BIT);
+    int32_t *x32 = (int32_t *)heap_caps_malloc(PCM_BENCH_N * sizeof(int32_t), MALLOC_CAP_8BIT);
+    if (!x || !x32) {
+        heap_caps_free(x);
+        heap_caps_free(x32);
+        return ESP_ERR_NO_MEM;
+    }
+    int16_t *a = x + 2 * PCM_BENCH_N, *b = a + PCM_BENCH_N;
+    // 含满幅样本，覆盖饱和与 -32768 的边界
+    app_tsig_tones(x, 2 * PCM_BENCH_N, DSP_TEST_SR);
+    x[7] = -32768;
+    x[11] = 32767;
+    for (int i = 0; i < PCM_BENCH_N; ++i) x32[i] = ((int32_t)x[i] << 16) | (i * 2654435761u >> 16);
+
+    const app_pcm_ops_t *ops[2] = {app_pcm_ops_get(APP_PCM_IMPL_PORTABLE), app_pcm_ops_get(APP_PCM_IMPL_FAST)};
+    int mismatch = 0;
+    ESP_LOGI(TAG, "pcm ops (%d samples, default %s): cycles/sample portable / fast", PCM_BENCH_N,
+             app_pcm_ops_impl());
+    for (int op = 0; op < PCM_OP_COUNT; ++op) {
+        const uint64_t ra = pcm_op_run(ops[0], (pcm_op_t)op, x, x32, a);
+        const uint64_t rb = pcm_op_run(ops[1], (pcm_op_t)op, x, x32, b);
+        const bool same = (ra == rb) && memcmp(a, b, PCM_BENCH_N * sizeof(int16_t)) == 0;
+        if (!same) mismatch++;
+
+        uint32_t cyc[2];
+        for (int impl = 0; impl < 2; ++impl) {
+            const uint32_t c0 = esp_cpu_get_cycle_count();
+            for (int r = 0; r < PCM_BENCH_REPS; ++r) pcm_op_run(ops[impl], (pcm_op_t)op, x, x32, a);
+            cyc[impl] = esp_cpu_get_cycle_count() - c0;
+        }
+        const double da = (double)cyc[0] / (PCM_BENCH_REPS * PCM_BENCH_N);
+        const double db = (double)cyc[1] / (PCM_BENCH_REPS * PCM_BENCH_N);
+        ESP_LOGI(TAG, "  %-15s %6.2f / %6.2f (%.2fx)%s", s_pcm_op_name[op], da, db, (db > 0) ? da / db : 0.0,
+                 same ? "" : "  MISMATCH");
+    }
+
+    // NCO：1 kHz 音的 RMS 应接近 amp/sqrt(2)
+    app_pcm_nco_t nco;
+    app_pcm_nco_init(&nco, 1000, DSP_TEST_SR, 12000);
+    app_pcm_nco_run(&nco, a, PCM_BENCH_N, 1);
+    const float rms = app_pcm_rms(a, PCM_BENCH_N);
+    ESP_LOGI(TAG, "  nco 1 kHz rms %.1f (expect %.1f)", (double)rms, 12000.0 / M_SQRT2);
+
+    heap_caps_free(x);
+    heap_caps_free(x32);
+    return (mismatch == 0 && fabsf(rms - 12000.0f / (float)M_SQRT2) < 20.0f) ? ESP_OK : ESP_FAIL;
+}
+
+// 播放混音：FILLER -> TTS 接管（填充音淡出丢弃）-> EARCON 闪避 TTS -> 恢复 -> 主音量减半
+#define MIX_TEST_BLOCK 480
+
+typedef struct {
+    app_pcm_nco_t nco;
+    int16_t buf[MIX_TEST_BLOCK];
+} mix_test_src_t;
+
+static esp_err_t bench_spkmix(void)
+{
+    app_spk_mix_cfg_t mc = app_spk_mix_cfg_default(DSP_TEST_SR, MIX_TEST_BLOCK);
+    app_spk_mix_t *m = (app_spk_mix_t *)calloc(1, sizeof(app_spk_mix_t));
+    mix_test_src_t *src = (mix_test_src_t *)calloc(APP_SPK_STREAM_MAX, sizeof(mix_test_src_t));
+    int16_t *out = (int16_t *)heap_caps_malloc(MIX_TEST_BLOCK * sizeof(int16_t), MALLOC_CAP_8BIT);
+    if (!m || !src || !out || app_spk_mix_init(m, &mc) != ESP_OK) {
+        free(m);
+        free(src);
+        heap_caps_free(out);
+        return ESP_ERR_NO_MEM;
+    }
+    static const int freq[APP_SPK_STREAM_MAX] = {300, 700, 1500, 2500};
+    for (int s = 0; s < APP_SPK_STREAM_MAX; ++s) app_pcm_nco_init(&src[s].nco, freq[s], DSP_TEST_SR, 8000);
+
+    // 时间线（块）：0 起 FILLER；25 起 TTS；50..64 EARCON；TTS 到 120；100 起主音量 0.5
+    const int blocks = 120;
+    const int ramp_blocks = (mc.streams[APP_SPK_STREAM_FILLER].ramp_ms * DSP_TEST_SR / 1000 + MIX_TEST_BLOCK - 1) /
+                            MIX_TEST_BLOCK;
+    int filler_muted_at = -1;
+    float tts_ducked = 0, tts_restored = 0, tts_master = 0;
+    int max_err = 0;
+    for (int b = 0; b < blocks; ++b) {
+        const int16_t *in[APP_SPK_STREAM_MAX] = {0};
+        int frames[APP_SPK_STREAM_MAX] = {0};
+        const bool on[APP_SPK_STREAM_MAX] = {filler_muted_at < 0, b >= 25, b >= 50 && b < 65, false};
+        for (int s = 0; s < APP_SPK_STREAM_MAX; ++s) {
+            if (!on[s]) continue;
+            app_pcm_nco_run(&src[s].nco, src[s].buf, MIX_TEST_BLOCK, 1);
+            in[s] = src[s].buf;
+            frames[s] = MIX_TEST_BLOCK;
+        }
+        if (b == 100) app_spk_mix_set_master(m, 0.5f);
+        const int32_t g_tts = m->cur_q15[APP_SPK_STREAM_TTS];
+        int n_out = 0;
+        const uint32_t muted = app_spk_mix_run(m, in, frames, out, &n_out);
+        if ((muted & (1u << APP_SPK_STREAM_FILLER)) && filler_muted_at < 0) filler_muted_at = b;
+
+        // 增益稳定的块逐样本核对：out = sat(tts * g + earcon * g_e)
+        if (b > 25 + ramp_blocks && g_tts == m->cur_q15[APP_SPK_STREAM_TTS] && !on[APP_SPK_STREAM_FILLER]) {
+            const int32_t ge = m->cur_q15[APP_SPK_STREAM_EARCON];
+            for (int i = 0; i < n_out; ++i) {
+                int32_t r = ((src[APP_SPK_STREAM_TTS].buf[i] * g_tts + 16384) >> 15);
+                if (on[APP_SPK_STREAM_EARCON]) r += (src[APP_SPK_STREAM_EARCON].buf[i] * ge + 16384) >> 15;
+                const int d = abs(r - out[i]);
+                if (d > max_err) max_err = d;
+            }
+        }
+        if (b == 64) tts_ducked = app_spk_mix_gain(m, APP_SPK_STREAM_TTS);
+        if (b == 99) tts_restored = app_spk_mix_gain(m, APP_SPK_STREAM_TTS);
+        if (b == blocks - 1) tts_master = app_spk_mix_gain(m, APP_SPK_STREAM_TTS);
+    }
+
+    const app_spk_mix_stats_t st = m->st;
+    const double sec = (double)st.frames / DSP_TEST_SR;
+    const double duck = powf(10.0f, mc.streams[APP_SPK_STREAM_EARCON].duck_db / 20.0f);
+    ESP_LOGI(TAG, "spkmix: filler muted %d blocks after tts (ramp %d), tts gain ducked %.3f (expect %.3f), "
+                  "restored %.3f, master 0.5 -> %.3f, max err %d LSB",
+             filler_muted_at - 25, ramp_blocks, (double)tts_ducked, duck, (double)tts_restored, (double)tts_master,
+             max_err);
+    ESP_LOGI(TAG, "spkmix: %" PRIu32 " cycles/block avg, %" PRIu32 " max, %.0f kcycles per second of output "
+                  "(%.2f%% of a core); added latency 1 block = %d ms (+ <= %d ms waiting on a short tail)",
+             st.cycles_avg, st.cycles_max, (sec > 0) ? (double)st.cycles / sec / 1000.0 : 0.0,
+             (double)app_spk_mix_load_pct(m, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ), MIX_TEST_BLOCK * 1000 / DSP_TEST_SR,
+             MIX_TEST_BLOCK * 500 / DSP_TEST_SR);
+
+    esp_err_t ret = ESP_OK;
+    if (filler_muted_at < 25 || filler_muted_at > 25 + ramp_blocks) ret = ESP_FAIL;
+    if (fabs(tts_ducked - duck) > 0.01 || tts_restored < 0.99f || fabsf(tts_master - 0.5f) > 0.01f) ret = ESP_FAIL;
+    if (max_err > 1) ret = ESP_FAIL;
+    free(m);
+    free(src);
+    heap_caps_free(out);
+    return ret;
+}
+
+// 喇叭 EQ + 限幅：默认链路（2 段）与满 6 段各跑 1 s 语音级正弦 + 满幅扫频，输出峰值不超过限幅上限
+static esp_err_t bench_spkeq_one(app_spk_eq_t *e, const app_spk_eq_cfg_t *cfg, int16_t *buf, const char *name)
+{
+    ESP_RETURN_ON_FALSE(app_spk_eq_init(e, cfg), ESP_ERR_INVALID_ARG, TAG, "eq init failed");
+    app_pcm_nco_t nco;
+    app_pcm_nco_init(&nco, 1000, DSP_TEST_SR, 30000);
+    const int blocks = DSP_TEST_SR / MIX_TEST_BLOCK;
+    uint32_t cyc_sum = 0, cyc_max = 0;
+    int32_t peak = 0;
+    for (int b = 0; b < 2 * blocks; ++b) {
+        // 后一秒每块换频率，让提升段与高通都被推到
+        if (b >= blocks) app_pcm_nco_init(&nco, 200 + (b - blocks) * 200, DSP_TEST_SR, 32000);
+        app_pcm_nco_run(&nco, buf, MIX_TEST_BLOCK, 1);
+        const uint32_t c0 = esp_cpu_get_cycle_count();
+        app_spk_eq_process(e, buf, MIX_TEST_BLOCK);
+        const uint32_t cyc = esp_cpu_get_cycle_count() - c0;
+        cyc_sum += cyc;
+        if (cyc > cyc_max) cyc_max = cyc;
+        const int32_t pk = app_pcm_peak(buf, MIX_TEST_BLOCK);
+        if (pk > peak) peak = pk;
+    }
+    app_spk_eq_stats_t st;
+    app_spk_eq_get_stats(e, &st);
+    const uint32_t cyc_avg = cyc_sum / (uint32_t)(2 * blocks);
+    const double block_us = MIX_TEST_BLOCK * 1e6 / DSP_TEST_SR;
+    ESP_LOGI(TAG, "spkeq %s: %d bands, %" PRIu32 " cycles/block avg, %" PRIu32 " max (%.2f%% of a core), "
+                  "peak in %" PRId32 " -> out %" PRId32 " (ceil %" PRId32 "), min gain %.1f dB, latency %d ms",
+             name, e->n_active, cyc_avg, cyc_max, 100.0 * cyc_avg / (block_us * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ),
+             st.peak_in, peak, e->ceil, (double)st.min_gain_db,
+             app_spk_eq_latency_frames(e) * 1000 / DSP_TEST_SR);
+    return (peak > e->ceil || st.peak_in <= e->ceil) ? ESP_FAIL : ESP_OK;
+}
+
+static esp_err_t bench_spkeq(void)
+{
+    app_spk_eq_t *e = (app_spk_eq_t *)calloc(1, sizeof(app_spk_eq_t));
+    int16_t *buf = (int16_t *)heap_caps_malloc(MIX_TEST_BLOCK * sizeof(int16_t), MALLOC_CAP_8BIT);
+    if (!e || !buf) {
+        free(e);
+        heap_caps_free(buf);
+        return ESP_ERR_NO_MEM;
+    }
+    app_spk_eq_cfg_t c = app_spk_eq_cfg_default(DSP_TEST_SR, 1);
+    esp_err_t ret = bench_spkeq_one(e, &c, buf, "default");
+    c.n_bands = APP_SPK_EQ_MAX_BANDS;
+    for (int i = 2; i < APP_SPK_EQ_MAX_BANDS; ++i) {
+        c.bands[i] = (app_spk_eq_band_t){.type = APP_SPK_EQ_PEAK, .freq_hz = 500.0f * i, .q = 1.0f, .gain_db = 2};
+    }
+    if (bench_spkeq_one(e, &c, buf, "6-band") != ESP_OK) ret = ESP_FAIL;
+    free(e);
+    heap_caps_free(buf);
+    return ret;
+}
+
+// 回放：检测时刻与标注的唤醒词结束时刻匹配，窗口内算命中，其余算误唤醒
+#define KWS_HIT_BEFORE_MS 300
+#define KWS_HIT_AFTER_MS 1500
+
+static esp_err_t bench_kws_replay(app_kws_t *k, const app_asset_t *pcm, const app_asset_t *lab)
+{
+    const int16_t *x = (const int16_t *)pcm->data;
+    const int n = (int)(pcm->len / sizeof(int16_t));
+    const uint32_t *labels = (const uint32_t *)lab->data;
+    const int n_lab = (int)(lab->len / sizeof(uint32_t));
+    const int frame = pcm->sample_rate / 50;
+    const int64_t dur_ms = (int64_t)n * 1000 / pcm->sample_rate;
+
+    int hits = 0, false_wakes = 0, lat_max = 0;
+    int64_t lat_sum = 0;
+    int next = 0; // 第一个尚未匹配的标注
+    for (int off = 0; off + frame <= n; off += frame) {
+        int at = 0;
+        if (!app_kws_feed(k, x + off, frame, &at)) continue;
+        const int64_t t_ms = (int64_t)(off + at) * 1000 / pcm->sample_rate;
+        while (next < n_lab && (int64_t)labels[next] + KWS_HIT_AFTER_MS < t_ms) next++;
+        if (next < n_lab && t_ms >= (int64_t)labels[next] - KWS_HIT_BEFORE_MS) {
+            const int lat = (int)(t_ms - (int64_t)labels[next]);
+            hits++;
+            lat_sum += lat;
+            if (lat > lat_max) lat_max = lat;
+            next++;
+        } else {
+            false_wakes++;
+        }
+    }
+    ESP_LOGI(TAG, "kws replay: %.1f min, %d/%d keywords detected, latency avg %d ms max %d ms, false wakes %d "
+                  "(%.1f /hour)",
+             dur_ms / 60000.0, hits, n_lab, hits ? (int)(lat_sum / hits) : 0, lat_max, false_wakes,
+             dur_ms > 0 ? false_wakes * 3600000.0 / (double)dur_ms : 0.0);
+    return ESP_OK;
+}
+
+static esp_err_t bench_kws(void)
+{
+    app_asset_t model = {0}, pcm = {0}, lab = {0};
+    uint8_t *syn = NULL;
+    const bool have_pack = app_asset_pack_ready();
+    if (!have_pack || app_asset_get(APP_ASSET_ID_KWS_MODEL, &model) != ESP_OK) {
+        const size_t len = app_tsig_kws_model(NULL);
+        syn = (uint8_t *)heap_caps_malloc(len, MALLOC_CAP_8BIT);
+        ESP_RETURN_ON_FALSE(syn, ESP_ERR_NO_MEM, TAG, "alloc model failed");
+        app_tsig_kws_model(syn);
+        model.data = syn;
+        model.len = len;
+        model.name = "synthetic";
+    }
+    const bool replay = have_pack && app_asset_get(APP_ASSET_ID_KWS_REPLAY, &pcm) == ESP_OK &&
+                        app_asset_get(APP_ASSET_ID_KWS_LABELS, &lab) == ESP_OK && pcm.kind == APP_ASSET_KIND_PCM &&
+                        pcm.channels == 1;
+
+    app_kws_t *k = (app_kws_t *)calloc(1, sizeof(app_kws_t));
+    app_kws_cfg_t cfg = app_kws_cfg_default(replay ? pcm.sample_rate : DSP_TEST_SR);
+    cfg.model = model.data;
+    cfg.model_len = model.len;
+    esp_err_t ret = k ? app_kws_init(k, &cfg) : ESP_ERR_NO_MEM;
+    if (ret == ESP_OK) {
+        // CPU：10s 测试信号
+        const int n = DSP_TEST_SR / 50;
+        int16_t *x = (int16_t *)malloc((size_t)n * sizeof(int16_t));
+        if (x) {
+            for (int f = 0; f < 500; ++f) {
+                app_tsig_tones(x, n, DSP_TEST_SR);
+                (void)app_kws_feed(k, x, n, NULL);
+            }
+            free(x);
+            app_kws_stats_t st;
+            app_kws_get_stats(k, &st);
+            ESP_LOGI(TAG, "kws %s (%u bytes): feature %" PRIu32 " cycles/10ms, inference %" PRIu32 " avg %" PRIu32
+                          " max cycles every %d ms, %.1f%% of a core",
+                     model.name, (unsigned)model.len, st.feat_cycles_avg, st.infer_cycles_avg, st.infer_cycles_max,
+                     cfg.infer_ms, (double)st.load_pct);
+            if (st.load_pct >= 100.0f) ret = ESP_FAIL;
+        } else {
+            ret = ESP_ERR_NO_MEM;
+        }
+    }
+    if (ret == ESP_OK && replay) {
+        app_kws_reset(k);
+        ret = bench_kws_replay(k, &pcm, &lab);
+    } else if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "kws replay skipped: no recording in asset pack (ids %d / %d)", APP_ASSET_ID_KWS_REPLAY,
+                 APP_ASSET_ID_KWS_LABELS);
+    }
+    if (k) app_kws_deinit(k);
+    free(k);
+    heap_caps_free(syn);
+    return ret;
+}
+
+static void task_entry(void *arg)
+{
+    (void)arg;
+    esp_err_t err = bench_adpcm();
+    ESP_LOGI(TAG, "adpcm: %s", err == ESP_OK ? "PASS" : esp_err_to_name(err));
+    err = bench_cap_fmt();
+    ESP_LOGI(TAG, "cap fmt: %s", err == ESP_OK ? "PASS" : esp_err_to_name(err));
+    err = bench_beamform();
+    ESP_LOGI(TAG, "beamform: %s", err == ESP_OK ? "PASS" : esp_err_to_name(err));
+    err = bench_spec();
+    ESP_LOGI(TAG, "spec: %s", err == ESP_OK ? "PASS" : esp_err_to_name(err));
+    err = bench_pcm_ops();
+    ESP_LOGI(TAG, "pcm ops: %s", err == ESP_OK ? "PASS" : esp_err_to_name(err));
+    err = bench_spkmix();
+    ESP_LOGI(TAG, "spkmix: %s", err == ESP_OK ? "PASS" : esp_err_to_name(err));
+    err = bench_spkeq();
+    ESP_LOGI(TAG, "spkeq: %s", err == ESP_OK ? "PASS" : esp_err_to_name(err));
+    err = bench_ns();
+    ESP_LOGI(TAG, "ns: %s", err == ESP_OK ? "PASS" : esp_err_to_name(err));
+    err = bench_agc();
+    ESP_LOGI(TAG, "agc: %s", err == ESP_OK ? "PASS" : esp_err_to_name(err));
+    err = bench_kws();
+    ESP_LOGI(TAG, "kws: %s", err == ESP_OK ? "PASS" : esp_err_to_name(err));
+    ESP_LOGI(TAG, "dsp selftest done");
+    vTaskDelete(NULL);
+}
+
+esp_err_t task_dsp_selftest_start(void)
+{
+    BaseType_t ok = xTaskCreate(task_entry, "task_dsp_selftest", 4096, NULL, 3, NULL);
+    return ok == pdPASS ? ESP_OK : ESP_FAIL;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 端上 DSP 自检/基准：逐项跑吞吐（相对实时倍数）和质量（SNR）并打印
+ */
+esp_err_t task_dsp_selftest_start(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -6,6 +6,7 @@
 #include "esp_check.h"
 #include "esp_log.h"
 
+#include "App_AssetPack.h"
 #include "App_Speak_Sound.h"
 
 static const char *TAG = "Task_Sound_Selftest";
@@ -19,6 +20,15 @@ static void task_entry(void *arg)
         ESP_LOGE(TAG, "play tone failed: %s", esp_err_to_name(err));
     }
     vTaskDelay(pdMS_TO_TICKS(200));
+
+    // 资源包里的提示音：直接从 flash 映射区播放
+    if (app_asset_pack_ready()) {
+        ESP_LOGI(TAG, "speaker selftest: play earcon from asset pack ...");
+        err = app_asset_play(APP_ASSET_ID_EARCON_WAKE);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "play earcon failed: %s", esp_err_to_name(err));
+        }
+    }
     ESP_LOGI(TAG, "speaker selftest done");
     vTaskDelete(NULL);
 }
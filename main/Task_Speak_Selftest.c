@@ -1,7 +1,6 @@
 #include "Task_Speak_Selftest.h"
 
 #include <string.h>
-#include <math.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -10,6 +9,8 @@
 #include "esp_heap_caps.h"
 #include "esp_log.h"
 
+#include "App_Agc.h"
+#include "App_PcmOps.h"
 #include "App_Speak_Sound.h"
 
 static const char *TAG = "Task_Speak_Selftest";
@@ -62,15 +63,7 @@ static void task_entry(void *arg)
         int16_t *p16 = (int16_t *)buf;
         size_t samples = got / sizeof(int16_t);
         size_t n = samples > 4000 ? 4000 : samples;
-        int64_t sum_sq = 0;
-        for (size_t i = 0; i < n; ++i) {
-            int32_t v = p16[i];
-            sum_sq += (int64_t)v * v;
-        }
-        float rms = 0.0f;
-        if (n > 0) {
-            rms = sqrtf((float)sum_sq / (float)n);
-        }
+        const float rms = app_pcm_rms(p16, (int)n);
         ESP_LOGI(TAG, "record stats: samples=%u rms=%.1f first8=[%d,%d,%d,%d,%d,%d,%d,%d]",
                  (unsigned)samples, rms,
                  samples > 0 ? p16[0] : 0,
@@ -82,13 +75,16 @@ static void task_entry(void *arg)
                  samples > 6 ? p16[6] : 0,
                  samples > 7 ? p16[7] : 0);
 
-        // 软件增益（x10，限幅）让回放更接近日常听感；如有明显爆音再调小
-        const int gain = 10;
-        for (size_t i = 0; i < samples; ++i) {
-            int32_t v = (int32_t)p16[i] * gain;
-            if (v > INT16_MAX) v = INT16_MAX;
-            if (v < INT16_MIN) v = INT16_MIN;
-            p16[i] = (int16_t)v;
+        // AGC 代替固定 x10：按语音电平放大到 -20 dBFS，限幅防爆音（录音已结束，不联动 codec 增益）
+        app_agc_t agc;
+        app_agc_cfg_t gcfg = app_agc_cfg_default(cfg.sample_rate);
+        if (app_agc_init(&agc, &gcfg) == ESP_OK) {
+            app_agc_process(&agc, p16, (int)samples);
+            app_agc_stats_t gs;
+            app_agc_get_stats(&agc, &gs);
+            ESP_LOGI(TAG, "agc: gain=%.1f dB level=%.0f dBFS limiter=%u clips=%u, rms after=%.1f",
+                     (double)gs.gain_db, (double)gs.level_dbfs, (unsigned)gs.limiter_hits, (unsigned)gs.in_clips,
+                     app_pcm_rms(p16, (int)samples));
         }
     }
 
@@ -13,6 +13,7 @@
 
 #include "protocol_examples_common.h"
 
+#include "App_EventCache.h"
 #include "App_RobotBrainV3.h"
 #include "App_Speak_Sound.h"
 
@@ -55,22 +56,56 @@ static void task_entry(void *arg)
     cfg.mode = "stream";
     cfg.chunk_bytes = 500;
 
-    app_rb3_meta_t meta = {0};
-    play_ctx_t pc = {0};
-
-    ESP_LOGI(TAG, "request event=idle ...");
-    esp_err_t err = app_rb3_http_event_stream(&cfg,
-                                              "idle",
-                                              "r_selftest",
-                                              "demo",
-                                              &meta,
-                                              on_audio_pcm,
-                                              &pc);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "v3 http event failed: %s", esp_err_to_name(err));
+    // 事件回复缓存：第二次起直接从 storage 分区回放，后台再校验版本
+    esp_err_t err_cache = app_event_cache_init(NULL);
+    if (err_cache != ESP_OK) {
+        ESP_LOGW(TAG, "event cache init failed: %s（直接走网络）", esp_err_to_name(err_cache));
+    }
+
+    // 事件走 WS 长连接（与语音共用一条连接，按 req 分流）；打不开就走 HTTP
+    app_rb3_ws_sess_t *ws = NULL;
+    if (app_rb3_ws_open(&cfg, &ws) == ESP_OK) {
+        app_event_cache_set_ws_session(ws);
     } else {
-        ESP_LOGI(TAG, "text=%s anim=%s motion=%s af=%s req=%s rid=%s",
-                 meta.text, meta.anim, meta.motion, meta.af, meta.req, meta.rid);
+        ESP_LOGW(TAG, "ws open failed, events via http");
+    }
+
+    for (int round = 0; round < 2; ++round) {
+        app_rb3_meta_t meta = {0};
+        play_ctx_t pc = {0};
+
+        ESP_LOGI(TAG, "request event=idle (round %d) ...", round);
+        esp_err_t err = app_event_cache_event_stream(&cfg,
+                                                     "idle",
+                                                     "r_selftest",
+                                                     "demo",
+                                                     &meta,
+                                                     on_audio_pcm,
+                                                     &pc);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "v3 http event failed: %s", esp_err_to_name(err));
+        } else {
+            ESP_LOGI(TAG, "text=%s anim=%s motion=%s af=%s req=%s rid=%s ver=%s",
+                     meta.text, meta.anim, meta.motion, meta.af, meta.req, meta.rid, meta.ver);
+        }
+    }
+
+    app_event_cache_stats_t cst;
+    app_event_cache_get_stats(&cst);
+    ESP_LOGI(TAG, "event cache: hit=%u miss=%u first_ms(hit/miss)=%u/%u entries=%u used=%u "
+                  "reval=%u (not modified %u, %u bytes)",
+             (unsigned)cst.hits, (unsigned)cst.misses, (unsigned)cst.hit_first_ms_avg,
+             (unsigned)cst.miss_first_ms_avg, (unsigned)cst.entries, (unsigned)cst.used_bytes,
+             (unsigned)cst.revalidations, (unsigned)cst.not_modified, (unsigned)cst.reval_bytes);
+
+    if (ws) {
+        app_rb3_ws_stats_t wst;
+        app_rb3_ws_get_stats(ws, &wst);
+        ESP_LOGI(TAG, "ws mux: active=%u dups=%u reorders=%u gaps=%u stale=%u unrouted=%u",
+                 (unsigned)wst.req_active, (unsigned)wst.seq_dups, (unsigned)wst.seq_reorders,
+                 (unsigned)wst.seq_gaps, (unsigned)wst.stale_msgs_dropped, (unsigned)wst.rx_unrouted);
+        app_event_cache_set_ws_session(NULL);
+        app_rb3_ws_close(ws);
     }
 
     vTaskDelete(NULL);
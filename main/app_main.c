@@ -21,7 +21,9 @@
 #include "rsa_sign_alt.h"
 #include "esp_secure_cert_read.h"
 
+#include "App_AssetPack.h"
 #include "App_Speak_Sound.h"
+#include "Task_Dsp_Selftest.h"
 #include "Task_Sound_Selftest.h"
 #include "Task_Speak_Selftest.h"
 #include "Task_v3interface_selftest.h"
@@ -29,6 +31,11 @@
 
 static const char *TAG = "gdBB_main";
 
+// 候选服务端：后台按 /health 的 RTT/错误率挑最近的健康端点，断线自动换
+static const char *const s_rb3_endpoints[] = {
+    "http://192.168.31.193:8443",
+};
+
 static void security_ds_sanity_check(void)
 {
     // DS ctx 由 esp_secure_cert_mgr 管理，不要 free
@@ -71,6 +78,12 @@ void app_main(void)
     };
     ESP_ERROR_CHECK(app_speak_sound_init(&cfg));
 
+    // 资源包（提示音/垫音/模型），没烧也能跑，只是没有本地音效
+    esp_err_t err = app_asset_pack_open("model");
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "asset pack unavailable: %s", esp_err_to_name(err));
+    }
+
     // 扬声器测试音
     ESP_ERROR_CHECK(task_sound_selftest_start());
     vTaskDelay(pdMS_TO_TICKS(1200));
@@ -81,9 +94,14 @@ void app_main(void)
     // 麦克风自检：录 5 秒并回放（验证 RX->TX）
     // ESP_ERROR_CHECK(task_speak_selftest_start());
 
+    // DSP 基准（ADPCM 等编解码吞吐与质量），需要时打开
+    // ESP_ERROR_CHECK(task_dsp_selftest_start());
+
     // 连续语音助手（当前：WS 逻辑先用日志模拟，不做真实连接/发送）
     task_chat_continue_cfg_t chat_cfg = {
         .base_url = "http://192.168.31.193:8443",
+        .endpoints = s_rb3_endpoints,
+        .endpoint_count = sizeof(s_rb3_endpoints) / sizeof(s_rb3_endpoints[0]),
         .user_id = "demo",
         .language = "zh-CN",
         .frame_ms = 20,
@@ -94,6 +112,29 @@ void app_main(void)
         .th_min = 200.0f,
         .spk_chunk_bytes = 512,
         .max_record_ms = 15000,
+        .uplink_min_chunk_bytes = 2048,
+        .uplink_max_chunk_bytes = 16384,
+        .uplink_target_send_ms = 40,
+        .uplink_max_lag_ms = 4000,
+        .first_audio_budget_ms = 1200,
+        .filler_xfade_ms = 60,
+        // 历史默认 5s 原始 PCM（零拷贝上行、无损）；连接慢、常需长追帧的现场可改
+        // preroll_history_ms = 20000 + preroll_adpcm = true（约同样内存，4bit 有损）
+        // 采集前端：本板单麦，波束不生效
+        .mic_beamform = false,
+        // 降噪会压低底噪与 VAD 电平，打开前按现场重调 th_min
+        .mic_noise_suppress = false,
+        .mic_agc = false,
+        .mic_agc_coarse = false,
     };
+#ifdef CONFIG_VOICE_WAKEUP_MODE
+    // 唤醒词模型在资源包里（APP_ASSET_ID_KWS_MODEL，tools/mkkwsmodel.py 生成）
+    chat_cfg.wake_word = true;
+#endif
+#ifdef CONFIG_KEY_PRESS_DIALOG_MODE
+    // 按住 BOOT 键说话；ptt_gpio 改成 -1 用模拟按键测延迟
+    chat_cfg.push_to_talk = true;
+    chat_cfg.ptt_gpio = 0;
+#endif
     ESP_ERROR_CHECK(task_chat_continue_start(&chat_cfg));
 }
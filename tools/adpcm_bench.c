@@ -0,0 +1,133 @@
+// App_Adpcm 主机基准：编解码吞吐、几类信号上的 SNR、单块随机访问与顺序解码逐位一致
+//   cc -O2 -Imain -Itools/host tools/adpcm_bench.c main/App_Adpcm.c main/App_TestSig.c main/App_PcmOps.c -lm -o build/adpcm_bench && build/adpcm_bench
+// 目标板上的 us / 实时倍数见 Task_Dsp_Selftest。
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "App_Adpcm.h"
+#include "App_TestSig.h"
+
+#define SR 24000
+#define BLOCKS ((SR * 20) / APP_ADPCM_BLOCK_SAMPLES) // 约 20s，与 app_main 的历史长度一致
+#define N (BLOCKS * APP_ADPCM_BLOCK_SAMPLES)
+
+static int16_t s_x[N];
+static int16_t s_y[N];
+static uint8_t s_e[BLOCKS * APP_ADPCM_BLOCK_BYTES];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int16_t clip16(double v)
+{
+    return (int16_t)(v > 32767.0 ? 32767 : (v < -32768.0 ? -32768 : lrint(v)));
+}
+
+// 0：app_tsig_tones，与 Task_Dsp_Selftest 同一测试信号（300 Hz + 1.7 kHz + 噪声）
+// 1：类语音：120~240 Hz 基频滑动的谐波串，4 Hz 音节包络
+// 2：100 Hz~10 kHz 扫频（ADPCM 对高频突变最吃力）
+// 3：-40 dBFS 低电平噪声（安静房间底噪）
+static void gen(int kind, int16_t *x, int n)
+{
+    if (kind == 0) {
+        app_tsig_tones(x, n, SR);
+        return;
+    }
+    uint32_t lfsr = 0x12345678u;
+    double ph = 0;
+    for (int i = 0; i < n; ++i) {
+        app_tsig_lcg(&lfsr);
+        const double t = (double)i / SR;
+        const double noise = (double)((int32_t)(lfsr >> 22) - 512);
+        double v = 0;
+        switch (kind) {
+        case 1: {
+            const double f0 = 180.0 + 60.0 * sin(2 * M_PI * 0.7 * t);
+            ph += 2 * M_PI * f0 / SR;
+            const double env = 0.5 + 0.5 * sin(2 * M_PI * 4.0 * t);
+            for (int h = 1; h <= 20; ++h) v += sin(h * ph) / h;
+            v = 8000.0 * env * v + noise * 0.5;
+            break;
+        }
+        case 2: {
+            const double f = 100.0 * pow(100.0, fmod(t, 2.0) / 2.0);
+            ph += 2 * M_PI * f / SR;
+            v = 10000.0 * sin(ph);
+            break;
+        }
+        default:
+            v = noise * 0.64; // 约 330 rms ≈ -40 dBFS
+            break;
+        }
+        x[i] = clip16(v);
+    }
+}
+
+static void encode_all(void)
+{
+    app_adpcm_enc_t enc = {0};
+    for (int b = 0; b < BLOCKS; ++b) {
+        app_adpcm_encode_block(&enc, s_x + b * APP_ADPCM_BLOCK_SAMPLES, s_e + b * APP_ADPCM_BLOCK_BYTES);
+    }
+}
+
+static void decode_all(void)
+{
+    for (int b = 0; b < BLOCKS; ++b) {
+        app_adpcm_decode_block(s_e + b * APP_ADPCM_BLOCK_BYTES, s_y + b * APP_ADPCM_BLOCK_SAMPLES);
+    }
+}
+
+int main(void)
+{
+    static const char *const names[] = {"tones+noise", "voiced", "sweep", "-40 dBFS noise"};
+    // 门限：测试信号与类语音须 >= 20 dB（与板上自检一致）；扫频、底噪只报告
+    static const double min_snr[] = {20.0, 20.0, 0.0, 0.0};
+    int fail = 0;
+
+    printf("ratio %.2f:1, %d blocks (%.1f s @ %d Hz)\n", (double)APP_ADPCM_BLOCK_PCM_BYTES / APP_ADPCM_BLOCK_BYTES,
+           BLOCKS, (double)N / SR, SR);
+    for (int k = 0; k < 4; ++k) {
+        gen(k, s_x, N);
+        encode_all();
+        decode_all();
+        const double snr = app_tsig_snr_db(s_x, s_y, N);
+        printf("%-16s SNR %5.1f dB%s\n", names[k], snr, (snr < min_snr[k]) ? "  FAIL" : "");
+        fail |= snr < min_snr[k];
+    }
+
+    // 随机访问：任意一块单独解码须与顺序解码一致（环形缓冲读指针依赖这一点）
+    gen(1, s_x, N);
+    encode_all();
+    decode_all();
+    int ra_bad = 0;
+    int16_t one[APP_ADPCM_BLOCK_SAMPLES];
+    for (int b = BLOCKS - 1; b >= 0; b -= 7) {
+        app_adpcm_decode_block(s_e + b * APP_ADPCM_BLOCK_BYTES, one);
+        ra_bad += memcmp(one, s_y + b * APP_ADPCM_BLOCK_SAMPLES, sizeof(one)) != 0;
+    }
+    printf("random access: %s\n", ra_bad ? "MISMATCH" : "ok");
+    fail |= ra_bad != 0;
+
+    // 吞吐
+    const int reps = 20;
+    double t0 = now_ns();
+    for (int r = 0; r < reps; ++r) encode_all();
+    double t1 = now_ns();
+    for (int r = 0; r < reps; ++r) decode_all();
+    double t2 = now_ns();
+    const double samples = (double)N * reps;
+    printf("encode %.2f ns/sample (%.0fx realtime), decode %.2f ns/sample (%.0fx realtime)\n", (t1 - t0) / samples,
+           samples / SR * 1e9 / (t1 - t0), (t2 - t1) / samples, samples / SR * 1e9 / (t2 - t1));
+
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
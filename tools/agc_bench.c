@@ -0,0 +1,157 @@
+// App_Agc 主机测试：同一段合成语音按不同距离（电平）送入，报输出电平一致性、VAD 看到的电平、限幅，
+// 另加小声之后突然大声（限幅）和模拟 codec 粗调两个场景，并报每帧耗时
+//   cc -O2 -Imain -Itools/host tools/agc_bench.c main/App_Agc.c main/App_PcmOps.c main/App_Spec.c main/App_TestSig.c -lm -o build/agc_bench && build/agc_bench
+// 主机上 cycles 为纳秒（见 tools/host/esp_cpu.h）；目标板上的 cycles/frame 见 Task_Dsp_Selftest。
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "App_Agc.h"
+#include "App_PcmOps.h"
+#include "App_TestSig.h"
+
+#define SR 24000
+#define FRAME (SR / 50)
+#define SEG_FRAMES 150 // 1.5s 说 / 1.5s 停
+
+// ---------- 模拟 codec 输入增益 ----------
+
+static int s_codec_db;
+
+static esp_err_t fake_set_coarse(int db, void *ctx)
+{
+    (void)ctx;
+    s_codec_db = db;
+    return ESP_OK;
+}
+
+// ---------- 场景 ----------
+
+typedef struct {
+    double in_dbfs, out_dbfs; // 稳定后语音段 RMS；in 为基准 codec 增益下的输入
+    double vad_db;            // VAD 看到的电平相对输入
+    int32_t peak;
+    app_agc_stats_t st;
+} result_t;
+
+// late_amp > 0：6s 起每段开头加 100ms 硬起音方波（小声之后拍桌 / 关门，增益还在高位，看限幅）
+// coarse：打开粗调，codec 增益（相对基准）在下一帧作用到输入上，带削顶
+static bool scene_run(int speech_amp, int late_amp, bool coarse, int seconds, int meas_from, result_t *r)
+{
+    app_agc_t agc;
+    app_agc_cfg_t cfg = app_agc_cfg_default(SR);
+    if (coarse) {
+        s_codec_db = 0;
+        cfg.set_coarse = fake_set_coarse;
+        cfg.coarse_db = 0;
+        cfg.coarse_min_db = -12;
+        cfg.coarse_max_db = 24;
+    }
+    if (app_agc_init(&agc, &cfg) != ESP_OK) return false;
+
+    // 合成场景与 Task_Dsp_Selftest 相同（App_TestSig）
+    app_tsig_scene_t sc;
+    app_tsig_scene_init(&sc, SR, 0xa5a5u);
+    int16_t x[FRAME], noise[FRAME], base[FRAME];
+    double pi = 0, po = 0, ai = 0, av = 0;
+    int64_t cnt = 0;
+    r->peak = 0;
+    for (int f = 0; f < seconds * 50; ++f) {
+        app_tsig_speech(&sc, f, speech_amp, x);
+        if (late_amp > 0 && f >= 300 && (f % SEG_FRAMES) < 5) {
+            for (int i = 0; i < FRAME; ++i) x[i] = (int16_t)(((i / 12) & 1) ? late_amp : -late_amp);
+        }
+        app_tsig_room_noise(&sc, APP_TSIG_NOISE_FAN, f, 20, noise);
+        app_pcm_mix(x, noise, FRAME, 4096);
+        memcpy(base, x, sizeof(base));
+        if (coarse && s_codec_db != cfg.coarse_db) {
+            app_pcm_gain(x, x, FRAME, (int32_t)lrint(4096.0 * pow(10.0, (s_codec_db - cfg.coarse_db) / 20.0)));
+        }
+        // 只统计收敛后的说话段
+        const bool meas = f >= meas_from && (f % SEG_FRAMES) < SEG_FRAMES / 2;
+        if (meas) {
+            pi += (double)app_pcm_sum_sq(base, FRAME);
+            ai += (double)app_pcm_sum_abs(base, FRAME);
+        }
+        app_agc_process(&agc, x, FRAME);
+        if (meas) {
+            po += (double)app_pcm_sum_sq(x, FRAME);
+            av += (double)app_pcm_sum_abs(x, FRAME) * app_agc_vad_scale_q12(&agc) / 4096.0;
+            cnt += FRAME;
+        }
+        const int32_t pk = app_pcm_peak(x, FRAME);
+        if (pk > r->peak) r->peak = pk;
+    }
+    app_agc_get_stats(&agc, &r->st);
+    r->in_dbfs = 10.0 * log10(pi / (double)cnt / (32768.0 * 32768.0) + 1e-12);
+    r->out_dbfs = 10.0 * log10(po / (double)cnt / (32768.0 * 32768.0) + 1e-12);
+    r->vad_db = 20.0 * log10((av + 1.0) / (ai + 1.0));
+    return true;
+}
+
+int main(void)
+{
+    // 远场小声 -> 近讲；最后一档输入已削顶，只看限幅
+    static const int amps[] = {300, 1000, 3000, 9000, 30000};
+    const int n_level = 4;
+    const app_agc_cfg_t def = app_agc_cfg_default(SR);
+    const int32_t ceil = (int32_t)lrintf(32767.0f * powf(10.0f, def.limit_dbfs / 20.0f));
+    const double frame_ns = 20e6;
+    double in_min = 0, in_max = -200, out_min = 0, out_max = -200;
+    uint32_t cyc_avg = 0, cyc_max = 0;
+    int fail = 0;
+
+    for (size_t i = 0; i < sizeof(amps) / sizeof(amps[0]); ++i) {
+        result_t r;
+        if (!scene_run(amps[i], 0, false, 9, SEG_FRAMES, &r)) return 1;
+        int bad = r.peak > ceil;
+        if ((int)i < n_level) {
+            if (r.in_dbfs < in_min) in_min = r.in_dbfs;
+            if (r.in_dbfs > in_max) in_max = r.in_dbfs;
+            if (r.out_dbfs < out_min) out_min = r.out_dbfs;
+            if (r.out_dbfs > out_max) out_max = r.out_dbfs;
+            // VAD 看到的放大不超过 vad_credit_db，衰减被补回
+            bad |= r.vad_db < -0.5 || r.vad_db > def.vad_credit_db + 0.5;
+        }
+        if (r.st.cycles_avg > cyc_avg) cyc_avg = r.st.cycles_avg;
+        if (r.st.cycles_max > cyc_max) cyc_max = r.st.cycles_max;
+        printf("amp %5d: speech %6.1f -> %6.1f dBFS, gain %5.1f dB, peak %5d, limiter %4u, clips %4u, vad %+.1f dB%s\n",
+               amps[i], r.in_dbfs, r.out_dbfs, (double)r.st.gain_db, (int)r.peak, (unsigned)r.st.limiter_hits,
+               (unsigned)r.st.in_clips, r.vad_db, bad ? "  FAIL" : "");
+        fail |= bad;
+    }
+
+    result_t r;
+    if (!scene_run(amps[0], 30000, false, 9, SEG_FRAMES, &r)) return 1;
+    int bad = r.peak > ceil || r.st.limiter_hits == 0;
+    printf("quiet -> slam: peak %d (ceil %d), limiter %u, gain %.1f dB%s\n", (int)r.peak, (int)ceil,
+           (unsigned)r.st.limiter_hits, (double)r.st.gain_db, bad ? "  FAIL" : "");
+    fail |= bad;
+
+    // 很远的小声：数字增益顶到上限附近，codec 应升档；总增益换档不跳变，VAD 仍以基准增益折算
+    if (!scene_run(150, 0, true, 21, 12 * 50, &r)) return 1;
+    bad = r.st.coarse_ups == 0 || r.st.coarse_downs != 0 || r.out_dbfs < out_min - 3.0 || r.peak > ceil ||
+          r.vad_db < -0.5 || r.vad_db > def.vad_credit_db + 0.5;
+    printf("far field + codec: speech %6.1f -> %6.1f dBFS, codec %+d dB (%u up, %u down), gain %.1f dB, "
+           "vad %+.1f dB%s\n",
+           r.in_dbfs, r.out_dbfs, r.st.coarse_db, (unsigned)r.st.coarse_ups, (unsigned)r.st.coarse_downs,
+           (double)r.st.gain_db, r.vad_db, bad ? "  FAIL" : "");
+    fail |= bad;
+
+    // 近讲削顶：codec 应降档
+    if (!scene_run(30000, 0, true, 21, 12 * 50, &r)) return 1;
+    bad = r.st.coarse_downs == 0 || r.peak > ceil;
+    printf("near field + codec: codec %+d dB (%u down), clips %u, out %.1f dBFS%s\n", r.st.coarse_db,
+           (unsigned)r.st.coarse_downs, (unsigned)r.st.in_clips, r.out_dbfs, bad ? "  FAIL" : "");
+    fail |= bad;
+
+    bad = out_max - out_min > 3.0;
+    printf("speech spread %.1f dB in -> %.1f dB out, %u ns/frame avg %u max (%.3f%% of a core)%s\n", in_max - in_min,
+           out_max - out_min, (unsigned)cyc_avg, (unsigned)cyc_max, 100.0 * cyc_avg / frame_ns, bad ? "  FAIL" : "");
+    fail |= bad;
+
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
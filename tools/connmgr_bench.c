@@ -0,0 +1,552 @@
+// App_Rb3ConnMgr 主机测试：真实的 App_Rb3ConnMgr.c（FreeRTOS 用 pthread 替身）连本机 rb3_standin_server.py，
+// 按场景打开替身的“不稳定网络”开关，用 Task_Chat_Continue 的唤醒流程量 唤醒->首个上行分片 的延迟
+//   cc -O2 -pthread -Imain -Itools/host tools/connmgr_bench.c main/App_Rb3ConnMgr.c -o build/connmgr_bench && build/connmgr_bench
+//   build/connmgr_bench [每个场景的唤醒次数，默认 20] [-v]
+// WS 会话是替身：POSIX socket 上的最小客户端，按 IDF websocket client 的语义每 ping_interval 发 ping、
+// pong 超时即断开；连接管理器的配置（退避、心跳、判死）与设备相同。-v 打出连接管理器日志。
+// 延迟不含 Wi-Fi；目标板上的实测见 chat 延迟统计（wake_uplink_ms_*）。
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "App_Rb3ConnMgr.h"
+#include "App_TestSig.h"
+#include "esp_random.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+extern char **environ;
+
+#define PORT 18600
+#define WAKE_CONNECT_WAIT_MS 8000 // 同 Task_Chat_Continue 的 wake_connect_wait_ms
+#define NET_TICK_MS 20            // task_net 非唤醒态的节拍
+#define REPLY_WAIT_MS 6000
+#define MAX_WAKES 256
+
+// ---------------- 替身：时间、随机数 ----------------
+
+static struct timespec s_t0;
+
+static uint32_t host_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((ts.tv_sec - s_t0.tv_sec) * 1000 + (ts.tv_nsec - s_t0.tv_nsec) / 1000000);
+}
+
+static void sleep_ms(uint32_t ms)
+{
+    struct timespec ts = {.tv_sec = ms / 1000, .tv_nsec = (long)(ms % 1000) * 1000000};
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return host_ms();
+}
+
+static pthread_mutex_t s_rand_mu = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t s_rand = 0x2545f491u;
+
+uint32_t esp_random(void)
+{
+    pthread_mutex_lock(&s_rand_mu);
+    const uint32_t r = app_tsig_lcg(&s_rand);
+    pthread_mutex_unlock(&s_rand_mu);
+    return r;
+}
+
+// ---------------- 替身：FreeRTOS（任务 = pthread，通知 = 计数 + 条件变量） ----------------
+
+struct tskTaskControlBlock {
+    pthread_t th;
+    pthread_mutex_t mu;
+    pthread_cond_t cv;
+    uint32_t notify;
+    TaskFunction_t fn;
+    void *arg;
+};
+
+static __thread struct tskTaskControlBlock *s_self;
+
+static void *task_trampoline(void *p)
+{
+    struct tskTaskControlBlock *t = (struct tskTaskControlBlock *)p;
+    s_self = t;
+    t->fn(t->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t prio,
+                       TaskHandle_t *out)
+{
+    (void)name;
+    (void)stack;
+    (void)prio;
+    struct tskTaskControlBlock *t = (struct tskTaskControlBlock *)calloc(1, sizeof(*t));
+    if (!t) return pdFAIL;
+    pthread_mutex_init(&t->mu, NULL);
+    pthread_cond_init(&t->cv, NULL);
+    t->fn = fn;
+    t->arg = arg;
+    if (out) *out = t;
+    if (pthread_create(&t->th, NULL, task_trampoline, t) != 0) {
+        free(t);
+        return pdFAIL;
+    }
+    pthread_detach(t->th);
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    // 只支持删除自己（连接管理器任务退出时）；控制块不回收，调用方可能还持有句柄
+    if (task == NULL || task == s_self) pthread_exit(NULL);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    sleep_ms(ticks * portTICK_PERIOD_MS);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return host_ms() / portTICK_PERIOD_MS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    struct tskTaskControlBlock *t = s_self;
+    struct timespec dl;
+    clock_gettime(CLOCK_REALTIME, &dl);
+    const uint64_t ns = (uint64_t)dl.tv_nsec + (uint64_t)ticks * portTICK_PERIOD_MS * 1000000u;
+    dl.tv_sec += (time_t)(ns / 1000000000u);
+    dl.tv_nsec = (long)(ns % 1000000000u);
+    pthread_mutex_lock(&t->mu);
+    while (t->notify == 0) {
+        if (pthread_cond_timedwait(&t->cv, &t->mu, &dl) == ETIMEDOUT) break;
+    }
+    const uint32_t v = t->notify;
+    if (v) t->notify = clear_on_exit ? 0 : v - 1;
+    pthread_mutex_unlock(&t->mu);
+    return v;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->mu);
+    task->notify++;
+    pthread_cond_signal(&task->cv);
+    pthread_mutex_unlock(&task->mu);
+    return pdPASS;
+}
+
+struct QueueDefinition {
+    pthread_mutex_t mu;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t s = (SemaphoreHandle_t)calloc(1, sizeof(*s));
+    if (s) pthread_mutex_init(&s->mu, NULL);
+    return s;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    (void)ticks; // 连接管理器只用 portMAX_DELAY
+    pthread_mutex_lock(&sem->mu);
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    pthread_mutex_unlock(&sem->mu);
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    pthread_mutex_destroy(&sem->mu);
+    free(sem);
+}
+
+// ---------------- 替身：WS 会话（连接管理器用到的 5 个接口 + 本测试的发送） ----------------
+
+enum { WS_CONNECTING = 0, WS_CONNECTED, WS_CLOSED };
+
+struct app_rb3_ws_sess_t {
+    int fd;
+    pthread_t th;
+    pthread_mutex_t tx_mu;
+    volatile int state;
+    volatile bool stop;
+    volatile uint32_t last_rx_ms;
+    volatile int replies; // 收到的 is_last audio 条数
+    int port;
+    int ping_ms;
+    int pong_ms;
+};
+
+static volatile int s_broken_marks;
+
+static int ws_send_frame(app_rb3_ws_sess_t *s, int op, const void *data, size_t len)
+{
+    uint8_t h[14];
+    size_t hn = 0;
+    h[hn++] = (uint8_t)(0x80 | op);
+    if (len < 126) {
+        h[hn++] = (uint8_t)(0x80 | len);
+    } else {
+        h[hn++] = 0x80 | 126;
+        h[hn++] = (uint8_t)(len >> 8);
+        h[hn++] = (uint8_t)len;
+    }
+    memset(h + hn, 0, 4); // 掩码取 0：载荷不用改写
+    hn += 4;
+    pthread_mutex_lock(&s->tx_mu);
+    int ok = send(s->fd, h, hn, MSG_NOSIGNAL) == (ssize_t)hn &&
+             (len == 0 || send(s->fd, data, len, MSG_NOSIGNAL) == (ssize_t)len);
+    pthread_mutex_unlock(&s->tx_mu);
+    return ok ? 0 : -1;
+}
+
+static int read_full(int fd, void *buf, size_t n)
+{
+    size_t got = 0;
+    while (got < n) {
+        ssize_t r = recv(fd, (char *)buf + got, n - got, 0);
+        if (r <= 0) return -1;
+        got += (size_t)r;
+    }
+    return 0;
+}
+
+static void *ws_thread(void *p)
+{
+    app_rb3_ws_sess_t *s = (app_rb3_ws_sess_t *)p;
+    struct sockaddr_in a = {.sin_family = AF_INET, .sin_port = htons((uint16_t)s->port)};
+    inet_pton(AF_INET, "127.0.0.1", &a.sin_addr);
+    if (connect(s->fd, (struct sockaddr *)&a, sizeof(a)) != 0) goto out;
+
+    static const char req[] = "GET /v3/robot/voice HTTP/1.1\r\nHost: 127.0.0.1\r\nUpgrade: websocket\r\n"
+                              "Connection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                              "Sec-WebSocket-Version: 13\r\n\r\n";
+    if (send(s->fd, req, sizeof(req) - 1, MSG_NOSIGNAL) != (ssize_t)sizeof(req) - 1) goto out;
+    char head[512];
+    size_t hn = 0;
+    while (hn < sizeof(head) - 1 && (hn < 4 || memcmp(head + hn - 4, "\r\n\r\n", 4) != 0)) {
+        if (recv(s->fd, head + hn, 1, 0) != 1) goto out; // 替身拒绝握手：直接断开
+        hn++;
+    }
+    head[hn] = '\0';
+    if (!strstr(head, " 101 ")) goto out;
+    s->last_rx_ms = host_ms();
+    s->state = WS_CONNECTED;
+
+    uint32_t next_ping = host_ms() + (uint32_t)s->ping_ms, pong_due = 0;
+    char *msg = NULL;
+    while (!s->stop) {
+        const uint32_t now = host_ms();
+        if ((int32_t)(now - next_ping) >= 0) {
+            if (ws_send_frame(s, 0x9, NULL, 0) != 0) break;
+            if (!pong_due) pong_due = now + (uint32_t)s->pong_ms;
+            next_ping = now + (uint32_t)s->ping_ms;
+        }
+        if (pong_due && (int32_t)(now - pong_due) >= 0) break; // 同 IDF：pong 超时即断开
+        struct pollfd pf = {.fd = s->fd, .events = POLLIN};
+        if (poll(&pf, 1, 20) <= 0) continue;
+
+        uint8_t h[2];
+        if (read_full(s->fd, h, 2) != 0) break;
+        uint64_t n = h[1] & 0x7F;
+        if (n == 126 || n == 127) {
+            uint8_t e[8];
+            const size_t en = n == 126 ? 2 : 8;
+            if (read_full(s->fd, e, en) != 0) break;
+            n = 0;
+            for (size_t i = 0; i < en; ++i) n = (n << 8) | e[i];
+        }
+        msg = (char *)realloc(msg, (size_t)n + 1);
+        if (read_full(s->fd, msg, (size_t)n) != 0) break;
+        msg[n] = '\0';
+        s->last_rx_ms = host_ms();
+        const int op = h[0] & 0x0F;
+        if (op == 0xA) pong_due = 0;
+        if (op == 0x8) break;
+        if (op == 0x1 && strstr(msg, "\"is_last\": true")) s->replies++;
+    }
+    free(msg);
+out:
+    s->state = WS_CLOSED;
+    return NULL;
+}
+
+esp_err_t app_rb3_ws_open_nowait(const app_rb3_cfg_t *cfg, app_rb3_ws_sess_t **out_sess)
+{
+    const char *colon = strrchr(cfg->base_url, ':');
+    app_rb3_ws_sess_t *s = (app_rb3_ws_sess_t *)calloc(1, sizeof(*s));
+    if (!s || !colon) return ESP_ERR_NO_MEM;
+    s->port = atoi(colon + 1);
+    s->ping_ms = cfg->ping_interval_ms > 0 ? cfg->ping_interval_ms : 10000;
+    s->pong_ms = cfg->pong_timeout_ms > 0 ? cfg->pong_timeout_ms : 4000;
+    s->fd = socket(AF_INET, SOCK_STREAM, 0);
+    pthread_mutex_init(&s->tx_mu, NULL);
+    if (s->fd < 0 || pthread_create(&s->th, NULL, ws_thread, s) != 0) {
+        if (s->fd >= 0) close(s->fd);
+        free(s);
+        return ESP_FAIL;
+    }
+    *out_sess = s;
+    return ESP_OK;
+}
+
+bool app_rb3_ws_is_connected(app_rb3_ws_sess_t *sess)
+{
+    return sess && sess->state == WS_CONNECTED;
+}
+
+bool app_rb3_ws_has_ended(app_rb3_ws_sess_t *sess)
+{
+    return !sess || sess->state == WS_CLOSED;
+}
+
+void app_rb3_ws_mark_broken(app_rb3_ws_sess_t *sess)
+{
+    (void)sess;
+    s_broken_marks++;
+}
+
+uint32_t app_rb3_ws_rx_idle_ms(app_rb3_ws_sess_t *sess)
+{
+    return app_rb3_ws_is_connected(sess) ? host_ms() - sess->last_rx_ms : 0;
+}
+
+void app_rb3_ws_close(app_rb3_ws_sess_t *sess)
+{
+    if (!sess) return;
+    sess->stop = true;
+    shutdown(sess->fd, SHUT_RDWR);
+    pthread_join(sess->th, NULL);
+    close(sess->fd);
+    pthread_mutex_destroy(&sess->tx_mu);
+    free(sess);
+}
+
+static int ws_send_text(app_rb3_ws_sess_t *s, const char *text)
+{
+    return app_rb3_ws_is_connected(s) ? ws_send_frame(s, 0x1, text, strlen(text)) : -1;
+}
+
+// ---------------- 替身服务端进程 ----------------
+
+static pid_t standin_start(const char *const *knobs)
+{
+    char port[16];
+    snprintf(port, sizeof(port), "%d", PORT);
+    const char *argv[32] = {"python3", "tools/rb3_standin_server.py", "--port", port, "--reply-scale", "0.25",
+                            "--seed", "7"};
+    int n = 8;
+    for (int i = 0; knobs[i] && n < 30; ++i) argv[n++] = knobs[i];
+    argv[n] = NULL;
+    posix_spawn_file_actions_t fa;
+    posix_spawn_file_actions_init(&fa);
+    posix_spawn_file_actions_addopen(&fa, 1, "/dev/null", 1, 0); // O_WRONLY
+    posix_spawn_file_actions_addopen(&fa, 2, "/dev/null", 1, 0);
+    pid_t pid = -1;
+    if (posix_spawnp(&pid, "python3", &fa, NULL, (char *const *)argv, environ) != 0) pid = -1;
+    posix_spawn_file_actions_destroy(&fa);
+    // 等端口开始监听（/health 不受拒绝握手影响，只看 TCP 能否连上）
+    for (int i = 0; pid > 0 && i < 100; ++i) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in a = {.sin_family = AF_INET, .sin_port = htons(PORT)};
+        inet_pton(AF_INET, "127.0.0.1", &a.sin_addr);
+        const int ok = connect(fd, (struct sockaddr *)&a, sizeof(a)) == 0;
+        close(fd);
+        if (ok) break;
+        sleep_ms(50);
+    }
+    return pid;
+}
+
+static void standin_stop(pid_t pid)
+{
+    if (pid <= 0) return;
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+}
+
+// ---------------- 唤醒流程（同 Task_Chat_Continue：不等待借用，未就绪则每拍重试，发送失败换连接重来） ----------------
+
+typedef struct {
+    const char *name;
+    const char *knobs[12];
+    bool standby;
+    bool lossy; // 黑洞场景：空闲时判死要等心跳超时，期间的轮次允许丢
+} scene_t;
+
+typedef struct {
+    uint32_t lat[MAX_WAKES];
+    int n, not_ready, gave_up, failovers, turns_ok;
+} result_t;
+
+static int cmp_u32(const void *a, const void *b)
+{
+    const uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void run_wakes(int wakes, result_t *r)
+{
+    static uint8_t pcm[3200]; // 100 ms 16k/16bit 静音
+    memset(r, 0, sizeof(*r));
+    for (int w = 0; w < wakes; ++w) {
+        sleep_ms(1000 + esp_random() % 3000); // 等待期（保持连接、不上传）
+
+        const uint32_t t0 = host_ms();
+        char start[96];
+        snprintf(start, sizeof(start), "{\"type\":\"start\",\"req\":\"r_chat_%d\",\"af\":\"pcm_24k_16bit\"}", w);
+        app_rb3_ws_sess_t *ws = app_rb3_connmgr_acquire(0);
+        if (!ws) r->not_ready++;
+        bool ok = false;
+        // 同 task_net：轮中断线（服务端掐连接时 start 恰好在路上）换连接整轮重发，最多 2 次
+        for (int attempt = 0; attempt <= 2 && !ok; ++attempt) {
+            bool sent = false;
+            while (!sent && host_ms() - t0 < WAKE_CONNECT_WAIT_MS) {
+                if (!ws) ws = app_rb3_connmgr_acquire(0);
+                if (!ws) {
+                    sleep_ms(NET_TICK_MS);
+                    continue;
+                }
+                if (ws_send_text(ws, start) == 0 && ws_send_frame(ws, 0x2, pcm, sizeof(pcm)) == 0) {
+                    sent = true;
+                } else {
+                    app_rb3_connmgr_release(ws, true);
+                    ws = NULL;
+                    app_rb3_connmgr_kick();
+                    r->failovers++;
+                }
+            }
+            if (!sent) {
+                r->gave_up++;
+                if (ws) app_rb3_connmgr_release(ws, false);
+                ws = NULL;
+                break;
+            }
+            if (attempt == 0) r->lat[r->n++] = host_ms() - t0;
+
+            // 本轮剩下的语音（0.5 s 实时）+ end，等回复收完
+            const int replies0 = ws->replies;
+            ok = true;
+            for (int i = 0; i < 4 && ok; ++i) {
+                sleep_ms(100);
+                ok = ws_send_frame(ws, 0x2, pcm, sizeof(pcm)) == 0;
+            }
+            ok = ok && ws_send_text(ws, "{\"type\":\"end\"}") == 0;
+            const uint32_t t1 = host_ms();
+            while (ok && ws->replies == replies0 && host_ms() - t1 < REPLY_WAIT_MS && app_rb3_ws_is_connected(ws)) {
+                sleep_ms(10);
+            }
+            ok = ok && ws->replies != replies0;
+            const bool dropped = !ok && !app_rb3_ws_is_connected(ws);
+            app_rb3_connmgr_release(ws, !ok);
+            ws = NULL;
+            if (!dropped) break; // 回复超时（黑洞）：不重发，等心跳判死
+            r->failovers++;
+            app_rb3_connmgr_kick();
+        }
+        r->turns_ok += ok;
+    }
+}
+
+static int run_scene(const scene_t *sc, int wakes)
+{
+    pid_t pid = standin_start(sc->knobs);
+    if (pid <= 0) {
+        printf("%-22s cannot start tools/rb3_standin_server.py  FAIL\n", sc->name);
+        return 1;
+    }
+    app_rb3_cfg_t rb3 = app_rb3_cfg_default("http://127.0.0.1:18600");
+    app_rb3_connmgr_cfg_t cm = app_rb3_connmgr_cfg_default();
+    cm.hot_standby = sc->standby;
+    s_broken_marks = 0;
+    app_rb3_connmgr_start(&rb3, &cm);
+
+    static result_t r;
+    run_wakes(wakes, &r);
+    app_rb3_connmgr_stats_t st;
+    app_rb3_connmgr_get_stats(&st);
+    app_rb3_connmgr_stop();
+    standin_stop(pid);
+
+    qsort(r.lat, (size_t)r.n, sizeof(r.lat[0]), cmp_u32);
+    uint64_t sum = 0;
+    for (int i = 0; i < r.n; ++i) sum += r.lat[i];
+    const uint32_t p50 = r.n ? r.lat[r.n / 2] : 0, p90 = r.n ? r.lat[(r.n * 9) / 10] : 0,
+                   mx = r.n ? r.lat[r.n - 1] : 0;
+    const int bad = r.gave_up > 0 || (!sc->lossy && r.turns_ok != wakes);
+    printf("%-22s wake->uplink avg %5u p50 %5u p90 %5u max %5u ms, not ready %2d/%d, gave up %d, failover %d, "
+           "turns ok %2d/%d | connects %u, fails %u, drops %u (heartbeat %u), standby %u%s\n",
+           sc->name, r.n ? (unsigned)(sum / (uint64_t)r.n) : 0u, (unsigned)p50, (unsigned)p90, (unsigned)mx,
+           r.not_ready, wakes, r.gave_up, r.failovers, r.turns_ok, wakes, (unsigned)st.connects,
+           (unsigned)st.connect_fails, (unsigned)st.drops, (unsigned)st.liveness_fails,
+           (unsigned)st.standby_promotions, bad ? "  FAIL" : "");
+    fflush(stdout);
+    return bad;
+}
+
+// 本测试不链接 App_RobotBrainV3.c：只需要默认配置
+app_rb3_cfg_t app_rb3_cfg_default(const char *base_url)
+{
+    app_rb3_cfg_t cfg = {.base_url = base_url};
+    return cfg;
+}
+
+int main(int argc, char **argv)
+{
+    int wakes = 20;
+    bool verbose = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
+        } else {
+            wakes = atoi(argv[i]);
+        }
+    }
+    if (wakes <= 0 || wakes > MAX_WAKES) wakes = 20;
+    if (!verbose && !freopen("/dev/null", "w", stderr)) return 1;
+    clock_gettime(CLOCK_MONOTONIC, &s_t0);
+
+    static const scene_t scenes[] = {
+        {.name = "clean", .knobs = {NULL}},
+        {.name = "idle drops 15%/s",
+         .knobs = {"--drop-idle-prob", "0.15", "--latency-ms", "40", "--jitter-ms", "20", NULL}},
+        {.name = "flaky",
+         .knobs = {"--refuse-prob", "0.5", "--accept-delay-ms", "300", "--drop-idle-prob", "0.15", "--latency-ms",
+                   "40", "--jitter-ms", "20", NULL}},
+        {.name = "flaky + standby",
+         .standby = true,
+         .knobs = {"--refuse-prob", "0.5", "--accept-delay-ms", "300", "--drop-idle-prob", "0.15", "--latency-ms",
+                   "40", "--jitter-ms", "20", NULL}},
+        {.name = "blackhole 5%/s",
+         .lossy = true,
+         .knobs = {"--blackhole-prob", "0.05", NULL}},
+    };
+    int fail = 0;
+    for (size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); ++i) fail |= run_scene(&scenes[i], wakes);
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
@@ -0,0 +1,6 @@
+// 主机替身：链接段属性在主机上无意义
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define EXT_RAM_BSS_ATTR
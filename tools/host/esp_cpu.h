@@ -0,0 +1,14 @@
+// 主机替身：周期计数用单调时钟的纳秒代替（配合 sdkconfig.h 替身的 1000 MHz），32 位回绕与芯片一致
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+#include "sdkconfig.h"
+
+static inline uint32_t esp_cpu_get_cycle_count(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
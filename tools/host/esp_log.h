@@ -0,0 +1,14 @@
+// 主机替身：日志打到 stderr，格式近似 IDF（级别 + TAG）
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define ESP_LOG_HOST_(lvl, tag, fmt, ...) fprintf(stderr, lvl " (%s) " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGE(tag, fmt, ...) ESP_LOG_HOST_("E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) ESP_LOG_HOST_("W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) ESP_LOG_HOST_("I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) do { (void)(tag); } while (0)
+#define ESP_LOGV(tag, fmt, ...) do { (void)(tag); } while (0)
+
+uint32_t esp_log_timestamp(void); // 只有声明：用到的测试程序自己实现（毫秒）
@@ -0,0 +1,6 @@
+// 主机替身：只有声明，由测试程序实现（见 tools/connmgr_bench.c）
+#pragma once
+
+#include <stdint.h>
+
+uint32_t esp_random(void);
@@ -0,0 +1,5 @@
+// 主机替身：只给 main/ 里算法模块用到的几个配置项。
+// 主频取 1000 MHz，与 esp_cpu.h 替身的“1 周期 = 1 ns”对应，模块里按主频换算的预算 / 负载照常可读
+#pragma once
+
+#define CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ 1000
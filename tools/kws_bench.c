@@ -0,0 +1,315 @@
+// App_Kws 主机回放：CPU 占用、检测延迟、每小时误唤醒
+//   cc -O2 -Imain -Itools/host tools/kws_bench.c main/App_Kws.c main/App_KwsDscnn.c main/App_Spec.c main/App_TestSig.c main/App_PcmOps.c -lm -o build/kws_bench
+//   build/kws_bench                                  合成 DS-CNN 测 CPU + 合成录音上的前端回放，有 PASS/FAIL
+//   build/kws_bench kws.bin [replay.wav labels.txt]  真实模型（tools/mkkwsmodel.py）测 CPU；给了录音再回放，只报告
+// labels.txt 每行一个唤醒词结束时刻（毫秒），与资源包 APP_ASSET_ID_KWS_LABELS 同义。
+// 主机上 cycles 为纳秒（见 tools/host/esp_cpu.h）；目标板上的数字见 Task_Dsp_Selftest。
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "App_Kws.h"
+#include "App_TestSig.h"
+
+// 回放：检测时刻与标注的唤醒词结束时刻匹配，窗口内算命中，其余算误唤醒（与 Task_Dsp_Selftest 相同）
+#define HIT_BEFORE_MS 300
+#define HIT_AFTER_MS 1500
+
+// ---------- 标定引擎：已知答案的“唤醒词”（1 kHz 音），用来校验前端的平滑 / 门限 / 不应期 / 触发位置 ----------
+
+#define TONE_T 30 // 300ms 特征窗
+
+typedef struct {
+    int band;                   // 唤醒音所在 mel 带（启动时用纯音标定）
+} tone_model_t;
+
+static esp_err_t tone_load(const void *model, size_t len, void **inst, app_kws_model_info_t *info)
+{
+    if (len != sizeof(tone_model_t)) return ESP_ERR_INVALID_SIZE;
+    *inst = (void *)model;
+    memset(info, 0, sizeof(*info));
+    info->in_t = TONE_T;
+    info->in_f = 40;
+    info->n_mel = 40;
+    info->feat = APP_KWS_FEAT_LOGMEL;
+    info->n_classes = 2;
+    info->wake_class = 1;
+    info->in_mult = 1 << 30; // Q8 log2 -> 半个 log2 单位（约 1.5 dB）一级，不饱和
+    info->in_shift = 8;
+    info->fmin_hz = 20;
+    info->fmax_hz = 4000;
+    info->smooth_ms = 200;
+    info->threshold_q15 = 19661;
+    return ESP_OK;
+}
+
+// 窗内峰值落在标定带 ±1、且比该帧均值高 6 dB 以上的帧占比
+static void tone_run(void *inst, const int8_t *in, float *prob)
+{
+    const tone_model_t *m = (const tone_model_t *)inst;
+    int on = 0;
+    for (int t = 0; t < TONE_T; ++t) {
+        const int8_t *r = in + t * 40;
+        int pk = 0, sum = 0;
+        for (int i = 0; i < 40; ++i) {
+            sum += r[i];
+            if (r[i] > r[pk]) pk = i;
+        }
+        on += (abs(pk - m->band) <= 1 && r[pk] * 40 - sum >= 4 * 40);
+    }
+    prob[1] = (float)on / TONE_T;
+    prob[0] = 1.0f - prob[1];
+}
+
+static void tone_unload(void *inst)
+{
+    (void)inst;
+}
+
+static const app_kws_engine_t s_tone_engine = {"tone", tone_load, tone_run, tone_unload};
+
+// ---------- 回放 ----------
+
+typedef struct {
+    int hits, n_lab, false_wakes;
+    int lat_avg, lat_max, lat_min;
+    double minutes, fw_per_hour;
+} replay_t;
+
+static void replay(app_kws_t *k, const int16_t *x, int n, int sr, const uint32_t *labels, int n_lab, replay_t *r)
+{
+    const int frame = sr / 50;
+    int64_t lat_sum = 0;
+    int next = 0; // 第一个尚未匹配的标注
+    memset(r, 0, sizeof(*r));
+    r->n_lab = n_lab;
+    r->lat_min = 1 << 30;
+    for (int off = 0; off + frame <= n; off += frame) {
+        int at = 0;
+        if (!app_kws_feed(k, x + off, frame, &at)) continue;
+        const int64_t t_ms = (int64_t)(off + at) * 1000 / sr;
+        while (next < n_lab && (int64_t)labels[next] + HIT_AFTER_MS < t_ms) next++;
+        if (next < n_lab && t_ms >= (int64_t)labels[next] - HIT_BEFORE_MS) {
+            const int lat = (int)(t_ms - (int64_t)labels[next]);
+            r->hits++;
+            lat_sum += lat;
+            if (lat > r->lat_max) r->lat_max = lat;
+            if (lat < r->lat_min) r->lat_min = lat;
+            next++;
+        } else {
+            r->false_wakes++;
+        }
+    }
+    if (!r->hits) r->lat_min = 0;
+    r->lat_avg = r->hits ? (int)(lat_sum / r->hits) : 0;
+    r->minutes = (double)n / sr / 60.0;
+    r->fw_per_hour = r->minutes > 0 ? r->false_wakes * 60.0 / r->minutes : 0.0;
+    printf("replay %.1f min: %d/%d keywords detected, latency avg %d ms (min %d, max %d), false wakes %d "
+           "(%.1f /hour)\n",
+           r->minutes, r->hits, n_lab, r->lat_avg, r->lat_min, r->lat_max, r->false_wakes, r->fw_per_hour);
+}
+
+static void add_tone(int16_t *x, int n, int sr, int at, int len, int hz, int amp)
+{
+    for (int i = 0; i < len && at + i < n; ++i) {
+        // 20ms 升降沿
+        const int edge = sr / 50;
+        double g = 1.0;
+        if (i < edge) g = (double)i / edge;
+        if (len - i < edge) g = (double)(len - i) / edge;
+        const int32_t v = x[at + i] + (int32_t)lrint(amp * g * sin(2.0 * M_PI * hz * i / sr));
+        x[at + i] = (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+    }
+}
+
+// 合成录音：底噪 + 每 6s 一个 500ms 1 kHz “唤醒词” + 其间 300 Hz / 2 kHz 干扰音与脉冲
+static int check_frontend(int sr)
+{
+    const int minutes = 10, n = sr * 60 * minutes;
+    int16_t *x = (int16_t *)malloc((size_t)n * sizeof(int16_t));
+    uint32_t *labels = (uint32_t *)malloc(sizeof(uint32_t) * 200);
+    if (!x || !labels) return 1;
+    uint32_t st = 0x1234u;
+    for (int i = 0; i < n; ++i) x[i] = app_tsig_noise(&st, 200);
+    int n_lab = 0;
+    for (int t_ms = 2000; t_ms + 6000 <= minutes * 60000; t_ms += 6000) {
+        const int kw = t_ms * (sr / 1000), kw_len = sr / 2;
+        add_tone(x, n, sr, kw, kw_len, 1000, 6000);
+        labels[n_lab++] = (uint32_t)(t_ms + 500);
+        add_tone(x, n, sr, kw + sr * 2, sr, 300, 8000);     // 1s 低频干扰
+        add_tone(x, n, sr, kw + sr * 7 / 2, sr / 2, 2000, 8000); // 500ms 高频干扰
+        add_tone(x, n, sr, kw + sr * 9 / 2, sr / 20, 1000, 9000); // 50ms 同频脉冲（短于平滑窗）
+    }
+
+    // 标定：纯 1 kHz 音的 logmel 峰值带
+    tone_model_t m = {0};
+    {
+        app_spec_pipe_t p;
+        app_spec_pipe_cfg_t pc = app_spec_pipe_cfg_default(sr);
+        pc.n_fft = 512;
+        pc.n_ceps = 0;
+        pc.fmin_hz = 20;
+        pc.fmax_hz = 4000;
+        int16_t t[512] = {0};
+        add_tone(t, 512, sr, 0, 512, 1000, 6000);
+        app_spec_feat_t f;
+        if (app_spec_pipe_init(&p, &pc) != ESP_OK) return 1;
+        app_spec_pipe_run(&p, t, &f);
+        for (int i = 1; i < pc.n_mel; ++i) {
+            if (f.logmel[i] > f.logmel[m.band]) m.band = i;
+        }
+        app_spec_pipe_deinit(&p);
+    }
+
+    app_kws_t k;
+    app_kws_cfg_t cfg = app_kws_cfg_default(sr);
+    cfg.engine = &s_tone_engine;
+    cfg.model = &m;
+    cfg.model_len = sizeof(m);
+    if (app_kws_init(&k, &cfg) != ESP_OK) return 1;
+    replay_t r;
+    replay(&k, x, n, sr, labels, n_lab, &r);
+    app_kws_deinit(&k);
+    free(x);
+    free(labels);
+    // 全部命中、无误唤醒；延迟：300ms 窗 × 0.6 门限 + 200ms 平滑，触发应在词尾前后几百毫秒内
+    const int fail = r.hits != r.n_lab || r.false_wakes != 0 || r.lat_max > 400 || r.lat_min < -300;
+    printf("frontend @ %d Hz (tone engine, band %d)%s\n", sr, m.band, fail ? "  FAIL" : "");
+    return fail;
+}
+
+// CPU：10s 测试信号
+static int check_cpu(const void *model, size_t len, const char *name, int sr, float *load)
+{
+    app_kws_t k;
+    app_kws_cfg_t cfg = app_kws_cfg_default(sr);
+    cfg.model = model;
+    cfg.model_len = len;
+    if (app_kws_init(&k, &cfg) != ESP_OK) {
+        printf("%s: model load failed  FAIL\n", name);
+        return 1;
+    }
+    const int frame = sr / 50;
+    int16_t *x = (int16_t *)malloc((size_t)frame * sizeof(int16_t));
+    uint32_t st = 0x777u;
+    for (int f = 0; f < 500; ++f) {
+        for (int i = 0; i < frame; ++i) {
+            x[i] = (int16_t)(6000.0 * sin(2.0 * M_PI * 300.0 * (f * frame + i) / sr) + app_tsig_noise(&st, 500));
+        }
+        (void)app_kws_feed(&k, x, frame, NULL);
+    }
+    free(x);
+    app_kws_stats_t s;
+    app_kws_get_stats(&k, &s);
+    app_kws_deinit(&k);
+    *load = s.load_pct;
+    printf("%s (%u bytes) @ %d Hz: feature %u ns/10ms, inference %u avg %u max ns every %d ms, %.2f%% of a core\n",
+           name, (unsigned)len, sr, (unsigned)s.feat_cycles_avg, (unsigned)s.infer_cycles_avg,
+           (unsigned)s.infer_cycles_max, cfg.infer_ms, (double)s.load_pct);
+    return 0;
+}
+
+static void *file_load(const char *path, size_t *len)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    fseek(fp, 0, SEEK_END);
+    long sz = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    void *p = (sz > 0) ? malloc((size_t)sz) : NULL;
+    if (p && fread(p, 1, (size_t)sz, fp) != (size_t)sz) {
+        free(p);
+        p = NULL;
+    }
+    fclose(fp);
+    *len = (size_t)sz;
+    return p;
+}
+
+// 最小 WAV 读取：PCM 16bit 单声道
+static int16_t *wav_load(const char *path, int *n, int *sr)
+{
+    size_t len = 0;
+    uint8_t *b = (uint8_t *)file_load(path, &len);
+    if (!b || len < 12 || memcmp(b, "RIFF", 4) != 0 || memcmp(b + 8, "WAVE", 4) != 0) {
+        free(b);
+        return NULL;
+    }
+    int ch = 0, bits = 0;
+    int16_t *data = NULL;
+    for (size_t off = 12; off + 8 <= len;) {
+        const uint32_t cl = (uint32_t)b[off + 4] | (uint32_t)b[off + 5] << 8 | (uint32_t)b[off + 6] << 16 |
+                            (uint32_t)b[off + 7] << 24;
+        const uint8_t *c = b + off + 8;
+        if (off + 8 + cl > len) break;
+        if (memcmp(b + off, "fmt ", 4) == 0 && cl >= 16) {
+            ch = c[2] | c[3] << 8;
+            *sr = (int)((uint32_t)c[4] | (uint32_t)c[5] << 8 | (uint32_t)c[6] << 16 | (uint32_t)c[7] << 24);
+            bits = c[14] | c[15] << 8;
+        } else if (memcmp(b + off, "data", 4) == 0 && ch == 1 && bits == 16) {
+            data = (int16_t *)malloc(cl);
+            if (data) memcpy(data, c, cl);
+            *n = (int)(cl / 2);
+            break;
+        }
+        off += 8 + cl + (cl & 1);
+    }
+    free(b);
+    return data;
+}
+
+int main(int argc, char **argv)
+{
+    float load = 0;
+    if (argc >= 2) {
+        size_t len = 0;
+        void *model = file_load(argv[1], &len);
+        if (!model) {
+            fprintf(stderr, "cannot read %s\n", argv[1]);
+            return 2;
+        }
+        int sr = 16000, n = 0;
+        int16_t *x = (argc >= 4) ? wav_load(argv[2], &n, &sr) : NULL;
+        if (argc >= 4 && !x) {
+            fprintf(stderr, "need a 16-bit mono WAV: %s\n", argv[2]);
+            return 2;
+        }
+        int rc = check_cpu(model, len, argv[1], sr, &load);
+        if (rc == 0 && x) {
+            uint32_t labels[4096];
+            int n_lab = 0;
+            FILE *fp = fopen(argv[3], "r");
+            unsigned v;
+            while (fp && n_lab < 4096 && fscanf(fp, "%u", &v) == 1) labels[n_lab++] = v;
+            if (fp) fclose(fp);
+            app_kws_t k;
+            app_kws_cfg_t cfg = app_kws_cfg_default(sr);
+            cfg.model = model;
+            cfg.model_len = len;
+            replay_t r;
+            if (app_kws_init(&k, &cfg) == ESP_OK) {
+                replay(&k, x, n, sr, labels, n_lab, &r);
+                app_kws_deinit(&k);
+            }
+        }
+        free(x);
+        free(model);
+        return rc;
+    }
+
+    int fail = 0;
+    const size_t len = app_tsig_kws_model(NULL);
+    uint8_t *syn = (uint8_t *)malloc(len);
+    app_tsig_kws_model(syn);
+    for (int sr = 16000; sr <= 24000; sr += 8000) {
+        fail |= check_cpu(syn, len, "synthetic ds-cnn", sr, &load);
+        fail |= load >= 100.0f;
+        fail |= check_frontend(sr);
+    }
+    free(syn);
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
@@ -0,0 +1,364 @@
+#!/usr/bin/env python3
+"""
+mkassetpack.py - 生成/查看/校验 gdBB 只读资源包（asset pack）
+
+格式与 main/App_AssetPack.h 一致（小端）：
+  header(32B) | entry table(slot_count * 32B，按 id 直接下标) | data（16B 对齐）
+
+用法：
+  python tools/mkassetpack.py build assets/manifest.json -o build/assets.bin
+  python tools/mkassetpack.py list  build/assets.bin
+  python tools/mkassetpack.py verify build/assets.bin --size 3M
+  python tools/mkassetpack.py selftest
+
+manifest.json 示例：
+  {
+    "sample_rate": 24000,
+    "channels": 1,
+    "assets": [
+      {"id": 1,  "name": "earcon_wake", "file": "wake.wav"},
+      {"id": 16, "name": "filler_en",   "file": "en.wav", "gain_db": -3},
+      {"id": 64, "name": "kws_model",   "file": "kws.bin", "kind": "blob"}
+    ]
+  }
+
+WAV 会在打包时转换成目标采样率/声道的 s16le（线性插值重采样），
+这样端上可以直接把映射地址交给喇叭，不做任何转换或拷贝。
+"""
+
+import argparse
+import json
+import math
+import os
+import struct
+import sys
+import tempfile
+import wave
+import zlib
+
+MAGIC = 0x50414447  # "GDAP"
+VERSION = 1
+HDR_FMT = "<IHHIIIIII"
+ENTRY_FMT = "<IIIBBBB16s"
+HDR_SIZE = struct.calcsize(HDR_FMT)
+ENTRY_SIZE = struct.calcsize(ENTRY_FMT)
+DATA_ALIGN = 16
+MAX_ID = 0xFFFF
+
+KIND_NONE = 0
+KIND_PCM = 1
+KIND_BLOB = 2
+KIND_NAMES = {KIND_NONE: "none", KIND_PCM: "pcm", KIND_BLOB: "blob"}
+
+assert HDR_SIZE == 32 and ENTRY_SIZE == 32
+
+
+class PackError(Exception):
+    pass
+
+
+def parse_size(s):
+    s = str(s).strip().upper()
+    mul = 1
+    if s.endswith("K"):
+        mul, s = 1024, s[:-1]
+    elif s.endswith("M"):
+        mul, s = 1024 * 1024, s[:-1]
+    return int(s, 0) * mul
+
+
+def align(n, a=DATA_ALIGN):
+    return (n + a - 1) // a * a
+
+
+def samples_from_wav(path):
+    with wave.open(path, "rb") as w:
+        if w.getsampwidth() != 2:
+            raise PackError("%s: only 16-bit PCM wav supported" % path)
+        ch = w.getnchannels()
+        sr = w.getframerate()
+        raw = w.readframes(w.getnframes())
+    n = len(raw) // 2
+    s = list(struct.unpack("<%dh" % n, raw[: n * 2]))
+    # 拆成每声道列表
+    return sr, [s[c::ch] for c in range(ch)]
+
+
+def convert_pcm(sr_in, chans, sr_out, ch_out, gain_db=0.0):
+    # 先混成单声道（或取前两个声道），再重采样
+    if ch_out == 1:
+        mono = [sum(v) / len(chans) for v in zip(*chans)]
+        chans = [mono]
+    elif len(chans) == 1:
+        chans = [chans[0], chans[0]]
+    else:
+        chans = chans[:2]
+
+    if sr_in != sr_out:
+        out = []
+        n_in = len(chans[0])
+        n_out = int(n_in * sr_out / sr_in)
+        step = sr_in / sr_out
+        for c in chans:
+            r = []
+            for i in range(n_out):
+                pos = i * step
+                j = int(pos)
+                f = pos - j
+                a = c[j] if j < n_in else 0
+                b = c[j + 1] if j + 1 < n_in else a
+                r.append(a + (b - a) * f)
+            out.append(r)
+        chans = out
+
+    g = 10.0 ** (gain_db / 20.0)
+    frames = []
+    for v in zip(*chans):
+        for x in v:
+            frames.append(max(-32768, min(32767, int(round(x * g)))))
+    return struct.pack("<%dh" % len(frames), *frames)
+
+
+def build_pack(assets, sample_rate, channels):
+    """assets: list of dict(id, name, kind, data)。返回 bytes。"""
+    if not assets:
+        raise PackError("no assets")
+    ids = [a["id"] for a in assets]
+    if len(set(ids)) != len(ids):
+        raise PackError("duplicate asset id")
+    for a in assets:
+        if not (0 <= a["id"] <= MAX_ID):
+            raise PackError("asset id out of range: %r" % a["id"])
+        if len(a["name"].encode()) > 15:
+            raise PackError("asset name too long (max 15): %s" % a["name"])
+
+    slot_count = max(ids) + 1
+    table_off = HDR_SIZE
+    data_off = align(table_off + slot_count * ENTRY_SIZE)
+
+    entries = [struct.pack(ENTRY_FMT, 0, 0, 0, KIND_NONE, 0, 0, 0, b"")] * slot_count
+    data = bytearray()
+    for a in sorted(assets, key=lambda x: x["id"]):
+        off = data_off + len(data)
+        blob = a["data"]
+        if a["kind"] == KIND_PCM:
+            entries[a["id"]] = struct.pack(ENTRY_FMT, off, len(blob), sample_rate, KIND_PCM, channels, 16, 0,
+                                           a["name"].encode())
+        else:
+            entries[a["id"]] = struct.pack(ENTRY_FMT, off, len(blob), 0, KIND_BLOB, 0, 0, 0, a["name"].encode())
+        data += blob
+        data += b"\0" * (align(len(data)) - len(data))
+
+    table = b"".join(entries)
+    body = table + b"\0" * (data_off - table_off - len(table)) + bytes(data)
+    total = HDR_SIZE + len(body)
+    crc = zlib.crc32(body) & 0xFFFFFFFF
+    hdr = struct.pack(HDR_FMT, MAGIC, VERSION, ENTRY_SIZE, slot_count, table_off, data_off, total, crc, 0)
+    return hdr + body
+
+
+def parse_pack(buf):
+    """返回 (header dict, {id: entry dict})；格式错误抛 PackError。"""
+    if len(buf) < HDR_SIZE:
+        raise PackError("file too small")
+    magic, ver, esize, slots, table_off, data_off, total, crc, _ = struct.unpack_from(HDR_FMT, buf, 0)
+    if magic != MAGIC:
+        raise PackError("bad magic 0x%08x" % magic)
+    if ver != VERSION or esize != ENTRY_SIZE:
+        raise PackError("unsupported version %d / entry size %d" % (ver, esize))
+    if total > len(buf) or table_off < HDR_SIZE or table_off + slots * ENTRY_SIZE > data_off or data_off > total:
+        raise PackError("layout invalid")
+    hdr = dict(slot_count=slots, table_off=table_off, data_off=data_off, total_size=total, crc32=crc)
+
+    entries = {}
+    for i in range(slots):
+        off, length, sr, kind, ch, bits, _, name = struct.unpack_from(ENTRY_FMT, buf, table_off + i * ENTRY_SIZE)
+        if kind == KIND_NONE:
+            continue
+        if off < data_off or off + length > total:
+            raise PackError("asset %d out of range" % i)
+        entries[i] = dict(offset=off, length=length, sample_rate=sr, kind=kind, channels=ch, bits=bits,
+                          name=name.split(b"\0", 1)[0].decode(errors="replace"))
+    return hdr, entries
+
+
+def lookup(buf, asset_id):
+    """与端上 app_asset_get() 相同的 O(1) 查找：按 id 直接下标读表项。"""
+    _, _, _, slots, table_off, _, _, _, _ = struct.unpack_from(HDR_FMT, buf, 0)
+    if asset_id >= slots:
+        return None
+    off, length, _, kind, _, _, _, _ = struct.unpack_from(ENTRY_FMT, buf, table_off + asset_id * ENTRY_SIZE)
+    if kind == KIND_NONE:
+        return None
+    return buf[off:off + length]
+
+
+def verify_pack(buf, part_size=None):
+    hdr, entries = parse_pack(buf)
+    crc = zlib.crc32(buf[hdr["table_off"]:hdr["total_size"]]) & 0xFFFFFFFF
+    if crc != hdr["crc32"]:
+        raise PackError("crc mismatch: 0x%08x != 0x%08x" % (crc, hdr["crc32"]))
+    if part_size is not None and hdr["total_size"] > part_size:
+        raise PackError("pack %d bytes > partition %d bytes" % (hdr["total_size"], part_size))
+    for i, e in entries.items():
+        if e["offset"] % 2:
+            raise PackError("asset %d not aligned" % i)
+        if e["kind"] == KIND_PCM and e["length"] % (2 * max(1, e["channels"])):
+            raise PackError("asset %d pcm length not frame aligned" % i)
+    return hdr, entries
+
+
+def load_manifest(path):
+    with open(path, "r", encoding="utf-8") as f:
+        m = json.load(f)
+    base = os.path.dirname(os.path.abspath(path))
+    sr = int(m.get("sample_rate", 24000))
+    ch = int(m.get("channels", 1))
+    assets = []
+    for a in m["assets"]:
+        fpath = os.path.join(base, a["file"])
+        kind = a.get("kind", "pcm" if fpath.lower().endswith(".wav") else "blob")
+        if kind == "pcm":
+            sr_in, chans = samples_from_wav(fpath)
+            data = convert_pcm(sr_in, chans, sr, ch, float(a.get("gain_db", 0.0)))
+            k = KIND_PCM
+        else:
+            with open(fpath, "rb") as f:
+                data = f.read()
+            k = KIND_BLOB
+        assets.append(dict(id=int(a["id"]), name=a.get("name", os.path.splitext(a["file"])[0])[:15],
+                           kind=k, data=data))
+    return assets, sr, ch
+
+
+def cmd_build(args):
+    assets, sr, ch = load_manifest(args.manifest)
+    pack = build_pack(assets, sr, ch)
+    if args.size:
+        limit = parse_size(args.size)
+        if len(pack) > limit:
+            raise PackError("pack %d bytes > partition %d bytes" % (len(pack), limit))
+    os.makedirs(os.path.dirname(os.path.abspath(args.output)), exist_ok=True)
+    with open(args.output, "wb") as f:
+        f.write(pack)
+    print("wrote %s: %d assets, %d bytes" % (args.output, len(assets), len(pack)))
+
+
+def cmd_list(args):
+    with open(args.pack, "rb") as f:
+        buf = f.read()
+    hdr, entries = parse_pack(buf)
+    print("slots=%d data_off=%d total=%d crc=0x%08x" %
+          (hdr["slot_count"], hdr["data_off"], hdr["total_size"], hdr["crc32"]))
+    for i in sorted(entries):
+        e = entries[i]
+        if e["kind"] == KIND_PCM:
+            ms = e["length"] * 1000 // (2 * max(1, e["channels"]) * max(1, e["sample_rate"]))
+            extra = "%dHz/%dch %dms" % (e["sample_rate"], e["channels"], ms)
+        else:
+            extra = ""
+        print("%5d  %-15s %-4s off=%-8d len=%-8d %s" %
+              (i, e["name"], KIND_NAMES[e["kind"]], e["offset"], e["length"], extra))
+
+
+def cmd_verify(args):
+    with open(args.pack, "rb") as f:
+        buf = f.read()
+    hdr, entries = verify_pack(buf, parse_size(args.size) if args.size else None)
+    print("OK: %d assets, %d bytes" % (len(entries), hdr["total_size"]))
+
+
+def cmd_selftest(args):
+    """打包/查找自测：生成合成资源，检查往返一致、O(1) 查找、空槽和损坏检测。"""
+    sr, ch = 24000, 1
+    tone = [int(8000 * math.sin(2 * math.pi * 1000 * i / sr)) for i in range(sr // 10)]
+    tone_pcm = convert_pcm(sr, [tone], sr, ch)
+    blob = bytes(range(256)) * 3 + b"\x01"  # 奇数长度，检查对齐填充
+    assets = [
+        dict(id=1, name="earcon_wake", kind=KIND_PCM, data=tone_pcm),
+        dict(id=16, name="filler_0", kind=KIND_PCM, data=tone_pcm[: len(tone_pcm) // 2]),
+        dict(id=64, name="kws_model", kind=KIND_BLOB, data=blob),
+    ]
+    pack = build_pack(assets, sr, ch)
+    hdr, entries = verify_pack(pack)
+    assert hdr["slot_count"] == 65
+    for a in assets:
+        assert lookup(pack, a["id"]) == a["data"], "roundtrip id %d" % a["id"]
+        assert entries[a["id"]]["offset"] % DATA_ALIGN == 0
+        assert entries[a["id"]]["name"] == a["name"]
+    assert lookup(pack, 2) is None and lookup(pack, 65) is None and lookup(pack, MAX_ID) is None
+
+    # 重采样：48k 立体声 -> 24k 单声道，长度减半
+    pcm = convert_pcm(48000, [tone * 2, tone * 2], sr, 1)
+    assert len(pcm) == len(tone) * 2, len(pcm)
+
+    # 损坏检测
+    bad = bytearray(pack)
+    bad[-1] ^= 0xFF
+    try:
+        verify_pack(bytes(bad))
+        raise AssertionError("crc corruption not detected")
+    except PackError:
+        pass
+    try:
+        build_pack(assets + [dict(id=1, name="dup", kind=KIND_BLOB, data=b"x")], sr, ch)
+        raise AssertionError("duplicate id not rejected")
+    except PackError:
+        pass
+
+    # 文件往返
+    with tempfile.TemporaryDirectory() as d:
+        with open(os.path.join(d, "t.wav"), "wb") as f:
+            with wave.open(f, "wb") as w:
+                w.setnchannels(1)
+                w.setsampwidth(2)
+                w.setframerate(16000)
+                w.writeframes(struct.pack("<%dh" % len(tone), *tone))
+        with open(os.path.join(d, "m.bin"), "wb") as f:
+            f.write(blob)
+        with open(os.path.join(d, "manifest.json"), "w") as f:
+            json.dump({"sample_rate": sr, "channels": 1, "assets": [
+                {"id": 1, "name": "earcon_wake", "file": "t.wav"},
+                {"id": 64, "name": "kws_model", "file": "m.bin"}]}, f)
+        a, s, c = load_manifest(os.path.join(d, "manifest.json"))
+        p = build_pack(a, s, c)
+        verify_pack(p)
+        assert lookup(p, 64) == blob
+        assert len(lookup(p, 1)) == len(tone) * 2 * sr // 16000
+
+    print("selftest OK")
+
+
+def main(argv=None):
+    ap = argparse.ArgumentParser(description="gdBB asset pack tool")
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("build", help="build pack from manifest.json")
+    p.add_argument("manifest")
+    p.add_argument("-o", "--output", required=True)
+    p.add_argument("--size", help="partition size limit, e.g. 3M")
+    p.set_defaults(func=cmd_build)
+
+    p = sub.add_parser("list", help="list assets in pack")
+    p.add_argument("pack")
+    p.set_defaults(func=cmd_list)
+
+    p = sub.add_parser("verify", help="check layout and crc")
+    p.add_argument("pack")
+    p.add_argument("--size", help="partition size limit, e.g. 3M")
+    p.set_defaults(func=cmd_verify)
+
+    p = sub.add_parser("selftest", help="run builder/lookup self test")
+    p.set_defaults(func=cmd_selftest)
+
+    args = ap.parse_args(argv)
+    try:
+        args.func(args)
+    except PackError as e:
+        print("error: %s" % e, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
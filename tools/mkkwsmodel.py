@@ -0,0 +1,447 @@
+#!/usr/bin/env python3
+"""
+mkkwsmodel.py - 把浮点 DS-CNN 唤醒词模型量化成 gdBB 端上的 int8 blob（App_KwsDscnn.c）
+
+格式（小端）：
+  header(48B) | layer × n_layers
+  layer = 头(16B) | int8 权重（补齐到 4B）| int32 偏置[out_ch]（POOL 无权重/偏置）
+
+张量 HWC，输入 in_t(帧) × in_f(特征) × 1；对称 int8 量化（零点 0），
+层输出 y = sat8(round(acc * mult / 2^(31 + shift)))。
+
+特征必须与端上 App_Spec 一致：10ms 跳步，log2 mel 能量 / 正交 DCT-II MFCC，Q8（× 256）。
+训练侧导出的校准特征（calib）也用这个单位。
+
+用法：
+  python tools/mkkwsmodel.py random -o build/kws.bin              # 随机权重，只用于测 CPU / 打通链路
+  python tools/mkkwsmodel.py pack model.json weights.npz -o build/kws.bin
+  python tools/mkkwsmodel.py info build/kws.bin
+  python tools/mkkwsmodel.py selftest
+
+model.json 示例：
+  {
+    "feat": "mfcc", "in_t": 49, "in_f": 10, "n_mel": 40, "fmin_hz": 20, "fmax_hz": 4000,
+    "wake_class": 2, "smooth_ms": 200, "threshold": 0.6,
+    "layers": [
+      {"type": "conv", "k": [10, 4], "stride": [2, 2], "pad": "same", "relu": true, "out": 32},
+      {"type": "dw",   "k": [3, 3], "pad": "same", "relu": true},
+      {"type": "conv", "k": [1, 1], "relu": true, "out": 32},
+      {"type": "pool"},
+      {"type": "fc",   "out": 3}
+    ]
+  }
+
+weights.npz：第 i 层的 w<i> / b<i>（浮点），布局
+  conv [oc][kh][kw][ic]、dw [kh][kw][c]、fc [oc][in]（in 按 HWC 展平）；
+  另有 calib：(N, in_t, in_f) 的校准特征，用来定激活尺度。
+
+生成的 blob 放进资源包（id 64，kind blob），见 tools/mkassetpack.py。
+"""
+
+import argparse
+import json
+import math
+import struct
+import sys
+
+MAGIC = 0x3153574B  # "KWS1"
+VERSION = 1
+HDR_FMT = "<IHHHHBBBBiib3xHHHHII4x"
+LAYER_FMT = "<BBBBBBBbHHi"
+HDR_SIZE = struct.calcsize(HDR_FMT)
+LAYER_SIZE = struct.calcsize(LAYER_FMT)
+MAX_LAYERS = 16
+MAX_CH = 256
+MAX_CLASSES = 12
+
+T_CONV, T_DW, T_POOL, T_FC = 1, 2, 3, 4
+TYPE_IDS = {"conv": T_CONV, "dw": T_DW, "pool": T_POOL, "fc": T_FC}
+TYPE_NAMES = {v: k for k, v in TYPE_IDS.items()}
+FEATS = {"mfcc": 0, "logmel": 1}
+
+assert HDR_SIZE == 48 and LAYER_SIZE == 16
+
+
+class ModelError(Exception):
+    pass
+
+
+def need_numpy():
+    try:
+        import numpy
+    except ImportError:
+        raise ModelError("numpy required (pip install numpy)")
+    return numpy
+
+
+def quant_mult(m):
+    """实数倍率 -> (mult Q31, shift)，m = mult / 2^(31 + shift)"""
+    if m <= 0:
+        return 0, 0
+    f, e = math.frexp(m)
+    mult = int(round(f * (1 << 31)))
+    if mult == 1 << 31:
+        mult //= 2
+        e += 1
+    shift = -e
+    if 31 + shift < 1:
+        raise ModelError("multiplier %g out of range" % m)
+    return mult, shift
+
+
+def conv_out(n, k, s, same):
+    if same:
+        o = (n + s - 1) // s
+        need = max((o - 1) * s + k - n, 0)
+        return o, need // 2, need - need // 2
+    return (n - k) // s + 1, 0, 0
+
+
+def layer_shapes(spec):
+    """按 spec 推出每层的输入/输出形状，和 App_KwsDscnn.c 的解析保持一致"""
+    h, w, c = spec["in_t"], spec["in_f"], 1
+    out = []
+    for i, L in enumerate(spec["layers"]):
+        t = TYPE_IDS.get(L["type"])
+        if t is None:
+            raise ModelError("layer %d: unknown type %r" % (i, L["type"]))
+        kh, kw = L.get("k", [1, 1])
+        sh, sw = L.get("stride", [1, 1])
+        same = L.get("pad", "same") == "same"
+        g = dict(t=t, relu=bool(L.get("relu", False)), kh=kh, kw=kw, sh=sh, sw=sw, same=same, ih=h, iw=w, ic=c)
+        if t in (T_CONV, T_DW):
+            oh, pt, pb = conv_out(h, kh, sh, same)
+            ow, pl, pr = conv_out(w, kw, sw, same)
+            g.update(oh=oh, ow=ow, oc=L["out"] if t == T_CONV else c, pad=(pt, pb, pl, pr))
+        elif t == T_POOL:
+            g.update(oh=1, ow=1, oc=c)
+        else:
+            g.update(oh=1, ow=1, oc=L["out"])
+        if g["oh"] <= 0 or g["ow"] <= 0 or not (0 < g["oc"] <= MAX_CH):
+            raise ModelError("layer %d: bad output shape %dx%dx%d" % (i, g["oh"], g["ow"], g["oc"]))
+        h, w, c = g["oh"], g["ow"], g["oc"]
+        out.append(g)
+    if h * w * c != spec["n_classes"]:
+        raise ModelError("last layer has %d outputs, expect n_classes %d" % (h * w * c, spec["n_classes"]))
+    return out
+
+
+def macs(shapes):
+    n = 0
+    for g in shapes:
+        if g["t"] == T_CONV:
+            n += g["oh"] * g["ow"] * g["oc"] * g["kh"] * g["kw"] * g["ic"]
+        elif g["t"] == T_DW:
+            n += g["oh"] * g["ow"] * g["oc"] * g["kh"] * g["kw"]
+        elif g["t"] == T_FC:
+            n += g["oc"] * g["ih"] * g["iw"] * g["ic"]
+    return n
+
+
+def forward(np, g, x, w=None, b=None):
+    """一层前向：x 为 (N, H, W, C)。浮点与 int64 共用（int 时不含重量化）"""
+    t = g["t"]
+    if t == T_POOL:
+        return x.sum(axis=(1, 2), keepdims=True)
+    if t == T_FC:
+        return (x.reshape(x.shape[0], -1) @ w.reshape(g["oc"], -1).T + b).reshape(x.shape[0], 1, 1, -1)
+    pt, pb, pl, pr = g["pad"]
+    xp = np.pad(x, ((0, 0), (pt, pb), (pl, pr), (0, 0)))
+    oh, ow, sh, sw = g["oh"], g["ow"], g["sh"], g["sw"]
+    y = np.zeros((x.shape[0], oh, ow, g["oc"]), dtype=x.dtype)
+    for ky in range(g["kh"]):
+        for kx in range(g["kw"]):
+            p = xp[:, ky : ky + sh * (oh - 1) + 1 : sh, kx : kx + sw * (ow - 1) + 1 : sw, :]
+            if t == T_CONV:
+                y += p @ w[:, ky, kx, :].T
+            else:
+                y += p * w[ky, kx, :]
+    return y + b
+
+
+def requant(np, acc, mult, shift):
+    total = 31 + shift
+    r = (acc.astype(np.int64) * mult + (1 << (total - 1))) >> total
+    return np.clip(r, -128, 127)
+
+
+def pool_int(np, acc, n):
+    # 与端上一致：四舍五入（远离 0）
+    return np.where(acc >= 0, (acc + n // 2) // n, -((-acc + n // 2) // n))
+
+
+def quantize(spec, weights, calib):
+    """浮点模型 + 校准特征 -> (blob, 量化信息)"""
+    np = need_numpy()
+    shapes = layer_shapes(spec)
+    if len(shapes) > MAX_LAYERS:
+        raise ModelError("too many layers (%d > %d)" % (len(shapes), MAX_LAYERS))
+    if not (1 < spec["n_classes"] <= MAX_CLASSES) or not (0 <= spec["wake_class"] < spec["n_classes"]):
+        raise ModelError("bad n_classes / wake_class")
+    calib = np.asarray(calib, dtype=np.float64)
+    if calib.ndim != 3 or calib.shape[1:] != (spec["in_t"], spec["in_f"]):
+        raise ModelError("calib must be (N, %d, %d)" % (spec["in_t"], spec["in_f"]))
+
+    # 输入：减去均值后按最大幅度量化到 int8
+    offset = int(round(float(calib.mean())))
+    s_x = max(float(np.abs(calib - offset).max()), 1.0) / 127.0
+    in_mult, in_shift = quant_mult(1.0 / s_x)
+    x = (calib - offset)[..., None]
+
+    layers = bytearray()
+    scales = []
+    for i, g in enumerate(shapes):
+        t = g["t"]
+        if t == T_POOL:
+            x = forward(np, g, x) / (g["ih"] * g["iw"])
+            layers += struct.pack(LAYER_FMT, t, 0, 0, 0, 0, 0, 0, 0, g["oc"], 0, 0)
+            scales.append(s_x)
+            continue
+        w = np.asarray(weights["w%d" % i], dtype=np.float64)
+        b = np.asarray(weights["b%d" % i], dtype=np.float64)
+        want = {T_CONV: (g["oc"], g["kh"], g["kw"], g["ic"]), T_DW: (g["kh"], g["kw"], g["ic"]),
+                T_FC: (g["oc"], g["ih"] * g["iw"] * g["ic"])}[t]
+        if w.shape != want or b.shape != (g["oc"],):
+            raise ModelError("layer %d: w%d %s / b%d %s, expect %s / (%d,)" % (i, i, w.shape, i, b.shape, want, g["oc"]))
+        y = forward(np, g, x, w, b)
+        if g["relu"]:
+            y = np.maximum(y, 0)
+        s_w = max(float(np.abs(w).max()), 1e-12) / 127.0
+        s_y = max(float(np.abs(y).max()), 1e-6) / 127.0
+        mult, shift = quant_mult(s_x * s_w / s_y)
+        wq = np.clip(np.round(w / s_w), -127, 127).astype(np.int8).tobytes()
+        bq = np.clip(np.round(b / (s_x * s_w)), -(1 << 31), (1 << 31) - 1).astype("<i4").tobytes()
+        layers += struct.pack(LAYER_FMT, t, g["relu"], g["kh"], g["kw"], g["sh"], g["sw"], 1 if g["same"] else 0,
+                              shift, g["oc"], 0, mult)
+        layers += wq + b"\0" * (-len(wq) % 4) + bq
+        x, s_x = y, s_y
+        scales.append(s_y)
+
+    logit_scale = int(round(s_x * (1 << 24)))
+    if not (0 < logit_scale < 1 << 32):
+        raise ModelError("logit scale %g out of range" % s_x)
+    th = int(round(float(spec.get("threshold", 0.6)) * 32768))
+    hdr = struct.pack(HDR_FMT, MAGIC, VERSION, len(shapes), spec["in_t"], spec["in_f"], FEATS[spec.get("feat", "mfcc")],
+                      spec.get("n_mel", 40), spec["n_classes"], spec["wake_class"], offset, in_mult, in_shift,
+                      spec.get("fmin_hz", 0), spec.get("fmax_hz", 0), spec.get("smooth_ms", 0), min(th, 32767),
+                      logit_scale, HDR_SIZE + len(layers))
+    return hdr + bytes(layers), dict(offset=offset, scales=scales, shapes=shapes)
+
+
+def parse(blob):
+    """blob -> (header dict, 层列表（含 int8 权重 / int32 偏置）)，校验方式同端上"""
+    if len(blob) < HDR_SIZE:
+        raise ModelError("blob too short")
+    (magic, ver, n_layers, in_t, in_f, feat, n_mel, n_classes, wake, in_offset, in_mult, in_shift, fmin, fmax,
+     smooth, th, logit_scale, total) = struct.unpack_from(HDR_FMT, blob, 0)
+    if magic != MAGIC or ver != VERSION:
+        raise ModelError("bad magic/version")
+    if total != len(blob):
+        raise ModelError("length %d != header %d" % (len(blob), total))
+    hdr = dict(n_layers=n_layers, in_t=in_t, in_f=in_f, feat=feat, n_mel=n_mel, n_classes=n_classes, wake_class=wake,
+               in_offset=in_offset, in_mult=in_mult, in_shift=in_shift, fmin_hz=fmin, fmax_hz=fmax, smooth_ms=smooth,
+               threshold_q15=th, logit_scale=logit_scale / float(1 << 24))
+    off = HDR_SIZE
+    h, w, c = in_t, in_f, 1
+    layers = []
+    for i in range(n_layers):
+        if off + LAYER_SIZE > len(blob):
+            raise ModelError("layer %d header truncated" % i)
+        t, relu, kh, kw, sh, sw, same, shift, oc, _, mult = struct.unpack_from(LAYER_FMT, blob, off)
+        off += LAYER_SIZE
+        sh, sw = sh or 1, sw or 1
+        g = dict(t=t, relu=bool(relu), kh=kh, kw=kw, sh=sh, sw=sw, same=bool(same), shift=shift, mult=mult,
+                 ih=h, iw=w, ic=c)
+        if t in (T_CONV, T_DW):
+            oh, pt, pb = conv_out(h, kh, sh, same)
+            ow, pl, pr = conv_out(w, kw, sw, same)
+            g.update(oh=oh, ow=ow, oc=oc if t == T_CONV else c, pad=(pt, pb, pl, pr))
+            nw = g["oc"] * kh * kw * c if t == T_CONV else kh * kw * c
+        elif t == T_POOL:
+            g.update(oh=1, ow=1, oc=c)
+            nw = 0
+        elif t == T_FC:
+            g.update(oh=1, ow=1, oc=oc)
+            nw = oc * h * w * c
+        else:
+            raise ModelError("layer %d: unknown type %d" % (i, t))
+        if nw:
+            wpad = nw + (-nw % 4)
+            if off + wpad + 4 * g["oc"] > len(blob):
+                raise ModelError("layer %d weights truncated" % i)
+            g["w"] = blob[off : off + nw]
+            g["b"] = blob[off + wpad : off + wpad + 4 * g["oc"]]
+            off += wpad + 4 * g["oc"]
+        h, w, c = g["oh"], g["ow"], g["oc"]
+        layers.append(g)
+    if off != len(blob) or h * w * c != n_classes:
+        raise ModelError("trailing bytes or output size mismatch")
+    return hdr, layers
+
+
+def run_int8(blob, feats):
+    """int8 参考推理（与 App_KwsDscnn.c 逐位一致）：feats (N, in_t, in_f) Q8 特征 -> (N, n_classes) 概率"""
+    np = need_numpy()
+    hdr, layers = parse(blob)
+    v = np.asarray(feats, dtype=np.int64) - hdr["in_offset"]
+    x = requant(np, v, hdr["in_mult"], hdr["in_shift"])[..., None]
+    for g in layers:
+        t = g["t"]
+        if t == T_POOL:
+            x = pool_int(np, forward(np, g, x), g["ih"] * g["iw"])
+            continue
+        shape = {T_CONV: (g["oc"], g["kh"], g["kw"], g["ic"]), T_DW: (g["kh"], g["kw"], g["ic"]),
+                 T_FC: (g["oc"], -1)}[t]
+        w = np.frombuffer(g["w"], dtype=np.int8).astype(np.int64).reshape(shape)
+        b = np.frombuffer(g["b"], dtype="<i4").astype(np.int64)
+        x = requant(np, forward(np, g, x, w, b), g["mult"], g["shift"])
+        if g["relu"]:
+            x = np.maximum(x, 0)
+    z = x.reshape(x.shape[0], -1).astype(np.float64) * hdr["logit_scale"]
+    z = np.exp(z - z.max(axis=1, keepdims=True))
+    return z / z.sum(axis=1, keepdims=True)
+
+
+def default_spec(feat="mfcc", in_t=49, in_f=10, ch=32, blocks=4, classes=3):
+    """DS-CNN：首层 10x4/2 卷积 + blocks 组（3x3 深度卷积 + 1x1 卷积）+ 全局平均池化 + 全连接"""
+    layers = [dict(type="conv", k=[10, 4], stride=[2, 2], pad="same", relu=True, out=ch)]
+    for _ in range(blocks):
+        layers.append(dict(type="dw", k=[3, 3], pad="same", relu=True))
+        layers.append(dict(type="conv", k=[1, 1], relu=True, out=ch))
+    layers += [dict(type="pool"), dict(type="fc", out=classes)]
+    return dict(feat=feat, in_t=in_t, in_f=in_f, n_mel=40 if feat == "mfcc" else in_f, fmin_hz=20, fmax_hz=4000,
+                n_classes=classes, wake_class=classes - 1, smooth_ms=200, threshold=0.6, layers=layers)
+
+
+def random_model(spec, seed=1, n_calib=64):
+    """随机浮点权重（He 初始化）+ 随机校准特征：结构/算量与真模型相同，只用于测 CPU 与链路"""
+    np = need_numpy()
+    rng = np.random.default_rng(seed)
+    weights = {}
+    for i, g in enumerate(layer_shapes(spec)):
+        if g["t"] == T_CONV:
+            shape, fan = (g["oc"], g["kh"], g["kw"], g["ic"]), g["kh"] * g["kw"] * g["ic"]
+        elif g["t"] == T_DW:
+            shape, fan = (g["kh"], g["kw"], g["ic"]), g["kh"] * g["kw"]
+        elif g["t"] == T_FC:
+            shape, fan = (g["oc"], g["ih"] * g["iw"] * g["ic"]), g["ih"] * g["iw"] * g["ic"]
+        else:
+            continue
+        weights["w%d" % i] = rng.normal(0, math.sqrt(2.0 / fan), shape)
+        weights["b%d" % i] = rng.normal(0, 0.1, (g["oc"],))
+    calib = rng.normal(0, 512, (n_calib, spec["in_t"], spec["in_f"]))
+    return weights, calib
+
+
+def cmd_random(args):
+    spec = default_spec(args.feat, args.in_t, args.in_f, args.ch, args.blocks, args.classes)
+    weights, calib = random_model(spec, args.seed)
+    blob, _ = quantize(spec, weights, calib)
+    with open(args.output, "wb") as f:
+        f.write(blob)
+    print("wrote %s: %d bytes, %d MACs/inference (random weights)" % (args.output, len(blob),
+                                                                       macs(layer_shapes(spec))))
+
+
+def cmd_pack(args):
+    np = need_numpy()
+    with open(args.spec) as f:
+        spec = json.load(f)
+    spec.setdefault("n_classes", spec["layers"][-1]["out"])
+    npz = np.load(args.weights)
+    if "calib" not in npz:
+        raise ModelError("%s: missing calib features" % args.weights)
+    blob, q = quantize(spec, npz, npz["calib"])
+    with open(args.output, "wb") as f:
+        f.write(blob)
+    print("wrote %s: %d bytes, %d MACs/inference, input offset %d" % (args.output, len(blob), macs(q["shapes"]),
+                                                                      q["offset"]))
+
+
+def cmd_info(args):
+    with open(args.model, "rb") as f:
+        blob = f.read()
+    hdr, layers = parse(blob)
+    print("%d bytes, input %dx%d %s (mel %d, %d-%d Hz), %d classes (wake %d), smooth %d ms, th %.2f" % (
+        len(blob), hdr["in_t"], hdr["in_f"], "mfcc" if hdr["feat"] == 0 else "logmel", hdr["n_mel"],
+        hdr["fmin_hz"], hdr["fmax_hz"], hdr["n_classes"], hdr["wake_class"], hdr["smooth_ms"],
+        hdr["threshold_q15"] / 32768.0))
+    for i, g in enumerate(layers):
+        print("  %2d %-4s %2dx%-2d /%dx%d %s %3dx%-3dx%-3d -> %3dx%-3dx%-3d" % (
+            i, TYPE_NAMES[g["t"]], g["kh"], g["kw"], g["sh"], g["sw"], "relu" if g["relu"] else "    ",
+            g["ih"], g["iw"], g["ic"], g["oh"], g["ow"], g["oc"]))
+    print("%d MACs/inference" % macs(layers))
+
+
+def cmd_selftest(args):
+    np = need_numpy()
+    spec = default_spec()
+    weights, calib = random_model(spec, seed=7, n_calib=256)
+    blob, q = quantize(spec, weights, calib)
+    hdr, layers = parse(blob)
+    assert len(blob) % 4 == 0 and hdr["n_layers"] == len(spec["layers"])
+
+    # 浮点前向 vs int8 参考：随机模型上 top-1 一致率应很高
+    x = (calib - q["offset"])[..., None]
+    for i, g in enumerate(q["shapes"]):
+        if g["t"] == T_POOL:
+            x = forward(np, g, x) / (g["ih"] * g["iw"])
+            continue
+        x = forward(np, g, x, weights["w%d" % i], weights["b%d" % i])
+        if g["relu"]:
+            x = np.maximum(x, 0)
+    ref = x.reshape(x.shape[0], -1).argmax(axis=1)
+    p = run_int8(blob, np.round(calib))
+    agree = float((p.argmax(axis=1) == ref).mean())
+    assert np.allclose(p.sum(axis=1), 1.0)
+    assert agree > 0.9, agree
+
+    for bad in (blob[:-4], blob[:8] + b"\0" * (len(blob) - 8), blob + b"\0\0\0\0"):
+        try:
+            parse(bad)
+            raise AssertionError("bad blob accepted")
+        except ModelError:
+            pass
+    print("selftest ok: %d bytes, %d MACs, int8/float top-1 agreement %.1f%%" % (len(blob), macs(layers),
+                                                                                 agree * 100))
+
+
+def main(argv=None):
+    ap = argparse.ArgumentParser(description="gdBB keyword-spotting model tool")
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("random", help="default DS-CNN topology with random weights (CPU / plumbing tests)")
+    p.add_argument("-o", "--output", required=True)
+    p.add_argument("--feat", choices=sorted(FEATS), default="mfcc")
+    p.add_argument("--in-t", type=int, default=49)
+    p.add_argument("--in-f", type=int, default=10)
+    p.add_argument("--ch", type=int, default=32)
+    p.add_argument("--blocks", type=int, default=4)
+    p.add_argument("--classes", type=int, default=3)
+    p.add_argument("--seed", type=int, default=1)
+    p.set_defaults(func=cmd_random)
+
+    p = sub.add_parser("pack", help="quantize float weights + calib features")
+    p.add_argument("spec")
+    p.add_argument("weights")
+    p.add_argument("-o", "--output", required=True)
+    p.set_defaults(func=cmd_pack)
+
+    p = sub.add_parser("info", help="print model header and layers")
+    p.add_argument("model")
+    p.set_defaults(func=cmd_info)
+
+    p = sub.add_parser("selftest", help="quantizer / parser self test")
+    p.set_defaults(func=cmd_selftest)
+
+    args = ap.parse_args(argv)
+    try:
+        args.func(args)
+    except ModelError as e:
+        print("error: %s" % e, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,184 @@
+// App_Ns 主机评估：带噪语音的 SNR 改善、只有噪声时能量 VAD 的误唤醒（旁路 vs 降噪），并报每跳耗时
+//   cc -O2 -Imain -Itools/host tools/ns_bench.c main/App_Ns.c main/App_Spec.c main/App_PcmOps.c main/App_TestSig.c -lm -o build/ns_bench
+//   build/ns_bench                         合成场景（风扇 / 电视），有 PASS/FAIL
+//   build/ns_bench speech.wav noise.wav    录音：干净语音 + 噪声（16bit 单声道、同采样率，噪声循环补齐），只报告
+// 主机上 cycles 为纳秒（见 tools/host/esp_cpu.h）；目标板上的 cycles/hop 见 Task_Dsp_Selftest。
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "App_Ns.h"
+#include "App_PcmOps.h"
+#include "App_TestSig.h"
+
+#define SYN_SR 24000
+#define SYN_SECONDS 12
+#define WARMUP_MS 2000 // 留给噪声估计收敛，不计入 SNR
+
+// ---------- 合成场景（App_TestSig，与 Task_Dsp_Selftest 相同） ----------
+
+static void syn_scene(int16_t *clean, int16_t *noise, int n, int sr, app_tsig_noise_t type, int speech_amp,
+                      int noise_amp)
+{
+    app_tsig_scene_t *sc = (app_tsig_scene_t *)malloc(sizeof(app_tsig_scene_t));
+    app_tsig_scene_init(sc, sr, 0x5a5au + (uint32_t)type);
+    for (int f = 0; (f + 1) * sc->frame <= n; ++f) {
+        app_tsig_speech(sc, f, speech_amp, clean + f * sc->frame);
+        app_tsig_room_noise(sc, type, f, noise_amp, noise + f * sc->frame);
+    }
+    free(sc);
+}
+
+// ---------- 录音 ----------
+
+// 最小 WAV 读取：PCM 16bit 单声道
+static int16_t *wav_load(const char *path, int *n, int *sr)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    unsigned char h[12];
+    int16_t *data = NULL;
+    int ch = 0, bits = 0;
+    *sr = 0;
+    if (fread(h, 1, 12, fp) != 12 || memcmp(h, "RIFF", 4) != 0 || memcmp(h + 8, "WAVE", 4) != 0) goto out;
+    for (;;) {
+        unsigned char c[8];
+        if (fread(c, 1, 8, fp) != 8) break;
+        const uint32_t len = (uint32_t)c[4] | (uint32_t)c[5] << 8 | (uint32_t)c[6] << 16 | (uint32_t)c[7] << 24;
+        if (memcmp(c, "fmt ", 4) == 0) {
+            unsigned char f[16];
+            if (len < 16 || fread(f, 1, 16, fp) != 16) break;
+            ch = f[2] | f[3] << 8;
+            *sr = (int)((uint32_t)f[4] | (uint32_t)f[5] << 8 | (uint32_t)f[6] << 16 | (uint32_t)f[7] << 24);
+            bits = f[14] | f[15] << 8;
+            fseek(fp, (long)(len - 16 + (len & 1)), SEEK_CUR);
+        } else if (memcmp(c, "data", 4) == 0) {
+            if (ch != 1 || bits != 16) break;
+            data = (int16_t *)malloc(len);
+            if (!data) break;
+            *n = (int)(fread(data, 1, len, fp) / sizeof(int16_t));
+            break;
+        } else {
+            fseek(fp, (long)(len + (len & 1)), SEEK_CUR);
+        }
+    }
+out:
+    fclose(fp);
+    return data;
+}
+
+// ---------- 评估 ----------
+
+typedef struct {
+    app_tsig_vad_t vad;
+    double snr_in, snr_out;     // clean 为 NULL 时无意义
+    app_ns_stats_t st;
+} run_t;
+
+// clean 可为 NULL（只有噪声）；输出与延迟 latency 的干净语音比较
+static int run(const int16_t *clean, const int16_t *noise, int n, int sr, bool bypass, run_t *r)
+{
+    app_ns_t ns;
+    app_ns_cfg_t cfg = app_ns_cfg_default(sr);
+    if (app_ns_init(&ns, &cfg) != ESP_OK) return 1;
+    app_ns_set_bypass(&ns, bypass);
+    const int frame = sr / 50, lat = ns.latency, warm = sr * WARMUP_MS / 1000;
+    int16_t *x = (int16_t *)malloc((size_t)frame * sizeof(int16_t));
+    if (!x) {
+        app_ns_deinit(&ns);
+        return 1;
+    }
+    memset(r, 0, sizeof(*r));
+    double ps = 0, pn = 0, pe = 0;
+    for (int off = 0; off + frame <= n; off += frame) {
+        memcpy(x, noise + off, (size_t)frame * sizeof(int16_t));
+        if (clean) app_pcm_mix(x, clean + off, frame, 4096);
+        app_ns_process(&ns, x, frame);
+        app_tsig_vad_feed(&r->vad, sr, x, frame);
+        for (int i = 0; i < frame; ++i) {
+            const int t = off + i;
+            if (t < warm) continue;
+            const int16_t c = (clean && t >= lat) ? clean[t - lat] : 0;
+            const double e = (double)x[i] - c;
+            ps += (double)c * c;
+            pe += e * e;
+            pn += (double)noise[t] * noise[t];
+        }
+    }
+    app_ns_get_stats(&ns, &r->st);
+    r->snr_in = 10.0 * log10((ps + 1.0) / (pn + 1.0));
+    r->snr_out = 10.0 * log10((ps + 1.0) / (pe + 1.0));
+    free(x);
+    app_ns_deinit(&ns);
+    return 0;
+}
+
+// 返回 0 通过；check=false 时只报告
+static int eval(const char *name, const int16_t *clean, const int16_t *noise, int n, int sr, bool check)
+{
+    run_t n_off, n_on, s_off, s_on;
+    if (run(NULL, noise, n, sr, true, &n_off) || run(NULL, noise, n, sr, false, &n_on) ||
+        run(clean, noise, n, sr, true, &s_off) || run(clean, noise, n, sr, false, &s_on)) {
+        printf("%s: ns init failed  FAIL\n", name);
+        return 1;
+    }
+    const double hop_ns = 1e9 * (double)(sr * 10 / 1000) / sr; // 默认 20ms 窗、10ms 跳
+    const int fail = check && !(s_on.snr_out - s_on.snr_in > 3.0 && n_on.vad.voiced < n_off.vad.voiced &&
+                                s_on.vad.wakes > 0);
+    printf("%-6s %.1f s @ %d Hz: SNR %.1f -> %.1f dB (%+.1f, bypass %.1f), speech wakes %d -> %d\n", name,
+           (double)n / sr, sr, s_on.snr_in, s_on.snr_out, s_on.snr_out - s_on.snr_in, s_off.snr_out,
+           s_off.vad.wakes, s_on.vad.wakes);
+    printf("%-6s noise only: wakes %d -> %d, voiced windows %d -> %d /%d, atten %.1f dB\n", name, n_off.vad.wakes,
+           n_on.vad.wakes, n_off.vad.voiced, n_on.vad.voiced, n_on.vad.windows, (double)n_on.st.atten_db);
+    printf("%-6s %u ns/hop avg, %u max (%.2f%% of a core), bypass %u avg%s\n", name, (unsigned)s_on.st.cycles_avg,
+           (unsigned)s_on.st.cycles_max, 100.0 * s_on.st.cycles_avg / hop_ns, (unsigned)s_off.st.cycles_avg,
+           fail ? "  FAIL" : "");
+    return fail;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 3) {
+        int ns = 0, nn = 0, srs = 0, srn = 0;
+        int16_t *speech = wav_load(argv[1], &ns, &srs);
+        int16_t *noise = wav_load(argv[2], &nn, &srn);
+        if (!speech || !noise || srs != srn || ns <= 0 || nn <= 0) {
+            fprintf(stderr, "need two 16-bit mono WAV files at the same sample rate\n");
+            return 2;
+        }
+        // 噪声循环补齐到语音长度
+        int16_t *nz = (int16_t *)malloc((size_t)ns * sizeof(int16_t));
+        for (int i = 0; i < ns; ++i) nz[i] = noise[i % nn];
+        eval("record", speech, nz, ns, srs, false);
+        free(nz);
+        free(speech);
+        free(noise);
+        return 0;
+    }
+
+    static const struct {
+        const char *name;
+        app_tsig_noise_t type;
+        int speech_amp;
+        int noise_amp;
+    } scenes[] = {
+        {"fan", APP_TSIG_NOISE_FAN, 2500, 500},
+        {"tv", APP_TSIG_NOISE_TV, 2500, 250},
+        {"fan-lo", APP_TSIG_NOISE_FAN, 1200, 500},
+    };
+    const int n = SYN_SR * SYN_SECONDS;
+    int16_t *clean = (int16_t *)malloc((size_t)n * sizeof(int16_t));
+    int16_t *noise = (int16_t *)malloc((size_t)n * sizeof(int16_t));
+    int fail = 0;
+    for (size_t i = 0; i < sizeof(scenes) / sizeof(scenes[0]); ++i) {
+        syn_scene(clean, noise, n, SYN_SR, scenes[i].type, scenes[i].speech_amp, scenes[i].noise_amp);
+        fail |= eval(scenes[i].name, clean, noise, n, SYN_SR, true);
+    }
+    free(clean);
+    free(noise);
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
@@ -0,0 +1,111 @@
+// App_PcmOps 主机基准：portable / fast 两份实现逐位对比 + 每样本耗时表
+//   cc -O2 -Imain tools/pcm_ops_bench.c main/App_PcmOps.c -lm -o build/pcm_ops_bench && build/pcm_ops_bench
+// 目标板上的同一张表见 Task_Dsp_Selftest（cycles/sample）。
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "App_PcmOps.h"
+#include "App_TestSig.h"
+
+#define N 4096
+#define REPS 2000
+
+static int16_t s_x[2 * N];
+static int32_t s_x32[N];
+static int16_t s_a[2 * N];
+static int16_t s_b[2 * N];
+static volatile uint64_t s_sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint64_t run(const app_pcm_ops_t *o, int op, int16_t *out)
+{
+    switch (op) {
+    case 0: return o->sum_abs(s_x, N);
+    case 1: return o->sum_sq(s_x, N);
+    case 2: return (uint64_t)o->peak(s_x, N);
+    case 3: o->gain(out, s_x, N, 3 * 4096 + 517); break;
+    case 4:
+        memcpy(out, s_x + N, N * sizeof(int16_t));
+        o->mix(out, s_x, N, 2900);
+        break;
+    case 5:
+        memcpy(out, s_x, N * sizeof(int16_t));
+        o->fade(out, N, 32767, 1200);
+        break;
+    case 6:
+        memcpy(out, s_x + N, N * sizeof(int16_t));
+        o->mix_ramp(out, s_x, N, 32767, 4100);
+        break;
+    case 7: o->s32_to_s16(out, s_x32, N); break;
+    case 8: o->stereo_to_mono(out, s_x, N); break;
+    }
+    return 0;
+}
+
+static const char *const s_names[] = {
+    "sum_abs", "sum_sq", "peak", "gain", "mix", "fade", "mix_ramp", "s32_to_s16", "stereo_to_mono",
+};
+
+int main(void)
+{
+    uint32_t st = 12345;
+    for (int i = 0; i < 2 * N; ++i) s_x[i] = (int16_t)(app_tsig_lcg(&st) >> 16);
+    s_x[3] = -32768;
+    s_x[9] = 32767;
+    for (int i = 0; i < N; ++i) s_x32[i] = (int32_t)app_tsig_lcg(&st);
+
+    const app_pcm_ops_t *ops[2] = {app_pcm_ops_get(APP_PCM_IMPL_PORTABLE), app_pcm_ops_get(APP_PCM_IMPL_FAST)};
+    int fail = 0;
+    printf("%-15s %10s %10s %7s  %s\n", "op", "portable", "fast", "ratio", "(ns/sample)");
+    for (int op = 0; op < 9; ++op) {
+        const uint64_t ra = run(ops[0], op, s_a);
+        const uint64_t rb = run(ops[1], op, s_b);
+        const int same = (ra == rb) && memcmp(s_a, s_b, N * sizeof(int16_t)) == 0;
+        fail |= !same;
+
+        double ns[2];
+        for (int impl = 0; impl < 2; ++impl) {
+            const double t0 = now_ns();
+            for (int r = 0; r < REPS; ++r) s_sink += run(ops[impl], op, s_a);
+            ns[impl] = (now_ns() - t0) / ((double)REPS * N);
+        }
+        printf("%-15s %10.3f %10.3f %6.2fx%s\n", s_names[op], ns[0], ns[1], ns[0] / ns[1], same ? "" : "  MISMATCH");
+    }
+
+    // xfade 与原先的整数除法写法最多差 1 LSB
+    memcpy(s_a, s_x + N, N * sizeof(int16_t));
+    app_pcm_xfade(s_a, s_x, N);
+    int xerr = 0;
+    for (int i = 0; i < N; ++i) {
+        const int32_t r = ((int32_t)s_x[i] * (N - i) + (int32_t)s_x[N + i] * i) / N;
+        const int d = abs(r - s_a[i]);
+        if (d > xerr) xerr = d;
+    }
+
+    // NCO：与 sinf 对比
+    app_pcm_nco_t nco;
+    app_pcm_nco_init(&nco, 1000, 24000, 12000);
+    app_pcm_nco_run(&nco, s_a, N, 1);
+    double e = 0, p = 0;
+    for (int i = 0; i < N; ++i) {
+        const double r = 12000.0 * sin(2.0 * M_PI * 1000.0 * i / 24000.0);
+        p += r * r;
+        e += (r - s_a[i]) * (r - s_a[i]);
+    }
+    const double snr = 10.0 * log10(p / e);
+    printf("xfade max err %d LSB, nco 1 kHz SNR %.1f dB\n", xerr, snr);
+    fail |= (xerr > 2) || (snr < 70.0);
+
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""
+rb3_capture.py - 连上 v3 WS 服务端（真服务端或 rb3_standin_server.py），发几轮请求，把收发的文本帧原样录下来
+
+录制文件每行一帧："> " 上行、"< " 下行，后面是帧的原始 JSON 文本（不重新序列化）；"#" 开头为注释。
+二进制上行音频不录，只在注释里记字节数。tools/rb3_json_bench.c 用它回放、校验 App_Rb3Json 并计时。
+
+用法：
+  python tools/rb3_capture.py --url ws://192.168.31.193:8443/v3/robot/voice -o tools/captures/rb3_ws_downlink.txt \\
+      --voice-secs 1 --event idle --event idle@v1 --query '你好，"rid" 不是字段\\n第二行' --bad end
+  --event NAME@VER      event 请求带 "if_version": VER（录服务端的“未变”回复）
+  --bad TYPE            发一条服务端应拒绝的请求（如无 start 的 end、未知 type），录 error 回复
+"""
+
+import argparse
+import base64
+import json
+import os
+import socket
+import struct
+import sys
+import time
+from urllib.parse import urlparse
+
+OP_TEXT = 0x1
+OP_BIN = 0x2
+OP_CLOSE = 0x8
+OP_PING = 0x9
+OP_PONG = 0xA
+
+
+class Ws:
+    def __init__(self, url, timeout):
+        u = urlparse(url)
+        if u.scheme != "ws":
+            raise SystemExit("only ws:// is supported (got %s)" % u.scheme)
+        self.sock = socket.create_connection((u.hostname, u.port or 80), timeout=timeout)
+        key = base64.b64encode(os.urandom(16)).decode()
+        self.sock.sendall(("GET %s HTTP/1.1\r\nHost: %s\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                           "Sec-WebSocket-Key: %s\r\nSec-WebSocket-Version: 13\r\n\r\n"
+                           % (u.path or "/", u.netloc, key)).encode())
+        head = b""
+        while b"\r\n\r\n" not in head:
+            b = self.sock.recv(1)
+            if not b:
+                raise SystemExit("handshake: connection closed")
+            head += b
+        if b" 101 " not in head.split(b"\r\n", 1)[0]:
+            raise SystemExit("handshake failed: %r" % head.split(b"\r\n", 1)[0])
+
+    def send(self, op, payload):
+        mask = os.urandom(4)
+        n = len(payload)
+        if n < 126:
+            h = struct.pack("!BB", 0x80 | op, 0x80 | n)
+        elif n < 65536:
+            h = struct.pack("!BBH", 0x80 | op, 0x80 | 126, n)
+        else:
+            h = struct.pack("!BBQ", 0x80 | op, 0x80 | 127, n)
+        self.sock.sendall(h + mask + bytes(c ^ mask[i & 3] for i, c in enumerate(payload)))
+
+    def _read(self, n):
+        buf = b""
+        while len(buf) < n:
+            b = self.sock.recv(n - len(buf))
+            if not b:
+                raise ConnectionError("closed")
+            buf += b
+        return buf
+
+    def recv(self):
+        """返回 (op, payload)，分片帧拼好；ping 自动回 pong"""
+        msg, msg_op = b"", None
+        while True:
+            b0, b1 = self._read(2)
+            op, n = b0 & 0x0F, b1 & 0x7F
+            if n == 126:
+                n = struct.unpack("!H", self._read(2))[0]
+            elif n == 127:
+                n = struct.unpack("!Q", self._read(8))[0]
+            mask = self._read(4) if b1 & 0x80 else None
+            data = self._read(n)
+            if mask:
+                data = bytes(c ^ mask[i & 3] for i, c in enumerate(data))
+            if op == OP_PING:
+                self.send(OP_PONG, data)
+                continue
+            if op == OP_PONG:
+                continue
+            if op == OP_CLOSE:
+                return op, data
+            if op != 0x0:
+                msg_op = op
+            msg += data
+            if b0 & 0x80:
+                return msg_op, msg
+
+
+class Capture:
+    def __init__(self, ws, out):
+        self.ws = ws
+        self.out = out
+        self.frames = 0
+
+    def up(self, obj):
+        text = json.dumps(obj, ensure_ascii=False)
+        self.out.write("> " + text + "\n")
+        self.ws.send(OP_TEXT, text.encode("utf-8"))
+
+    def run_until_last(self, req, until="audio"):
+        """收到该 req 的 is_last audio（until="error" 时为 error 帧）为止（其他 req 的帧也照录）"""
+        while True:
+            op, data = self.ws.recv()
+            if op == OP_CLOSE:
+                raise SystemExit("server closed during req=%s" % req)
+            if op != OP_TEXT:
+                continue
+            text = data.decode("utf-8")
+            if "\n" in text:
+                raise SystemExit("frame contains a raw newline, cannot store one frame per line")
+            self.out.write("< " + text + "\n")
+            self.frames += 1
+            m = json.loads(text)
+            if m.get("req") == req and m.get("type") == until and (until != "audio" or m.get("is_last")):
+                return
+
+
+def main():
+    ap = argparse.ArgumentParser(description="record v3 WS text frames for host replay")
+    ap.add_argument("--url", required=True)
+    ap.add_argument("-o", "--out", required=True)
+    ap.add_argument("--voice-secs", type=float, default=0.0, help="先发一轮语音（静音 16k/16bit），0 不发")
+    ap.add_argument("--event", action="append", default=[], help="NAME 或 NAME@IF_VERSION")
+    ap.add_argument("--query", action="append", default=[])
+    ap.add_argument("--bad", action="append", default=[], help="服务端应回 error 的请求 type")
+    ap.add_argument("--af", default="pcm_24k_16bit")
+    ap.add_argument("--chunk-bytes", type=int, default=500)
+    ap.add_argument("--timeout", type=float, default=20.0)
+    a = ap.parse_args()
+
+    ws = Ws(a.url, a.timeout)
+    with open(a.out, "w", encoding="utf-8", newline="\n") as out:
+        out.write("# rb3_capture %s %s\n" % (a.url, time.strftime("%Y-%m-%d %H:%M:%S")))
+        cap = Capture(ws, out)
+        n = 0
+        if a.voice_secs > 0:
+            n += 1
+            req = "cap_v%d" % n
+            cap.up({"type": "start", "req": req, "af": a.af, "mode": "stream", "chunk_bytes": a.chunk_bytes,
+                    "audio_format": "pcm_16k_16bit", "language": "zh-CN"})
+            pcm = bytes(int(16000 * 2 * a.voice_secs))
+            for off in range(0, len(pcm), 4096):
+                ws.send(OP_BIN, pcm[off:off + 4096])
+            out.write("# binary uplink %d bytes\n" % len(pcm))
+            cap.up({"type": "end", "req": req})
+            cap.run_until_last(req)
+        for ev in a.event:
+            n += 1
+            req = "cap_e%d" % n
+            name, _, if_ver = ev.partition("@")
+            msg = {"type": "event", "event": name, "req": req, "user_id": "demo", "chunk_bytes": a.chunk_bytes,
+                   "mode": "stream", "af": a.af}
+            if if_ver:
+                msg["if_version"] = if_ver
+            cap.up(msg)
+            cap.run_until_last(req)
+        for q in a.query:
+            n += 1
+            req = "cap_q%d" % n
+            cap.up({"type": "query", "text": q.replace("\\n", "\n"), "req": req, "chunk_bytes": a.chunk_bytes,
+                    "mode": "stream", "af": a.af})
+            cap.run_until_last(req)
+        for t in a.bad:
+            n += 1
+            req = "cap_b%d" % n
+            cap.up({"type": t, "req": req})
+            cap.run_until_last(req, until="error")
+    print("captured %d downlink frames from %d requests -> %s" % (cap.frames, n, a.out), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
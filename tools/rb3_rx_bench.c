@@ -0,0 +1,284 @@
+// App_Rb3Rx 主机测试：慢消费者下的按请求窗口、残余/无主消息计数、seq 重排（确定性时间步模拟）
+//   cc -O2 -Imain -Itools/host tools/rb3_rx_bench.c main/App_Rb3Rx.c main/App_Rb3Json.c -o build/rb3_rx_bench && build/rb3_rx_bench
+// 模型：服务端按 speed 倍实时发 audio（每条 500 B 原始 PCM），消费者把音频写进 512 KB 播放环，
+// 环按 24 kHz s16 实时排空、写满时消费者停下（同 Task_Chat_Continue 的 on_audio_push_rb）。
+// 音频超出窗口时该请求记为溢出，消费者放弃本轮（设备上 ws_rx_next 返回 ESP_ERR_INVALID_SIZE 并 cancel）。
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "App_Rb3Rx.h"
+
+#define PCM_BYTES_PER_MS 48      // 24 kHz s16 单声道
+#define CHUNK_RAW 500            // 服务端 audio 分片（base64 前）
+#define PLAY_RING (512 * 1024)
+#define WINDOW_DEFAULT (512 * 1024) // 同 RB3_WS_RX_WINDOW_DEFAULT
+
+static int s_fail;
+
+static void check(int ok, const char *what)
+{
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) s_fail = 1;
+}
+
+static app_rb3_rx_msg_t *mk_msg(const char *fmt_json)
+{
+    size_t n = strlen(fmt_json);
+    app_rb3_rx_msg_t *m = (app_rb3_rx_msg_t *)malloc(sizeof(*m) + n + 1);
+    m->next = NULL;
+    m->len = n;
+    memcpy(m->data, fmt_json, n + 1);
+    return m;
+}
+
+static app_rb3_rx_msg_t *mk_audio(const char *req, const char *rid, int seq, bool last)
+{
+    static char chunk[(CHUNK_RAW + 2) / 3 * 4 + 1];
+    if (!chunk[0]) memset(chunk, 'A', sizeof(chunk) - 1);
+    char buf[sizeof(chunk) + 160];
+    if (req) {
+        snprintf(buf, sizeof(buf), "{\"type\":\"audio\",\"req\":\"%s\",\"rid\":\"%s\",\"seq\":%d,\"chunk\":\"%s\",\"is_last\":%s}",
+                 req, rid, seq, chunk, last ? "true" : "false");
+    } else {
+        snprintf(buf, sizeof(buf), "{\"type\":\"audio\",\"rid\":\"%s\",\"seq\":%d,\"chunk\":\"%s\",\"is_last\":%s}", rid,
+                 seq, chunk, last ? "true" : "false");
+    }
+    return mk_msg(buf);
+}
+
+// ws 任务侧：parse_ro + push；非 QUEUED 的消息立即释放（事件回调不阻塞）
+static app_rb3_rx_push_t push(app_rb3_rx_t *rx, app_rb3_rx_msg_t *msg)
+{
+    app_rb3_msg_t m;
+    const bool ok = app_rb3_json_parse_ro(msg->data, msg->len, &m) == ESP_OK;
+    int slot = -1;
+    app_rb3_rx_push_t r = app_rb3_rx_push(rx, msg, ok ? &m : NULL, &slot);
+    if (r != APP_RB3_RX_QUEUED) free(msg);
+    return r;
+}
+
+// 消费者侧：pop -> parse -> stale -> accept；返回交付的消息（调用方 free），没有则 NULL
+static app_rb3_rx_msg_t *next(app_rb3_rx_t *rx, int slot, app_rb3_msg_t *m)
+{
+    app_rb3_rx_req_t *q = &rx->req[slot];
+    app_rb3_rx_msg_t *msg = NULL;
+    if (q->npend > 0 && app_rb3_rx_ready(q, &msg, m)) return msg;
+    while ((msg = app_rb3_rx_pop(rx, slot)) != NULL) {
+        if (app_rb3_json_parse(msg->data, msg->len, m, NULL) != ESP_OK || app_rb3_rx_is_stale(rx, m)) {
+            free(msg);
+            continue;
+        }
+        app_rb3_rx_order_t o = app_rb3_rx_accept(q, msg, m);
+        if (o == APP_RB3_RX_DELIVER) return msg;
+        if (o == APP_RB3_RX_DUP) free(msg);
+        if (q->npend > 0 && app_rb3_rx_ready(q, &msg, m)) return msg;
+    }
+    return NULL;
+}
+
+typedef struct {
+    int n;                // 本轮 audio 条数
+    int delivered;
+    int full;
+    size_t peak_queued;
+    bool got_last;
+    bool overflowed;      // 消费者见到溢出、放弃本轮（ws_rx_next 返回 ESP_ERR_INVALID_SIZE）
+    int end_ms;           // 本轮在消费者侧结束的时刻（收到 is_last 或放弃）
+    bool ctrl_admitted;   // 结尾的 text 与 is_last 都入了队（不受窗口限制）
+    int last_seq;
+    bool in_order;
+} play_result_t;
+
+/**
+ * 一轮语音回复：reply_ms 长的音频，服务端 speed 倍实时发送，结尾先发一条 text 再发 is_last；
+ * stuck_event 时另有一个从不消费的 event 请求同时在收消息（检查它不占语音的窗口）。
+ * 窗口同 Task_Chat_Continue：base + 播放环余量 * 4/3，每写一块播放环更新一次。
+ */
+static play_result_t simulate_reply(size_t base, int reply_ms, int speed, bool stuck_event)
+{
+    app_rb3_rx_t *rx = (app_rb3_rx_t *)malloc(sizeof(*rx));
+    app_rb3_rx_init(rx, base + PLAY_RING / 3 * 4);
+    const int voice = app_rb3_rx_open(rx, "v1", true);
+    const int ev = stuck_event ? app_rb3_rx_open(rx, "e1", false) : -1;
+    app_rb3_rx_req_t *q = &rx->req[voice];
+
+    const int n = (reply_ms * PCM_BYTES_PER_MS + CHUNK_RAW - 1) / CHUNK_RAW;
+    const double send_ms_per_msg = (double)CHUNK_RAW / PCM_BYTES_PER_MS / speed;
+    play_result_t r = {.n = n, .last_seq = 0, .in_order = true, .end_ms = -1, .ctrl_admitted = true};
+    long ring = 0;
+    int sent = 0;
+    int ev_sent = 0;
+
+    // 服务端发完为止：消费者放弃后（cancel 还在路上）尾部分片照样到达
+    for (int t = 0; (r.end_ms < 0 || sent < n) && t < reply_ms * 4 + 10000; ++t) {
+        while (sent < n && sent * send_ms_per_msg <= t) {
+            ++sent;
+            if (sent == n) {
+                r.ctrl_admitted &= push(rx, mk_msg("{\"type\":\"text\",\"req\":\"v1\",\"text\":\"bye\"}")) ==
+                                   APP_RB3_RX_QUEUED;
+                r.ctrl_admitted &= push(rx, mk_audio("v1", "r1", sent, true)) == APP_RB3_RX_QUEUED;
+            } else if (push(rx, mk_audio("v1", "r1", sent, false)) == APP_RB3_RX_FULL) {
+                r.full++;
+            }
+        }
+        if (ev >= 0 && (t % 5) == 0) {
+            ++ev_sent;
+            (void)push(rx, mk_audio("e1", "re1", ev_sent, false));
+        }
+        if (q->bytes > r.peak_queued) r.peak_queued = q->bytes;
+
+        ring -= PCM_BYTES_PER_MS;
+        if (ring < 0) ring = 0;
+        // 消费者：溢出即放弃本轮（不带缺口播放）；否则环里放得下一块才取下一条
+        while (r.end_ms < 0) {
+            if (q->overflowed) {
+                r.overflowed = true;
+                r.end_ms = t;
+                break;
+            }
+            if (ring + CHUNK_RAW > PLAY_RING) break;
+            app_rb3_msg_t m;
+            app_rb3_rx_msg_t *msg = next(rx, voice, &m);
+            if (!msg) break;
+            if (m.type == APP_RB3_MSG_AUDIO) {
+                if (m.seq != r.last_seq + 1) r.in_order = false;
+                r.last_seq = (int)m.seq;
+                r.delivered++;
+                ring += CHUNK_RAW;
+                if (m.is_last) {
+                    r.got_last = true;
+                    r.end_ms = t;
+                }
+            }
+            free(msg);
+            app_rb3_rx_set_window(rx, base + (size_t)(PLAY_RING - ring) / 3 * 4);
+        }
+    }
+
+    app_rb3_rx_free_chain(app_rb3_rx_close(rx, voice, "r1"));
+    if (ev >= 0) app_rb3_rx_free_chain(app_rb3_rx_close(rx, ev, "re1"));
+    size_t left = 1;
+    int active = 1;
+    app_rb3_rx_stats_t st;
+    app_rb3_rx_get_stats(rx, &st, &left, &active);
+    if (left != 0 || active != 0) r.in_order = false;
+    app_rb3_rx_deinit(rx);
+    free(rx);
+    return r;
+}
+
+static void test_slow_consumer(void)
+{
+    printf("slow consumer (play ring %d KB, window %d KB + ring headroom):\n", PLAY_RING / 1024,
+           WINDOW_DEFAULT / 1024);
+    play_result_t a = simulate_reply(WINDOW_DEFAULT, 20000, 2, false);
+    printf("  20 s reply @2x: delivered %d/%d, peak queued %zu B, window full %d\n", a.delivered, a.n, a.peak_queued,
+           a.full);
+    check(a.full == 0 && a.delivered == a.n && a.in_order && a.got_last, "20 s reply @2x: no drop, in order, bytes returned");
+
+    play_result_t b = simulate_reply(WINDOW_DEFAULT, 20000, 2, true);
+    check(b.full == 0 && b.delivered == b.n && b.in_order, "same with a stuck event request: voice unaffected");
+
+    // 窗口不够：第一次溢出后消费者立即放弃本轮（调用方 cancel），不播带缺口的回复、不等 is_last
+    play_result_t c = simulate_reply(32 * 1024, 40000, 2, false);
+    printf("  40 s reply @2x, 32 KB base: delivered %d/%d, window full %d, gave up at %d ms\n", c.delivered, c.n,
+           c.full, c.end_ms);
+    check(c.overflowed && !c.got_last && c.in_order && c.full > 0, "small window: turn fails fast, no gap played");
+
+    // 服务端 10 倍实时：尾部分片撞上满窗口；结尾的 text / is_last 仍入队，本轮以错误结束而不是卡住
+    play_result_t d = simulate_reply(WINDOW_DEFAULT, 60000, 10, false);
+    printf("  60 s reply @10x: delivered %d/%d, window full %d (%d dropped after the first), gave up at %d ms\n",
+           d.delivered, d.n, d.full, d.full - 1, d.end_ms);
+    check(d.full > 1 && d.ctrl_admitted, "10x realtime: tail hits a full window, text + is_last still queued");
+    check(d.overflowed && d.in_order && d.end_ms >= 0 && d.end_ms <= 60000 / 10 + 1,
+          "10x realtime: turn ends with an error as soon as it overflows");
+
+    // 能无溢出承受的最长回复（信息性）
+    static const int speeds[] = {2, 4, 10};
+    for (size_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); ++i) {
+        const int speed = speeds[i];
+        int ok_ms = 0;
+        for (int ms = 5000; ms <= 120000; ms += 5000) {
+            play_result_t r = simulate_reply(WINDOW_DEFAULT, ms, speed, false);
+            if (r.full || !r.got_last) break;
+            ok_ms = ms;
+        }
+        printf("  longest reply without overflow @%dx realtime: %d s\n", speed, ok_ms / 1000);
+    }
+}
+
+static void test_barge_in(void)
+{
+    printf("barge-in:\n");
+    app_rb3_rx_t rx;
+    app_rb3_rx_init(&rx, 8 * 1024);
+    int v = app_rb3_rx_open(&rx, "v1", true);
+    int full = 0;
+    for (int i = 1; i <= 40; ++i) full += push(&rx, mk_audio("v1", "r1", i, false)) == APP_RB3_RX_FULL;
+    check(full > 0, "consumer stuck: window fills, ws side does not wait");
+
+    // 打断：关掉本轮，排队的残余立即释放，在途的按 rid/req 丢弃
+    app_rb3_rx_free_chain(app_rb3_rx_close(&rx, v, "r1"));
+    size_t q = 1;
+    app_rb3_rx_stats_t st;
+    app_rb3_rx_get_stats(&rx, &st, &q, NULL);
+    check(q == 0, "close returns all queued bytes");
+    check(push(&rx, mk_audio("v1", "r1", 41, false)) == APP_RB3_RX_STALE, "late chunk of cancelled reply is stale");
+
+    v = app_rb3_rx_open(&rx, "v2", true);
+    check(v >= 0 && push(&rx, mk_audio("v2", "r2", 1, false)) == APP_RB3_RX_QUEUED, "next turn queues immediately");
+    app_rb3_rx_deinit(&rx);
+}
+
+static void test_unrouted(void)
+{
+    printf("unrouted:\n");
+    app_rb3_rx_t rx;
+    app_rb3_rx_init(&rx, WINDOW_DEFAULT);
+    check(push(&rx, mk_msg("{\"type\":\"error\",\"message\":\"idle\"}")) == APP_RB3_RX_UNROUTED,
+          "error without req while idle: dropped");
+    int v = app_rb3_rx_open(&rx, "v1", true);
+    check(push(&rx, mk_audio("zz", "rz", 1, false)) == APP_RB3_RX_UNROUTED, "req matching no request: dropped");
+    check(push(&rx, mk_msg("{\"type\":\"asr_text\",\"text\":\"hi\"}")) == APP_RB3_RX_QUEUED,
+          "asr_text (no req) goes to the voice turn");
+    app_rb3_rx_stats_t st;
+    size_t q = 0;
+    app_rb3_rx_get_stats(&rx, &st, &q, NULL);
+    check(st.unrouted_msgs == 2 && q == rx.req[v].bytes, "unrouted counted, not queued anywhere");
+    app_rb3_rx_deinit(&rx);
+}
+
+static void test_seq(void)
+{
+    printf("seq:\n");
+    app_rb3_rx_t rx;
+    app_rb3_rx_init(&rx, WINDOW_DEFAULT);
+    int v = app_rb3_rx_open(&rx, NULL, true);
+    const int order[] = {1, 3, 2, 2, 5, 4, 1};
+    for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); ++i) (void)push(&rx, mk_audio(NULL, "r1", order[i], false));
+    int got[8] = {0};
+    int n = 0;
+    app_rb3_msg_t m;
+    app_rb3_rx_msg_t *msg;
+    while (n < 8 && (msg = next(&rx, v, &m)) != NULL) {
+        got[n++] = (int)m.seq;
+        free(msg);
+    }
+    check(n == 5 && got[0] == 1 && got[1] == 2 && got[2] == 3 && got[3] == 4 && got[4] == 5, "delivered 1..5 in order");
+    app_rb3_rx_stats_t st;
+    app_rb3_rx_get_stats(&rx, &st, NULL, NULL);
+    check(st.seq_dups == 2 && st.seq_reorders == 2 && st.seq_gaps == 0, "2 dups, 2 reorders, no gap");
+    app_rb3_rx_deinit(&rx);
+}
+
+int main(void)
+{
+    test_slow_consumer();
+    test_barge_in();
+    test_unrouted();
+    test_seq();
+    printf("%s\n", s_fail ? "FAIL" : "PASS");
+    return s_fail;
+}
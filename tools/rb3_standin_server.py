@@ -0,0 +1,333 @@
+#!/usr/bin/env python3
+"""
+rb3_standin_server.py - 本地 v3 WS 替身服务端（只用标准库），用于在坏网络下验证设备端连接管理
+
+协议与 docs/Robot Brain v3 Interface.md 一致（路径不限）：
+  上行：start -> 二进制音频分片 -> end；event / query / voice 单条请求；cancel
+  下行：asr_text -> meta -> text_delta(seq 从 1 递增) -> text(完整回复文本) -> audio(seq 从 1 递增，is_last 结束)，都带 req
+  出错：未知 type、无 start 的 end 回 {"type":"error","req":...,"message":...}（不再有后续帧）
+  控制帧：收到 ping 回 pong（设备端靠 ping/pong 判活）
+
+“不稳定网络”开关（都可叠加）：
+  --refuse-prob P        握手阶段直接断开的概率（模拟建连失败 -> 设备退避）
+  --accept-delay-ms N    握手前等待 N ms（模拟慢建连）
+  --drop-idle-prob P     每秒对空闲连接直接断开的概率（模拟 NAT/代理掐连接）
+  --blackhole-prob P     每秒让连接“黑洞”的概率：不再回任何帧（含 pong），只能靠心跳超时发现
+  --reply-delay-ms N     end/event/query 后等待 N ms 再下行
+  --latency-ms N         注入网络延迟：/health、握手、pong、每轮回复首包前都等 N ms（可加 --jitter-ms）
+  --health-fail-prob P   /health 返回 503 的概率（模拟端点半故障）
+  --reply-scale F        回复音频时长乘 F（录 tools/captures 时用小值，文件不至于太大）
+  --event-version V      event 回复的 meta 带 "version": V；请求 if_version 相同时只回 meta + 空的最后一片
+
+多端点选择/故障转移：在不同端口起几个实例，注入不同延迟，设备端 endpoints 填这几个地址：
+  python tools/rb3_standin_server.py --port 8443 --latency-ms 120
+  python tools/rb3_standin_server.py --port 8444 --latency-ms 20
+  python tools/rb3_standin_server.py --port 8445 --latency-ms 60 --health-fail-prob 0.5
+设备日志里 App_Rb3Endpoint 的 "route a -> b" 应指向 8444；Ctrl-C 掉 8444 后应在下一次重连切到 8445/8443。
+
+用法：
+  python tools/rb3_standin_server.py --port 8443
+  python tools/rb3_standin_server.py --port 8443 --refuse-prob 0.3 --drop-idle-prob 0.05 --blackhole-prob 0.02
+
+设备端 base_url 指向 http://<PC IP>:8443，观察日志里的
+  “唤醒->首个上行: X ms（平均/最大/未就绪 N 次）” 与连接管理器统计。
+不接设备时 tools/connmgr_bench.c 会自己起本替身，按场景量同一个延迟（主机上跑真实的 App_Rb3ConnMgr.c）。
+"""
+
+import argparse
+import asyncio
+import base64
+import hashlib
+import json
+import math
+import random
+import struct
+import time
+
+WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC11B65"
+
+OP_CONT = 0x0
+OP_TEXT = 0x1
+OP_BIN = 0x2
+OP_CLOSE = 0x8
+OP_PING = 0x9
+OP_PONG = 0xA
+
+
+async def net_delay(args):
+    """注入的单向网络延迟"""
+    ms = args.latency_ms + (random.uniform(-args.jitter_ms, args.jitter_ms) if args.jitter_ms > 0 else 0)
+    if ms > 0:
+        await asyncio.sleep(ms / 1000.0)
+
+
+def log(peer, msg):
+    print("%s %s %s" % (time.strftime("%H:%M:%S"), peer, msg), flush=True)
+
+
+def ws_frame(op, payload=b""):
+    n = len(payload)
+    if n < 126:
+        hdr = struct.pack("!BB", 0x80 | op, n)
+    elif n < 65536:
+        hdr = struct.pack("!BBH", 0x80 | op, 126, n)
+    else:
+        hdr = struct.pack("!BBQ", 0x80 | op, 127, n)
+    return hdr + payload
+
+
+async def ws_read_frame(reader):
+    b0, b1 = await reader.readexactly(2)
+    fin = bool(b0 & 0x80)
+    op = b0 & 0x0F
+    n = b1 & 0x7F
+    if n == 126:
+        (n,) = struct.unpack("!H", await reader.readexactly(2))
+    elif n == 127:
+        (n,) = struct.unpack("!Q", await reader.readexactly(8))
+    mask = await reader.readexactly(4) if (b1 & 0x80) else None
+    data = await reader.readexactly(n)
+    if mask:
+        data = bytes(c ^ mask[i & 3] for i, c in enumerate(data))
+    return fin, op, data
+
+
+class Conn:
+    def __init__(self, args, reader, writer):
+        self.args = args
+        self.reader = reader
+        self.writer = writer
+        self.peer = "%s:%d" % writer.get_extra_info("peername")[:2]
+        self.blackholed = False
+        self.busy = 0
+        self.cancelled = set()
+        self.turn = None  # 当前语音轮：{"req":..., "bytes":...}
+
+    async def send(self, op, payload=b""):
+        if self.blackholed:
+            return
+        self.writer.write(ws_frame(op, payload))
+        await self.writer.drain()
+
+    async def send_json(self, obj):
+        await self.send(OP_TEXT, json.dumps(obj, ensure_ascii=False).encode("utf-8"))
+
+    def spawn_reply(self, *a, **kw):
+        """排队一轮回复；排上就算忙（否则 reply 开始前的空档会被 chaos 当成空闲掐掉）"""
+        self.busy += 1
+        asyncio.ensure_future(self.reply(*a, **kw))
+
+    async def reply(self, req, asr_text, secs=1.0, version=None, if_version=None):
+        """按协议顺序下行一轮回复：asr_text -> meta -> text_delta/text -> audio 分片（busy 由 spawn_reply 加）"""
+        try:
+            if self.args.reply_delay_ms > 0:
+                await asyncio.sleep(self.args.reply_delay_ms / 1000.0)
+            await net_delay(self.args)
+            rid = "rep_%06x" % random.getrandbits(24)
+            await self.send_json({"type": "asr_text", "req": req, "text": asr_text})
+            meta = {"type": "meta", "req": req, "rid": rid, "anim": "smile_soft",
+                    "motion": "idle", "af": "pcm_24k_16bit", "text": "好的"}
+            if version:
+                meta["version"] = version
+            await self.send_json(meta)
+            if version and if_version == version:
+                await self.send_json({"type": "audio", "req": req, "rid": rid, "seq": 1, "is_last": True, "chunk": ""})
+                log(self.peer, "req=%s not modified (version %s)" % (req, version))
+                return
+            # 回复文本（回显提问，转义/引号/换行都原样带回）：按 3 段 text_delta 流出，再发完整 text
+            text = "好的：" + asr_text
+            step = (len(text) + 2) // 3
+            for i in range(0, len(text), step):
+                await self.send_json({"type": "text_delta", "req": req, "rid": rid, "seq": i // step + 1,
+                                      "text": text[i:i + step]})
+            await self.send_json({"type": "text", "req": req, "rid": rid, "text": text})
+            # 440Hz 提示音（24k/16bit/mono），按 chunk_bytes 切片，节奏约为实时 2 倍
+            sr = 24000
+            pcm = b"".join(struct.pack("<h", int(6000 * math.sin(2 * math.pi * 440 * i / sr)))
+                           for i in range(int(sr * secs * self.args.reply_scale)))
+            chunk = self.args.chunk_bytes
+            total = (len(pcm) + chunk - 1) // chunk
+            for seq in range(1, total + 1):
+                if req in self.cancelled:
+                    log(self.peer, "req=%s cancelled at seq=%d" % (req, seq))
+                    return
+                part = pcm[(seq - 1) * chunk:seq * chunk]
+                await self.send_json({"type": "audio", "req": req, "rid": rid, "seq": seq,
+                                      "is_last": seq == total,
+                                      "chunk": base64.b64encode(part).decode("ascii")})
+                await asyncio.sleep(len(part) / (sr * 2) / 2)
+            log(self.peer, "req=%s reply done (%d chunks)" % (req, total))
+        finally:
+            self.busy -= 1
+
+    async def send_error(self, req, message):
+        log(self.peer, "error req=%s: %s" % (req, message))
+        await self.send_json({"type": "error", "req": req, "message": message})
+
+    async def on_text(self, data):
+        try:
+            m = json.loads(data.decode("utf-8"))
+        except ValueError:
+            log(self.peer, "bad json: %r" % data[:80])
+            return
+        t = m.get("type")
+        req = m.get("req") or "r_%d" % int(time.time() * 1000)
+        if t == "start":
+            self.turn = {"req": req, "bytes": 0, "t0": time.time()}
+            log(self.peer, "start req=%s af=%s" % (req, m.get("af")))
+        elif t == "end":
+            if not self.turn:
+                await self.send_error(req, "end without start")
+                return
+            turn, self.turn = self.turn, None
+            log(self.peer, "end req=%s uplink=%d bytes in %.2fs"
+                % (turn["req"], turn["bytes"], time.time() - turn["t0"]))
+            self.spawn_reply(turn["req"], "（%d 字节语音）" % turn["bytes"])
+        elif t == "event":
+            log(self.peer, "event %s req=%s if_version=%s" % (m.get("event"), req, m.get("if_version")))
+            self.spawn_reply(req, m.get("event", ""), secs=0.5, version=self.args.event_version,
+                             if_version=m.get("if_version"))
+        elif t == "query":
+            log(self.peer, "query req=%s text=%s" % (req, m.get("text")))
+            self.spawn_reply(req, m.get("text", ""))
+        elif t == "voice":
+            n = len(base64.b64decode(m.get("audio_data", "")))
+            log(self.peer, "voice req=%s %d bytes" % (req, n))
+            self.spawn_reply(req, "（%d 字节语音）" % n)
+        elif t == "cancel":
+            log(self.peer, "cancel req=%s rid=%s" % (req, m.get("rid")))
+            self.cancelled.add(req)
+        else:
+            await self.send_error(req, "unknown type %r" % t)
+
+    async def chaos(self):
+        """每秒按概率掐断空闲连接 / 让连接进入黑洞"""
+        a = self.args
+        while True:
+            await asyncio.sleep(1.0)
+            idle = self.busy == 0 and self.turn is None
+            if idle and random.random() < a.drop_idle_prob:
+                log(self.peer, "chaos: drop idle connection")
+                self.writer.close()
+                return
+            if not self.blackholed and random.random() < a.blackhole_prob:
+                log(self.peer, "chaos: blackhole (no more frames, no pong)")
+                self.blackholed = True
+
+    async def run(self):
+        chaos = asyncio.ensure_future(self.chaos())
+        try:
+            msg = b""
+            msg_op = None
+            while True:
+                fin, op, data = await ws_read_frame(self.reader)
+                if self.blackholed:
+                    continue
+                if op == OP_PING:
+                    await net_delay(self.args)
+                    await self.send(OP_PONG, data)
+                    continue
+                if op == OP_PONG:
+                    continue
+                if op == OP_CLOSE:
+                    await self.send(OP_CLOSE, data[:2])
+                    break
+                if op != OP_CONT:
+                    msg, msg_op = b"", op
+                msg += data
+                if not fin:
+                    continue
+                if msg_op == OP_TEXT:
+                    await self.on_text(msg)
+                elif msg_op == OP_BIN and self.turn:
+                    self.turn["bytes"] += len(msg)
+                msg = b""
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+        finally:
+            chaos.cancel()
+            self.writer.close()
+            log(self.peer, "closed")
+
+
+async def handle(args, reader, writer):
+    peer = "%s:%d" % writer.get_extra_info("peername")[:2]
+    try:
+        head = await reader.readuntil(b"\r\n\r\n")
+    except (asyncio.IncompleteReadError, asyncio.LimitOverrunError, ConnectionError):
+        writer.close()
+        return
+    lines = head.decode("latin-1").split("\r\n")
+    headers = {}
+    for ln in lines[1:]:
+        if ":" in ln:
+            k, v = ln.split(":", 1)
+            headers[k.strip().lower()] = v.strip()
+    path = lines[0].split(" ")[1] if len(lines[0].split(" ")) > 1 else "/"
+
+    # 健康检查（HTTP）
+    if "sec-websocket-key" not in headers:
+        await net_delay(args)
+        if not path.startswith("/health"):
+            status, body = b"404 Not Found", b'{"error":"not found"}'
+        elif random.random() < args.health_fail_prob:
+            status, body = b"503 Service Unavailable", b'{"status":"degraded"}'
+        else:
+            status, body = b"200 OK", b'{"status":"ok"}'
+
+        writer.write(b"HTTP/1.1 " + status + b"\r\nContent-Type: application/json\r\nContent-Length: "
+                     + str(len(body)).encode() + b"\r\nConnection: close\r\n\r\n" + body)
+        await writer.drain()
+        writer.close()
+        return
+
+    if args.accept_delay_ms > 0:
+        await asyncio.sleep(args.accept_delay_ms / 1000.0)
+    await net_delay(args)
+    if random.random() < args.refuse_prob:
+        log(peer, "chaos: refuse handshake")
+        writer.close()
+        return
+
+    accept = base64.b64encode(hashlib.sha1((headers["sec-websocket-key"] + WS_GUID).encode()).digest())
+    writer.write(b"HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                 b"Sec-WebSocket-Accept: " + accept + b"\r\n\r\n")
+    await writer.drain()
+    log(peer, "ws open %s" % path)
+    await Conn(args, reader, writer).run()
+
+
+def main():
+    ap = argparse.ArgumentParser(description="v3 WS stand-in server with flaky-network knobs")
+    ap.add_argument("--host", default="0.0.0.0")
+    ap.add_argument("--port", type=int, default=8443)
+    ap.add_argument("--chunk-bytes", type=int, default=500)
+    ap.add_argument("--refuse-prob", type=float, default=0.0)
+    ap.add_argument("--accept-delay-ms", type=int, default=0)
+    ap.add_argument("--drop-idle-prob", type=float, default=0.0)
+    ap.add_argument("--blackhole-prob", type=float, default=0.0)
+    ap.add_argument("--reply-delay-ms", type=int, default=0)
+    ap.add_argument("--latency-ms", type=int, default=0)
+    ap.add_argument("--jitter-ms", type=int, default=0)
+    ap.add_argument("--health-fail-prob", type=float, default=0.0)
+    ap.add_argument("--reply-scale", type=float, default=1.0)
+    ap.add_argument("--event-version", default="")
+    ap.add_argument("--seed", type=int, default=None)
+    args = ap.parse_args()
+    if args.seed is not None:
+        random.seed(args.seed)
+
+    async def serve():
+        srv = await asyncio.start_server(lambda r, w: handle(args, r, w), args.host, args.port)
+        print("listening on %s:%d" % (args.host, args.port), flush=True)
+        async with srv:
+            await srv.serve_forever()
+
+    try:
+        asyncio.run(serve())
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
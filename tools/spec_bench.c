@@ -0,0 +1,150 @@
+// App_Spec 主机测试：REF / FAST 两套 radix-4 逐位一致、rfft 对浮点 DFT 的精度、rfft->irfft 往返、
+// log-mel / MFCC 管线的峰值频带，并报每帧耗时
+//   cc -O2 -Imain -Itools/host tools/spec_bench.c main/App_Spec.c main/App_TestSig.c main/App_PcmOps.c -lm -o build/spec_bench && build/spec_bench
+// 主机上 cycles 为纳秒（见 tools/host/esp_cpu.h）；目标板上的 cycles/frame 见 Task_Dsp_Selftest。
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "App_Spec.h"
+#include "App_TestSig.h"
+#include "esp_cpu.h"
+
+#define SR 24000
+#define FRAMES_EXACT 2000
+
+static int16_t s_x[APP_SPEC_FFT_MAX];
+static int16_t s_a[APP_SPEC_FFT_MAX + 2];
+static int16_t s_b[APP_SPEC_FFT_MAX + 2];
+static int16_t s_y[APP_SPEC_FFT_MAX];
+
+// 随机帧：幅度从 1 到满量程，含纯直流、单脉冲、交替满量程等极端帧
+static void gen_frame(uint32_t *st, int t, int16_t *x, int n)
+{
+    switch (t % 16) {
+    case 0:
+        for (int i = 0; i < n; ++i) x[i] = (int16_t)((i & 1) ? 32767 : -32768);
+        return;
+    case 1:
+        for (int i = 0; i < n; ++i) x[i] = 32767;
+        return;
+    case 2:
+        memset(x, 0, (size_t)n * sizeof(int16_t));
+        x[app_tsig_lcg(st) % (uint32_t)n] = -32768;
+        return;
+    default: {
+        const int sh = (int)(app_tsig_lcg(st) % 16u);
+        for (int i = 0; i < n; ++i) x[i] = (int16_t)((int32_t)app_tsig_lcg(st) >> (16 + sh));
+        return;
+    }
+    }
+}
+
+// 返回 0 通过
+static int check_fft(int n)
+{
+    app_spec_fft_t f;
+    if (app_spec_fft_init(&f, n) != ESP_OK) return 1;
+
+    // 1) REF / FAST 逐位一致
+    uint32_t st = 0x5eedu + (uint32_t)n;
+    int mismatch = 0;
+    for (int t = 0; t < FRAMES_EXACT; ++t) {
+        gen_frame(&st, t, s_x, n);
+        app_spec_set_impl(APP_SPEC_IMPL_REF);
+        const int ea = app_spec_rfft(&f, s_x, s_a);
+        app_spec_set_impl(APP_SPEC_IMPL_FAST);
+        const int eb = app_spec_rfft(&f, s_x, s_b);
+        if (ea != eb || memcmp(s_a, s_b, (size_t)(n + 2) * sizeof(int16_t)) != 0) mismatch++;
+    }
+
+    // 2) 精度：与浮点 DFT 比较
+    app_tsig_tones(s_x, n, SR);
+    const int e = app_spec_rfft(&f, s_x, s_a);
+    double ps = 0, pe = 0;
+    for (int k = 0; k <= n / 2; ++k) {
+        double re = 0, im = 0;
+        for (int i = 0; i < n; ++i) {
+            const double ph = 2.0 * M_PI * (double)((k * i) % n) / n;
+            re += s_x[i] * cos(ph);
+            im -= s_x[i] * sin(ph);
+        }
+        const double dr = re - ldexp(s_a[2 * k], e), di = im - ldexp(s_a[2 * k + 1], e);
+        ps += re * re + im * im;
+        pe += dr * dr + di * di;
+    }
+    const double snr = (pe > 0) ? 10.0 * log10(ps / pe) : 99.0;
+
+    // 3) 往返：irfft(rfft(x)) * 2^(e+ei) ≈ x
+    memcpy(s_b, s_a, (size_t)(n + 2) * sizeof(int16_t));
+    const int ei = app_spec_irfft(&f, s_b, s_y);
+    double rs = 0, re2 = 0;
+    for (int i = 0; i < n; ++i) {
+        const double d = ldexp(s_y[i], e + ei) - s_x[i];
+        rs += (double)s_x[i] * s_x[i];
+        re2 += d * d;
+    }
+    const double snr_rt = (re2 > 0) ? 10.0 * log10(rs / re2) : 99.0;
+
+    // 4) 每帧耗时
+    double ns[2];
+    for (int impl = 0; impl < 2; ++impl) {
+        app_spec_set_impl(impl ? APP_SPEC_IMPL_FAST : APP_SPEC_IMPL_REF);
+        const int reps = 20000;
+        const uint32_t c0 = esp_cpu_get_cycle_count();
+        for (int r = 0; r < reps; ++r) app_spec_rfft(&f, s_x, s_a);
+        ns[impl] = (double)(uint32_t)(esp_cpu_get_cycle_count() - c0) / reps;
+    }
+    app_spec_fft_deinit(&f);
+
+    const int fail = mismatch != 0 || snr < 50.0 || snr_rt < 40.0;
+    printf("rfft %d: ref %.0f / fast %.0f ns/frame (%.2fx), SNR %.1f dB vs float DFT, round trip %.1f dB, "
+           "mismatch %d/%d%s\n",
+           n, ns[0], ns[1], ns[1] > 0 ? ns[0] / ns[1] : 0.0, snr, snr_rt, mismatch, FRAMES_EXACT,
+           fail ? "  FAIL" : "");
+    return fail;
+}
+
+static int check_pipe(int n_fft)
+{
+    app_spec_pipe_t p;
+    app_spec_pipe_cfg_t cfg = app_spec_pipe_cfg_default(SR);
+    cfg.n_fft = n_fft;
+    if (app_spec_pipe_init(&p, &cfg) != ESP_OK) return 1;
+
+    app_tsig_tones(s_x, cfg.n_fft, SR);
+    app_spec_feat_t feat;
+    for (int r = 0; r < 2000; ++r) app_spec_pipe_run(&p, s_x, &feat);
+
+    // 测试信号主能量在 300 Hz：峰值应落在低频 mel 带
+    int peak = 0;
+    for (int i = 1; i < cfg.n_mel; ++i) {
+        if (feat.logmel[i] > feat.logmel[peak]) peak = i;
+    }
+    // 对数能量对照浮点
+    double e2 = 0;
+    for (int i = 0; i < cfg.n_fft; ++i) e2 += (double)s_x[i] * s_x[i];
+    const double log_e_ref = log2(e2), log_e = feat.log_energy / 256.0;
+
+    const double hop_ns = (double)cfg.n_fft / 2 * 1e9 / SR;
+    const int fail = peak >= cfg.n_mel / 4 || fabs(log_e - log_e_ref) > 0.05;
+    printf("pipe %d/%d mel/%d ceps: %u ns/frame (%.2f%% of a core at %.0f us hop), log E %.2f (float %.2f), "
+           "peak mel %d, c0 %.1f%s\n",
+           cfg.n_fft, cfg.n_mel, cfg.n_ceps, (unsigned)p.cycles_avg, 100.0 * p.cycles_avg / hop_ns, hop_ns / 1000.0,
+           log_e, log_e_ref, peak, feat.mfcc[0] / 256.0, fail ? "  FAIL" : "");
+    app_spec_pipe_deinit(&p);
+    return fail;
+}
+
+int main(void)
+{
+    int fail = 0;
+    fail |= check_fft(256);
+    fail |= check_fft(512);
+    fail |= check_pipe(256);
+    fail |= check_pipe(512);
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
@@ -0,0 +1,135 @@
+// App_SpkEq 主机校验：级联双二阶频响 vs 量化系数理论值、限幅上限、释放后恢复单位增益 + 每样本耗时
+//   cc -O2 -Imain tools/spk_eq_bench.c main/App_SpkEq.c -lm -o build/spk_eq_bench && build/spk_eq_bench
+// 目标板上的 cycles/block 见 Task_Dsp_Selftest。
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "App_SpkEq.h"
+#include "App_TestSig.h"
+
+#define SR 24000
+#define BLOCK 480
+
+static int16_t s_x[SR];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void run_blocks(app_spk_eq_t *e, int16_t *x, int n)
+{
+    for (int off = 0; off < n; off += BLOCK) app_spk_eq_process(e, x + off, (n - off < BLOCK) ? n - off : BLOCK);
+}
+
+static double rms(const int16_t *x, int n)
+{
+    double s = 0;
+    for (int i = 0; i < n; ++i) s += (double)x[i] * x[i];
+    return sqrt(s / n);
+}
+
+static void sine(int16_t *x, int n, double f, double amp)
+{
+    for (int i = 0; i < n; ++i) x[i] = (int16_t)lrint(amp * sin(2.0 * M_PI * f * i / SR));
+}
+
+// 正弦扫点：稳态输出 RMS / 输入 RMS 与 app_spk_eq_response_db 对比
+static int check_response(const char *name, const app_spk_eq_cfg_t *cfg)
+{
+    static const float freqs[] = {60, 120, 250, 500, 1000, 2000, 3000, 5000, 8000, 11000};
+    app_spk_eq_t *e = (app_spk_eq_t *)malloc(sizeof(*e));
+    double max_err = 0;
+    for (size_t k = 0; k < sizeof(freqs) / sizeof(freqs[0]); ++k) {
+        app_spk_eq_init(e, cfg);
+        sine(s_x, SR, freqs[k], 4000.0);
+        const double in = rms(s_x + SR / 2, SR / 2);
+        run_blocks(e, s_x, SR);
+        const double got = 20.0 * log10(rms(s_x + SR / 2, SR / 2) / in);
+        const double want = app_spk_eq_response_db(e, freqs[k]);
+        // 深阻带里量化噪声占主导，只看 -40 dB 以上
+        if (want > -40.0 && fabs(got - want) > max_err) max_err = fabs(got - want);
+    }
+    free(e);
+    printf("%-22s response max err %.3f dB\n", name, max_err);
+    return max_err > 0.2;
+}
+
+int main(void)
+{
+    int fail = 0;
+
+    app_spk_eq_cfg_t cfg = app_spk_eq_cfg_default(SR, 1);
+    cfg.limiter = false;
+    fail |= check_response("default (hp+peak)", &cfg);
+
+    app_spk_eq_cfg_t c2 = cfg;
+    c2.pre_gain_db = -6.0f;
+    c2.n_bands = 4;
+    c2.bands[0] = (app_spk_eq_band_t){.type = APP_SPK_EQ_LOWSHELF, .freq_hz = 300, .q = 0.707f, .gain_db = -9};
+    c2.bands[1] = (app_spk_eq_band_t){.type = APP_SPK_EQ_PEAK, .freq_hz = 1800, .q = 2.0f, .gain_db = 6};
+    c2.bands[2] = (app_spk_eq_band_t){.type = APP_SPK_EQ_HIGHSHELF, .freq_hz = 6000, .q = 0.707f, .gain_db = 4};
+    c2.bands[3] = (app_spk_eq_band_t){.type = APP_SPK_EQ_LOWPASS, .freq_hz = 10000, .q = 0.707f};
+    fail |= check_response("shelf+peak+lp, -6 pre", &c2);
+
+    // 限幅：+12 dB 提升把满幅方波 / 噪声 / 单脉冲推过上限
+    app_spk_eq_cfg_t c3 = app_spk_eq_cfg_default(SR, 1);
+    c3.pre_gain_db = 12.0f;
+    app_spk_eq_t *e = (app_spk_eq_t *)malloc(sizeof(*e));
+    app_spk_eq_init(e, &c3);
+    const int32_t ceil = e->ceil;
+    int32_t peak = 0;
+    uint32_t st = 1;
+    for (int seg = 0; seg < 4; ++seg) {
+        for (int i = 0; i < SR; ++i) {
+            app_tsig_lcg(&st);
+            switch (seg) {
+            case 0: s_x[i] = ((i / 20) & 1) ? 32767 : -32768; break;
+            case 1: s_x[i] = (int16_t)(st >> 16); break;
+            case 2: s_x[i] = (i % 4800 == 0) ? 32767 : 0; break;
+            default: s_x[i] = (int16_t)lrint(30000.0 * sin(2.0 * M_PI * 3000.0 * i / SR)); break;
+            }
+        }
+        run_blocks(e, s_x, SR);
+        for (int i = 0; i < SR; ++i) {
+            const int32_t a = abs(s_x[i]);
+            if (a > peak) peak = a;
+        }
+    }
+    // 安静下来后恢复单位增益：输出应等于 EQ 的线性响应
+    sine(s_x, SR, 1000.0, 1000.0);
+    const double in = rms(s_x, SR / 4);
+    run_blocks(e, s_x, SR);
+    const double rel_err = 20.0 * log10(rms(s_x + 3 * SR / 4, SR / 4) / in) - app_spk_eq_response_db(e, 1000.0f);
+    app_spk_eq_stats_t es;
+    app_spk_eq_get_stats(e, &es);
+    printf("limiter: peak in %d -> out %d (ceil %d), min gain %.1f dB, after release err %.3f dB, latency %d frames\n",
+           (int)es.peak_in, (int)peak, (int)ceil, (double)es.min_gain_db, rel_err, app_spk_eq_latency_frames(e));
+    fail |= (peak > ceil) || (fabs(rel_err) > 0.1);
+
+    // 耗时：默认链路（2 段 + 限幅）与 6 段
+    app_spk_eq_cfg_t c6 = app_spk_eq_cfg_default(SR, 1);
+    c6.n_bands = APP_SPK_EQ_MAX_BANDS;
+    for (int i = 2; i < APP_SPK_EQ_MAX_BANDS; ++i) {
+        c6.bands[i] = (app_spk_eq_band_t){.type = APP_SPK_EQ_PEAK, .freq_hz = 500.0f * i, .q = 1.0f, .gain_db = -2};
+    }
+    const app_spk_eq_cfg_t *cs[2] = {&c3, &c6};
+    for (int k = 0; k < 2; ++k) {
+        app_spk_eq_init(e, cs[k]);
+        sine(s_x, SR, 1000.0, 8000.0);
+        const int reps = 50;
+        const double t0 = now_ns();
+        for (int r = 0; r < reps; ++r) run_blocks(e, s_x, SR);
+        printf("%d bands + limiter: %.2f ns/sample\n", cs[k]->n_bands, (now_ns() - t0) / ((double)reps * SR));
+    }
+    free(e);
+
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}